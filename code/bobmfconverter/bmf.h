@@ -37,13 +37,36 @@
 
 // Version of the BMF format
 #define BMF_VERSION_MAJOR              0
-#define BMF_VERSION_MINOR              1
-#define BMF_VERSION_RELEASE            1
+#define BMF_VERSION_MINOR              2
+#define BMF_VERSION_RELEASE            0
 
 #define BMF_MAKE_VERSION_CODE(a, b, c)  ( ((a) << 16) | ((b) << 8) | (c) )
 #define BMF_VERSION_CODE \
     BMF_MAKE_VERSION_CODE(BMF_VERSION_MAJOR, BMF_VERSION_MINOR, BMF_VERSION_RELEASE)
 
+// Last version that stores the arrays inside the model chunk
+#define BMF_VERSION_CODE_STREAMED_ARRAYS  BMF_MAKE_VERSION_CODE(0, 1, 1)
+
+/**
+ * Since version 0.2.0 the vertex and index arrays are stored at the beginning
+ *  of the file, so that they can be mapped into memory and used directly:
+ *
+ * @li The file id and the version code
+ * @li BMF_MAGIC_ARRAYS, the number of points, the number of indices and the
+ *     index type (as in older versions)
+ * @li The file offsets of the point array, of the index array and of the
+ *     model chunk (BMF_MAGIC_MODEL)
+ * @li Padding, the point array, padding, the index array and padding
+ * @li The model chunk (without arrays section) and BMF_MAGIC_END
+ *
+ * The arrays are little-endian and start at offsets that are multiples of
+ *  BMF_ARRAY_ALIGNMENT. Every point consists of 8 floats (position, normal
+ *  and texture coordinates). All other values are big-endian, as in older
+ *  versions.
+ **/
+#define BMF_VERSION_CODE_MAPPED_ARRAYS    BMF_MAKE_VERSION_CODE(0, 2, 0)
+#define BMF_ARRAY_ALIGNMENT            16
+
 
 // Magics for different chunks
 #define BMF_MAGIC_MODEL                0x100000
@@ -0,0 +1,719 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2005 Rivo Laks (rivolaks@hot.ee)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "converter.h"
+
+#include "model.h"
+#include "debug.h"
+#include "lod.h"
+#include "frame.h"
+#include "texture.h"
+#include "material.h"
+#include "processor.h"
+#include "bmf.h"
+#include "processors/lodcreator.h"
+#include "processors/transformer.h"
+#include "processors/vertexoptimizer.h"
+#include "processors/vertexcacheoptimizer.h"
+#include "processors/frameoptimizer.h"
+#include "processors/unuseddataremover.h"
+#include "processors/meshoptimizer.h"
+#include "processors/textureoptimizer.h"
+#include "processors/materialoptimizer.h"
+#include "processors/defaultmaterials.h"
+#include "processors/normalcalculator.h"
+#include "processors/nodeoptimizer.h"
+
+#include <qfileinfo.h>
+#include <qregexp.h>
+#include <QSettings>
+#include <QThread>
+
+
+ConverterOptions::ConverterOptions()
+{
+  numLods = 5;
+  lod_factor = 0.5;
+  smoothAllFaces = false;
+  lod_useError = false;
+  lod_useBoth = false;
+  lod_baseError = 0.075;
+  lod_errorMod = 4.0;
+  frames_keepCount = -1;
+  frame_base = 0;
+  frames_keepAll = true;
+  modelSize = 1.0;
+  tex_size = 512;
+  tex_convertToLowerCase = false;
+  tex_optimize = false;
+  model_center = false;
+  tex_dontLoad = false;
+  meshes_merge = true;
+  usenormalcalculator = true;
+  normalcalculator_threshold = 0.6;
+  materials_reset = false;
+  weld_epsilon = 0.001;
+  vertexcache_optimize = true;
+  bmf_versionCode = BMF_VERSION_CODE;
+  lod_threadCount = 0;
+}
+
+
+Converter::Converter(const ConverterOptions& options)
+{
+  mOptions = options;
+}
+
+bool Converter::convert()
+{
+  // Create new model
+  boDebug() << "Loading model..." << endl;
+  Model* m = new Model();
+
+  // Set model info
+  m->setName(mOptions.modelName);
+  m->setComment(mOptions.modelComment);
+  m->setAuthor(mOptions.modelAuthor);
+
+  // Load the model
+  if(!m->load(mOptions.inFileName))
+  {
+    delete m;
+    return false;
+  }
+
+  // Load the config file
+  loadConfigFile(m);
+
+  if(mOptions.smoothAllFaces)
+  {
+    boDebug() << "Smoothing all faces..." << endl;
+    m->smoothAllFaces();
+  }
+
+  boDebug() << "Completing model loading..." << endl;
+  m->loadingCompleted();
+
+  if(!m->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "broken model loaded" << endl;
+    delete m;
+    return false;
+  }
+
+
+  // Do all necessary processing
+  if(!doModelProcessing(m))
+  {
+    boError() << k_funcinfo << "model processing failed. cannot load model." << endl;
+    delete m;
+    return false;
+  }
+
+  if(!m->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "model processing broke model" << endl;
+    delete m;
+    return false;
+  }
+
+  // Prepare the model for saving
+  boDebug() << "Preparing model for saving..." << endl;
+  m->prepareForSaving(mOptions.frame_base);
+
+  // Save the model
+  boDebug() << "Saving model..." << endl;
+  bool ret = m->save(mOptions.outFileName, mOptions.bmf_versionCode);
+  delete m;
+  return ret;
+}
+
+
+#define NEXTARG(arg) \
+    i++; \
+    if(i >= args.count()) \
+    { \
+      boError() << k_funcinfo << "No value found for argument " << arg.toStdString() << endl; \
+      return false; \
+    } \
+    arg = args[i];
+
+QString Converter::argumentsUsage()
+{
+  QString usage;
+  usage += "  -o -output <file>  Write output to <file>\n";
+  usage += "  -c -config <file>  Load config setting from <file>\n";
+  usage += "  -name <name>       Name of the model\n";
+  usage += "  -comment <text>    Comment for the model\n";
+  usage += "  -author <text>     Author(s) of the model\n";
+  usage += "  -lods <num>        Create <num> lods for the model\n";
+  usage += "  -lodfactor <f>     Every successive lod will have <f> times the faces of it's predecessor\n";
+  usage += "  -smoothall         Smooth normals will be used for the whole model\n";
+  usage += "  -useerror          Use error-based lod calculation (instead of budget-based)\n";
+  usage += "  -useboth           Use combined error- and budget-based lod calculation\n";
+  usage += "  -baseerror <num>   Set maximum lod error for the first lod to <num>\n";
+  usage += "  -errormod <num>    Every successive lod will have max error which is <num> times bigger than that of it's predecessor\n";
+  usage += "  -noframes          Remove all frames (but the first one)\n";
+  usage += "  -keepframes        Don't remove duplicate frames\n";
+  usage += "  -baseframe <num>   Make frame <num> the base frame (all calculations will be based on it)\n";
+  usage += "  -size <num>        Make model's width/height (whichever is bigger) <num> units long (default: 1)\n";
+  usage += "  -texoptimize       Combine all textures into one big texture\n";
+  usage += "  -texsize <num>     Combined texture will be <num>x<num> pixels big\n";
+  usage += "  -texname <file>    Combined texture will be written to <file> (this should be without path)\n";
+  usage += "  -texpath <dir>     Combined texture file will be put to <dir>\n";
+  usage += "  -t <dir>           Add directory <dir> to texture search path\n";
+  usage += "  -texnametolower    Convert all texture names to lowercase\n";
+  usage += "  -center            Centers the model\n";
+  usage += "  -dontloadtex       Will not try to load the used textures\n";
+  usage += "  -dontmergemeshes   Will not try to merge model's meshes\n";
+  usage += "  -resetmaterials    Resets all model's materials to a default one\n";
+  usage += "  -weldepsilon <f>   Weld vertices whose positions differ by at most <f> (default: 0.001)\n";
+  usage += "  -dontoptimizevertexcache  Will not reorder faces and vertices for the vertex cache\n";
+  usage += "  -bmfversion <num>  Write version <num> of the BMF format: 1 (arrays inside the model) or 2 (mappable arrays, default)\n";
+  usage += "  -lodthreads <num>  Simplify meshes for LODs using <num> threads (default: one per core)\n";
+  return usage;
+}
+
+bool Converter::parseArguments(const QStringList& args, ConverterOptions* options)
+{
+  if(!options)
+  {
+    BO_NULL_ERROR(options);
+    return false;
+  }
+  for(int i = 0; i < args.count(); i++)
+  {
+    QString arg = args[i];
+    QString larg = arg.toLower();
+
+    if(larg == "-o" || larg == "-output")
+    {
+      NEXTARG(arg);
+      options->outFileName = arg;
+    }
+    else if(larg == "-c" || larg == "-config")
+    {
+      NEXTARG(arg);
+      options->configFileName = arg;
+    }
+    else if(larg == "-name")
+    {
+      NEXTARG(arg);
+      options->modelName = arg;
+    }
+    else if(larg == "-comment")
+    {
+      NEXTARG(arg);
+      options->modelComment = arg;
+    }
+    else if(larg == "-author")
+    {
+      NEXTARG(arg);
+      options->modelAuthor = arg;
+    }
+    else if(larg == "-lods")
+    {
+      // TODO: error checking for arguments which use int/float/whatever
+      //  parameters
+      NEXTARG(arg);
+      options->numLods = arg.toUInt();
+    }
+    else if(larg == "-lodfactor")
+    {
+      NEXTARG(arg);
+      options->lod_factor = arg.toFloat();
+    }
+    else if(larg == "-q" || larg == "-quick")
+    {
+      boError() << "'-quick' argument not yet implemented!" << endl;
+    }
+    else if(larg == "-smoothall")
+    {
+      options->smoothAllFaces = true;
+    }
+    else if(larg == "-useerror")
+    {
+      options->lod_useError = true;
+    }
+    else if(larg == "-useboth")
+    {
+      options->lod_useError = true;
+      options->lod_useBoth = true;
+    }
+    else if(larg == "-baseerror")
+    {
+      NEXTARG(arg);
+      options->lod_baseError = arg.toFloat();
+    }
+    else if(larg == "-errormod")
+    {
+      NEXTARG(arg);
+      options->lod_errorMod = arg.toFloat();
+    }
+    else if(larg == "-baseframe")
+    {
+      NEXTARG(arg);
+      options->frame_base = arg.toUInt();
+    }
+    else if(larg == "-noframes")
+    {
+      options->frames_keepCount = 1;
+    }
+    else if(larg == "-keepframes")
+    {
+      options->frames_keepAll = true;
+    }
+    else if(larg == "-size")
+    {
+      NEXTARG(arg);
+      options->modelSize = arg.toFloat();
+    }
+    else if(larg == "-texsize")
+    {
+      NEXTARG(arg);
+      options->tex_size = arg.toUInt();
+    }
+    else if(larg == "-t")
+    {
+      NEXTARG(arg);
+      options->texturePaths.append(arg);
+    }
+    else if(larg == "-texoptimize")
+    {
+      options->tex_optimize = true;
+    }
+    else if(larg == "-texname")
+    {
+      NEXTARG(arg);
+      options->tex_name = arg;
+    }
+    else if(larg == "-texpath")
+    {
+      NEXTARG(arg);
+      options->tex_path = arg;
+    }
+    else if(larg == "-texnametolower")
+    {
+      options->tex_convertToLowerCase = true;
+    }
+    else if(larg == "-center")
+    {
+      options->model_center = true;
+    }
+    else if(larg == "-dontloadtex")
+    {
+      options->tex_dontLoad = true;
+    }
+    else if(larg == "-dontmergemeshes")
+    {
+      options->meshes_merge = false;
+    }
+    else if(larg == "-resetmaterials")
+    {
+      options->materials_reset = true;
+    }
+    else if(larg == "-weldepsilon")
+    {
+      NEXTARG(arg);
+      options->weld_epsilon = arg.toFloat();
+    }
+    else if(larg == "-dontoptimizevertexcache")
+    {
+      options->vertexcache_optimize = false;
+    }
+    else if(larg == "-bmfversion")
+    {
+      NEXTARG(arg);
+      if(arg == "1")
+      {
+        options->bmf_versionCode = BMF_VERSION_CODE_STREAMED_ARRAYS;
+      }
+      else if(arg == "2")
+      {
+        options->bmf_versionCode = BMF_VERSION_CODE_MAPPED_ARRAYS;
+      }
+      else
+      {
+        boError() << "Unsupported BMF version " << arg.toStdString() << endl;
+        return false;
+      }
+    }
+    else if(larg == "-lodthreads")
+    {
+      NEXTARG(arg);
+      bool ok = false;
+      options->lod_threadCount = arg.toUInt(&ok);
+      if(!ok || options->lod_threadCount == 0)
+      {
+        boError() << "Invalid number of LOD threads " << arg.toStdString() << endl;
+        return false;
+      }
+    }
+    else
+    {
+      if(arg[0] == '-')
+      {
+        boError() << "Unrecognized argument " << arg.toStdString() << endl;
+        return false;
+      }
+
+      options->inFileName = arg;
+    }
+  }
+
+  return true;
+}
+
+bool Converter::checkOptions()
+{
+  // Check input file
+  if(mOptions.inFileName.isEmpty())
+  {
+    boError() << "No input file specified!" << endl;
+    return false;
+  }
+  QFileInfo inFileinfo(mOptions.inFileName);
+  if(!inFileinfo.exists())
+  {
+    boError() << "Input file '" << mOptions.inFileName.toStdString() << "' doesn't exist!" << endl;
+    return false;
+  }
+  else if(!inFileinfo.isReadable())
+  {
+    boError() << "Input file '" << mOptions.inFileName.toStdString() << "' isn't readable!" << endl;
+    return false;
+  }
+
+  // Output file
+  if(mOptions.outFileName.isEmpty())
+  {
+    // Create output filename by replacing input file's extension with '.bmf'
+    int i = mOptions.inFileName.lastIndexOf('.');
+    if(i == -1)
+    {
+      // Filename didn't have '.' in it. Just append '.bmf'
+      mOptions.outFileName = mOptions.inFileName + ".bmf";
+    }
+    else
+    {
+      mOptions.outFileName = mOptions.inFileName.left(i) + ".bmf";
+    }
+  }
+
+  // Output texture file
+  if(mOptions.tex_name.isEmpty())
+  {
+    // Create output texture filename by replacing input file's extension with
+    //  '.jpg'
+    int i = mOptions.inFileName.lastIndexOf('.');
+    if(i == -1)
+    {
+      // Filename didn't have '.' in it. Just append '.jpg'
+      mOptions.tex_name = mOptions.inFileName + ".jpg";
+    }
+    else
+    {
+      mOptions.tex_name = mOptions.inFileName.left(i) + ".jpg";
+    }
+  }
+
+  // Config file
+  if(!mOptions.configFileName.isEmpty())
+  {
+    QFileInfo configFileInfo(mOptions.configFileName);
+    if(!configFileInfo.exists())
+    {
+      boError() << "Config file '" << mOptions.configFileName.toStdString() << "' doesn't exist!" << endl;
+      return false;
+    }
+    else if(!configFileInfo.isReadable())
+    {
+      boError() << "Config file '" << mOptions.configFileName.toStdString() << "' isn't readable!" << endl;
+      return false;
+    }
+    mOptions.configFileName = configFileInfo.absoluteFilePath();
+  }
+
+  return true;
+}
+
+bool Converter::loadConfigFile(Model* m)
+{
+  if(mOptions.configFileName.isEmpty())
+  {
+    return true;
+  }
+
+  //KSimpleConfig cfg(mOptions.configFileName, true);
+
+  // Load model size
+  QSettings cfg(mOptions.configFileName);
+  cfg.beginGroup("Boson Unit");
+  mOptions.modelSize = (float)cfg.value("UnitWidth", mOptions.modelSize).toFloat();
+  cfg.endGroup();
+
+  // Load entries from "Model" config group.
+  // Note that size entry here takes preference over the one in "Boson Unit"
+  //  group.
+  cfg.beginGroup("Model");
+  mOptions.modelSize = (float)cfg.value("Size", mOptions.modelSize).toFloat();
+  mOptions.meshes_merge = cfg.value("MergeMeshes", mOptions.meshes_merge).toBool();
+  mOptions.usenormalcalculator = cfg.value("UseNormalCalculator", mOptions.usenormalcalculator).toBool();
+  mOptions.normalcalculator_threshold = (float)cfg.value("NormalCalculatorThreshold", mOptions.normalcalculator_threshold).toFloat();
+  mOptions.frames_keepCount = cfg.value("KeepFramesCount", mOptions.frames_keepCount).toInt();
+  mOptions.numLods = cfg.value("LODs", mOptions.numLods).toInt();
+  mOptions.weld_epsilon = (float)cfg.value("WeldEpsilon", mOptions.weld_epsilon).toFloat();
+
+  if(mOptions.frames_keepCount == -1)
+  {
+    mOptions.frames_keepCount = 1;
+    QMap<QString, QString> entries = cfg.value("Model").value<QMap<QString, QString> >();
+    QRegExp animationend("Animation-[A-Za-z]+-End");
+    for(QMap<QString, QString>::Iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+      if(animationend.exactMatch(it.key()))
+      {
+        mOptions.frames_keepCount = qMax(mOptions.frames_keepCount, cfg.value(it.key(), 0).toInt()+1);
+      }
+    }
+    boDebug() << k_funcinfo << "Automatically set number of kept frames to " << mOptions.frames_keepCount << endl;
+  }
+  cfg.endGroup();
+
+  return true;
+}
+
+
+bool Converter::doModelProcessing(Model* m)
+{
+  if(!mOptions.tex_dontLoad)
+  {
+    // Load textures
+    m->loadTextures();
+  }
+  else
+  {
+    boDebug() << "not loading textures due to request." << endl;
+  }
+
+  if(mOptions.tex_convertToLowerCase)
+  {
+    // Convert texture names to lowercase
+    QHashIterator<QString, Texture> it(*m->texturesDict());
+    while(it.current())
+    {
+      it.current()->setFilename(it.current()->filename().toLower());
+      ++it;
+    }
+  }
+  boDebug() << "LOD 0 had " << m->baseLOD()->shortStats() << endl;
+
+  Processor::setBaseFrame(mOptions.frame_base);
+
+  if(!m->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "cannot process broken model" << endl;
+    return false;
+  }
+
+  QList<Processor*> processorList;
+
+  processorList.append(new DefaultMaterials);
+  processorList.append(new UnusedDataRemover);
+  if(!mOptions.frames_keepAll || mOptions.frames_keepCount > 0)
+  {
+    FrameOptimizer* frameOptimizer = new FrameOptimizer();
+    frameOptimizer->setName("DuplicateFrameRemover");
+    frameOptimizer->setKeepFramesCount(mOptions.frames_keepCount);
+    processorList.append(frameOptimizer);
+  }
+
+  Transformer* transformer = new Transformer();
+  transformer->setModelSize(mOptions.modelSize);
+  transformer->setCenterModel(mOptions.model_center);
+  processorList.append(transformer);
+  transformer = 0;
+
+  if(mOptions.tex_optimize)
+  {
+    TextureOptimizer* textureOptimizer = new TextureOptimizer();
+    textureOptimizer->setCombinedTexSize(mOptions.tex_size);
+    textureOptimizer->setCombinedTexFilename(mOptions.tex_name);
+    textureOptimizer->setCombinedTexPath(mOptions.tex_path);
+    processorList.append(textureOptimizer);
+  }
+
+  processorList.append(new NodeOptimizer());
+
+  if(mOptions.usenormalcalculator)
+  {
+    processorList.append(new NormalCalculator(mOptions.normalcalculator_threshold));
+  }
+  MaterialOptimizer* materialOptimizer = new MaterialOptimizer();
+  materialOptimizer->setResetMaterials(mOptions.materials_reset);
+  processorList.append(materialOptimizer);
+  if(mOptions.meshes_merge)
+  {
+    processorList.append(new MeshOptimizer());
+  }
+  processorList.append(new VertexOptimizer(mOptions.weld_epsilon));
+
+
+  bool ret = executeProcessors(m, processorList);
+  qDeleteAll(processorList);
+  processorList.clear();
+  if(!ret)
+  {
+    return false;
+  }
+
+
+  if(!mOptions.usenormalcalculator)
+  {
+    boDebug() << "Calculating model's face normals..." << endl;
+    m->calculateFaceNormals();
+
+    boDebug() << "Calculating model's vertex normals..." << endl;
+    m->calculateVertexNormals();
+  }
+
+  boDebug() << "Creating lods..." << endl;
+  m->createLODs(mOptions.numLods);
+
+  if(!m->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "broken model after initial LOD creation" << endl;
+    return false;
+  }
+
+  // The meshes of all LODs are independent of each other, so they are
+  //  simplified in parallel. Every mesh gets its own MxStdModel, so the result
+  //  is the same as with a single thread.
+  QList<LodCreator*> lodCreators;
+  float targetFactor = 1.0f;
+  float lodError = mOptions.lod_baseError;
+  for(unsigned int i = 1; i < mOptions.numLods; i++)
+  {
+    targetFactor *= mOptions.lod_factor;
+    LodCreator* lodCreator = new LodCreator(i);
+    lodCreator->setFaceTargetFactor(targetFactor);
+    lodCreator->setMaxError(lodError);
+    lodCreator->setUseError(mOptions.lod_useError);
+    lodCreator->setUseBoth(mOptions.lod_useBoth);
+    lodCreators.append(lodCreator);
+
+    lodError *= mOptions.lod_errorMod;
+  }
+  ret = true;
+  for(int i = 0; i < lodCreators.count() && ret; i++)
+  {
+    if(!lodCreators[i]->initProcessor(m))
+    {
+      boError() << k_funcinfo << "initializing of processor " << lodCreators[i]->name() << " failed" << endl;
+      ret = false;
+    }
+  }
+  if(ret)
+  {
+    unsigned int threadCount = mOptions.lod_threadCount;
+    if(threadCount == 0)
+    {
+      threadCount = qMax(1, QThread::idealThreadCount());
+    }
+    ret = LodCreator::processParallel(lodCreators, threadCount);
+  }
+  qDeleteAll(lodCreators);
+  lodCreators.clear();
+  if(!ret)
+  {
+    return false;
+  }
+  if(!m->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "model broken after creating LODs" << endl;
+    return false;
+  }
+
+  // Reorder faces and vertices after all LODs have been created, as the
+  //  LodCreator creates new faces
+  if(mOptions.vertexcache_optimize)
+  {
+    for(unsigned int i = 0; i < m->lodCount(); i++)
+    {
+      processorList.append(new VertexCacheOptimizer(i));
+    }
+  }
+
+
+  ret = executeProcessors(m, processorList);
+  qDeleteAll(processorList);
+  processorList.clear();
+  if(!ret)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+
+bool Converter::executeProcessors(Model* model, const QList<Processor*>& list)
+{
+  if(!model)
+  {
+    BO_NULL_ERROR(model);
+    return false;
+  }
+  if(!model->checkLoadedModel())
+  {
+    boError() << k_funcinfo << "cannot process broken model" << endl;
+    return false;
+  }
+  for(int i = 0; i < list.count(); i++)
+  {
+    Processor* processor = list[i];
+    QString name = processor->name();
+    if(name.isEmpty())
+    {
+      name = "Unnamed";
+    }
+    boDebug() << k_funcinfo << "starting " << name << endl;
+    if(!processor->initProcessor(model))
+    {
+      boError() << k_funcinfo << "initializing of processor " << name << " failed" << endl;
+      return false;
+    }
+    if(!processor->process())
+    {
+      boError() << k_funcinfo << "processor " << name << " failed" << endl;
+      return false;
+    }
+    if(!model->checkLoadedModel())
+    {
+      boError() << k_funcinfo << "model broken after executing processor " << name << ". Fix that processor!" << endl;
+      return false;
+    }
+    boDebug() << k_funcinfo << name << " succeeded" << endl;
+  }
+  return true;
+}
+
+/*
+ * vim: et sw=2
+ */
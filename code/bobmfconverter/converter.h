@@ -0,0 +1,145 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2005 Rivo Laks (rivolaks@hot.ee)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CONVERTER_H
+#define CONVERTER_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <QList>
+
+class Model;
+class Processor;
+
+
+/**
+ * Settings for the conversion of a single model, see @ref Converter.
+ *
+ * These used to be global variables of the converter, they are collected
+ * here so that several models can be converted at the same time.
+ **/
+class ConverterOptions
+{
+  public:
+    ConverterOptions();
+
+    QString inFileName;
+    QString outFileName;
+    QString modelName;
+    QString modelComment;
+    QString modelAuthor;
+    QString configFileName;
+    unsigned int numLods;
+    float lod_factor;
+    bool smoothAllFaces;
+    bool lod_useError;
+    bool lod_useBoth;
+    float lod_baseError;
+    float lod_errorMod;
+    int frames_keepCount;
+    unsigned int frame_base;
+    bool frames_keepAll;
+    float modelSize;
+    unsigned int tex_size;
+    QString tex_name;
+    QString tex_path;
+    bool tex_convertToLowerCase;
+    bool tex_optimize;
+    bool model_center;
+    bool tex_dontLoad;
+    bool meshes_merge;
+    bool usenormalcalculator;
+    float normalcalculator_threshold;
+    bool materials_reset;
+    float weld_epsilon;
+    bool vertexcache_optimize;
+    unsigned int bmf_versionCode;
+
+    /**
+     * Number of threads used by the @ref LodCreator. 0 means one thread per
+     * core, see QThread::idealThreadCount().
+     **/
+    unsigned int lod_threadCount;
+
+    /**
+     * Directories given by "-t". Note that the texture search path is
+     * shared by all conversions, see @ref Texture::addTexturePath.
+     **/
+    QStringList texturePaths;
+};
+
+
+/**
+ * Converts a single model into the BMF format: the model is loaded (see @ref
+ * Loader), processed by the chain of @ref Processor objects and saved (see
+ * @ref Saver).
+ *
+ * Several Converter objects can be used in different threads at the same
+ * time, as long as the texture search path is not modified meanwhile.
+ **/
+class Converter
+{
+  public:
+    Converter(const ConverterOptions& options);
+
+    const ConverterOptions& options() const  { return mOptions; }
+
+    /**
+     * See @ref ConverterOptions::lod_threadCount
+     **/
+    void setLodThreadCount(unsigned int count)  { mOptions.lod_threadCount = count; }
+
+    /**
+     * Parse the command line arguments @p args (without the program name)
+     * of a single conversion into @p options.
+     * @return FALSE if an argument is invalid.
+     **/
+    static bool parseArguments(const QStringList& args, ConverterOptions* options);
+
+    /**
+     * @return The description of the arguments accepted by @ref
+     * parseArguments.
+     **/
+    static QString argumentsUsage();
+
+    /**
+     * Verify the options and fill in default values for the output files.
+     **/
+    bool checkOptions();
+
+    /**
+     * Load, process and save the model.
+     * @return TRUE if the model was converted successfully.
+     **/
+    bool convert();
+
+  protected:
+    bool loadConfigFile(Model* m);
+    bool doModelProcessing(Model* m);
+    bool executeProcessors(Model* model, const QList<Processor*>& list);
+
+  private:
+    ConverterOptions mOptions;
+};
+
+
+/*
+ * vim: et sw=2
+ */
+#endif //CONVERTER_H
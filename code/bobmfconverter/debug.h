@@ -24,7 +24,7 @@
 #include <sys/time.h>
 #include <stdio.h>
 extern double starttime;
-extern char dbgtimestr[20];
+extern thread_local char dbgtimestr[20];
 void initdbgtime();
 char* dbgtime();
 
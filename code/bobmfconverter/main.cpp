@@ -17,74 +17,34 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 */
 
+#include "converter.h"
 #include "model.h"
 #include "debug.h"
 #include "lod.h"
 #include "frame.h"
 #include "texture.h"
 #include "material.h"
-#include "processors/lodcreator.h"
-#include "processors/transformer.h"
-#include "processors/vertexoptimizer.h"
-#include "processors/frameoptimizer.h"
-#include "processors/unuseddataremover.h"
-#include "processors/meshoptimizer.h"
-#include "processors/textureoptimizer.h"
-#include "processors/materialoptimizer.h"
-#include "processors/defaultmaterials.h"
-#include "processors/normalcalculator.h"
-#include "processors/nodeoptimizer.h"
 
 #include <qstring.h>
-#include <qfileinfo.h>
-#include <qvaluelist.h>
-#include <qpair.h>
-#include <qregexp.h>
-#include <QSettings>
-
-//#include <kinstance.h>
-//#include <ksimpleconfig.h>
+#include <qstringlist.h>
+#include <qfile.h>
+#include <qtextstream.h>
+#include <QThread>
+#include <QMutex>
+#include <QVector>
 
 
 bool processCommandLine(int argc, char** argv);
-bool checkConfig();
-bool loadConfigFile(Model* m);
-bool doModelProcessing(Model* m);
-bool executeProcessors(Model* model, const QVector<Processor*>& list);
+bool convertBatch(const QString& batchFileName, unsigned int threadCount);
 
 // Global variables - used for configuration
-QString g_inFileName;
-QString g_outFileName;
-QString g_modelName;
-QString g_modelComment;
-QString g_modelAuthor;
-QString g_configFileName;
-unsigned int g_numLods = 5;
-float g_lod_factor = 0.5;
-bool g_smoothAllFaces = false;
-bool g_lod_useError = false;
-bool g_lod_useBoth = false;
-float g_lod_baseError = 0.075;
-float g_lod_errorMod = 4.0;
-int g_frames_keepCount = -1;
-unsigned int g_frame_base = 0;
-bool g_frames_keepAll = true;
-float g_modelSize = 1.0;
-unsigned int g_tex_size = 512;
-QString g_tex_name;
-QString g_tex_path;
-bool g_tex_convertToLowerCase = false;
-bool g_tex_optimize = false;
-bool g_model_center = false;
-bool g_tex_dontLoad = false;
-bool g_meshes_merge = true;
-bool g_usenormalcalculator = true;
-float g_normalcalculator_threshold = 0.6;
-bool g_materials_reset = false;
+ConverterOptions g_options;
+QString g_batchFileName;
+unsigned int g_threadCount = 0;
 
 
 double starttime;
-char dbgtimestr[20];
+thread_local char dbgtimestr[20];
 void initdbgtime()
 {
   struct timeval tm;
@@ -114,86 +74,43 @@ int main(int argc, char** argv)
     return 1;
   }
 
-  // Verify config
-  boDebug() << "Checking config..." << endl;
-  if(!checkConfig())
-  {
-    return 1;
-  }
-
-
-  // Create new model
-  boDebug() << "Loading model..." << endl;
-  Model* m = new Model();
-
-  // Set model info
-  m->setName(g_modelName);
-  m->setComment(g_modelComment);
-  m->setAuthor(g_modelAuthor);
-
-  // Load the model
-  if(!m->load(g_inFileName))
-  {
-    return 1;
-  }
-
-  // Load the config file
-  loadConfigFile(m);
-
-  if(g_smoothAllFaces)
+  if(!g_batchFileName.isEmpty())
   {
-    boDebug() << "Smoothing all faces..." << endl;
-    m->smoothAllFaces();
+    if(!convertBatch(g_batchFileName, g_threadCount))
+    {
+      return 1;
+    }
+    boDebug() << "All done!" << endl;
+    return 0;
   }
 
-  boDebug() << "Completing model loading..." << endl;
-  m->loadingCompleted();
-
-  if(!m->checkLoadedModel())
+  for(int i = 0; i < g_options.texturePaths.count(); i++)
   {
-    boError() << k_funcinfo << "broken model loaded" << endl;
-    return 1;
+    Texture::addTexturePath(g_options.texturePaths[i]);
   }
 
-
-  // Do all necessary processing
-  if(!doModelProcessing(m))
+  // Verify config
+  boDebug() << "Checking config..." << endl;
+  Converter converter(g_options);
+  if(!converter.checkOptions())
   {
-    boError() << k_funcinfo << "model processing failed. cannot load model." << endl;
     return 1;
   }
 
-  if(!m->checkLoadedModel())
+  if(!converter.convert())
   {
-    boError() << k_funcinfo << "model processing broke model" << endl;
     return 1;
   }
 
-  // Prepare the model for saving
-  boDebug() << "Preparing model for saving..." << endl;
-  m->prepareForSaving(g_frame_base);
-
-  // Save the model
-  boDebug() << "Saving model..." << endl;
-  m->save(g_outFileName);
-
   // Done!
   boDebug() << "All done!" << endl;
   return 0;
 }
 
 
-#define NEXTARG(arg) \
-    i++; \
-    if(i >= argc) \
-    { \
-      boError() << k_funcinfo << "No value found for argument " << arg.toStdString() << endl; \
-      return false; \
-    } \
-    arg = argv[i];
-
 bool processCommandLine(int argc, char** argv)
 {
+  QStringList args;
   for(int i = 1; i < argc; i++)
   {
     QString arg = QString(argv[i]);
@@ -202,34 +119,14 @@ bool processCommandLine(int argc, char** argv)
     if(larg == "-h" || larg == "-help" || larg == "--help")
     {
       QString usage = QString("Usage: %1 [arguments] <filename>\n").arg(argv[0]);
+      usage += QString("       %1 -batch <file> [-j <num>]\n").arg(argv[0]);
       usage += "\n";
       usage += "Arguments:\n";
-      usage += "  -o -output <file>  Write output to <file>\n";
-      usage += "  -c -config <file>  Load config setting from <file>\n";
-      usage += "  -name <name>       Name of the model\n";
-      usage += "  -comment <text>    Comment for the model\n";
-      usage += "  -author <text>     Author(s) of the model\n";
-      usage += "  -lods <num>        Create <num> lods for the model\n";
-      usage += "  -lodfactor <f>     Every successive lod will have <f> times the faces of it's predecessor\n";
-      usage += "  -smoothall         Smooth normals will be used for the whole model\n";
-      usage += "  -useerror          Use error-based lod calculation (instead of budget-based)\n";
-      usage += "  -useboth           Use combined error- and budget-based lod calculation\n";
-      usage += "  -baseerror <num>   Set maximum lod error for the first lod to <num>\n";
-      usage += "  -errormod <num>    Every successive lod will have max error which is <num> times bigger than that of it's predecessor\n";
-      usage += "  -noframes          Remove all frames (but the first one)\n";
-      usage += "  -keepframes        Don't remove duplicate frames\n";
-      usage += "  -baseframe <num>   Make frame <num> the base frame (all calculations will be based on it)\n";
-      usage += "  -size <num>        Make model's width/height (whichever is bigger) <num> units long (default: 1)\n";
-      usage += "  -texoptimize       Combine all textures into one big texture\n";
-      usage += "  -texsize <num>     Combined texture will be <num>x<num> pixels big\n";
-      usage += "  -texname <file>    Combined texture will be written to <file> (this should be without path)\n";
-      usage += "  -texpath <dir>     Combined texture file will be put to <dir>\n";
-      usage += "  -t <dir>           Add directory <dir> to texture search path\n";
-      usage += "  -texnametolower    Convert all texture names to lowercase\n";
-      usage += "  -center            Centers the model\n";
-      usage += "  -dontloadtex       Will not try to load the used textures\n";
-      usage += "  -dontmergemeshes   Will not try to merge model's meshes\n";
-      usage += "  -resetmaterials    Resets all model's materials to a default one\n";
+      usage += Converter::argumentsUsage();
+      usage += "  -batch <file>      Convert all models listed in <file>. Every line of <file>\n";
+      usage += "                     contains the arguments for one model, separated by tabs\n";
+      usage += "  -j <num>           Convert <num> models of a batch at the same time\n";
+      usage += "                     (default: number of CPUs)\n";
       //usage += "  \n";
       cout << usage.toStdString();
       return false;
@@ -239,274 +136,180 @@ bool processCommandLine(int argc, char** argv)
       cerr << "BoBMFConverter version 0.13pre" << endl;
       return false;
     }
-    else if(larg == "-o" || larg == "-output")
-    {
-      NEXTARG(arg);
-      g_outFileName = arg;
-    }
-    else if(larg == "-c" || larg == "-config")
-    {
-      NEXTARG(arg);
-      g_configFileName = arg;
-    }
-    else if(larg == "-name")
-    {
-      NEXTARG(arg);
-      g_modelName = arg;
-    }
-    else if(larg == "-comment")
-    {
-      NEXTARG(arg);
-      g_modelComment = arg;
-    }
-    else if(larg == "-author")
-    {
-      NEXTARG(arg);
-      g_modelAuthor = arg;
-    }
-    else if(larg == "-lods")
-    {
-      // TODO: error checking for arguments which use int/float/whatever
-      //  parameters
-      NEXTARG(arg);
-      g_numLods = arg.toUInt();
-    }
-    else if(larg == "-lodfactor")
-    {
-      NEXTARG(arg);
-      g_lod_factor = arg.toFloat();
-    }
-    else if(larg == "-q" || larg == "-quick")
-    {
-      boError() << "'-quick' argument not yet implemented!" << endl;
-    }
-    else if(larg == "-smoothall")
-    {
-      g_smoothAllFaces = true;
-    }
-    else if(larg == "-useerror")
-    {
-      g_lod_useError = true;
-    }
-    else if(larg == "-useboth")
-    {
-      g_lod_useError = true;
-      g_lod_useBoth = true;
-    }
-    else if(larg == "-baseerror")
-    {
-      NEXTARG(arg);
-      g_lod_baseError = arg.toFloat();
-    }
-    else if(larg == "-errormod")
-    {
-      NEXTARG(arg);
-      g_lod_errorMod = arg.toFloat();
-    }
-    else if(larg == "-baseframe")
+    else if(larg == "-batch" || larg == "-j")
     {
-      NEXTARG(arg);
-      g_frame_base = arg.toUInt();
-    }
-    else if(larg == "-noframes")
-    {
-      g_frames_keepCount = 1;
-    }
-    else if(larg == "-keepframes")
-    {
-      g_frames_keepAll = true;
-    }
-    else if(larg == "-size")
-    {
-      NEXTARG(arg);
-      g_modelSize = arg.toFloat();
-    }
-    else if(larg == "-texsize")
-    {
-      NEXTARG(arg);
-      g_tex_size = arg.toUInt();
-    }
-    else if(larg == "-t")
-    {
-      NEXTARG(arg);
-      Texture::addTexturePath(arg);
-    }
-    else if(larg == "-texoptimize")
-    {
-      g_tex_optimize = true;
-    }
-    else if(larg == "-texname")
-    {
-      NEXTARG(arg);
-      g_tex_name = arg;
-    }
-    else if(larg == "-texpath")
-    {
-      NEXTARG(arg);
-      g_tex_path = arg;
-    }
-    else if(larg == "-texnametolower")
-    {
-      g_tex_convertToLowerCase = true;
-    }
-    else if(larg == "-center")
-    {
-      g_model_center = true;
-    }
-    else if(larg == "-dontloadtex")
-    {
-      g_tex_dontLoad = true;
+      i++;
+      if(i >= argc)
+      {
+        boError() << k_funcinfo << "No value found for argument " << arg.toStdString() << endl;
+        return false;
+      }
+      if(larg == "-batch")
+      {
+        g_batchFileName = argv[i];
+      }
+      else
+      {
+        g_threadCount = QString(argv[i]).toUInt();
+      }
     }
-    else if(larg == "-dontmergemeshes")
+    else
     {
-      g_meshes_merge = false;
+      args.append(arg);
     }
-    else if(larg == "-resetmaterials")
+  }
+
+  if(!g_batchFileName.isEmpty() && !args.isEmpty())
+  {
+    boError() << "-batch can not be used with other arguments" << endl;
+    return false;
+  }
+
+  return Converter::parseArguments(args, &g_options);
+}
+
+
+/**
+ * Converts the models of a batch. Every thread takes the next model that has
+ * not been converted yet, until all models are done.
+ **/
+class ConverterThread : public QThread
+{
+  public:
+    ConverterThread(QVector<Converter*>* converters, QVector<bool>* results, int* next, QMutex* mutex)
     {
-      g_materials_reset = true;
+      mConverters = converters;
+      mResults = results;
+      mNext = next;
+      mMutex = mutex;
     }
-    else
+
+  protected:
+    virtual void run()
     {
-      if(arg[0] == '-')
+      while(true)
       {
-        boError() << "Unrecognized argument " << arg.toStdString() << endl;
-        return false;
+        mMutex->lock();
+        int index = *mNext;
+        (*mNext)++;
+        mMutex->unlock();
+        if(index >= mConverters->count())
+        {
+          return;
+        }
+        Converter* converter = (*mConverters)[index];
+        (*mResults)[index] = converter->convert();
       }
-
-      g_inFileName = arg;
     }
-  }
 
-  return true;
-}
+  private:
+    QVector<Converter*>* mConverters;
+    QVector<bool>* mResults;
+    int* mNext;
+    QMutex* mMutex;
+};
 
-bool checkConfig()
+bool convertBatch(const QString& batchFileName, unsigned int threadCount)
 {
-  // Check input file
-  if(g_inFileName.isEmpty())
-  {
-    boError() << "No input file specified!" << endl;
-    return false;
-  }
-  QFileInfo inFileinfo(g_inFileName);
-  if(!inFileinfo.exists())
-  {
-    boError() << "Input file '" << g_inFileName.toStdString() << "' doesn't exist!" << endl;
-    return false;
-  }
-  else if(!inFileinfo.isReadable())
+  QFile file(batchFileName);
+  if(!file.open(QIODevice::ReadOnly))
   {
-    boError() << "Input file '" << g_inFileName.toStdString() << "' isn't readable!" << endl;
+    boError() << "Could not open batch file '" << batchFileName.toStdString() << "'" << endl;
     return false;
   }
 
-  // Output file
-  if(g_outFileName.isEmpty())
+  // Parse all lines first, so that the texture search path is complete
+  //  before any thread uses it.
+  QVector<Converter*> converters;
+  QTextStream stream(&file);
+  bool ret = true;
+  while(!stream.atEnd())
   {
-    // Create output filename by replacing input file's extension with '.bmf'
-    int i = g_inFileName.lastIndexOf('.');
-    if(i == -1)
+    QString line = stream.readLine();
+    if(line.trimmed().isEmpty() || line.startsWith("#"))
     {
-      // Filename didn't have '.' in it. Just append '.bmf'
-      g_outFileName = g_inFileName + ".bmf";
+      continue;
     }
-    else
+    ConverterOptions options;
+    if(!Converter::parseArguments(line.split('\t', QString::SkipEmptyParts), &options))
     {
-      g_outFileName = g_inFileName.left(i) + ".bmf";
+      boError() << "Invalid arguments in batch file: " << line.toStdString() << endl;
+      ret = false;
+      continue;
     }
-  }
-
-  // Output texture file
-  if(g_tex_name.isEmpty())
-  {
-    // Create output texture filename by replacing input file's extension with
-    //  '.jpg'
-    int i = g_inFileName.lastIndexOf('.');
-    if(i == -1)
+    Converter* converter = new Converter(options);
+    if(!converter->checkOptions())
     {
-      // Filename didn't have '.' in it. Just append '.jpg'
-      g_tex_name = g_inFileName + ".jpg";
+      delete converter;
+      ret = false;
+      continue;
     }
-    else
+    for(int i = 0; i < options.texturePaths.count(); i++)
     {
-      g_tex_name = g_inFileName.left(i) + ".jpg";
+      if(!Texture::texturePaths().contains(options.texturePaths[i]))
+      {
+        Texture::addTexturePath(options.texturePaths[i]);
+      }
     }
+    converters.append(converter);
   }
+  file.close();
 
-  // Config file
-  if(!g_configFileName.isEmpty())
+  if(threadCount == 0)
   {
-    QFileInfo configFileInfo(g_configFileName);
-    if(!configFileInfo.exists())
-    {
-      boError() << "Config file '" << g_configFileName.toStdString() << "' doesn't exist!" << endl;
-      return false;
-    }
-    else if(!configFileInfo.isReadable())
+    threadCount = QThread::idealThreadCount();
+  }
+  threadCount = qMax(1, qMin((int)threadCount, converters.count()));
+  boDebug() << "Converting " << converters.count() << " models using " << threadCount << " threads..." << endl;
+
+  // The models are already converted in parallel, so share the remaining
+  //  cores between the LOD creators of the models.
+  unsigned int lodThreadCount = qMax(1, QThread::idealThreadCount() / (int)threadCount);
+  for(int i = 0; i < converters.count(); i++)
+  {
+    if(converters[i]->options().lod_threadCount == 0)
     {
-      boError() << "Config file '" << g_configFileName.toStdString() << "' isn't readable!" << endl;
-      return false;
+      converters[i]->setLodThreadCount(lodThreadCount);
     }
-    g_configFileName = configFileInfo.absoluteFilePath();
   }
 
-  return true;
-}
-
-bool loadConfigFile(Model* m)
-{
-  if(g_configFileName.isEmpty())
+  QVector<bool> results(converters.count(), false);
+  int next = 0;
+  QMutex mutex;
+  QList<ConverterThread*> threads;
+  for(unsigned int i = 0; i < threadCount; i++)
+  {
+    ConverterThread* thread = new ConverterThread(&converters, &results, &next, &mutex);
+    threads.append(thread);
+    thread->start();
+  }
+  for(int i = 0; i < threads.count(); i++)
   {
-    return true;
+    threads[i]->wait();
   }
+  qDeleteAll(threads);
 
-  //KSimpleConfig cfg(g_configFileName, true);
-
-  // Load model size
-  QSettings cfg(g_configFileName);
-  cfg.beginGroup("Boson Unit");
-  g_modelSize = (float)cfg.value("UnitWidth", g_modelSize).toFloat();
-  cfg.endGroup();
-
-  // Load entries from "Model" config group.
-  // Note that size entry here takes preference over the one in "Boson Unit"
-  //  group.
-  cfg.beginGroup("Model");
-  g_modelSize = (float)cfg.value("Size", g_modelSize).toFloat();
-  g_meshes_merge = cfg.value("MergeMeshes", g_meshes_merge).toBool();
-  g_usenormalcalculator = cfg.value("UseNormalCalculator", g_usenormalcalculator).toBool();
-  g_normalcalculator_threshold = (float)cfg.value("NormalCalculatorThreshold", g_normalcalculator_threshold).toFloat();
-  g_frames_keepCount = cfg.value("KeepFramesCount", g_frames_keepCount).toInt();
-  g_numLods = cfg.value("LODs", g_numLods).toInt();
-
-  if(g_frames_keepCount == -1)
+  for(int i = 0; i < converters.count(); i++)
   {
-    g_frames_keepCount = 1;
-    QMap<QString, QString> entries = cfg.value("Model").value<QMap<QString, QString> >();
-    QRegExp animationend("Animation-[A-Za-z]+-End");
-    for(QMap<QString, QString>::Iterator it = entries.begin(); it != entries.end(); ++it)
+    if(!results[i])
     {
-      if(animationend.exactMatch(it.key()))
-      {
-        g_frames_keepCount = qMax(g_frames_keepCount, cfg.value(it.key(), 0).toInt()+1);
-      }
+      boError() << "Converting '" << converters[i]->options().inFileName.toStdString() << "' failed" << endl;
+      ret = false;
     }
-    boDebug() << k_funcinfo << "Automatically set number of kept frames to " << g_frames_keepCount << endl;
   }
-  cfg.endGroup();
-
-  return true;
+  qDeleteAll(converters);
+  return ret;
 }
 
 
 #include <fstream>
 #include "mesh.h"
 using namespace std;
-void saveLod(Model* m, unsigned int i)
+void saveLod(Model* m, unsigned int i, const QString& outFileName)
 {
   LOD* l = m->lod(i);
 
-  ofstream out(QString("%1-%2.obj").arg(g_outFileName).arg(i).toStdString());
+  ofstream out(QString("%1-%2.obj").arg(outFileName).arg(i).toStdString());
 
   QString vertexStr;
   QString faceStr;
@@ -535,12 +338,12 @@ void saveLod(Model* m, unsigned int i)
   out.close();
 }
 #include "bo3dtools.h"
-void saveLodFrame(Model* m, unsigned int lodi, unsigned int framei)
+void saveLodFrame(Model* m, unsigned int lodi, unsigned int framei, const QString& outFileName)
 {
   LOD* l = m->lod(lodi);
   Frame* f = l->frame(framei);
 
-  ofstream out(QString("%1-%2-%3.obj").arg(g_outFileName).arg(lodi).arg(framei).toStdString());
+  ofstream out(QString("%1-%2-%3.obj").arg(outFileName).arg(lodi).arg(framei).toStdString());
 
   QString vertexStr;
   QString faceStr;
@@ -573,12 +376,12 @@ void saveLodFrame(Model* m, unsigned int lodi, unsigned int framei)
   out.close();
 }
 
-void saveLodFrameAC(Model* m, unsigned int lodi, unsigned int framei)
+void saveLodFrameAC(Model* m, unsigned int lodi, unsigned int framei, const QString& outFileName)
 {
   LOD* l = m->lod(lodi);
   Frame* f = l->frame(framei);
 
-  ofstream out(QString("%1-%2-%3.ac").arg(g_outFileName).arg(lodi).arg(framei));
+  ofstream out(QString("%1-%2-%3.ac").arg(outFileName).arg(lodi).arg(framei));
 
   // AC3D header
   out << "AC3Db" << endl;
@@ -644,175 +447,6 @@ void saveLodFrameAC(Model* m, unsigned int lodi, unsigned int framei)
   out.close();
 }
 
-bool doModelProcessing(Model* m)
-{
-  if(!g_tex_dontLoad)
-  {
-    // Load textures
-    m->loadTextures();
-  }
-  else
-  {
-    boDebug() << "not loading textures due to request." << endl;
-  }
-
-  if(g_tex_convertToLowerCase)
-  {
-    // Convert texture names to lowercase
-    QHashIterator<QString, Texture> it(*m->texturesDict());
-    while(it.current())
-    {
-      it.current()->setFilename(it.current()->filename().toLower());
-      ++it;
-    }
-  }
-  boDebug() << "LOD 0 had " << m->baseLOD()->shortStats() << endl;
-
-  Processor::setBaseFrame(g_frame_base);
-
-  if(!m->checkLoadedModel())
-  {
-    boError() << k_funcinfo << "cannot process broken model" << endl;
-    return false;
-  }
-
-  QVector<Processor*> processorList;
-
-  processorList.append(new DefaultMaterials);
-  processorList.append(new UnusedDataRemover);
-  if(!g_frames_keepAll || g_frames_keepCount > 0)
-  {
-    FrameOptimizer* frameOptimizer = new FrameOptimizer();
-    frameOptimizer->setName("DuplicateFrameRemover");
-    frameOptimizer->setKeepFramesCount(g_frames_keepCount);
-    processorList.append(frameOptimizer);
-  }
-
-  Transformer* transformer = new Transformer();
-  transformer->setModelSize(g_modelSize);
-  transformer->setCenterModel(g_model_center);
-  processorList.append(transformer);
-  transformer = 0;
-
-  if(g_tex_optimize)
-  {
-    TextureOptimizer* textureOptimizer = new TextureOptimizer();
-    textureOptimizer->setCombinedTexSize(g_tex_size);
-    textureOptimizer->setCombinedTexFilename(g_tex_name);
-    textureOptimizer->setCombinedTexPath(g_tex_path);
-    processorList.append(textureOptimizer);
-  }
-
-  processorList.append(new NodeOptimizer());
-
-  if(g_usenormalcalculator)
-  {
-    processorList.append(new NormalCalculator(g_normalcalculator_threshold));
-  }
-  MaterialOptimizer* materialOptimizer = new MaterialOptimizer();
-  materialOptimizer->setResetMaterials(g_materials_reset);
-  processorList.append(materialOptimizer);
-  if(g_meshes_merge)
-  {
-    processorList.append(new MeshOptimizer());
-  }
-  processorList.append(new VertexOptimizer());
-
-
-  if(!executeProcessors(m, processorList))
-  {
-    return false;
-  }
-  qDeleteAll(processorList);
-  processorList.clear();
-
-
-  if(!g_usenormalcalculator)
-  {
-    boDebug() << "Calculating model's face normals..." << endl;
-    m->calculateFaceNormals();
-
-    boDebug() << "Calculating model's vertex normals..." << endl;
-    m->calculateVertexNormals();
-  }
-
-  boDebug() << "Creating lods..." << endl;
-  m->createLODs(g_numLods);
-
-  if(!m->checkLoadedModel())
-  {
-    boError() << k_funcinfo << "broken model after initial LOD creation" << endl;
-    return false;
-  }
-
-  float targetFactor = 1.0f;
-  float lodError = g_lod_baseError;
-  for(unsigned int i = 1; i < g_numLods; i++)
-  {
-    targetFactor *= g_lod_factor;
-    LodCreator* lodCreator = new LodCreator(i);
-    lodCreator->setFaceTargetFactor(targetFactor);
-    lodCreator->setMaxError(lodError);
-    lodCreator->setUseError(g_lod_useError);
-    lodCreator->setUseBoth(g_lod_useBoth);
-    processorList.append(lodCreator);
-
-    lodError *= g_lod_errorMod;
-  }
-
-
-
-  if(!executeProcessors(m, processorList))
-  {
-    return false;
-  }
-  processorList.setAutoDelete(true);
-  processorList.clear();
-
-  return true;
-}
-
-
-bool executeProcessors(Model* model, const QList<Processor*>& list)
-{
-  if(!model)
-  {
-    BO_NULL_ERROR(model);
-    return false;
-  }
-  if(!model->checkLoadedModel())
-  {
-    boError() << k_funcinfo << "cannot process broken model" << endl;
-    return false;
-  }
-  for(QPtrListIterator<Processor> it(list); it.current(); ++it)
-  {
-    QString name = it.current()->name();
-    if(name.isEmpty())
-    {
-      name = "Unnamed";
-    }
-    boDebug() << k_funcinfo << "starting " << name << endl;
-    if(!it.current()->initProcessor(model))
-    {
-      boError() << k_funcinfo << "initializing of processor " << name << " failed" << endl;
-      return false;
-    }
-    if(!it.current()->process())
-    {
-      boError() << k_funcinfo << "processor " << name << " failed" << endl;
-      return false;
-    }
-    if(!model->checkLoadedModel())
-    {
-      boError() << k_funcinfo << "model broken after executing processor " << name << ". Fix that processor!" << endl;
-      return false;
-    }
-    boDebug() << k_funcinfo << name << " succeeded" << endl;
-  }
-  return true;
-}
-
 /*
  * vim: et sw=2
  */
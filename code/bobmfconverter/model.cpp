@@ -156,9 +156,10 @@ bool Model::checkLoadedModel() const
   return true;
 }
 
-bool Model::save(const QString& file)
+bool Model::save(const QString& file, unsigned int versionCode)
 {
   Saver s(this, file);
+  s.setVersionCode(versionCode);
   return s.save();
 }
 
@@ -39,7 +39,11 @@ class Model
 
     bool load(const QString& file);
 
-    bool save(const QString& file);
+    /**
+     * Save the model to @p file using the BMF version @p versionCode, see
+     * @ref Saver::setVersionCode.
+     **/
+    bool save(const QString& file, unsigned int versionCode);
 
     /**
      * Prepare model for saving.
@@ -24,7 +24,7 @@
 #include "debug.h"
 
 
-unsigned int Processor::mBaseFrame = 0;
+thread_local unsigned int Processor::mBaseFrame = 0;
 
 
 Processor::Processor()
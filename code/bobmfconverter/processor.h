@@ -53,6 +53,11 @@ class Processor
     Model* model() const  { return mModel; }
     LOD* lod() const  { return mLOD; }
 
+    /**
+     * Set the frame that the processors use as reference. Note that this
+     * is stored per thread, so that several models can be converted at the
+     * same time, see @ref Converter.
+     **/
     static void setBaseFrame(unsigned int frame)  { mBaseFrame = frame; }
     static unsigned int baseFrame()  { return mBaseFrame; }
 
@@ -63,7 +68,7 @@ class Processor
     QString mName;
     Model* mModel;
     LOD* mLOD;
-    static unsigned int mBaseFrame;
+    static thread_local unsigned int mBaseFrame;
 };
 
 
@@ -29,11 +29,62 @@
 #include <mixkit/MxStdModel.h>
 #include <mixkit/MxQSlim.h>
 
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+
+
+/**
+ * Simplifies meshes for @ref LodCreator::processParallel. Every thread takes
+ * the next mesh that has not been processed yet, until all meshes are done.
+ **/
+class LodCreatorThread : public QThread
+{
+  public:
+    LodCreatorThread(const QVector<LodCreator*>* creators, const QVector<Mesh*>* meshes,
+        QVector<bool>* results, int* next, QMutex* mutex)
+    {
+      mCreators = creators;
+      mMeshes = meshes;
+      mResults = results;
+      mNext = next;
+      mMutex = mutex;
+    }
+
+    static bool processMesh(LodCreator* creator, Mesh* mesh)
+    {
+      return creator->processMesh(mesh);
+    }
+
+  protected:
+    virtual void run()
+    {
+      while(true)
+      {
+        mMutex->lock();
+        int index = *mNext;
+        (*mNext)++;
+        mMutex->unlock();
+        if(index >= mMeshes->count())
+        {
+          return;
+        }
+        (*mResults)[index] = processMesh((*mCreators)[index], (*mMeshes)[index]);
+      }
+    }
+
+  private:
+    const QVector<LodCreator*>* mCreators;
+    const QVector<Mesh*>* mMeshes;
+    QVector<bool>* mResults;
+    int* mNext;
+    QMutex* mMutex;
+};
+
 
 LodCreator::LodCreator(int lodIndex) : Processor()
 {
   mLODIndex = lodIndex;
-  mMxModel = 0;
   mTargetFactor = -1;
   mMaxError = -1;
   mUseError = false;
@@ -71,6 +122,92 @@ bool LodCreator::initProcessor(Model* model)
 }
 
 bool LodCreator::process()
+{
+  if(!checkSettings())
+  {
+    return false;
+  }
+
+  for(unsigned int i = 0; i < lod()->meshCount(); i++)
+  {
+    if(!processMesh(lod()->mesh(i)))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool LodCreator::processParallel(const QList<LodCreator*>& creators, unsigned int threadCount)
+{
+  // Collect all meshes of all LODs. The meshes of a LOD are copies of the
+  //  base LOD meshes (see Model::createLODs()), so they are independent.
+  QVector<LodCreator*> taskCreators;
+  QVector<Mesh*> taskMeshes;
+  for(int i = 0; i < creators.count(); i++)
+  {
+    LodCreator* creator = creators[i];
+    if(!creator->checkSettings())
+    {
+      boError() << k_funcinfo << "invalid settings for " << creator->name() << endl;
+      return false;
+    }
+    for(unsigned int j = 0; j < creator->lod()->meshCount(); j++)
+    {
+      taskCreators.append(creator);
+      taskMeshes.append(creator->lod()->mesh(j));
+    }
+  }
+  if(taskMeshes.isEmpty())
+  {
+    return true;
+  }
+
+  threadCount = qMax(1, qMin((int)threadCount, taskMeshes.count()));
+  boDebug() << k_funcinfo << "Simplifying " << taskMeshes.count() << " meshes in " <<
+      creators.count() << " LODs using " << threadCount << " threads" << endl;
+
+  QVector<bool> results(taskMeshes.count(), false);
+  int next = 0;
+  QMutex mutex;
+  if(threadCount == 1)
+  {
+    for(int i = 0; i < taskMeshes.count(); i++)
+    {
+      results[i] = LodCreatorThread::processMesh(taskCreators[i], taskMeshes[i]);
+    }
+  }
+  else
+  {
+    QList<LodCreatorThread*> threads;
+    for(unsigned int i = 0; i < threadCount; i++)
+    {
+      LodCreatorThread* thread = new LodCreatorThread(&taskCreators, &taskMeshes, &results, &next, &mutex);
+      threads.append(thread);
+      thread->start();
+    }
+    for(int i = 0; i < threads.count(); i++)
+    {
+      threads[i]->wait();
+    }
+    qDeleteAll(threads);
+  }
+
+  bool ret = true;
+  for(int i = 0; i < results.count(); i++)
+  {
+    if(!results[i])
+    {
+      boError() << k_funcinfo << "Simplifying mesh '" << taskMeshes[i]->name() << "' for " <<
+          taskCreators[i]->name() << " failed" << endl;
+      ret = false;
+    }
+  }
+  return ret;
+}
+
+bool LodCreator::checkSettings() const
 {
   if(lod() == 0)
   {
@@ -93,29 +230,24 @@ bool LodCreator::process()
       return false;
     }
   }
-
-  for(unsigned int i = 0; i < lod()->meshCount(); i++)
-  {
-    if(!processMesh(lod()->mesh(i)))
-    {
-      return false;
-    }
-  }
-
   return true;
 }
 
 bool LodCreator::processMesh(Mesh* mesh)
 {
-  // Load the mesh into MxStdModel
-  mMxModel = loadMeshIntoMxModel(mesh);
-  if(!mMxModel)
+  // Load the mesh into MxStdModel. Note that this method may be called by
+  //  several threads at once (see processParallel()), so all mixkit objects
+  //  must be local. The only globals that mixkit uses here are the message
+  //  settings in mixmsg.cxx, which must not be changed (e.g. using
+  //  mxmsg_indent()) while the threads are running.
+  MxStdModel* mxModel = loadMeshIntoMxModel(mesh);
+  if(!mxModel)
   {
     return false;
   }
 
   // Init slimming process
-  MxQSlim* slim = initSlim(mMxModel);
+  MxQSlim* slim = initSlim(mxModel);
 
   // Decimate
   /*float maxerror = 0.0;
@@ -139,21 +271,19 @@ bool LodCreator::processMesh(Mesh* mesh)
     slim->decimate(MAX(facetarget, 4));
   }
 
-  cleanupModel(mMxModel);
+  cleanupModel(mxModel);
 
   // Put MxStdModel data back to the mesh
-  if(!updateMeshFromMxModel(mesh, mMxModel))
+  if(!updateMeshFromMxModel(mesh, mxModel))
   {
-    delete mMxModel;
-    mMxModel = 0;
     delete slim;
+    delete mxModel;
     return false;
   }
 
   // Delete data structures
-  delete mMxModel;
-  mMxModel = 0;
   delete slim;
+  delete mxModel;
 
   return true;
 }
@@ -23,6 +23,8 @@
 
 #include "processor.h"
 
+#include <QList>
+
 class Model;
 class Mesh;
 class MxStdModel;
@@ -38,6 +40,21 @@ class LodCreator : public Processor
     virtual bool initProcessor(Model* model);
     virtual bool process();
 
+    /**
+     * Simplify the meshes of all LODs of @p creators using @p threadCount
+     * threads. This is equivalent to calling @ref process of every
+     * creator, but the meshes are processed concurrently.
+     *
+     * Every mesh is simplified by a separate MxStdModel/MxQSlim instance,
+     * so the result does not depend on the number of threads. Note that
+     * mixkit keeps the settings of its messages (mixmsg.cxx) in globals.
+     * We never change them, so the threads only read them, but warnings of
+     * several threads may be printed interleaved.
+     *
+     * @ref initProcessor must have been called for all @p creators.
+     **/
+    static bool processParallel(const QList<LodCreator*>& creators, unsigned int threadCount);
+
     void setFaceTargetFactor(float factor)  { mTargetFactor = factor; }
     float faceTargetFactor() const  { return mTargetFactor; }
 
@@ -52,6 +69,9 @@ class LodCreator : public Processor
 
 
   protected:
+    friend class LodCreatorThread;
+
+    bool checkSettings() const;
     bool processMesh(Mesh* mesh);
 
     MxStdModel* loadMeshIntoMxModel(Mesh* mesh);
@@ -62,7 +82,6 @@ class LodCreator : public Processor
 
   private:
     int mLODIndex;
-    MxStdModel* mMxModel;
     float mTargetFactor;
     float mMaxError;
     bool mUseError;
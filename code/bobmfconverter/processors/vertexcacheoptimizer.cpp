@@ -0,0 +1,388 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include "vertexcacheoptimizer.h"
+
+#include "debug.h"
+#include "model.h"
+#include "lod.h"
+#include "mesh.h"
+
+#include <math.h>
+
+
+// Parameters of the vertex scoring, see Forsyth's paper
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+/**
+ * @param cachePosition The position of the vertex in the (simulated LRU)
+ * cache or -1 if it is not in the cache.
+ * @param remaining The number of triangles of the vertex that have not been
+ * added yet.
+ **/
+static float vertexScore(int cachePosition, unsigned int remaining)
+{
+  if(remaining == 0)
+  {
+    // No triangle needs this vertex anymore
+    return -1.0f;
+  }
+
+  float score = 0.0f;
+  if(cachePosition >= 0)
+  {
+    if(cachePosition < 3)
+    {
+      // The vertex was used by the last triangle. Give it a fixed score, so
+      //  that it doesn't matter which of the three vertices is used next.
+      score = FORSYTH_LAST_TRIANGLE_SCORE;
+    }
+    else
+    {
+      const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+      score = powf(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+    }
+  }
+
+  // Prefer vertices with few remaining triangles, so that no lone triangles
+  //  are left behind
+  score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remaining, -FORSYTH_VALENCE_BOOST_POWER);
+  return score;
+}
+
+
+VertexCacheOptimizer::VertexCacheOptimizer(int lodIndex) : Processor()
+{
+  setName("VertexCacheOptimizer");
+  mLODIndex = lodIndex;
+  mCacheSize = 16;
+}
+
+VertexCacheOptimizer::~VertexCacheOptimizer()
+{
+}
+
+bool VertexCacheOptimizer::initProcessor(Model* model)
+{
+  if(!Processor::initProcessor(model))
+  {
+    return false;
+  }
+  if(mLODIndex < 0)
+  {
+    return false;
+  }
+  if((unsigned int)mLODIndex >= model->lodCount())
+  {
+    boError() << k_funcinfo << "LOD index out of bounds: " << mLODIndex << " >= " << model->lodCount() << endl;
+    return false;
+  }
+  LOD* lod = model->lod(mLODIndex);
+  if(!lod)
+  {
+    BO_NULL_ERROR(lod);
+    return false;
+  }
+  setLOD(lod);
+  return true;
+}
+
+bool VertexCacheOptimizer::process()
+{
+  if(lod() == 0)
+  {
+    boError() << k_funcinfo << "NULL LOD!" << endl;
+    return false;
+  }
+
+  for(unsigned int i = 0; i < lod()->meshCount(); i++)
+  {
+    if(!processMesh(lod()->mesh(i)))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool VertexCacheOptimizer::processMesh(Mesh* mesh)
+{
+  if(mesh->faceCount() == 0)
+  {
+    return true;
+  }
+
+  // Create the index array of the mesh
+  for(unsigned int i = 0; i < mesh->vertexCount(); i++)
+  {
+    mesh->vertex(i)->id = i;
+  }
+  QVector<unsigned int> indices(mesh->faceCount() * 3);
+  for(unsigned int i = 0; i < mesh->faceCount(); i++)
+  {
+    Face* f = mesh->face(i);
+    if(f->vertexCount() != 3)
+    {
+      boWarning() << k_funcinfo << "Mesh '" << mesh->name() << "' has face with " <<
+          f->vertexCount() << " vertices, not optimizing it" << endl;
+      return true;
+    }
+    for(unsigned int j = 0; j < 3; j++)
+    {
+      indices[i * 3 + j] = f->vertex(j)->id;
+    }
+  }
+
+  QVector<unsigned int> order = optimizeTriangleOrder(indices, mesh->vertexCount());
+  if(order.count() != (int)mesh->faceCount())
+  {
+    boError() << k_funcinfo << "invalid triangle order for mesh '" << mesh->name() << "'" << endl;
+    return false;
+  }
+
+  // Number the vertices in the order they are used by the reordered
+  //  triangles. Vertices that are not used at all are moved to the end.
+  QVector<int> newVertexIndex(mesh->vertexCount(), -1);
+  QVector<unsigned int> newIndices(indices.count());
+  unsigned int nextVertex = 0;
+  for(int i = 0; i < order.count(); i++)
+  {
+    for(unsigned int j = 0; j < 3; j++)
+    {
+      unsigned int v = indices[order[i] * 3 + j];
+      if(newVertexIndex[v] < 0)
+      {
+        newVertexIndex[v] = nextVertex;
+        nextVertex++;
+      }
+      newIndices[i * 3 + j] = newVertexIndex[v];
+    }
+  }
+  for(unsigned int i = 0; i < mesh->vertexCount(); i++)
+  {
+    if(newVertexIndex[i] < 0)
+    {
+      newVertexIndex[i] = nextVertex;
+      nextVertex++;
+    }
+  }
+
+  float acmrBefore = calculateACMR(indices, mesh->vertexCount(), cacheSize());
+  float acmrAfter = calculateACMR(newIndices, mesh->vertexCount(), cacheSize());
+  boDebug() << k_funcinfo << "Mesh '" << mesh->name() << "' (" << mesh->faceCount() << " faces, " <<
+      mesh->vertexCount() << " vertices): ACMR " << acmrBefore << " -> " << acmrAfter << endl;
+  if(acmrAfter >= acmrBefore)
+  {
+    boDebug() << k_funcinfo << "Keeping original order of mesh '" << mesh->name() << "'" << endl;
+    return true;
+  }
+
+  // Apply the new orders. Note that the Face and Vertex objects themselves
+  //  are not modified (except for the vertex ids).
+  Face** newfaces = new Face*[mesh->faceCount()];
+  for(int i = 0; i < order.count(); i++)
+  {
+    newfaces[i] = mesh->face(order[i]);
+  }
+  mesh->replaceFaceList(newfaces, mesh->faceCount());
+
+  Vertex** newvertices = new Vertex*[mesh->vertexCount()];
+  for(unsigned int i = 0; i < mesh->vertexCount(); i++)
+  {
+    Vertex* v = mesh->vertex(i);
+    v->id = newVertexIndex[i];
+    newvertices[v->id] = v;
+  }
+  mesh->replaceVertexList(newvertices, mesh->vertexCount());
+
+  return true;
+}
+
+QVector<unsigned int> VertexCacheOptimizer::optimizeTriangleOrder(const QVector<unsigned int>& indices, unsigned int vertexCount) const
+{
+  const unsigned int triangleCount = indices.count() / 3;
+
+  // The triangles of every vertex. adjacency[adjacencyOffset[v]] to
+  //  adjacency[adjacencyOffset[v] + remaining[v] - 1] are the triangles of
+  //  vertex v that have not been added yet.
+  QVector<unsigned int> remaining(vertexCount, 0);
+  for(int i = 0; i < indices.count(); i++)
+  {
+    remaining[indices[i]]++;
+  }
+  QVector<unsigned int> adjacencyOffset(vertexCount, 0);
+  unsigned int offset = 0;
+  for(unsigned int v = 0; v < vertexCount; v++)
+  {
+    adjacencyOffset[v] = offset;
+    offset += remaining[v];
+  }
+  QVector<unsigned int> adjacency(indices.count());
+  QVector<unsigned int> adjacencyCount(vertexCount, 0);
+  for(int i = 0; i < indices.count(); i++)
+  {
+    unsigned int v = indices[i];
+    adjacency[adjacencyOffset[v] + adjacencyCount[v]] = i / 3;
+    adjacencyCount[v]++;
+  }
+
+  QVector<int> cachePosition(vertexCount, -1);
+  QVector<float> score(vertexCount);
+  for(unsigned int v = 0; v < vertexCount; v++)
+  {
+    score[v] = vertexScore(-1, remaining[v]);
+  }
+
+  QVector<bool> added(triangleCount, false);
+  QVector<float> triangleScore(triangleCount);
+  int bestTriangle = -1;
+  float bestScore = -1.0f;
+  for(unsigned int t = 0; t < triangleCount; t++)
+  {
+    triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    if(triangleScore[t] > bestScore)
+    {
+      bestScore = triangleScore[t];
+      bestTriangle = t;
+    }
+  }
+
+  // The simulated LRU cache, most recently used vertex first. It may contain
+  //  up to 3 additional entries while it is updated.
+  QVector<unsigned int> cache;
+  cache.reserve(FORSYTH_CACHE_SIZE + 3);
+  QVector<unsigned int> newCache;
+  newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+  QVector<unsigned int> order;
+  order.reserve(triangleCount);
+  unsigned int nextUnadded = 0;
+  while((unsigned int)order.count() < triangleCount)
+  {
+    if(bestTriangle < 0)
+    {
+      // None of the cached vertices has remaining triangles. Continue with
+      //  the next triangle in the original order, as searching for the
+      //  triangle with the best score would be quadratic.
+      while(added[nextUnadded])
+      {
+        nextUnadded++;
+      }
+      bestTriangle = nextUnadded;
+    }
+
+    const unsigned int t = bestTriangle;
+    added[t] = true;
+    order.append(t);
+
+    // Remove the triangle from the remaining triangles of its vertices and
+    //  move the vertices to the front of the cache
+    newCache.clear();
+    for(unsigned int j = 0; j < 3; j++)
+    {
+      unsigned int v = indices[t * 3 + j];
+      unsigned int* tris = adjacency.data() + adjacencyOffset[v];
+      for(unsigned int k = 0; k < remaining[v]; k++)
+      {
+        if(tris[k] == t)
+        {
+          tris[k] = tris[remaining[v] - 1];
+          remaining[v]--;
+          break;
+        }
+      }
+      if(!newCache.contains(v))
+      {
+        newCache.append(v);
+      }
+    }
+    for(int i = 0; i < cache.count(); i++)
+    {
+      if(!newCache.contains(cache[i]))
+      {
+        newCache.append(cache[i]);
+      }
+    }
+
+    // Update the scores of all vertices that are (or were) in the cache and
+    //  find the best triangle of those vertices
+    for(int i = 0; i < newCache.count(); i++)
+    {
+      unsigned int v = newCache[i];
+      cachePosition[v] = (i < FORSYTH_CACHE_SIZE) ? i : -1;
+      score[v] = vertexScore(cachePosition[v], remaining[v]);
+    }
+    bestTriangle = -1;
+    bestScore = -1.0f;
+    for(int i = 0; i < newCache.count(); i++)
+    {
+      unsigned int v = newCache[i];
+      const unsigned int* tris = adjacency.data() + adjacencyOffset[v];
+      for(unsigned int k = 0; k < remaining[v]; k++)
+      {
+        unsigned int tri = tris[k];
+        triangleScore[tri] = score[indices[tri * 3]] + score[indices[tri * 3 + 1]] + score[indices[tri * 3 + 2]];
+        if(triangleScore[tri] > bestScore)
+        {
+          bestScore = triangleScore[tri];
+          bestTriangle = tri;
+        }
+      }
+    }
+
+    if(newCache.count() > FORSYTH_CACHE_SIZE)
+    {
+      newCache.resize(FORSYTH_CACHE_SIZE);
+    }
+    cache = newCache;
+  }
+
+  return order;
+}
+
+float VertexCacheOptimizer::calculateACMR(const QVector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+  if(indices.count() < 3)
+  {
+    return 0.0f;
+  }
+
+  // A vertex is in the FIFO cache if it was one of the last cacheSize
+  //  vertices that were transformed. missTime[v] is the number of misses
+  //  before v was transformed the last time.
+  QVector<int> missTime(vertexCount, -1);
+  unsigned int misses = 0;
+  for(int i = 0; i < indices.count(); i++)
+  {
+    unsigned int v = indices[i];
+    if(missTime[v] < 0 || misses - (unsigned int)missTime[v] > cacheSize)
+    {
+      missTime[v] = misses;
+      misses++;
+    }
+  }
+  return (float)misses / (float)(indices.count() / 3);
+}
+
@@ -0,0 +1,91 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef VERTEXCACHEOPTIMIZER_H
+#define VERTEXCACHEOPTIMIZER_H
+
+
+#include "processor.h"
+
+#include <QVector>
+
+class Model;
+class Mesh;
+
+
+/**
+ * Reorders the faces of all meshes of a LOD so that consecutive faces share
+ * as many vertices as possible. The vertices are reordered in the order they
+ * are first used by the faces, which improves the locality of the vertex
+ * fetches, too.
+ *
+ * When the mesh is rendered using indices, the GPU can use transformed
+ * vertices from its post-transform cache instead of running the vertex
+ * shader again. The faces are ordered using the algorithm described by Tom
+ * Forsyth in "Linear-Speed Vertex Cache Optimisation", which does not depend
+ * on the actual size of the cache.
+ *
+ * The average cache miss ratio (ACMR, transformed vertices per face) is
+ * printed before and after optimizing every mesh, see @ref calculateACMR. The
+ * new order is used only if it is actually better.
+ **/
+class VertexCacheOptimizer : public Processor
+{
+  public:
+    VertexCacheOptimizer(int lodIndex = 0);
+    virtual ~VertexCacheOptimizer();
+
+    virtual bool initProcessor(Model* model);
+    virtual bool process();
+
+    /**
+     * Set the size of the FIFO cache that is simulated to calculate the
+     * ACMR. Default is 16 entries.
+     **/
+    void setCacheSize(unsigned int size)  { mCacheSize = size; }
+    unsigned int cacheSize() const  { return mCacheSize; }
+
+    /**
+     * @return The average number of vertices that need to be transformed
+     * per triangle when the triangles with the vertex indices @p indices
+     * (3 per triangle) are rendered using a FIFO vertex cache with @p
+     * cacheSize entries. 3.0 is the worst case, 0.5 is about the best case
+     * for a regular grid.
+     **/
+    static float calculateACMR(const QVector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize);
+
+
+  protected:
+    bool processMesh(Mesh* mesh);
+
+    /**
+     * @return The new order of the triangles with the vertex indices @p
+     * indices, i.e. the index of the triangle that should be rendered
+     * first, second, ...
+     **/
+    QVector<unsigned int> optimizeTriangleOrder(const QVector<unsigned int>& indices, unsigned int vertexCount) const;
+
+
+  private:
+    int mLODIndex;
+    unsigned int mCacheSize;
+};
+
+
+#endif //VERTEXCACHEOPTIMIZER_H
@@ -24,78 +24,69 @@
 #include "lod.h"
 #include "mesh.h"
 
-#include <qvaluelist.h>
-#include <qptrvector.h>
+#include <QMultiHash>
+#include <QVector>
 
+#include <math.h>
 
-class VertexOptimizer::VertexPtrVector : public QPtrVector<Vertex>
+
+/**
+ * A cell of the spatial hash that is used to find duplicate vertices.
+ **/
+class WeldKey
 {
   public:
-    VertexPtrVector(int size) : QPtrVector<Vertex>(size)  {}
-
+    WeldKey(int _x, int _y, int _z) : x(_x), y(_y), z(_z)  {}
 
-  protected:
-    virtual int compareItems(QPtrCollection::Item d1, QPtrCollection::Item d2)
+    bool operator==(const WeldKey& k) const
     {
-      return compareItems((Vertex*)d1, (Vertex*)d2);
+      return ((x == k.x) && (y == k.y) && (z == k.z));
     }
 
-    virtual int compareItems(Vertex* v1, Vertex* v2)
-    {
-      // Compare pos
-      float posxdiff = v2->pos.x() - v1->pos.x();
-      if(posxdiff != 0)
-      {
-        return ((posxdiff > 0) ? 1 : -1);
-      }
-      float posydiff = v2->pos.y() - v1->pos.y();
-      if(posydiff != 0)
-      {
-        return ((posydiff > 0) ? 1 : -1);
-      }
-      float poszdiff = v2->pos.z() - v1->pos.z();
-      if(poszdiff != 0)
-      {
-        return ((poszdiff > 0) ? 1 : -1);
-      }
+    int x;
+    int y;
+    int z;
+};
 
-      // Compare normal
-      float normalxdiff = v2->normal.x() - v1->normal.x();
-      if(normalxdiff != 0)
-      {
-        return ((normalxdiff > 0) ? 1 : -1);
-      }
-      float normalydiff = v2->normal.y() - v1->normal.y();
-      if(normalydiff != 0)
-      {
-        return ((normalydiff > 0) ? 1 : -1);
-      }
-      float normalzdiff = v2->normal.z() - v1->normal.z();
-      if(normalzdiff != 0)
-      {
-        return ((normalzdiff > 0) ? 1 : -1);
-      }
+inline uint qHash(const WeldKey& k)
+{
+  return ((uint)k.x * 73856093u) ^ ((uint)k.y * 19349663u) ^ ((uint)k.z * 83492791u);
+}
 
-      // Compare tex
-      float texxdiff = v2->tex.x() - v1->tex.x();
-      if(texxdiff != 0)
-      {
-        return ((texxdiff > 0) ? 1 : -1);
-      }
-      float texydiff = v2->tex.y() - v1->tex.y();
-      if(texydiff != 0)
-      {
-        return ((texydiff > 0) ? 1 : -1);
-      }
+static bool isDuplicate(Vertex* v1, Vertex* v2, float epsilon)
+{
+  if(!v1->pos.isEqual(v2->pos, epsilon) || !(v1->tex == v2->tex))
+  {
+    return false;
+  }
+  // For vertices to be duplicates, all their faces must share a smoothing
+  //  group, too (otherwise the normals will be different)
+  return (v1->smoothgroup & v2->smoothgroup);
+}
 
-      return 0;
+/**
+ * @return The index of a vertex in @p cell of @p cells that is a duplicate of
+ * @p v, or -1 if there is none.
+ **/
+static int findDuplicate(Mesh* mesh, const QMultiHash<WeldKey, unsigned int>& cells, const WeldKey& cell, Vertex* v, float epsilon)
+{
+  QMultiHash<WeldKey, unsigned int>::const_iterator it = cells.find(cell);
+  while(it != cells.end() && it.key() == cell)
+  {
+    if(isDuplicate(mesh->vertex(it.value()), v, epsilon))
+    {
+      return it.value();
     }
-};
+    ++it;
+  }
+  return -1;
+}
 
 
-VertexOptimizer::VertexOptimizer() : Processor()
+VertexOptimizer::VertexOptimizer(float weldEpsilon) : Processor()
 {
   setName("VertexOptimizer");
+  mWeldEpsilon = weldEpsilon;
 }
 
 VertexOptimizer::~VertexOptimizer()
@@ -123,166 +114,109 @@ bool VertexOptimizer::process()
 
 bool VertexOptimizer::processMesh(Mesh* mesh)
 {
-  unsigned int validcount = 0;
-  unsigned int removedcount = 0;
-
-  QValueList<unsigned int> removed;
+  const unsigned int count = mesh->vertexCount();
+  if(count == 0)
+  {
+    return true;
+  }
 
-  // Create temporary sorted list of vertices.
-  // This speeds up duplicates search process a _lot_
-  VertexPtrVector vertices(mesh->vertexCount());
-  for(unsigned int i = 0; i < mesh->vertexCount(); i++)
+  // Vertices that are at most epsilon apart are in the same or in adjacent
+  //  cells. With an epsilon of 0 duplicates are always in the same cell.
+  float cellsize = mWeldEpsilon;
+  int range = 1;
+  if(cellsize <= 0.0f)
   {
-    vertices.insert(i, mesh->vertex(i));
+    cellsize = 0.001f;
+    range = 0;
   }
-  boDebug() << "    VO::processMesh(): " << "Vertices added to list, sorting list..." << endl;
-  vertices.sort();
-  boDebug() << "    VO::processMesh(): " << "List sorted, checking for dups..." << endl;
 
-  for(unsigned int i = 0; i < vertices.count(); i++)
+  QMultiHash<WeldKey, unsigned int> cells;
+  cells.reserve(count);
+
+  // replacement[i] is the index of the vertex that replaces vertex i (i
+  //  itself if the vertex is kept)
+  QVector<unsigned int> replacement(count);
+  unsigned int validcount = 0;
+  for(unsigned int i = 0; i < count; i++)
   {
-    if(removed.contains(i))
-    {
-      // Vertex has already been removed
-      continue;
-    }
+    Vertex* v = mesh->vertex(i);
+    v->id = i;
+    WeldKey cell((int)floorf(v->pos.x() / cellsize),
+        (int)floorf(v->pos.y() / cellsize),
+        (int)floorf(v->pos.z() / cellsize));
 
-    // This vertex isn't removed yet
-    // Check if it has duplicates
-    Vertex* v = vertices[i];
-    validcount++;
-    /*boDebug() << "  VO::processMesh(): " << "Processing vertex " << i << ": id: " << v->id <<
-        "; pos: (" << v->pos.x() << "; " << v->pos.y() << "; " << v->pos.z() <<
-        "); normal: (" << v->normal.x() << "; " << v->normal.y() << "; " << v->normal.z() <<
-        "); tex: (" << v->tex.x() << "; " << v->tex.y() << ")" << endl;*/
-    // Search for duplicates
-    // Note that duplicates are always _after each other_ in the list
-    while((i < vertices.count() - 1) && v->isDuplicate(vertices[i+1]))
+    int duplicate = -1;
+    for(int dx = -range; dx <= range && duplicate < 0; dx++)
     {
-      // Duplicate found
-      replaceVertex(mesh, vertices[i+1], v);
-      removed.append(i+1);
-      removedcount++;
-      i++;
-      if(i >= (vertices.count() - 1))
+      for(int dy = -range; dy <= range && duplicate < 0; dy++)
       {
-        break;
+        for(int dz = -range; dz <= range && duplicate < 0; dz++)
+        {
+          WeldKey neighbor(cell.x + dx, cell.y + dy, cell.z + dz);
+          duplicate = findDuplicate(mesh, cells, neighbor, v, mWeldEpsilon);
+        }
       }
     }
-  }
 
-  if((validcount + removedcount) != vertices.count())
-  {
-    boError() << k_funcinfo << "Counts differ: " << validcount << " + " << removedcount <<
-        " != " << vertices.count() << endl;
-    return false;
+    if(duplicate >= 0)
+    {
+      replacement[i] = duplicate;
+    }
+    else
+    {
+      replacement[i] = i;
+      cells.insert(cell, i);
+      validcount++;
+    }
   }
-  boDebug() << k_funcinfo << "Vertices removed: " << removedcount << " of " << mesh->vertexCount() << endl;
+
+  unsigned int removedcount = count - validcount;
+  boDebug() << k_funcinfo << "Vertices removed: " << removedcount << " of " << count << endl;
 
   if(removedcount == 0)
   {
     return true;
   }
 
-  // Create new vertex list for the mesh
-  Vertex** newvertices = new Vertex*[validcount];
-
-  // Copy valid vertices to the new list and update their id, delete other
-  //  (invalid) vertices
-  int newpos = 0;
-  QValueList<unsigned int>::Iterator it = removed.begin();
-  for(unsigned int i = 0; i < vertices.count(); i++)
+  // Replace the duplicates in all faces
+  for(unsigned int i = 0; i < mesh->faceCount(); i++)
   {
-    Vertex* v = vertices[i];
-    // Check if removed list contains this vertex id
-    bool vertexisremoved = false;
-    while((it != removed.end()) && (*it <= i))
+    Face* f = mesh->face(i);
+    for(unsigned int j = 0; j < f->vertexCount(); j++)
     {
-      if(*it == i)
+      Vertex* v = f->vertex(j);
+      unsigned int with = replacement[v->id];
+      if(with != (unsigned int)v->id)
       {
-        vertexisremoved = true;
+        f->setVertex(j, mesh->vertex(with));
+        mesh->vertex(with)->faces.append(f);
       }
-      ++it;
     }
+  }
 
-    if(vertexisremoved)
+  // Copy valid vertices to the new list and update their id, delete other
+  //  (invalid) vertices
+  Vertex** newvertices = new Vertex*[validcount];
+  unsigned int newpos = 0;
+  for(unsigned int i = 0; i < count; i++)
+  {
+    Vertex* v = mesh->vertex(i);
+    if(replacement[i] != i)
     {
       delete v;
     }
     else
     {
-      // This vertex is valid. Copy it to the new list and update it's id
       v->id = newpos;
       newvertices[newpos] = v;
       newpos++;
     }
   }
 
-  if(newpos != (int)validcount)
-  {
-    boError() << k_funcinfo << "Wrong number of vertices was copied! copied: " << newpos <<
-        "; should've: " << validcount << endl;
-  }
-
   mesh->replaceVertexList(newvertices, validcount);
 
   boDebug() << "    VO::processMesh(): " << "Vertex list replaced" << endl;
 
-#if 0
-  for(int i = 0; i < mesh->vertexCount(); i++)
-  {
-    if(removed.contains(i))
-    {
-      // Vertex has already been removed
-      continue;
-    }
-
-    // This vertex isn't removed yet
-    // Check if it has duplicates
-    Vertex* v = mesh->vertex(i);
-    /*boDebug() << "  VO::processMesh(): " << "Processing vertex " << i <<
-        ": pos: (" << v->pos.x() << "; " << v->pos.y() << "; " << v->pos.z() <<
-        "); normal: (" << v->normal.x() << "; " << v->normal.y() << "; " << v->normal.z() <<
-        "); tex: (" << v->tex.x() << "; " << v->tex.y() << ")" << endl;*/
-    QValueList<int> duplicates;
-    for(int j = i + 1; j < mesh->vertexCount(); j++)
-    {
-      if(*v == *mesh->vertex(j))
-      {
-        // Vertices at i and j are equal: j will be removed
-        //boDebug() << "    VO::processMesh(): " << "Found duplicate vertex " << j << " for " << i << endl;
-        duplicates.append(j);
-      }
-    }
-    if(!duplicates.isEmpty())
-    {
-      // Replace all duplicates with this vertex
-      for(QValueList<int>::Iterator it = duplicates.begin(); it != duplicates.end(); ++it)
-      {
-        replaceVertex(mesh, mesh->vertex(*it), v);
-        removed.append(*it);
-        removedcount++;
-      }
-    }
-    validcount++;
-  }
-#endif
-
   return true;
 }
 
-void VertexOptimizer::replaceVertex(Mesh* mesh, Vertex* replace, Vertex* with)
-{
-  for(unsigned int i = 0; i < replace->faces.count(); i++)
-  {
-    Face* f = replace->faces[i];
-    for(unsigned int j = 0; j < f->vertexCount(); j++)
-    {
-      if(f->vertex(j) == replace)
-      {
-        f->setVertex(j, with);
-        with->faces.append(f);
-      }
-    }
-  }
-}
@@ -26,25 +26,39 @@
 class Model;
 class LOD;
 class Mesh;
-class Vertex;
 
 
+/**
+ * Welds duplicate vertices of all meshes of the base LOD, i.e. vertices with
+ * (almost) the same position, the same texture coordinates and a common
+ * smoothing group are replaced by a single vertex.
+ *
+ * Candidates are found using a spatial hash of the vertex positions, so a mesh
+ * is processed in linear time.
+ **/
 class VertexOptimizer : public Processor
 {
   public:
-    VertexOptimizer();
+    VertexOptimizer(float weldEpsilon = 0.001);
     virtual ~VertexOptimizer();
 
     virtual bool process();
 
+    /**
+     * Vertices are welded if their positions differ by at most @p epsilon
+     * in every component. Texture coordinates still need to be equal (see
+     * @ref BoVector2::isEqual).
+     **/
+    void setWeldEpsilon(float epsilon)  { mWeldEpsilon = epsilon; }
+    float weldEpsilon() const  { return mWeldEpsilon; }
+
 
   protected:
     bool processMesh(Mesh* mesh);
-    void replaceVertex(Mesh* mesh, Vertex* replace, Vertex* with);
 
 
   private:
-    class VertexPtrVector;
+    float mWeldEpsilon;
 };
 
 
@@ -38,11 +38,17 @@ Saver::Saver(Model* m, const QString& filename)
 {
   mModel = m;
   mFilename = filename;
+  mVersionCode = BMF_VERSION_CODE;
 }
 
 bool Saver::save()
 {
   boDebug() << k_funcinfo << endl;
+  if(mVersionCode != BMF_VERSION_CODE_STREAMED_ARRAYS && mVersionCode != BMF_VERSION_CODE_MAPPED_ARRAYS)
+  {
+    boError() << k_funcinfo << "Unsupported BMF version 0x" << QString::number(mVersionCode, 16) << endl;
+    return false;
+  }
   // Open the file
   QFile f(mFilename);
   if(!f.open(IO_WriteOnly))
@@ -58,9 +64,17 @@ bool Saver::save()
 
   // Write header
   stream.writeRawBytes(BMF_FILE_ID, BMF_FILE_ID_LEN);
-  stream << (Q_UINT32)BMF_VERSION_CODE;
+  stream << (Q_UINT32)mVersionCode;
 
-  ret = saveModel(stream, mModel);
+  if(mVersionCode >= BMF_VERSION_CODE_MAPPED_ARRAYS)
+  {
+    ret = saveMappedArrays(stream, mModel);
+  }
+
+  if(ret)
+  {
+    ret = saveModel(stream, mModel);
+  }
 
   stream << (Q_UINT32)BMF_MAGIC_END;
 
@@ -89,39 +103,15 @@ bool Saver::saveModel(QDataStream& stream, Model* model)
   stream << model->maxCoord();
   stream << (Q_UINT32)BMF_MAGIC_MODEL_INFO_END;
 
-  // Vertex and index arrays
-  stream << (Q_UINT32)BMF_MAGIC_ARRAYS;
-  stream << (Q_UINT32)model->vertexArraySize();
-  stream << (Q_UINT32)model->indexArraySize();
-  stream << (Q_UINT32)model->indexArrayType();
-  // Arrays will be little-endian-encoded
-  stream.setByteOrder(QDataStream::LittleEndian);
-  // Vertex array
-  for(unsigned int i = 0; i < model->vertexArraySize(); i++)
-  {
-    for(unsigned int j = 0; j < 8; j++)
-    {
-      stream << model->vertexArray()[i*8 + j];
-    }
-  }
-  // Index array
-  if(model->indexArrayType() == BMF_DATATYPE_UNSIGNED_SHORT)
+  // Vertex and index arrays (newer versions store them at the beginning of
+  //  the file)
+  if(mVersionCode < BMF_VERSION_CODE_MAPPED_ARRAYS)
   {
-    Q_UINT16* indices = (Q_UINT16*)model->indexArray();
-    for(unsigned int i = 0; i < model->indexArraySize(); i++)
+    if(!saveArrays(stream, model))
     {
-      stream << indices[i];
-    }
-  }
-  else
-  {
-    Q_UINT32* indices = (Q_UINT32*)model->indexArray();
-    for(unsigned int i = 0; i < model->indexArraySize(); i++)
-    {
-      stream << indices[i];
+      return false;
     }
   }
-  stream.setByteOrder(QDataStream::BigEndian);
 
   // Textures
   stream << (Q_UINT32)BMF_MAGIC_TEXTURES;
@@ -162,6 +152,96 @@ bool Saver::saveModel(QDataStream& stream, Model* model)
   return true;
 }
 
+bool Saver::saveArrays(QDataStream& stream, Model* model)
+{
+  stream << (Q_UINT32)BMF_MAGIC_ARRAYS;
+  stream << (Q_UINT32)model->vertexArraySize();
+  stream << (Q_UINT32)model->indexArraySize();
+  stream << (Q_UINT32)model->indexArrayType();
+  // Arrays will be little-endian-encoded
+  stream.setByteOrder(QDataStream::LittleEndian);
+  writeVertexArray(stream, model);
+  writeIndexArray(stream, model);
+  stream.setByteOrder(QDataStream::BigEndian);
+
+  return true;
+}
+
+bool Saver::saveMappedArrays(QDataStream& stream, Model* model)
+{
+  unsigned int indexsize = sizeof(Q_UINT32);
+  if(model->indexArrayType() == BMF_DATATYPE_UNSIGNED_SHORT)
+  {
+    indexsize = sizeof(Q_UINT16);
+  }
+  // File id, version code, 4 values and 3 offsets
+  const unsigned int headersize = BMF_FILE_ID_LEN + 8 * sizeof(Q_UINT32);
+  const unsigned int align = BMF_ARRAY_ALIGNMENT;
+  unsigned int pointoffset = ((headersize + align - 1) / align) * align;
+  unsigned int pointsize = model->vertexArraySize() * 8 * sizeof(float);
+  unsigned int indexoffset = ((pointoffset + pointsize + align - 1) / align) * align;
+  unsigned int indexarraysize = model->indexArraySize() * indexsize;
+  unsigned int modeloffset = ((indexoffset + indexarraysize + align - 1) / align) * align;
+
+  stream << (Q_UINT32)BMF_MAGIC_ARRAYS;
+  stream << (Q_UINT32)model->vertexArraySize();
+  stream << (Q_UINT32)model->indexArraySize();
+  stream << (Q_UINT32)model->indexArrayType();
+  stream << (Q_UINT32)pointoffset;
+  stream << (Q_UINT32)indexoffset;
+  stream << (Q_UINT32)modeloffset;
+  writePadding(stream, pointoffset - headersize);
+
+  // Arrays will be little-endian-encoded
+  stream.setByteOrder(QDataStream::LittleEndian);
+  writeVertexArray(stream, model);
+  writePadding(stream, indexoffset - (pointoffset + pointsize));
+  writeIndexArray(stream, model);
+  writePadding(stream, modeloffset - (indexoffset + indexarraysize));
+  stream.setByteOrder(QDataStream::BigEndian);
+
+  return true;
+}
+
+void Saver::writeVertexArray(QDataStream& stream, Model* model)
+{
+  for(unsigned int i = 0; i < model->vertexArraySize(); i++)
+  {
+    for(unsigned int j = 0; j < 8; j++)
+    {
+      stream << model->vertexArray()[i*8 + j];
+    }
+  }
+}
+
+void Saver::writeIndexArray(QDataStream& stream, Model* model)
+{
+  if(model->indexArrayType() == BMF_DATATYPE_UNSIGNED_SHORT)
+  {
+    Q_UINT16* indices = (Q_UINT16*)model->indexArray();
+    for(unsigned int i = 0; i < model->indexArraySize(); i++)
+    {
+      stream << indices[i];
+    }
+  }
+  else
+  {
+    Q_UINT32* indices = (Q_UINT32*)model->indexArray();
+    for(unsigned int i = 0; i < model->indexArraySize(); i++)
+    {
+      stream << indices[i];
+    }
+  }
+}
+
+void Saver::writePadding(QDataStream& stream, unsigned int bytes)
+{
+  for(unsigned int i = 0; i < bytes; i++)
+  {
+    stream << (Q_UINT8)0;
+  }
+}
+
 bool Saver::saveTexture(QDataStream& stream, Texture* tex)
 {
   stream << tex->filename().latin1();
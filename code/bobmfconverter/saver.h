@@ -36,11 +36,24 @@ class Saver
   public:
     Saver(Model* m, const QString& filename);
 
+    /**
+     * Set the version of the file format that is written. Supported are
+     * BMF_VERSION_CODE_STREAMED_ARRAYS and BMF_VERSION_CODE_MAPPED_ARRAYS
+     * (the default), see bmf.h.
+     **/
+    void setVersionCode(unsigned int version)  { mVersionCode = version; }
+    unsigned int versionCode() const  { return mVersionCode; }
+
     bool save();
 
 
   private:
     bool saveModel(QDataStream& stream, Model* model);
+    bool saveArrays(QDataStream& stream, Model* model);
+    bool saveMappedArrays(QDataStream& stream, Model* model);
+    void writeVertexArray(QDataStream& stream, Model* model);
+    void writeIndexArray(QDataStream& stream, Model* model);
+    void writePadding(QDataStream& stream, unsigned int bytes);
     bool saveTexture(QDataStream& stream, Texture* tex);
     bool saveMaterial(QDataStream& stream, Material* mat);
     bool saveLOD(QDataStream& stream, LOD* lod);
@@ -49,6 +62,7 @@ class Saver
 
     QString mFilename;
     Model* mModel;
+    unsigned int mVersionCode;
 };
 
 #endif //SAVER_H
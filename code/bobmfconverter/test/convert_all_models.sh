@@ -62,14 +62,33 @@ for model in $MODELS; do
 	dir=`dirname $model`
 	config="$dir/index.unit"
 	unit=`basename $dir`
-	$CONVERTER $CONVERTER_PARAMS -o "$OUTPUT_DIR/$unit.bmf" -c "$config" "$model"
+	$CONVERTER $CONVERTER_PARAMS -lodthreads 4 -o "$OUTPUT_DIR/$unit.bmf" -c "$config" "$model"
 	exit_code=$?
-	rm -f "$OUTPUT_DIR/$unit.bmf"
+	if [ "$exit_code" -ne "0" ]; then
+		rm -f "$OUTPUT_DIR/$unit.bmf"
+		echo "bobmfconverter returned an error for model file $model"
+		exit_script 1
+	fi
+
+	# LODs are created in parallel above (the default number of threads
+	# may be 1, so it is set explicitly). The result must be exactly the
+	# same as with a single thread.
+	$CONVERTER $CONVERTER_PARAMS -lodthreads 1 -o "$OUTPUT_DIR/$unit.serial.bmf" -c "$config" "$model"
+	exit_code=$?
+	if [ "$exit_code" -eq "0" ]; then
+		cmp -s "$OUTPUT_DIR/$unit.bmf" "$OUTPUT_DIR/$unit.serial.bmf"
+		cmp_code=$?
+	fi
+	rm -f "$OUTPUT_DIR/$unit.bmf" "$OUTPUT_DIR/$unit.serial.bmf"
 
 	if [ "$exit_code" -ne "0" ]; then
 		echo "bobmfconverter returned an error for model file $model"
 		exit_script 1
 	fi
+	if [ "$cmp_code" -ne "0" ]; then
+		echo "Parallel and serial LOD creation differ for model file $model"
+		exit_script 1
+	fi
 done
 
 exit_script 0
@@ -0,0 +1,110 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "boimagecache.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "bodebug.h"
+
+#include <qstring.h>
+#include <qimage.h>
+#include <qgl.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qdeepcopy.h>
+
+/**
+ * @internal
+ **/
+class BoImageCacheData
+{
+public:
+	QMutex mMutex;
+	QMap<QString, QImage> mImages;
+	QMap<QString, QImage> mGLImages;
+};
+
+static BoImageCacheData* cacheData()
+{
+ static BoImageCacheData data;
+ return &data;
+}
+
+void BoImageCache::initStatic()
+{
+ // QImageIO registers the available formats (including the plugins) on the
+ // first use. this must not happen in a worker thread.
+ QImageIO::inputFormats();
+}
+
+bool BoImageCache::prefetchImage(const QString& file, bool glFormat)
+{
+ QImage image(file);
+ if (image.isNull()) {
+	return false;
+ }
+ if (glFormat) {
+	image = QGLWidget::convertToGLFormat(image);
+ }
+
+ BoImageCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ QMap<QString, QImage>& images = glFormat ? data->mGLImages : data->mImages;
+ images.insert(QDeepCopy<QString>(file), image);
+
+ // release our reference while we still hold the lock, so that the GUI
+ // thread is the only owner of the image once it takes it.
+ image = QImage();
+ return true;
+}
+
+bool BoImageCache::takeImage(const QString& file, bool glFormat, QImage* image)
+{
+ BO_CHECK_NULL_RET0(image);
+ BoImageCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ QMap<QString, QImage>& images = glFormat ? data->mGLImages : data->mImages;
+ QMap<QString, QImage>::iterator it = images.find(file);
+ if (it == images.end()) {
+	return false;
+ }
+ *image = it.data();
+ images.remove(it);
+ return true;
+}
+
+void BoImageCache::removeImage(const QString& file, bool glFormat)
+{
+ BoImageCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ if (glFormat) {
+	data->mGLImages.remove(file);
+ } else {
+	data->mImages.remove(file);
+ }
+}
+
+void BoImageCache::clear()
+{
+ BoImageCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ data->mImages.clear();
+ data->mGLImages.clear();
+}
+
@@ -0,0 +1,78 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOIMAGECACHE_H
+#define BOIMAGECACHE_H
+
+class QString;
+class QImage;
+
+/**
+ * @short Images that have been decoded in advance
+ *
+ * Decoding images (PNG, JPG, ...) is a large part of the time that is
+ * required to start a game. The files are independent of each other, so they
+ * can be decoded by worker threads while the GUI thread waits for them (see
+ * @ref BosonStartingTask::preparePart). The OpenGL calls still have to be
+ * made by the GUI thread, so the decoded images are stored here until the GUI
+ * thread requests them (see @ref BoTexture::load).
+ *
+ * @ref prefetchImage may be called by any thread, also while the GUI thread
+ * takes other images out of the cache. All other methods must be called by
+ * the GUI thread only.
+ *
+ * Note that @ref QImage uses implicit sharing with a reference count that is
+ * not thread safe. A prefetched image is therefore never shared between two
+ * threads: it is copied into the cache by the worker thread and taken out of
+ * the cache by the GUI thread, after the worker has released its copy.
+ **/
+class BoImageCache
+{
+public:
+	/**
+	 * Must be called by the GUI thread before images are prefetched. This
+	 * registers the image formats of Qt, which is not thread safe.
+	 **/
+	static void initStatic();
+
+	/**
+	 * Decode the image @p file and keep it until @ref takeImage is called.
+	 * This method is thread safe.
+	 * @param glFormat If TRUE the image is converted using @ref
+	 * QGLWidget::convertToGLFormat.
+	 * @return FALSE if the image could not be loaded.
+	 **/
+	static bool prefetchImage(const QString& file, bool glFormat);
+
+	/**
+	 * Remove the image @p file from the cache and store it in @p image.
+	 * @return FALSE if the image has not been prefetched. @p image is not
+	 * touched then.
+	 **/
+	static bool takeImage(const QString& file, bool glFormat, QImage* image);
+
+	/**
+	 * Remove the image @p file from the cache, if it has not been taken.
+	 **/
+	static void removeImage(const QString& file, bool glFormat);
+
+	static void clear();
+};
+
+#endif
+
@@ -57,6 +57,12 @@ void BosonConfig::initConfigEntries()
  addDynamicEntryInt("ToolTipUpdatePeriod", 300);
  addDynamicEntryInt("ToolTipCreator", 1); // FIXME: should be BoToolTipCreator::Extended, but I don't want to include the file here
  addDynamicEntryInt("GameLogInterval", 10);
+ addDynamicEntryUInt("AdvanceWorkerThreads", 1); // see BoAdvanceWorkerPool
+ addDynamicEntryUInt("AIAdvanceBudget", 2000); // microseconds per computer player and advance call, 0 is unlimited
+ addDynamicEntryUInt("StartingWorkerThreads", 0); // threads that prepare the game starting tasks, 0 is the number of CPUs
+ addDynamicEntryBool("BinarySaveGames", false); // save the canvas as canvas.bin, see BoBinarySaveGame
+ addDynamicEntryUInt("ReplayKeyframeInterval", 0); // advance calls between two keyframes of the replay (see BoReplayKeyframe), 0 takes no keyframes
+ addDynamicEntryUInt("MaxLoggedMessagesInMemory", 5000); // older messages are spilled to disk, 0 keeps all messages in memory
  addDynamicEntryBool("UseLOD", true);
  addDynamicEntryBool("UseVBO", false); // NVidia drivers don't properly support VBOs
  addDynamicEntryBool("WaterShaders", true);
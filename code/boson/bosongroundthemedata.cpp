@@ -160,22 +160,27 @@ const QString& BosonGroundThemeData::identifier() const
  return d->mGroundTheme->identifier();
 }
 
+QStringList BosonGroundThemeData::textureFiles(const QString& dir, const QString& name)
+{
+ QDir d(dir);
+ QStringList files = d.entryList(name + "*.png " + name + "*.jpg", QDir::Files, QDir::Name);
+ QStringList absFiles;
+ for (QStringList::Iterator it = files.begin(); it != files.end(); it++) {
+	absFiles.append(dir + "/" + *it);
+ }
+ return absFiles;
+}
+
 bool BosonGroundThemeData::loadTextures(const QString& dir, unsigned int i)
 {
  BosonProfiler prof("BosonGroundThemeData::loadTextures()");
- QDir d(dir);
- // Find all name*.png and name*.jpg files
  BosonGroundTypeData* groundData = groundTypeData(i);
  if (!groundData) {
 	BO_NULL_ERROR(groundTypeData);
 	return false;
  }
  QString name = groundData->groundType->textureFile;
- QStringList files = d.entryList(name + "*.png " + name + "*.jpg", QDir::Files, QDir::Name);
- QStringList absFiles;
- for (QStringList::Iterator it = files.begin(); it != files.end(); it++) {
-	absFiles.append(dir + "/" + *it);
- }
+ QStringList absFiles = textureFiles(dir, name);
  if (absFiles.isEmpty()) {
 	boError() << k_funcinfo << "No textures found from " << dir << " for ground type " << i << " (" << name << ")" << endl;
 	return false;
@@ -188,17 +193,19 @@ bool BosonGroundThemeData::loadTextures(const QString& dir, unsigned int i)
 
 
  // Load pixmap (for editor)
- QString iconFile = groundData->groundType->iconFile;
- if (iconFile.isNull()) {
+ QString iconFile;
+ if (groundData->groundType->iconFile.isNull()) {
 	// If no pixmap is given, we take the first available texture
-	iconFile = files.first();
+	iconFile = absFiles.first();
+ } else {
+	iconFile = dir + "/" + groundData->groundType->iconFile;
  }
  QPixmap tmppix;
- if (!tmppix.load(dir + "/" + iconFile)) {
+ if (!tmppix.load(iconFile)) {
 	tmppix = QPixmap();
  }
  if (tmppix.isNull()) {
-	boWarning() << k_funcinfo << "unable to load pixmap for ground type " << groundData->groundType->name << " from " << dir + "/" + iconFile << endl;
+	boWarning() << k_funcinfo << "unable to load pixmap for ground type " << groundData->groundType->name << " from " << iconFile << endl;
 	tmppix = QPixmap(50, 50, 32);
 	tmppix.fill(Qt::green);
  }
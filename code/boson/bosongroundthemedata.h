@@ -26,6 +26,7 @@
 
 class QImage;
 class QPixmap;
+class QStringList;
 
 class BosonMap;
 class BosonGroundTheme;
@@ -106,6 +107,14 @@ public:
 	 **/
 	BosonGroundTypeData* groundTypeData(unsigned int i) const;
 
+	/**
+	 * @return The absolute filenames of the textures of the groundtype
+	 * with the texture name @p name (see @ref
+	 * BosonGroundType::textureFile) in the directory @p dir, i.e. all
+	 * name*.png and name*.jpg files.
+	 **/
+	static QStringList textureFiles(const QString& dir, const QString& name);
+
 	static bool shadersSupported();
 	static void setUseGroundShaders(bool use);
 
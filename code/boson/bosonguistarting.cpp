@@ -44,6 +44,9 @@
 #include "gameview/bosoneffectproperties.h"
 #include "modelrendering/bomeshrenderermanager.h"
 #include "botexture.h"
+#include "boimagecache.h"
+#include "bosonconfig.h"
+#include "gameengine/bofilehashcache.h"
 
 #include <klocale.h>
 
@@ -85,6 +88,7 @@ bool BosonGUIStarting::createTasks(QPtrList<BosonStartingTask>* tasks)
  BosonStartingLoadTiles* tiles = new BosonStartingLoadTiles(i18n("Load Tiles"));
  connect(mStarting, SIGNAL(signalDestPlayField(BosonPlayField*)),
 		tiles, SLOT(slotSetDestPlayField(BosonPlayField*)));
+ tiles->addRequiredResource("PlayField");
  tasks->append(tiles);
 
  BosonStartingLoadWater* water = new BosonStartingLoadWater(i18n("Load Water"));
@@ -109,6 +113,7 @@ bool BosonGUIStarting::createTasks(QPtrList<BosonStartingTask>* tasks)
 
 	BosonStartingLoadPlayerGUIData* playerData = new BosonStartingLoadPlayerGUIData(text);
 	playerData->setPlayer(p);
+	playerData->addRequiredResource(QString("PlayerGameData %1").arg(p->bosonId()));
 	tasks->append(playerData);
  }
 
@@ -128,6 +133,53 @@ bool BosonGUIStarting::createTasks(QPtrList<BosonStartingTask>* tasks)
 
 
 
+BosonStartingLoadTiles::~BosonStartingLoadTiles()
+{
+ // the textures that were not used (e.g. because loading was aborted)
+ for (unsigned int i = 0; i < mPrefetchFiles.count(); i++) {
+	BoImageCache::removeImage(mPrefetchFiles[i], true);
+ }
+}
+
+unsigned int BosonStartingLoadTiles::beginPrepare()
+{
+ mPrefetchFiles.clear();
+ if (!playField() || !playField()->map() || !playField()->map()->groundTheme()) {
+	// startTask() will report the error
+	return 0;
+ }
+ if (!boViewData) {
+	return 0;
+ }
+ const BosonGroundTheme* theme = playField()->map()->groundTheme();
+ if (boViewData->groundThemeData(theme)) {
+	// the textures are loaded already
+	return 0;
+ }
+ BoImageCache::initStatic();
+ for (unsigned int i = 0; i < theme->groundTypeCount(); i++) {
+	const BosonGroundType* type = theme->groundType(i);
+	if (!type) {
+		continue;
+	}
+	QStringList files = BosonGroundThemeData::textureFiles(theme->themeDirectory(), type->textureFile);
+	for (QStringList::iterator it = files.begin(); it != files.end(); ++it) {
+		mPrefetchFiles.append(*it);
+	}
+ }
+ return mPrefetchFiles.count();
+}
+
+bool BosonStartingLoadTiles::preparePart(unsigned int part)
+{
+ const QValueVector<QString>& files = mPrefetchFiles;
+
+ // if the file cannot be loaded, BoTexture will load (and report) it
+ // again
+ BoImageCache::prefetchImage(files[part], true);
+ return true;
+}
+
 bool BosonStartingLoadTiles::startTask()
 {
  if (!boGame) {
@@ -189,6 +241,74 @@ unsigned int BosonStartingLoadEffects::taskDuration() const
 
 
 
+BosonStartingLoadPlayerGUIData::~BosonStartingLoadPlayerGUIData()
+{
+ for (unsigned int i = 0; i < mPrefetchFiles.count(); i++) {
+	BoImageCache::removeImage(mPrefetchFiles[i], false);
+ }
+ for (unsigned int i = 0; i < mPrefetchModels.count(); i++) {
+	BoFileHashCache::removeHash(mPrefetchModels[i]);
+ }
+}
+
+unsigned int BosonStartingLoadPlayerGUIData::beginPrepare()
+{
+ mPrefetchFiles.clear();
+ mPrefetchModels.clear();
+ if (!player() || !player()->speciesTheme() || !boViewData) {
+	// startTask() will report the error
+	return 0;
+ }
+ BoImageCache::initStatic();
+ SpeciesTheme* theme = player()->speciesTheme();
+ boViewData->addSpeciesTheme(theme);
+ SpeciesData* speciesData = boViewData->speciesData(theme);
+ if (!speciesData) {
+	return 0;
+ }
+
+ QValueList<unsigned long int> unitIds;
+ unitIds += theme->allFacilities();
+ unitIds += theme->allMobiles();
+ for (QValueList<unsigned long int>::iterator it = unitIds.begin(); it != unitIds.end(); ++it) {
+	const UnitProperties* prop = theme->unitProperties(*it);
+	if (!prop) {
+		continue;
+	}
+	QStringList files = speciesData->unitOverviewFiles(prop, theme->teamColor());
+	for (QStringList::iterator fileIt = files.begin(); fileIt != files.end(); ++fileIt) {
+		mPrefetchFiles.append(*fileIt);
+	}
+
+	QString model = SpeciesData::unitModelFile(prop);
+	if (!model.isNull() && !speciesData->unitModel(prop->typeId()) &&
+			!boConfig->boolValue("ForceDisableModelLoading")) {
+		// see BoBMFLoad::calculateHash()
+		QStringList modelFiles;
+		modelFiles.append(prop->unitPath() + model);
+		modelFiles.append(prop->unitPath() + QString::fromLatin1("index.unit"));
+		mPrefetchModels.append(modelFiles);
+	}
+ }
+ return mPrefetchFiles.count() + mPrefetchModels.count();
+}
+
+bool BosonStartingLoadPlayerGUIData::preparePart(unsigned int part)
+{
+ const QValueVector<QString>& files = mPrefetchFiles;
+ if (part >= files.count()) {
+	// if the file cannot be read, BoBMFLoad will read (and report) it
+	// again
+	BoFileHashCache::prefetchHash(mPrefetchModels[part - files.count()]);
+	return true;
+ }
+
+ // if the file cannot be loaded, SpeciesData will load (and report) it
+ // again
+ BoImageCache::prefetchImage(files[part], false);
+ return true;
+}
+
 bool BosonStartingLoadPlayerGUIData::startTask()
 {
  boDebug(270) << k_funcinfo << endl;
@@ -304,6 +424,16 @@ bool BosonStartingLoadPlayerGUIData::loadUnitDatas()
  QValueList<unsigned long int> unitIds;
  unitIds += player()->speciesTheme()->allFacilities();
  unitIds += player()->speciesTheme()->allMobiles();
+ // convert the models that are not in the model cache yet at once, this
+ // is a lot faster than converting them one by one.
+ QValueList<const UnitProperties*> props;
+ for (QValueList<unsigned long int>::iterator it = unitIds.begin(); it != unitIds.end(); ++it) {
+	props.append(player()->speciesTheme()->unitProperties(*it));
+ }
+ if (!speciesData->convertUnitModels(props)) {
+	boWarning(270) << k_funcinfo << "converting the unit models failed" << endl;
+ }
+
  QValueList<unsigned long int>::iterator it;
  int currentUnit = 0;
  float factor = 0.0f;
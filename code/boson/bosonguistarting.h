@@ -22,6 +22,8 @@
 
 #include "bosonstarting.h"
 
+#include <qvaluevector.h>
+
 class BosonPlayField;
 class Player;
 class Boson;
@@ -60,9 +62,17 @@ public:
 	{
 		mDestPlayField = 0;
 	}
+	~BosonStartingLoadTiles();
 
 	virtual unsigned int taskDuration() const;
 
+	/**
+	 * Collects the textures of the groundtheme, so that they can be
+	 * decoded by @ref preparePart.
+	 **/
+	virtual unsigned int beginPrepare();
+	virtual bool preparePart(unsigned int part);
+
 	BosonPlayField* playField() const
 	{
 		return mDestPlayField;
@@ -79,6 +89,7 @@ protected:
 
 private:
 	BosonPlayField* mDestPlayField;
+	QValueVector<QString> mPrefetchFiles;
 };
 
 class BosonStartingLoadEffects : public BosonStartingTask
@@ -106,9 +117,20 @@ public:
 		mPlayer = 0;
 		mDuration = 0;
 	}
+	~BosonStartingLoadPlayerGUIData();
 
 	virtual unsigned int taskDuration() const;
 
+	/**
+	 * Collects the overview images of the units of the player, so that
+	 * they can be decoded by @ref preparePart. The MD5 sums of the unit
+	 * models are calculated by @ref preparePart as well (see @ref
+	 * BoFileHashCache), these are required to find the models in the
+	 * model cache.
+	 **/
+	virtual unsigned int beginPrepare();
+	virtual bool preparePart(unsigned int part);
+
 	void setPlayer(Player* p);
 	Player* player() const
 	{
@@ -127,6 +149,8 @@ private:
 	Player* mPlayer;
 
 	unsigned int mDuration;
+	QValueVector<QString> mPrefetchFiles;
+	QValueVector<QStringList> mPrefetchModels; // model file and config file
 };
 
 class BosonStartingLoadWater : public BosonStartingTask
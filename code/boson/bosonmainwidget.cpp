@@ -110,6 +110,9 @@ public:
 		mLocalPlayer = 0;
 
 		mStarting = 0;
+		mStartingPrepareTime = 0;
+		mStartingStartTime = 0;
+		mStartingTaskCount = 0;
 	}
 
 	BosonGameEngine* mGameEngine;
@@ -126,6 +129,9 @@ public:
 	int mUpdateInterval;
 
 	BosonStarting* mStarting;
+	unsigned int mStartingPrepareTime;
+	unsigned int mStartingStartTime;
+	unsigned int mStartingTaskCount;
 
 	QGuardedPtr<Player> mLocalPlayer;
 };
@@ -797,6 +803,11 @@ void BosonMainWidget::reinitGame()
 		d->mStartup, SLOT(slotLoadingMaxDuration(unsigned int)));
  connect(d->mStarting, SIGNAL(signalLoadingTaskCompleted(unsigned int)),
 		d->mStartup, SLOT(slotLoadingTaskCompleted(unsigned int)));
+ connect(d->mStarting, SIGNAL(signalLoadingTaskCompleted(const QString&, unsigned int, unsigned int)),
+		this, SLOT(slotStartingTaskTimes(const QString&, unsigned int, unsigned int)));
+ d->mStartingPrepareTime = 0;
+ d->mStartingStartTime = 0;
+ d->mStartingTaskCount = 0;
  connect(d->mStarting, SIGNAL(signalLoadingStartTask(const QString&)),
 		d->mStartup, SLOT(slotLoadingStartTask(const QString&)));
  connect(d->mStarting, SIGNAL(signalLoadingStartSubTask(const QString&)),
@@ -913,6 +924,14 @@ void BosonMainWidget::slotStartNewGame()
 }
 
 // TODO: when this fails we should go back to the welcome widget!
+void BosonMainWidget::slotStartingTaskTimes(const QString& text, unsigned int prepareTime, unsigned int startTime)
+{
+ Q_UNUSED(text);
+ d->mStartingPrepareTime += prepareTime;
+ d->mStartingStartTime += startTime;
+ d->mStartingTaskCount++;
+}
+
 void BosonMainWidget::slotGameStarted()
 {
  boDebug(270) << k_funcinfo << endl;
@@ -921,6 +940,16 @@ void BosonMainWidget::slotGameStarted()
 	boWarning(270) << k_funcinfo << "not in Run status" << endl;
 	return;
  }
+ if (d->mStartingTaskCount > 0) {
+	// the prepare time is spent by the worker threads, mostly while the
+	// main thread starts other tasks.
+	boDebug(270) << k_funcinfo << d->mStartingTaskCount << " starting tasks took "
+			<< d->mStartingStartTime << " ms in the main thread and "
+			<< d->mStartingPrepareTime << " ms in the worker threads" << endl;
+	d->mStartingPrepareTime = 0;
+	d->mStartingStartTime = 0;
+	d->mStartingTaskCount = 0;
+ }
 
  boDebug(270) << k_funcinfo << "init player" << endl;
  Player* localPlayer = 0;
@@ -174,6 +174,13 @@ protected slots:
 	void slotGameStarted();
 	void slotStartingFailed();
 
+	/**
+	 * Sums up the times of the starting tasks, see @ref
+	 * BosonStarting::signalLoadingTaskCompleted. The sums are reported
+	 * once the game has been started.
+	 **/
+	void slotStartingTaskTimes(const QString& text, unsigned int prepareTime, unsigned int startTime);
+
 
 	void slotEditorNewMap(const QByteArray&);
 
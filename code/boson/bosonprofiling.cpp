@@ -28,6 +28,7 @@
 #include <qptrstack.h>
 #include <qvaluestack.h>
 #include <qdict.h>
+#include <qmap.h>
 
 static BoGlobalObject<BosonProfiling> globalProfiling(BoGlobalObjectBase::BoGlobalProfiling);
 
@@ -63,6 +64,14 @@ BosonProfilingItem::BosonProfilingItem(const QString& name)
  gettimeofday(&mStart, 0);
 }
 
+BosonProfilingItem::BosonProfilingItem(const QString& name, const struct timeval& start)
+	: mName(new QString(name)),
+	  mChildren(0),
+	  mEnded(false)
+{
+ mStart = start;
+}
+
 BosonProfilingItem::~BosonProfilingItem()
 {
  if (mChildren) {
@@ -163,6 +172,12 @@ void BosonProfilingItem::stop()
  gettimeofday(&mEnd, 0);
 }
 
+void BosonProfilingItem::stop(const struct timeval& end)
+{
+ mEnded = true;
+ mEnd = end;
+}
+
 long int BosonProfilingItem::elapsedTime() const
 {
  if (!mEnded) {
@@ -320,6 +335,10 @@ public:
 	QDict<BosonProfilingStorage> mStorages;
 	QValueStack<QString> mStorageStack;
 
+	// the BoTraceProfiling sections of the items on mStack
+	QMap<QString, unsigned int> mTraceSections;
+	QValueStack<unsigned int> mTraceStack;
+
 	BosonProfilingPopTask* mPopTask;
 };
 
@@ -335,6 +354,9 @@ void BosonProfiling::init()
  d->mDefaultMaxEntries = 1000;
  d->mCurrentStorage = new BosonProfilingStorage("Default", d->mDefaultMaxEntries);
  d->mStorages.insert(d->mCurrentStorage->name(), d->mCurrentStorage);
+
+ // the global profiling object is created by the main thread
+ BoTraceProfiling::setThreadName("Main");
 }
 
 BosonProfiling::~BosonProfiling()
@@ -430,6 +452,18 @@ const BosonProfilingItem* BosonProfiling::push(const QString& name)
 {
  BosonProfilingItem* item = new BosonProfilingItem(name);
  d->mStack.push(item);
+
+ // BoTraceProfiling::section() needs a lock, we cache the IDs here
+ unsigned int section;
+ QMap<QString, unsigned int>::iterator it = d->mTraceSections.find(name);
+ if (it != d->mTraceSections.end()) {
+	section = it.data();
+ } else {
+	section = BoTraceProfiling::section(name);
+	d->mTraceSections.insert(name, section);
+ }
+ d->mTraceStack.push(section);
+ BoTraceProfiling::begin(section);
  return item;
 }
 
@@ -444,6 +478,7 @@ void BosonProfiling::pop()
  }
  BosonProfilingItem* item = d->mStack.pop();
  item->stop();
+ BoTraceProfiling::end(d->mTraceStack.pop());
 
  BosonProfilingItem* parent = d->mStack.top();
  if (parent) {
@@ -512,6 +547,15 @@ void BosonProfiling::setMaximalEntries(const QString& storage, int max)
  switchStorage(current);
 }
 
+void BosonProfiling::addItem(const QString& storage, BosonProfilingItem* item)
+{
+ BO_CHECK_NULL_RET(item);
+ QString current = d->mCurrentStorage->name();
+ switchStorage(storage);
+ d->mCurrentStorage->addItem(item);
+ switchStorage(current);
+}
+
 void BosonProfiling::clearStorage()
 {
  BO_CHECK_NULL_RET(d->mCurrentStorage);
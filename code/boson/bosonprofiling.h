@@ -22,6 +22,8 @@
 
 #include <sys/time.h>
 
+#include "botraceprofiling.h"
+
 class QString;
 class QDataStream;
 template<class T> class QPtrList;
@@ -39,26 +41,39 @@ template<class T> class QPtrStack;
 
 /**
  * Use this macro to profile a method. Place it at the beginning of a method and
- * the profiling values appear in the profiling dialog
+ * the profiling values appear in the profiling dialog (in the "Trace"
+ * storages).
+ *
+ * This uses @ref BoTraceProfiling, the name of the method is converted into
+ * a section ID only once, so this is cheap enough to be used in methods that
+ * are called very often, and it may be used in any thread.
  **/
 #define PROFILE_METHOD \
-	BosonProfiler methodProfiler(prof_funcinfo);
+	static const unsigned int methodProfilerSection = BoTraceProfiling::section(prof_funcinfo); \
+	BoTraceProfiler methodProfiler(methodProfilerSection);
 
 /**
  * Same as above, but provides two parameters for advanced uses:
- * @param name The name of the @ref BosonProfiler object. You can use this to
+ * @param name The name of the @ref BoTraceProfiler object. You can use this to
  * stop the profiling object at some point for example.
  * @param desc A description of what is profiled, in addition to the
  * (automatically added) method name.
  **/
 #define PROFILE_METHOD_2(name, desc) \
-	BosonProfiler name(prof_funcinfo + " - " + desc);
+	static const unsigned int name##Section = BoTraceProfiling::section(prof_funcinfo + " - " + desc); \
+	BoTraceProfiler name(name##Section);
 
 class BosonProfilingItem
 {
 public:
 	BosonProfilingItem();
 	BosonProfilingItem(const QString& name);
+
+	/**
+	 * Construct an item that started at @p start, instead of now. See
+	 * also @ref stop.
+	 **/
+	BosonProfilingItem(const QString& name, const struct timeval& start);
 	~BosonProfilingItem();
 
 	BosonProfilingItem* clone() const;
@@ -77,6 +92,14 @@ public:
 	 **/
 	void stop();
 
+	/**
+	 * @overload
+	 * Like the above, but uses @p end as end time. This is used to create
+	 * items from profiling data that has been collected before (see @ref
+	 * BoTraceProfiling::exportToProfiling).
+	 **/
+	void stop(const struct timeval& end);
+
 	/**
 	 * @return The time elapsed between constructing this object and calling
 	 * @ref stop. Undefined if @ref stop was not called yet, see @ref
@@ -203,6 +226,9 @@ public:
 	 *
 	 * Call @p pop to end profiling. Note that you always have exactly one
 	 * @ref pop call for every push call!
+	 *
+	 * The item is recorded by @ref BoTraceProfiling, too, so that traces
+	 * contain the phases of the program as well.
 	 **/
 	const BosonProfilingItem* push(const QString& name);
 
@@ -261,6 +287,14 @@ public:
 	 **/
 	void setMaximalEntries(const QString& storage, int max);
 
+	/**
+	 * Add a (stopped) toplevel @p item to @p storage. The item is owned by
+	 * the storage afterwards.
+	 *
+	 * Usually items are added by @ref pop.
+	 **/
+	void addItem(const QString& storage, BosonProfilingItem* item);
+
 	/**
 	 * This returns all items currently stored which are not older than @p
 	 * since. The sorting of the list depends on the internal storage
@@ -21,6 +21,7 @@
 
 #include "../bomemory/bodummymemory.h"
 #include "bosonprofiling.h"
+#include "botraceprofiling.h"
 #include "bodebug.h"
 #include "bofiledialog.h"
 #include "qlistviewitemnumber.h"
@@ -320,6 +321,7 @@ void BosonProfilingDialog::reset()
 void BosonProfilingDialog::slotUpdateFromGlobalProfiling()
 {
  d->mProfiling = *boProfiling;
+ BoTraceProfiling::exportToProfiling(&d->mProfiling);
 
  // update data from d->mProfiling
  slotUpdate();
@@ -361,6 +363,13 @@ void BosonProfilingDialog::slotSaveToFile()
 		return;
 	}
  }
+ if (file.endsWith(".json")) {
+	// the current trace in the format of the chrome browser
+	if (!BoTraceProfiling::saveChromeTrace(file)) {
+		KMessageBox::sorry(this, i18n("Error while saving to %1").arg(file));
+	}
+	return;
+ }
  QFile f(file);
  if (!f.open(IO_WriteOnly)) {
 	KMessageBox::sorry(this, i18n("File %1 could not be opened").arg(file));
@@ -25,6 +25,7 @@
 #include "gameengine/speciestheme.h"
 #include "speciesdata.h"
 #include "gameengine/bosonitem.h"
+#include "gameengine/rtti.h"
 #include "gameengine/bosongroundtheme.h"
 #include "bosongroundthemedata.h"
 
@@ -67,6 +68,7 @@ public:
 
 	QPtrDict<BosonItemContainer> mItem2ItemContainer;
 	QPtrList<BosonItemContainer> mAllItemContainers;
+	QPtrList<BosonItemContainer> mShotItemContainers;
 
 	QMap<const SpeciesTheme*, SpeciesData*> mSpeciesTheme2SpeciesData;
 
@@ -125,6 +127,9 @@ void BosonViewData::slotAddItemContainerFor(BosonItem* item)
  c = new BosonItemContainer(item);
  d->mAllItemContainers.append(c);
  d->mItem2ItemContainer.insert(item, c);
+ if (RTTI::isShot(item->rtti())) {
+	d->mShotItemContainers.append(c);
+ }
 
  emit signalItemContainerAdded(c);
 }
@@ -137,6 +142,7 @@ void BosonViewData::slotRemoveItemContainerFor(BosonItem* item)
  emit signalItemContainerAboutToBeRemoved(c);
 
  d->mItem2ItemContainer.remove(item);
+ d->mShotItemContainers.removeRef(c);
  d->mAllItemContainers.setAutoDelete(true);
  d->mAllItemContainers.removeRef(c);
 }
@@ -152,6 +158,11 @@ const QPtrList<BosonItemContainer>& BosonViewData::allItemContainers() const
  return d->mAllItemContainers;
 }
 
+const QPtrList<BosonItemContainer>& BosonViewData::shotItemContainers() const
+{
+ return d->mShotItemContainers;
+}
+
 void BosonViewData::addSpeciesTheme(const SpeciesTheme* theme)
 {
  BO_CHECK_NULL_RET(theme);
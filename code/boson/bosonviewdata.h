@@ -157,6 +157,13 @@ public:
 	BosonItemContainer* itemContainer(BosonItem* item);
 	const QPtrList<BosonItemContainer>& allItemContainers() const;
 
+	/**
+	 * @return The containers of all shots. Shots are not placed in the
+	 * cells of the map (see @ref BosonItem::addToCells), so they can not
+	 * be found using the cells.
+	 **/
+	const QPtrList<BosonItemContainer>& shotItemContainers() const;
+
 	void addGroundTheme(const BosonGroundTheme* theme);
 	void removeGroundTheme(const BosonGroundTheme* theme);
 	BosonGroundThemeData* groundThemeData(const BosonGroundTheme* theme) const;
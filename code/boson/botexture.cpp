@@ -28,6 +28,7 @@
 #include "bosonconfig.h"
 #include "bosonprofiling.h"
 #include "info/boinfo.h"
+#include "boimagecache.h"
 
 #define USE_BTF 0
 #if USE_BTF
@@ -227,15 +228,19 @@ void BoTexture::load(const QString& name)
     {
       // Load the image using QImage
       QString sidename = name.arg(sides[i]);
-      QImage img(sidename);
-      if(img.isNull())
+      QImage img;
+      if(!BoImageCache::takeImage(sidename, true, &img))
       {
-        boError() << k_funcinfo << "Couldn't load image for side " << i << " from file '" <<
-            sidename << "'" << endl;
-        mLoaded = false;
-        return;
+        img = QImage(sidename);
+        if(img.isNull())
+        {
+          boError() << k_funcinfo << "Couldn't load image for side " << i << " from file '" <<
+              sidename << "'" << endl;
+          mLoaded = false;
+          return;
+        }
+        img = QGLWidget::convertToGLFormat(img);
       }
-      img = QGLWidget::convertToGLFormat(img);
       load(img.bits(), img.width(), img.height(), i);
     }
   }
@@ -243,13 +248,18 @@ void BoTexture::load(const QString& name)
   {
     // Load the image using QImage
 #if !USE_BTF
-    QImage img(name);
-    if(img.isNull())
+    // Use the image if it has been decoded in advance already
+    QImage img;
+    if(!BoImageCache::takeImage(name, true, &img))
     {
-      boError() << k_funcinfo << "Couldn't load image from file '" << name << "'" << endl;
-      return;
+      img = QImage(name);
+      if(img.isNull())
+      {
+        boError() << k_funcinfo << "Couldn't load image from file '" << name << "'" << endl;
+        return;
+      }
+      img = QGLWidget::convertToGLFormat(img);
     }
-    img = QGLWidget::convertToGLFormat(img);
 #else
     BoBTFLoad btfLoader(name);
     if(!btfLoader.loadTexture())
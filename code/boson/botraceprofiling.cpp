@@ -0,0 +1,435 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "botraceprofiling.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "bosonprofiling.h"
+#include "bodebug.h"
+
+#include <qstring.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qptrlist.h>
+#include <qvaluelist.h>
+#include <qvaluevector.h>
+#include <qfile.h>
+#include <qtextstream.h>
+#include <qatomic.h>
+
+#include <atomic>
+
+#include <sys/time.h>
+#include <time.h>
+
+// number of events per thread. must be a power of 2.
+// 64k events (1 MB) are a few seconds of a busy game.
+#define TRACE_RING_BUFFER_SIZE (1 << 16)
+#define TRACE_RING_BUFFER_MASK (TRACE_RING_BUFFER_SIZE - 1)
+
+bool BoTraceProfiling::mEnabled = true;
+
+/**
+ * @internal
+ *
+ * The events of a single thread. Only the owning thread writes to the
+ * buffer, other threads may read it at any time (see @ref copyEvents).
+ *
+ * The writer publishes every event by a release store of the write index, no
+ * locks are involved. The reader checks after copying whether the writer may
+ * have overwritten some of the copied slots in the meantime and discards
+ * them.
+ **/
+class BoTraceRingBuffer
+{
+public:
+	BoTraceRingBuffer(unsigned int number)
+	{
+		mEvents = new BoTraceEvent[TRACE_RING_BUFFER_SIZE];
+		mWriteIndex.storeRelease(0);
+		mClearIndex.storeRelease(0);
+		mInUse = true;
+		setNumber(number);
+	}
+	~BoTraceRingBuffer()
+	{
+		delete[] mEvents;
+	}
+
+	void setNumber(unsigned int number)
+	{
+		mNumber = number;
+		mName = QString("Thread %1").arg(number);
+	}
+
+	void record(unsigned int section, unsigned int type, Q_UINT64 time)
+	{
+		// we are the only writer, so a relaxed load is sufficient
+		Q_UINT64 index = mWriteIndex.load();
+		BoTraceEvent& e = mEvents[index & TRACE_RING_BUFFER_MASK];
+		e.mTime = time;
+		e.mSection = section;
+		e.mType = type;
+		mWriteIndex.storeRelease(index + 1);
+	}
+
+	/**
+	 * Copy all valid events into @p events, oldest first. The writing
+	 * thread may continue while we copy, events that may have been
+	 * overwritten during the copy (including the slot that is being
+	 * written right now) are discarded.
+	 **/
+	void copyEvents(QValueVector<BoTraceEvent>* events) const
+	{
+		events->clear();
+		Q_UINT64 end = mWriteIndex.loadAcquire();
+		Q_UINT64 begin = mClearIndex.loadAcquire();
+		if (end > TRACE_RING_BUFFER_SIZE && begin < end - TRACE_RING_BUFFER_SIZE) {
+			begin = end - TRACE_RING_BUFFER_SIZE;
+		}
+		if (begin >= end) {
+			return;
+		}
+		QValueVector<BoTraceEvent> copy((int)(end - begin));
+		for (Q_UINT64 i = begin; i < end; i++) {
+			copy[(int)(i - begin)] = mEvents[i & TRACE_RING_BUFFER_MASK];
+		}
+
+		// the copy must be complete before we look at the write index
+		// again
+		std::atomic_thread_fence(std::memory_order_acquire);
+		Q_UINT64 end2 = mWriteIndex.load();
+
+		// the writer has written all slots up to end2 and may be writing
+		// slot end2 right now, all of them replace events that are
+		// TRACE_RING_BUFFER_SIZE older.
+		Q_UINT64 firstValid = begin;
+		if (end2 + 1 > TRACE_RING_BUFFER_SIZE && firstValid < end2 + 1 - TRACE_RING_BUFFER_SIZE) {
+			firstValid = end2 + 1 - TRACE_RING_BUFFER_SIZE;
+		}
+		if (firstValid >= end) {
+			return;
+		}
+		events->reserve((int)(end - firstValid));
+		for (Q_UINT64 i = firstValid; i < end; i++) {
+			events->append(copy[(int)(i - begin)]);
+		}
+	}
+
+	void clear()
+	{
+		mClearIndex.storeRelease(mWriteIndex.loadAcquire());
+	}
+
+	BoTraceEvent* mEvents;
+	QAtomicInteger<Q_UINT64> mWriteIndex;
+	QAtomicInteger<Q_UINT64> mClearIndex;
+
+	// the following are protected by the mutex of BoTraceRegistry
+	bool mInUse;
+	unsigned int mNumber;
+	QString mName;
+};
+
+/**
+ * @internal
+ **/
+class BoTraceRegistry
+{
+public:
+	BoTraceRegistry()
+	{
+		mNextThreadNumber = 0;
+		mBuffers.setAutoDelete(true);
+	}
+
+	QMutex mMutex;
+	QMap<QString, unsigned int> mSectionIds;
+	QValueVector<QString> mSectionNames;
+	QPtrList<BoTraceRingBuffer> mBuffers;
+	unsigned int mNextThreadNumber;
+};
+
+static BoTraceRegistry* registry()
+{
+ static BoTraceRegistry r;
+ return &r;
+}
+
+/**
+ * @internal
+ *
+ * Releases the buffer of a thread when the thread ends, so that it can be
+ * used by the next thread. This makes sure that we don't need a new buffer
+ * whenever e.g. the number of advance workers changes.
+ **/
+class BoTraceThreadRelease
+{
+public:
+	BoTraceThreadRelease()
+	{
+		mBuffer = 0;
+	}
+	~BoTraceThreadRelease()
+	{
+		if (mBuffer) {
+			QMutexLocker lock(&registry()->mMutex);
+			mBuffer->mInUse = false;
+		}
+	}
+	BoTraceRingBuffer* mBuffer;
+};
+
+static thread_local BoTraceRingBuffer* currentThreadBuffer = 0;
+static thread_local BoTraceThreadRelease currentThreadRelease;
+
+unsigned int BoTraceProfiling::section(const QString& name)
+{
+ BoTraceRegistry* r = registry();
+ QMutexLocker lock(&r->mMutex);
+ QMap<QString, unsigned int>::iterator it = r->mSectionIds.find(name);
+ if (it != r->mSectionIds.end()) {
+	return it.data();
+ }
+ unsigned int id = r->mSectionNames.count();
+ r->mSectionNames.append(name);
+ r->mSectionIds.insert(name, id);
+ return id;
+}
+
+QString BoTraceProfiling::sectionName(unsigned int id)
+{
+ BoTraceRegistry* r = registry();
+ QMutexLocker lock(&r->mMutex);
+ if (id >= r->mSectionNames.count()) {
+	return QString::null;
+ }
+ return r->mSectionNames[id];
+}
+
+void BoTraceProfiling::setEnabled(bool e)
+{
+ mEnabled = e;
+}
+
+Q_UINT64 BoTraceProfiling::now()
+{
+ struct timespec t;
+ clock_gettime(CLOCK_MONOTONIC, &t);
+ return ((Q_UINT64)t.tv_sec) * 1000000000 + (Q_UINT64)t.tv_nsec;
+}
+
+BoTraceRingBuffer* BoTraceProfiling::currentBuffer()
+{
+ if (currentThreadBuffer) {
+	return currentThreadBuffer;
+ }
+ BoTraceRegistry* r = registry();
+ QMutexLocker lock(&r->mMutex);
+ BoTraceRingBuffer* buffer = 0;
+ for (QPtrListIterator<BoTraceRingBuffer> it(r->mBuffers); it.current(); ++it) {
+	if (!it.current()->mInUse) {
+		buffer = it.current();
+		buffer->clear();
+		buffer->mInUse = true;
+		buffer->setNumber(r->mNextThreadNumber);
+		break;
+	}
+ }
+ if (!buffer) {
+	buffer = new BoTraceRingBuffer(r->mNextThreadNumber);
+	r->mBuffers.append(buffer);
+ }
+ r->mNextThreadNumber++;
+ currentThreadBuffer = buffer;
+ currentThreadRelease.mBuffer = buffer;
+ return buffer;
+}
+
+void BoTraceProfiling::record(unsigned int section, unsigned int type, Q_UINT64 time)
+{
+ currentBuffer()->record(section, type, time);
+}
+
+void BoTraceProfiling::setThreadName(const QString& name)
+{
+ BoTraceRingBuffer* buffer = currentBuffer();
+ QMutexLocker lock(&registry()->mMutex);
+ buffer->mName = name;
+}
+
+void BoTraceProfiling::clear()
+{
+ BoTraceRegistry* r = registry();
+ QMutexLocker lock(&r->mMutex);
+ for (QPtrListIterator<BoTraceRingBuffer> it(r->mBuffers); it.current(); ++it) {
+	it.current()->clear();
+ }
+}
+
+/**
+ * @internal
+ * The events and the name of a thread, copied out of the ring buffer.
+ **/
+class BoTraceThreadEvents
+{
+public:
+	unsigned int mNumber;
+	QString mName;
+	QValueVector<BoTraceEvent> mEvents;
+};
+
+static void copyAllEvents(QValueList<BoTraceThreadEvents>* threads, QValueVector<QString>* sectionNames)
+{
+ BoTraceRegistry* r = registry();
+ QMutexLocker lock(&r->mMutex);
+ for (QPtrListIterator<BoTraceRingBuffer> it(r->mBuffers); it.current(); ++it) {
+	BoTraceThreadEvents t;
+	t.mNumber = it.current()->mNumber;
+	t.mName = it.current()->mName;
+	it.current()->copyEvents(&t.mEvents);
+	if (!t.mEvents.isEmpty()) {
+		threads->append(t);
+	}
+ }
+ *sectionNames = r->mSectionNames;
+}
+
+static struct timeval toTimeval(Q_UINT64 time, Q_INT64 offset)
+{
+ Q_INT64 us = (Q_INT64)(time / 1000) + offset;
+ struct timeval t;
+ t.tv_sec = us / 1000000;
+ t.tv_usec = us % 1000000;
+ return t;
+}
+
+void BoTraceProfiling::exportToProfiling(BosonProfiling* profiling)
+{
+ BO_CHECK_NULL_RET(profiling);
+ QValueList<BoTraceThreadEvents> threads;
+ QValueVector<QString> sectionNames;
+ copyAllEvents(&threads, &sectionNames);
+
+ // the items use the time of day, we use a monotonic clock
+ struct timeval timeOfDay;
+ gettimeofday(&timeOfDay, 0);
+ Q_INT64 offset = ((Q_INT64)timeOfDay.tv_sec) * 1000000 + timeOfDay.tv_usec - (Q_INT64)(now() / 1000);
+
+ for (QValueList<BoTraceThreadEvents>::iterator it = threads.begin(); it != threads.end(); ++it) {
+	QString storage = QString("Trace: %1").arg((*it).mName);
+	profiling->clearStorage(storage);
+	profiling->setMaximalEntries(storage, -1);
+
+	QPtrList<BosonProfilingItem> stack;
+	QValueVector<unsigned int> sectionStack;
+	const QValueVector<BoTraceEvent>& events = (*it).mEvents;
+	for (unsigned int i = 0; i < events.count(); i++) {
+		const BoTraceEvent& e = events[i];
+		if (e.mType == BoTraceEvent::Begin) {
+			QString name;
+			if (e.mSection < sectionNames.count()) {
+				name = sectionNames[e.mSection];
+			}
+			stack.append(new BosonProfilingItem(name, toTimeval(e.mTime, offset)));
+			sectionStack.push_back(e.mSection);
+			continue;
+		}
+		if (stack.isEmpty() || sectionStack.back() != e.mSection) {
+			// the begin event has been overwritten already (or
+			// profiling was enabled in between)
+			continue;
+		}
+		BosonProfilingItem* item = stack.take(stack.count() - 1);
+		sectionStack.pop_back();
+		item->stop(toTimeval(e.mTime, offset));
+		if (stack.isEmpty()) {
+			profiling->addItem(storage, item);
+		} else {
+			stack.last()->addChild(item);
+		}
+	}
+
+	// sections that have not yet ended
+	stack.setAutoDelete(true);
+	stack.clear();
+ }
+}
+
+QString BoTraceProfiling::jsonString(const QString& string)
+{
+ QString s = string;
+ s.replace("\\", "\\\\");
+ s.replace("\"", "\\\"");
+ s.replace("\n", "\\n");
+ s.replace("\t", "\\t");
+ return QString("\"%1\"").arg(s);
+}
+
+bool BoTraceProfiling::saveChromeTrace(const QString& fileName)
+{
+ QValueList<BoTraceThreadEvents> threads;
+ QValueVector<QString> sectionNames;
+ copyAllEvents(&threads, &sectionNames);
+
+ QFile file(fileName);
+ if (!file.open(IO_WriteOnly)) {
+	boError() << k_funcinfo << "could not open " << fileName << endl;
+	return false;
+ }
+
+ // chrome uses us. we make all times relative to the oldest event, the
+ // absolute values are meaningless anyway.
+ Q_UINT64 start = 0;
+ for (QValueList<BoTraceThreadEvents>::iterator it = threads.begin(); it != threads.end(); ++it) {
+	Q_UINT64 t = (*it).mEvents[0].mTime;
+	if (start == 0 || t < start) {
+		start = t;
+	}
+ }
+
+ QTextStream stream(&file);
+ stream << "{\"traceEvents\":[\n";
+ bool first = true;
+ for (QValueList<BoTraceThreadEvents>::iterator it = threads.begin(); it != threads.end(); ++it) {
+	if (!first) {
+		stream << ",\n";
+	}
+	first = false;
+	stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (*it).mNumber
+			<< ",\"args\":{\"name\":" << jsonString((*it).mName) << "}}";
+
+	const QValueVector<BoTraceEvent>& events = (*it).mEvents;
+	for (unsigned int i = 0; i < events.count(); i++) {
+		const BoTraceEvent& e = events[i];
+		QString name;
+		if (e.mSection < sectionNames.count()) {
+			name = sectionNames[e.mSection];
+		}
+		stream << ",\n{\"name\":" << jsonString(name)
+				<< ",\"cat\":\"boson\",\"ph\":\"" << (e.mType == BoTraceEvent::Begin ? "B" : "E")
+				<< "\",\"ts\":" << QString::number((double)(e.mTime - start) / 1000.0, 'f', 3)
+				<< ",\"pid\":1,\"tid\":" << (*it).mNumber << "}";
+	}
+ }
+ stream << "\n]}\n";
+ file.close();
+ return true;
+}
+
@@ -0,0 +1,201 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOTRACEPROFILING_H
+#define BOTRACEPROFILING_H
+
+#include <qglobal.h>
+
+class QString;
+class BosonProfiling;
+class BoTraceRingBuffer;
+
+/**
+ * A single entry of the trace, see @ref BoTraceProfiling. All events have the
+ * same (small) size, so that they can be stored in a ring buffer.
+ **/
+struct BoTraceEvent
+{
+	enum Type {
+		Begin = 0,
+		End = 1
+	};
+	Q_UINT64 mTime; // ns, see BoTraceProfiling::now()
+	Q_UINT32 mSection;
+	Q_UINT32 mType;
+};
+
+/**
+ * A cheap alternative to @ref BosonProfiling, meant to be left enabled all
+ * the time.
+ *
+ * Every section that is profiled gets an ID once (see @ref section), usually
+ * in a static variable at the place where it is profiled (see @ref
+ * PROFILE_METHOD). Profiling a section then just stores two @ref BoTraceEvent
+ * objects (begin and end) in a ring buffer of the current thread - no
+ * strings are copied, nothing is allocated and no locks are involved. Once
+ * the ring buffer is full, the oldest events are overwritten.
+ *
+ * The events can be converted to a @ref BosonProfiling tree (see @ref
+ * exportToProfiling), e.g. for the profiling dialog and boprofiling, or
+ * written in the trace format of the Chrome browser (see @ref
+ * saveChromeTrace, load the file in chrome://tracing).
+ *
+ * All methods of this class are static and thread safe.
+ **/
+class BoTraceProfiling
+{
+public:
+	/**
+	 * @return The ID of the section @p name. The ID is created on the
+	 * first call and remains the same for the rest of the program. This
+	 * method uses a lock, so call it once per section only.
+	 **/
+	static unsigned int section(const QString& name);
+
+	/**
+	 * @return The name of the section @p id, see @ref section.
+	 **/
+	static QString sectionName(unsigned int id);
+
+	/**
+	 * Enable or disable recording of events. Enabled by default.
+	 **/
+	static void setEnabled(bool e);
+	static bool isEnabled()
+	{
+		return mEnabled;
+	}
+
+	/**
+	 * Set the name of the current thread in exported traces. By default
+	 * threads are numbered in the order in which they record their first
+	 * event.
+	 **/
+	static void setThreadName(const QString& name);
+
+	/**
+	 * @return The current time in ns, from a monotonic clock.
+	 **/
+	static Q_UINT64 now();
+
+	static void begin(unsigned int section)
+	{
+		if (mEnabled) {
+			record(section, BoTraceEvent::Begin, now());
+		}
+	}
+	static void end(unsigned int section)
+	{
+		if (mEnabled) {
+			record(section, BoTraceEvent::End, now());
+		}
+	}
+
+	/**
+	 * Discard the events of all threads.
+	 **/
+	static void clear();
+
+	/**
+	 * Convert the events of all threads into @ref BosonProfilingItem
+	 * trees and add them to @p profiling, one storage per thread (named
+	 * "Trace: " and the thread name). Sections whose begin event has
+	 * already been overwritten or that have not ended yet are skipped.
+	 **/
+	static void exportToProfiling(BosonProfiling* profiling);
+
+	/**
+	 * Write the events of all threads to @p fileName in the JSON trace
+	 * event format of the Chrome browser.
+	 **/
+	static bool saveChromeTrace(const QString& fileName);
+
+	/**
+	 * @return @p string in quotes, with all characters escaped that must
+	 * not appear in a JSON string.
+	 **/
+	static QString jsonString(const QString& string);
+
+protected:
+	friend class BoTraceProfiler;
+	static void record(unsigned int section, unsigned int type, Q_UINT64 time);
+	static BoTraceRingBuffer* currentBuffer();
+
+private:
+	static bool mEnabled;
+};
+
+/**
+ * Profiles a section of code from construction until destruction (or @ref
+ * pop) using @ref BoTraceProfiling. This is what @ref PROFILE_METHOD uses.
+ *
+ * The interface is the same as the one of @ref BosonProfiler, so that code
+ * using PROFILE_METHOD does not care about which backend is used.
+ **/
+class BoTraceProfiler
+{
+public:
+	BoTraceProfiler(unsigned int section)
+		: mSection(section),
+		mPopped(false)
+	{
+		mStart = BoTraceProfiling::now();
+		if (BoTraceProfiling::isEnabled()) {
+			BoTraceProfiling::record(mSection, BoTraceEvent::Begin, mStart);
+		}
+	}
+	~BoTraceProfiler()
+	{
+		pop();
+	}
+
+	void pop()
+	{
+		if (mPopped) {
+			return;
+		}
+		mPopped = true;
+		mEnd = BoTraceProfiling::now();
+		if (BoTraceProfiling::isEnabled()) {
+			BoTraceProfiling::record(mSection, BoTraceEvent::End, mEnd);
+		}
+	}
+
+	/**
+	 * @return The elapsed time in us, like @ref BosonProfiler::popElapsed
+	 **/
+	long int popElapsed()
+	{
+		pop();
+		return (long int)((mEnd - mStart) / 1000);
+	}
+
+	long int elapsedSinceStart() const
+	{
+		return (long int)((BoTraceProfiling::now() - mStart) / 1000);
+	}
+
+private:
+	unsigned int mSection;
+	bool mPopped;
+	Q_UINT64 mStart;
+	Q_UINT64 mEnd;
+};
+
+#endif
@@ -0,0 +1,269 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "boadvanceworkerpool.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "bodebug.h"
+#include "../botraceprofiling.h"
+
+#include <qthread.h>
+#include <qmutex.h>
+#include <qwaitcondition.h>
+#include <qptrlist.h>
+
+// default number of indices a worker takes from a job at once
+#define WORKER_CHUNK_SIZE 16
+
+// a higher number of threads would not help, the jobs are too small
+#define MAX_WORKER_COUNT 16
+
+class BoAdvanceWorkerThread : public QThread
+{
+public:
+	BoAdvanceWorkerThread(BoAdvanceWorkerPool* pool, unsigned int number, unsigned int generation)
+		: QThread()
+	{
+		mPool = pool;
+		mNumber = number;
+		mGeneration = generation;
+	}
+
+protected:
+	virtual void run()
+	{
+		BoTraceProfiling::setThreadName(QString("Advance worker %1").arg(mNumber));
+		mPool->workerLoop(mGeneration);
+	}
+
+private:
+	BoAdvanceWorkerPool* mPool;
+	unsigned int mNumber;
+	unsigned int mGeneration;
+};
+
+class BoAdvanceWorkerPoolPrivate
+{
+public:
+	BoAdvanceWorkerPoolPrivate()
+	{
+		mJob = 0;
+		mCount = 0;
+		mNextIndex = 0;
+		mBusyWorkers = 0;
+		mGeneration = 0;
+		mQuit = false;
+		mChunkSize = WORKER_CHUNK_SIZE;
+	}
+	QPtrList<BoAdvanceWorkerThread> mThreads;
+
+	// mMutex protects all of the following
+	QMutex mMutex;
+	QWaitCondition mStartCondition;
+	QWaitCondition mDoneCondition;
+	BoAdvanceJob* mJob;
+	unsigned int mCount;
+	unsigned int mNextIndex;
+	unsigned int mBusyWorkers;
+	unsigned int mGeneration;
+	bool mQuit;
+
+	unsigned int mChunkSize;
+};
+
+BoAdvanceWorkerPool::BoAdvanceWorkerPool()
+{
+ d = new BoAdvanceWorkerPoolPrivate;
+ d->mThreads.setAutoDelete(true);
+}
+
+BoAdvanceWorkerPool::~BoAdvanceWorkerPool()
+{
+ wait();
+ stopWorkers();
+ delete d;
+}
+
+unsigned int BoAdvanceWorkerPool::workerCount() const
+{
+ return d->mThreads.count() + 1;
+}
+
+void BoAdvanceWorkerPool::setWorkerCount(unsigned int count)
+{
+ if (count == 0) {
+	count = 1;
+ }
+ if (count > MAX_WORKER_COUNT) {
+	boWarning() << k_funcinfo << count << " workers requested, using " << MAX_WORKER_COUNT << endl;
+	count = MAX_WORKER_COUNT;
+ }
+ if (count == workerCount()) {
+	return;
+ }
+ wait();
+ stopWorkers();
+ for (unsigned int i = 1; i < count; i++) {
+	// the thread must not use d->mGeneration itself when it starts - we
+	// might have started a job already
+	BoAdvanceWorkerThread* thread = new BoAdvanceWorkerThread(this, i, d->mGeneration);
+	d->mThreads.append(thread);
+	thread->start();
+ }
+}
+
+void BoAdvanceWorkerPool::setChunkSize(unsigned int size)
+{
+ if (size == 0) {
+	size = 1;
+ }
+ d->mChunkSize = size;
+}
+
+unsigned int BoAdvanceWorkerPool::chunkSize() const
+{
+ return d->mChunkSize;
+}
+
+void BoAdvanceWorkerPool::stopWorkers()
+{
+ if (d->mThreads.isEmpty()) {
+	return;
+ }
+ d->mMutex.lock();
+ d->mQuit = true;
+ d->mStartCondition.wakeAll();
+ d->mMutex.unlock();
+ for (QPtrListIterator<BoAdvanceWorkerThread> it(d->mThreads); it.current(); ++it) {
+	it.current()->wait();
+ }
+ d->mThreads.clear();
+ d->mQuit = false;
+}
+
+void BoAdvanceWorkerPool::run(BoAdvanceJob* job, unsigned int count)
+{
+ if (!job) {
+	BO_NULL_ERROR(job);
+	return;
+ }
+ if (d->mThreads.isEmpty() || count <= d->mChunkSize) {
+	wait();
+	for (unsigned int i = 0; i < count; i++) {
+		job->compute(i);
+	}
+	return;
+ }
+
+ start(job, count);
+ wait();
+}
+
+void BoAdvanceWorkerPool::start(BoAdvanceJob* job, unsigned int count)
+{
+ if (!job) {
+	BO_NULL_ERROR(job);
+	return;
+ }
+ if (isRunning()) {
+	boWarning() << k_funcinfo << "a job is running already. waiting for it." << endl;
+	wait();
+ }
+
+ d->mMutex.lock();
+ d->mJob = job;
+ d->mCount = count;
+ d->mNextIndex = 0;
+ d->mBusyWorkers = d->mThreads.count();
+ if (!d->mThreads.isEmpty()) {
+	d->mGeneration++;
+	d->mStartCondition.wakeAll();
+ }
+ d->mMutex.unlock();
+}
+
+void BoAdvanceWorkerPool::wait()
+{
+ // mJob is modified by the main thread only
+ if (!isRunning()) {
+	return;
+ }
+
+ processChunks();
+
+ d->mMutex.lock();
+ while (d->mBusyWorkers > 0) {
+	d->mDoneCondition.wait(&d->mMutex);
+ }
+ d->mJob = 0;
+ d->mCount = 0;
+ d->mMutex.unlock();
+}
+
+bool BoAdvanceWorkerPool::isRunning() const
+{
+ return (d->mJob != 0);
+}
+
+void BoAdvanceWorkerPool::processChunks()
+{
+ while (true) {
+	d->mMutex.lock();
+	BoAdvanceJob* job = d->mJob;
+	unsigned int begin = d->mNextIndex;
+	unsigned int end = begin + d->mChunkSize;
+	if (end > d->mCount) {
+		end = d->mCount;
+	}
+	d->mNextIndex = end;
+	d->mMutex.unlock();
+
+	if (begin >= end) {
+		return;
+	}
+	for (unsigned int i = begin; i < end; i++) {
+		job->compute(i);
+	}
+ }
+}
+
+void BoAdvanceWorkerPool::workerLoop(unsigned int generation)
+{
+ d->mMutex.lock();
+ while (true) {
+	while (!d->mQuit && d->mGeneration == generation) {
+		d->mStartCondition.wait(&d->mMutex);
+	}
+	if (d->mQuit) {
+		break;
+	}
+	generation = d->mGeneration;
+	d->mMutex.unlock();
+
+	processChunks();
+
+	d->mMutex.lock();
+	d->mBusyWorkers--;
+	if (d->mBusyWorkers == 0) {
+		d->mDoneCondition.wakeAll();
+	}
+ }
+ d->mMutex.unlock();
+}
+
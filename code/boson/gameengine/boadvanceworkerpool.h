@@ -0,0 +1,140 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOADVANCEWORKERPOOL_H
+#define BOADVANCEWORKERPOOL_H
+
+class BoAdvanceWorkerPoolPrivate;
+
+/**
+ * A job for the "compute" phase of an advance call, see @ref
+ * BoAdvanceWorkerPool.
+ *
+ * @ref compute is called exactly once for every index of the job, but in no
+ * particular order and possibly from several threads at the same time. An
+ * implementation may therefore only read the game state and must write its
+ * result to a place that belongs to @p index only (e.g. an array entry).
+ * Note that this includes debug output and @ref BosonProfiling (i.e. @ref
+ * BosonProfiler and boProfiling), which are not thread safe. @ref
+ * PROFILE_METHOD and @ref BoTraceProfiler record to a buffer of the calling
+ * thread only and may be used.
+ **/
+class BoAdvanceJob
+{
+public:
+	BoAdvanceJob() {}
+	virtual ~BoAdvanceJob() {}
+
+	virtual void compute(unsigned int index) = 0;
+};
+
+/**
+ * A small pool of worker threads for the advance call.
+ *
+ * The advance call is split into two phases for the work that can run in
+ * parallel: a "compute" phase that calls @ref BoAdvanceJob::compute for all
+ * items (see @ref run) and writes the results to per-item storage only, and a
+ * "commit" phase that applies the results to the game in a fixed order (e.g.
+ * by item ID) in the main thread.
+ *
+ * Since the compute phase does not change the game, the result of an advance
+ * call does not depend on the number of workers, i.e. a game with 1 worker
+ * behaves exactly like a game with 8 workers.
+ *
+ * With a worker count of 1 no threads are created at all and @ref run simply
+ * calls the job in the main thread.
+ **/
+class BoAdvanceWorkerPool
+{
+public:
+	BoAdvanceWorkerPool();
+	~BoAdvanceWorkerPool();
+
+	/**
+	 * Set the number of threads that work on a job, including the main
+	 * thread. The default is 1, i.e. no additional threads.
+	 **/
+	void setWorkerCount(unsigned int count);
+	unsigned int workerCount() const;
+
+	/**
+	 * Set the number of indices a thread takes from a job at once. The
+	 * default is optimized for many small calls (such as one call per
+	 * item). Use 1 for jobs that consist of few, but long calls.
+	 **/
+	void setChunkSize(unsigned int size);
+	unsigned int chunkSize() const;
+
+	/**
+	 * Call @ref BoAdvanceJob::compute for all indices 0..count-1 and
+	 * return once all calls are completed. The main thread works on the
+	 * job as well.
+	 **/
+	void run(BoAdvanceJob* job, unsigned int count);
+
+	/**
+	 * Start calling @ref BoAdvanceJob::compute for all indices
+	 * 0..count-1 in the worker threads and return immediately, i.e. the
+	 * main thread can do something else in the meantime. Call @ref wait
+	 * before the results of the job are used.
+	 *
+	 * Only one job can be running at a time. If a job has been started
+	 * already, it is completed first.
+	 *
+	 * With a worker count of 1 the job is not computed before @ref wait is
+	 * called.
+	 **/
+	void start(BoAdvanceJob* job, unsigned int count);
+
+	/**
+	 * Work on the job that was started by @ref start in the main thread
+	 * as well and return once all calls of the job are completed. Does
+	 * nothing if no job is running.
+	 **/
+	void wait();
+
+	/**
+	 * @return TRUE if a job has been started by @ref start and @ref wait
+	 * has not yet been called.
+	 **/
+	bool isRunning() const;
+
+protected:
+	friend class BoAdvanceWorkerThread;
+
+	/**
+	 * Process chunks of the current job until no chunks are left.
+	 **/
+	void processChunks();
+
+	/**
+	 * Main loop of a worker thread.
+	 * @param generation The job generation at the time the thread was
+	 * created. The thread starts working once a job with a higher
+	 * generation gets started.
+	 **/
+	void workerLoop(unsigned int generation);
+
+	void stopWorkers();
+
+private:
+	BoAdvanceWorkerPoolPrivate* d;
+};
+
+#endif
+
@@ -0,0 +1,895 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "bobinarysavegame.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "bosonmessage.h"
+#include "bosonpropertyxml.h"
+#include "../math/bofixed.h"
+#include "bodebug.h"
+
+#include <kgame/kgameproperty.h>
+#include <kgame/kgamepropertyhandler.h>
+
+#include <qdom.h>
+#include <qbuffer.h>
+#include <qdatastream.h>
+#include <qintdict.h>
+#include <qmap.h>
+#include <qstringlist.h>
+#include <qvaluevector.h>
+
+// 4 bytes tag, 2 bytes version, 4 bytes length
+#define CHUNK_HEADER_SIZE 10
+
+// elements in savegames are not nested very deep. this limit protects us from
+// corrupted files only.
+#define MAX_ELEMENT_DEPTH 64
+
+enum ValueType {
+	ValueString = 0,
+	ValueInt = 1
+};
+
+enum NodeType {
+	NodeElement = 0,
+	NodeText = 1,
+	NodeCDATA = 2
+};
+
+// the value of a property. types that are not listed here are stored as
+// strings (see BosonCustomPropertyXML)
+enum PropertyType {
+	PropertyEnd = 0,
+	PropertyString = 1,
+	PropertyInt = 2,
+	PropertyUInt = 3,
+	PropertyFixed = 4,
+	PropertyInt8 = 5,
+	PropertyUInt8 = 6
+};
+
+enum PropertyHandlerMarker {
+	PropertyHandlerEnd = 0,
+	PropertyHandlerNext = 1
+};
+
+static void writeString(QDataStream& stream, const QString& string)
+{
+ QCString utf8 = string.utf8();
+ BosonMessage::saveVarUInt(stream, utf8.length());
+ stream.writeRawBytes(utf8.data(), utf8.length());
+}
+
+static bool readString(QDataStream& stream, QString* string)
+{
+ Q_UINT32 length = BosonMessage::loadVarUInt(stream);
+ QIODevice* device = stream.device();
+ if (device->at() + length > device->size()) {
+	boError() << k_funcinfo << "invalid string length " << length << endl;
+	return false;
+ }
+ QCString utf8(length + 1);
+ stream.readRawBytes(utf8.data(), length);
+ *string = QString::fromUtf8(utf8.data(), length);
+ return true;
+}
+
+
+bool BoBinarySaveGame::isItemPropertyHandler(const QDomElement& element)
+{
+ return (element.tagName() == QString::fromLatin1("DataHandler") ||
+		element.tagName() == QString::fromLatin1("WeaponDataHandler"));
+}
+
+bool BoBinarySaveGame::isBinary(const QByteArray& data)
+{
+ if (data.size() < 4) {
+	return false;
+ }
+ QDataStream stream(data, IO_ReadOnly);
+ Q_UINT32 magic;
+ stream >> magic;
+ return (magic == Magic);
+}
+
+QByteArray BoBinarySaveGame::convertCanvasXMLToBinary(const QByteArray& xml)
+{
+ QDomDocument doc(QString::fromLatin1("Canvas"));
+ QString errorMsg;
+ int lineNo, columnNo;
+ if (!doc.setContent(QString(xml), &errorMsg, &lineNo, &columnNo)) {
+	boError() << k_funcinfo << "Parse error in line " << lineNo << ",column " << columnNo
+			<< " error message: " << errorMsg << endl;
+	return QByteArray();
+ }
+ QDomElement root = doc.documentElement();
+
+ QByteArray data;
+ QBuffer buffer(data);
+ buffer.open(IO_WriteOnly);
+ BoBinarySaveGameWriter writer(&buffer);
+ writer.writeFileHeader();
+
+ // the root element without the children
+ writer.writeElement(writer.beginChunk(ChunkCanvas, 1), root.cloneNode(false).toElement());
+ writer.endChunk();
+
+ for (QDomNode n = root.firstChild(); !n.isNull(); n = n.nextSibling()) {
+	QDomElement e = n.toElement();
+	if (e.isNull()) {
+		continue;
+	}
+	if (e.tagName() != QString::fromLatin1("Items")) {
+		writer.writeElement(writer.beginChunk(ChunkElement, 1), e);
+		writer.endChunk();
+		continue;
+	}
+	bool ok = false;
+	unsigned int owner = e.attribute(QString::fromLatin1("PlayerId")).toUInt(&ok);
+	if (!ok) {
+		boError() << k_funcinfo << "invalid PlayerId of Items tag" << endl;
+		return QByteArray();
+	}
+	writer.writeElement(writer.beginChunk(ChunkItems, 1), e.cloneNode(false).toElement());
+	writer.endChunk();
+	for (QDomNode n2 = e.firstChild(); !n2.isNull(); n2 = n2.nextSibling()) {
+		QDomElement item = n2.toElement();
+		if (item.isNull()) {
+			continue;
+		}
+		QDataStream& stream = writer.beginChunk(ChunkItem, 2);
+		BosonMessage::saveVarUInt(stream, owner);
+		writer.writeElement(stream, item.cloneNode(false).toElement());
+		QDomElement children = doc.createElement(QString::fromLatin1("Item"));
+		for (QDomNode n3 = item.firstChild(); !n3.isNull(); n3 = n3.nextSibling()) {
+			QDomElement child = n3.toElement();
+			if (!child.isNull() && isItemPropertyHandler(child)) {
+				writer.writePropertyHandler(stream, child);
+				children.appendChild(doc.createElement(child.tagName()));
+			} else {
+				children.appendChild(n3.cloneNode(true));
+			}
+		}
+		writer.endPropertyHandlers(stream);
+		writer.writeElement(stream, children);
+		writer.endChunk();
+	}
+ }
+ if (!writer.finish()) {
+	return QByteArray();
+ }
+ buffer.close();
+ return data;
+}
+
+QByteArray BoBinarySaveGame::convertCanvasBinaryToXML(const QByteArray& data)
+{
+ BoBinarySaveGameReader reader(data);
+ if (!reader.open()) {
+	boError() << k_funcinfo << "not a valid binary canvas file" << endl;
+	return QByteArray();
+ }
+ QDomDocument doc(QString::fromLatin1("Canvas"));
+ QDomElement root;
+ QMap<unsigned int, QDomElement> owner2Items;
+ for (unsigned int i = 0; i < reader.chunkCount(); i++) {
+	Q_UINT32 tag = reader.chunkTag(i);
+	if (tag == ChunkNames) {
+		continue;
+	}
+	if (tag != ChunkCanvas && tag != ChunkItems && tag != ChunkItem && tag != ChunkElement) {
+		boWarning() << k_funcinfo << "ignoring unknown chunk " << tag << endl;
+		continue;
+	}
+	Q_UINT16 version = (tag == ChunkItem) ? 2 : 1;
+	if (reader.chunkVersion(i) != version) {
+		boError() << k_funcinfo << "chunk " << i << " has unsupported version " << reader.chunkVersion(i) << endl;
+		return QByteArray();
+	}
+	if (tag != ChunkCanvas && root.isNull()) {
+		boError() << k_funcinfo << "first chunk must be the canvas chunk" << endl;
+		return QByteArray();
+	}
+	QDataStream& stream = reader.chunkStream(i);
+	unsigned int owner = 0;
+	if (tag == ChunkItem) {
+		owner = BosonMessage::loadVarUInt(stream);
+	}
+	QDomElement e = reader.readElement(stream, doc);
+	if (!e.isNull() && tag == ChunkItem) {
+		QValueList<QDomElement> handlers;
+		QString name;
+		bool ok = reader.readPropertyHandlerName(stream, &name);
+		while (ok && !name.isNull()) {
+			QDomElement handler = doc.createElement(name);
+			ok = reader.readPropertyHandler(stream, handler);
+			handlers.append(handler);
+			if (ok) {
+				ok = reader.readPropertyHandlerName(stream, &name);
+			}
+		}
+		QDomElement children;
+		if (ok) {
+			children = reader.readElement(stream, doc);
+		}
+		if (children.isNull()) {
+			e = QDomElement();
+		} else {
+			// replace the empty handler elements by the handlers
+			for (QValueList<QDomElement>::iterator it = handlers.begin(); it != handlers.end(); ++it) {
+				QDomNode old = children.namedItem((*it).tagName());
+				if (old.isNull()) {
+					children.appendChild(*it);
+				} else {
+					children.replaceChild(*it, old);
+				}
+			}
+			while (!children.firstChild().isNull()) {
+				e.appendChild(children.firstChild());
+			}
+		}
+	}
+	if (e.isNull() || !reader.isInChunk(i)) {
+		boError() << k_funcinfo << "invalid chunk " << i << endl;
+		return QByteArray();
+	}
+	switch (tag) {
+		case ChunkCanvas:
+			if (!root.isNull()) {
+				boError() << k_funcinfo << "more than one canvas chunk" << endl;
+				return QByteArray();
+			}
+			root = e;
+			doc.appendChild(root);
+			break;
+		case ChunkItems:
+			root.appendChild(e);
+			owner2Items.insert(e.attribute(QString::fromLatin1("PlayerId")).toUInt(), e);
+			break;
+		case ChunkItem:
+			if (!owner2Items.contains(owner)) {
+				boError() << k_funcinfo << "no Items chunk for player " << owner << endl;
+				return QByteArray();
+			}
+			owner2Items[owner].appendChild(e);
+			break;
+		default:
+			root.appendChild(e);
+			break;
+	}
+ }
+ if (root.isNull()) {
+	boError() << k_funcinfo << "no canvas chunk found" << endl;
+	return QByteArray();
+ }
+ return doc.toCString();
+}
+
+
+class BoBinarySaveGameWriterPrivate
+{
+public:
+	BoBinarySaveGameWriterPrivate()
+	{
+		mDevice = 0;
+		mChunkStart = -1;
+	}
+	QIODevice* mDevice;
+	QDataStream mStream;
+	int mChunkStart;
+
+	QMap<QString, Q_UINT32> mNameIds;
+	QStringList mNames;
+};
+
+BoBinarySaveGameWriter::BoBinarySaveGameWriter(QIODevice* device)
+{
+ d = new BoBinarySaveGameWriterPrivate;
+ d->mDevice = device;
+ d->mStream.setDevice(device);
+}
+
+BoBinarySaveGameWriter::~BoBinarySaveGameWriter()
+{
+ if (d->mChunkStart >= 0) {
+	boWarning() << k_funcinfo << "chunk has not been completed" << endl;
+ }
+ d->mStream.unsetDevice();
+ delete d;
+}
+
+void BoBinarySaveGameWriter::writeFileHeader()
+{
+ d->mStream << (Q_UINT32)BoBinarySaveGame::Magic;
+ d->mStream << (Q_UINT32)BoBinarySaveGame::FormatVersion;
+}
+
+QDataStream& BoBinarySaveGameWriter::beginChunk(Q_UINT32 tag, Q_UINT16 version)
+{
+ if (d->mChunkStart >= 0) {
+	boError() << k_funcinfo << "previous chunk has not been completed" << endl;
+	endChunk();
+ }
+ d->mChunkStart = d->mDevice->at();
+ d->mStream << tag;
+ d->mStream << version;
+ d->mStream << (Q_UINT32)0; // length. written by endChunk()
+ return d->mStream;
+}
+
+bool BoBinarySaveGameWriter::endChunk()
+{
+ if (d->mChunkStart < 0) {
+	boError() << k_funcinfo << "no chunk started" << endl;
+	return false;
+ }
+ int end = d->mDevice->at();
+ Q_UINT32 length = end - d->mChunkStart - CHUNK_HEADER_SIZE;
+ if (!d->mDevice->at(d->mChunkStart + 6)) {
+	boError() << k_funcinfo << "device does not support seeking" << endl;
+	d->mChunkStart = -1;
+	return false;
+ }
+ d->mStream << length;
+ d->mDevice->at(end);
+ d->mChunkStart = -1;
+ return true;
+}
+
+Q_UINT32 BoBinarySaveGameWriter::nameId(const QString& name)
+{
+ QMap<QString, Q_UINT32>::const_iterator it = d->mNameIds.find(name);
+ if (it != d->mNameIds.end()) {
+	return it.data();
+ }
+ Q_UINT32 id = d->mNames.count();
+ d->mNames.append(name);
+ d->mNameIds.insert(name, id);
+ return id;
+}
+
+void BoBinarySaveGameWriter::writeValue(QDataStream& stream, const QString& value)
+{
+ // most values in a savegame (IDs, property values, ...) are integers.
+ // note that we may store a value as integer only if converting it back
+ // results in exactly the same string.
+ bool ok = false;
+ int v = value.toInt(&ok);
+ if (ok && QString::number(v) == value) {
+	stream << (Q_UINT8)ValueInt;
+	BosonMessage::saveVarInt(stream, v);
+	return;
+ }
+ stream << (Q_UINT8)ValueString;
+ writeString(stream, value);
+}
+
+void BoBinarySaveGameWriter::writeElement(QDataStream& stream, const QDomElement& element)
+{
+ BosonMessage::saveVarUInt(stream, nameId(element.tagName()));
+
+ QDomNamedNodeMap attributes = element.attributes();
+ BosonMessage::saveVarUInt(stream, attributes.count());
+ for (unsigned int i = 0; i < attributes.count(); i++) {
+	QDomAttr a = attributes.item(i).toAttr();
+	BosonMessage::saveVarUInt(stream, nameId(a.name()));
+	writeValue(stream, a.value());
+ }
+
+ unsigned int count = 0;
+ for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling()) {
+	if (n.isElement() || n.isText()) { // note: CDATA sections are text nodes, too
+		count++;
+	}
+ }
+ BosonMessage::saveVarUInt(stream, count);
+ for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling()) {
+	if (n.isElement()) {
+		stream << (Q_UINT8)NodeElement;
+		writeElement(stream, n.toElement());
+	} else if (n.isCDATASection()) {
+		stream << (Q_UINT8)NodeCDATA;
+		writeString(stream, n.toCDATASection().data());
+	} else if (n.isText()) {
+		stream << (Q_UINT8)NodeText;
+		writeValue(stream, n.toText().data());
+	}
+ }
+}
+
+void BoBinarySaveGameWriter::writePropertyHandler(QDataStream& stream, const QString& name, const KGamePropertyHandler* handler)
+{
+ stream << (Q_UINT8)PropertyHandlerNext;
+ BosonMessage::saveVarUInt(stream, nameId(name));
+ if (!handler) {
+	BO_NULL_ERROR(handler);
+	stream << (Q_UINT8)PropertyEnd;
+	return;
+ }
+ BosonCustomPropertyXML propertyXML;
+ QIntDictIterator<KGamePropertyBase> it(handler->dict());
+ for (; it.current(); ++it) {
+	KGamePropertyBase* prop = it.current();
+	const type_info* t = prop->typeinfo();
+	if (*t == typeid(int)) {
+		stream << (Q_UINT8)PropertyInt;
+		BosonMessage::saveVarInt(stream, prop->id());
+		BosonMessage::saveVarInt(stream, ((KGameProperty<int>*)prop)->value());
+	} else if (*t == typeid(unsigned int)) {
+		stream << (Q_UINT8)PropertyUInt;
+		BosonMessage::saveVarInt(stream, prop->id());
+		BosonMessage::saveVarUInt(stream, ((KGameProperty<unsigned int>*)prop)->value());
+	} else if (*t == typeid(bofixed)) {
+		stream << (Q_UINT8)PropertyFixed;
+		BosonMessage::saveVarInt(stream, prop->id());
+		stream << (Q_INT32)((KGameProperty<bofixed>*)prop)->value().rawInt();
+	} else if (*t == typeid(Q_INT8)) {
+		stream << (Q_UINT8)PropertyInt8;
+		BosonMessage::saveVarInt(stream, prop->id());
+		stream << (Q_INT8)((KGameProperty<Q_INT8>*)prop)->value();
+	} else if (*t == typeid(Q_UINT8)) {
+		stream << (Q_UINT8)PropertyUInt8;
+		BosonMessage::saveVarInt(stream, prop->id());
+		stream << (Q_UINT8)((KGameProperty<Q_UINT8>*)prop)->value();
+	} else {
+		QString value = propertyXML.propertyValue(prop);
+		if (value.isNull()) {
+			boWarning() << k_funcinfo << "invalid null value for " << prop->id() << endl;
+			continue;
+		}
+		stream << (Q_UINT8)PropertyString;
+		BosonMessage::saveVarInt(stream, prop->id());
+		writeString(stream, value);
+	}
+ }
+ stream << (Q_UINT8)PropertyEnd;
+}
+
+void BoBinarySaveGameWriter::writePropertyHandler(QDataStream& stream, const QDomElement& handler)
+{
+ stream << (Q_UINT8)PropertyHandlerNext;
+ BosonMessage::saveVarUInt(stream, nameId(handler.tagName()));
+ QDomNodeList list = handler.elementsByTagName(QString::fromLatin1("KGameProperty"));
+ for (unsigned int i = 0; i < list.count(); i++) {
+	QDomElement e = list.item(i).toElement();
+	bool ok = false;
+	int id = e.attribute(QString::fromLatin1("Id")).toInt(&ok);
+	if (!ok) {
+		boError() << k_funcinfo << "attribute Id is not a valid number: " << e.attribute(QString::fromLatin1("Id")) << endl;
+		continue;
+	}
+	stream << (Q_UINT8)PropertyString;
+	BosonMessage::saveVarInt(stream, id);
+	writeString(stream, e.text());
+ }
+ stream << (Q_UINT8)PropertyEnd;
+}
+
+void BoBinarySaveGameWriter::endPropertyHandlers(QDataStream& stream)
+{
+ stream << (Q_UINT8)PropertyHandlerEnd;
+}
+
+bool BoBinarySaveGameWriter::finish()
+{
+ QDataStream& stream = beginChunk(BoBinarySaveGame::ChunkNames, 1);
+ BosonMessage::saveVarUInt(stream, d->mNames.count());
+ for (QStringList::const_iterator it = d->mNames.begin(); it != d->mNames.end(); ++it) {
+	writeString(stream, *it);
+ }
+ return endChunk();
+}
+
+
+class BoBinarySaveGameChunk
+{
+public:
+	BoBinarySaveGameChunk()
+	{
+		mTag = 0;
+		mVersion = 0;
+		mOffset = 0;
+		mLength = 0;
+	}
+	Q_UINT32 mTag;
+	Q_UINT16 mVersion;
+	Q_UINT32 mOffset; // offset of the payload
+	Q_UINT32 mLength;
+};
+
+class BoBinarySaveGameReaderPrivate
+{
+public:
+	BoBinarySaveGameReaderPrivate()
+	{
+	}
+	QByteArray mData;
+	QBuffer mBuffer;
+	QDataStream mStream;
+
+	QValueVector<BoBinarySaveGameChunk> mChunks;
+	QValueVector<QString> mNames;
+};
+
+BoBinarySaveGameReader::BoBinarySaveGameReader(const QByteArray& data)
+{
+ d = new BoBinarySaveGameReaderPrivate;
+ d->mData = data;
+ d->mBuffer.setBuffer(d->mData);
+ d->mBuffer.open(IO_ReadOnly);
+ d->mStream.setDevice(&d->mBuffer);
+}
+
+BoBinarySaveGameReader::~BoBinarySaveGameReader()
+{
+ d->mStream.unsetDevice();
+ d->mBuffer.close();
+ delete d;
+}
+
+bool BoBinarySaveGameReader::open()
+{
+ d->mChunks.clear();
+ d->mNames.clear();
+ const Q_UINT32 size = d->mData.size();
+ if (size < 8) {
+	boError() << k_funcinfo << "file too small" << endl;
+	return false;
+ }
+ d->mBuffer.at(0);
+ Q_UINT32 magic;
+ Q_UINT32 version;
+ d->mStream >> magic;
+ d->mStream >> version;
+ if (magic != BoBinarySaveGame::Magic) {
+	boError() << k_funcinfo << "not a binary savegame file" << endl;
+	return false;
+ }
+ if (version > BoBinarySaveGame::FormatVersion) {
+	boError() << k_funcinfo << "file format version " << version << " is not supported" << endl;
+	return false;
+ }
+
+ // read the chunk headers only. the payload is read on demand.
+ int names = -1;
+ Q_UINT32 pos = 8;
+ while (pos < size) {
+	if (pos + CHUNK_HEADER_SIZE > size) {
+		boError() << k_funcinfo << "truncated chunk header at " << pos << endl;
+		return false;
+	}
+	d->mBuffer.at(pos);
+	BoBinarySaveGameChunk chunk;
+	d->mStream >> chunk.mTag;
+	d->mStream >> chunk.mVersion;
+	d->mStream >> chunk.mLength;
+	chunk.mOffset = pos + CHUNK_HEADER_SIZE;
+	if (chunk.mLength > size - chunk.mOffset) {
+		boError() << k_funcinfo << "truncated chunk at " << pos << endl;
+		return false;
+	}
+	if (chunk.mTag == BoBinarySaveGame::ChunkNames) {
+		names = d->mChunks.count();
+	}
+	d->mChunks.append(chunk);
+	pos = chunk.mOffset + chunk.mLength;
+ }
+ if (names < 0) {
+	boError() << k_funcinfo << "no name table found" << endl;
+	return false;
+ }
+
+ QDataStream& stream = chunkStream(names);
+ Q_UINT32 count = BosonMessage::loadVarUInt(stream);
+ if (count > chunkLength(names)) {
+	boError() << k_funcinfo << "invalid name count " << count << endl;
+	return false;
+ }
+ d->mNames.resize(count);
+ for (Q_UINT32 i = 0; i < count; i++) {
+	if (!readString(stream, &d->mNames[i])) {
+		return false;
+	}
+ }
+ if (!isInChunk(names)) {
+	boError() << k_funcinfo << "invalid name table" << endl;
+	return false;
+ }
+ return true;
+}
+
+unsigned int BoBinarySaveGameReader::chunkCount() const
+{
+ return d->mChunks.count();
+}
+
+Q_UINT32 BoBinarySaveGameReader::chunkTag(unsigned int chunk) const
+{
+ return d->mChunks[chunk].mTag;
+}
+
+Q_UINT16 BoBinarySaveGameReader::chunkVersion(unsigned int chunk) const
+{
+ return d->mChunks[chunk].mVersion;
+}
+
+Q_UINT32 BoBinarySaveGameReader::chunkLength(unsigned int chunk) const
+{
+ return d->mChunks[chunk].mLength;
+}
+
+QDataStream& BoBinarySaveGameReader::chunkStream(unsigned int chunk)
+{
+ d->mBuffer.at(d->mChunks[chunk].mOffset);
+ return d->mStream;
+}
+
+bool BoBinarySaveGameReader::isInChunk(unsigned int chunk) const
+{
+ const BoBinarySaveGameChunk& c = d->mChunks[chunk];
+ return (d->mBuffer.at() <= c.mOffset + c.mLength);
+}
+
+bool BoBinarySaveGameReader::readName(QDataStream& stream, QString* name)
+{
+ Q_UINT32 id = BosonMessage::loadVarUInt(stream);
+ if (id >= d->mNames.count()) {
+	boError() << k_funcinfo << "invalid name id " << id << endl;
+	return false;
+ }
+ *name = d->mNames[id];
+ return true;
+}
+
+bool BoBinarySaveGameReader::readValue(QDataStream& stream, QString* value)
+{
+ Q_UINT8 type;
+ stream >> type;
+ switch (type) {
+	case ValueInt:
+		*value = QString::number(BosonMessage::loadVarInt(stream));
+		return true;
+	case ValueString:
+		return readString(stream, value);
+	default:
+		break;
+ }
+ boError() << k_funcinfo << "invalid value type " << (int)type << endl;
+ return false;
+}
+
+QDomElement BoBinarySaveGameReader::readElement(QDataStream& stream, QDomDocument& doc)
+{
+ return readElement(stream, doc, 0);
+}
+
+QDomElement BoBinarySaveGameReader::readElement(QDataStream& stream, QDomDocument& doc, unsigned int depth)
+{
+ if (depth > MAX_ELEMENT_DEPTH) {
+	boError() << k_funcinfo << "elements nested too deep" << endl;
+	return QDomElement();
+ }
+ QString name;
+ if (!readName(stream, &name)) {
+	return QDomElement();
+ }
+ QDomElement element = doc.createElement(name);
+
+ Q_UINT32 attributes = BosonMessage::loadVarUInt(stream);
+ for (Q_UINT32 i = 0; i < attributes; i++) {
+	QString value;
+	if (!readName(stream, &name) || !readValue(stream, &value)) {
+		return QDomElement();
+	}
+	element.setAttribute(name, value);
+ }
+
+ Q_UINT32 children = BosonMessage::loadVarUInt(stream);
+ for (Q_UINT32 i = 0; i < children; i++) {
+	if (d->mBuffer.atEnd()) {
+		boError() << k_funcinfo << "unexpected end of file" << endl;
+		return QDomElement();
+	}
+	Q_UINT8 type;
+	stream >> type;
+	QString text;
+	switch (type) {
+		case NodeElement:
+		{
+			QDomElement child = readElement(stream, doc, depth + 1);
+			if (child.isNull()) {
+				return QDomElement();
+			}
+			element.appendChild(child);
+			break;
+		}
+		case NodeText:
+			if (!readValue(stream, &text)) {
+				return QDomElement();
+			}
+			element.appendChild(doc.createTextNode(text));
+			break;
+		case NodeCDATA:
+			if (!readString(stream, &text)) {
+				return QDomElement();
+			}
+			element.appendChild(doc.createCDATASection(text));
+			break;
+		default:
+			boError() << k_funcinfo << "invalid node type " << (int)type << endl;
+			return QDomElement();
+	}
+ }
+ return element;
+}
+
+bool BoBinarySaveGameReader::readPropertyHandlerName(QDataStream& stream, QString* name)
+{
+ if (d->mBuffer.atEnd()) {
+	boError() << k_funcinfo << "unexpected end of file" << endl;
+	return false;
+ }
+ Q_UINT8 marker;
+ stream >> marker;
+ switch (marker) {
+	case PropertyHandlerEnd:
+		*name = QString::null;
+		return true;
+	case PropertyHandlerNext:
+		return readName(stream, name);
+	default:
+		break;
+ }
+ boError() << k_funcinfo << "invalid property handler marker " << (int)marker << endl;
+ return false;
+}
+
+bool BoBinarySaveGameReader::readPropertyHandler(QDataStream& stream, KGamePropertyHandler* handler)
+{
+ if (handler) {
+	handler->blockSignals(true);
+ }
+ bool ret = readPropertyHandler(stream, handler, 0);
+ if (handler) {
+	handler->blockSignals(false);
+ }
+ return ret;
+}
+
+bool BoBinarySaveGameReader::readPropertyHandler(QDataStream& stream, QDomElement& element)
+{
+ return readPropertyHandler(stream, 0, &element);
+}
+
+bool BoBinarySaveGameReader::readPropertyHandler(QDataStream& stream, KGamePropertyHandler* handler, QDomElement* element)
+{
+ BosonCustomPropertyXML propertyXML;
+ while (true) {
+	if (d->mBuffer.atEnd()) {
+		boError() << k_funcinfo << "unexpected end of file" << endl;
+		return false;
+	}
+	Q_UINT8 type;
+	stream >> type;
+	if (type == PropertyEnd) {
+		return true;
+	}
+	int id = BosonMessage::loadVarInt(stream);
+	KGamePropertyBase* prop = 0;
+	if (handler) {
+		prop = handler->find(id);
+		if (!prop) {
+			boError() << k_funcinfo << "Can't find property " << id << " in datahandler " << handler->id() << endl;
+		}
+	}
+	const type_info* t = prop ? prop->typeinfo() : 0;
+
+	// values of the matching type are set directly, otherwise we need the
+	// string (for the element or for converting the value)
+	QString value;
+	switch (type) {
+		case PropertyString:
+			if (!readString(stream, &value)) {
+				return false;
+			}
+			break;
+		case PropertyInt:
+		{
+			int v = BosonMessage::loadVarInt(stream);
+			if (t && *t == typeid(int)) {
+				((KGameProperty<int>*)prop)->setValue(v);
+				prop = 0;
+			} else {
+				value = QString::number(v);
+			}
+			break;
+		}
+		case PropertyUInt:
+		{
+			unsigned int v = BosonMessage::loadVarUInt(stream);
+			if (t && *t == typeid(unsigned int)) {
+				((KGameProperty<unsigned int>*)prop)->setValue(v);
+				prop = 0;
+			} else {
+				value = QString::number(v);
+			}
+			break;
+		}
+		case PropertyFixed:
+		{
+			Q_INT32 raw;
+			stream >> raw;
+			bofixed v;
+			v.setFromRawInt(raw);
+			if (t && *t == typeid(bofixed)) {
+				((KGameProperty<bofixed>*)prop)->setValue(v);
+				prop = 0;
+			} else {
+				value = QString::number(v);
+			}
+			break;
+		}
+		case PropertyInt8:
+		{
+			Q_INT8 v;
+			stream >> v;
+			if (t && *t == typeid(Q_INT8)) {
+				((KGameProperty<Q_INT8>*)prop)->setValue(v);
+				prop = 0;
+			} else {
+				value = QString::number(v);
+			}
+			break;
+		}
+		case PropertyUInt8:
+		{
+			Q_UINT8 v;
+			stream >> v;
+			if (t && *t == typeid(Q_UINT8)) {
+				((KGameProperty<Q_UINT8>*)prop)->setValue(v);
+				prop = 0;
+			} else {
+				value = QString::number(v);
+			}
+			break;
+		}
+		default:
+			boError() << k_funcinfo << "invalid property type " << (int)type << endl;
+			return false;
+	}
+	if (element) {
+		QDomDocument doc = element->ownerDocument();
+		QDomElement e = doc.createElement(QString::fromLatin1("KGameProperty"));
+		e.setAttribute(QString::fromLatin1("Id"), id);
+		e.appendChild(doc.createTextNode(value));
+		element->appendChild(e);
+	}
+	if (prop) {
+		if (value.isEmpty()) {
+			boError() << k_funcinfo << "empty value for property " << id << endl;
+			continue;
+		}
+		propertyXML.propertySetValue(prop, value);
+	}
+ }
+ return false;
+}
+
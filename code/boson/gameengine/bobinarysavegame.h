@@ -0,0 +1,302 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOBINARYSAVEGAME_H
+#define BOBINARYSAVEGAME_H
+
+#include <qglobal.h>
+#include <qcstring.h>
+
+class QIODevice;
+class QDataStream;
+class QDomDocument;
+class QDomElement;
+class QString;
+class KGamePropertyHandler;
+
+class BoBinarySaveGameWriterPrivate;
+class BoBinarySaveGameReaderPrivate;
+
+/**
+ * Tags and helpers for the binary savegame format.
+ *
+ * A binary file starts with @ref Magic and @ref FormatVersion (both 32 bit),
+ * followed by a list of chunks. Every chunk consists of
+ * @li A 32 bit tag (see @ref ChunkTag) that identifies the chunk
+ * @li A 16 bit version of the chunk format
+ * @li The 32 bit length of the payload (in bytes)
+ * @li The payload
+ *
+ * Unknown chunks can be skipped using the length, so new chunks can be added
+ * without breaking old files.
+ *
+ * The payload of most chunks are @ref QDomElement objects in a compact binary
+ * encoding (see @ref BoBinarySaveGameWriter::writeElement), i.e. the binary
+ * format contains exactly the data of the XML format, but it can be written
+ * and read without serializing the whole document to text and without parsing
+ * it again. Element and attribute names are stored in a name table (the @ref
+ * ChunkNames chunk at the end of the file) and are referenced by their index,
+ * integer values are stored as variable length integers.
+ *
+ * Currently only the canvas (i.e. the items, which make up most of a
+ * savegame) is stored in binary format ("canvas.bin" instead of
+ * "canvas.xml"):
+ * @li @ref ChunkCanvas: the root element (without children)
+ * @li @ref ChunkItems: an "Items" element of a player (without children)
+ * @li @ref ChunkItem: the owner ID and an "Item" element, see below
+ * @li @ref ChunkElement: any other child element of the root element
+ *
+ * The properties of an item (its "DataHandler" and "WeaponDataHandler"
+ * elements) are not stored as elements, as they make up most of the data of an
+ * item. Instead they are written directly from the @ref KGamePropertyHandler
+ * to the stream (see @ref BoBinarySaveGameWriter::writePropertyHandler). An
+ * item chunk (version 2) contains
+ * @li The owner ID
+ * @li The "Item" element with the attributes only
+ * @li The property handlers of the item
+ * @li An "Item" element with the children only. The property handlers are
+ * empty elements here, i.e. they only mark the position of the handler.
+ *
+ * This way the item can be created and its properties can be loaded without
+ * decoding the children, which are decoded only when the item gets loaded.
+ *
+ * See @ref convertCanvasXMLToBinary and @ref convertCanvasBinaryToXML for
+ * conversion between both formats. The files of older Boson versions are
+ * always XML files, see @ref BosonPlayFieldConverter.
+ **/
+class BoBinarySaveGame
+{
+public:
+	enum ChunkTag {
+		ChunkCanvas = 0x434e5653, // "CNVS"
+		ChunkItems = 0x49544d53, // "ITMS"
+		ChunkItem = 0x4954454d, // "ITEM"
+		ChunkElement = 0x454c454d, // "ELEM"
+		ChunkNames = 0x4e414d45 // "NAME"
+	};
+
+	enum {
+		Magic = 0x424f5342, // "BOSB"
+		FormatVersion = 1
+	};
+
+	/**
+	 * @return TRUE if @p data starts with the @ref Magic of a binary file.
+	 **/
+	static bool isBinary(const QByteArray& data);
+
+	/**
+	 * @return TRUE if @p element is a property handler of an item (such as
+	 * the "DataHandler" element). See @ref ChunkItem.
+	 **/
+	static bool isItemPropertyHandler(const QDomElement& element);
+
+	/**
+	 * Convert the canvas.xml file @p xml into the binary format.
+	 * @return The binary file or a null array if an error occured.
+	 **/
+	static QByteArray convertCanvasXMLToBinary(const QByteArray& xml);
+
+	/**
+	 * Convert the binary canvas file @p data (canvas.bin) back to XML. The
+	 * result is equal to the XML file the binary file was created from
+	 * (except for whitespace and the order of attributes).
+	 * @return The XML file or a null array if an error occured.
+	 **/
+	static QByteArray convertCanvasBinaryToXML(const QByteArray& data);
+};
+
+/**
+ * Writes a binary savegame file (see @ref BoBinarySaveGame) to a @ref
+ * QIODevice. The data is written directly to the device, so a caller can
+ * save one object at a time, instead of building a complete document first.
+ *
+ * Usage:
+ * <pre>
+ * BoBinarySaveGameWriter writer(&device);
+ * writer.writeFileHeader();
+ * QDataStream& stream = writer.beginChunk(BoBinarySaveGame::ChunkItem, 1);
+ * writer.writeElement(stream, element);
+ * writer.endChunk();
+ * // ...
+ * writer.finish();
+ * </pre>
+ **/
+class BoBinarySaveGameWriter
+{
+public:
+	/**
+	 * @param device An opened device. The device must support
+	 * QIODevice::at(), as the length of a chunk is written when the chunk
+	 * is completed.
+	 **/
+	BoBinarySaveGameWriter(QIODevice* device);
+	~BoBinarySaveGameWriter();
+
+	void writeFileHeader();
+
+	/**
+	 * Start a new chunk. All data that is written to the returned stream
+	 * until @ref endChunk is called is the payload of the chunk.
+	 **/
+	QDataStream& beginChunk(Q_UINT32 tag, Q_UINT16 version);
+
+	/**
+	 * Complete the current chunk.
+	 * @return FALSE if no chunk was started or the device could not be
+	 * written.
+	 **/
+	bool endChunk();
+
+	/**
+	 * Write @p element including all of its attributes and child nodes
+	 * (elements, text and CDATA sections) to @p stream. Other nodes (such
+	 * as comments) are skipped.
+	 **/
+	void writeElement(QDataStream& stream, const QDomElement& element);
+
+	/**
+	 * Write @p value as an integer if it is a number, otherwise as a
+	 * string.
+	 **/
+	void writeValue(QDataStream& stream, const QString& value);
+
+	/**
+	 * Write all properties of @p handler to @p stream. The values are
+	 * stored in their binary representation if possible, otherwise the
+	 * string of @ref BosonCustomPropertyXML is used.
+	 *
+	 * @param name The name of the handler, as used for the element of the
+	 * handler in XML files (e.g. "DataHandler").
+	 **/
+	void writePropertyHandler(QDataStream& stream, const QString& name, const KGamePropertyHandler* handler);
+
+	/**
+	 * @overload
+	 *
+	 * Write the properties of the XML element @p handler (as created by
+	 * @ref BosonPropertyXML::saveAsXML). This is used to convert XML files.
+	 **/
+	void writePropertyHandler(QDataStream& stream, const QDomElement& handler);
+
+	/**
+	 * Mark the end of a list of property handlers (see @ref
+	 * writePropertyHandler).
+	 **/
+	void endPropertyHandlers(QDataStream& stream);
+
+	/**
+	 * Write the name table. No further chunks may be written afterwards.
+	 **/
+	bool finish();
+
+protected:
+	Q_UINT32 nameId(const QString& name);
+
+private:
+	BoBinarySaveGameWriterPrivate* d;
+};
+
+/**
+ * Reads a binary savegame file (see @ref BoBinarySaveGame).
+ *
+ * @ref open reads the chunk headers and the name table only. The payload of a
+ * chunk is not read before @ref chunkStream is called for it, so chunks that
+ * are not needed (e.g. the items of a player that is not in the game) are
+ * never decoded.
+ **/
+class BoBinarySaveGameReader
+{
+public:
+	BoBinarySaveGameReader(const QByteArray& data);
+	~BoBinarySaveGameReader();
+
+	/**
+	 * Check the file header and read the chunk headers and the name table.
+	 * @return FALSE if this is not a valid binary file.
+	 **/
+	bool open();
+
+	unsigned int chunkCount() const;
+	Q_UINT32 chunkTag(unsigned int chunk) const;
+	Q_UINT16 chunkVersion(unsigned int chunk) const;
+	Q_UINT32 chunkLength(unsigned int chunk) const;
+
+	/**
+	 * @return A stream that is positioned at the beginning of the payload
+	 * of @p chunk. The stream is shared by all chunks, i.e. it is valid
+	 * until this method is called for a different chunk.
+	 **/
+	QDataStream& chunkStream(unsigned int chunk);
+
+	/**
+	 * @return TRUE if no more than the payload of @p chunk has been read
+	 * from the stream (see @ref chunkStream) so far. Use this to check
+	 * whether a chunk was corrupted.
+	 **/
+	bool isInChunk(unsigned int chunk) const;
+
+	/**
+	 * Read an element that was written by @ref
+	 * BoBinarySaveGameWriter::writeElement. The element is created in
+	 * @p doc, but is not added to any parent.
+	 * @return The element or a null element if the data is invalid.
+	 **/
+	QDomElement readElement(QDataStream& stream, QDomDocument& doc);
+
+	bool readValue(QDataStream& stream, QString* value);
+
+	/**
+	 * Read the name of the next property handler that was written by @ref
+	 * BoBinarySaveGameWriter::writePropertyHandler. @p name is set to
+	 * QString::null if there are no more handlers (see @ref
+	 * BoBinarySaveGameWriter::endPropertyHandlers).
+	 * @return FALSE if the data is invalid.
+	 **/
+	bool readPropertyHandlerName(QDataStream& stream, QString* name);
+
+	/**
+	 * Read the properties of a property handler (see @ref
+	 * readPropertyHandlerName) into @p handler. The signals of @p handler
+	 * are blocked while loading.
+	 *
+	 * @param handler The handler that receives the properties. If NULL the
+	 * properties are skipped.
+	 * @return FALSE if the data is invalid.
+	 **/
+	bool readPropertyHandler(QDataStream& stream, KGamePropertyHandler* handler);
+
+	/**
+	 * @overload
+	 *
+	 * Append the properties to @p element, i.e. create the XML data of the
+	 * handler (see @ref BosonPropertyXML::saveAsXML).
+	 **/
+	bool readPropertyHandler(QDataStream& stream, QDomElement& element);
+
+protected:
+	bool readName(QDataStream& stream, QString* name);
+	QDomElement readElement(QDataStream& stream, QDomDocument& doc, unsigned int depth);
+	bool readPropertyHandler(QDataStream& stream, KGamePropertyHandler* handler, QDomElement* element);
+
+private:
+	BoBinarySaveGameReaderPrivate* d;
+};
+
+#endif
+
@@ -64,7 +64,7 @@ BoQuadTreeNode* BoCanvasQuadTreeNode::createNode(int l, int t, int r, int b, int
 
 void BoCanvasQuadTreeNode::cellUnitsChanged(const BosonCanvas* canvas, int x1, int y1, int x2, int y2)
 {
- if (!contains(x1, y1, x2, y2)) {
+ if (!intersects(x1, y1, x2, y2)) {
 	return;
  }
  BoQuadTreeNode* children[4];
@@ -102,7 +102,7 @@ void BoCanvasQuadTreeNode::calculateUnitMinMaxZ(const BosonCanvas* canvas)
 				mUnitMaxZ = z2;
 				firstUnit = false;
 			} else {
-				mUnitMinZ = QMAX(mUnitMinZ, z2);
+				mUnitMinZ = QMIN(mUnitMinZ, z1);
 				mUnitMaxZ = QMAX(mUnitMaxZ, z2);
 			}
 		}
@@ -118,8 +118,8 @@ void BoCanvasQuadTreeNode::calculateUnitMinMaxZ(const BosonCanvas* canvas)
  for (int i = 0; i < 4; i++) {
 	if (children[i]) {
 		if (firstChild) {
-			mUnitMinZ = ((BoCanvasQuadTreeNode*)children[0])->unitMinZ();
-			mUnitMaxZ = ((BoCanvasQuadTreeNode*)children[0])->unitMaxZ();
+			mUnitMinZ = ((BoCanvasQuadTreeNode*)children[i])->unitMinZ();
+			mUnitMaxZ = ((BoCanvasQuadTreeNode*)children[i])->unitMaxZ();
 			firstChild = false;
 		} else {
 			mUnitMinZ = QMIN(mUnitMinZ, ((BoCanvasQuadTreeNode*)children[i])->unitMinZ());
@@ -26,6 +26,13 @@ class BosonItem;
 class Unit;
 
 /**
+ * A @ref BoGroundQuadTreeNode that additionally knows about the z range of
+ * the units in this node, see @ref unitMinZ and @ref unitMaxZ. @ref minZ and
+ * @ref maxZ cover both, the ground and the units.
+ *
+ * The tree should be registered with both, @ref
+ * BosonCanvas::registerQuadTree and @ref BosonMap::registerQuadTree.
+ *
  * @author Andreas Beckermann <b_mann@gmx.de>
  **/
 class BoCanvasQuadTreeNode : public BoGroundQuadTreeNode
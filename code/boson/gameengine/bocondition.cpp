@@ -22,6 +22,7 @@
 #include "../bomemory/bodummymemory.h"
 #include "boevent.h"
 #include "boeventmatching.h"
+#include "boeventmanager.h"
 #include "boson.h" // boGame->queueEvent()
 #include "bodebug.h"
 #include "script/bosonscript.h"
@@ -165,6 +166,27 @@ void BoCondition::processEvent(const BoEvent* event)
  processEvent(event);
 }
 
+void BoCondition::eventNameIds(const BoEventManager* manager, QValueList<int>* ids) const
+{
+ BO_CHECK_NULL_RET(manager);
+ BO_CHECK_NULL_RET(ids);
+ QPtrListIterator<BoCondition> orIt(d->mAlternatives);
+ for (; orIt.current(); ++orIt) {
+	orIt.current()->eventNameIds(manager, ids);
+ }
+ QPtrListIterator<BoEventMatching> it(d->mEvents);
+ for (; it.current(); ++it) {
+	if (!it.current()->event()) {
+		continue;
+	}
+	int id = manager->eventNameId(it.current()->event()->name());
+	it.current()->setEventNameId(id);
+	if (id >= 0 && !ids->contains(id)) {
+		ids->append(id);
+	}
+ }
+}
+
 bool BoCondition::saveAsXML(QDomElement& root) const
 {
  QDomDocument doc = root.ownerDocument();
@@ -483,10 +505,10 @@ void BoConditionAction::fire()
 		boError(360) << k_funcinfo << "could not save event that is caused by condition" << endl;
 		return;
 	}
-	BoEvent* e = new BoEvent();
+	BoEvent* e = BoEvent::create(QCString());
 	if (!e->loadFromXML(root)) {
 		boError(360) << k_funcinfo << "could not load event that is caused by condition" << endl;
-		delete e;
+		BoEvent::release(e);
 		return;
 	}
 	boGame->queueEvent(e);
@@ -25,9 +25,11 @@ class QDomElement;
 class QDomNodeList;
 
 class BoEvent;
+class BoEventManager;
 class BoConditionAction;
 class BosonScript;
 template<class T1, class T2> class QMap;
+template<class T> class QValueList;
 
 class BoConditionPrivate;
 
@@ -78,6 +80,16 @@ public:
 
 	void processEvent(const BoEvent* event);
 
+	/**
+	 * Look up the names of all events of this condition (and its
+	 * alternatives) in @p manager and append their IDs (see @ref
+	 * BoEventManager::eventNameId) to @p ids.
+	 *
+	 * If nothing is appended, this condition does not wait for any events
+	 * and therefore has to be checked on every event.
+	 **/
+	void eventNameIds(const BoEventManager* manager, QValueList<int>* ids) const;
+
 	virtual bool saveAsXML(QDomElement& root) const;
 	virtual bool loadFromXML(const QDomElement& root);
 
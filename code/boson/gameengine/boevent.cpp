@@ -26,6 +26,25 @@
 #include <qdom.h>
 #include <qptrlist.h>
 #include <qmap.h>
+#include <qvaluevector.h>
+
+#include <typeinfo>
+
+// maximal number of unused events that are kept for reuse
+#define EVENT_POOL_SIZE 256
+
+class BoEventPool
+{
+public:
+	~BoEventPool()
+	{
+		for (unsigned int i = 0; i < mEvents.count(); i++) {
+			delete mEvents[i];
+		}
+	}
+	QValueVector<BoEvent*> mEvents;
+};
+static BoEventPool eventPool;
 
 BoEvent::BoEvent(const QCString& name, const QString& data1, const QString& data2)
 {
@@ -39,9 +58,35 @@ BoEvent::BoEvent()
  init(QCString());
 }
 
+BoEvent* BoEvent::create(const QCString& name, const QString& data1, const QString& data2)
+{
+ if (eventPool.mEvents.isEmpty()) {
+	return new BoEvent(name, data1, data2);
+ }
+ BoEvent* e = eventPool.mEvents.back();
+ eventPool.mEvents.pop_back();
+ e->init(name);
+ e->mData1 = data1;
+ e->mData2 = data2;
+ return e;
+}
+
+void BoEvent::release(BoEvent* event)
+{
+ if (!event) {
+	return;
+ }
+ if (eventPool.mEvents.count() >= EVENT_POOL_SIZE || typeid(*event) != typeid(BoEvent)) {
+	delete event;
+	return;
+ }
+ eventPool.mEvents.push_back(event);
+}
+
 void BoEvent::init(const QCString& name)
 {
  mName = name;
+ mNameId = -1;
  mId = 0;
  mDelayedDelivery = 0;
  mHasLocation = false;
@@ -77,6 +122,7 @@ bool BoEvent::loadFromXML(const QDomElement& root)
 {
  bool ok;
  mName = root.attribute("Name");
+ mNameId = -1;
  mId = root.attribute("Id").toULong(&ok);
  if (!ok) {
 	boError(360) << k_funcinfo << "Id is not a valid number: " << root.attribute("Id") << endl;
@@ -117,7 +163,11 @@ bool BoEvent::loadFromXML(const QDomElement& root)
 
 bool BoEvent::matches(const BoEventMatching* m, const BoEvent* e) const
 {
- if (name() != e->name()) {
+ if (nameId() >= 0 && e->nameId() >= 0) {
+	if (nameId() != e->nameId()) {
+		return false;
+	}
+ } else if (name() != e->name()) {
 	return false;
  }
  if (!m->ignoreUnitId()) {
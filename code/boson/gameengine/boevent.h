@@ -60,6 +60,26 @@ public:
 
 	virtual ~BoEvent();
 
+	/**
+	 * Like the constructor, but the event is taken from a pool of events
+	 * that have been delivered already, if possible. Use this for events
+	 * that are queued frequently.
+	 *
+	 * An event created using this method can be deleted normally, but
+	 * should be given back to the pool using @ref release instead.
+	 *
+	 * Note that the pool is not thread safe, events may be created in the
+	 * main thread only.
+	 **/
+	static BoEvent* create(const QCString& name, const QString& data1 = QString::null, const QString& data2 = QString::null);
+
+	/**
+	 * Give @p event back to the pool, see @ref create. If the pool is full
+	 * (or @p event is not a plain BoEvent object), the event is simply
+	 * deleted.
+	 **/
+	static void release(BoEvent* event);
+
 	virtual bool saveAsXML(QDomElement& root) const;
 	virtual bool loadFromXML(const QDomElement& root);
 
@@ -173,6 +193,24 @@ public:
 		return mName;
 	}
 
+	/**
+	 * Called by @ref BoEventManager::queueEvent only.
+	 **/
+	void setNameId(int id)
+	{
+		mNameId = id;
+	}
+
+	/**
+	 * @return The ID of the @ref name in the @ref BoEventManager, see @ref
+	 * BoEventManager::eventNameId, or -1 if the name has not been looked
+	 * up yet.
+	 **/
+	int nameId() const
+	{
+		return mNameId;
+	}
+
 	/**
 	 * @return Optional parameter 1. The value of this depends completely on
 	 * the event. Default is @ref QString::null
@@ -197,6 +235,7 @@ private:
 private:
 	unsigned long int mId;
 	QCString mName;
+	int mNameId;
 	unsigned long int mDelayedDelivery;
 	bool mHasLocation;
 	BoVector3Fixed mLocation;
@@ -33,12 +33,16 @@
 #include "speciestheme.h"
 #include "player.h"
 #include "bosonprofiling.h"
+#include "../bosonconfig.h"
+#include "../botraceprofiling.h"
 
 #include <klocale.h>
 
 #include <qptrlist.h>
 #include <qdom.h>
 #include <qintdict.h>
+#include <qvaluevector.h>
+#include <qvaluelist.h>
 
 
 class BoEventHandlerInfo
@@ -55,12 +59,23 @@ public:
 	BoEventListenerPrivate()
 	{
 		mScript = 0;
+		mEventIndexDirty = true;
+		mAdvanceNameId = -1;
 	}
 	QPtrList<BoCondition> mConditions;
 
 	QIntDict<BoEventHandlerInfo> mEventHandlers;
 	int mNextEventHandlerId;
 
+	// the conditions and the IDs of the event handlers that wait for an
+	// event, by the name ID of the event. see rebuildEventIndex()
+	QValueVector< QValueVector<BoCondition*> > mConditionsByEvent;
+	QValueVector< QValueVector<int> > mEventHandlersByEvent;
+	bool mEventIndexDirty;
+
+	// the name ID of the "Advance" event, see deliverToScript()
+	int mAdvanceNameId;
+
 	BosonScript* mScript;
 };
 
@@ -73,6 +88,7 @@ BoEventListener::BoEventListener(BoEventManager* manager, QObject* parent)
  d->mNextEventHandlerId = 1;
  mManager = manager;
  mManager->addEventListener(this);
+ d->mAdvanceNameId = mManager->eventNameId("Advance");
 }
 
 BoEventListener::~BoEventListener()
@@ -104,9 +120,77 @@ bool BoEventListener::addCondition(BoCondition* c)
 {
  boDebug(360) << k_funcinfo << endl;
  d->mConditions.append(c);
+ eventIndexChanged();
  return true;
 }
 
+void BoEventListener::eventIndexChanged()
+{
+ d->mEventIndexDirty = true;
+ if (mManager) {
+	mManager->eventListenerSubscriptionsChanged(this);
+ }
+}
+
+void BoEventListener::rebuildEventIndex()
+{
+ d->mConditionsByEvent.clear();
+ d->mEventHandlersByEvent.clear();
+ d->mEventIndexDirty = false;
+ if (!mManager) {
+	return;
+ }
+ const unsigned int count = mManager->eventNameCount();
+ d->mConditionsByEvent.resize(count);
+ d->mEventHandlersByEvent.resize(count);
+
+ QPtrListIterator<BoCondition> it(d->mConditions);
+ for (; it.current(); ++it) {
+	BoCondition* c = it.current();
+	QValueList<int> ids;
+	c->eventNameIds(mManager, &ids);
+	if (ids.isEmpty() || c->requireScript()) {
+		// the condition may become fullfilled when any event is
+		// received (status conditions are checked on every event)
+		for (unsigned int i = 0; i < count; i++) {
+			d->mConditionsByEvent[i].push_back(c);
+		}
+	} else {
+		for (QValueList<int>::iterator idIt = ids.begin(); idIt != ids.end(); ++idIt) {
+			d->mConditionsByEvent[*idIt].push_back(c);
+		}
+	}
+ }
+
+ QIntDictIterator<BoEventHandlerInfo> handlerIt(d->mEventHandlers);
+ for (; handlerIt.current(); ++handlerIt) {
+	int id = mManager->eventNameId(handlerIt.current()->eventName.latin1());
+	if (id >= 0) {
+		d->mEventHandlersByEvent[id].push_back(handlerIt.currentKey());
+	}
+ }
+}
+
+bool BoEventListener::receivesEvent(int nameId)
+{
+ if (!mManager || nameId < 0) {
+	return false;
+ }
+ if (d->mEventIndexDirty) {
+	rebuildEventIndex();
+ }
+ if ((unsigned int)nameId >= d->mConditionsByEvent.count()) {
+	return false;
+ }
+ if (!d->mConditionsByEvent[nameId].isEmpty()) {
+	return true;
+ }
+ if (!d->mEventHandlersByEvent[nameId].isEmpty()) {
+	return true;
+ }
+ return processesEvent(mManager->eventName(nameId));
+}
+
 bool BoEventListener::saveAsXML(QDomElement& root) const
 {
  QDomDocument doc = root.ownerDocument();
@@ -175,6 +259,7 @@ bool BoEventListener::loadScript(const QByteArray& script, const QByteArray& scr
 
  d->mEventHandlers.setAutoDelete(true);
  d->mEventHandlers.clear();
+ eventIndexChanged();
 
  // AB: scriptData contains script + variable values. this is available when
  // loading saved games.
@@ -213,6 +298,7 @@ bool BoEventListener::loadScript(const QByteArray& script, const QByteArray& scr
  info->args = "";
  d->mEventHandlers.insert(1, info);
  d->mNextEventHandlerId = 2;
+ eventIndexChanged();
 
 
  return ret;
@@ -244,6 +330,7 @@ bool BoEventListener::loadConditions(const QDomElement& root)
 {
  boDebug(360) << k_funcinfo << endl;
  d->mConditions.clear();
+ eventIndexChanged();
  QDomNodeList list = root.elementsByTagName("Condition");
  for (unsigned int i = 0; i < list.count(); i++) {
 	QDomElement e = list.item(i).toElement();
@@ -326,6 +413,7 @@ bool BoEventListener::loadEventHandlers(const QDomElement& root)
 	}
 	d->mEventHandlers.insert(id, info);
  }
+ eventIndexChanged();
  int nextid = root.attribute("NextId").toLong(&ok);
  if (!ok) {
 	boError(360) << k_funcinfo << "Invalid NextId!" << endl;
@@ -340,21 +428,32 @@ void BoEventListener::deliverToConditions(const BoEvent* event)
 {
  PROFILE_METHOD
 // boDebug(360) << k_funcinfo << "conditions: " << d->mConditions.count() << endl;
+ if (d->mEventIndexDirty) {
+	rebuildEventIndex();
+ }
+ if (event->nameId() < 0 || (unsigned int)event->nameId() >= d->mConditionsByEvent.count()) {
+	return;
+ }
+ // only the conditions that wait for this event (or for any event) need to
+ // be checked. they are in the order of d->mConditions.
+ const QValueVector<BoCondition*>& conditions = d->mConditionsByEvent[event->nameId()];
  QPtrList<BoCondition> remove;
- QPtrListIterator<BoCondition> it(d->mConditions);
- while (it.current()) {
-	it.current()->processEvent(event);
-	if (it.current()->conditionDone(d->mScript)) {
-		it.current()->fireAction();
-		if (!it.current()->reset()) {
-			remove.append(it.current());
+ for (unsigned int i = 0; i < conditions.count(); i++) {
+	BoCondition* c = conditions[i];
+	c->processEvent(event);
+	if (c->conditionDone(d->mScript)) {
+		c->fireAction();
+		if (!c->reset()) {
+			remove.append(c);
 		}
 	}
-	++it;
  }
- while (!remove.isEmpty()) {
-	BoCondition* c = remove.take(0);
-	d->mConditions.removeRef(c);
+ if (!remove.isEmpty()) {
+	while (!remove.isEmpty()) {
+		BoCondition* c = remove.take(0);
+		d->mConditions.removeRef(c);
+	}
+	eventIndexChanged();
  }
 // boDebug(360) << k_funcinfo << "done" << endl;
 }
@@ -368,14 +467,30 @@ void BoEventListener::deliverToScript(const BoEvent* event)
 	}
 	return;
  }
- QIntDictIterator<BoEventHandlerInfo> it(d->mEventHandlers);
- for( ; it.current(); ++it) {
-	BoEventHandlerInfo* info = it.current();
-
-	if (info->eventName.latin1() == event->name()) {
-		d->mScript->callEventHandler(event, info->function, info->args);
+ BoTraceProfiler profiler(d->mScript->profilingSection());
+ if (d->mEventIndexDirty) {
+	rebuildEventIndex();
+ }
+ if (event->nameId() >= 0 && event->nameId() == d->mAdvanceNameId) {
+	// the script may skip this advance call, or continue a previous call
+	// instead of starting a new one
+	if (!d->mScript->startAdvance()) {
+		return;
 	}
  }
+ if (event->nameId() < 0 || (unsigned int)event->nameId() >= d->mEventHandlersByEvent.count()) {
+	return;
+ }
+ // the script may add or remove event handlers while we call them. we iterate
+ // over a copy of the IDs and skip handlers that have been removed.
+ QValueVector<int> handlers = d->mEventHandlersByEvent[event->nameId()];
+ for (unsigned int i = 0; i < handlers.count(); i++) {
+	BoEventHandlerInfo* info = d->mEventHandlers.find(handlers[i]);
+	if (!info) {
+		continue;
+	}
+	d->mScript->callEventHandler(event, info->function, info->args);
+ }
 }
 
 void BoEventListener::receiveEvent(const BoEvent* event)
@@ -400,12 +515,14 @@ void BoEventListener::addEventHandler(const QString& eventName, const QString& f
  d->mEventHandlers.insert(d->mNextEventHandlerId, info);
  *id = d->mNextEventHandlerId;
  d->mNextEventHandlerId++;
+ eventIndexChanged();
 }
 
 void BoEventListener::removeEventHandler(int id)
 {
  d->mEventHandlers.setAutoDelete(true);
  d->mEventHandlers.remove(id);
+ eventIndexChanged();
 }
 
 
@@ -469,6 +586,16 @@ void BoCanvasEventListener::processEvent(const BoEvent* event)
  }
 }
 
+bool BoCanvasEventListener::processesEvent(const QCString& name) const
+{
+ if (name == "AllUnitsDestroyed" || name == "PlayerLost" ||
+		name == "PlayerWon" || name == "GameOver" ||
+		name == "CustomStringEvent") {
+	return true;
+ }
+ return false;
+}
+
 // AB: here we could do several nice things
 // * provide an XML file (and a dialog in the editor) to define winning
 //   conditions
@@ -518,16 +645,16 @@ void BoCanvasEventListener::checkGameOverAndEndGame()
 	for (unsigned int i = 0; i < activeGamePlayerList.count(); i++) {
 		Player* p = activeGamePlayerList.at(i);
 		if (fullfilledWinningConditions.contains(p)) {
-			BoEvent* won = new BoEvent("PlayerWon");
+			BoEvent* won = BoEvent::create("PlayerWon");
 			won->setPlayerId(p->bosonId());
 			boGame->queueEvent(won);
 		} else {
-			BoEvent* lost = new BoEvent("PlayerLost");
+			BoEvent* lost = BoEvent::create("PlayerLost");
 			lost->setPlayerId(p->bosonId());
 			boGame->queueEvent(lost);
 		}
 	}
-	BoEvent* gameOver = new BoEvent("GameOver");
+	BoEvent* gameOver = BoEvent::create("GameOver");
 
 	// We use a "fadeout" time of 100 advance calls.
 	// This is meant to make sure that the final explosions are actually
@@ -563,7 +690,31 @@ BosonScript* BoComputerPlayerEventListener::createScriptParser() const
 	playerId = playerIO()->playerId();
  }
 
- return BosonScript::newScriptParser(BosonScript::Python, playerId);
+ BosonScript* script = BosonScript::newScriptParser(BosonScript::Python, playerId);
+ if (script && boGame && playerIO()) {
+	// the AI acts once every (AIDelay * 20 + 1) advance calls only. we
+	// spread the computer players evenly over that period, so that they
+	// don't all run in the same advance call.
+	double aiDelay = boConfig->doubleValue("AIDelay");
+	unsigned int period = 1;
+	if (aiDelay > 0.0) {
+		period = (unsigned int)(aiDelay * 20) + 1;
+	}
+	const QPtrList<Player>& players = boGame->gamePlayerList();
+	unsigned int index = 0;
+	for (QPtrListIterator<Player> it(players); it.current(); ++it) {
+		if (it.current() == playerIO()->player()) {
+			break;
+		}
+		index++;
+	}
+	unsigned int phase = 0;
+	if (index < players.count()) {
+		phase = (index * period) / players.count();
+	}
+	script->setAdvanceSchedule(phase, boConfig->uintValue("AIAdvanceBudget"));
+ }
+ return script;
 }
 
 void BoComputerPlayerEventListener::processEvent(const BoEvent* event)
@@ -113,6 +113,17 @@ public:
 	 **/
 	virtual bool canSee(const BoEvent* event) const = 0;
 
+	/**
+	 * Used by @ref BoEventManager to find out which listeners an event
+	 * needs to be delivered to.
+	 *
+	 * @return TRUE if this listener wants to receive events with the name
+	 * ID @p nameId (see @ref BoEventManager::eventNameId), i.e. if a
+	 * condition or a script event handler waits for such events or if
+	 * @ref processesEvent returns TRUE for the name.
+	 **/
+	bool receivesEvent(int nameId);
+
 public slots:
 	void addEventHandler(const QString& eventname, const QString& functionname, const QString& args, int* id);
 	void removeEventHandler(int id);
@@ -120,6 +131,32 @@ public slots:
 protected:
 	virtual void processEvent(const BoEvent* event) = 0;
 
+	/**
+	 * @return Whether @ref processEvent does anything with events of the
+	 * name @p name. The default returns always TRUE, reimplement this if
+	 * @ref processEvent handles a few events only.
+	 *
+	 * This is called when the event index of the @ref BoEventManager is
+	 * rebuilt only, not for every event.
+	 **/
+	virtual bool processesEvent(const QCString& name) const
+	{
+		Q_UNUSED(name);
+		return true;
+	}
+
+	/**
+	 * Rebuild the lists of conditions and event handlers that wait for a
+	 * certain event, see @ref receivesEvent.
+	 **/
+	void rebuildEventIndex();
+
+	/**
+	 * Called when a condition or event handler is added or removed. The
+	 * event index is rebuilt before the next event is delivered.
+	 **/
+	void eventIndexChanged();
+
 	void deliverToConditions(const BoEvent* event);
 	void deliverToScript(const BoEvent* event);
 
@@ -165,6 +202,7 @@ signals:
 
 protected:
 	virtual BosonScript* createScriptParser() const;
+	virtual bool processesEvent(const QCString& name) const;
 
 	/**
 	 * Check whether the game is over (see @ref checkGameOver) and send a
@@ -202,6 +240,10 @@ public:
 
 protected:
 	virtual BosonScript* createScriptParser() const;
+	virtual bool processesEvent(const QCString&) const
+	{
+		return false;
+	}
 
 private:
 	PlayerIO* mPlayerIO;
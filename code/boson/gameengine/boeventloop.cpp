@@ -48,6 +48,7 @@ public:
 		mGameSpeed = 0;
 		mAdvanceCallsMade = 0;
 		mAdvanceMessagesWaiting = 0;
+		mFastAdvance = false;
 	}
 	int mAdvanceMessageInterval;
 
@@ -56,6 +57,7 @@ public:
 	int mGameSpeed;
 	int mAdvanceCallsMade;
 	int mAdvanceMessagesWaiting;
+	bool mFastAdvance;
 	QTime mLastAdvanceMessage;
 	QTime mNextAdvanceMessage;
 	QTime mNextAdvanceCall;
@@ -99,6 +101,11 @@ void BoEventLoop::setAdvanceMessagesWaiting(int count)
  d->mAdvanceMessagesWaiting = count;
 }
 
+void BoEventLoop::setFastAdvance(bool fast)
+{
+ d->mFastAdvance = fast;
+}
+
 void BoEventLoop::postAdvanceCallEvent()
 {
  BO_CHECK_NULL_RET(mAdvanceObject);
@@ -111,7 +118,7 @@ void BoEventLoop::postAdvanceCallEvent()
 
  // first calculate when the next advance call will be made
  if (d->mAdvanceCallsMade + 1 < d->mGameSpeed) {
-	if (d->mAdvanceMessagesWaiting == 0) {
+	if (d->mAdvanceMessagesWaiting == 0 && !d->mFastAdvance) {
 		int nextCallNumber = d->mAdvanceCallsMade + 1;
 		const int callAfterMs = d->mAdvanceMessageInterval / d->mGameSpeed;
 		const int nextCall = nextCallNumber * callAfterMs;
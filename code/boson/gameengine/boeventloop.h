@@ -44,6 +44,14 @@ public:
 	void receivedAdvanceMessage(int gameSpeed);
 	void setAdvanceMessagesWaiting(int count);
 
+	/**
+	 * If @p fast is TRUE, all advance calls of an advance message are made
+	 * immediately, instead of spreading them over the advance message
+	 * interval. This is used for benchmarking only, see @ref
+	 * Boson::setFastAdvance.
+	 **/
+	void setFastAdvance(bool fast);
+
 protected:
 	/**
 	 * Post an QtEventAdvanceCall event to the advance object (see @ref
@@ -39,19 +39,48 @@
 
 #include <stdlib.h>
 
+// number of slots in the timing wheel of the delayed events. events that are
+// delayed by more advance calls simply remain in their slot until they are due.
+#define EVENT_WHEEL_SIZE 128
+
+class BoQueuedEvent
+{
+public:
+	BoQueuedEvent()
+	{
+		mEvent = 0;
+		mDeliverAt = 0;
+	}
+	BoEvent* mEvent;
+	unsigned long int mDeliverAt; // the advance call, see mAdvanceCount
+};
 
 class BoEventManagerPrivate
 {
 public:
 	BoEventManagerPrivate()
 	{
+		mAdvanceCount = 0;
+		mQueuedEventsCount = 0;
+		mListenerIndexDirty = true;
 	}
 	KGamePropertyHandler* mProperties;
 	KGameProperty<unsigned long int> mNextEventId;
 
-	QPtrList<BoEvent> mEvents;
+	// the queued events, in the slot (mDeliverAt % EVENT_WHEEL_SIZE). the
+	// events of a slot are in the order in which they were queued.
+	QValueVector<BoQueuedEvent> mEventWheel[EVENT_WHEEL_SIZE];
+	unsigned long int mAdvanceCount; // number of advance() calls
+	unsigned int mQueuedEventsCount;
+
 	QPtrList<BoEventListener> mEventListeners;
 
+	// mListenersByEvent[i] contains the listeners that receive events with
+	// the name ID i, in the order of mEventListeners.
+	QValueVector< QValueVector<BoEventListener*> > mListenersByEvent;
+	bool mListenerIndexDirty;
+
+	// sorted. the index of a name is its ID.
 	QValueVector<QCString> mEventNames;
 
 	QMap<QString, QByteArray> mAvailableScripts;
@@ -61,7 +90,6 @@ public:
 BoEventManager::BoEventManager(QObject* parent) : QObject(parent)
 {
  d = new BoEventManagerPrivate;
- d->mEvents.setAutoDelete(true);
 
  d->mProperties = new KGamePropertyHandler(this);
  d->mNextEventId.registerData(IdNextEvent, d->mProperties,
@@ -73,6 +101,7 @@ BoEventManager::BoEventManager(QObject* parent) : QObject(parent)
 
 BoEventManager::~BoEventManager()
 {
+ clearEvents();
  d->mAvailableScripts.clear();
  d->mEventListenerXML.clear();
  delete d;
@@ -117,6 +146,7 @@ void BoEventManager::declareEvents()
  BO_DECLARE_EVENT(CustomStringEvent);
 #undef BO_DECLARE_EVENT
  qHeapSort(d->mEventNames);
+ d->mListenerIndexDirty = true;
 }
 
 bool BoEventManager::saveAsXML(QDomElement& root) const
@@ -133,22 +163,31 @@ bool BoEventManager::saveAsXML(QDomElement& root) const
  QDomElement events = doc.createElement(QString::fromLatin1("EventQueue"));
  root.appendChild(events);
 
- QPtrListIterator<BoEvent> it(d->mEvents);
- while (it.current()) {
+ // save the events in the order in which they were queued, i.e. sorted by
+ // their IDs. the remaining delay replaces the initial one.
+ QMap<unsigned long int, BoQueuedEvent> queued;
+ for (unsigned int i = 0; i < EVENT_WHEEL_SIZE; i++) {
+	const QValueVector<BoQueuedEvent>& slot = d->mEventWheel[i];
+	for (unsigned int j = 0; j < slot.count(); j++) {
+		queued.insert(slot[j].mEvent->id(), slot[j]);
+	}
+ }
+ for (QMap<unsigned long int, BoQueuedEvent>::iterator it = queued.begin(); it != queued.end(); ++it) {
+	BoEvent* event = it.data().mEvent;
+	event->setDelayedDelivery(it.data().mDeliverAt - d->mAdvanceCount);
 	QDomElement e = doc.createElement(QString::fromLatin1("Event"));
-	if (!it.current()->saveAsXML(e)) {
+	if (!event->saveAsXML(e)) {
 		boError(360) << k_funcinfo << "error saving event" << endl;
 		return false;
 	}
 	events.appendChild(e);
-	++it;
  }
  return true;
 }
 
 bool BoEventManager::loadFromXML(const QDomElement& root)
 {
- d->mEvents.clear();
+ clearEvents();
  QDomElement handler = root.namedItem(QString::fromLatin1("DataHandler")).toElement();
  if (handler.isNull()) {
 	boError(360) << k_funcinfo << "DataHandler not found" << endl;
@@ -413,70 +452,151 @@ bool BoEventManager::queueEvent(BoEvent* event)
  // this is just to avoid typos!
  // -> it might be a problem if we want to support custom events, and maybe we
  // will remove it.
- if (!knowEventName(event->name())) {
+ int nameId = eventNameId(event->name());
+ if (nameId < 0) {
 	boError(360) << k_funcinfo << "The event " << event->name() << " has not been declared in the event manager. cannot use this event." << endl;
-	delete event;
+	BoEvent::release(event);
 	return false;
  }
  if (!boGame->gameMode()) {
 	// in editor mode we just ignore the event.
-	delete event;
+	BoEvent::release(event);
 	return true;
  }
  boDebug(360) << k_funcinfo << "queue event " << event->name() << endl;
  unsigned long int id = d->mNextEventId;
  d->mNextEventId = d->mNextEventId + 1;
  event->setId(id);
+ event->setNameId(nameId);
 
  // the event is valid now.
- d->mEvents.append(event);
+ // note that if we are in advance() currently, d->mAdvanceCount is the
+ // current advance call, so an event without delay is still delivered in this
+ // call.
+ BoQueuedEvent queued;
+ queued.mEvent = event;
+ queued.mDeliverAt = d->mAdvanceCount + event->delayedDelivery();
+ d->mEventWheel[queued.mDeliverAt % EVENT_WHEEL_SIZE].push_back(queued);
+ d->mQueuedEventsCount++;
 
  return true;
 }
 
+unsigned int BoEventManager::queuedEventsCount() const
+{
+ return d->mQueuedEventsCount;
+}
+
+void BoEventManager::clearEvents()
+{
+ for (unsigned int i = 0; i < EVENT_WHEEL_SIZE; i++) {
+	QValueVector<BoQueuedEvent>& slot = d->mEventWheel[i];
+	for (unsigned int j = 0; j < slot.count(); j++) {
+		BoEvent::release(slot[j].mEvent);
+	}
+	slot.clear();
+ }
+ d->mQueuedEventsCount = 0;
+}
+
 void BoEventManager::deliverEvent(BoEvent* event)
 {
  PROFILE_METHOD
  const BoEvent* e = event;
  boDebug(360) << k_funcinfo << e->name() << endl;
- QPtrListIterator<BoEventListener> it(d->mEventListeners);
- while (it.current()) {
+ if (d->mListenerIndexDirty) {
+	rebuildListenerIndex();
+ }
+ if (e->nameId() < 0 || (unsigned int)e->nameId() >= d->mListenersByEvent.count()) {
+	boError(360) << k_funcinfo << "invalid name ID " << e->nameId() << " of event " << e->name() << endl;
+	BoEvent::release(event);
+	return;
+ }
+
+ // note: removeEventListener() may be called while we deliver the event, it
+ // sets the entry to NULL then. the index itself is not rebuilt before the
+ // next event.
+ const QValueVector<BoEventListener*>& listeners = d->mListenersByEvent[e->nameId()];
+ for (unsigned int i = 0; i < listeners.count(); i++) {
+	BoEventListener* l = listeners[i];
+	if (!l) {
+		continue;
+	}
 	if (e->hasLocation()) {
-		if (!it.current()->canSee(e)) {
-			++it;
+		if (!l->canSee(e)) {
 			continue;
 		}
 	}
-	it.current()->receiveEvent(e);
-	++it;
+	l->receiveEvent(e);
  }
- delete event;
+ BoEvent::release(event);
 }
 
 void BoEventManager::advance(unsigned int advanceCallsCount)
 {
  PROFILE_METHOD
- QPtrList<BoEvent> remainingEvents;
- while (!d->mEvents.isEmpty()) {
-	BoEvent* e = d->mEvents.take(0);
-	if (e->delayedDelivery() == 0) {
-		deliverEvent(e); // deletes the event
-	} else {
-		e->setDelayedDelivery(e->delayedDelivery() - 1);
-		remainingEvents.append(e);
+ Q_UNUSED(advanceCallsCount);
+ const unsigned long int now = d->mAdvanceCount;
+ QValueVector<BoQueuedEvent>& slot = d->mEventWheel[now % EVENT_WHEEL_SIZE];
+
+ // deliver the events of the current slot that are due now and keep the others
+ // (which are due in a later round of the wheel).
+ // note that delivering an event may queue new events to this slot, so we must
+ // not cache slot.count().
+ unsigned int kept = 0;
+ for (unsigned int i = 0; i < slot.count(); i++) {
+	if (slot[i].mDeliverAt != now) {
+		if (kept != i) {
+			slot[kept] = slot[i];
+		}
+		kept++;
+		continue;
 	}
+	BoEvent* e = slot[i].mEvent;
+	d->mQueuedEventsCount--;
+	deliverEvent(e); // gives the event back to the pool
  }
- d->mEvents = remainingEvents;
+ slot.resize(kept);
+ d->mAdvanceCount++;
 }
 
 void BoEventManager::addEventListener(BoEventListener* l)
 {
  d->mEventListeners.append(l);
+ d->mListenerIndexDirty = true;
 }
 
 void BoEventManager::removeEventListener(BoEventListener* l)
 {
  d->mEventListeners.removeRef(l);
+ for (unsigned int i = 0; i < d->mListenersByEvent.count(); i++) {
+	QValueVector<BoEventListener*>& listeners = d->mListenersByEvent[i];
+	for (unsigned int j = 0; j < listeners.count(); j++) {
+		if (listeners[j] == l) {
+			listeners[j] = 0;
+		}
+	}
+ }
+ d->mListenerIndexDirty = true;
+}
+
+void BoEventManager::eventListenerSubscriptionsChanged(BoEventListener*)
+{
+ d->mListenerIndexDirty = true;
+}
+
+void BoEventManager::rebuildListenerIndex()
+{
+ d->mListenersByEvent.clear();
+ d->mListenersByEvent.resize(d->mEventNames.count());
+ for (QPtrListIterator<BoEventListener> it(d->mEventListeners); it.current(); ++it) {
+	for (unsigned int i = 0; i < d->mEventNames.count(); i++) {
+		if (it.current()->receivesEvent(i)) {
+			d->mListenersByEvent[i].push_back(it.current());
+		}
+	}
+ }
+ d->mListenerIndexDirty = false;
 }
 
 static int compare_cstrings(const void* s1, const void* s2)
@@ -487,17 +607,36 @@ static int compare_cstrings(const void* s1, const void* s2)
 }
 
 bool BoEventManager::knowEventName(const QCString& name) const
+{
+ return (eventNameId(name) >= 0);
+}
+
+int BoEventManager::eventNameId(const QCString& name) const
 {
  if (d->mEventNames.isEmpty()) {
-	return false;
+	return -1;
  }
  // d->mEventNames is a sorted array. we make a binary search on it.
- void* e = ::bsearch(&name, d->mEventNames.begin(), d->mEventNames.count(),
+ const QCString* begin = d->mEventNames.begin();
+ void* e = ::bsearch(&name, begin, d->mEventNames.count(),
 		sizeof(QCString), compare_cstrings);
  if (!e) {
-	return false;
+	return -1;
  }
- return true;
+ return (int)((const QCString*)e - begin);
+}
+
+unsigned int BoEventManager::eventNameCount() const
+{
+ return d->mEventNames.count();
+}
+
+QCString BoEventManager::eventName(int id) const
+{
+ if (id < 0 || (unsigned int)id >= d->mEventNames.count()) {
+	return QCString();
+ }
+ return d->mEventNames[id];
 }
 
 QStringList BoEventManager::availableScriptFiles(bool includeDataFiles) const
@@ -43,6 +43,27 @@ public:
 
 	bool knowEventName(const QCString& name) const;
 
+	/**
+	 * All event names are declared when the event manager is constructed
+	 * and each name gets a unique ID. Events, listeners and conditions use
+	 * these IDs instead of comparing the names.
+	 *
+	 * @return The ID of the event name @p name, or -1 if it has not been
+	 * declared. The IDs are in the range 0..@ref eventNameCount - 1.
+	 **/
+	int eventNameId(const QCString& name) const;
+
+	/**
+	 * @return The number of declared event names.
+	 **/
+	unsigned int eventNameCount() const;
+
+	/**
+	 * @return The name of the event with the ID @p id, see @ref
+	 * eventNameId.
+	 **/
+	QCString eventName(int id) const;
+
 	/**
 	 * This does NOT take ownership of the listener! You still have to
 	 * delete it on your own.
@@ -51,6 +72,12 @@ public:
 
 	void removeEventListener(BoEventListener* listener);
 
+	/**
+	 * Called by @ref BoEventListener when the events it wants to receive
+	 * (see @ref BoEventListener::receivesEvent) have changed.
+	 **/
+	void eventListenerSubscriptionsChanged(BoEventListener* listener);
+
 	/**
 	 * Queue an event for delivery. Delivery takes place in @ref advance.
 	 *
@@ -62,10 +89,19 @@ public:
 	bool queueEvent(BoEvent*);
 
 	/**
-	 * Advance any queued events.
+	 * Deliver all events that are due in this advance call.
+	 *
+	 * Events that are delayed (see @ref BoEvent::setDelayedDelivery) are
+	 * kept in a timing wheel, i.e. they are not touched until the advance
+	 * call in which they are due.
 	 **/
 	void advance(unsigned int advanceCallsCount);
 
+	/**
+	 * @return The number of events that are queued for delivery.
+	 **/
+	unsigned int queuedEventsCount() const;
+
 	bool saveAsXML(QDomElement& root) const;
 	bool loadFromXML(const QDomElement& root);
 
@@ -134,6 +170,17 @@ protected:
 	void deliverEvent(BoEvent* event);
 	void declareEvents();
 
+	/**
+	 * Rebuild the lists of listeners that want to receive the events, see
+	 * @ref BoEventListener::receivesEvent.
+	 **/
+	void rebuildListenerIndex();
+
+	/**
+	 * Delete all queued events.
+	 **/
+	void clearEvents();
+
 private:
 	BoEventManagerPrivate* d;
 };
@@ -99,3 +99,9 @@ bool BoEventMatching::matches(const BoEvent* e) const
  return mEvent->matches(this, e);
 }
 
+void BoEventMatching::setEventNameId(int id)
+{
+ BO_CHECK_NULL_RET(mEvent);
+ mEvent->setNameId(id);
+}
+
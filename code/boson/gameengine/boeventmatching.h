@@ -61,6 +61,12 @@ public:
 
 	bool matches(const BoEvent* event) const;
 
+	/**
+	 * Set the @ref BoEvent::nameId of the @ref event, so that @ref matches
+	 * can compare the IDs instead of the names.
+	 **/
+	void setEventNameId(int id);
+
 private:
 	// AB: the name and the rtti of an event are never ignored
 	// same for the location, which is not relevant for matching
@@ -230,6 +230,16 @@ public:
 		return fileData(QString::fromLatin1("canvas.xml"));
 	}
 
+	/**
+	 * @return The content of the canvas.bin file, i.e. the canvas in
+	 * binary format (see @ref BoBinarySaveGame). A file contains either a
+	 * canvas.xml or a canvas.bin file.
+	 **/
+	QByteArray canvasBinaryData() const
+	{
+		return fileData(QString::fromLatin1("canvas.bin"));
+	}
+
 	/**
 	 * @return The content of the players.xml file
 	 **/
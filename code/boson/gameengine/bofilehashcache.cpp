@@ -0,0 +1,105 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "bofilehashcache.h"
+
+#include "../../bomemory/bodummymemory.h"
+#include "bodebug.h"
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qcstring.h>
+#include <qfile.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qdeepcopy.h>
+
+#include <kmdcodec.h>
+
+/**
+ * @internal
+ **/
+class BoFileHashCacheData
+{
+public:
+	QMutex mMutex;
+	QMap<QString, QCString> mHashes;
+};
+
+static BoFileHashCacheData* cacheData()
+{
+ static BoFileHashCacheData data;
+ return &data;
+}
+
+static QString hashKey(const QStringList& files)
+{
+ return files.join(QString::fromLatin1("\n"));
+}
+
+bool BoFileHashCache::prefetchHash(const QStringList& files)
+{
+ if (files.isEmpty()) {
+	return false;
+ }
+ KMD5 md5;
+ for (unsigned int i = 0; i < files.count(); i++) {
+	QFile file(files[i]);
+	if (!file.open(IO_ReadOnly)) {
+		if (i == 0) {
+			return false;
+		}
+		continue;
+	}
+	md5.update(file.readAll());
+ }
+
+ BoFileHashCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ data->mHashes.insert(QDeepCopy<QString>(hashKey(files)), QDeepCopy<QCString>(md5.hexDigest()));
+ return true;
+}
+
+bool BoFileHashCache::hash(const QStringList& files, QCString* md5)
+{
+ BO_CHECK_NULL_RET0(md5);
+ BoFileHashCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ QMap<QString, QCString>::iterator it = data->mHashes.find(hashKey(files));
+ if (it == data->mHashes.end()) {
+	return false;
+ }
+ *md5 = QDeepCopy<QCString>(it.data());
+ return true;
+}
+
+void BoFileHashCache::removeHash(const QStringList& files)
+{
+ BoFileHashCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ data->mHashes.remove(hashKey(files));
+}
+
+void BoFileHashCache::clear()
+{
+ BoFileHashCacheData* data = cacheData();
+ QMutexLocker lock(&data->mMutex);
+ data->mHashes.clear();
+}
+
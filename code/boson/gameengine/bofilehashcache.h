@@ -0,0 +1,65 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOFILEHASHCACHE_H
+#define BOFILEHASHCACHE_H
+
+class QStringList;
+class QCString;
+
+/**
+ * @short MD5 sums of files that have been calculated in advance
+ *
+ * Unit configs and models are identified by the MD5 sum of their files (see
+ * @ref UnitProperties::md5 and @ref BoBMFLoad::cachedModelFilename), so every
+ * file is read completely before it is parsed. Reading and hashing the files
+ * does not depend on the game, so it can be done by worker threads (see @ref
+ * BosonStartingTask::preparePart) while the main thread is still busy with
+ * other tasks. The main thread then finds the MD5 sum here and the file in
+ * the file system cache.
+ *
+ * @ref prefetchHash may be called by any thread. All other methods must be
+ * called by the main thread only.
+ **/
+class BoFileHashCache
+{
+public:
+	/**
+	 * Calculate the MD5 sum of the contents of @p files (i.e. of the
+	 * files concatenated) and keep it until @ref removeHash is called.
+	 * Files that cannot be read are skipped, except for the first one.
+	 * This method is thread safe.
+	 * @return FALSE if the first file could not be read.
+	 **/
+	static bool prefetchHash(const QStringList& files);
+
+	/**
+	 * Store the MD5 sum of @p files in @p md5, if it has been prefetched.
+	 * The sum stays in the cache.
+	 * @return FALSE if the sum has not been prefetched. @p md5 is not
+	 * touched then.
+	 **/
+	static bool hash(const QStringList& files, QCString* md5);
+
+	static void removeHash(const QStringList& files);
+
+	static void clear();
+};
+
+#endif
+
@@ -0,0 +1,207 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include "boitemfrustumculler.h"
+
+#include "../../bomemory/bodummymemory.h"
+#include "bocanvasquadtreenode.h"
+#include "bosoncanvas.h"
+#include "bosonmap.h"
+#include "cell.h"
+#include "boitemlist.h"
+#include "../bo3dtools.h"
+#include "bodebug.h"
+
+#include <qvaluevector.h>
+
+// the nodes cover the cells of the ground and the units only, but the
+// bounding spheres of the items are a bit larger. the boxes of the nodes are
+// enlarged by this margin, so that an item in a rejected node is not visible
+// either.
+static const float itemCullingMargin = 2.0f;
+
+// nodes of this size or smaller are not divided any further by the culler
+static const unsigned int itemCullingMinNodeSize = 4;
+
+static void nodeBox(const BoCanvasQuadTreeNode* node, BoVector3Float* min, BoVector3Float* max)
+{
+ min->set((float)node->left() - itemCullingMargin,
+		(float)-(node->bottom() + 1) - itemCullingMargin,
+		node->minZ() - itemCullingMargin);
+ max->set((float)(node->right() + 1) + itemCullingMargin,
+		(float)-node->top() + itemCullingMargin,
+		node->maxZ() + itemCullingMargin);
+}
+
+BoItemFrustumCuller::BoItemFrustumCuller()
+{
+ mCanvas = 0;
+ mTree = 0;
+ mWidth = 0;
+ mHeight = 0;
+ mTestedNodes = 0;
+ mAcceptedNodes = 0;
+}
+
+BoItemFrustumCuller::~BoItemFrustumCuller()
+{
+ // the tree unregisters itself from the canvas and the map
+ delete mTree;
+}
+
+void BoItemFrustumCuller::setCanvas(BosonCanvas* canvas)
+{
+ delete mTree;
+ mTree = 0;
+ mCanvas = 0;
+ mWidth = 0;
+ mHeight = 0;
+ mNodeVisibility.resize(0);
+ mCollectedItems.clear();
+ if (!canvas) {
+	return;
+ }
+ BO_CHECK_NULL_RET(canvas->map());
+ mCanvas = canvas;
+ mWidth = canvas->mapWidth();
+ mHeight = canvas->mapHeight();
+ mTree = BoCanvasQuadTreeNode::createTree(mWidth, mHeight);
+ mNodeVisibility.resize(nodeIndexCount(mTree, 0));
+ mNodeVisibility.fill(NotVisible);
+
+ canvas->registerQuadTree(mTree);
+ canvas->map()->registerQuadTree(mTree);
+
+ mTree->cellHeightChanged(canvas->map(), 0, 0, mWidth - 1, mHeight - 1);
+ mTree->cellUnitsChanged(canvas, 0, 0, mWidth - 1, mHeight - 1);
+}
+
+unsigned int BoItemFrustumCuller::nodeIndexCount(const BoCanvasQuadTreeNode* node, unsigned int index)
+{
+ unsigned int count = index + 1;
+ if (node->nodeSize() <= itemCullingMinNodeSize) {
+	return count;
+ }
+ BoQuadTreeNode* children[4];
+ node->getChildren(children);
+ for (int i = 0; i < 4; i++) {
+	if (children[i]) {
+		count = QMAX(count, nodeIndexCount((BoCanvasQuadTreeNode*)children[i], index * 4 + 1 + i));
+	}
+ }
+ return count;
+}
+
+void BoItemFrustumCuller::cullNodes(const BoFrustum& frustum)
+{
+ mTestedNodes = 0;
+ mAcceptedNodes = 0;
+ if (!mTree) {
+	return;
+ }
+ cullNode(frustum, mTree, 0);
+}
+
+void BoItemFrustumCuller::cullNode(const BoFrustum& frustum, const BoCanvasQuadTreeNode* node, unsigned int index)
+{
+ BoVector3Float min;
+ BoVector3Float max;
+ nodeBox(node, &min, &max);
+ mTestedNodes++;
+ int visibility = frustum.boxCompleteInFrustum(min, max);
+ if (visibility == PartiallyVisible && node->nodeSize() > itemCullingMinNodeSize) {
+	mNodeVisibility[index] = ChildrenTested;
+	BoQuadTreeNode* children[4];
+	node->getChildren(children);
+	for (int i = 0; i < 4; i++) {
+		if (children[i]) {
+			cullNode(frustum, (BoCanvasQuadTreeNode*)children[i], index * 4 + 1 + i);
+		}
+	}
+	return;
+ }
+ if (visibility == CompletelyVisible) {
+	mAcceptedNodes++;
+ }
+ mNodeVisibility[index] = (unsigned char)visibility;
+}
+
+void BoItemFrustumCuller::collectItems(QValueVector<BoCulledItem>* items)
+{
+ items->clear();
+ mCollectedItems.clear();
+ if (!mTree) {
+	return;
+ }
+ collectNode(mTree, 0, items);
+ mCollectedItems.clear();
+}
+
+void BoItemFrustumCuller::collectNode(const BoCanvasQuadTreeNode* node, unsigned int index, QValueVector<BoCulledItem>* items)
+{
+ const int visibility = mNodeVisibility[index];
+ if (visibility == NotVisible) {
+	return;
+ }
+ if (visibility == ChildrenTested) {
+	BoQuadTreeNode* children[4];
+	node->getChildren(children);
+	for (int i = 0; i < 4; i++) {
+		if (children[i]) {
+			collectNode((const BoCanvasQuadTreeNode*)children[i], index * 4 + 1 + i, items);
+		}
+	}
+	return;
+ }
+
+ for (int y = node->top(); y <= node->bottom(); y++) {
+	for (int x = node->left(); x <= node->right(); x++) {
+		const Cell* c = mCanvas->cell(x, y);
+		if (!c) {
+			continue;
+		}
+		const BoItemList* list = c->items();
+		for (BoItemList::ConstIterator it = list->begin(); it != list->end(); ++it) {
+			// items that cover several cells are collected once only
+			BosonItem* item = *it;
+			if (mCollectedItems.find(item)) {
+				continue;
+			}
+			mCollectedItems.insert(item, item);
+			items->append(BoCulledItem(item, node, visibility));
+		}
+	}
+ }
+}
+
+int BoItemFrustumCuller::itemVisibility(const BoCulledItem& item, const BoVector3Float& center, float radius)
+{
+ if (item.nodeVisibility != CompletelyVisible || !item.node) {
+	return PartiallyVisible;
+ }
+ BoVector3Float min;
+ BoVector3Float max;
+ nodeBox(item.node, &min, &max);
+ if (center.x() - radius < min.x() || center.x() + radius > max.x() ||
+		center.y() - radius < min.y() || center.y() + radius > max.y() ||
+		center.z() - radius < min.z() || center.z() + radius > max.z()) {
+	return PartiallyVisible;
+ }
+ return CompletelyVisible;
+}
+
@@ -0,0 +1,160 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOITEMFRUSTUMCULLER_H
+#define BOITEMFRUSTUMCULLER_H
+
+#include <qmemarray.h>
+#include <qptrdict.h>
+
+class BosonCanvas;
+class BosonItem;
+class BoCanvasQuadTreeNode;
+class BoFrustum;
+template<class T> class BoVector3;
+typedef BoVector3<float> BoVector3Float;
+template<class T> class QValueVector;
+
+/**
+ * An item that was collected by @ref BoItemFrustumCuller::collectItems.
+ **/
+class BoCulledItem
+{
+public:
+	BoCulledItem()
+	{
+		item = 0;
+		node = 0;
+		nodeVisibility = 0;
+	}
+	BoCulledItem(BosonItem* _item, const BoCanvasQuadTreeNode* _node, int _nodeVisibility)
+	{
+		item = _item;
+		node = _node;
+		nodeVisibility = _nodeVisibility;
+	}
+
+	BosonItem* item;
+
+	/**
+	 * The node the item was found in. This node was either accepted or
+	 * partially visible.
+	 **/
+	const BoCanvasQuadTreeNode* node;
+
+	/**
+	 * @ref BoItemFrustumCuller::CompletelyVisible or @ref
+	 * BoItemFrustumCuller::PartiallyVisible, the result of the culler
+	 * for @ref node.
+	 **/
+	int nodeVisibility;
+};
+
+/**
+ * Hierarchical frustum culling for items. The nodes of a @ref
+ * BoCanvasQuadTreeNode tree are tested against the view frustum once per frame
+ * (see @ref cullNodes). A node that is completely inside or completely
+ * outside of the frustum accepts or rejects all items in it, only items in
+ * partially visible nodes need to be tested one by one.
+ *
+ * The items are collected from the cells of the accepted and partially
+ * visible nodes (see @ref collectItems), i.e. the items in rejected nodes are
+ * never looked at. Shots are not placed in cells (see @ref
+ * BosonItem::addToCells) and therefore are never collected.
+ *
+ * The result is stored per node. Every node gets an index as in a complete
+ * quadtree (the children of node i are 4*i+1 to 4*i+4), so the visibility of
+ * the nodes is a simple array.
+ **/
+class BoItemFrustumCuller
+{
+public:
+	enum Visibility {
+		NotVisible = 0,
+		PartiallyVisible = 1,
+		CompletelyVisible = 2,
+
+		// the node was partially visible and its children have been
+		// tested
+		ChildrenTested = 3
+	};
+
+	BoItemFrustumCuller();
+	~BoItemFrustumCuller();
+
+	/**
+	 * Create the quadtree for @p canvas and register it at the canvas and
+	 * its map.
+	 **/
+	void setCanvas(BosonCanvas* canvas);
+
+	/**
+	 * Test the nodes of the tree against @p frustum. Nodes that are only
+	 * partially visible are tested further, until the node is small
+	 * enough.
+	 **/
+	void cullNodes(const BoFrustum& frustum);
+
+	/**
+	 * Collect the items in the cells of all nodes that were accepted or
+	 * partially visible in the last @ref cullNodes call. An item that is
+	 * in several of these nodes is collected once only.
+	 **/
+	void collectItems(QValueVector<BoCulledItem>* items);
+
+	/**
+	 * @param center The center of the bounding sphere of the item, in
+	 * world coordinates (i.e. y is negative).
+	 * @return @ref CompletelyVisible if the node of @p item was accepted
+	 * and the sphere is inside of the node. Otherwise @ref
+	 * PartiallyVisible, i.e. the item needs to be tested on its own.
+	 **/
+	static int itemVisibility(const BoCulledItem& item, const BoVector3Float& center, float radius);
+
+	unsigned int testedNodes() const
+	{
+		return mTestedNodes;
+	}
+	unsigned int acceptedNodes() const
+	{
+		return mAcceptedNodes;
+	}
+
+protected:
+	void cullNode(const BoFrustum& frustum, const BoCanvasQuadTreeNode* node, unsigned int index);
+	void collectNode(const BoCanvasQuadTreeNode* node, unsigned int index, QValueVector<BoCulledItem>* items);
+
+	/**
+	 * @return The number of node indices that are required for the
+	 * subtree of @p node, see @ref cullNode.
+	 **/
+	static unsigned int nodeIndexCount(const BoCanvasQuadTreeNode* node, unsigned int index);
+
+private:
+	BosonCanvas* mCanvas;
+	BoCanvasQuadTreeNode* mTree;
+	unsigned int mWidth;
+	unsigned int mHeight;
+	QMemArray<unsigned char> mNodeVisibility;
+	QPtrDict<BosonItem> mCollectedItems;
+	unsigned int mTestedNodes;
+	unsigned int mAcceptedNodes;
+};
+
+#endif
+
@@ -27,11 +27,13 @@
 
 BoItemList::BoItemList()
 {
+ mRegistered = false;
  registerList();
 }
 
 BoItemList::BoItemList(const BoItemList& list, bool _registerList)
 {
+ mRegistered = false;
  if (_registerList) {
 	registerList();
  }
@@ -40,6 +42,10 @@ BoItemList::BoItemList(const BoItemList& list, bool _registerList)
 
 BoItemList::~BoItemList()
 {
+ if (!mRegistered) {
+	// lists that are not registered don't need a lookup in the handler
+	return;
+ }
  BoItemListHandler* handler = BoItemListHandler::itemListHandler();
  if (handler) {
 	handler->unregisterList(this);
@@ -53,6 +59,7 @@ void BoItemList::registerList()
  BoItemListHandler* handler = BoItemListHandler::itemListHandler();
  if (handler) {
 	handler->registerList(this);
+	mRegistered = true;
  } else {
 	boWarning() << k_funcinfo << "NULL item list handler" << endl;
  }
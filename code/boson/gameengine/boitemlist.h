@@ -68,6 +68,7 @@ public:
 	BoItemList(int foobar, bool _registerList = true)
 	{
 		Q_UNUSED(foobar);
+		mRegistered = false;
 		if (_registerList) {
 			registerList();
 		}
@@ -161,6 +162,9 @@ protected:
 
 private:
 	QValueList<BosonItem*> mList;
+
+	// whether this list is known to the BoItemListHandler
+	bool mRegistered;
 };
 
 #endif
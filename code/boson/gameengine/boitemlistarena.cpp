@@ -0,0 +1,83 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "boitemlistarena.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "boitemlist.h"
+#include "bodebug.h"
+
+// initial number of lists. the arena grows by doubling.
+#define ITEM_LIST_ARENA_INITIAL_SIZE 64
+
+BoItemListArena::BoItemListArena()
+{
+ mLists = 0;
+ mSize = 0;
+ mUsed = 0;
+}
+
+BoItemListArena::~BoItemListArena()
+{
+ for (unsigned int i = 0; i < mSize; i++) {
+	delete mLists[i];
+ }
+ delete[] mLists;
+}
+
+void BoItemListArena::grow()
+{
+ unsigned int size = mSize * 2;
+ if (size == 0) {
+	size = ITEM_LIST_ARENA_INITIAL_SIZE;
+ }
+ BoItemList** lists = new BoItemList*[size];
+ for (unsigned int i = 0; i < mSize; i++) {
+	lists[i] = mLists[i];
+ }
+ for (unsigned int i = mSize; i < size; i++) {
+	lists[i] = new BoItemList(0, false);
+ }
+ delete[] mLists;
+ mLists = lists;
+ mSize = size;
+}
+
+BoItemList* BoItemListArena::allocate()
+{
+ if (mUsed == mSize) {
+	grow();
+ }
+ BoItemList* list = mLists[mUsed];
+ mUsed++;
+
+ // we clear the list here, not in rewind(), so that rewind() is O(1)
+ list->clear();
+ return list;
+}
+
+void BoItemListArena::rewind(unsigned int mark)
+{
+ if (mark > mUsed) {
+	boError() << k_funcinfo << "invalid mark " << mark << " - only " << mUsed << " lists in use" << endl;
+	return;
+ }
+ mUsed = mark;
+}
+
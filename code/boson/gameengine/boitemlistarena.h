@@ -0,0 +1,84 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOITEMLISTARENA_H
+#define BOITEMLISTARENA_H
+
+class BoItemList;
+
+/**
+ * Scratch storage for the results of collision queries, such as @ref
+ * BosonCollisions::collisionsAtCells.
+ *
+ * The arena keeps a number of (unregistered) @ref BoItemList objects that are
+ * handed out by @ref allocate. The lists are never deleted, instead all lists
+ * that were allocated since a certain @ref mark are given back to the arena
+ * by @ref rewind, in constant time. So once the arena has grown to the number
+ * of lists that are needed in an advance call, queries do not allocate any
+ * lists anymore.
+ *
+ * A list that was allocated from the arena is valid until the arena is
+ * rewound to a mark that was taken before the list was allocated. See @ref
+ * BoItemListHandler for when this happens.
+ *
+ * Note that this class is not thread safe.
+ **/
+class BoItemListArena
+{
+public:
+	BoItemListArena();
+	~BoItemListArena();
+
+	/**
+	 * @return An empty list. Do not delete it, it is owned by the arena.
+	 **/
+	BoItemList* allocate();
+
+	/**
+	 * @return A mark that can be used in @ref rewind to give back all lists
+	 * that are allocated after this call.
+	 **/
+	inline unsigned int mark() const { return mUsed; }
+
+	/**
+	 * Give back all lists that were allocated since @p mark was taken (see
+	 * @ref mark). The lists must not be used anymore afterwards.
+	 **/
+	void rewind(unsigned int mark);
+
+	/**
+	 * @return The number of lists that are currently in use.
+	 **/
+	inline unsigned int usedLists() const { return mUsed; }
+
+	/**
+	 * @return The number of lists the arena has allocated so far.
+	 **/
+	inline unsigned int size() const { return mSize; }
+
+protected:
+	void grow();
+
+private:
+	BoItemList** mLists;
+	unsigned int mSize;
+	unsigned int mUsed;
+};
+
+#endif
+
@@ -22,6 +22,7 @@
 
 #include "../../bomemory/bodummymemory.h"
 #include "boitemlist.h"
+#include "boitemlistarena.h"
 #include "../boglobal.h"
 #include "bodebug.h"
 
@@ -44,6 +45,7 @@ public:
 	{
 	}
 	QPtrList<BoItemList> mLists;
+	BoItemListArena* mArena;
 	bool mTimerActive;
 };
 
@@ -51,11 +53,13 @@ BoItemListHandler::BoItemListHandler() : QObject(0)
 {
  d = new BoItemListHandlerPrivate();
  d->mTimerActive = false;
+ d->mArena = new BoItemListArena();
 }
 
 BoItemListHandler::~BoItemListHandler()
 {
  slotDeleteLists();
+ delete d->mArena;
  delete d;
 }
 
@@ -64,9 +68,19 @@ BoItemListHandler* BoItemListHandler::itemListHandler()
  return BoGlobal::boGlobal()->boItemListHandler();
 }
 
-void BoItemListHandler::registerList(BoItemList* list)
+BoItemListArena* BoItemListHandler::arena() const
+{
+ return d->mArena;
+}
+
+BoItemList* BoItemListHandler::allocateList()
+{
+ startDeletionTimer();
+ return d->mArena->allocate();
+}
+
+void BoItemListHandler::startDeletionTimer()
 {
- d->mLists.append(list);
  if (!d->mTimerActive) {
 	// we need to delete this list once we return to the event loop.
 	 QTimer::singleShot(DELETION_DELAY, this, SLOT(slotDeleteLists()));
@@ -76,15 +90,29 @@ void BoItemListHandler::registerList(BoItemList* list)
  }
 }
 
+void BoItemListHandler::registerList(BoItemList* list)
+{
+ d->mLists.append(list);
+ startDeletionTimer();
+}
+
 void BoItemListHandler::unregisterList(BoItemList* list)
 {
  // note: d->mList is NOT autodelete=true!
+
+ // lists on the stack are usually destroyed in the reverse order of
+ // their construction, so the list is most probably the last one.
+ if (d->mLists.getLast() == list) {
+	d->mLists.removeLast();
+	return;
+ }
  d->mLists.removeRef(list);
 }
 
 void BoItemListHandler::slotDeleteLists()
 {
  d->mTimerActive = false;
+ d->mArena->rewind(0);
  QPtrList<BoItemList> lists = d->mLists;
 
  // every list's unregisters itself in its d'tor, so let's keep that fast by
@@ -20,6 +20,7 @@
 #define BOITEMLISTHANDLER_H
 
 class BoItemList;
+class BoItemListArena;
 class BoItemListHandlerPrivate;
 
 #include <qobject.h>
@@ -32,6 +33,12 @@ class BoItemListHandlerPrivate;
  *
  * BoItemListHandler uses a list internally, meaning that registering lists to
  * the handler can be done very fast (constant time).
+ *
+ * Lists that are meant as results of queries should be taken from the @ref
+ * arena instead (see @ref allocateList). They are not allocated and not
+ * registered, the arena is simply rewound once we return to the event loop.
+ * BoCanvasAdvance additionally rewinds the arena at the end of every advance
+ * call, so that an advance call does not let the arena grow.
  * @author Andreas Beckermann <b_mann@gmx.de>
  **/
 class BoItemListHandler : public QObject
@@ -46,6 +53,15 @@ public:
 	void registerList(BoItemList* list);
 	void unregisterList(BoItemList* list);
 
+	/**
+	 * @return An empty list from the @ref arena. The list is valid until we
+	 * return to the event loop, or until the arena gets rewound to an
+	 * earlier mark (see @ref BoItemListArena::rewind). Do not delete it.
+	 **/
+	BoItemList* allocateList();
+
+	BoItemListArena* arena() const;
+
 
 public slots:
 	/**
@@ -54,6 +70,9 @@ public slots:
 	 **/
 	void slotDeleteLists();
 
+protected:
+	void startDeletionTimer();
+
 private:
 	BoItemListHandlerPrivate* d;
 };
@@ -34,6 +34,9 @@
 #include <qptrqueue.h>
 #include <qbuffer.h>
 #include <qapplication.h>
+#include <qfile.h>
+
+#include <ktempfile.h>
 
 BoMessage::BoMessage(QByteArray& _message, int _msgid, Q_UINT32 _receiver, Q_UINT32 _sender, Q_UINT32 _clientId, unsigned int _advanceCallsCount)
 		: byteArray(_message),
@@ -256,17 +259,92 @@ BoMessageLogger::BoMessageLogger()
 {
  mLoggedMessages = new QPtrList<BoMessage>();
  mLoggedMessages->setAutoDelete(true);
+ mSpillFile = 0;
+ mSpilledMessages = 0;
+ mMaxMessagesInMemory = 0;
 }
 
 BoMessageLogger::~BoMessageLogger()
 {
  mLoggedMessages->clear();
  delete mLoggedMessages;
+ delete mSpillFile;
 }
 
 void BoMessageLogger::append(BoMessage* message)
 {
  mLoggedMessages->append(message);
+ if (mMaxMessagesInMemory > 0 && mLoggedMessages->count() > mMaxMessagesInMemory) {
+	// spill more than one message at once, so that we don't have to
+	// touch the file on every message
+	unsigned int keep = QMAX((unsigned int)1, mMaxMessagesInMemory / 2);
+	if (!spillMessages(mLoggedMessages->count() - keep)) {
+		boWarning() << k_funcinfo << "could not spill messages to disk. keeping all messages in memory." << endl;
+		mMaxMessagesInMemory = 0;
+	}
+ }
+}
+
+unsigned int BoMessageLogger::messageCount() const
+{
+ return mSpilledMessages + mLoggedMessages->count();
+}
+
+void BoMessageLogger::setMaxMessagesInMemory(unsigned int max)
+{
+ mMaxMessagesInMemory = max;
+}
+
+bool BoMessageLogger::spillMessages(unsigned int count)
+{
+ if (!mSpillFile) {
+	mSpillFile = new KTempFile(QString::null, QString::fromLatin1(".messagelog"));
+	mSpillFile->setAutoDelete(true);
+	if (mSpillFile->status() != 0 || !mSpillFile->file()) {
+		boError() << k_funcinfo << "could not create temporary file" << endl;
+		delete mSpillFile;
+		mSpillFile = 0;
+		return false;
+	}
+ }
+ QDataStream* stream = mSpillFile->dataStream();
+ if (!stream) {
+	BO_NULL_ERROR(stream);
+	return false;
+ }
+ for (unsigned int i = 0; i < count && !mLoggedMessages->isEmpty(); i++) {
+	saveMessage(*stream, mLoggedMessages->getFirst());
+	mLoggedMessages->removeFirst();
+	mSpilledMessages++;
+ }
+ mSpillFile->file()->flush();
+ return true;
+}
+
+QIODevice* BoMessageLogger::openSpilledMessages() const
+{
+ if (!mSpillFile || mSpilledMessages == 0) {
+	return 0;
+ }
+ mSpillFile->file()->flush();
+ QFile* file = new QFile(mSpillFile->name());
+ if (!file->open(IO_ReadOnly)) {
+	boError() << k_funcinfo << "could not open " << mSpillFile->name() << endl;
+	delete file;
+	return 0;
+ }
+ return file;
+}
+
+static void writeHumanReadableMessage(QTextStream& log, const BoMessage* m)
+{
+ log << "Msg: " << m->deliveredOnAdvanceCallsCount << "  "
+		<< m->msgid << "  "
+		<< m->sender << " "
+		<< m->receiver << " "
+		<< m->clientId << "  ";
+ log.writeRawBytes(m->byteArray.data(), m->byteArray.size());
+ log << endl;
 }
 
 bool BoMessageLogger::saveHumanReadableMessageLog(QIODevice* logDevice)
@@ -280,16 +358,22 @@ bool BoMessageLogger::saveHumanReadableMessageLog(QIODevice* logDevice)
 	return false;
  }
  QTextStream log(logDevice);
+ if (mSpilledMessages > 0) {
+	QIODevice* spilled = openSpilledMessages();
+	if (!spilled) {
+		return false;
+	}
+	QDataStream spilledStream(spilled);
+	for (unsigned int i = 0; i < mSpilledMessages; i++) {
+		BoMessage* m = loadMessage(spilledStream);
+		writeHumanReadableMessage(log, m);
+		delete m;
+	}
+	delete spilled;
+ }
  QPtrListIterator<BoMessage> it(*mLoggedMessages);
  while (it.current()) {
-	const BoMessage* m = it.current();
-	log << "Msg: " << m->deliveredOnAdvanceCallsCount << "  "
-			<< m->msgid << "  "
-			<< m->sender << " "
-			<< m->receiver << " "
-			<< m->clientId << "  ";
-	log.writeRawBytes(m->byteArray.data(), m->byteArray.size());
-	log << endl;
+	writeHumanReadableMessage(log, it.current());
 	++it;
  }
  return true;
@@ -305,29 +389,81 @@ bool BoMessageLogger::saveMessageLog(QIODevice* logDevice, unsigned int maxCount
 	boError() << k_funcinfo << "device not open" << endl;
 	return false;
  }
+ unsigned int skip = 0;
+ if (maxCount > 0 && messageCount() > maxCount) {
+	skip = messageCount() - maxCount;
+ }
  QDataStream stream(logDevice);
- stream << (Q_UINT32)mLoggedMessages->count();
- QPtrListIterator<BoMessage> it(*mLoggedMessages);
- if (maxCount > 0 && mLoggedMessages->count() > maxCount) {
-	unsigned int diff = mLoggedMessages->count() - maxCount;
-	it += diff;
+ stream << (Q_UINT32)(messageCount() - skip);
+ if (skip < mSpilledMessages) {
+	QIODevice* spilled = openSpilledMessages();
+	if (!spilled) {
+		return false;
+	}
+	QDataStream spilledStream(spilled);
+	for (unsigned int i = 0; i < mSpilledMessages; i++) {
+		BoMessage* m = loadMessage(spilledStream);
+		if (i >= skip) {
+			saveMessage(stream, m);
+		}
+		delete m;
+	}
+	delete spilled;
+	skip = 0;
+ } else {
+	skip -= mSpilledMessages;
  }
+ QPtrListIterator<BoMessage> it(*mLoggedMessages);
+ it += skip;
  while (it.current()) {
-	const BoMessage* m = it.current();
-	stream << (Q_UINT32)m->deliveredOnAdvanceCallsCount;
-	stream << (Q_INT32)m->msgid;
-	stream << (Q_UINT32)m->sender;
-	stream << (Q_UINT32)m->receiver;
-	stream << (Q_UINT32)m->clientId;
-	stream << m->mArrivalTime;
-	stream << m->mDeliveryTime;
-	stream << m->byteArray;
+	saveMessage(stream, it.current());
 	++it;
  }
  return true;
 }
 
-bool BoMessageLogger::loadMessageLog(QIODevice* logDevice, QPtrList<BoMessage>* messages)
+void BoMessageLogger::saveMessage(QDataStream& stream, const BoMessage* m)
+{
+ stream << (Q_UINT32)m->deliveredOnAdvanceCallsCount;
+ stream << (Q_INT32)m->msgid;
+ stream << (Q_UINT32)m->sender;
+ stream << (Q_UINT32)m->receiver;
+ stream << (Q_UINT32)m->clientId;
+ stream << m->mArrivalTime;
+ stream << m->mDeliveryTime;
+ stream << m->byteArray;
+}
+
+BoMessage* BoMessageLogger::loadMessage(QDataStream& stream)
+{
+ // AB: we log when the message was delivered _only_
+ // -> receiving of the message is not interesting and makes comparing
+ // network logs very hard (diffs are useless then)
+ Q_UINT32 deliveredOnAdvanceCallsCount;
+ Q_INT32 msgid;
+ Q_UINT32 sender;
+ Q_UINT32 receiver;
+ Q_UINT32 clientId;
+ QTime arrivalTime;
+ QTime deliveryTime;
+ QByteArray byteArray;
+ stream >> deliveredOnAdvanceCallsCount;
+ stream >> msgid;
+ stream >> sender;
+ stream >> receiver;
+ stream >> clientId;
+ stream >> arrivalTime;
+ stream >> deliveryTime;
+ stream >> byteArray;
+
+ BoMessage* m = new BoMessage(byteArray, msgid, receiver, sender, clientId, deliveredOnAdvanceCallsCount);
+ m->deliveredOnAdvanceCallsCount = deliveredOnAdvanceCallsCount;
+ m->mArrivalTime = arrivalTime;
+ m->mDeliveryTime = deliveryTime;
+ return m;
+}
+
+bool BoMessageLogger::loadMessageLog(QIODevice* logDevice, QPtrList<BoMessage>* messages, unsigned int skip)
 {
  if (!logDevice) {
 	BO_NULL_ERROR(logDevice);
@@ -349,31 +485,16 @@ bool BoMessageLogger::loadMessageLog(QIODevice* logDevice, QPtrList<BoMessage>*
  Q_UINT32 count;
  stream >> count;
  for (unsigned int i = 0; i < count; i++) {
-	// AB: we log when the message was delivered _only_
-	// -> receiving of the message is not interesting and makes comparing
-	// network logs very hard (diffs are useless then)
-	Q_UINT32 deliveredOnAdvanceCallsCount;
-	Q_INT32 msgid;
-	Q_UINT32 sender;
-	Q_UINT32 receiver;
-	Q_UINT32 clientId;
-	QTime arrivalTime;
-	QTime deliveryTime;
-	QByteArray byteArray;
-	stream >> deliveredOnAdvanceCallsCount;
-	stream >> msgid;
-	stream >> sender;
-	stream >> receiver;
-	stream >> clientId;
-	stream >> arrivalTime;
-	stream >> deliveryTime;
-	stream >> byteArray;
-
-	BoMessage* m = new BoMessage(byteArray, msgid, receiver, sender, clientId, deliveredOnAdvanceCallsCount);
-	m->mArrivalTime = arrivalTime;
-	m->mDeliveryTime = deliveryTime;
+	if (logDevice->atEnd()) {
+		boError() << k_funcinfo << "log ends after " << i << " of " << count << " messages" << endl;
+		return false;
+	}
+	BoMessage* m = loadMessage(stream);
+	if (i < skip) {
+		delete m;
+		continue;
+	}
 	messages->append(m);
  }
  return true;
 }
-
@@ -28,6 +28,8 @@ class Boson;
 template<class T> class QPtrQueue;
 template<class T> class QPtrList;
 class QIODevice;
+class QDataStream;
+class KTempFile;
 
 /**
  * @short Helper class for @ref Boson.
@@ -145,9 +147,11 @@ private:
 
 /**
  * @short This class keeps a log of all messages received by now
+ *
+ * Only the most recent messages are kept in memory (see @ref
+ * setMaxMessagesInMemory), older messages are spilled to a temporary file.
+ * Saving the log (see @ref saveMessageLog) always writes all messages.
  **/
-// AB: after a certain time / number of messages we should delete old messages,
-// in order to save memory
 class BoMessageLogger
 {
 public:
@@ -160,12 +164,48 @@ public:
 	 **/
 	void append(BoMessage* message);
 
+	/**
+	 * @return The number of messages that have been logged so far,
+	 * including the messages that have been spilled to disk.
+	 **/
+	unsigned int messageCount() const;
+
+	/**
+	 * Keep at most @p max messages in memory. Once there are more messages,
+	 * the oldest messages are written to a temporary file, until only half
+	 * of @p max messages are left in memory. 0 keeps all messages in
+	 * memory (the default).
+	 **/
+	void setMaxMessagesInMemory(unsigned int max);
+
 	bool saveHumanReadableMessageLog(QIODevice* logDevice);
 	bool saveMessageLog(QIODevice* logDevice, unsigned int maxCount = 0);
-	static bool loadMessageLog(QIODevice* logDevice, QPtrList<BoMessage>* messages);
+
+	/**
+	 * Load the messages of a log written by @ref saveMessageLog into @p
+	 * messages. The first @p skip messages of the log are skipped, i.e.
+	 * they are not added to @p messages.
+	 **/
+	static bool loadMessageLog(QIODevice* logDevice, QPtrList<BoMessage>* messages, unsigned int skip = 0);
+
+	static void saveMessage(QDataStream& stream, const BoMessage* m);
+	static BoMessage* loadMessage(QDataStream& stream);
+
+protected:
+	bool spillMessages(unsigned int count);
+
+	/**
+	 * @return A newly opened device for reading the spilled messages or
+	 * NULL if no messages have been spilled. The device must be deleted by
+	 * the caller.
+	 **/
+	QIODevice* openSpilledMessages() const;
 
 private:
 	QPtrList<BoMessage>* mLoggedMessages;
+	KTempFile* mSpillFile;
+	unsigned int mSpilledMessages;
+	unsigned int mMaxMessagesInMemory;
 };
 
 #endif
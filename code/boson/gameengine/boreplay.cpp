@@ -0,0 +1,159 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "boreplay.h"
+
+#include "../bomemory/bodummymemory.h"
+#include "bomessage.h"
+#include "bpfloader.h"
+#include "bodebug.h"
+
+#include <kgame/kgamemessage.h>
+
+#include <qptrlist.h>
+#include <qdatastream.h>
+
+BoReplayKeyframe::BoReplayKeyframe()
+{
+ advanceCallsCount = 0;
+ messageIndex = 0;
+ randomSeed = 0;
+}
+
+void BoReplayKeyframe::save(QDataStream& stream) const
+{
+ stream << (Q_UINT32)advanceCallsCount;
+ stream << (Q_UINT32)messageIndex;
+ stream << (Q_INT32)randomSeed;
+ stream << playerIds;
+ stream << compressedFiles;
+}
+
+bool BoReplayKeyframe::load(QDataStream& stream)
+{
+ if (stream.atEnd()) {
+	boError() << k_funcinfo << "unexpected end of stream" << endl;
+	return false;
+ }
+ Q_UINT32 advanceCalls;
+ Q_UINT32 index;
+ Q_INT32 seed;
+ stream >> advanceCalls;
+ stream >> index;
+ stream >> seed;
+ stream >> playerIds;
+ stream >> compressedFiles;
+ advanceCallsCount = advanceCalls;
+ messageIndex = index;
+ randomSeed = seed;
+ return true;
+}
+
+bool BoReplayKeyframe::files(QMap<QString, QByteArray>& files) const
+{
+ QByteArray buffer = qUncompress(compressedFiles);
+ if (buffer.size() == 0) {
+	boError() << k_funcinfo << "keyframe at advance call " << advanceCallsCount << " has no data" << endl;
+	return false;
+ }
+ return BPFLoader::unstreamFiles(files, buffer);
+}
+
+
+bool BoReplay::saveReplay(QIODevice* device, BoMessageLogger* messages, const QPtrList<BoReplayKeyframe>& keyframes)
+{
+ BO_CHECK_NULL_RET0(device);
+ BO_CHECK_NULL_RET0(messages);
+ if (!device->isOpen()) {
+	boError() << k_funcinfo << "device not open" << endl;
+	return false;
+ }
+ QDataStream stream(device);
+ stream << (Q_UINT32)Magic;
+ stream << (Q_UINT32)FormatVersion;
+ stream << (Q_UINT32)keyframes.count();
+ for (QPtrListIterator<BoReplayKeyframe> it(keyframes); it.current(); ++it) {
+	it.current()->save(stream);
+ }
+ return messages->saveMessageLog(device);
+}
+
+bool BoReplay::loadKeyframes(QIODevice* device, QPtrList<BoReplayKeyframe>* keyframes)
+{
+ BO_CHECK_NULL_RET0(device);
+ BO_CHECK_NULL_RET0(keyframes);
+ if (!device->isOpen()) {
+	boError() << k_funcinfo << "device not open" << endl;
+	return false;
+ }
+ QDataStream stream(device);
+ Q_UINT32 magic;
+ Q_UINT32 version;
+ stream >> magic;
+ stream >> version;
+ if (magic != (Q_UINT32)Magic) {
+	boError() << k_funcinfo << "not a replay file" << endl;
+	return false;
+ }
+ if (version != (Q_UINT32)FormatVersion) {
+	boError() << k_funcinfo << "unsupported replay version " << version << endl;
+	return false;
+ }
+ Q_UINT32 count;
+ stream >> count;
+ for (unsigned int i = 0; i < count; i++) {
+	BoReplayKeyframe* keyframe = new BoReplayKeyframe();
+	if (!keyframe->load(stream)) {
+		boError() << k_funcinfo << "could not load keyframe " << i << endl;
+		delete keyframe;
+		return false;
+	}
+	keyframes->append(keyframe);
+ }
+ return true;
+}
+
+BoReplayKeyframe* BoReplay::findKeyframe(const QPtrList<BoReplayKeyframe>& keyframes, unsigned int advanceCallsCount)
+{
+ BoReplayKeyframe* best = 0;
+ for (QPtrListIterator<BoReplayKeyframe> it(keyframes); it.current(); ++it) {
+	if (it.current()->advanceCallsCount > advanceCallsCount) {
+		continue;
+	}
+	if (!best || it.current()->advanceCallsCount >= best->advanceCallsCount) {
+		best = it.current();
+	}
+ }
+ return best;
+}
+
+void BoReplay::mapPlayerIds(QPtrList<BoMessage>* messages, const QMap<Q_UINT32, Q_UINT32>& oldToNew)
+{
+ BO_CHECK_NULL_RET(messages);
+ for (QPtrListIterator<BoMessage> it(*messages); it.current(); ++it) {
+	BoMessage* m = it.current();
+	if (KGameMessage::isPlayer(m->receiver) && oldToNew.contains(m->receiver)) {
+		m->receiver = oldToNew[m->receiver];
+	}
+	if (KGameMessage::isPlayer(m->sender) && oldToNew.contains(m->sender)) {
+		m->sender = oldToNew[m->sender];
+	}
+ }
+}
+
@@ -0,0 +1,126 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOREPLAY_H
+#define BOREPLAY_H
+
+#include <qglobal.h>
+#include <qcstring.h>
+#include <qmap.h>
+
+class BoMessage;
+class BoMessageLogger;
+class QIODevice;
+class QDataStream;
+template<class T> class QPtrList;
+
+/**
+ * A keyframe of a replay, i.e. a complete savegame of the game at a certain
+ * advance call. A replay can be started at a keyframe instead of at the
+ * beginning of the game, see @ref BoReplay.
+ *
+ * Keyframes are taken when a @ref BosonMessageIds::IdReplayKeyframe message
+ * is delivered. This message sets a new random seed, as the state of the
+ * random number generator cannot be saved into a savegame. It is delivered
+ * between two advance messages only, so no advance call is in progress.
+ **/
+class BoReplayKeyframe
+{
+public:
+	BoReplayKeyframe();
+
+	void save(QDataStream& stream) const;
+	bool load(QDataStream& stream);
+
+	/**
+	 * @return The savegame files of this keyframe, see @ref
+	 * BosonSaveLoad::saveToFiles.
+	 **/
+	bool files(QMap<QString, QByteArray>& files) const;
+
+public:
+	unsigned int advanceCallsCount;
+
+	/**
+	 * The number of messages that have been logged when the keyframe was
+	 * taken (including the IdReplayKeyframe message). The replay continues
+	 * with the message at this index of the message log.
+	 **/
+	unsigned int messageIndex;
+
+	/**
+	 * The random seed that was set by the IdReplayKeyframe message.
+	 **/
+	Q_INT32 randomSeed;
+
+	/**
+	 * Maps the KGame ID of a player to its user ID (see @ref
+	 * KPlayer::userId). Messages to players use the KGame ID, which
+	 * depends on the order in which the players were added to the game.
+	 **/
+	QMap<Q_UINT32, Q_UINT32> playerIds;
+
+	/**
+	 * The savegame files streamed by @ref BPFLoader::streamFiles and
+	 * compressed.
+	 **/
+	QByteArray compressedFiles;
+};
+
+/**
+ * A replay file contains the message log of a game (see @ref
+ * BoMessageLogger) and the keyframes (see @ref BoReplayKeyframe) that were
+ * taken during the game.
+ *
+ * The file starts with @ref Magic and @ref FormatVersion, followed by the
+ * keyframes. The message log follows the keyframes, so that a replay can
+ * read the keyframes first and then load only the messages after the keyframe
+ * it starts at.
+ **/
+class BoReplay
+{
+public:
+	enum {
+		Magic = 0x424f5250, // "BORP"
+		FormatVersion = 1
+	};
+
+	static bool saveReplay(QIODevice* device, BoMessageLogger* messages, const QPtrList<BoReplayKeyframe>& keyframes);
+
+	/**
+	 * Read the header and the keyframes of a replay file. The device is at
+	 * the beginning of the message log afterwards, see @ref
+	 * BoMessageLogger::loadMessageLog.
+	 **/
+	static bool loadKeyframes(QIODevice* device, QPtrList<BoReplayKeyframe>* keyframes);
+
+	/**
+	 * @return The last keyframe in @p keyframes that was taken before
+	 * (or at) @p advanceCallsCount, or NULL if there is no such keyframe.
+	 **/
+	static BoReplayKeyframe* findKeyframe(const QPtrList<BoReplayKeyframe>& keyframes, unsigned int advanceCallsCount);
+
+	/**
+	 * Replace the KGame IDs of the players in the receiver and sender of
+	 * @p messages by the IDs in @p oldToNew.
+	 **/
+	static void mapPlayerIds(QPtrList<BoMessage>* messages, const QMap<Q_UINT32, Q_UINT32>& oldToNew);
+};
+
+#endif
+
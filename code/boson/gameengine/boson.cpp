@@ -42,6 +42,8 @@
 #include "boevent.h"
 #include "boeventmanager.h"
 #include "bomessage.h"
+#include "boreplay.h"
+#include "bpfloader.h"
 #include "bosonplayerinputhandler.h"
 #include "bosonnetworksynchronizer.h"
 #include "bosonnetworktraffic.h"
@@ -49,8 +51,10 @@
 #include "bosonpath.h"
 #include "bosonmap.h"
 #include "bosonplayerlistmanager.h"
+#include "script/bosonscript.h"
 
 #include <klocale.h>
+#include <kapplication.h>
 #include <kdeversion.h>
 #include <kcrash.h>
 #include <kgame/kgameio.h>
@@ -233,7 +237,7 @@ void BoAdvance::receiveAdvanceCall()
 {
  BO_CHECK_NULL_RET(mCurrentAdvanceMessageTimes);
 
- BoEvent* advanceEvent = new BoEvent("Advance");
+ BoEvent* advanceEvent = BoEvent::create("Advance");
  mBoson->queueEvent(advanceEvent);
 
  mCurrentAdvanceMessageTimes->receiveAdvanceCall();
@@ -254,6 +258,10 @@ void BoAdvance::receiveAdvanceCall()
 	}
 	emit mBoson->signalAdvance(advanceCallsCount(), flag);
  }
+ // the scripts (called by the event listeners) share a snapshot of the units
+ // that is taken once per advance call
+ BosonScript::invalidateUnitSnapshot();
+
  // AB: do _not_ connect to the signal!
  // -> slots may be called in random order, but we need well defined order
  // (otherwise network may get broken soon)
@@ -298,6 +306,7 @@ public:
 	QValueList<QByteArray> mGameLogs;
 	QValueList<QByteArray> mUnitLogs;
 	BoMessageLogger mMessageLogger;
+	QPtrList<BoReplayKeyframe> mReplayKeyframes;
 
 	BoAdvance* mAdvance;
 	BoMessageDelayer* mMessageDelayer;
@@ -312,6 +321,9 @@ public:
 
 	bool mGameIsOver;
 	bool mLoadFromLogMode;
+
+	bool mFastAdvance;
+	bool mFastAdvanceMessagePending;
 };
 
 
@@ -324,6 +336,7 @@ public:
 
 protected:
 	bool saveMessageLog();
+	bool saveReplay();
 	bool saveGameLog();
 	bool saveUnitLog();
 	bool saveNetworkLog();
@@ -353,6 +366,10 @@ bool BoGameLogSaver::save()
 	boError() << k_funcinfo << "failed saving message log" << endl;
 	ret = false;
  }
+ if (!saveReplay()) {
+	boError() << k_funcinfo << "failed saving replay" << endl;
+	ret = false;
+ }
  if (!saveGameLog()) {
 	boError() << k_funcinfo << "failed saving game log" << endl;
 	ret = false;
@@ -398,6 +415,27 @@ bool BoGameLogSaver::saveMessageLog()
  return true;
 }
 
+bool BoGameLogSaver::saveReplay()
+{
+ // the replay contains the message log, too. it is useful only if it has
+ // keyframes.
+ if (d->mReplayKeyframes.isEmpty()) {
+	return true;
+ }
+ QFile replay(mPrefix + ".replay");
+ if (!replay.open(IO_WriteOnly)) {
+	boError() << k_funcinfo << "Can't open output file '" << replay.name() << "' for writing!" << endl;
+	return false;
+ }
+ if (!BoReplay::saveReplay(&replay, &d->mMessageLogger, d->mReplayKeyframes)) {
+	boError() << k_funcinfo << "unable to write replay" << endl;
+	return false;
+ }
+ replay.close();
+ boDebug() << k_funcinfo << "replay with " << d->mReplayKeyframes.count() << " keyframes saved to " << replay.name() << endl;
+ return true;
+}
+
 bool BoGameLogSaver::saveGameLog()
 {
  QFile gameLog(mPrefix + ".gamelog");
@@ -535,6 +573,7 @@ Boson::Boson(QObject* parent) : KGame(BOSON_COOKIE, parent)
 
  d->mNetworkSynchronizer->setGame(this);
  d->mNetworkSynchronizer->setMessageLogger(&d->mMessageLogger);
+ d->mReplayKeyframes.setAutoDelete(true);
  d->mNetworkTraffic->setBoson(this);
  d->mGameStatistics->setGame(this);
 
@@ -542,6 +581,8 @@ Boson::Boson(QObject* parent) : KGame(BOSON_COOKIE, parent)
  mGameMode = true;
  d->mGameIsOver = false;
  d->mLoadFromLogMode = false;
+ d->mFastAdvance = false;
+ d->mFastAdvanceMessagePending = false;
 
  connect(this, SIGNAL(signalNetworkData(int, const QByteArray&, Q_UINT32, Q_UINT32)),
 		this, SLOT(slotNetworkData(int, const QByteArray&, Q_UINT32, Q_UINT32)));
@@ -631,6 +672,7 @@ bool Boson::createCanvas(BosonMap* map)
 	return false;
  }
  d->mCanvas = new BosonCanvas(advanceFlag(), this, gameMode());
+ d->mCanvas->setAdvanceWorkerCount(boConfig->uintValue("AdvanceWorkerThreads"));
  connect(d->mCanvas, SIGNAL(signalGameOver()),
 		this, SLOT(slotGameOver()));
  if (!d->mCanvas->init(map, playerListManager(), eventManager())) {
@@ -660,6 +702,10 @@ bool Boson::event(QEvent* e)
 		boDebug(300) << k_funcinfo << "delayed messages: "
 				<< delayedMessageCount() << endl;
 		unlock();
+		if (d->mFastAdvanceMessagePending) {
+			d->mFastAdvanceMessagePending = false;
+			sendFastAdvance();
+		}
 		return true;
 	default:
 		break;
@@ -775,6 +821,7 @@ void Boson::quitGame()
 	d->mCanvas->quitGame();
  }
  d->mGameTimer->stop();
+ d->mFastAdvanceMessagePending = false;
  setGameStatus(KGame::End);
 
  // remove all players from game
@@ -903,6 +950,7 @@ void Boson::slotNetworkData(int msgid, const QByteArray& buffer, Q_UINT32 , Q_UI
 			break;
 		}
 		d->mGameIsOver = false;
+		d->mMessageLogger.setMaxMessagesInMemory(boConfig->uintValue("MaxLoggedMessagesInMemory"));
 
 		emit signalGameStarted();
 
@@ -1076,6 +1124,32 @@ void Boson::slotNetworkData(int msgid, const QByteArray& buffer, Q_UINT32 , Q_UI
 		syncNetwork();
 		break;
 	}
+	case BosonMessageIds::IdReplayKeyframe:
+	{
+		Q_INT32 seed;
+		stream >> seed;
+		random()->setSeed(seed);
+
+		// the pending path requests and the caches of the pathfinder
+		// are not in the keyframe. all clients and all replays of this
+		// game get rid of them here, so that a replay that starts at the
+		// keyframe continues exactly like the game.
+		if (canvas()) {
+			canvas()->pathFinder()->flushPathRequests();
+		}
+		if (!d->mLoadFromLogMode) {
+			if (!takeReplayKeyframe(seed)) {
+				boWarning() << k_funcinfo << "could not take keyframe at advance call " << advanceCallsCount() << endl;
+			}
+		}
+		break;
+	}
+	case BosonMessageIds::IdNetworkSyncCheckRequestLog:
+	{
+		BO_CHECK_NULL_RET(canvas());
+		d->mNetworkSynchronizer->receiveNetworkSyncCheckRequestLog(stream);
+		break;
+	}
 	case BosonMessageIds::IdNetworkRequestSync:
 	{
 		BO_CHECK_NULL_RET(canvas());
@@ -1180,6 +1254,33 @@ bool Boson::gamePaused() const
  return d->mGamePaused;
 }
 
+void Boson::setFastAdvance(bool fast)
+{
+ d->mFastAdvance = fast;
+ if (qApp && qApp->eventLoop() && qApp->eventLoop()->isA("BoEventLoop")) {
+	((BoEventLoop*)qApp->eventLoop())->setFastAdvance(fast);
+ }
+}
+
+bool Boson::fastAdvance() const
+{
+ return d->mFastAdvance;
+}
+
+void Boson::sendFastAdvance()
+{
+ // in fast advance mode there is at most one advance message on its way.
+ // the next message is sent once all advance calls for it have been made.
+ if (!d->mFastAdvance || d->mFastAdvanceMessagePending) {
+	return;
+ }
+ if (!isServer() || gameSpeed() == 0 || gamePaused() || d->mGameIsOver) {
+	return;
+ }
+ d->mFastAdvanceMessagePending = true;
+ slotSendAdvance();
+}
+
 void Boson::slotSetGameSpeed(int speed)
 {
  boDebug() << k_funcinfo << " speed = " << speed << endl;
@@ -1221,7 +1322,9 @@ void Boson::slotPropertyChanged(KGamePropertyBase* p)
  switch (p->id()) {
 	case IdGameSpeed:
 		boDebug() << k_funcinfo << "speed has changed, new speed: " << gameSpeed() << endl;
-		if (isServer()) {
+		if (isServer() && d->mFastAdvance) {
+			sendFastAdvance();
+		} else if (isServer()) {
 			if (d->mGameSpeed == 0) {
 				if (d->mGameTimer->isActive()) {
 					boDebug() << "pausing" << endl;
@@ -1245,7 +1348,11 @@ void Boson::slotPropertyChanged(KGamePropertyBase* p)
 		} else if (d->mGameSpeed > 0) {
 			boDebug() << k_funcinfo << "starting timer again" << endl;
 			slotAddChatSystemMessage(i18n("The game is not paused anymore"));
-			d->mGameTimer->start(advanceMessageInterval());
+			if (d->mFastAdvance) {
+				sendFastAdvance();
+			} else {
+				d->mGameTimer->start(advanceMessageInterval());
+			}
 		}
 		break;
 	default:
@@ -1376,12 +1483,64 @@ void Boson::slotReceiveAdvance()
  makeUnitLog();
 #endif
 
+ // the message is delayed until all advance calls of the current advance
+ // message have been made, so the keyframe is taken between two advance
+ // messages.
+ if (isAdmin() && !d->mLoadFromLogMode && advanceCallsCount() > 0) {
+	unsigned int interval = boConfig->uintValue("ReplayKeyframeInterval");
+	if (interval > 0 && advanceCallsCount() % interval == 0) {
+		sendReplayKeyframe();
+	}
+ }
+
  d->mAdvance->receiveAdvanceCall();
 }
 
+void Boson::sendReplayKeyframe()
+{
+ QByteArray buffer;
+ QDataStream stream(buffer, IO_WriteOnly);
+ // do NOT use random() here - it is in sync on all clients and must not
+ // be used by the ADMIN only.
+ stream << (Q_INT32)(KApplication::random() % 65535);
+ sendMessage(buffer, BosonMessageIds::IdReplayKeyframe);
+}
+
+bool Boson::takeReplayKeyframe(Q_INT32 seed)
+{
+ BosonProfiler p("takeReplayKeyframe");
+ BoReplayKeyframe* keyframe = new BoReplayKeyframe();
+ keyframe->advanceCallsCount = advanceCallsCount();
+ keyframe->messageIndex = d->mMessageLogger.messageCount();
+ keyframe->randomSeed = seed;
+ for (QPtrListIterator<Player> it(allPlayerList()); it.current(); ++it) {
+	keyframe->playerIds.insert(it.current()->kgameId(), it.current()->userId());
+ }
+
+ // the binary canvas is a lot faster to save and a lot smaller
+ QMap<QString, QByteArray> files;
+ BosonSaveLoad* save = new BosonSaveLoad(this);
+ bool ret = save->saveToFiles(files, true);
+ delete save;
+ if (!ret) {
+	boError() << k_funcinfo << "saving failed" << endl;
+	delete keyframe;
+	return false;
+ }
+ keyframe->compressedFiles = qCompress(BPFLoader::streamFiles(files));
+ d->mReplayKeyframes.append(keyframe);
+ boDebug() << k_funcinfo << "took keyframe at advance call " << keyframe->advanceCallsCount
+		<< " (" << keyframe->compressedFiles.size() << " bytes) in " << p.elapsedSinceStart() << "us" << endl;
+ return true;
+}
+
 void Boson::setLoadFromLogComplete()
 {
+ if (!d->mLoadFromLogMode) {
+	return;
+ }
  d->mLoadFromLogMode = false;
+ emit signalLoadFromLogCompleted();
 }
 
 void Boson::networkTransmission(QDataStream& stream, int msgid, Q_UINT32 r, Q_UINT32 s, Q_UINT32 clientId)
@@ -1501,7 +1660,7 @@ bool Boson::saveToFile(const QString& file)
  boDebug() << k_funcinfo << file << endl;
  QMap<QString, QByteArray> files;
  BosonSaveLoad* save = new BosonSaveLoad(this);
- bool ret = save->saveToFiles(files);
+ bool ret = save->saveToFiles(files, boConfig->boolValue("BinarySaveGames"));
  delete save;
  if (!ret) {
 	boError() << k_funcinfo << "saving failed" << endl;
@@ -1962,6 +2121,11 @@ const BosonNetworkTraffic* Boson::networkTraffic() const
  return d->mNetworkTraffic;
 }
 
+BosonNetworkTraffic* Boson::networkTraffic()
+{
+ return d->mNetworkTraffic;
+}
+
 const QPtrList<BoAdvanceMessageTimes>& Boson::advanceMessageTimes() const
 {
  return d->mAdvance->advanceMessageTimes();
@@ -172,6 +172,18 @@ public:
 	int gameSpeed() const;
 	bool gamePaused() const;
 
+	/**
+	 * In fast advance mode the ADMIN sends the next advance message as soon
+	 * as all advance calls of the previous message have been made, instead
+	 * of waiting for the advance timer. The advance calls of a message are
+	 * made immediately, too (see @ref BoEventLoop::setFastAdvance).
+	 *
+	 * This is meant for benchmarks, it makes no sense in a network game.
+	 * Must be set before the game is started.
+	 **/
+	void setFastAdvance(bool fast);
+	bool fastAdvance() const;
+
 	/**
 	 * Add the neutral player. This player contains all "dummy" objects and
 	 * units (such as houses, trees, rocks, civilians, ...) that do nothing
@@ -347,6 +359,7 @@ public:
 	void setLoadFromLogComplete();
 
 	const BosonNetworkTraffic* networkTraffic() const;
+	BosonNetworkTraffic* networkTraffic();
 
 	// for debugging
 	const QPtrList<BoAdvanceMessageTimes>& advanceMessageTimes() const;
@@ -529,6 +542,12 @@ signals:
 	 **/
 	void signalGameOver();
 
+	/**
+	 * Emitted when all messages of a "loadfromlog" run have been delivered,
+	 * see @ref loadFromLog.
+	 **/
+	void signalLoadFromLogCompleted();
+
 	/**
 	 * Tell the map to change @ref BosonMap::texMap at coordinates @p x, @p
 	 * y.
@@ -566,6 +585,12 @@ protected:
 	virtual void systemAddPlayer(KPlayer* p);
 	virtual void systemRemovePlayer(KPlayer* p, bool deleteIt);
 
+	/**
+	 * Send the next advance message in fast advance mode, see @ref
+	 * setFastAdvance.
+	 **/
+	void sendFastAdvance();
+
 	/**
 	 * Create a game log (see @ref writeGameLog) and store it for later use (see
 	 * @ref saveGameLogs).
@@ -575,6 +600,20 @@ protected:
 
 	bool loadFromLogFile(const QString& file);
 
+	/**
+	 * Send a @ref BosonMessageIds::IdReplayKeyframe message with a new
+	 * random seed. This is done by the ADMIN every
+	 * "ReplayKeyframeInterval" advance calls.
+	 **/
+	void sendReplayKeyframe();
+
+	/**
+	 * Save the current game into a new @ref BoReplayKeyframe. Called when a
+	 * @ref BosonMessageIds::IdReplayKeyframe message is delivered. The
+	 * keyframes are saved with the game logs, see @ref saveGameLogs.
+	 **/
+	bool takeReplayKeyframe(Q_INT32 seed);
+
 	void clearUndoStacks();
 
 	bool changeUserIdOfPlayer(Player* p, unsigned int newId);
@@ -34,6 +34,7 @@
 #include "speciestheme.h"
 #include "boitemlist.h"
 #include "boitemlisthandler.h"
+#include "boitemlistarena.h"
 #include "defines.h"
 #include "bosonshot.h"
 #include "bosonweapon.h"
@@ -50,6 +51,9 @@
 #include "playerio.h"
 #include "boeventmanager.h"
 #include "bosonplayerlistmanager.h"
+#include "boadvanceworkerpool.h"
+#include "bobinarysavegame.h"
+#include "bosonmessage.h"
 
 #include <klocale.h>
 #include <kgame/kgamepropertyhandler.h>
@@ -57,7 +61,10 @@
 #include <qpointarray.h>
 #include <qdatastream.h>
 #include <qdom.h>
+#include <qbuffer.h>
 #include <qintdict.h>
+#include <qmap.h>
+#include <qvaluevector.h>
 
 #include <math.h>
 
@@ -98,6 +105,7 @@ public:
 		mEventManager = 0;
 		mEventListener = 0;
 		mSightManager = 0;
+		mWorkerPool = 0;
 	}
 	bool mGameMode;
 	bool mAdvanceFlag;
@@ -129,6 +137,8 @@ public:
 
 	BosonPath* mPathFinder;
 
+	BoAdvanceWorkerPool* mWorkerPool;
+
 	BosonPlayerListManager* mPlayerListManager;
 
 	BoEventManager* mEventManager;
@@ -182,6 +192,26 @@ public:
 	bofixed jammerSignalStrength(const RadarJammerPlugin* radar, bofixed x, bofixed y, Unit* u);
 
 private:
+	/**
+	 * @return The sight circle for @p sight as a list of spans, one for every
+	 * row. See @ref sightSpan. The tables are created on demand and kept
+	 * for the rest of the game.
+	 **/
+	const QValueVector<int>& sightSpans(int sight);
+
+	/**
+	 * Calculates the cells in @p row that a unit at (@p x, @p y) can see.
+	 * @return FALSE if no cell of @p row is in sight, otherwise TRUE and
+	 * the cells from @p x1 to @p x2 (inclusive) are in sight.
+	 **/
+	bool sightSpan(const QValueVector<int>& spans, int sight, int x, int y, int row, int* x1, int* x2) const;
+
+	/**
+	 * Adds (or removes) the fog references for the complete sight circle of
+	 * @p unit, when it is at (@p x, @p y).
+	 **/
+	void changeSight(Unit* unit, int x, int y, bool add);
+
 	class ScheduledUnit
 	{
 	public:
@@ -208,6 +238,9 @@ private:
 	QValueList<const Unit*> mRadarUnits;
 	QValueList<const Unit*> mRadarJammers;
 
+	// Span tables of the sight circles, by sight range
+	QMap<int, QValueVector<int> > mSightSpans;
+
 	BosonMap* mMap;
 	BosonCanvas* mCanvas;
 	BosonPlayerListManager* mPlayerListManager;
@@ -221,6 +254,7 @@ void BoCanvasSightManager::quitGame()
  mChangedJammers.clear();
  mRadarUnits.clear();
  mRadarJammers.clear();
+ mSightSpans.clear();
 }
 
 void BoCanvasSightManager::unitMoved(Unit* u, bofixed oldCenterX, bofixed oldCenterY)
@@ -257,74 +291,111 @@ void BoCanvasSightManager::updateSights()
  }
 }
 
+const QValueVector<int>& BoCanvasSightManager::sightSpans(int sight)
+{
+ QMap<int, QValueVector<int> >::Iterator it = mSightSpans.find(sight);
+ if (it != mSightSpans.end()) {
+	return *it;
+ }
+
+ // A cell (x + i, y + j) is in sight of a unit at (x, y) if
+ // i*i + j*j < sight*sight. For every row j we store the largest such i, rows
+ // that are not in sight at all get -1.
+ QValueVector<int> spans(2 * sight + 1, -1);
+ int sight2 = sight * sight;
+ for (int j = -sight + 1; j < sight; j++) {
+	int i = 0;
+	while ((i + 1) * (i + 1) + j * j < sight2) {
+		i++;
+	}
+	spans[j + sight] = i;
+ }
+ it = mSightSpans.insert(sight, spans);
+ return *it;
+}
+
+bool BoCanvasSightManager::sightSpan(const QValueVector<int>& spans, int sight, int x, int y, int row, int* x1, int* x2) const
+{
+ int j = row - y;
+ if (j <= -sight || j >= sight) {
+	return false;
+ }
+ int i = spans[j + sight];
+ if (i < 0) {
+	return false;
+ }
+ *x1 = QMAX(x - i, 0);
+ *x2 = QMIN(x + i, (int)mMap->width() - 1);
+ return (*x1 <= *x2);
+}
+
+void BoCanvasSightManager::changeSight(Unit* unit, int x, int y, bool add)
+{
+ int sight = (int)unit->sightRange();
+ const QValueVector<int>& spans = sightSpans(sight);
+ Player* owner = unit->owner();
+ int top = QMAX(y - sight + 1, 0);
+ int bottom = QMIN(y + sight - 1, (int)mMap->height() - 1);
+ for (int row = top; row <= bottom; row++) {
+	int x1, x2;
+	if (!sightSpan(spans, sight, x, y, row, &x1, &x2)) {
+		continue;
+	}
+	if (add) {
+		owner->addFogRefs(row, x1, x2);
+	} else {
+		owner->removeFogRefs(row, x1, x2);
+	}
+ }
+ owner->flushFogChanges();
+}
+
 void BoCanvasSightManager::updateSight(Unit* unit, bofixed oldCenterX_, bofixed oldCenterY_)
 {
  PROFILE_METHOD;
- unsigned int sight = (int)unit->sightRange();
- int sight2 = sight * sight;
- unsigned int x = (unsigned int)unit->centerX();
- unsigned int y = (unsigned int)unit->centerY();
-
- int left = ((x > sight) ? (x - sight) : 0) - x;
- int top = ((y > sight) ? (y - sight) : 0) - y;
- int right = ((x + sight > mMap->width()) ?  mMap->width() :
-		x + sight) - x;
- int bottom = ((y + sight > mMap->height()) ?  mMap->height() :
-		y + sight) - y;
-
-
- unsigned int oldCenterX = oldCenterX_;
- unsigned int oldCenterY = oldCenterY_;
- int deltaX = x - oldCenterX;
- int deltaY = y - oldCenterY;
- if (!deltaX && !deltaY) {
+ int sight = (int)unit->sightRange();
+ int x = (int)unit->centerX();
+ int y = (int)unit->centerY();
+ int oldCenterX = (int)oldCenterX_;
+ int oldCenterY = (int)oldCenterY_;
+ if (x == oldCenterX && y == oldCenterY) {
 	unit->setScheduledForSightUpdate(false);
 	return;
  }
 
- int oldleft = ((oldCenterX < sight) ? 0 : (oldCenterX - sight)) - x;
- int oldtop = ((oldCenterY < sight) ? 0 : (oldCenterY - sight)) - y;
- int oldright = ((oldCenterX + sight > mMap->width()) ? mMap->width() : (oldCenterX + sight)) - x;
- int oldbottom = ((oldCenterY + sight > mMap->height()) ? mMap->height() : (oldCenterY + sight)) - y;
-
- if (QMAX(deltaX, deltaY) <= 5) {
-	// Speed up the common case by looking through every cell just once
-	left = QMIN(left, oldleft);
-	top = QMIN(top, oldtop);
-	right = QMAX(right, oldright);
-	bottom = QMAX(bottom, oldbottom);
-	for (int i = left; i < right; i++) {
-		for (int j = top; j < bottom; j++) {
-			int olddist = (i+deltaX)*(i+deltaX) + (j+deltaY)*(j+deltaY);
-			int newdist = i*i + j*j;
-			if ((newdist >= sight2) && (olddist < sight2)) {
-				// This cell is now out of sight but was previously in sight
-				unit->owner()->removeFogRef(x + i, y + j);
-			} else if ((newdist < sight2) && (olddist >= sight2)) {
-				unit->owner()->addFogRef(x + i, y + j);
-			}
+ // Go through the rows covered by the old and the new sight circle and
+ // compare the spans of both in every row. Only cells that are in just one of
+ // the spans change.
+ const QValueVector<int>& spans = sightSpans(sight);
+ Player* owner = unit->owner();
+ int top = QMAX(QMIN(y, oldCenterY) - sight + 1, 0);
+ int bottom = QMIN(QMAX(y, oldCenterY) + sight - 1, (int)mMap->height() - 1);
+ for (int row = top; row <= bottom; row++) {
+	int oldx1, oldx2, newx1, newx2;
+	bool hadSight = sightSpan(spans, sight, oldCenterX, oldCenterY, row, &oldx1, &oldx2);
+	bool hasSight = sightSpan(spans, sight, x, y, row, &newx1, &newx2);
+	if (!hadSight && !hasSight) {
+		continue;
+	} else if (!hadSight) {
+		owner->addFogRefs(row, newx1, newx2);
+	} else if (!hasSight) {
+		owner->removeFogRefs(row, oldx1, oldx2);
+	} else {
+		if (oldx1 < newx1) {
+			owner->removeFogRefs(row, oldx1, QMIN(oldx2, newx1 - 1));
 		}
-	}
- } else {
-	// First remove cells which were visible but aren't anymore...
-	for (int i = oldleft; i < oldright; i++) {
-		for (int j = oldtop; j < oldbottom; j++) {
-			if ((i*i + j*j >= sight2) && ((i+deltaX)*(i+deltaX) + (j+deltaY)*(j+deltaY) < sight2)) {
-				// This cell is now out of sight but was previously in sight
-				unit->owner()->removeFogRef(x + i, y + j);
-			}
+		if (oldx2 > newx2) {
+			owner->removeFogRefs(row, QMAX(oldx1, newx2 + 1), oldx2);
 		}
-	}
-
-	// ... then add those which just became visible
-	for (int i = left; i < right; i++) {
-		for (int j = top; j < bottom; j++) {
-			if ((i*i + j*j < sight2) && ((i+deltaX)*(i+deltaX) + (j+deltaY)*(j+deltaY) >= sight2)) {
-				unit->owner()->addFogRef(x + i, y + j);
-			}
+		if (newx1 < oldx1) {
+			owner->addFogRefs(row, newx1, QMIN(newx2, oldx1 - 1));
+		}
+		if (newx2 > oldx2) {
+			owner->addFogRefs(row, QMAX(newx1, oldx2 + 1), newx2);
 		}
 	}
  }
+ owner->flushFogChanges();
 
  // Update visible status of the unit for all players
  updateVisibleStatus(unit);
@@ -334,33 +405,14 @@ void BoCanvasSightManager::updateSight(Unit* unit, bofixed oldCenterX_, bofixed
 
 void BoCanvasSightManager::addSight(Unit* unit)
 {
- unsigned int sight = (int)unit->sightRange();
- int sight2 = sight * sight;
- unsigned int x = (unsigned int)unit->centerX();
- unsigned int y = (unsigned int)unit->centerY();
-
- int left = ((x > sight) ? (x - sight) : 0) - x;
- int top = ((y > sight) ? (y - sight) : 0) - y;
- int right = ((x + sight > mMap->width()) ?  mMap->width() :
-		x + sight) - x;
- int bottom = ((y + sight > mMap->height()) ?  mMap->height() :
-		y + sight) - y;
- for (int i = left; i < right; i++) {
-	for (int j = top; j < bottom; j++) {
-		if (i*i + j*j < sight2) {
-			unit->owner()->addFogRef(x + i, y + j);
-		}
-	}
- }
+ changeSight(unit, (int)unit->centerX(), (int)unit->centerY(), true);
  unit->setScheduledForSightUpdate(false);
 }
 
 void BoCanvasSightManager::removeSight(Unit* unit)
 {
- unsigned int sight = (int)unit->sightRange();
- int sight2 = sight * sight;
- unsigned int x = (unsigned int)unit->centerX();
- unsigned int y = (unsigned int)unit->centerY();
+ int x = (int)unit->centerX();
+ int y = (int)unit->centerY();
 
  if (unit->isScheduledForSightUpdate()) {
 	// If unit has already moved since the last sight update, we need to use the
@@ -369,27 +421,15 @@ void BoCanvasSightManager::removeSight(Unit* unit)
 	for (it = mScheduledSightUpdates.begin(); it != mScheduledSightUpdates.end(); ++it) {
 		const ScheduledUnit& s = *it;
 		if (s.unit == unit) {
-			x = (unsigned int)(unit->centerX() + (s.lastCenterX - unit->centerX()));
-			y = (unsigned int)(unit->centerY() + (s.lastCenterY - unit->centerY()));
+			x = (int)(unit->centerX() + (s.lastCenterX - unit->centerX()));
+			y = (int)(unit->centerY() + (s.lastCenterY - unit->centerY()));
 			mScheduledSightUpdates.remove(it);
 			break;
 		}
 	}
  }
 
- int left = ((x > sight) ? (x - sight) : 0) - x;
- int top = ((y > sight) ? (y - sight) : 0) - y;
- int right = ((x + sight > mMap->width()) ?  mMap->width() :
-		x + sight) - x;
- int bottom = ((y + sight > mMap->height()) ?  mMap->height() :
-		y + sight) - y;
- for (int i = left; i < right; i++) {
-	for (int j = top; j < bottom; j++) {
-		if (i*i + j*j < sight2) {
-			unit->owner()->removeFogRef(x + i, y + j);
-		}
-	}
- }
+ changeSight(unit, x, y, false);
  unit->setScheduledForSightUpdate(false);
 }
 
@@ -807,6 +847,7 @@ protected:
 	void unchargeUnits(unsigned int advanceCallsCount, bool advanceFlag);
 	void advanceItems(const BoItemList& allItems, unsigned int advanceCallsCount, bool advanceFlag);
 	void itemReload(const BoItemList& allItems, unsigned int advanceCallsCount); // calls BosonItem::advance()
+	void searchIdleTargets(unsigned int advanceCallsCount, QPtrList<Unit>* searchedUnits);
 
 	// AB: note that allItems is not used here currently. we use
 	// mCanvas->d->mWork2AdvanceList.
@@ -821,10 +862,40 @@ private:
 	BosonPlayerListManager* mPlayerListManager;
 };
 
+/**
+ * Searches the targets of idle units (see @ref Unit::advanceIdle) in the
+ * compute phase of the advance call. See @ref
+ * BoCanvasAdvance::searchIdleTargets.
+ **/
+class BoIdleTargetSearchJob : public BoAdvanceJob
+{
+public:
+	BoIdleTargetSearchJob(Unit** units, Unit** targets)
+		: BoAdvanceJob()
+	{
+		mUnits = units;
+		mTargets = targets;
+	}
+
+	virtual void compute(unsigned int index)
+	{
+		mTargets[index] = mUnits[index]->findBestEnemyUnitInRange();
+	}
+
+private:
+	Unit** mUnits;
+	Unit** mTargets;
+};
+
 void BoCanvasAdvance::advance(const BoItemList& allItems, unsigned int advanceCallsCount, bool advanceFlag)
 {
  boProfiling->push(prof_funcinfo + " - Whole method");
 
+ // all query results (see BosonCollisions) that are requested during this
+ // advance call are given back to the arena at the end of the call
+ BoItemListArena* itemListArena = BoItemListHandler::itemListHandler()->arena();
+ const unsigned int itemListArenaMark = itemListArena->mark();
+
  QMap<Player*, bool> player2HasMiniMap;
  for (QPtrListIterator<Player> it(mPlayerListManager->gamePlayerList()); it.current(); ++it) {
 	Player* p = it.current();
@@ -912,16 +983,18 @@ void BoCanvasAdvance::advance(const BoItemList& allItems, unsigned int advanceCa
 		continue;
 	}
 	if (has) {
-		BoEvent* miniMapEvent = new BoEvent("GainedMinimap");
+		BoEvent* miniMapEvent = BoEvent::create("GainedMinimap");
 		miniMapEvent->setPlayerId(p->bosonId());
 		mCanvas->eventManager()->queueEvent(miniMapEvent);
 	} else {
-		BoEvent* event = new BoEvent("LostMinimap");
+		BoEvent* event = BoEvent::create("LostMinimap");
 		event->setPlayerId(p->bosonId());
 		mCanvas->eventManager()->queueEvent(event);
 	}
  }
 
+ itemListArena->rewind(itemListArenaMark);
+
  boProfiling->pop(); // Whole method
 }
 
@@ -958,6 +1031,13 @@ void BoCanvasAdvance::advanceItems(const BoItemList& allItems, unsigned int adva
  itemReload(allItems, advanceCallsCount);
  boProfiling->pop();
 
+ // the target search of idle units only reads the game state, so we can do
+ // it for all idle units at once, using the worker threads.
+ QPtrList<Unit> searchedUnits;
+ boProfiling->push("Advance: search idle targets");
+ searchIdleTargets(advanceCallsCount, &searchedUnits);
+ boProfiling->pop();
+
  // now the rest - mainly call BosonItem::advanceFunction().
  // this depends on in which list an item resides (changed when Unit::work()
  // changes). normal items are usually in -1.
@@ -965,6 +1045,12 @@ void BoCanvasAdvance::advanceItems(const BoItemList& allItems, unsigned int adva
  advanceFunctionAndMove(advanceCallsCount, advanceFlag);
  boProfiling->pop();
 
+ // units that did not use their target (e.g. because their work changed)
+ // must not keep it until the next search
+ for (QPtrListIterator<Unit> it(searchedUnits); it.current(); ++it) {
+	it.current()->clearPrecomputedIdleTarget();
+ }
+
  // now we need to make sure that the correct advance function will be called in
  // the next advance call.
  syncAdvanceFunctions(allItems, advanceFlag);
@@ -988,6 +1074,56 @@ void BoCanvasAdvance::itemReload(const BoItemList& allItems, unsigned int advanc
  }
 }
 
+void BoCanvasAdvance::searchIdleTargets(unsigned int advanceCallsCount, QPtrList<Unit>* searchedUnits)
+{
+ QMap<int, QPtrList<BosonItem> >::Iterator workIt = mCanvas->d->mWork2AdvanceList.find((int)UnitBase::WorkIdle);
+ if (workIt == mCanvas->d->mWork2AdvanceList.end()) {
+	return;
+ }
+
+ // collect the units in item ID order
+ QMap<unsigned long int, Unit*> units;
+ for (QPtrListIterator<BosonItem> it(*workIt); it.current(); ++it) {
+	if (!RTTI::isUnit(it.current()->rtti())) {
+		continue;
+	}
+	Unit* u = (Unit*)it.current();
+	if (u->isDestroyed() || !u->searchesIdleTarget(advanceCallsCount)) {
+		continue;
+	}
+	units.insert(u->id(), u);
+ }
+ if (units.isEmpty()) {
+	return;
+ }
+
+ unsigned int count = units.count();
+ Unit** unitArray = new Unit*[count];
+ Unit** targets = new Unit*[count];
+ unsigned int i = 0;
+ for (QMap<unsigned long int, Unit*>::Iterator it = units.begin(); it != units.end(); ++it) {
+	unitArray[i] = *it;
+	targets[i] = 0;
+	i++;
+ }
+
+ // compute phase: may run in several threads. every job writes to its own
+ // entry in targets only.
+ BoIdleTargetSearchJob job(unitArray, targets);
+ mCanvas->d->mWorkerPool->run(&job, count);
+
+ // commit phase: in item ID order.
+ // the target is actually used by Unit::advanceIdle() which checks whether
+ // the target has been destroyed in the meantime.
+ for (i = 0; i < count; i++) {
+	unitArray[i]->setPrecomputedIdleTarget(targets[i]);
+	searchedUnits->append(unitArray[i]);
+ }
+
+ delete[] unitArray;
+ delete[] targets;
+}
+
 void BoCanvasAdvance::advanceFunctionAndMove(unsigned int advanceCallsCount, bool advanceFlag)
 {
  PROFILE_METHOD;
@@ -1185,6 +1321,8 @@ BosonCanvas::BosonCanvas(bool advanceFlag, QObject* parent, bool gameMode)
  d->mDestroyedUnits.setAutoDelete(false);
  mAdvanceFunctionLocked = false;
  mCollisions = new BosonCollisions();
+ mItemsSyncHash = 0;
+ d->mWorkerPool = new BoAdvanceWorkerPool();
  d->mSightManager = 0;
  d->mQuadTreeCollection = new BoCanvasQuadTreeCollection(this);
  d->mStatistics = new BosonCanvasStatistics(this);
@@ -1237,6 +1375,7 @@ BosonCanvas::~BosonCanvas()
  clearMoveDatas();
  delete d->mQuadTreeCollection;
  delete d->mSightManager;
+ delete d->mWorkerPool;
  delete d;
  boDebug()<< k_funcinfo <<"done"<< endl;
 }
@@ -1256,6 +1395,16 @@ BosonCanvasStatistics* BosonCanvas::canvasStatistics() const
  return d->mStatistics;
 }
 
+void BosonCanvas::setAdvanceWorkerCount(unsigned int count)
+{
+ d->mWorkerPool->setWorkerCount(count);
+}
+
+unsigned int BosonCanvas::advanceWorkerCount() const
+{
+ return d->mWorkerPool->workerCount();
+}
+
 void BosonCanvas::quitGame()
 {
  // Delete pathfinder first. Otherwise lot of time would be spent recalculating
@@ -1642,7 +1791,7 @@ void BosonCanvas::destroyUnit(Unit* unit)
 		unit->setVisible(false);
 	}
 
-	BoEvent* unitDestroyed = new BoEvent("UnitWithTypeDestroyed", QString::number(unit->type()));
+	BoEvent* unitDestroyed = BoEvent::create("UnitWithTypeDestroyed", QString::number(unit->type()));
 	unitDestroyed->setUnitId(unit->id());
 	unitDestroyed->setPlayerId(unit->owner()->bosonId());
 	eventManager()->queueEvent(unitDestroyed);
@@ -1650,17 +1799,17 @@ void BosonCanvas::destroyUnit(Unit* unit)
 	// the following events are not emitted for the neutral player
 	if (owner->isActiveGamePlayer()) {
 		if (owner->mobilesCount() == 0) {
-			BoEvent* event = new BoEvent("AllMobileUnitsDestroyed");
+			BoEvent* event = BoEvent::create("AllMobileUnitsDestroyed");
 			event->setPlayerId(unit->owner()->bosonId());
 			eventManager()->queueEvent(event);
 		}
 		if (owner->facilitiesCount() == 0) {
-			BoEvent* allFacilitiesDestroyed = new BoEvent("AllFacilitiesDestroyed");
+			BoEvent* allFacilitiesDestroyed = BoEvent::create("AllFacilitiesDestroyed");
 			allFacilitiesDestroyed->setPlayerId(unit->owner()->bosonId());
 			eventManager()->queueEvent(allFacilitiesDestroyed);
 		}
 		if (owner->allUnits()->count() == 0) {
-			BoEvent* event = new BoEvent("AllUnitsDestroyed");
+			BoEvent* event = BoEvent::create("AllUnitsDestroyed");
 			event->setPlayerId(unit->owner()->bosonId());
 			eventManager()->queueEvent(event);
 		}
@@ -1834,6 +1983,10 @@ float BosonCanvas::terrainHeightAtPoint(bofixed x, bofixed y) const
 
 void BosonCanvas::removeFromCells(BosonItem* item)
 {
+ // note that we must not use rtti() here, this is called from the
+ // BosonItem d'tor
+ collisions()->removeUnitFromGrid(item);
+
  const QPtrVector<Cell>* cells = item->cells();
  for (unsigned int i = 0; i < cells->count(); i++) {
 	Cell* c = cells->at(i);
@@ -1870,6 +2023,9 @@ void BosonCanvas::addToCells(BosonItem* item)
 	}
 	c->addItem(item);
  }
+ if (RTTI::isUnit(item->rtti())) {
+	collisions()->addUnitToGrid(item);
+ }
 
  if (cells->count() > 0) {
 	int x1 = cells->at(0)->x();
@@ -2141,6 +2297,11 @@ bool BosonCanvas::loadItemsFromXML(const QDomElement& root)
 		allItems.append(i);
 	}
  }
+ return loadItemsFromXML(allItemElements, allItems);
+}
+
+bool BosonCanvas::loadItemsFromXML(const QValueList<QDomElement>& allItemElements, const QValueList<BosonItem*>& allItems)
+{
  if (allItemElements.count() != allItems.count()) {
 	boError(260) << k_funcinfo << "item count != element count" << endl;
 	return false;
@@ -2148,10 +2309,10 @@ bool BosonCanvas::loadItemsFromXML(const QDomElement& root)
  boDebug(260) << k_funcinfo << "created " << allItems.count() << " items" << endl;
 
  unsigned int itemCount = 0;
- for (unsigned int i = 0; i < allItems.count(); i++) {
-	QDomElement e = allItemElements[i];
-	BosonItem* item = allItems[i];
-	if (!loadItemFromXML(e, item)) {
+ QValueList<QDomElement>::const_iterator elementIt = allItemElements.begin();
+ QValueList<BosonItem*>::const_iterator itemIt = allItems.begin();
+ for (; itemIt != allItems.end(); ++itemIt, ++elementIt) {
+	if (!loadItemFromXML(*elementIt, *itemIt)) {
 		boError(260) << k_funcinfo << "failed loading item" << endl;
 		return false;
 	}
@@ -2162,7 +2323,158 @@ bool BosonCanvas::loadItemsFromXML(const QDomElement& root)
  return true;
 }
 
+bool BosonCanvas::loadFromBinary(const QByteArray& data)
+{
+ PROFILE_METHOD
+ BoBinarySaveGameReader reader(data);
+ if (!reader.open()) {
+	boError(260) << k_funcinfo << "invalid binary canvas file" << endl;
+	return false;
+ }
+
+ QDomDocument doc(QString::fromLatin1("Canvas"));
+ QDomElement handler;
+
+ // the items are created and their properties are loaded in the first pass.
+ // the children of the item elements are decoded in the second pass only,
+ // when the item is loaded.
+ QValueList<QDomElement> allItemElements;
+ QValueList<BosonItem*> allItems;
+ QValueList<unsigned int> allItemChunks;
+ QValueList<unsigned int> allItemChildrenOffsets;
+ for (unsigned int i = 0; i < reader.chunkCount(); i++) {
+	Q_UINT32 tag = reader.chunkTag(i);
+	if (tag != BoBinarySaveGame::ChunkItem && tag != BoBinarySaveGame::ChunkElement) {
+		// the canvas and Items chunks contain no data that we need
+		continue;
+	}
+	Q_UINT16 version = (tag == BoBinarySaveGame::ChunkItem) ? 2 : 1;
+	if (reader.chunkVersion(i) != version) {
+		boError(260) << k_funcinfo << "chunk " << i << " has unsupported version " << reader.chunkVersion(i) << endl;
+		return false;
+	}
+	QDataStream& stream = reader.chunkStream(i);
+	Player* owner = 0;
+	if (tag == BoBinarySaveGame::ChunkItem) {
+		unsigned int id = BosonMessage::loadVarUInt(stream);
+		owner = d->mPlayerListManager->findPlayerByUserId(id);
+		if (!owner) {
+			// AB: this is totally valid. less players in game, than in the
+			// file. we don't even need to decode the item then.
+			continue;
+		}
+	}
+	QDomElement e = reader.readElement(stream, doc);
+	if (e.isNull() || !reader.isInChunk(i)) {
+		boError(260) << k_funcinfo << "invalid chunk " << i << endl;
+		return false;
+	}
+	if (!owner) {
+		if (e.tagName() == QString::fromLatin1("DataHandler")) {
+			handler = e;
+		}
+		continue;
+	}
+	BosonItem* item = createItemFromXMLAttributes(e, owner);
+	if (!item) {
+		boError(260) << k_funcinfo << "failed creating item from chunk " << i << endl;
+		continue;
+	}
+
+	// some units depend on properties of other units (see
+	// createItemFromXML()), so all properties are loaded before any item
+	// is loaded.
+	QString name;
+	bool ok = reader.readPropertyHandlerName(stream, &name);
+	while (ok && !name.isNull()) {
+		KGamePropertyHandler* properties = item->dataHandlerByName(name);
+		if (!properties) {
+			boError(260) << k_funcinfo << "item " << item->id() << " has no property handler " << name << endl;
+		}
+		ok = reader.readPropertyHandler(stream, properties);
+		if (ok) {
+			ok = reader.readPropertyHandlerName(stream, &name);
+		}
+	}
+	if (!ok || !reader.isInChunk(i)) {
+		boError(260) << k_funcinfo << "invalid properties in chunk " << i << endl;
+		return false;
+	}
+	allItemElements.append(e);
+	allItems.append(item);
+	allItemChunks.append(i);
+	allItemChildrenOffsets.append(stream.device()->at());
+ }
+ boDebug(260) << k_funcinfo << "created " << allItems.count() << " items" << endl;
+
+ QValueList<QDomElement>::iterator elementIt = allItemElements.begin();
+ QValueList<BosonItem*>::iterator itemIt = allItems.begin();
+ QValueList<unsigned int>::iterator chunkIt = allItemChunks.begin();
+ QValueList<unsigned int>::iterator offsetIt = allItemChildrenOffsets.begin();
+ for (; itemIt != allItems.end(); ++itemIt, ++elementIt, ++chunkIt, ++offsetIt) {
+	QDataStream& stream = reader.chunkStream(*chunkIt);
+	stream.device()->at(*offsetIt);
+	QDomElement children = reader.readElement(stream, doc);
+	if (children.isNull() || !reader.isInChunk(*chunkIt)) {
+		boError(260) << k_funcinfo << "invalid chunk " << *chunkIt << endl;
+		return false;
+	}
+	QDomElement e = *elementIt;
+	while (!children.firstChild().isNull()) {
+		e.appendChild(children.firstChild());
+	}
+	if (!loadItemFromXML(e, *itemIt)) {
+		boError(260) << k_funcinfo << "failed loading item" << endl;
+		return false;
+	}
+ }
+
+ if (handler.isNull()) {
+	boError(260) << k_funcinfo << "DataHandler not found" << endl;
+	return false;
+ }
+ BosonPropertyXML propertyXML;
+ if (!propertyXML.loadFromXML(handler, d->mProperties)) {
+	boError(260) << k_funcinfo << "unable to load the datahandler" << endl;
+	return false;
+ }
+
+ initPathFinder();
+ boDebug(260) << k_funcinfo << "done" << endl;
+ return true;
+}
+
 BosonItem* BosonCanvas::createItemFromXML(const QDomElement& item, Player* owner)
+{
+ PROFILE_METHOD
+ BosonItem* i = createItemFromXMLAttributes(item, owner);
+ if (!i || !RTTI::isUnit(i->rtti())) {
+	return i;
+ }
+
+ // AB: some units may depend on properties of other units - e.g. on
+ // whether a unit is constructed completely.
+ // we must make sure that these properties are already loaded, even if
+ // the unit that a unit depends on is loaded later.
+ // I hope loading the DataHandler in advance will solve this problem
+ // (it comes up for harvesters currently, as they require the
+ // refineries/mines to be completely constructed, as Unit::plugin()
+ // returns 0 otherwise)
+ BosonCustomPropertyXML propertyXML;
+ QDomElement handler = item.namedItem(QString::fromLatin1("DataHandler")).toElement();
+ if (handler.isNull()) {
+	boError() << k_funcinfo << "NULL DataHandler tag for item" << endl;
+	delete i;
+	return 0;
+ }
+ if (!propertyXML.loadFromXML(handler, i->dataHandler())) {
+	boError(260) << k_funcinfo << "unable to load item data handler" << endl;
+	return 0;
+ }
+ return i;
+}
+
+BosonItem* BosonCanvas::createItemFromXMLAttributes(const QDomElement& item, Player* owner)
 {
  PROFILE_METHOD
  if (item.isNull()) {
@@ -2298,26 +2610,6 @@ BosonItem* BosonCanvas::createItemFromXML(const QDomElement& item, Player* owner
 	// Set additional properties
 	owner->addUnit(u, dataHandlerId);
 
-	// AB: some units may depend on properties of other units - e.g. on
-	// whether a unit is constructed completely.
-	// we must make sure that these properties are already loaded, even if
-	// the unit that a unit depends on is loaded later.
-	// I hope loading the DataHandler in advance will solve this problem
-	// (it comes up for harvesters currently, as they require the
-	// refineries/mines to be completely constructed, as Unit::plugin()
-	// returns 0 otherwise)
-	BosonCustomPropertyXML propertyXML;
-	QDomElement handler = item.namedItem(QString::fromLatin1("DataHandler")).toElement();
-	if (handler.isNull()) {
-		boError() << k_funcinfo << "NULL DataHandler tag for item" << endl;
-		delete u;
-		return 0;
-	}
-	if (!propertyXML.loadFromXML(handler, u->dataHandler())) {
-		boError(260) << k_funcinfo << "unable to load item data handler" << endl;
-		return false;
-	}
-
 	return (BosonItem*)u;
  } else if (RTTI::isShot(rtti)) {
 	BosonShot* s = (BosonShot*)createItemAtTopLeftPos(RTTI::Shot, owner, ItemType(type, group, groupType), pos, id);
@@ -2350,6 +2642,10 @@ bool BosonCanvas::loadItemFromXML(const QDomElement& element, BosonItem* item)
 	}
 	return false;
  }
+
+ // the signals of the data handler are blocked while loading, so the
+ // owner did not notice the changed properties.
+ item->updateSyncState();
  return true;
 }
 
@@ -2435,6 +2731,90 @@ bool BosonCanvas::saveItemsAsXML(QDomElement& root) const
  return true;
 }
 
+QByteArray BosonCanvas::saveCanvasBinary() const
+{
+ PROFILE_METHOD
+ QByteArray data;
+ QBuffer buffer(data);
+ buffer.open(IO_WriteOnly);
+ BoBinarySaveGameWriter writer(&buffer);
+ writer.writeFileHeader();
+
+ QDomDocument doc(QString::fromLatin1("Canvas"));
+ QDomElement root = doc.createElement(QString::fromLatin1("Canvas"));
+ writer.writeElement(writer.beginChunk(BoBinarySaveGame::ChunkCanvas, 1), root);
+ writer.endChunk();
+
+ QValueList<unsigned int> owners;
+ QPtrList<Player> gamePlayerList = d->mPlayerListManager->gamePlayerList();
+ for (KPlayer* p = gamePlayerList.first(); p; p = gamePlayerList.next()) {
+	QDomElement items = doc.createElement(QString::fromLatin1("Items"));
+	items.setAttribute(QString::fromLatin1("PlayerId"), ((Player*)p)->bosonId());
+	writer.writeElement(writer.beginChunk(BoBinarySaveGame::ChunkItems, 1), items);
+	writer.endChunk();
+	owners.append(((Player*)p)->bosonId());
+ }
+
+ // every item is written to the device as soon as it is saved, i.e. we never
+ // have the elements of all items in memory at the same time.
+ BoItemList::Iterator it;
+ for (it = d->mAllItems.begin(); it != d->mAllItems.end(); ++it) {
+	BosonItem* i = *it;
+	if (!i->owner()) {
+		BO_NULL_ERROR(i->owner());
+		return QByteArray();
+	}
+	unsigned int id = i->owner()->bosonId();
+	if (!owners.contains(id)) {
+		boError() << k_funcinfo << "owner " << id << " is not a game player" << endl;
+		return QByteArray();
+	}
+	if (RTTI::isShot(i->rtti())) {
+		if (!((BosonShot*)i)->isActive()) {
+			continue;
+		}
+	}
+	QDomElement item = doc.createElement(QString::fromLatin1("Item"));
+	if (!i->saveAsXMLWithoutDataHandlers(item)) {
+		boError() << k_funcinfo << "Could not save item " << i << endl;
+		return QByteArray();
+	}
+	QDomElement children = doc.createElement(QString::fromLatin1("Item"));
+	while (!item.firstChild().isNull()) {
+		children.appendChild(item.firstChild());
+	}
+	QDataStream& stream = writer.beginChunk(BoBinarySaveGame::ChunkItem, 2);
+	BosonMessage::saveVarUInt(stream, id);
+	writer.writeElement(stream, item);
+	i->saveDataHandlers(&writer, stream);
+	writer.endPropertyHandlers(stream);
+	writer.writeElement(stream, children);
+	writer.endChunk();
+ }
+
+ QDomElement pathFinderXML = doc.createElement(QString::fromLatin1("Pathfinder"));
+ if (d->mPathFinder) {
+	d->mPathFinder->saveAsXML(pathFinderXML);
+ }
+ writer.writeElement(writer.beginChunk(BoBinarySaveGame::ChunkElement, 1), pathFinderXML);
+ writer.endChunk();
+
+ BosonPropertyXML propertyXML;
+ QDomElement handler = doc.createElement(QString::fromLatin1("DataHandler"));
+ if (!propertyXML.saveAsXML(handler, d->mProperties)) {
+	boError() << k_funcinfo << "unable to save the datahandler" << endl;
+	return QByteArray();
+ }
+ writer.writeElement(writer.beginChunk(BoBinarySaveGame::ChunkElement, 1), handler);
+ writer.endChunk();
+
+ if (!writer.finish()) {
+	return QByteArray();
+ }
+ buffer.close();
+ return data;
+}
+
 QCString BosonCanvas::emptyCanvasFile(unsigned int playerCount)
 {
  QDomDocument doc(QString::fromLatin1("Canvas"));
@@ -188,6 +188,32 @@ public:
 
 	inline BosonCollisions* collisions() const { return mCollisions; }
 
+	/**
+	 * @return The sum of the hashes of all items in this canvas (see @ref
+	 * BosonItem::syncState). Every item updates its part of the sum when it
+	 * changes, so this is available in O(1). Two canvases with the same
+	 * items in the same state have the same hash.
+	 **/
+	inline Q_UINT64 itemsSyncHash() const { return mItemsSyncHash; }
+
+	/**
+	 * @internal
+	 * Called by @ref BosonItem when its hash changed from @p oldHash to
+	 * @p newHash.
+	 **/
+	inline void changeItemsSyncHash(Q_UINT64 oldHash, Q_UINT64 newHash)
+	{
+		mItemsSyncHash += newHash - oldHash;
+	}
+
+	/**
+	 * Set the number of threads that are used for the "compute" phase of
+	 * an advance call, see @ref BoAdvanceWorkerPool. The result of an
+	 * advance call does not depend on this value.
+	 **/
+	void setAdvanceWorkerCount(unsigned int count);
+	unsigned int advanceWorkerCount() const;
+
 	/**
 	 * See @ref createItem.
 	 *
@@ -464,6 +490,26 @@ public:
 	 **/
 	QCString saveCanvas() const;
 
+	/**
+	 * Like @ref saveCanvas, but the canvas is saved in the binary format
+	 * (see @ref BoBinarySaveGame). The items are encoded one at a time,
+	 * which is a lot faster than saving and serializing a complete XML
+	 * document for large maps. The properties of the items are written to
+	 * the file directly, without creating XML elements for them.
+	 *
+	 * Use @ref loadFromBinary to load the canvas again.
+	 **/
+	QByteArray saveCanvasBinary() const;
+
+	/**
+	 * Load the canvas from a file that was saved by @ref saveCanvasBinary.
+	 * The chunks of the file are decoded when they are needed only, e.g.
+	 * the items of players that are not in the game are skipped and the
+	 * children of an item element are decoded when the item gets loaded.
+	 * The properties of the items are read from the binary data directly.
+	 **/
+	bool loadFromBinary(const QByteArray& data);
+
 	/**
 	 * This method is meant for use in the editor or in test programs, it is
 	 * of no use for the game itself (you always have a .bpf file to load
@@ -600,6 +646,12 @@ protected:
 	 * Used by @ref loadFromXML.
 	 **/
 	bool loadItemsFromXML(const QDomElement& root);
+
+	/**
+	 * Load the items in @p allItems (created by @ref createItemFromXML)
+	 * from the corresponding elements in @p allItemElements.
+	 **/
+	bool loadItemsFromXML(const QValueList<QDomElement>& allItemElements, const QValueList<BosonItem*>& allItems);
 	bool saveItemsAsXML(QDomElement& root) const;
 
 	/**
@@ -609,6 +661,13 @@ protected:
 	 **/
 	BosonItem* createItemFromXML(const QDomElement& item, Player* owner);
 
+	/**
+	 * Like @ref createItemFromXML, but uses the attributes of @p item only,
+	 * i.e. the properties of the new item are not loaded. Used by @ref
+	 * loadFromBinary, which loads the properties from the binary data.
+	 **/
+	BosonItem* createItemFromXMLAttributes(const QDomElement& item, Player* owner);
+
 	bool loadItemFromXML(const QDomElement& element, BosonItem* item);
 
 	/**
@@ -643,6 +702,7 @@ private:
 	class BosonCanvasPrivate;
 	BosonCanvasPrivate* d;
 	BosonCollisions* mCollisions;
+	Q_UINT64 mItemsSyncHash;
 
 	bool mAdvanceFunctionLocked;
 };
@@ -25,14 +25,161 @@
 #include "bosonmap.h"
 #include "bo3dtools.h"
 #include "boitemlist.h"
+#include "boitemlisthandler.h"
 #include "bodebug.h"
 #include "defines.h"
 #include "bosonprofiling.h"
 
 #include <qptrvector.h>
+#include <qvaluelist.h>
 
 #include <math.h>
 
+// Size of a unit grid bucket, in cells
+#define UNIT_GRID_BUCKET_SIZE 8
+
+/**
+ * A bucket of the unit grid. The units are kept in a single array, so that
+ * a query only has to walk through a few small arrays.
+ *
+ * Every item remembers its bucket and its slot in that bucket (see @ref
+ * BosonItem::setUnitGridSlot), so removing it does not have to search the
+ * bucket.
+ **/
+class BoUnitGridBucket
+{
+public:
+	BoUnitGridBucket()
+	{
+		mItems = 0;
+		mCount = 0;
+		mSize = 0;
+	}
+	~BoUnitGridBucket()
+	{
+		delete[] mItems;
+	}
+
+	void add(int bucket, BosonItem* item)
+	{
+		if (mCount == mSize) {
+			unsigned int size = QMAX(mSize * 2, (unsigned int)8);
+			BosonItem** items = new BosonItem*[size];
+			for (unsigned int i = 0; i < mCount; i++) {
+				items[i] = mItems[i];
+			}
+			delete[] mItems;
+			mItems = items;
+			mSize = size;
+		}
+		mItems[mCount] = item;
+		item->setUnitGridSlot(bucket, mCount);
+		mCount++;
+	}
+	bool remove(BosonItem* item)
+	{
+		unsigned int slot = item->unitGridSlot();
+		if (slot >= mCount || mItems[slot] != item) {
+			return false;
+		}
+		// The order of the units doesn't matter, so the last one simply
+		// takes this place
+		mCount--;
+		if (slot != mCount) {
+			mItems[slot] = mItems[mCount];
+			mItems[slot]->setUnitGridSlot(item->unitGridBucket(), slot);
+		}
+		item->setUnitGridSlot(-1, 0);
+		return true;
+	}
+
+	inline unsigned int count() const { return mCount; }
+	inline BosonItem* at(unsigned int i) const { return mItems[i]; }
+
+private:
+	BosonItem** mItems;
+	unsigned int mCount;
+	unsigned int mSize;
+};
+
+/**
+ * Passes the units in range of a point on to another visitor.
+ **/
+class BoUnitRangeFilter : public BoUnitVisitor
+{
+public:
+	BoUnitRangeFilter(const BoVector2Fixed& pos, bofixed radius, BoUnitVisitor* visitor)
+		: mPos(pos), mRadius2(radius * radius), mVisitor(visitor)
+	{
+	}
+
+	virtual bool visit(Unit* u)
+	{
+		if (u->isDestroyed()) {
+			return true;
+		}
+		if ((mPos - u->center()).dotProduct() > mRadius2) {
+			return true;
+		}
+		return mVisitor->visit(u);
+	}
+
+private:
+	BoVector2Fixed mPos;
+	bofixed mRadius2;
+	BoUnitVisitor* mVisitor;
+};
+
+/**
+ * Passes the units in a sphere on to another visitor. Note that the size of
+ * the units is taken into account, see @ref Unit::distanceSquared.
+ **/
+class BoUnitSphereFilter : public BoUnitVisitor
+{
+public:
+	BoUnitSphereFilter(const BoVector3Fixed& pos, bofixed radius, BoUnitVisitor* visitor)
+		: mPos(pos), mRadius2(radius * radius), mVisitor(visitor)
+	{
+	}
+
+	virtual bool visit(Unit* u)
+	{
+		if (u->isDestroyed()) {
+			return true;
+		}
+		if (u->distanceSquared(mPos) > mRadius2) {
+			return true;
+		}
+		return mVisitor->visit(u);
+	}
+
+private:
+	BoVector3Fixed mPos;
+	bofixed mRadius2;
+	BoUnitVisitor* mVisitor;
+};
+
+/**
+ * Collects the visited units in a list
+ **/
+class BoUnitListVisitor : public BoUnitVisitor
+{
+public:
+	BoUnitListVisitor(QValueList<Unit*>* list) : mList(list)
+	{
+	}
+
+	virtual bool visit(Unit* u)
+	{
+		mList->append(u);
+		return true;
+	}
+
+private:
+	QValueList<Unit*>* mList;
+};
+
+
 BosonCollisions::BosonCollisions()
 {
  init();
@@ -41,10 +188,108 @@ BosonCollisions::BosonCollisions()
 void BosonCollisions::init()
 {
  mMap = 0;
+ mUnitGrid = 0;
+ mUnitGridWidth = 0;
+ mUnitGridHeight = 0;
+ mMaxUnitExtent = 0;
 }
 
 BosonCollisions::~BosonCollisions()
 {
+ delete[] mUnitGrid;
+}
+
+void BosonCollisions::setMap(BosonMap* map)
+{
+ mMap = map;
+ delete[] mUnitGrid;
+ mUnitGrid = 0;
+ mUnitGridWidth = 0;
+ mUnitGridHeight = 0;
+ mMaxUnitExtent = 0;
+ if (!mMap) {
+	return;
+ }
+ mUnitGridWidth = (mMap->width() + UNIT_GRID_BUCKET_SIZE - 1) / UNIT_GRID_BUCKET_SIZE;
+ mUnitGridHeight = (mMap->height() + UNIT_GRID_BUCKET_SIZE - 1) / UNIT_GRID_BUCKET_SIZE;
+ mUnitGrid = new BoUnitGridBucket[mUnitGridWidth * mUnitGridHeight];
+}
+
+int BosonCollisions::unitGridIndex(bofixed x, bofixed y) const
+{
+ int bx = QMIN(QMAX((int)x, 0) / UNIT_GRID_BUCKET_SIZE, mUnitGridWidth - 1);
+ int by = QMIN(QMAX((int)y, 0) / UNIT_GRID_BUCKET_SIZE, mUnitGridHeight - 1);
+ return by * mUnitGridWidth + bx;
+}
+
+void BosonCollisions::addUnitToGrid(BosonItem* item)
+{
+ if (!mUnitGrid) {
+	return;
+ }
+ int bucket = unitGridIndex(item->centerX(), item->centerY());
+ mUnitGrid[bucket].add(bucket, item);
+ mMaxUnitExtent = QMAX(mMaxUnitExtent, QMAX(item->width(), item->height()) / 2);
+}
+
+void BosonCollisions::removeUnitFromGrid(BosonItem* item)
+{
+ if (!mUnitGrid || item->unitGridBucket() < 0) {
+	return;
+ }
+ if (item->unitGridBucket() >= mUnitGridWidth * mUnitGridHeight) {
+	// the grid has been rebuilt for another map
+	item->setUnitGridSlot(-1, 0);
+	return;
+ }
+ if (!mUnitGrid[item->unitGridBucket()].remove(item)) {
+	boError(310) << k_funcinfo << "item " << item->id() << " not found in its unit grid bucket" << endl;
+ }
+}
+
+void BosonCollisions::visitUnits(const BoRect2Fixed& rect, BoUnitVisitor* visitor) const
+{
+ if (!mUnitGrid) {
+	return;
+ }
+ if (rect.right() < 0 || rect.bottom() < 0) {
+	return;
+ }
+ int bx1 = QMAX((int)rect.left(), 0) / UNIT_GRID_BUCKET_SIZE;
+ int by1 = QMAX((int)rect.top(), 0) / UNIT_GRID_BUCKET_SIZE;
+ int bx2 = QMIN((int)rect.right() / UNIT_GRID_BUCKET_SIZE, mUnitGridWidth - 1);
+ int by2 = QMIN((int)rect.bottom() / UNIT_GRID_BUCKET_SIZE, mUnitGridHeight - 1);
+ for (int by = by1; by <= by2; by++) {
+	for (int bx = bx1; bx <= bx2; bx++) {
+		const BoUnitGridBucket& bucket = mUnitGrid[by * mUnitGridWidth + bx];
+		for (unsigned int i = 0; i < bucket.count(); i++) {
+			Unit* u = (Unit*)bucket.at(i);
+			bofixed x = u->centerX();
+			bofixed y = u->centerY();
+			if (x < rect.left() || x > rect.right() || y < rect.top() || y > rect.bottom()) {
+				continue;
+			}
+			if (!visitor->visit(u)) {
+				return;
+			}
+		}
+	}
+ }
+}
+
+void BosonCollisions::visitUnitsInRange(const BoVector2Fixed& pos, bofixed radius, BoUnitVisitor* visitor) const
+{
+ BoUnitRangeFilter filter(pos, radius, visitor);
+ visitUnits(BoRect2Fixed(pos.x() - radius, pos.y() - radius, pos.x() + radius, pos.y() + radius), &filter);
+}
+
+void BosonCollisions::visitUnitsInSphere(const BoVector3Fixed& pos, bofixed radius, BoUnitVisitor* visitor) const
+{
+ // Units are in the grid by their center, but the distance is measured to
+ // their edges
+ bofixed r = radius + mMaxUnitExtent;
+ BoUnitSphereFilter filter(pos, radius, visitor);
+ visitUnits(BoRect2Fixed(pos.x() - r, pos.y() - r, pos.x() + r, pos.y() + r), &filter);
 }
 
 Cell* BosonCollisions::cell(int x, int y) const
@@ -111,57 +356,18 @@ Unit* BosonCollisions::findUnitAt(const BoVector3Fixed& pos) const
 QValueList<Unit*> BosonCollisions::unitCollisionsInRange(const BoVector2Fixed& pos, bofixed radius) const
 {
  PROFILE_METHOD
- BoItemList* l = collisions(BoRect2Fixed(QMAX(pos.x() - radius, bofixed(0)), QMAX(pos.y() - radius, bofixed(0)),
-		pos.x() + radius, pos.y() + radius));
-
  QValueList<Unit*> list;
- BoItemList::Iterator it;
- for (it = l->begin(); it != l->end(); ++it) {
-	if (!RTTI::isUnit((*it)->rtti())) {
-		// this item is not important for us here
-		continue;
-	}
-	Unit* u = (Unit*)*it;
-	if (u->isDestroyed()) {
-		// this item is not important for us here
-		continue;
-	}
-//	boDebug(310) << "unit at x=" << u->x() << ",y=" << u->y() << ",pos=" << pos.x() << "," << pos.y() << endl;
-
-	if ((pos - u->center()).dotProduct() <= radius * radius) {
-//		boDebug(310) << "adding " << u->id() << endl;
-		list.append(u);
-	}
- }
+ BoUnitListVisitor visitor(&list);
+ visitUnitsInRange(pos, radius, &visitor);
  return list;
 }
 
 QValueList<Unit*> BosonCollisions::unitCollisionsInSphere(const BoVector3Fixed& pos, bofixed radius) const
 {
  PROFILE_METHOD
- // FIXME: code duplicated from unitCollisionsInRange
- boDebug(310) << k_funcinfo << endl;
- BoItemList* l = collisions(BoRect2Fixed(QMAX(pos.x() - radius, bofixed(0)), QMAX(pos.y() - radius, bofixed(0)),
-		pos.x() + radius, pos.y() + radius));
-
  QValueList<Unit*> list;
- BoItemList::Iterator it;
- for (it = l->begin(); it != l->end(); ++it) {
-	if (!RTTI::isUnit((*it)->rtti())) {
-		// this item is not important for us here
-		continue;
-	}
-	Unit* u = (Unit*)*it;
-	if (u->isDestroyed()) {
-		// this item is not important for us here
-		continue;
-	}
-//	boDebug(310) << "unit at x=" << u->x() << ",y=" << u->y() << ",pos=" << pos.x() << "," << pos.y() << endl;
-
-	if (u->distanceSquared(pos) <= radius * radius) {
-		list.append(u);
-	}
- }
+ BoUnitListVisitor visitor(&list);
+ visitUnitsInSphere(pos, radius, &visitor);
  return list;
 }
 
@@ -200,22 +406,29 @@ bool BosonCollisions::cellsOccupied(const BoRect2Fixed& rect) const
  return false;
 }
 
-// this is an extremely time-critical function!
 BoItemList* BosonCollisions::collisionsAtCells(const QPtrVector<Cell>* cells, const BosonItem* item, bool exact) const
+{
+ BoItemList* collisions = BoItemListHandler::itemListHandler()->allocateList();
+ collisionsAtCells(cells, item, exact, collisions);
+ return collisions;
+}
+
+// this is an extremely time-critical function!
+void BosonCollisions::collisionsAtCells(const QPtrVector<Cell>* cells, const BosonItem* item, bool exact, BoItemList* collisions) const
 {
  PROFILE_METHOD
  // FIXME: if exact is true we assume that cells == item->cells() !!
 // AB: item can be NULL, too!
- BoItemList* collisions = new BoItemList(); // will get deleted by BoItemListHandler
+ BO_CHECK_NULL_RET(collisions);
  const BoItemList* cellItems;
  BoItemList::ConstIterator it;
  BosonItem* s;
  if (cells->count() == 0) {
-	return collisions;
+	return;
  }
  if (!map()) {
 	BO_NULL_ERROR(map());
-	return collisions;
+	return;
  }
  for (unsigned int i = 0; i < cells->count(); i++) {
 	Cell* c = cells->at(i);
@@ -233,7 +446,6 @@ BoItemList* BosonCollisions::collisionsAtCells(const QPtrVector<Cell>* cells, co
 		}
 	}
  }
- return collisions;
 }
 
 BoItemList* BosonCollisions::collisions(const BoRect2Fixed& rect, const BosonItem* item, bool exact) const
@@ -242,11 +454,18 @@ BoItemList* BosonCollisions::collisions(const BoRect2Fixed& rect, const BosonIte
 }
 
 BoItemList* BosonCollisions::collisionsAtCells(const BoRect2Fixed& rect, const BosonItem* item, bool exact) const
+{
+ BoItemList* collisions = BoItemListHandler::itemListHandler()->allocateList();
+ collisionsAtCells(rect, item, exact, collisions);
+ return collisions;
+}
+
+void BosonCollisions::collisionsAtCells(const BoRect2Fixed& rect, const BosonItem* item, bool exact, BoItemList* result) const
 {
  PROFILE_METHOD
  if (!map()) {
 	BO_NULL_ERROR(map());
-	return new BoItemList();
+	return;
  }
  int left, right, top, bottom;
  left = QMAX((int)rect.left(), 0);
@@ -255,7 +474,7 @@ BoItemList* BosonCollisions::collisionsAtCells(const BoRect2Fixed& rect, const B
  bottom = QMIN((int)ceil(rect.bottom()), (int)map()->height());
  int size = (right - left + 1) * (bottom - top + 1);
  if (size <= 0) {
-	return new BoItemList();
+	return;
  }
  QPtrVector<Cell> cells(size);
  int n = 0;
@@ -275,7 +494,7 @@ BoItemList* BosonCollisions::collisionsAtCells(const BoRect2Fixed& rect, const B
 		n++;
 	}
  }
- return collisionsAtCells(&cells, item, exact);
+ collisionsAtCells(&cells, item, exact, result);
 }
 
 BoItemList* BosonCollisions::collisionsAtCell(int x, int y) const
@@ -284,7 +503,7 @@ BoItemList* BosonCollisions::collisionsAtCell(int x, int y) const
  Cell* c = cell(x, y);
  if (!c) {
 	boWarning(310) << k_funcinfo << "NULL cell: " << x << "," << y << endl;
-	return new BoItemList();
+	return BoItemListHandler::itemListHandler()->allocateList();
  }
  cells.insert(0, c);
 // boDebug(310) << k_funcinfo << c->x() << " " << c->y() << endl;
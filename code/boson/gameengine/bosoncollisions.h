@@ -36,9 +36,26 @@ template<class T> class QPtrList;
 template<class T> class QValueList;
 template<class T> class QPtrVector;
 
+class BoUnitGridBucket;
+
 #include "../bomath.h"
 
 
+/**
+ * Interface for range queries on @ref BosonCollisions that don't need a
+ * result list. @ref visit is called for every unit that is found.
+ **/
+class BoUnitVisitor
+{
+public:
+	virtual ~BoUnitVisitor() {}
+
+	/**
+	 * @return TRUE to continue the search, FALSE to stop it.
+	 **/
+	virtual bool visit(Unit* unit) = 0;
+};
+
 
 /**
  * @author Andreas Beckermann <b_mann@gmx.de>
@@ -89,13 +106,34 @@ public:
 	 **/
 	BosonItem* findItemAtCell(int x, int y, bofixed z, bool unitOnly) const;
 
-	void setMap(BosonMap* map) { mMap = map; }
+	void setMap(BosonMap* map);
 	inline BosonMap* map() const { return mMap; }
 
+	/**
+	 * The returned lists of these methods are taken from the arena of the
+	 * @ref BoItemListHandler (see @ref BoItemListHandler::allocateList),
+	 * you must not delete them and not use them anymore once the advance
+	 * call (or the current event) is completed.
+	 *
+	 * See also the versions taking a @p result parameter, they can be used
+	 * with a list on the stack.
+	 **/
 	BoItemList* collisionsAtCells(const QPtrVector<Cell>* cells, const BosonItem* item, bool exact) const;
 	BoItemList* collisions(const BoRect2Fixed& rect, const BosonItem* item = 0, bool exact = true) const; // note: exact == true has n effec for item != 0 ONLY!
 	BoItemList* collisionsAtCells(const BoRect2Fixed& rect, const BosonItem* item = 0, bool exact = true) const; // note: exact == true has n effec for item != 0 ONLY!
 
+	/**
+	 * @overload
+	 * Like the above, but appends the items to @p result instead of
+	 * returning a new list. @p result is not cleared.
+	 **/
+	void collisionsAtCells(const QPtrVector<Cell>* cells, const BosonItem* item, bool exact, BoItemList* result) const;
+
+	/**
+	 * @overload
+	 **/
+	void collisionsAtCells(const BoRect2Fixed& rect, const BosonItem* item, bool exact, BoItemList* result) const;
+
 	/**
 	 * @param x x-Position in <em>cell</em>-coordinates.
 	 * @param y y-Position in <em>cell</em>-coordinates.
@@ -124,6 +162,39 @@ public:
 	 **/
 	QValueList<Unit*> unitCollisionsInSphere(const BoVector3Fixed& pos, bofixed radius) const;
 
+	/**
+	 * Like @ref unitCollisionsInRange, but @p visitor is called for every
+	 * unit instead of making a list.
+	 **/
+	void visitUnitsInRange(const BoVector2Fixed& pos, bofixed radius, BoUnitVisitor* visitor) const;
+
+	/**
+	 * Like @ref unitCollisionsInSphere, but @p visitor is called for every
+	 * unit instead of making a list.
+	 **/
+	void visitUnitsInSphere(const BoVector3Fixed& pos, bofixed radius, BoUnitVisitor* visitor) const;
+
+	/**
+	 * Calls @p visitor for every unit whose center is inside @p rect
+	 * (including the borders). Destroyed units are visited, too.
+	 *
+	 * This uses the unit grid, i.e. no cells are touched.
+	 **/
+	void visitUnits(const BoRect2Fixed& rect, BoUnitVisitor* visitor) const;
+
+	/**
+	 * Adds @p item to the unit grid. Must be called only for units, after
+	 * they have been added to their cells.
+	 **/
+	void addUnitToGrid(BosonItem* item);
+
+	/**
+	 * Removes @p item from the unit grid. @p item is found by its current
+	 * position, so this must be called before it moves. Nothing happens if
+	 * @p item is not in the grid.
+	 **/
+	void removeUnitFromGrid(BosonItem* item);
+
 	/**
 	 * Returns whether cell is occupied (there is non-destroyed mobile or
 	 * facility on it) or not
@@ -151,8 +222,22 @@ public:
 private:
 	void init();
 
+	/**
+	 * @return The index of the unit grid bucket for the canvas coordinates
+	 * @p x, @p y.
+	 **/
+	int unitGridIndex(bofixed x, bofixed y) const;
+
 private:
 	BosonMap* mMap;
+
+	// Units by their center position, in buckets of
+	// UNIT_GRID_BUCKET_SIZE x UNIT_GRID_BUCKET_SIZE cells
+	BoUnitGridBucket* mUnitGrid;
+	int mUnitGridWidth;
+	int mUnitGridHeight;
+	// Largest half width/height of all units that have been in the grid
+	bofixed mMaxUnitExtent;
 };
 
 #endif
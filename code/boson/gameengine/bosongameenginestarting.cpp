@@ -38,6 +38,7 @@
 #include "unit.h"
 #include "boitemlist.h"
 #include "bosonconfig.h"
+#include "bofilehashcache.h"
 
 #include <klocale.h>
 
@@ -135,6 +136,7 @@ bool BosonGameEngineStarting::createTasks(QPtrList<BosonStartingTask>* tasks)
  connect(loadPlayField, SIGNAL(signalPlayFieldCreated(BosonPlayField*, bool*)),
 		mStarting, SLOT(slotPlayFieldCreated(BosonPlayField*, bool*)));
  loadPlayField->setFiles(mFiles);
+ loadPlayField->addProvidedResource("PlayField");
  tasks->append(loadPlayField);
 
  BosonStartingCreateCanvas* createCanvas = new BosonStartingCreateCanvas(i18n("Create Canvas"));
@@ -170,6 +172,10 @@ bool BosonGameEngineStarting::createTasks(QPtrList<BosonStartingTask>* tasks)
 	}
 	BosonStartingLoadPlayerGameData* playerData = new BosonStartingLoadPlayerGameData(text);
 	playerData->setPlayer(p);
+	playerData->addProvidedResource(QString("PlayerGameData %1").arg(p->bosonId()));
+	// the unit configs depend on the species theme only, which is known
+	// already. they can be prepared right from the start.
+	playerData->setDependsOnPreviousTasks(false);
 	tasks->append(playerData);
 	index++;
  }
@@ -301,6 +307,39 @@ unsigned int BosonStartingInitScript::taskDuration() const
  return 1;
 }
 
+BosonStartingLoadPlayerGameData::~BosonStartingLoadPlayerGameData()
+{
+ for (unsigned int i = 0; i < mPrefetchFiles.count(); i++) {
+	BoFileHashCache::removeHash(QStringList(mPrefetchFiles[i]));
+ }
+}
+
+unsigned int BosonStartingLoadPlayerGameData::beginPrepare()
+{
+ mPrefetchFiles.clear();
+ if (!player() || !player()->speciesTheme()) {
+	// startTask() will report the error
+	return 0;
+ }
+ SpeciesTheme* theme = player()->speciesTheme();
+ if (theme->unitConfigsRead()) {
+	return 0;
+ }
+ QStringList files = theme->unitConfigFiles();
+ for (QStringList::iterator it = files.begin(); it != files.end(); ++it) {
+	mPrefetchFiles.append(*it);
+ }
+ return mPrefetchFiles.count();
+}
+
+bool BosonStartingLoadPlayerGameData::preparePart(unsigned int part)
+{
+ // if the file cannot be read, UnitProperties will read (and report) it
+ // again
+ BoFileHashCache::prefetchHash(QStringList(mPrefetchFiles[part]));
+ return true;
+}
+
 bool BosonStartingLoadPlayerGameData::startTask()
 {
  boDebug(270) << k_funcinfo << endl;
@@ -22,6 +22,8 @@
 
 #include "bosonstarting.h"
 
+#include <qvaluevector.h>
+
 class BosonPlayField;
 class Player;
 class Boson;
@@ -172,9 +174,17 @@ public:
 	{
 		mPlayer = 0;
 	}
+	~BosonStartingLoadPlayerGameData();
 
 	virtual unsigned int taskDuration() const;
 
+	/**
+	 * Collects the unit configs of the species theme, so that they can be
+	 * read and hashed by @ref preparePart (see @ref BoFileHashCache).
+	 **/
+	virtual unsigned int beginPrepare();
+	virtual bool preparePart(unsigned int part);
+
 	void setPlayer(Player* p);
 	Player* player() const
 	{
@@ -186,6 +196,7 @@ protected:
 
 private:
 	Player* mPlayer;
+	QValueVector<QString> mPrefetchFiles;
 };
 
 class BosonStartingStartScenario : public BosonStartingTask
@@ -24,10 +24,12 @@
 #include "rtti.h"
 #include "cell.h" // for deleteitem. i dont want this. how can we avoid this? don't use qptrvector probably.
 #include "bosonpropertyxml.h"
+#include "bobinarysavegame.h"
 #include "bosonconfig.h"
 #include "../bo3dtools.h"
 #include "player.h"
 #include "bosonitempropertyhandler.h"
+#include "bosynchash.h"
 #include "bodebug.h"
 
 #include <qptrlist.h>
@@ -122,6 +124,8 @@ BosonItem::BosonItem(Player* owner, BosonCanvas* canvas)
 
  mId = 0;
  mX = mY = mZ = 0;
+ mUnitGridBucket = -1;
+ mUnitGridSlot = 0;
  mWidth = mHeight = 0;
  mDepth = 0;
  mCellsDirty = true;
@@ -131,6 +135,7 @@ BosonItem::BosonItem(Player* owner, BosonCanvas* canvas)
  mIsVisible = true;
  mEffectsPositionIsDirty = true;
  mEffectsRotationIsDirty = true;
+ mSaveDataHandlersAsXML = true;
 
  mXVelocity = 0;
  mYVelocity = 0;
@@ -146,6 +151,10 @@ BosonItem::BosonItem(Player* owner, BosonCanvas* canvas)
 
  mCells = new QPtrVector<Cell>();
  mAnimationMode = UnitAnimationIdle;
+
+ mSyncState = 0;
+ mSyncHash = 0;
+ updateSyncHash();
 }
 
 BosonItem::~BosonItem()
@@ -159,6 +168,9 @@ BosonItem::~BosonItem()
 	}
  }
  delete mCells;
+ if (canvas()) {
+	canvas()->changeItemsSyncHash(mSyncHash, 0);
+ }
 }
 
 
@@ -316,6 +328,29 @@ BoRect2Fixed BosonItem::boundingRectAdvanced() const
  return BoRect2Fixed(left, top, left + width(), top + height());
 }
 
+Q_UINT64 BosonItem::syncState() const
+{
+ Q_UINT64 h = BoSyncHash::add(0, (Q_UINT64)id());
+ h = BoSyncHash::add(h, (Q_UINT64)rtti());
+ h = BoSyncHash::add(h, xRotation());
+ h = BoSyncHash::add(h, yRotation());
+ return h;
+}
+
+void BosonItem::updateSyncHash()
+{
+ Q_UINT64 h = mSyncState;
+ h = BoSyncHash::add(h, mX);
+ h = BoSyncHash::add(h, mY);
+ h = BoSyncHash::add(h, mZ);
+ h = BoSyncHash::add(h, mRotation);
+ h = BoSyncHash::finish(h);
+ if (canvas()) {
+	canvas()->changeItemsSyncHash(mSyncHash, h);
+ }
+ mSyncHash = h;
+}
+
 void BosonItem::itemAboutToMove(bofixed dx, bofixed dy, bofixed dz)
 {
  Q_UNUSED(dx);
@@ -400,7 +435,7 @@ bool BosonItem::saveAsXML(QDomElement& root)
  BosonCustomPropertyXML propertyXML;
  QDomDocument doc = root.ownerDocument();
  QDomElement handler = doc.createElement(QString::fromLatin1("DataHandler"));
- if (!propertyXML.saveAsXML(handler, dataHandler())) {
+ if (saveDataHandlersAsXML() && !propertyXML.saveAsXML(handler, dataHandler())) {
 	boError() << k_funcinfo << "Unable to save datahandler of item" << endl;
 	return false;
  }
@@ -410,6 +445,27 @@ bool BosonItem::saveAsXML(QDomElement& root)
  return true;
 }
 
+bool BosonItem::saveAsXMLWithoutDataHandlers(QDomElement& root)
+{
+ mSaveDataHandlersAsXML = false;
+ bool ret = saveAsXML(root);
+ mSaveDataHandlersAsXML = true;
+ return ret;
+}
+
+void BosonItem::saveDataHandlers(BoBinarySaveGameWriter* writer, QDataStream& stream)
+{
+ writer->writePropertyHandler(stream, QString::fromLatin1("DataHandler"), dataHandler());
+}
+
+KGamePropertyHandler* BosonItem::dataHandlerByName(const QString& name)
+{
+ if (name == QString::fromLatin1("DataHandler")) {
+	return dataHandler();
+ }
+ return 0;
+}
+
 bool BosonItem::loadFromXML(const QDomElement& root)
 {
  if (root.isNull()) {
@@ -41,6 +41,7 @@ typedef BoRect2<bofixed> BoRect2Fixed;
 typedef BoVector2<bofixed> BoVector2Fixed;
 typedef BoVector3<bofixed> BoVector3Fixed;
 class BoFrustum;
+class BoBinarySaveGameWriter;
 
 class KGamePropertyHandler;
 class KGamePropertyBase;
@@ -217,7 +218,7 @@ public:
 	 * Set a unique Id for this item. The Id <em>must</em> be unique for
 	 * <em>all</em> items in the game. Otherwise the results are undefined.
 	 **/
-	void setId(unsigned long int id) { mId = id; }
+	void setId(unsigned long int id) { mId = id; updateSyncState(); }
 
 	/**
 	 * @return An id that identifies this item uniquely. There are never 2
@@ -309,6 +310,7 @@ public:
 			mX += dx;
 			mY += dy;
 			mZ += dz;
+			updateSyncHash();
 			itemHasMoved(dx, dy, dz);
 		}
 	}
@@ -403,6 +405,19 @@ public:
 	 **/
 	bool bosonCollidesWith(const BoVector3Fixed& v1, const BoVector3Fixed& v2) const;
 
+	/**
+	 * @internal
+	 * Used by @ref BosonCollisions to remember where this item is stored
+	 * in the unit grid. @p bucket is -1 if the item is not in the grid.
+	 **/
+	inline void setUnitGridSlot(int bucket, unsigned int slot)
+	{
+		mUnitGridBucket = bucket;
+		mUnitGridSlot = slot;
+	}
+	inline int unitGridBucket() const { return mUnitGridBucket; }
+	inline unsigned int unitGridSlot() const { return mUnitGridSlot; }
+
 	inline bofixed xVelocity() const { return mXVelocity; }
 	inline bofixed yVelocity() const { return mYVelocity; }
 	inline bofixed zVelocity() const { return mZVelocity; }
@@ -512,13 +527,34 @@ public:
 	 * unit to correct direction when moving.
 	 **/
 	inline bofixed rotation() const { return mRotation; }
-	void setRotation(bofixed r) { mRotation = r; setEffectsRotationDirty(true); }
+	void setRotation(bofixed r) { mRotation = r; setEffectsRotationDirty(true); updateSyncHash(); }
 
 	inline bofixed xRotation() const { return mXRotation; }
-	void setXRotation(bofixed r) { mXRotation = r; setEffectsRotationDirty(true); }
+	void setXRotation(bofixed r) { mXRotation = r; setEffectsRotationDirty(true); updateSyncState(); }
 
 	inline bofixed yRotation() const { return mYRotation; }
-	void setYRotation(bofixed r) { mYRotation = r; setEffectsRotationDirty(true); }
+	void setYRotation(bofixed r) { mYRotation = r; setEffectsRotationDirty(true); updateSyncState(); }
+
+	/**
+	 * @return A hash (see @ref BoSyncHash) of all values of this item that
+	 * must be the same on all clients, except of position and rotation
+	 * (they are always part of the hash of the item). This is used by the
+	 * network sync checks, see @ref BosonCanvas::itemsSyncHash.
+	 *
+	 * Derived classes that add such values should include the value of
+	 * the base class and make sure that @ref updateSyncState is called
+	 * whenever one of them changes.
+	 **/
+	virtual Q_UINT64 syncState() const;
+
+	/**
+	 * Recalculate the hash of this item, using the current @ref syncState.
+	 **/
+	inline void updateSyncState()
+	{
+		mSyncState = syncState();
+		updateSyncHash();
+	}
 
 
 	/**
@@ -536,6 +572,28 @@ public:
 	virtual bool saveAsXML(QDomElement&);
 	virtual bool loadFromXML(const QDomElement&);
 
+	/**
+	 * Like @ref saveAsXML, but the property handlers (such as the @ref
+	 * dataHandler) are saved as empty elements only. Use @ref
+	 * saveDataHandlers to save them. See @ref
+	 * BosonCanvas::saveCanvasBinary.
+	 **/
+	bool saveAsXMLWithoutDataHandlers(QDomElement& root);
+
+	/**
+	 * Write all property handlers of this item to @p stream, see @ref
+	 * BoBinarySaveGameWriter::writePropertyHandler. Derived classes with
+	 * additional handlers must save them here as well.
+	 **/
+	virtual void saveDataHandlers(BoBinarySaveGameWriter* writer, QDataStream& stream);
+
+	/**
+	 * @return The property handler that is saved as @p name by @ref
+	 * saveDataHandlers (e.g. "DataHandler" for @ref dataHandler) or NULL
+	 * if this item has no such handler.
+	 **/
+	virtual KGamePropertyHandler* dataHandlerByName(const QString& name);
+
 	/**
 	 * @return The team color this item should get rendered with. This
 	 * should be the @ref Player::teamColor of the owner, if applicable. For
@@ -563,6 +621,15 @@ public:
 	}
 
 protected:
+	/**
+	 * @return FALSE if @ref saveAsXML should save empty elements for the
+	 * property handlers only, see @ref saveAsXMLWithoutDataHandlers.
+	 **/
+	bool saveDataHandlersAsXML() const
+	{
+		return mSaveDataHandlersAsXML;
+	}
+
 	/**
 	 * @return The current animation mode. @ref UnitAnimationIdle by
 	 * default. Note that currently only units use animations, but they
@@ -600,6 +667,13 @@ private:
 	 **/
 	void removeFromCells();
 
+	/**
+	 * Update the hash of this item (see @ref updateSyncState) and its
+	 * contribution to @ref BosonCanvas::itemsSyncHash after position or
+	 * rotation changed.
+	 **/
+	void updateSyncHash();
+
 private:
 	BosonCanvas* mCanvas;
 	Player* mOwner;
@@ -609,6 +683,8 @@ private:
 	bofixed mX; // centerX
 	bofixed mY; // centerY
 	bofixed mZ; // NOT the center! still the bottom of the unit (should be changed to centerZ too!)
+	int mUnitGridBucket;
+	unsigned int mUnitGridSlot;
 	bofixed mWidth;
 	bofixed mHeight;
 	bofixed mDepth;
@@ -626,6 +702,10 @@ private:
 	bofixed mXRotation;
 	bofixed mYRotation;
 
+	// see updateSyncState() and updateSyncHash()
+	Q_UINT64 mSyncState;
+	Q_UINT64 mSyncHash;
+
 	bool mIsSelected;
 	bool mIsGroupLeaderOfSelection;
 
@@ -636,6 +716,8 @@ private:
 	bool mEffectsPositionIsDirty;
 	bool mEffectsRotationIsDirty;
 
+	bool mSaveDataHandlersAsXML;
+
 	// AB: this is NOT saved to any file! it is calculated on the fly by
 	// updateAnimationMode() and getAnimationMode()
 	int mAnimationMode;
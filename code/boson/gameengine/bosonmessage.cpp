@@ -64,6 +64,197 @@ bool BosonMessage::copyTo(BosonMessage& copy) const
  return true;
 }
 
+bool BosonMessage::saveCompact(QDataStream& stream) const
+{
+ // messages without a compact format of their own use the data of save(),
+ // but without the message ID, as that is part of the batch already.
+ QByteArray buffer;
+ QDataStream write(buffer, IO_WriteOnly);
+ if (!save(write)) {
+	return false;
+ }
+ QDataStream read(buffer, IO_ReadOnly);
+ if (!readMessageId(read)) {
+	boError() << k_funcinfo << "could not read messageId from saved message" << endl;
+	return false;
+ }
+ unsigned int pos = read.device()->at();
+ stream.writeRawBytes(buffer.data() + pos, buffer.size() - pos);
+ return true;
+}
+
+bool BosonMessage::loadCompact(QDataStream& stream)
+{
+ return load(stream);
+}
+
+BosonMessage* BosonMessage::createMessage(Q_UINT32 msgid, bool editor)
+{
+ if (editor) {
+	switch (msgid) {
+		case BosonMessageIds::MovePlaceUnit:
+			return new BosonMessageEditorMovePlaceUnit();
+		case BosonMessageIds::MoveChangeTexMap:
+			return new BosonMessageEditorMoveChangeTexMap();
+		case BosonMessageIds::MoveChangeHeight:
+			return new BosonMessageEditorMoveChangeHeight();
+		case BosonMessageIds::MoveDeleteItems:
+			return new BosonMessageEditorMoveDeleteItems();
+		case BosonMessageIds::MoveUndoPlaceUnit:
+			return new BosonMessageEditorMoveUndoPlaceUnit();
+		case BosonMessageIds::MoveUndoChangeHeight:
+			return new BosonMessageEditorMoveUndoChangeHeight();
+		case BosonMessageIds::MoveUndoDeleteItems:
+			return new BosonMessageEditorMoveUndoDeleteItems();
+		default:
+			return 0;
+	}
+ }
+ switch (msgid) {
+	case BosonMessageIds::MoveMove:
+		return new BosonMessageMoveMove();
+	case BosonMessageIds::MoveAttack:
+		return new BosonMessageMoveAttack();
+	case BosonMessageIds::MoveStop:
+		return new BosonMessageMoveStop();
+	case BosonMessageIds::MoveMine:
+		return new BosonMessageMoveMine();
+	case BosonMessageIds::MoveRefine:
+		return new BosonMessageMoveRefine();
+	case BosonMessageIds::MoveRepair:
+		return new BosonMessageMoveRepair();
+	case BosonMessageIds::MoveProduce:
+		return new BosonMessageMoveProduce();
+	case BosonMessageIds::MoveProduceStop:
+		return new BosonMessageMoveProduceStop();
+	case BosonMessageIds::MoveBuild:
+		return new BosonMessageMoveBuild();
+	case BosonMessageIds::MoveFollow:
+		return new BosonMessageMoveFollow();
+	case BosonMessageIds::MoveEnterUnit:
+		return new BosonMessageMoveEnterUnit();
+	case BosonMessageIds::MoveLayMine:
+		return new BosonMessageMoveLayMine();
+	case BosonMessageIds::MoveDropBomb:
+		return new BosonMessageMoveDropBomb();
+	case BosonMessageIds::MoveTeleport:
+		return new BosonMessageMoveTeleport();
+	case BosonMessageIds::MoveRotate:
+		return new BosonMessageMoveRotate();
+	default:
+		break;
+ }
+ return 0;
+}
+
+void BosonMessage::saveVarUInt(QDataStream& stream, Q_UINT32 value)
+{
+ while (value >= 0x80) {
+	stream << (Q_UINT8)((value & 0x7f) | 0x80);
+	value >>= 7;
+ }
+ stream << (Q_UINT8)value;
+}
+
+Q_UINT32 BosonMessage::loadVarUInt(QDataStream& stream)
+{
+ Q_UINT32 value = 0;
+ for (int shift = 0; shift < 32; shift += 7) {
+	Q_UINT8 byte = 0;
+	stream >> byte;
+	value |= ((Q_UINT32)(byte & 0x7f)) << shift;
+	if (!(byte & 0x80)) {
+		break;
+	}
+ }
+ return value;
+}
+
+void BosonMessage::saveVarInt(QDataStream& stream, Q_INT32 value)
+{
+ // "zigzag" encoding: 0, -1, 1, -2, 2, ... are stored as 0, 1, 2, 3, 4, ...
+ saveVarUInt(stream, ((Q_UINT32)value << 1) ^ (Q_UINT32)(value >> 31));
+}
+
+Q_INT32 BosonMessage::loadVarInt(QDataStream& stream)
+{
+ Q_UINT32 v = loadVarUInt(stream);
+ return (Q_INT32)((v >> 1) ^ (~(v & 1) + 1));
+}
+
+void BosonMessage::saveIdList(QDataStream& stream, const QValueList<Q_ULONG>& ids)
+{
+ // every run of consecutive IDs is stored as the difference of its first ID
+ // to the last ID of the previous run, followed by the length of the run.
+ saveVarUInt(stream, ids.count());
+ Q_ULONG previous = 0;
+ QValueList<Q_ULONG>::const_iterator it = ids.begin();
+ while (it != ids.end()) {
+	Q_ULONG first = *it;
+	Q_UINT32 length = 1;
+	++it;
+	while (it != ids.end() && *it == first + length) {
+		length++;
+		++it;
+	}
+	saveVarInt(stream, (Q_INT32)(first - previous));
+	saveVarUInt(stream, length - 1);
+	previous = first + length - 1;
+ }
+}
+
+bool BosonMessage::loadIdList(QDataStream& stream, QValueList<Q_ULONG>* ids)
+{
+ ids->clear();
+ Q_UINT32 count = loadVarUInt(stream);
+ if (count > 65536) {
+	boError() << k_funcinfo << "broken message. tried to allocate size for " << count << " IDs" << endl;
+	return false;
+ }
+ Q_ULONG previous = 0;
+ while (ids->count() < count) {
+	Q_ULONG first = (Q_ULONG)((Q_LONG)previous + loadVarInt(stream));
+	Q_UINT32 length = loadVarUInt(stream) + 1;
+	if (length > count - ids->count()) {
+		boError() << k_funcinfo << "broken message. invalid run length " << length << endl;
+		return false;
+	}
+	for (Q_UINT32 i = 0; i < length; i++) {
+		ids->append(first + i);
+	}
+	previous = first + length - 1;
+ }
+ return true;
+}
+
+// positions are stored in 1/256 cells, i.e. a position on a 500x500 map needs
+// 3 bytes per coordinate at most.
+#define POS_QUANTIZATION_SHIFT (BITS_AFTER_POINT - 8)
+
+void BosonMessage::saveCompactPos(QDataStream& stream, const BoVector2Fixed& pos)
+{
+#ifdef BOFIXED_IS_FLOAT
+ stream << pos;
+#else
+ const Q_INT32 round = 1 << (POS_QUANTIZATION_SHIFT - 1);
+ saveVarInt(stream, (pos.x().rawInt() + round) >> POS_QUANTIZATION_SHIFT);
+ saveVarInt(stream, (pos.y().rawInt() + round) >> POS_QUANTIZATION_SHIFT);
+#endif
+}
+
+void BosonMessage::loadCompactPos(QDataStream& stream, BoVector2Fixed* pos)
+{
+#ifdef BOFIXED_IS_FLOAT
+ stream >> *pos;
+#else
+ bofixed x;
+ bofixed y;
+ x.setFromRawInt(loadVarInt(stream) * (1 << POS_QUANTIZATION_SHIFT));
+ y.setFromRawInt(loadVarInt(stream) * (1 << POS_QUANTIZATION_SHIFT));
+ pos->set(x, y);
+#endif
+}
+
 BosonMessageEditorMove::BosonMessageEditorMove()
 	: BosonMessage()
 {
@@ -435,6 +626,61 @@ bool BosonMessageEditorMoveChangeHeight::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageEditorMoveChangeHeight::saveCompact(QDataStream& stream) const
+{
+ if (mCellCornersX.count() != mCellCornersY.count() ||
+		mCellCornersX.count() != mCellCornersHeight.count()) {
+	boError() << k_funcinfo << "invalid cell counts" << endl;
+	return false;
+ }
+ if (!BosonMessageEditorMove::saveFlags(stream)) {
+	return false;
+ }
+ // the corners are usually next to each other (and so are their heights),
+ // so we store differences to the previous corner only. the heights are not
+ // quantized, the editor needs the exact values for undo.
+ saveVarUInt(stream, mCellCornersX.count());
+ Q_INT32 x = 0;
+ Q_INT32 y = 0;
+ Q_INT32 height = 0;
+ for (unsigned int i = 0; i < mCellCornersX.count(); i++) {
+	saveVarInt(stream, (Q_INT32)mCellCornersX[i] - x);
+	saveVarInt(stream, (Q_INT32)mCellCornersY[i] - y);
+	saveVarInt(stream, mCellCornersHeight[i].rawInt() - height);
+	x = mCellCornersX[i];
+	y = mCellCornersY[i];
+	height = mCellCornersHeight[i].rawInt();
+ }
+ return true;
+}
+
+bool BosonMessageEditorMoveChangeHeight::loadCompact(QDataStream& stream)
+{
+ if (!BosonMessageEditorMove::loadFlags(stream)) {
+	return false;
+ }
+ Q_UINT32 count = loadVarUInt(stream);
+ if (count > 65536) {
+	boError() << k_funcinfo << "broken message. tried to allocate size for " << count << " corners" << endl;
+	return false;
+ }
+ mCellCornersX.resize(count);
+ mCellCornersY.resize(count);
+ mCellCornersHeight.resize(count);
+ Q_INT32 x = 0;
+ Q_INT32 y = 0;
+ Q_INT32 height = 0;
+ for (Q_UINT32 i = 0; i < count; i++) {
+	x += loadVarInt(stream);
+	y += loadVarInt(stream);
+	height += loadVarInt(stream);
+	mCellCornersX[i] = (Q_UINT32)x;
+	mCellCornersY[i] = (Q_UINT32)y;
+	mCellCornersHeight[i].setFromRawInt(height);
+ }
+ return true;
+}
+
 BosonMessageEditorMoveDeleteItems::BosonMessageEditorMoveDeleteItems()
 	: BosonMessageEditorMove()
 {
@@ -478,6 +724,23 @@ bool BosonMessageEditorMoveDeleteItems::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageEditorMoveDeleteItems::saveCompact(QDataStream& stream) const
+{
+ if (!BosonMessageEditorMove::saveFlags(stream)) {
+	return false;
+ }
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageEditorMoveDeleteItems::loadCompact(QDataStream& stream)
+{
+ if (!BosonMessageEditorMove::loadFlags(stream)) {
+	return false;
+ }
+ return loadIdList(stream, &mItems);
+}
+
 BosonMessageEditorMoveUndoDeleteItems::BosonMessageEditorMoveUndoDeleteItems(
 		const QValueList<BosonMessageEditorMovePlaceUnit*>& units,
 		const QValueList<QString>& unitsData,
@@ -686,6 +949,21 @@ bool BosonMessageMoveMove::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveMove::saveCompact(QDataStream& stream) const
+{
+ stream << (Q_INT8)mIsAttack;
+ saveCompactPos(stream, mPos);
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveMove::loadCompact(QDataStream& stream)
+{
+ stream >> mIsAttack;
+ loadCompactPos(stream, &mPos);
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveAttack::save(QDataStream& stream) const
 {
  stream << (Q_UINT32)messageId();
@@ -713,6 +991,19 @@ bool BosonMessageMoveAttack::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveAttack::saveCompact(QDataStream& stream) const
+{
+ saveVarUInt(stream, (Q_UINT32)mAttackedUnitId);
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveAttack::loadCompact(QDataStream& stream)
+{
+ mAttackedUnitId = loadVarUInt(stream);
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveStop::save(QDataStream& stream) const
 {
  stream << (Q_UINT32)messageId();
@@ -738,6 +1029,17 @@ bool BosonMessageMoveStop::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveStop::saveCompact(QDataStream& stream) const
+{
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveStop::loadCompact(QDataStream& stream)
+{
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveMine::save(QDataStream& stream) const
 {
  stream << (Q_UINT32)messageId();
@@ -783,6 +1085,21 @@ bool BosonMessageMoveRefine::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveRefine::saveCompact(QDataStream& stream) const
+{
+ saveVarUInt(stream, (Q_UINT32)mRefineryOwner);
+ saveVarUInt(stream, (Q_UINT32)mRefineryId);
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveRefine::loadCompact(QDataStream& stream)
+{
+ mRefineryOwner = loadVarUInt(stream);
+ mRefineryId = loadVarUInt(stream);
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveRepair::save(QDataStream& stream) const
 {
  stream << (Q_UINT32)messageId();
@@ -882,6 +1199,19 @@ bool BosonMessageMoveFollow::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveFollow::saveCompact(QDataStream& stream) const
+{
+ saveVarUInt(stream, (Q_UINT32)mFollowUnitId);
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveFollow::loadCompact(QDataStream& stream)
+{
+ mFollowUnitId = loadVarUInt(stream);
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveEnterUnit::save(QDataStream& stream) const
 {
  stream << (Q_UINT32)messageId();
@@ -909,6 +1239,19 @@ bool BosonMessageMoveEnterUnit::load(QDataStream& stream)
  return true;
 }
 
+bool BosonMessageMoveEnterUnit::saveCompact(QDataStream& stream) const
+{
+ saveVarUInt(stream, (Q_UINT32)mEnterUnitId);
+ saveIdList(stream, mItems);
+ return true;
+}
+
+bool BosonMessageMoveEnterUnit::loadCompact(QDataStream& stream)
+{
+ mEnterUnitId = loadVarUInt(stream);
+ return loadIdList(stream, &mItems);
+}
+
 bool BosonMessageMoveLayMine::save(QDataStream& stream) const
 {
  if (mUnits.count() != mWeapons.count()) {
@@ -1013,3 +1356,68 @@ bool BosonMessageMoveRotate::load(QDataStream& stream)
  return true;
 }
 
+BosonMessageBatch::BosonMessageBatch()
+{
+ mEditor = false;
+}
+
+void BosonMessageBatch::clear()
+{
+ mMessages.clear();
+ mEditor = false;
+}
+
+unsigned int BosonMessageBatch::append(const BosonMessage& message)
+{
+ bool editor = (dynamic_cast<const BosonMessageEditorMove*>(&message) != 0);
+ if (!isEmpty() && editor != mEditor) {
+	boError() << k_funcinfo << "cannot mix editor and game messages in a batch" << endl;
+	return 0;
+ }
+ QByteArray buffer;
+ QDataStream stream(buffer, IO_WriteOnly);
+ BosonMessage::saveVarUInt(stream, message.messageId());
+ if (!message.saveCompact(stream)) {
+	boError() << k_funcinfo << "unable to save message (" << message.messageId() << ")" << endl;
+	return 0;
+ }
+ mEditor = editor;
+ mMessages.append(buffer);
+ return buffer.size();
+}
+
+bool BosonMessageBatch::save(QDataStream& stream) const
+{
+ if (isEmpty()) {
+	boError() << k_funcinfo << "nothing to save" << endl;
+	return false;
+ }
+ if (mEditor) {
+	stream << (Q_UINT32)BosonMessageIds::MoveEditor;
+ }
+ stream << (Q_UINT32)BosonMessageIds::MoveBatch;
+ stream << (Q_UINT8)FormatVersion;
+ BosonMessage::saveVarUInt(stream, count());
+ QValueList<QByteArray>::const_iterator it;
+ for (it = mMessages.begin(); it != mMessages.end(); ++it) {
+	stream.writeRawBytes((*it).data(), (*it).size());
+ }
+ return true;
+}
+
+bool BosonMessageBatch::loadHeader(QDataStream& stream, Q_UINT32* count)
+{
+ // AB: msgid and editor flag have been read already
+ Q_UINT8 version;
+ stream >> version;
+ if (version != FormatVersion) {
+	boError() << k_funcinfo << "cannot read batch format version " << (int)version << ", expected " << (int)FormatVersion << endl;
+	return false;
+ }
+ *count = BosonMessage::loadVarUInt(stream);
+ if (*count > 65536) {
+	boError() << k_funcinfo << "broken message. " << *count << " messages in a batch" << endl;
+	return false;
+ }
+ return true;
+}
@@ -47,6 +47,23 @@ public:
 	virtual bool save(QDataStream& stream) const = 0;
 	virtual bool load(QDataStream& stream) = 0;
 
+	/**
+	 * Save the message in the compact format that is used for network
+	 * transmission, see @ref BosonMessageBatch. In contrast to @ref save
+	 * the message ID is not included.
+	 *
+	 * The default implementation writes the same data as @ref save. Messages
+	 * that are sent frequently or that can be large should reimplement this
+	 * (and @ref loadCompact).
+	 **/
+	virtual bool saveCompact(QDataStream& stream) const;
+
+	/**
+	 * Load a message that was saved by @ref saveCompact. The default
+	 * implementation simply calls @ref load.
+	 **/
+	virtual bool loadCompact(QDataStream& stream);
+
 
 	/**
 	 * @internal
@@ -57,6 +74,41 @@ public:
 	virtual bool readMessageId(QDataStream& stream) const;
 
 	bool copyTo(BosonMessage& copy) const;
+
+	/**
+	 * @return A new message object for the message ID @p msgid, or NULL if
+	 * @p msgid is not a player input. @p editor specifies whether the
+	 * message is prefixed by @ref BosonMessageIds::MoveEditor.
+	 **/
+	static BosonMessage* createMessage(Q_UINT32 msgid, bool editor);
+
+	// helpers for the compact format.
+	/**
+	 * Save @p value in as few bytes as possible (7 bits per byte). Small
+	 * values need 1 byte only.
+	 **/
+	static void saveVarUInt(QDataStream& stream, Q_UINT32 value);
+	static Q_UINT32 loadVarUInt(QDataStream& stream);
+	/**
+	 * Like @ref saveVarUInt, but small negative values need few bytes as
+	 * well.
+	 **/
+	static void saveVarInt(QDataStream& stream, Q_INT32 value);
+	static Q_INT32 loadVarInt(QDataStream& stream);
+
+	/**
+	 * Save a list of (unit) IDs. Consecutive IDs are stored as runs, so e.g.
+	 * a group of units that was produced in a row needs 2 or 3 bytes only.
+	 * The order of the IDs is preserved.
+	 **/
+	static void saveIdList(QDataStream& stream, const QValueList<Q_ULONG>& ids);
+	static bool loadIdList(QDataStream& stream, QValueList<Q_ULONG>* ids);
+
+	/**
+	 * Save a position quantized to 1/256 of a cell.
+	 **/
+	static void saveCompactPos(QDataStream& stream, const BoVector2Fixed& pos);
+	static void loadCompactPos(QDataStream& stream, BoVector2Fixed* pos);
 };
 
 class BosonMessageEditorMove : public BosonMessage
@@ -162,6 +214,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveChangeHeight;
@@ -181,6 +235,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveDeleteItems;
@@ -278,6 +334,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveMove;
@@ -302,6 +360,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveAttack;
@@ -324,6 +384,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveStop;
@@ -370,6 +432,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveRefine;
@@ -497,6 +561,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveFollow;
@@ -520,6 +586,8 @@ public:
 
 	virtual bool save(QDataStream& stream) const;
 	virtual bool load(QDataStream& stream);
+	virtual bool saveCompact(QDataStream& stream) const;
+	virtual bool loadCompact(QDataStream& stream);
 	virtual int messageId() const
 	{
 		return BosonMessageIds::MoveEnterUnit;
@@ -628,5 +696,76 @@ public:
 	bofixed mRotate;
 };
 
+/**
+ * @short A number of player inputs that are sent in a single network message.
+ *
+ * Every player input (aka order, see @ref BosonMessageIds::MoveMove and
+ * following) would be a network message of its own, which costs a lot of
+ * bytes for the network headers alone. Therefore the orders of a player are
+ * collected in a batch (see @ref append) and sent together (see @ref save),
+ * usually once per advance call.
+ *
+ * The orders are stored using @ref BosonMessage::saveCompact.
+ *
+ * A batch is saved as
+ * @li @ref BosonMessageIds::MoveEditor (editor mode only)
+ * @li @ref BosonMessageIds::MoveBatch
+ * @li The format version (@ref FormatVersion), Q_UINT8
+ * @li The number of orders (@ref BosonMessage::saveVarUInt)
+ * @li For every order the message ID (@ref BosonMessage::saveVarUInt) and the
+ * compact data of the message
+ **/
+class BosonMessageBatch
+{
+public:
+	enum {
+		// increase this whenever the compact format of a message changes
+		FormatVersion = 1
+	};
+
+	BosonMessageBatch();
+
+	/**
+	 * Append @p message to the batch. Note that all messages of a batch
+	 * must either be editor messages or game messages.
+	 * @return The number of bytes that were used for @p message, or 0 on
+	 * error.
+	 **/
+	unsigned int append(const BosonMessage& message);
+
+	unsigned int count() const
+	{
+		return mMessages.count();
+	}
+	bool isEmpty() const
+	{
+		return mMessages.isEmpty();
+	}
+	bool isEditor() const
+	{
+		return mEditor;
+	}
+
+	void clear();
+
+	/**
+	 * Save all messages of the batch to @p stream.
+	 **/
+	bool save(QDataStream& stream) const;
+
+	/**
+	 * Read the header of a batch. The message ID (and the @ref
+	 * BosonMessageIds::MoveEditor prefix) must have been read already.
+	 * @param count Set to the number of messages in the batch. Every message
+	 * must be read using the message ID (see @ref BosonMessage::loadVarUInt)
+	 * and @ref BosonMessage::loadCompact.
+	 **/
+	static bool loadHeader(QDataStream& stream, Q_UINT32* count);
+
+private:
+	QValueList<QByteArray> mMessages;
+	bool mEditor;
+};
+
 #endif
 
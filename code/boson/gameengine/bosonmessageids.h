@@ -66,6 +66,8 @@ public:
 		IdNetworkRequestSync = 82,
 		IdNetworkSync = 83,
 		IdNetworkSyncUnlockGame = 84,
+		IdNetworkSyncCheckRequestLog = 85, // a SyncCheck hash did not match, make a complete log
+		IdReplayKeyframe = 86, // a new random seed. clients take a keyframe of the replay here, see BoReplayKeyframe
 
 	// Player Moves aka Player Input:
 		MoveMove = 100, // Unit(s) is/are moved
@@ -83,6 +85,8 @@ public:
 		MoveLayMine = 120,
 		MoveDropBomb = 121,
 
+		MoveBatch = 130, // several of the above in a compact format, see BosonMessageBatch
+
 		MoveTeleport = 150,  // Immediately move unit (set it's position)
 		MoveRotate = 151,  // Set unit's rotation
 
@@ -28,6 +28,7 @@
 #include "boitemlist.h"
 #include "rtti.h"
 #include "bosonitem.h"
+#include "bosynchash.h"
 #include "unit.h"
 #include "player.h"
 #include "bosonmap.h"
@@ -81,6 +82,30 @@
 #define DECLARE_UNSTREAM_COMPARE(type, name) DECLARE(type, name) UNSTREAM(name) COMPARE(name)
 
 
+// type of a SyncCheck message
+enum SyncCheckType {
+	SyncCheckHash = 0, // state hash only, see BosonNetworkSyncChecker::createSyncHash()
+	SyncCheckLog = 1 // MD5 sum of a complete log
+};
+
+/**
+ * An entry in the queue of sync checks that have been created by a client but
+ * not yet been checked against the values of the ADMIN. For a hash check only
+ * @ref mHash is used, for a log check only @ref mLog.
+ **/
+class BoSyncCheckEntry
+{
+public:
+	BoSyncCheckEntry(Q_INT8 type)
+	{
+		mType = type;
+		mHash = 0;
+	}
+	Q_INT8 mType;
+	Q_UINT64 mHash;
+	QByteArray mLog;
+};
+
 class BoAwaitAck
 {
 public:
@@ -99,11 +124,27 @@ public:
 		QByteArray buffer;
 		QDataStream stream(buffer, IO_WriteOnly);
 		stream << (Q_UINT32)syncId;
+		stream << (Q_INT8)SyncCheckLog;
 		stream << md5.hexDigest();
 		game->sendMessage(buffer, BosonMessageIds::IdNetworkSyncCheck);
 		mClientsLeft = game->messageClient()->clientList();
 		return;
 	}
+	void sendHash(Boson* game, Q_UINT64 hash, unsigned long int syncId)
+	{
+		if (!game->isAdmin()) {
+			boError(370) << k_funcinfo << "must not be called if not admin!!" << endl;
+			return;
+		}
+		QByteArray buffer;
+		QDataStream stream(buffer, IO_WriteOnly);
+		stream << (Q_UINT32)syncId;
+		stream << (Q_INT8)SyncCheckHash;
+		stream << hash;
+		game->sendMessage(buffer, BosonMessageIds::IdNetworkSyncCheck);
+		mClientsLeft = game->messageClient()->clientList();
+		return;
+	}
 	bool receiveAck(Q_UINT32 sender)
 	{
 		mClientsLeft.remove(sender);
@@ -384,6 +425,9 @@ QByteArray BoPathSyncCheckMessage::makeLog()
  stream << mPathFinder->mChangedBlocks.count();
  stream << mPathFinder->mDirtyConnections.count();
  stream << mPathFinder->mBlockStatusDirty.count();
+ stream << (Q_UINT32)mPathFinder->mHighLevelCache.count();
+ stream << (Q_UINT32)mPathFinder->mFlowFields.count();
+ stream << (Q_UINT32)mPathFinder->mPathRequests.count();
 
  return b;
 }
@@ -419,6 +463,9 @@ QString BoPathSyncCheckMessage::findLogError(const QByteArray& b1, const QByteAr
  DECLARE_UNSTREAM_COMPARE(Q_UINT32, changedBlocksCount);
  DECLARE_UNSTREAM_COMPARE(Q_UINT32, dirtyConnectionsCount);
  DECLARE_UNSTREAM_COMPARE(Q_UINT32, blockStatusDirtyCount);
+ DECLARE_UNSTREAM_COMPARE(Q_UINT32, highLevelCacheCount);
+ DECLARE_UNSTREAM_COMPARE(Q_UINT32, flowFieldCount);
+ DECLARE_UNSTREAM_COMPARE(Q_UINT32, pathRequestCount);
 
 
  return error;
@@ -908,6 +955,17 @@ void BosonNetworkSynchronizer::setMessageLogger(BoMessageLogger* logger)
  d->mSyncChecker.setMessageLogger(logger);
 }
 
+QByteArray BosonNetworkSynchronizer::makeCanvasLog(BosonCanvas* canvas)
+{
+ if (!canvas) {
+	BO_NULL_ERROR(canvas);
+	return QByteArray();
+ }
+ BoCanvasSyncCheckMessage message;
+ message.setCanvas(canvas, 0, 0); // interval == 0 means log everything
+ return message.makeLog();
+}
+
 void BosonNetworkSynchronizer::receiveAdvanceMessage(BosonCanvas* canvas)
 {
  d->mSyncChecker.receiveAdvanceMessage(canvas);
@@ -923,6 +981,12 @@ bool BosonNetworkSynchronizer::receiveNetworkSyncCheckAck(QDataStream& stream, Q
  return d->mSyncChecker.receiveNetworkSyncCheckAck(stream, sender);
 }
 
+void BosonNetworkSynchronizer::receiveNetworkSyncCheckRequestLog(QDataStream& stream)
+{
+ Q_UNUSED(stream);
+ d->mSyncChecker.receiveRequestCompleteLog();
+}
+
 bool BosonNetworkSynchronizer::receiveNetworkRequestSync(QDataStream& stream)
 {
  return d->mSyncer.receiveNetworkRequestSync(stream);
@@ -1094,7 +1158,7 @@ public:
 	BosonNetworkSyncCheckerPrivate()
 	{
 	}
-	QPtrQueue<QByteArray> mLogs;
+	QPtrQueue<BoSyncCheckEntry> mLogs;
 	QIntDict<BoAwaitAck> mAwaitAcks;
 };
 
@@ -1103,6 +1167,8 @@ BosonNetworkSyncChecker::BosonNetworkSyncChecker()
  mParent = 0;
  mAdvanceMessageCounter = 0;
  mSyncId = 0;
+ mCompleteLogRequested = false;
+ mCompleteLogRequestSent = false;
  mGame = 0;
  mMessageLogger = 0;
  d = new BosonNetworkSyncCheckerPrivate;
@@ -1135,26 +1201,43 @@ void BosonNetworkSyncChecker::receiveAdvanceMessage(BosonCanvas* canvas)
  // a message is sent every 250 ms
  mAdvanceMessageCounter++;
 
- unsigned int shortInterval = 10; // every 2,5s
- unsigned int longInterval = 100; // every 25s
- if (mAdvanceMessageCounter % shortInterval == 5) {
-	QByteArray log = createLongSyncCheckLog(canvas, mAdvanceMessageCounter, shortInterval);
+ if (mCompleteLogRequested) {
+	// a hash check failed. the request has been received by all clients
+	// before this advance message, so all logs are made at the same
+	// point of the game.
+	mCompleteLogRequested = false;
+	mCompleteLogRequestSent = false;
+	QByteArray log = createCompleteSyncCheckLog(canvas);
 	storeLogAndSend(log);
+	return;
  }
- if (mAdvanceMessageCounter % longInterval == 50) {
+
+ unsigned int hashInterval = 2; // every 0,5s
+ if (mAdvanceMessageCounter % hashInterval == 0) {
+	storeHashAndSend(createSyncHash(canvas));
  }
 }
 
+void BosonNetworkSyncChecker::receiveRequestCompleteLog()
+{
+ mCompleteLogRequested = true;
+}
+
 void BosonNetworkSyncChecker::forceCompleteSyncCheck(BosonCanvas* canvas)
 {
  BO_CHECK_NULL_RET(canvas);
+ // a pending request for a complete log is obsolete now
+ mCompleteLogRequested = false;
+ mCompleteLogRequestSent = false;
  QByteArray log = createCompleteSyncCheckLog(canvas);
  storeLogAndSend(log);
 }
 
 void BosonNetworkSyncChecker::storeLogAndSend(const QByteArray& log)
 {
- d->mLogs.enqueue(new QByteArray(log));
+ BoSyncCheckEntry* entry = new BoSyncCheckEntry(SyncCheckLog);
+ entry->mLog = log;
+ d->mLogs.enqueue(entry);
  if (mGame->isAdmin()) {
 	BoAwaitAck* wait = new BoAwaitAck();
 	wait->sendLog(mGame, log, mSyncId);
@@ -1163,6 +1246,19 @@ void BosonNetworkSyncChecker::storeLogAndSend(const QByteArray& log)
  }
 }
 
+void BosonNetworkSyncChecker::storeHashAndSend(Q_UINT64 hash)
+{
+ BoSyncCheckEntry* entry = new BoSyncCheckEntry(SyncCheckHash);
+ entry->mHash = hash;
+ d->mLogs.enqueue(entry);
+ if (mGame->isAdmin()) {
+	BoAwaitAck* wait = new BoAwaitAck();
+	wait->sendHash(mGame, hash, mSyncId);
+	d->mAwaitAcks.insert(mSyncId, wait);
+	mSyncId++;
+ }
+}
+
 bool BosonNetworkSyncChecker::receiveNetworkSyncCheck(QDataStream& stream)
 {
  if (!mGame) {
@@ -1173,30 +1269,54 @@ bool BosonNetworkSyncChecker::receiveNetworkSyncCheck(QDataStream& stream)
 	return false;
  }
  Q_UINT32 syncId;
- QCString md5String;
+ Q_INT8 type;
  stream >> syncId;
- stream >> md5String;
- if (md5String.isEmpty()) {
-	boError(370) << k_funcinfo << "empty md5 string" << endl;
+ stream >> type;
+
+ BoSyncCheckEntry* entry = d->mLogs.dequeue();
+ if (entry->mType != type) {
+	boError(370) << k_funcinfo << "expected sync check of type " << entry->mType << ", received " << type << endl;
+	delete entry;
 	return false;
  }
 
- QByteArray* log = d->mLogs.dequeue();
- KMD5 md5(*log);
- bool verify = md5.verify(md5String);
+ bool verify = false;
+ if (type == SyncCheckHash) {
+	Q_UINT64 hash;
+	stream >> hash;
+	verify = (hash == entry->mHash);
+	if (!verify) {
+		// the ADMIN will request a complete log now, that will
+		// tell us what is out of sync.
+		boError(370) << k_funcinfo << "state hashes don't match!" << endl;
+	}
+ } else {
+	QCString md5String;
+	stream >> md5String;
+	if (md5String.isEmpty()) {
+		boError(370) << k_funcinfo << "empty md5 string" << endl;
+		delete entry;
+		return false;
+	}
+	KMD5 md5(entry->mLog);
+	verify = md5.verify(md5String);
+ }
 
- sendAck(md5String, verify, syncId, *log);
+ sendAck(type, verify, syncId, entry->mLog);
 
- delete log;
- log = 0;
+ delete entry;
+ entry = 0;
 
- if (!verify) {
+ if (!verify && type == SyncCheckLog) {
 	boError(370) << k_funcinfo << "md5 strings of logs don't match!" << endl;
 	boError(370) << k_funcinfo << "network is out of sync (or we have a sync bug)" << endl;
 	addChatSystemMessage(i18n("Network out of sync for this client !!! Big trouble!"));
 	addChatSystemMessage(i18n("A message containing more information has been sent to ADMIN for investigation (debugging)"));
 	return false;
  }
+ if (!verify) {
+	return false;
+ }
 
  boDebug(370) << k_funcinfo << "network sync OK" << endl;
  return true;
@@ -1217,19 +1337,30 @@ bool BosonNetworkSyncChecker::receiveNetworkSyncCheckAck(QDataStream& stream, Q_
 	return false;
  }
  Q_UINT32 id;
- QCString md5;
+ Q_INT8 type;
  Q_INT8 verify;
  QByteArray brokenLog;
  stream >> id;
- stream >> md5;
+ stream >> type;
  stream >> verify;
- if (!verify) {
+ if (!verify && type == SyncCheckLog) {
 	stream >> brokenLog;
  }
 
  BoAwaitAck* await = d->mAwaitAcks[id];
 
- if (!verify) {
+ if (!verify && type == SyncCheckHash) {
+	// the hash tells us only _that_ the client is out of sync. we
+	// let all clients make a complete log at the next advance message,
+	// which is checked like any other log and tells us _what_ is out of
+	// sync. the game is synced once that check fails.
+	boWarning(370) << k_funcinfo << "state hash of client " << sender << " does not match" << endl;
+	if (!mCompleteLogRequestSent) {
+		mCompleteLogRequestSent = true;
+		mGame->sendMessage(0, BosonMessageIds::IdNetworkSyncCheckRequestLog);
+	}
+	verify = true;
+ } else if (!verify) {
 	boWarning(370) << k_funcinfo << "network out of sync for client " << sender << endl;
 	addChatSystemMessage(i18n("Network out of sync for client %1").arg(sender));
 	if (await) {
@@ -1258,14 +1389,14 @@ bool BosonNetworkSyncChecker::receiveNetworkSyncCheckAck(QDataStream& stream, Q_
  return verify;
 }
 
-void BosonNetworkSyncChecker::sendAck(const QCString& md5, bool verify, unsigned int syncId, const QByteArray& origLog)
+void BosonNetworkSyncChecker::sendAck(Q_INT8 type, bool verify, unsigned int syncId, const QByteArray& origLog)
 {
  QByteArray buffer;
  QDataStream stream(buffer, IO_WriteOnly);
  stream << (Q_UINT32)syncId;
- stream << md5;
+ stream << type;
  stream << (Q_INT8)verify;
- if (!verify) {
+ if (!verify && type == SyncCheckLog) {
 	stream << origLog;
  }
  mGame->sendMessage(buffer, BosonMessageIds::IdNetworkSyncCheckACK);
@@ -1283,15 +1414,21 @@ QByteArray BosonNetworkSyncChecker::createCompleteSyncCheckLog(BosonCanvas* canv
  return m.makeLog();
 }
 
-QByteArray BosonNetworkSyncChecker::createLongSyncCheckLog(BosonCanvas* canvas, unsigned int advanceMessageCounter, unsigned int interval) const
+Q_UINT64 BosonNetworkSyncChecker::createSyncHash(BosonCanvas* canvas) const
 {
- BosonProfiler profiler("CreateLongSyncCheckLog");
+ BosonProfiler profiler("CreateSyncHash");
 
- BoLongSyncCheckMessage m;
- m.setGame(mGame);
- m.setMessageLogger(mMessageLogger);
- m.setCanvas(canvas, advanceMessageCounter, interval);
- return m.makeLog();
+ // note: this acutally _changes_ the random object. however since we do
+ // this at the same time on all clients, it is valid (see
+ // BoGameSyncCheckMessage).
+ Q_UINT64 hash = BoSyncHash::add(0, (Q_UINT64)mGame->random()->getLong(100000));
+ hash = BoSyncHash::finish(hash);
+
+ hash += canvas->itemsSyncHash();
+ for (QPtrListIterator<Player> it(mGame->allPlayerList()); it.current(); ++it) {
+	hash += it.current()->syncHash();
+ }
+ return hash;
 }
 
 
@@ -35,10 +35,10 @@ class BosonNetworkSynchronizerPrivate;
 /**
  * This class is supposed to notice when the network goes out of sync. @ref
  * receiveAdvanceMessage is called whenever an advance message is received. It
- * collects several data about the current game, and if we are the ADMIN we send
- * an md5 string over these data out to all clients.
+ * takes a 64 bit hash of the current game, and if we are the ADMIN we send
+ * that hash out to all clients.
  *
- * The clients will receive the MD5 string sent by the client in @ref
+ * The clients will receive the hash sent by the client in @ref
  * receiveNetworkSyncCheck. They compare it to their own data that were saved
  * at the same time (speaking in terms of advance calls/messages of course) and
  * they send an ACK back to the ADMIN, indicating they received the sync
@@ -84,6 +84,11 @@ public:
 	 **/
 	bool receiveNetworkSyncCheckAck(QDataStream& stream, Q_UINT32 sender);
 
+	/**
+	 * See @ref BosonSyncChecker::receiveRequestCompleteLog.
+	 **/
+	void receiveNetworkSyncCheckRequestLog(QDataStream& stream);
+
 	/**
 	 * See @ref BosonNetworkSyncer::receiveNetworkRequestSync
 	 **/
@@ -129,6 +134,12 @@ public:
 
 	bool acceptNetworkTransmission(int msgid) const;
 
+	/**
+	 * @return A complete log of the canvas, as it is used for the sync
+	 * checks. Two canvases are in sync if their logs are equal.
+	 **/
+	static QByteArray makeCanvasLog(BosonCanvas* canvas);
+
 protected:
 	void unlockGame();
 
@@ -148,12 +159,20 @@ class BosonNetworkSyncCheckerPrivate;
  * received. This class will decide whether a SyncCheck message should be
  * generated.
  *
- * In certain intervals this class creates a SyncCheck messages and stores it
- * internally. Then it sends out the MD5 sum of that message to all clients.
- * When they receive it in @ref receiveNetworkSyncCheck, they send back an ACK
- * message indicating whether their own SyncCheck message matched the MD5 sum
- * that they received. If not, the ACK also contains the whole SyncCheck log
- * message for further investigation.
+ * In short intervals this class creates a hash of the game (see @ref
+ * createSyncHash) and stores it internally. Then it sends out that hash to all
+ * clients. When they receive it in @ref receiveNetworkSyncCheck, they send back
+ * an ACK message indicating whether their own hash matched the hash that they
+ * received. The hash is updated incrementally whenever an item or a player
+ * changes (see @ref BosonCanvas::itemsSyncHash), so it is cheap enough to be
+ * checked every few advance messages.
+ *
+ * A hash tells only that a client is out of sync, not what is out of sync. So
+ * if a hash does not match, the ADMIN requests a complete SyncCheck log (see
+ * @ref receiveRequestCompleteLog), which is made on all clients at the next
+ * advance message. Of that log only the MD5 sum is sent to the clients, they
+ * compare it to their own log and if it does not match, the ACK also contains
+ * the whole SyncCheck log message for further investigation.
  *
  * The ACK messages from the clients are received in @ref
  * receiveNetworkSyncCheckAck by the ADMIN. If the ACK indicates that the client
@@ -193,6 +212,13 @@ public:
 	void receiveAdvanceMessage(BosonCanvas* canvas);
 	void forceCompleteSyncCheck(BosonCanvas* canvas);
 
+	/**
+	 * Called on all clients when the ADMIN noticed that the hash of a
+	 * client did not match. All clients create a complete SyncCheck log at
+	 * the next call of @ref receiveAdvanceMessage.
+	 **/
+	void receiveRequestCompleteLog();
+
 	/**
 	 * This is called for the message that was sent out by the ADMIN in @ref
 	 * receiveAdvanceMessage. Here we check whether the contents of the
@@ -212,15 +238,23 @@ public:
 	 * response to our Network Sync message. This ACK tells us whether the
 	 * network is in sync (i.e. everything fine) or not (big trouble).
 	 *
-	 * @return TRUE if the client is in sync, otherwise FALSE.
+	 * @return TRUE if the client is in sync, otherwise FALSE. If only the
+	 * hash of the client did not match, a complete log is requested and
+	 * TRUE is returned, the check of that log will return FALSE.
 	 **/
 	bool receiveNetworkSyncCheckAck(QDataStream& stream, Q_UINT32 sender);
 
 protected:
 	void storeLogAndSend(const QByteArray& log);
-	void sendAck(const QCString& expectedString, bool verify, unsigned int syncId, const QByteArray& origLog);
+	void storeHashAndSend(Q_UINT64 hash);
+	void sendAck(Q_INT8 type, bool verify, unsigned int syncId, const QByteArray& origLog);
 
-	QByteArray createLongSyncCheckLog(BosonCanvas* canvas, unsigned int advanceMessageCounter, unsigned int interval) const;
+	/**
+	 * @return A hash of the game, i.e. of all items (see @ref
+	 * BosonCanvas::itemsSyncHash), all players (see @ref Player::syncHash)
+	 * and the random number generator.
+	 **/
+	Q_UINT64 createSyncHash(BosonCanvas* canvas) const;
 	QByteArray createCompleteSyncCheckLog(BosonCanvas* canvas) const;
 
 	void addChatSystemMessage(const QString& msg)
@@ -236,6 +270,8 @@ private:
 	BosonNetworkSynchronizer* mParent;
 	unsigned int mAdvanceMessageCounter;
 	unsigned int mSyncId;
+	bool mCompleteLogRequested;
+	bool mCompleteLogRequestSent;
 	Boson* mGame;
 	BoMessageLogger* mMessageLogger;
 };
@@ -66,6 +66,9 @@ public:
 		mTotalBosonBytesReceived = 0;
 
 		mKeepMessageDetailsSeconds = 0;
+
+		mPlayerInputBatchesSent = 0;
+		mPlayerInputBatchBytesSent = 0;
 	}
 
 	long long mTotalBytesSent;
@@ -81,6 +84,11 @@ public:
 
 	QPtrList<BosonNetworkTrafficStatistics> mStatistics;
 	QMap<int, BosonNetworkTrafficStatistics*> mMsgid2Statistics;
+
+	unsigned int mPlayerInputBatchesSent;
+	long long mPlayerInputBatchBytesSent;
+	QPtrList<BosonNetworkTrafficPlayerInputStatistics> mPlayerInputStatistics;
+	QMap<int, BosonNetworkTrafficPlayerInputStatistics*> mMsgid2PlayerInputStatistics;
 };
 
 BosonNetworkTraffic::BosonNetworkTraffic(QObject* parent)
@@ -101,6 +109,9 @@ BosonNetworkTraffic::~BosonNetworkTraffic()
  d->mStatistics.setAutoDelete(true);
  d->mStatistics.clear();
  d->mMsgid2Statistics.clear();
+ d->mPlayerInputStatistics.setAutoDelete(true);
+ d->mPlayerInputStatistics.clear();
+ d->mMsgid2PlayerInputStatistics.clear();
  delete d;
 }
 
@@ -142,6 +153,11 @@ void BosonNetworkTraffic::clearStatistics()
  d->mStatistics.setAutoDelete(true);
  d->mStatistics.clear();
  d->mMsgid2Statistics.clear();
+ d->mPlayerInputStatistics.setAutoDelete(true);
+ d->mPlayerInputStatistics.clear();
+ d->mMsgid2PlayerInputStatistics.clear();
+ d->mPlayerInputBatchesSent = 0;
+ d->mPlayerInputBatchBytesSent = 0;
 }
 
 void BosonNetworkTraffic::slotSendBytes(Q_UINT32 bytes, int msgid, int usermsgid, Q_UINT32 sender, Q_UINT32 receiver)
@@ -242,3 +258,33 @@ const QPtrList<BosonNetworkTrafficStatistics>& BosonNetworkTraffic::statistics()
  return d->mStatistics;
 }
 
+void BosonNetworkTraffic::addPlayerInput(int msgid, Q_UINT32 bytes, Q_UINT32 uncompressedBytes)
+{
+ if (!d->mMsgid2PlayerInputStatistics[msgid]) {
+	BosonNetworkTrafficPlayerInputStatistics* stat = new BosonNetworkTrafficPlayerInputStatistics(msgid);
+	d->mPlayerInputStatistics.append(stat);
+	d->mMsgid2PlayerInputStatistics.insert(msgid, stat);
+ }
+ d->mMsgid2PlayerInputStatistics[msgid]->addMessage(bytes, uncompressedBytes);
+}
+
+void BosonNetworkTraffic::addPlayerInputBatch(Q_UINT32 bytes)
+{
+ d->mPlayerInputBatchesSent++;
+ d->mPlayerInputBatchBytesSent += bytes;
+}
+
+unsigned int BosonNetworkTraffic::playerInputBatchesSent() const
+{
+ return d->mPlayerInputBatchesSent;
+}
+
+long long BosonNetworkTraffic::playerInputBatchBytesSent() const
+{
+ return d->mPlayerInputBatchBytesSent;
+}
+
+const QPtrList<BosonNetworkTrafficPlayerInputStatistics>& BosonNetworkTraffic::playerInputStatistics() const
+{
+ return d->mPlayerInputStatistics;
+}
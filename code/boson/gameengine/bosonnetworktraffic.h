@@ -151,6 +151,64 @@ private:
 	unsigned int mMessagesReceived;
 };
 
+/**
+ * @short Information about the player inputs (orders) with a specific message
+ * ID.
+ *
+ * Player inputs are sent in a compact format (see @ref BosonMessageBatch),
+ * this class collects the number of bytes that were actually used, as well as
+ * the number of bytes the uncompressed format (see @ref BosonMessage::save)
+ * would have used.
+ *
+ * See @ref BosonNetworkTraffic::playerInputStatistics
+ **/
+class BosonNetworkTrafficPlayerInputStatistics
+{
+public:
+	BosonNetworkTrafficPlayerInputStatistics(int msgid)
+	{
+		mMsgid = msgid;
+		clear();
+	}
+
+	int msgid() const
+	{
+		return mMsgid;
+	}
+
+	void addMessage(Q_UINT32 bytes, Q_UINT32 uncompressedBytes)
+	{
+		mMessages++;
+		mBytes += bytes;
+		mUncompressedBytes += uncompressedBytes;
+	}
+	void clear()
+	{
+		mMessages = 0;
+		mBytes = 0;
+		mUncompressedBytes = 0;
+	}
+
+	unsigned int messages() const
+	{
+		return mMessages;
+	}
+	long long bytes() const
+	{
+		return mBytes;
+	}
+	long long uncompressedBytes() const
+	{
+		return mUncompressedBytes;
+	}
+
+private:
+	int mMsgid;
+	unsigned int mMessages;
+	long long mBytes;
+	long long mUncompressedBytes;
+};
+
 class BosonNetworkTrafficPrivate;
 /**
  * @short Collects and provides information about network traffic.
@@ -206,6 +264,28 @@ public:
 	const QPtrList<BosonNetworkTrafficDetails>& messageDetails() const;
 	const QPtrList<BosonNetworkTrafficStatistics>& statistics() const;
 
+	/**
+	 * Called when a player input with the ID @p msgid has been added to a
+	 * @ref BosonMessageBatch. @p bytes is the size of the message in the
+	 * batch, @p uncompressedBytes the size it would have without a batch.
+	 **/
+	void addPlayerInput(int msgid, Q_UINT32 bytes, Q_UINT32 uncompressedBytes);
+
+	/**
+	 * Called when a @ref BosonMessageBatch with a total size of @p bytes
+	 * has been sent.
+	 **/
+	void addPlayerInputBatch(Q_UINT32 bytes);
+
+	/**
+	 * @return The number of @ref BosonMessageBatch messages sent, i.e. the
+	 * number of network messages that were used for player inputs.
+	 **/
+	unsigned int playerInputBatchesSent() const;
+	long long playerInputBatchBytesSent() const;
+
+	const QPtrList<BosonNetworkTrafficPlayerInputStatistics>& playerInputStatistics() const;
+
 protected slots:
 	void slotSendBytes(Q_UINT32 bytes, int msgid, int usermsgid, Q_UINT32 sender, Q_UINT32 receiver);
 	void slotReceiveBytes(Q_UINT32 bytes, int msgid, int usermsgid, Q_UINT32 sender, Q_UINT32 receiver);
@@ -98,6 +98,21 @@ const int yoffsets[] = { -1, -1,  0,  1,  1,  1,  0, -1};
 #define HIGH_DIST_MULTIPLIER 0.75
 #define HIGH_MAX_NODES 600
 #define HIGH_ROTATION_COST 1.0
+// Maximum number of high-level routes kept in the cache
+#define HIGH_CACHE_MAX_ENTRIES 200
+
+
+// Groups with at least this many units use a shared flow field
+#define FLOWFIELD_MIN_GROUP_SIZE 20
+// How far from the goal (in cells) the flow field is calculated
+#define FLOWFIELD_MAX_RANGE 96
+// Maximum number of cached flow fields
+#define FLOWFIELD_MAX_FIELDS 8
+// How many waypoints are sampled from the field at once
+#define FLOWFIELD_MAX_PATH_STEPS MAXDIST_LOW
+
+// Default number of searched nodes per advance call for queued path requests
+#define PATH_REQUEST_NODE_BUDGET 4000
 
 
 // Max steps (nodes) to search ahead
@@ -117,6 +132,8 @@ const int yoffsets[] = { -1, -1,  0,  1,  1,  1,  0, -1};
 #define FLYING_BASE_COST 0.75
 #define FLYING_DIST_MULTPLIER 1.5
 #define FLYING_TURNDIST_MULTPLIER 3.0
+// Number of nodes allocated at once by the flying nodes pool
+#define FLYING_POOL_CHUNK_SIZE 256
 
 
 /*****  Cell status flags  *****/
@@ -164,34 +181,85 @@ const int yoffsets[] = { -1, -1,  0,  1,  1,  1,  0, -1};
 
 
 
+/**
+ * Indexed binary heap used as OPEN list by the pathfinder.
+ *
+ * Every node has a position (T::pos) and the heap remembers where in the heap
+ * the node with a given position is stored. This way a node that is already
+ * in OPEN can be found in constant time and its cost can be changed
+ * (decrease-key) instead of adding a duplicate node.
+ *
+ * The heap is meant to be reused for many searches, so the memory is only
+ * allocated once (and grown when necessary), @ref clear doesn't free
+ * anything.
+ **/
 template<class T> class BosonPathHeap
 {
   public:
-    inline BosonPathHeap(unsigned int maxitems = LOW_MAX_NODES + 2)
+    /**
+     * @param positions Number of possible positions (e.g. number of cells)
+     **/
+    BosonPathHeap(unsigned int positions, unsigned int maxitems = LOW_MAX_NODES + 2)
     {
       mCapacity = maxitems;
       mCount = 0;
       mHeap = new T[mCapacity];
+      mPositions = positions;
+      mIndex = new unsigned int[mPositions];
+      for(unsigned int i = 0; i < mPositions; i++)
+      {
+        mIndex[i] = 0;
+      }
     }
     ~BosonPathHeap()
     {
       delete[] mHeap;
+      delete[] mIndex;
     }
 
     inline void add(const T& x)
     {
       if(mCount == mCapacity)
       {
-        resize(mCapacity + 200);
+        resize(mCapacity * 2);
       }
       // Add the entry to the back of the heap
       unsigned int pos = mCount;
       mHeap[pos] = x;
+      mIndex[x.pos] = pos;
       mCount++;
       // Fix the heap
       fix_upward(pos);
     }
 
+    /**
+     * @return The node with the position @p pos. It must be in the heap, see
+     * @ref contains.
+     **/
+    inline const T& node(int pos) const
+    {
+      return mHeap[mIndex[pos]];
+    }
+
+    /**
+     * Replace the node with the same position as @p x (which must be in the
+     * heap already, see @ref contains) by @p x.
+     **/
+    inline void update(const T& x)
+    {
+      unsigned int pos = mIndex[x.pos];
+      bool decreased = (x < mHeap[pos]);
+      mHeap[pos] = x;
+      if(decreased)
+      {
+        fix_upward(pos);
+      }
+      else
+      {
+        fix_downward(pos);
+      }
+    }
+
     inline void takeFirst(T& x)
     {
       x = mHeap[0];
@@ -200,11 +268,23 @@ template<class T> class BosonPathHeap
       if(mCount > 0)
       {
         mHeap[0] = mHeap[mCount];
+        mIndex[mHeap[0].pos] = 0;
         fix_downward(0);
       }
     }
 
+    /**
+     * @return Whether a node with the position @p pos is in the heap
+     **/
+    inline bool contains(int pos) const
+    {
+      unsigned int index = mIndex[pos];
+      return ((index < mCount) && (mHeap[index].pos == pos));
+    }
+
     bool isEmpty() const  { return (mCount == 0); }
+    unsigned int count() const  { return mCount; }
+    void clear()  { mCount = 0; }
 
 
   protected:
@@ -229,51 +309,170 @@ template<class T> class BosonPathHeap
 
     void fix_upward(unsigned int pos)
     {
-      if(pos == 0)
-      {
-        return;
-      }
-      unsigned int parent = parentPos(pos);
-      if(mHeap[pos] < mHeap[parent])
+      T x = mHeap[pos];
+      while(pos > 0)
       {
-        // Swap
-        T temp = mHeap[parent];
-        mHeap[parent] = mHeap[pos];
-        mHeap[pos] = temp;
-        fix_upward(parent);
+        unsigned int parent = parentPos(pos);
+        if(!(x < mHeap[parent]))
+        {
+          break;
+        }
+        // Move the parent down
+        mHeap[pos] = mHeap[parent];
+        mIndex[mHeap[pos].pos] = pos;
+        pos = parent;
       }
+      mHeap[pos] = x;
+      mIndex[x.pos] = pos;
     }
 
     void fix_downward(unsigned int pos)
     {
-      unsigned int child = leftPos(pos);
-      if(child >= mCount)
+      T x = mHeap[pos];
+      while(true)
       {
-        return;
+        unsigned int child = leftPos(pos);
+        if(child >= mCount)
+        {
+          break;
+        }
+
+        // Select the smaller one of the children
+        if((child+1 < mCount) && (mHeap[child+1] < mHeap[child]))
+        {
+          child++;
+        }
+
+        // Test the child
+        if(!(mHeap[child] < x))
+        {
+          break;
+        }
+        // Move the child up
+        mHeap[pos] = mHeap[child];
+        mIndex[mHeap[pos].pos] = pos;
+        pos = child;
       }
+      mHeap[pos] = x;
+      mIndex[x.pos] = pos;
+    }
+
+
+  private:
+    T* mHeap;
+    unsigned int mCapacity;
+    unsigned int mCount;
+    // Heap index of the node for every position
+    unsigned int* mIndex;
+    unsigned int mPositions;
+};
 
-      // Select the smaller one of the children
-      if((child+1 < mCount) && (mHeap[child+1] < mHeap[child]))
+/**
+ * Storage for @ref BosonPathFlyingNode objects.
+ *
+ * Nodes are allocated in chunks that are kept for the whole lifetime of the
+ * pathfinder. @ref reset makes all nodes available again, so a search doesn't
+ * need to allocate (or delete) any nodes once the pool is big enough.
+ **/
+class BosonPathFlyingNodePool
+{
+  public:
+    BosonPathFlyingNodePool()  { mUsed = 0; }
+    ~BosonPathFlyingNodePool()
+    {
+      for(unsigned int i = 0; i < mChunks.count(); i++)
       {
-        child++;
+        delete[] mChunks[i];
       }
+    }
 
-      // Test the child
-      if(mHeap[child] < mHeap[pos])
+    inline BosonPathFlyingNode* alloc()
+    {
+      unsigned int chunk = mUsed / FLYING_POOL_CHUNK_SIZE;
+      if(chunk >= mChunks.count())
       {
-        // Swap
-        T temp = mHeap[child];
-        mHeap[child] = mHeap[pos];
-        mHeap[pos] = temp;
-        fix_downward(child);
+        mChunks.append(new BosonPathFlyingNode[FLYING_POOL_CHUNK_SIZE]);
       }
+      BosonPathFlyingNode* n = &mChunks[chunk][mUsed % FLYING_POOL_CHUNK_SIZE];
+      mUsed++;
+      *n = BosonPathFlyingNode();
+      return n;
+    }
+
+    /**
+     * @return The @p i th node allocated since last @ref reset.
+     **/
+    inline BosonPathFlyingNode* at(unsigned int i) const
+    {
+      return &mChunks[i / FLYING_POOL_CHUNK_SIZE][i % FLYING_POOL_CHUNK_SIZE];
     }
 
+    unsigned int count() const  { return mUsed; }
+    void reset()  { mUsed = 0; }
 
   private:
-    T* mHeap;
-    unsigned int mCapacity;
-    unsigned int mCount;
+    QValueVector<BosonPathFlyingNode*> mChunks;
+    unsigned int mUsed;
+};
+
+
+
+/**
+ * Distance map to a single goal cell for a single movedata.
+ *
+ * For every cell in the area around the goal it stores the cost of getting
+ * from that cell to the goal and the direction of the next cell on the way. A
+ * unit can find its path by simply following the directions, so a single
+ * field can be used by all units of a group that move to the same place.
+ **/
+class BosonPathFlowField
+{
+  public:
+    BosonPathFlowField(int _goalx, int _goaly, int _movedataid, int _x1, int _y1, int _x2, int _y2)
+    {
+      goalx = _goalx;
+      goaly = _goaly;
+      movedataid = _movedataid;
+      x1 = _x1;
+      y1 = _y1;
+      x2 = _x2;
+      y2 = _y2;
+      width = x2 - x1 + 1;
+      int size = width * (y2 - y1 + 1);
+      cost = new bofixed[size];
+      dir = new unsigned char[size];
+      for(int i = 0; i < size; i++)
+      {
+        cost[i] = -1;
+        dir[i] = 0;
+      }
+    }
+    ~BosonPathFlowField()
+    {
+      delete[] cost;
+      delete[] dir;
+    }
+
+    inline bool contains(int x, int y) const
+    {
+      return ((x >= x1) && (x <= x2) && (y >= y1) && (y <= y2));
+    }
+    inline int index(int x, int y) const  { return (y - y1) * width + (x - x1); }
+
+    int goalx;
+    int goaly;
+    int movedataid;
+    // Area of the field (inclusive)
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+    int width;
+
+    // Cost of getting to the goal, -1 if the goal can't be reached
+    bofixed* cost;
+    // Direction of the next cell towards the goal (0 for the goal itself)
+    unsigned char* dir;
 };
 
 
@@ -281,9 +480,10 @@ template<class T> class BosonPathHeap
 class BosonPathLowLevelData
 {
   public:
-    BosonPathLowLevelData()  { openednodes = 0; closednodes = 0; }
+    BosonPathLowLevelData()  { open = 0; openednodes = 0; closednodes = 0; }
 
-    BosonPathHeap<BosonPathNode> open;
+    // OPEN list. This is owned by the pathfinder and reused for all searches
+    BosonPathHeap<BosonPathNode>* open;
     int areax1;
     int areay1;
     int areax2;
@@ -312,9 +512,10 @@ class BosonPathLowLevelData
 class BosonPathHighLevelData
 {
   public:
-    BosonPathHighLevelData()  { openednodes = 0; closednodes = 0; }
+    BosonPathHighLevelData()  { open = 0; openednodes = 0; closednodes = 0; }
 
-    BosonPathHeap<BosonPathNode> open;
+    // OPEN list. This is owned by the pathfinder and reused for all searches
+    BosonPathHeap<BosonPathNode>* open;
     BosonPathNode goalnode;
     BosonPathNode nearest;
     // Start/dest blocks
@@ -329,6 +530,10 @@ class BosonPathHighLevelData
     BosonPathInfo* info;
     int movedataid;
 
+    // Positions of the blocks in the found route (filled by
+    //  highLevelFinishSearch())
+    QValueVector<int> blocks;
+
     int openednodes;
     int closednodes;
 };
@@ -364,11 +569,29 @@ BosonPath::BosonPath(BosonMap* map)
   mBlocksCountY = 0;
   mBlockConnections = 0;
   mBlockConnectionsDirty = 0;
+  mBlockCacheRefs = 0;
+  mLowLevelOpen = 0;
+  mHighLevelOpen = 0;
+  mFlyingOpen = new BosonPathPointerHeap<BosonPathFlyingNode>;
+  mFlyingNodes = new BosonPathFlyingNodePool;
+  mHighLevelCacheHits = 0;
+  mHighLevelCacheMisses = 0;
+  mFlowFields.setAutoDelete(true);
+  mSearchedNodes = 0;
+  mNodeBudget = PATH_REQUEST_NODE_BUDGET;
   boDebug(500) << k_funcinfo << "END" << endl;
 }
 
 BosonPath::~BosonPath()
 {
+  // Pending requests will never be answered now
+  for(BosonPathInfo* info = mPathRequests.first(); info; info = mPathRequests.next())
+  {
+    info->pathrequest = NotRequested;
+    info->requestpathfinder = 0;
+  }
+  mPathRequests.clear();
+
   delete[] mSlopeMap;
   //delete[] mForestMap;
 
@@ -381,6 +604,12 @@ BosonPath::~BosonPath()
   delete[] mBlocks;
   delete[] mBlockConnections;
   delete[] mBlockConnectionsDirty;
+  delete[] mBlockCacheRefs;
+
+  delete mLowLevelOpen;
+  delete mHighLevelOpen;
+  delete mFlyingOpen;
+  delete mFlyingNodes;
 }
 
 void BosonPath::init(BosonCanvas* canvas, BosonPlayerListManager* playerListManager)
@@ -407,6 +636,76 @@ void BosonPath::init(BosonCanvas* canvas, BosonPlayerListManager* playerListMana
 void BosonPath::advance()
 {
   updateChangedBlocks();
+  processPathRequests();
+}
+
+void BosonPath::requestPath(BosonPathInfo* info)
+{
+  if(info->pathrequest == RequestPending)
+  {
+    if(info->requestpathfinder == this)
+    {
+      return;
+    }
+    info->cancelPathRequest();
+  }
+  info->pathrequest = RequestPending;
+  info->requestpathfinder = this;
+  mPathRequests.append(info);
+}
+
+void BosonPath::cancelPathRequest(BosonPathInfo* info)
+{
+  if(info->pathrequest == RequestPending && info->requestpathfinder == this)
+  {
+    mPathRequests.removeRef(info);
+  }
+  info->pathrequest = NotRequested;
+  info->requestpathfinder = 0;
+}
+
+void BosonPath::setNodeBudget(unsigned int budget)
+{
+  mNodeBudget = budget;
+}
+
+void BosonPath::flushPathRequests()
+{
+  PROFILE_METHOD;
+  updateChangedBlocks();
+  while(!mPathRequests.isEmpty())
+  {
+    BosonPathInfo* info = mPathRequests.take(0);
+    findPath(info);
+    info->pathrequest = RequestDone;
+    info->requestpathfinder = 0;
+  }
+  // The caches are not saved, a loaded game starts without them
+  mFlowFields.clear();
+  clearHighLevelCache();
+}
+
+void BosonPath::processPathRequests()
+{
+  if(mPathRequests.isEmpty())
+  {
+    return;
+  }
+  PROFILE_METHOD;
+  // Requests are answered in the order they were made. The first one is always
+  //  answered, so that a single expensive search can't block the queue.
+  unsigned int answered = 0;
+  mSearchedNodes = 0;
+  while(!mPathRequests.isEmpty() && (answered == 0 || mSearchedNodes < mNodeBudget))
+  {
+    BosonPathInfo* info = mPathRequests.take(0);
+    findPath(info);
+    info->pathrequest = RequestDone;
+    info->requestpathfinder = 0;
+    answered++;
+  }
+  boDebug(500) << k_funcinfo << "answered " << answered << " requests (" << mSearchedNodes <<
+      " nodes), " << mPathRequests.count() << " left" << endl;
 }
 
 void BosonPath::findPath(BosonPathInfo* info)
@@ -444,7 +743,11 @@ void BosonPath::findPath(BosonPathInfo* info)
 
     int dist = (int)QMAX(QABS(info->dest.x() - info->start.x()), QABS(info->dest.y() - info->start.y()));
     // Select the pathfinder according to the distance
-    if(dist <= MAXDIST_LOW)
+    if(oldrange < 0 && findFlowFieldPath(info))
+    {
+      // Part of a big group. The path was taken from the group's flow field
+    }
+    else if(dist <= MAXDIST_LOW)
     {
       // Use the lowlevel pf
       getLowLevelPath(info);
@@ -603,6 +906,8 @@ BosonPath::Result BosonPath::getLowLevelPath(BosonPathInfo* info)
 
   data->mapwidth = (int)mMap->width();
   data->info = info;
+  data->open = mLowLevelOpen;
+  data->open->clear();
 
   data->startx = (int)info->start.x();
   data->starty = (int)info->start.y();
@@ -644,7 +949,7 @@ BosonPath::Result BosonPath::getLowLevelPath(BosonPathInfo* info)
   setCellStatusDirty(n.pos);
 
   // Add first node to open list
-  data->open.add(n);
+  data->open->add(n);
   data->openednodes++;
   data->nearest = n;
 
@@ -664,6 +969,7 @@ BosonPath::Result BosonPath::getLowLevelPath(BosonPathInfo* info)
   }
   //boDebug(500) << k_funcinfo << "Nodes opened: " << data->openednodes <<
   //    "; nodes closed: " << data->closednodes << "; path length: " << info->llpath.count() << endl;
+  mSearchedNodes += data->closednodes;
 
   delete data;
 
@@ -679,10 +985,10 @@ BosonPath::Result BosonPath::lowLevelDoSearch(BosonPathLowLevelData* data)
 
   BosonPathNode n;
   // Main loop
-  while(!data->open.isEmpty())
+  while(!data->open->isEmpty())
   {
     // Take first node from open
-    data->open.takeFirst(n);
+    data->open->takeFirst(n);
     //boDebug(500) << "  Got node from open: pos: (" << n.x << "; " << n.y << "); g: " << n.g << "; h: " << n.h << endl;
     data->closednodes++;
 
@@ -816,18 +1122,11 @@ bool BosonPath::lowLevelSearchNeighbor(BosonPathLowLevelData* data, const BosonP
       //boDebug(500) << "      In open with better cost (" << mCellStatus[n2.pos].cost << " vs " << n.g << ")" << endl;
       return true;
     }
-    else
-    {
-      // Delete old direction
-      mCellStatus[n2.pos].flags &= ~STATUS_DIR;
-      // TODO: shouldn't the old node be deleted from open?
-    }
   }
 
   setCellStatusDirty(n2.pos);
 
   LP_PROFILE_METHOD_2(avprof, "Available");
-  mCellStatus[n2.pos].cost = n.g;
 
   // Check for occupied status
   bool movingunit = false;  // Moving unit on one of the cells
@@ -901,8 +1200,24 @@ bool BosonPath::lowLevelSearchNeighbor(BosonPathLowLevelData* data, const BosonP
 
   // Add the node to open
   //boDebug(500) << "      Adding to open; g: " << n2.g << "; h: " << n2.h << endl;
-  data->open.add(n2);
-  data->openednodes++;
+  if(data->open->contains(n2.pos))
+  {
+    // The step costs differ, so a cheaper parent doesn't necessarily give a
+    //  cheaper node
+    if(n2.g >= data->open->node(n2.pos).g)
+    {
+      return true;
+    }
+    // Delete old direction and replace the old node with this (better) one
+    mCellStatus[n2.pos].flags &= ~STATUS_DIR;
+    data->open->update(n2);
+  }
+  else
+  {
+    data->open->add(n2);
+    data->openednodes++;
+  }
+  mCellStatus[n2.pos].cost = n.g;
   mCellStatus[n2.pos].flags |= (STATUS_OPEN | dir);
 
   return true;
@@ -1201,11 +1516,20 @@ void BosonPath::setCellStatusDirty(int pos)
 
 bool BosonPath::getHighLevelPath(BosonPathInfo* info)
 {
+  // Hits and misses are counted by findCachedHighLevelPath()
+  if(findCachedHighLevelPath(info))
+  {
+    return true;
+  }
+  PROFILE_METHOD_2(cacheprof, "Cache miss");
+
   // Create data object
   BosonPathHighLevelData* data = new BosonPathHighLevelData;
 
   data->mapwidth = (int)mMap->width();
   data->info = info;
+  data->open = mHighLevelOpen;
+  data->open->clear();
   data->movedataid = info->movedata->id;
   // TODO: use a meaningful value
   data->maxdepth = 50;
@@ -1227,7 +1551,7 @@ bool BosonPath::getHighLevelPath(BosonPathInfo* info)
   mBlocks[start.pos].flags = STATUS_START | STATUS_OPEN;
   mBlockStatusDirty.append(start.pos);
 
-  data->open.add(start);
+  data->open->add(start);
   data->openednodes++;
   data->nearest = start;
 
@@ -1238,6 +1562,7 @@ bool BosonPath::getHighLevelPath(BosonPathInfo* info)
   if(res != NoPath)
   {
     highLevelFinishSearch(data);
+    addCachedHighLevelPath(data, res);
   }
   else
   {
@@ -1247,6 +1572,7 @@ bool BosonPath::getHighLevelPath(BosonPathInfo* info)
 
   //boDebug(500) << k_funcinfo << "Nodes opened: " << data->openednodes <<
   //    "; nodes closed: " << data->closednodes << "; path length: " << info->hlpath.count() << endl;
+  mSearchedNodes += data->closednodes;
   // Reset statuses in the search area
   resetDirtyBlockStatuses();
 
@@ -1264,10 +1590,10 @@ BosonPath::Result BosonPath::highLevelDoSearch(BosonPathHighLevelData* data)
 
   BosonPathNode n;
   // Main loop
-  while(!data->open.isEmpty())
+  while(!data->open->isEmpty())
   {
     // Take first node from open
-    data->open.takeFirst(n);
+    data->open->takeFirst(n);
     //boDebug(500) << "  Got node from open: pos: (" << n.x << "; " << n.y <<
     //    "); g: " << n.g << "; h: " << n.h << "; total: " << n.g + n.h << endl;
     data->closednodes++;
@@ -1389,17 +1715,12 @@ void BosonPath::highLevelSearchNeighbor(BosonPathHighLevelData* data, const Boso
       //boDebug(500) << "      In open with better cost (" << mBlocks[n2.pos].cost << " vs " << n.g << ")" << endl;
       return;
     }
-    else
-    {
-      // Delete old direction
-      mBlocks[n2.pos].flags &= ~STATUS_DIR;
-      // TODO: shouldn't the old node be deleted from open?
-    }
   }
 
-  mBlockStatusDirty.append(n2.pos);
-
-  mBlocks[n2.pos].cost = n.g;
+  if(!(mBlocks[n2.pos].flags & STATUS_OPEN))
+  {
+    mBlockStatusDirty.append(n2.pos);
+  }
 
   n2.depth = n.depth + 1;
 
@@ -1425,8 +1746,24 @@ void BosonPath::highLevelSearchNeighbor(BosonPathHighLevelData* data, const Boso
 
   // Add the node to open
   //boDebug(500) << "      Adding to open; g: " << n2.g << "; h: " << n2.h << "; total: " << n2.g + n2.h << endl;
-  data->open.add(n2);
-  data->openednodes++;
+  if(data->open->contains(n2.pos))
+  {
+    // The connection costs differ, so a cheaper parent doesn't necessarily
+    //  give a cheaper node
+    if(n2.g >= data->open->node(n2.pos).g)
+    {
+      return;
+    }
+    // Delete old direction and replace the old node with this (better) one
+    mBlocks[n2.pos].flags &= ~STATUS_DIR;
+    data->open->update(n2);
+  }
+  else
+  {
+    data->open->add(n2);
+    data->openednodes++;
+  }
+  mBlocks[n2.pos].cost = n.g;
   mBlocks[n2.pos].flags |= (STATUS_OPEN | dir);
 }
 
@@ -1450,12 +1787,16 @@ void BosonPath::highLevelFinishSearch(BosonPathHighLevelData* data)
   int y = data->goalnode.y;
 
   data->info->pathcost = data->goalnode.g;
+  data->blocks.clear();
 
   // Add all nodes until we reach the start node
   while(true)
   {
     int pos = y * mBlocksCountX + x;  // Necessary because we'll change x and y
     //boDebug(500) << "    Tracing at (" << x << "; " << y << "); flags: " << mBlocks[pos].flags << endl;
+    // Remember all blocks of the route (including the starting one) for the
+    //  high-level path cache
+    data->blocks.append(pos);
     if(mBlocks[pos].flags & STATUS_START)
     {
       //boDebug(500) << "  Starting block found. Break." << endl;
@@ -1519,6 +1860,120 @@ bofixed BosonPath::highLevelDistToGoal(BosonPathHighLevelData* data, const Boson
   return (QMAX(dx, dy) + QMIN(dx, dy) * 0.4) * HIGH_DIST_MULTIPLIER;
 }
 
+bool BosonPath::findCachedHighLevelPath(BosonPathInfo* info)
+{
+  if(!mBlockCacheRefs)
+  {
+    return false;
+  }
+  int startblock = ((int)info->start.y() / mBlockSize) * mBlocksCountX + ((int)info->start.x() / mBlockSize);
+  int destblock = ((int)info->dest.y() / mBlockSize) * mBlocksCountX + ((int)info->dest.x() / mBlockSize);
+  QMap<HighLevelCacheKey, HighLevelCacheEntry>::ConstIterator it;
+  it = mHighLevelCache.find(HighLevelCacheKey(startblock, destblock, info->movedata->id));
+  if(it == mHighLevelCache.end())
+  {
+    mHighLevelCacheMisses++;
+    return false;
+  }
+  mHighLevelCacheHits++;
+
+  // Only complete routes are cached
+  info->result = GoalReached;
+  info->pathcost = (*it).pathcost;
+  if(info->needpath)
+  {
+    info->hlpath = (*it).hlpath;
+  }
+  return true;
+}
+
+void BosonPath::addCachedHighLevelPath(BosonPathHighLevelData* data, Result result)
+{
+  // Partial routes depend on the search limits and on blocks that are not on
+  //  the route itself, so we can't safely reuse them
+  if(result != GoalReached || !data->info->needpath || data->blocks.isEmpty())
+  {
+    return;
+  }
+
+  HighLevelCacheKey key(data->startblocky * mBlocksCountX + data->startblockx,
+      data->destblocky * mBlocksCountX + data->destblockx, data->movedataid);
+  if(mHighLevelCache.contains(key))
+  {
+    return;
+  }
+
+  if(mHighLevelCacheOrder.count() >= HIGH_CACHE_MAX_ENTRIES)
+  {
+    // Throw out the oldest route
+    HighLevelCacheKey oldest = mHighLevelCacheOrder.first();
+    mHighLevelCacheOrder.pop_front();
+    const QValueVector<int>& blocks = mHighLevelCache[oldest].blocks;
+    for(unsigned int i = 0; i < blocks.count(); i++)
+    {
+      mBlockCacheRefs[blocks[i]]--;
+    }
+    mHighLevelCache.remove(oldest);
+  }
+
+  HighLevelCacheEntry entry;
+  entry.pathcost = data->info->pathcost;
+  entry.hlpath = data->info->hlpath;
+  entry.blocks = data->blocks;
+  for(unsigned int i = 0; i < entry.blocks.count(); i++)
+  {
+    mBlockCacheRefs[entry.blocks[i]]++;
+  }
+  mHighLevelCache.insert(key, entry);
+  mHighLevelCacheOrder.append(key);
+}
+
+void BosonPath::invalidateCachedHighLevelPaths(int blockpos)
+{
+  if(!mBlockCacheRefs || mBlockCacheRefs[blockpos] == 0)
+  {
+    // No cached route goes through this block
+    return;
+  }
+
+  // Find all routes going through the block. Note that we must not remove
+  //  them while iterating over the map
+  QValueList<HighLevelCacheKey> invalid;
+  QMap<HighLevelCacheKey, HighLevelCacheEntry>::ConstIterator it;
+  for(it = mHighLevelCache.begin(); it != mHighLevelCache.end(); ++it)
+  {
+    if((*it).blocks.contains(blockpos))
+    {
+      invalid.append(it.key());
+    }
+  }
+
+  QValueList<HighLevelCacheKey>::Iterator keyit;
+  for(keyit = invalid.begin(); keyit != invalid.end(); ++keyit)
+  {
+    const QValueVector<int>& blocks = mHighLevelCache[*keyit].blocks;
+    for(unsigned int i = 0; i < blocks.count(); i++)
+    {
+      mBlockCacheRefs[blocks[i]]--;
+    }
+    mHighLevelCache.remove(*keyit);
+    mHighLevelCacheOrder.remove(*keyit);
+  }
+}
+
+void BosonPath::clearHighLevelCache()
+{
+  mHighLevelCache.clear();
+  mHighLevelCacheOrder.clear();
+  if(mBlockCacheRefs)
+  {
+    for(int i = 0; i < mBlocksCountX * mBlocksCountY; i++)
+    {
+      mBlockCacheRefs[i] = 0;
+    }
+  }
+}
+
 void BosonPath::resetDirtyBlockStatuses()
 {
   //boDebug(500) << k_funcinfo << "Resetting " << mCellStatusDirtyCount << " dirty cells" << endl;
@@ -1533,16 +1988,276 @@ void BosonPath::resetDirtyBlockStatuses()
 
 
 
+bool BosonPath::findFlowFieldPath(BosonPathInfo* info)
+{
+  // Flow fields are used for big groups only. They don't support targets and
+  //  ranges given by the caller (yet). info->range is the range that was set
+  //  by findClosestFreeGoalCell(), like for the normal search.
+  if(info->groupsize < FLOWFIELD_MIN_GROUP_SIZE || info->target)
+  {
+    return false;
+  }
+  PROFILE_METHOD;
+
+  int goalx = (int)info->dest.x();
+  int goaly = (int)info->dest.y();
+  BosonPathFlowField* field = flowField(goalx, goaly, info->movedata);
+  if(!field)
+  {
+    // Goal isn't passable. Let the normal pathfinder find the closest point
+    return false;
+  }
+
+  int x = (int)info->start.x();
+  int y = (int)info->start.y();
+  if(!field->contains(x, y) || field->cost[field->index(x, y)] < 0)
+  {
+    // Too far away or the goal can't be reached from here
+    return false;
+  }
+
+  info->pathcost = field->cost[field->index(x, y)];
+
+  // Follow the field until we are in range of the goal or we have enough
+  //  waypoints. The field leads to the goal cell itself, but that may be
+  //  occupied, so we stop at the same distance as the normal search does.
+  bofixed add = (((info->movedata->size % 2) == 1) ? 0.5 : 0);
+  int steps = 0;
+  while(!inFlowFieldGoalRange(info, x, y, goalx, goaly) && (steps < FLOWFIELD_MAX_PATH_STEPS))
+  {
+    unsigned int dir = field->dir[field->index(x, y)];
+    x += mXOffset[dir];
+    y += mYOffset[dir];
+    if(info->needpath)
+    {
+      info->llpath.append(BoVector2Fixed(x + add, y + add));
+    }
+    steps++;
+  }
+
+  if(inFlowFieldGoalRange(info, x, y, goalx, goaly))
+  {
+    info->result = GoalReached;
+  }
+  else
+  {
+    // The rest of the path will be sampled once these waypoints are done
+    info->result = OutOfRange;
+  }
+  return true;
+}
+
+bool BosonPath::inFlowFieldGoalRange(BosonPathInfo* info, int x, int y, int goalx, int goaly) const
+{
+  if(info->range < 0)
+  {
+    return ((x == goalx) && (y == goaly));
+  }
+  return (QMAX(QABS(x - goalx), QABS(y - goaly)) <= info->range);
+}
+
+BosonPathFlowField* BosonPath::flowField(int goalx, int goaly, BosonMoveData* movedata)
+{
+  for(QPtrListIterator<BosonPathFlowField> it(mFlowFields); it.current(); ++it)
+  {
+    BosonPathFlowField* field = it.current();
+    if((field->goalx == goalx) && (field->goaly == goaly) && (field->movedataid == movedata->id))
+    {
+      return field;
+    }
+  }
+
+  BosonPathFlowField* field = createFlowField(goalx, goaly, movedata);
+  if(!field)
+  {
+    return 0;
+  }
+  if(mFlowFields.count() >= FLOWFIELD_MAX_FIELDS)
+  {
+    // Throw out the oldest field
+    mFlowFields.removeFirst();
+  }
+  mFlowFields.append(field);
+  return field;
+}
+
+BosonPathFlowField* BosonPath::createFlowField(int goalx, int goaly, BosonMoveData* movedata)
+{
+  PROFILE_METHOD;
+  int mapwidth = (int)mMap->width();
+  // Nodes too close to the map's edge can't be used because of unit's size
+  int x1 = QMAX(goalx - FLOWFIELD_MAX_RANGE, movedata->edgedist1);
+  int y1 = QMAX(goaly - FLOWFIELD_MAX_RANGE, movedata->edgedist1);
+  int x2 = QMIN(goalx + FLOWFIELD_MAX_RANGE, mapwidth - 1 - movedata->edgedist2);
+  int y2 = QMIN(goaly + FLOWFIELD_MAX_RANGE, (int)mMap->height() - 1 - movedata->edgedist2);
+  if((goalx < x1) || (goalx > x2) || (goaly < y1) || (goaly > y2))
+  {
+    return 0;
+  }
+
+  BosonPathFlowField* field = new BosonPathFlowField(goalx, goaly, movedata->id, x1, y1, x2, y2);
+  int size = field->width * (y2 - y1 + 1);
+
+  // Find cells that are blocked by terrain or facilities. Mobile units are
+  //  ignored, they will move away (or are avoided while moving).
+  int cx1 = x1 - movedata->edgedist1;
+  int cy1 = y1 - movedata->edgedist1;
+  int cx2 = x2 + movedata->edgedist2;
+  int cy2 = y2 + movedata->edgedist2;
+  int cwidth = cx2 - cx1 + 1;
+  bool* cellfree = new bool[cwidth * (cy2 - cy1 + 1)];
+  for(int y = cy1; y <= cy2; y++)
+  {
+    for(int x = cx1; x <= cx2; x++)
+    {
+      bool isfree = movedata->cellPassable[y * mapwidth + x];
+      if(isfree)
+      {
+        const BoItemList* items = cell(x, y)->items();
+        for(BoItemList::ConstIterator it = items->begin(); it != items->end(); ++it)
+        {
+          if(RTTI::isUnit((*it)->rtti()) && !((Unit*)*it)->isMobile())
+          {
+            isfree = false;
+            break;
+          }
+        }
+      }
+      cellfree[(y - cy1) * cwidth + (x - cx1)] = isfree;
+    }
+  }
+
+  // Nodes are passable if all cells occupied by the unit are free
+  bool* passable = new bool[size];
+  for(int y = y1; y <= y2; y++)
+  {
+    for(int x = x1; x <= x2; x++)
+    {
+      bool p = true;
+      for(int cy = y - movedata->edgedist1; p && cy <= y + movedata->edgedist2; cy++)
+      {
+        for(int cx = x - movedata->edgedist1; cx <= x + movedata->edgedist2; cx++)
+        {
+          if(!cellfree[(cy - cy1) * cwidth + (cx - cx1)])
+          {
+            p = false;
+            break;
+          }
+        }
+      }
+      passable[field->index(x, y)] = p;
+    }
+  }
+  delete[] cellfree;
+
+  if(!passable[field->index(goalx, goaly)])
+  {
+    delete[] passable;
+    delete field;
+    return 0;
+  }
+
+  // Dijkstra search outwards from the goal. Only bofixed costs are used, so
+  //  the result is the same on all clients.
+  bool* closed = new bool[size];
+  for(int i = 0; i < size; i++)
+  {
+    closed[i] = false;
+  }
+  BosonPathHeap<BosonPathNode>* open = mLowLevelOpen;
+  open->clear();
+
+  BosonPathNode n;
+  n.x = goalx;
+  n.y = goaly;
+  n.pos = goaly * mapwidth + goalx;
+  n.g = 0;
+  n.h = 0;
+  field->cost[field->index(goalx, goaly)] = 0;
+  open->add(n);
+
+  while(!open->isEmpty())
+  {
+    open->takeFirst(n);
+    int index = field->index(n.x, n.y);
+    closed[index] = true;
+    mSearchedNodes++;
+
+    for(unsigned int dir = 1; dir <= 8; dir++)
+    {
+      BosonPathNode n2;
+      n2.x = n.x + mXOffset[dir];
+      n2.y = n.y + mYOffset[dir];
+      if(!field->contains(n2.x, n2.y))
+      {
+        continue;
+      }
+      int index2 = field->index(n2.x, n2.y);
+      if(closed[index2] || !passable[index2])
+      {
+        continue;
+      }
+
+      n2.pos = n2.y * mapwidth + n2.x;
+      n2.g = n.g + (ISDIAGONALDIR(dir) ? bofixed(LOW_BASE_COST * SQRT_2) : bofixed(LOW_BASE_COST));
+      n2.h = 0;
+      if((field->cost[index2] >= 0) && (field->cost[index2] <= n2.g))
+      {
+        // Already reached with a better (or same) cost
+        continue;
+      }
+
+      field->cost[index2] = n2.g;
+      // Units at n2 have to go in the opposite direction to get to n
+      field->dir[index2] = ((dir + 3) % 8) + 1;
+      if(open->contains(n2.pos))
+      {
+        open->update(n2);
+      }
+      else
+      {
+        open->add(n2);
+      }
+    }
+  }
+
+  delete[] closed;
+  delete[] passable;
+
+  return field;
+}
+
+void BosonPath::invalidateFlowFields(int x1, int y1, int x2, int y2)
+{
+  BosonPathFlowField* field = mFlowFields.first();
+  while(field)
+  {
+    if((x1 <= field->x2) && (x2 > field->x1) && (y1 <= field->y2) && (y2 > field->y1))
+    {
+      // Also moves to the next field
+      mFlowFields.remove();
+      field = mFlowFields.current();
+    }
+    else
+    {
+      field = mFlowFields.next();
+    }
+  }
+}
+
 void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
 {
   PROFILE_METHOD;
-  // List of open nodes
-  BosonPathPointerHeap<BosonPathFlyingNode> open;
-  QValueList<BosonPathFlyingNode*> closed;
+  // List of open nodes. All nodes are allocated from mFlyingNodes, so nodes
+  //  that aren't in open are closed (we only need to count them).
+  BosonPathPointerHeap<BosonPathFlyingNode>& open = *mFlyingOpen;
+  open.clear();
+  mFlyingNodes->reset();
+  unsigned int closedcount = 0;
 
   // Create the first node
   BosonPathFlyingNode* n;
-  n = new BosonPathFlyingNode;
+  n = mFlyingNodes->alloc();
   n->x = info->start.x();
   n->y = info->start.y();
   n->depth = 0;
@@ -1571,8 +2286,8 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
   {
     // Take first node from open
     open.takeFirst(n);
-    // Add it to closed list
-    closed.append(n);
+    // It's closed now
+    closedcount++;
     //boDebug(500) << "Got node " << n << " from OPEN" << endl;
 
     // We only search FLYING_MAX_STEPS steps ahead
@@ -1582,7 +2297,7 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
       pathfound = true;
       break;
     }
-    else if(closed.count() + open.count() > FLYING_MAX_NODES)
+    else if(closedcount + open.count() > FLYING_MAX_NODES)
     {
       boWarning(500) << k_funcinfo << "Node count bigger than FLYING_MAX_NODES. Interrupting." << endl;
       n = nearest;
@@ -1621,32 +2336,33 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
     // Add neighbor nodes to open
     for(bofixed r = -FLYING_MAX_TURN; r <= FLYING_MAX_TURN; r += FLYING_TURN_STEP)
     {
-      BosonPathFlyingNode* n2 = new BosonPathFlyingNode;
-      n2->rot = n->rot + r;
-      n2->x = n->x + cos(Bo3dTools::deg2rad(n2->rot)) * FLYING_NODE_DIST;
-      n2->y = n->y + sin(Bo3dTools::deg2rad(n2->rot)) * FLYING_NODE_DIST;
-      n2->depth = n->depth + 1;
-      n2->parent = n;
+      bofixed rot = n->rot + r;
+      bofixed x = n->x + cos(Bo3dTools::deg2rad(rot)) * FLYING_NODE_DIST;
+      bofixed y = n->y + sin(Bo3dTools::deg2rad(rot)) * FLYING_NODE_DIST;
 
       // Make sure cell is in search area
-      if((n2->x < 0) || (n2->x >= mMap->width()) || (n2->y < 0) || (n2->y >= mMap->height()))
+      if((x < 0) || (x >= mMap->width()) || (y < 0) || (y >= mMap->height()))
       {
         // Discard this node
-        delete n2;
         continue;
       }
 
+      BosonPathFlyingNode* n2 = mFlyingNodes->alloc();
+      n2->rot = rot;
+      n2->x = x;
+      n2->y = y;
+      n2->depth = n->depth + 1;
+      n2->parent = n;
+
       // TODO: do we want/need this for _air_ units?
       // Make sure cell is passable
       /*if(mSlopeMap[(int)(n2->y * mMap->width() + n2->x)] > 45)
       {
-        delete n2;
         continue;
       }*/
       // And not occupied
       /*else if(cell(n2->x, n2->y)->isAirOccupied())
       {
-        delete n2;
         continue;
       }*/
 
@@ -1675,7 +2391,8 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
   }
 
   boDebug(500) << k_funcinfo << "n->depth: " << n->depth << "; nodes: open: " << open.count() <<
-      "; closed: " << closed.count() << "; total: " << open.count() + closed.count() << endl;
+      "; closed: " << closedcount << "; total: " << open.count() + closedcount << endl;
+  mSearchedNodes += closedcount;
 
   // Traceback path
   if(!pathfound && info->range >= 0)
@@ -1753,11 +2470,9 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
       const int timeout = 80;
       const bofixed zOffset = 0.4f;
       const BoVector4Float opencolor(1.0f, 0.7f, 0.6f, 0.5f);
-      int i = 0;
-      QValueList<BosonPathFlyingNode*>::Iterator it;
-      for(it = open.begin(); it != open.end(); ++it, i++)
+      for(unsigned int i = 0; i < open.count(); i++)
       {
-        BosonPathFlyingNode* node = *it;
+        BosonPathFlyingNode* node = open.at(i);
         if(!node->parent)
         {
           continue;
@@ -1767,11 +2482,12 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
         points.append(BoVector3Fixed(node->parent->x, -node->parent->y, 0.0f));
         BosonPathVisualization::pathVisualization()->addLineVisualization(points, opencolor, pointSize, timeout, zOffset);
       }
+      // All nodes of the pool that have children are closed
       const BoVector4Float closedcolor(0.4f, 0.4f, 0.4f, 0.5f);
-      for(it = closed.begin(); it != closed.end(); ++it, i++)
+      for(unsigned int i = 0; i < mFlyingNodes->count(); i++)
       {
-        BosonPathFlyingNode* node = *it;
-        if(!node->parent)
+        BosonPathFlyingNode* node = mFlyingNodes->at(i)->parent;
+        if(!node || !node->parent)
         {
           continue;
         }
@@ -1785,16 +2501,7 @@ void BosonPath::findFlyingUnitPath(BosonPathInfo* info)
 #endif
   }
 
-  // Delete the nodes in open and closed
-  QValueList<BosonPathFlyingNode*>::Iterator it;
-  for(it = open.begin(); it != open.end(); ++it)
-  {
-    delete *it;
-  }
-  for(it = closed.begin(); it != closed.end(); ++it)
-  {
-    delete *it;
-  }
+  // Note that the nodes are not deleted, they are reused by the next search
 }
 
 bofixed BosonPath::flyingDistToGoal(bofixed x, bofixed y, bofixed rot, BosonPathInfo* info)
@@ -1923,6 +2630,9 @@ void BosonPath::initCellStatusArray()
   mCellStatusDirtyCount = 0;
   mCellStatusDirtySize = 2 * LOW_MAX_NODES;
   mCellStatusDirty = new int[mCellStatusDirtySize];
+
+  delete mLowLevelOpen;
+  mLowLevelOpen = new BosonPathHeap<BosonPathNode>(cells);
 }
 
 void BosonPath::initCellPassabilityMaps()
@@ -1987,6 +2697,14 @@ void BosonPath::initBlocks()
   // Create the array of blocks
   mBlocks = new BlockInfo[blockcount];
 
+  delete mHighLevelOpen;
+  mHighLevelOpen = new BosonPathHeap<BosonPathNode>(blockcount, HIGH_MAX_NODES + 2);
+
+  // Nothing is cached yet
+  delete[] mBlockCacheRefs;
+  mBlockCacheRefs = new int[blockcount];
+  clearHighLevelCache();
+
   // Find out the block centers for all movedatas
   for(int i = 0; i < blockcount; i++)
   {
@@ -2371,10 +3089,16 @@ bofixed* BosonPath::calculateForestmap()
 
 void BosonPath::cellsOccupiedStatusChanged(int x1, int y1, int x2, int y2)
 {
-  for(int x = x1; x < x2; x++)
+  x1 = QMAX(x1, 0);
+  y1 = QMAX(y1, 0);
+  x2 = QMIN(x2, (int)mMap->width());
+  y2 = QMIN(y2, (int)mMap->height());
+  // It's enough to mark a single cell of every affected block
+  for(int y = y1; y < y2; y = (y / mBlockSize + 1) * mBlockSize)
   {
-    for(int y = y1; y < y2; y++)
+    for(int x = x1; x < x2; x = (x / mBlockSize + 1) * mBlockSize)
     {
+      markBlockChanged(cell(x, y));
     }
   }
 }
@@ -2406,6 +3130,23 @@ void BosonPath::unitMovingStatusChanges(Unit* u, int oldstatus, int newstatus)
       else
       {
         cellChanged(c);
+        x1 = QMIN(x1, c->x());
+        y1 = QMIN(y1, c->y());
+        x2 = QMAX(x2, c->x() + 1);
+        y2 = QMAX(y2, c->y() + 1);
+      }
+    }
+    if(x1 < x2)
+    {
+      cellsOccupiedStatusChanged(x1, y1, x2, y2);
+
+      // Flow fields ignore mobile units (they are avoided while moving), so
+      //  only facilities that are built or destroyed make them outdated.
+      //  Otherwise the units that follow a field would throw it away
+      //  whenever one of them starts or stops.
+      if(!u->isMobile())
+      {
+        invalidateFlowFields(x1, y1, x2, y2);
       }
     }
   }
@@ -2423,6 +3164,9 @@ void BosonPath::markBlockChanged(Cell* c)
   int blocky = c->y() / mBlockSize;
   int blockpos = blocky * mBlocksCountX + blockx;
 
+  // Cached routes through this block can't be trusted anymore
+  invalidateCachedHighLevelPaths(blockpos);
+
   // Set this block to be dirty
   if(mBlocks[blockpos].flags & STATUS_CHANGED)
   {
@@ -2498,6 +3242,8 @@ void BosonPath::updateChangedBlocks()
       resetDirtyCellStatuses();
     }
     mBlocks[pos].flags &= ~STATUS_CHANGED;
+    // Routes might have been cached after the block was marked as changed
+    invalidateCachedHighLevelPaths(pos);
   }
 
   // Update connections
@@ -2514,6 +3260,7 @@ void BosonPath::updateChangedBlocks()
       calculateBlockConnection(blockpos, mMoveDatas[i], dir+1);
     }
     mBlockConnectionsDirty[blockpos*4 + dir] = false;
+    invalidateCachedHighLevelPaths(blockpos);
   }
   long int elapsed = methodProfiler.popElapsed();
   boDebug(500) << k_funcinfo << "Updated " << blocksToUpdate << " blocks and " <<
@@ -2599,6 +3346,10 @@ QString BosonPath::debugText(bofixed x, bofixed y)
   }
 
 
+  info += QString("B cached routes: %1\n").arg(mBlockCacheRefs[blockpos]);
+  info += QString("HL cache: %1 routes; %2 hits; %3 misses\n").arg(mHighLevelCache.count()).
+      arg(mHighLevelCacheHits).arg(mHighLevelCacheMisses);
+
   info += QString("B connections for movedatas:\n");
   for(unsigned int i = 0; i < mMoveDatas.count(); i++)
   {
@@ -2768,24 +3519,34 @@ bool BosonPathInfo::saveAsXML(QDomElement& root)
   //  to change loadFromXML() as well
 
   // Save start/dest points and range
-  //saveVector2AsXML(start, root, "start");
-  //saveVector2AsXML(dest, root, "dest");
+  saveVector2AsXML(start, root, "start");
+  saveVector2AsXML(dest, root, "dest");
   //root.setAttribute("target", target ? (int)target->id() : (int)-1);
-  //root.setAttribute("range", range);
+  root.setAttribute("range", range);
+  root.setAttribute("needpath", needpath ? 1 : 0);
+  root.setAttribute("pathcost", pathcost);
   // Save last pf query result
   root.setAttribute("result", result);
-  // Save llpath
-  //root.setAttribute("llpathlength", llpath.count());
-  //for(unsigned int i = 0; i < llpath.count(); i++
-  //{
-  //  saveVector2AsXML(llpath[i], root, QString("llpath-%1").arg(i));
-  //}
-  // hlpath doesn't have to be saved atm
+  // Save llpath and hlpath. They contain the result of an answered request
+  //  that was not yet taken by the unit and the rest of a partial path.
+  root.setAttribute("llpathlength", llpath.count());
+  for(unsigned int i = 0; i < llpath.count(); i++)
+  {
+    saveVector2AsXML(llpath[i], root, QString("llpath-%1").arg(i));
+  }
+  root.setAttribute("hlpathlength", hlpath.count());
+  for(unsigned int i = 0; i < hlpath.count(); i++)
+  {
+    saveVector2AsXML(hlpath[i], root, QString("hlpath-%1").arg(i));
+  }
+  // Pending requests are made again after loading
+  root.setAttribute("pathrequest", (pathrequest == BosonPath::RequestDone) ? 1 : 0);
   // Save misc stuff
   root.setAttribute("moveAttacking", moveAttacking ? 1 : 0);
   root.setAttribute("slowDownAtDest", slowDownAtDest ? 1 : 0);
   root.setAttribute("waiting", waiting);
   root.setAttribute("pathrecalced", pathrecalced);
+  root.setAttribute("groupsize", groupsize);
 
   return true;
 }
@@ -2823,6 +3584,80 @@ bool BosonPathInfo::loadFromXML(const QDomElement& root)
     boError(500) << k_funcinfo << "Invalid value for pathrecalced attribute" << endl;
     return false;
   }
+  // Older savegames don't have the path
+  if(root.hasAttribute("llpathlength"))
+  {
+    if(!loadVector2FromXML(&start, root, "start"))
+    {
+      return false;
+    }
+    if(!loadVector2FromXML(&dest, root, "dest"))
+    {
+      return false;
+    }
+    range = root.attribute("range").toInt(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for range attribute" << endl;
+      return false;
+    }
+    needpath = root.attribute("needpath").toInt(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for needpath attribute" << endl;
+      return false;
+    }
+    pathcost = root.attribute("pathcost").toFloat(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for pathcost attribute" << endl;
+      return false;
+    }
+    unsigned int count = root.attribute("llpathlength").toUInt(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for llpathlength attribute" << endl;
+      return false;
+    }
+    llpath.resize(count);
+    for(unsigned int i = 0; i < count; i++)
+    {
+      if(!loadVector2FromXML(&llpath[i], root, QString("llpath-%1").arg(i)))
+      {
+        return false;
+      }
+    }
+    count = root.attribute("hlpathlength").toUInt(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for hlpathlength attribute" << endl;
+      return false;
+    }
+    hlpath.resize(count);
+    for(unsigned int i = 0; i < count; i++)
+    {
+      if(!loadVector2FromXML(&hlpath[i], root, QString("hlpath-%1").arg(i)))
+      {
+        return false;
+      }
+    }
+    cancelPathRequest();
+    if(root.attribute("pathrequest").toInt(&ok) == 1 && ok)
+    {
+      pathrequest = BosonPath::RequestDone;
+    }
+  }
+  // Older savegames don't have this
+  groupsize = 1;
+  if(root.hasAttribute("groupsize"))
+  {
+    groupsize = root.attribute("groupsize").toInt(&ok);
+    if(!ok)
+    {
+      boError(500) << k_funcinfo << "Invalid value for groupsize attribute" << endl;
+      return false;
+    }
+  }
 
   return true;
 }
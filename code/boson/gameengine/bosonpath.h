@@ -26,6 +26,7 @@
 #include <qvaluevector.h>
 #include <qptrlist.h>
 #include <qvaluelist.h>
+#include <qmap.h>
 
 #include "../bomath.h"
 #include "../bo3dtools.h"
@@ -37,6 +38,11 @@ class BosonPathNode;
 class BosonPathHighLevelPath;
 class BosonPathLowLevelData;
 class BosonPathHighLevelData;
+class BosonPathFlyingNode;
+class BosonPathFlyingNodePool;
+class BosonPathFlowField;
+template<class T> class BosonPathHeap;
+template<class T> class BosonPathPointerHeap;
 
 class BosonMap;
 class Cell;
@@ -81,6 +87,14 @@ class BosonPath
 
     enum Result { None = 0, GoalReached, NoPath, OutOfRange };
 
+    /**
+     * Status of a queued path request, see @ref requestPath
+     * @li NotRequested  no request was made (or the result was already used)
+     * @li RequestPending  the request waits in the queue
+     * @li RequestDone  the path was searched, the result is in the info object
+     **/
+    enum RequestStatus { NotRequested = 0, RequestPending, RequestDone };
+
 
     /**
      * Construct pathfinder, using given map
@@ -97,6 +111,45 @@ class BosonPath
     void findPath(BosonPathInfo* info);
     void preparePathInfo(BosonPathInfo* info);
 
+    /**
+     * Queues a path search for @p info. The search is done by one of the next
+     *  @ref advance calls, then @ref BosonPathInfo::pathrequest is set to @ref
+     *  RequestDone and the result is in @p info, just like after @ref findPath.
+     *
+     * Requests are answered in the order they were made. Every advance call
+     *  answers requests until @ref nodeBudget nodes have been searched.
+     **/
+    void requestPath(BosonPathInfo* info);
+    /**
+     * Removes @p info from the request queue. This must be called before a
+     *  pathinfo with a pending request is deleted (@ref BosonPathInfo does
+     *  this itself).
+     **/
+    void cancelPathRequest(BosonPathInfo* info);
+    /**
+     * @return Number of requests that wait in the queue
+     **/
+    unsigned int pendingPathRequests() const  { return mPathRequests.count(); }
+
+    /**
+     * Sets how many nodes may be searched per @ref advance call for queued
+     *  requests. Note that this must be the same on all clients.
+     **/
+    void setNodeBudget(unsigned int budget);
+    unsigned int nodeBudget() const  { return mNodeBudget; }
+
+    /**
+     * Answers all pending requests (ignoring @ref nodeBudget) and clears the
+     *  flow-field and high-level path caches. Afterwards the complete state of
+     *  the pathfinder is in the @ref BosonPathInfo objects, which are saved
+     *  with the units. A game loaded from a savegame that is made now
+     *  continues exactly like this one.
+     *
+     * This is used for the replay keyframes and must be called at the same
+     *  point of the game on all clients.
+     **/
+    void flushPathRequests();
+
     void cellsOccupiedStatusChanged(int x1, int y1, int x2, int y2);
 
     bool saveAsXML(QDomElement& root) const;
@@ -127,6 +180,22 @@ class BosonPath
 
     QValueList<BoVector2Fixed> findLocations(Player* player, int x, int y, int n, int radius, ResourceType type);
 
+    /**
+     * @return How many high-level searches were answered from the high-level
+     *  path cache.
+     **/
+    unsigned int highLevelCacheHits() const  { return mHighLevelCacheHits; }
+    /**
+     * @return How many high-level searches had to be done because no
+     *  usable route was in the cache.
+     **/
+    unsigned int highLevelCacheMisses() const  { return mHighLevelCacheMisses; }
+    /**
+     * @return How many flow fields (see @ref BosonPathInfo::groupsize) are
+     *  currently cached.
+     **/
+    unsigned int flowFieldCount() const  { return mFlowFields.count(); }
+
 
 
   protected:
@@ -148,6 +217,11 @@ class BosonPath
 
     void cellChanged(Cell* c);
 
+    /**
+     * Answers queued path requests, see @ref requestPath
+     **/
+    void processPathRequests();
+
 
     /*****  Flying-unit pathfinder  *****/
     // Flying-unit pathfinder methods
@@ -175,6 +249,14 @@ class BosonPath
     int findClosestFreeGoalCell(BosonPathInfo* info);
 
 
+    /*****  Flow-field pathfinder (for big groups)  *****/
+    bool findFlowFieldPath(BosonPathInfo* info);
+    bool inFlowFieldGoalRange(BosonPathInfo* info, int x, int y, int goalx, int goaly) const;
+    BosonPathFlowField* flowField(int goalx, int goaly, BosonMoveData* movedata);
+    BosonPathFlowField* createFlowField(int goalx, int goaly, BosonMoveData* movedata);
+    void invalidateFlowFields(int x1, int y1, int x2, int y2);
+
+
     /*****  High-level pathfinder  *****/
     bool getHighLevelPath(BosonPathInfo* info);
     Result highLevelDoSearch(BosonPathHighLevelData* data);
@@ -189,6 +271,11 @@ class BosonPath
     void createBlockColormap(BosonMoveData* movedata);
     void markBlockChanged(Cell* c);
     void updateChangedBlocks();
+    // High-level path cache
+    bool findCachedHighLevelPath(BosonPathInfo* info);
+    void addCachedHighLevelPath(BosonPathHighLevelData* data, Result result);
+    void invalidateCachedHighLevelPaths(int blockpos);
+    void clearHighLevelCache();
 
 
     /**
@@ -229,6 +316,49 @@ class BosonPath
         // Status flags for pathfinder
         unsigned int flags;
     };
+    class HighLevelCacheKey
+    {
+      public:
+        HighLevelCacheKey()  { startblock = 0; destblock = 0; movedataid = 0; }
+        HighLevelCacheKey(int _startblock, int _destblock, int _movedataid)
+        {
+          startblock = _startblock; destblock = _destblock; movedataid = _movedataid;
+        }
+
+        inline bool operator<(const HighLevelCacheKey& k) const
+        {
+          if(movedataid != k.movedataid)
+          {
+            return (movedataid < k.movedataid);
+          }
+          if(startblock != k.startblock)
+          {
+            return (startblock < k.startblock);
+          }
+          return (destblock < k.destblock);
+        }
+        inline bool operator==(const HighLevelCacheKey& k) const
+        {
+          return ((movedataid == k.movedataid) && (startblock == k.startblock) && (destblock == k.destblock));
+        }
+
+        int startblock;
+        int destblock;
+        int movedataid;
+    };
+    // A high-level route found earlier, which can be reused as long as none of
+    //  the blocks it goes through changes
+    class HighLevelCacheEntry
+    {
+      public:
+        HighLevelCacheEntry()  { pathcost = 0; }
+
+        bofixed pathcost;
+        // The route, as stored in BosonPathInfo::hlpath
+        QValueVector<BoVector2Fixed> hlpath;
+        // Positions of all blocks that the route goes through
+        QValueVector<int> blocks;
+    };
 
     BosonMap* mMap;
 
@@ -261,6 +391,31 @@ class BosonPath
     QValueList<int> mDirtyConnections;
     QValueList<int> mBlockStatusDirty;
 
+    /*****  Flow fields  *****/
+    // Fields of recent group move orders, oldest first
+    QPtrList<BosonPathFlowField> mFlowFields;
+
+    /*****  Queued path requests  *****/
+    QPtrList<BosonPathInfo> mPathRequests;
+    unsigned int mNodeBudget;
+    // Nodes searched since the queue was last processed
+    unsigned int mSearchedNodes;
+
+    /*****  Reusable search storage  *****/
+    BosonPathHeap<BosonPathNode>* mLowLevelOpen;
+    BosonPathHeap<BosonPathNode>* mHighLevelOpen;
+    BosonPathPointerHeap<BosonPathFlyingNode>* mFlyingOpen;
+    BosonPathFlyingNodePool* mFlyingNodes;
+
+    /*****  High-level path cache  *****/
+    QMap<HighLevelCacheKey, HighLevelCacheEntry> mHighLevelCache;
+    // Keys of cached routes, oldest first. Used to throw out old routes
+    QValueList<HighLevelCacheKey> mHighLevelCacheOrder;
+    // Number of cached routes going through each block
+    int* mBlockCacheRefs;
+    unsigned int mHighLevelCacheHits;
+    unsigned int mHighLevelCacheMisses;
+
     friend class BoPathSyncCheckMessage;
 };
 
@@ -271,7 +426,7 @@ class BosonPathNode
   public:
     BosonPathNode() { x = 0; y = 0; pos = 0; g = 0; h = 0; depth = 0; }
 
-    inline bool operator<(const BosonPathNode& n2)
+    inline bool operator<(const BosonPathNode& n2) const
     {
       return ((g + h) < (n2.g + n2.h));
     }
@@ -319,30 +474,113 @@ class BosonPathFlyingNode
 };
 
 
-template<class T> class BosonPathPointerHeap : public QValueList<T*>
+/**
+ * Binary heap of node pointers, ordered by (g + h) of the nodes.
+ *
+ * The heap doesn't own the nodes. Memory is kept when the heap is cleared, so
+ * that it can be reused for many searches.
+ **/
+template<class T> class BosonPathPointerHeap
 {
   public:
-    inline void add(T*& x)
+    BosonPathPointerHeap()
+    {
+      mCapacity = 256;
+      mCount = 0;
+      mHeap = new T*[mCapacity];
+    }
+    ~BosonPathPointerHeap()
+    {
+      delete[] mHeap;
+    }
+
+    inline void add(T* x)
     {
-      QValueListIterator<T*> it;
-      for(it = this->begin(); it != this->end(); ++it)
+      if(mCount == mCapacity)
+      {
+        resize(mCapacity * 2);
+      }
+      unsigned int pos = mCount;
+      mCount++;
+      // Move parents down until we find the place for x
+      while(pos > 0)
       {
-        if((x->g + x->h) <= ((*it)->g + (*it)->h))
+        unsigned int parent = (pos - 1) / 2;
+        if(!less(x, mHeap[parent]))
         {
-          insert(it, x);
           break;
         }
+        mHeap[pos] = mHeap[parent];
+        pos = parent;
       }
-      if(it == this->end()) {
-        append(x);
-      }
+      mHeap[pos] = x;
     }
 
     inline void takeFirst(T*& x)
     {
-      x = this->first();
-      this->pop_front();
+      x = mHeap[0];
+      mCount--;
+      if(mCount == 0)
+      {
+        return;
+      }
+
+      // Move the last item to the top and let it sink down
+      T* last = mHeap[mCount];
+      unsigned int pos = 0;
+      while(true)
+      {
+        unsigned int child = pos * 2 + 1;
+        if(child >= mCount)
+        {
+          break;
+        }
+        if((child + 1 < mCount) && less(mHeap[child + 1], mHeap[child]))
+        {
+          child++;
+        }
+        if(!less(mHeap[child], last))
+        {
+          break;
+        }
+        mHeap[pos] = mHeap[child];
+        pos = child;
+      }
+      mHeap[pos] = last;
     }
+
+    /**
+     * @return The @p i th item in the heap. Note that the items are @em not
+     * sorted, except that the first one has the lowest cost.
+     **/
+    inline T* at(unsigned int i) const  { return mHeap[i]; }
+
+    bool isEmpty() const  { return (mCount == 0); }
+    unsigned int count() const  { return mCount; }
+    void clear()  { mCount = 0; }
+
+  protected:
+    inline bool less(const T* x1, const T* x2) const
+    {
+      return ((x1->g + x1->h) < (x2->g + x2->h));
+    }
+
+    void resize(unsigned int newsize)
+    {
+      T** newheap = new T*[newsize];
+      for(unsigned int i = 0; i < mCount; i++)
+      {
+        newheap[i] = mHeap[i];
+      }
+      delete[] mHeap;
+      mHeap = newheap;
+      mCapacity = newsize;
+    }
+
+  private:
+    T** mHeap;
+    unsigned int mCapacity;
+    unsigned int mCount;
 };
 
 /**
@@ -355,9 +593,16 @@ template<class T> class BosonPathPointerHeap : public QValueList<T*>
 class BosonPathInfo
 {
   public:
-    BosonPathInfo()  { reset(); }
+    BosonPathInfo()
+    {
+      pathrequest = BosonPath::NotRequested;
+      requestpathfinder = 0;
+      reset();
+    }
+    ~BosonPathInfo()  { cancelPathRequest(); }
     void reset()
     {
+      cancelPathRequest();
       unit = 0;
       player = 0;
       movedata = 0;
@@ -375,6 +620,16 @@ class BosonPathInfo
       slowDownAtDest = true;
       waiting = 0;
       pathrecalced = 0;
+      groupsize = 1;
+    }
+
+    void cancelPathRequest()
+    {
+      if(requestpathfinder)
+      {
+        requestpathfinder->cancelPathRequest(this);
+      }
+      pathrequest = BosonPath::NotRequested;
     }
 
     bool saveAsXML(QDomElement& root);
@@ -427,6 +682,15 @@ class BosonPathInfo
     int waiting;
     // How many times path has been recalculated for unit (while waiting)
     int pathrecalced;
+    // Number of units that got the same move order. Big groups use a shared
+    //  flow field instead of one search per unit
+    int groupsize;
+    // Status of the queued path request, see BosonPath::requestPath(). Pending
+    //  requests are not saved, they are simply made again after loading (see
+    //  BosonPath::flushPathRequests()).
+    BosonPath::RequestStatus pathrequest;
+    // Pathfinder that has the pending request in its queue
+    BosonPath* requestpathfinder;
 };
 
 
@@ -47,6 +47,7 @@ BosonPlayerInputHandler::BosonPlayerInputHandler(Boson* game)
 	: QObject(0, "bosonplayerinputhandler")
 {
  mGame = game;
+ mCompactInput = false;
 }
 
 BosonPlayerInputHandler::~BosonPlayerInputHandler()
@@ -103,6 +104,10 @@ bool BosonPlayerInputHandler::playerInput(QDataStream& stream, Player* player)
  }
  Q_UINT32 msgid;
  stream >> msgid;
+ if (msgid == BosonMessageIds::MoveBatch) {
+	batchPlayerInput(stream, player);
+	return true;
+ }
  if (mGame->gameMode()) {
 	if (gamePlayerInput(msgid, stream, player)) {
 		return true;
@@ -120,13 +125,51 @@ bool BosonPlayerInputHandler::playerInput(QDataStream& stream, Player* player)
  return true;
 }
 
+void BosonPlayerInputHandler::batchPlayerInput(QDataStream& stream, Player* player)
+{
+ Q_UINT32 count;
+ if (!BosonMessageBatch::loadHeader(stream, &count)) {
+	boError() << k_funcinfo << "invalid batch header" << endl;
+	return;
+ }
+ mCompactInput = true;
+ for (Q_UINT32 i = 0; i < count; i++) {
+	if (stream.atEnd()) {
+		boError() << k_funcinfo << "batch ended after " << i << " of " << count << " messages" << endl;
+		break;
+	}
+	Q_UINT32 msgid = BosonMessage::loadVarUInt(stream);
+	bool processed;
+	if (mGame->gameMode()) {
+		processed = gamePlayerInput(msgid, stream, player);
+	} else {
+		processed = editorPlayerInput(msgid, stream, player);
+	}
+	if (!processed) {
+		// we don't know the size of the message, so we can't read the
+		// remaining messages either
+		boWarning() << k_funcinfo << "unexpected playerInput " << msgid << " in batch" << endl;
+		break;
+	}
+ }
+ mCompactInput = false;
+}
+
+bool BosonPlayerInputHandler::loadMessage(BosonMessage& message, QDataStream& stream)
+{
+ if (mCompactInput) {
+	return message.loadCompact(stream);
+ }
+ return message.load(stream);
+}
+
 bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& stream, Player* player)
 {
  switch (msgid) {
 	case BosonMessageIds::MoveMove:
 	{
 		BosonMessageMoveMove message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError(380) << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -157,13 +200,16 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 		if (unitsToMove.count() == 0) {
 			break;
 		}
-		giveOrder(unitsToMove, UnitMoveOrder(message.mPos, -1, attack));
+		UnitMoveOrder order(message.mPos, -1, attack);
+		// big groups share a single flow field in the pathfinder
+		order.setGroupSize(unitsToMove.count());
+		giveOrder(unitsToMove, order);
 		break;
 	}
 	case BosonMessageIds::MoveAttack:
 	{
 		BosonMessageMoveAttack message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -206,7 +252,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveStop:
 	{
 		BosonMessageMoveStop message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -245,7 +291,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveMine:
 	{
 		BosonMessageMoveMine message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -289,7 +335,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveRefine:
 	{
 		BosonMessageMoveRefine message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -343,7 +389,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 		break;
 
 		BosonMessageMoveRepair message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -402,7 +448,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveProduce:
 	{
 		BosonMessageMoveProduce message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -452,7 +498,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveProduceStop:
 	{
 		BosonMessageMoveProduceStop message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -501,7 +547,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveBuild:
 	{
 		BosonMessageMoveBuild message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -551,7 +597,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveFollow:
 	{
 		BosonMessageMoveFollow message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -586,7 +632,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveEnterUnit:
 	{
 		BosonMessageMoveEnterUnit message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -634,7 +680,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveLayMine:
 	{
 		BosonMessageMoveLayMine message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -668,7 +714,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveDropBomb:
 	{
 		BosonMessageMoveDropBomb message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -703,7 +749,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveTeleport:
 	{
 		BosonMessageMoveTeleport message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -726,7 +772,7 @@ bool BosonPlayerInputHandler::gamePlayerInput(Q_UINT32 msgid, QDataStream& strea
 	case BosonMessageIds::MoveRotate:
 	{
 		BosonMessageMoveRotate message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -760,7 +806,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MovePlaceUnit:
 	{
 		BosonMessageEditorMovePlaceUnit message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -780,7 +826,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MoveChangeTexMap:
 	{
 		BosonMessageEditorMoveChangeTexMap message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -804,7 +850,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	{
 		boDebug() << k_lineinfo << "change height" << endl;
 		BosonMessageEditorMoveChangeHeight message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -830,7 +876,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MoveDeleteItems:
 	{
 		BosonMessageEditorMoveDeleteItems message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -847,7 +893,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MoveUndoPlaceUnit:
 	{
 		BosonMessageEditorMoveUndoPlaceUnit message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -861,7 +907,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MoveUndoDeleteItems:
 	{
 		BosonMessageEditorMoveUndoDeleteItems message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -904,7 +950,7 @@ bool BosonPlayerInputHandler::editorPlayerInput(Q_UINT32 msgid, QDataStream& str
 	case BosonMessageIds::MoveUndoChangeHeight:
 	{
 		BosonMessageEditorMoveUndoChangeHeight message;
-		if (!message.load(stream)) {
+		if (!loadMessage(message, stream)) {
 			boError() << k_lineinfo << "message (" << message.messageId() << ") could not be read" << endl;
 			break;
 		}
@@ -28,6 +28,7 @@ class Boson;
 class Unit;
 class UnitOrder;
 class BosonCanvas;
+class BosonMessage;
 class BosonMessageEditorMove;
 class BosonMessageEditorMoveDeleteItems;
 class bofixed;
@@ -79,6 +80,19 @@ protected:
 
 	BosonCanvas* canvas() const;
 
+	/**
+	 * Process all messages of a @ref BosonMessageBatch. The message ID has
+	 * been read already.
+	 **/
+	void batchPlayerInput(QDataStream& stream, Player* player);
+
+	/**
+	 * Load @p message from @p stream, using @ref BosonMessage::loadCompact
+	 * if the message is part of a batch, otherwise @ref
+	 * BosonMessage::load.
+	 **/
+	bool loadMessage(BosonMessage& message, QDataStream& stream);
+
 	/**
 	 * WARNING: return value differs from @ref playerInput!
 	 * @return TRUE if the message was processed in here, otherwise FALSE
@@ -109,6 +123,7 @@ signals:
 
 private:
 	Boson* mGame;
+	bool mCompactInput; // TRUE while the messages of a batch are processed
 };
 
 #endif
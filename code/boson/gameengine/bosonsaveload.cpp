@@ -129,7 +129,7 @@ bool BosonSaveLoad::loadXMLDoc(QDomDocument* doc, const QString& xml)
  return true;
 }
 
-bool BosonSaveLoad::saveToFiles(QMap<QString, QByteArray>& files)
+bool BosonSaveLoad::saveToFiles(QMap<QString, QByteArray>& files, bool binaryCanvas)
 {
  boDebug() << k_funcinfo << endl;
  if (!files.isEmpty()) {
@@ -161,11 +161,19 @@ bool BosonSaveLoad::saveToFiles(QMap<QString, QByteArray>& files)
  }
  files.insert("players.xml", playersXML);
 
- QByteArray canvasXML = saveCanvasAsXML();
- if (canvasXML.isNull()) {
-	return false;
+ if (binaryCanvas) {
+	QByteArray canvasBinary = saveCanvasBinary();
+	if (canvasBinary.isNull()) {
+		return false;
+	}
+	files.insert("canvas.bin", canvasBinary);
+ } else {
+	QByteArray canvasXML = saveCanvasAsXML();
+	if (canvasXML.isNull()) {
+		return false;
+	}
+	files.insert("canvas.xml", canvasXML);
  }
- files.insert("canvas.xml", canvasXML);
 
  QByteArray externalXML = saveExternalAsXML();
  if (externalXML.isNull()) {
@@ -206,6 +214,7 @@ bool BosonSaveLoad::saveToFile(const QMap<QString, QByteArray>& files, const QSt
  QByteArray kgameXML = files["kgame.xml"];
  QByteArray playersXML = files["players.xml"];
  QByteArray canvasXML = files["canvas.xml"];
+ QByteArray canvasBinary = files["canvas.bin"];
  QByteArray externalXML = files["external.xml"];
  QByteArray mapXML = files["map/map.xml"];
  QByteArray waterXML = files["map/water.xml"];
@@ -217,7 +226,7 @@ bool BosonSaveLoad::saveToFile(const QMap<QString, QByteArray>& files, const QSt
 	boError() << k_funcinfo << "no kgameXML found" << endl;
 	return false;
  }
- if (canvasXML.size() == 0) {
+ if (canvasXML.size() == 0 && canvasBinary.size() == 0) {
 	boError() << k_funcinfo << "no canvasXML found" << endl;
 	return false;
  }
@@ -225,10 +234,6 @@ bool BosonSaveLoad::saveToFile(const QMap<QString, QByteArray>& files, const QSt
 	boError() << k_funcinfo << "no playersXML found" << endl;
 	return false;
  }
- if (canvasXML.size() == 0) {
-	boError() << k_funcinfo << "no canvasXML found" << endl;
-	return false;
- }
  if (externalXML.size() == 0) {
 	// do nothing - is optional only.
  }
@@ -263,11 +268,19 @@ bool BosonSaveLoad::saveToFile(const QMap<QString, QByteArray>& files, const QSt
 	return false;
  }
  writtenFiles.append("players.xml");
- if (!f.writeFile(QString::fromLatin1("canvas.xml"), QString(canvasXML))) {
-	boError() << k_funcinfo << "Could not write canvas.xml to " << file << endl;
-	return false;
+ if (canvasBinary.size() != 0) {
+	if (!f.writeFile(QString::fromLatin1("canvas.bin"), canvasBinary)) {
+		boError() << k_funcinfo << "Could not write canvas.bin to " << file << endl;
+		return false;
+	}
+	writtenFiles.append("canvas.bin");
+ } else {
+	if (!f.writeFile(QString::fromLatin1("canvas.xml"), QString(canvasXML))) {
+		boError() << k_funcinfo << "Could not write canvas.xml to " << file << endl;
+		return false;
+	}
+	writtenFiles.append("canvas.xml");
  }
- writtenFiles.append("canvas.xml");
  if (!f.writeFile(QString::fromLatin1("external.xml"), QString(externalXML))) {
 	boError() << k_funcinfo << "Could not write external.xml to " << file << endl;
 	return false;
@@ -427,6 +440,16 @@ QCString BosonSaveLoad::saveCanvasAsXML()
  return QCString();
 }
 
+QByteArray BosonSaveLoad::saveCanvasBinary()
+{
+ PROFILE_METHOD
+ if (!d->mCanvas) {
+	BO_NULL_ERROR(d->mCanvas);
+	return QByteArray();
+ }
+ return d->mCanvas->saveCanvasBinary();
+}
+
 QCString BosonSaveLoad::saveExternalAsXML()
 {
  PROFILE_METHOD
@@ -544,6 +567,9 @@ bool BosonSaveLoad::loadCanvasFromXML(const QMap<QString, QByteArray>& files)
 {
  PROFILE_METHOD
  boDebug(270) << k_funcinfo << endl;
+ if (files.contains("canvas.bin")) {
+	return d->mCanvas->loadFromBinary(files["canvas.bin"]);
+ }
  QString xml = QString(files["canvas.xml"]);
  if (xml.length() == 0) {
 	boError(270) << k_funcinfo << "Empty canvas.xml" << endl;
@@ -54,8 +54,11 @@ public:
 
 	/**
 	 * Save the game to @p files.
+	 * @param binaryCanvas If TRUE the canvas is saved in the binary format
+	 * (canvas.bin, see @ref BoBinarySaveGame) instead of canvas.xml. This
+	 * is a lot faster for large maps.
 	 **/
-	bool saveToFiles(QMap<QString, QByteArray>& files);
+	bool saveToFiles(QMap<QString, QByteArray>& files, bool binaryCanvas = false);
 
 	/**
 	 * Just like @ref saveToFiles, but this takes care of converting the
@@ -109,6 +112,7 @@ protected:
 	QCString saveKGameAsXML();
 	QCString savePlayersAsXML();
 	QCString saveCanvasAsXML();
+	QByteArray saveCanvasBinary();
 	QCString saveExternalAsXML();
 	bool saveEventListenerScripts(QMap<QString, QByteArray>* files);
 	bool saveEventListenersXML(QMap<QString, QByteArray>* files);
@@ -903,8 +903,9 @@ bool BosonShotMine::loadFromXML(const QDomElement& root)
 void BosonShotMine::advanceMoveInternal()
 {
   boDebug(350) << "MINE: " << k_funcinfo << endl;
-  BoItemList* contacts = collisions()->collisions(boundingRect(), this, true);
-  if(!contacts->isEmpty())
+  BoItemList contacts(0, false);
+  collisions()->collisionsAtCells(boundingRect(), this, true, &contacts);
+  if(!contacts.isEmpty())
   {
     // Somebody is touching the mine. If mine is activated, explode
     if(mActivated)
@@ -1025,8 +1026,9 @@ void BosonShotBomb::advanceMoveInternal()
     return;
   }
   // Then check if it collides with items
-  BoItemList* contacts = collisions()->collisions(boundingRect(), this, true);
-  if(!contacts->isEmpty())
+  BoItemList contacts(0, false);
+  collisions()->collisionsAtCells(boundingRect(), this, true, &contacts);
+  if(!contacts.isEmpty())
   {
     // We use same trigger mechanism as for mine to prevent it from being
     //  triggered by a collision with the unit that dropped it
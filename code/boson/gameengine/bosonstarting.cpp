@@ -31,12 +31,22 @@
 #include "bodebug.h"
 #include "bosonsaveload.h"
 #include "bpfloader.h"
+#include "boadvanceworkerpool.h"
+#include "../bosonconfig.h"
+#include "../botraceprofiling.h"
 
 #include <klocale.h>
 #include <kgame/kmessageclient.h>
 
 #include <qtimer.h>
 #include <qmap.h>
+#include <qptrlist.h>
+#include <qvaluevector.h>
+
+#include <unistd.h>
+
+// the preparation is mostly limited by the disk, more threads don't help
+#define MAX_STARTING_WORKER_COUNT 8
 
 #define DO_GUI_INIT_ON_DATA_INIT 1
 
@@ -71,11 +81,61 @@ private:
 	bool mIsLocked;
 };
 
+/**
+ * Calls @ref BosonStartingTask::preparePart for all parts of a group of tasks,
+ * see @ref BosonStarting::beginPrepareTasks. The result and the time of a part
+ * are stored at the index of the part.
+ **/
+class BosonStartingPrepareJob : public BoAdvanceJob
+{
+public:
+	BosonStartingPrepareJob()
+		: BoAdvanceJob()
+	{
+	}
+
+	void addPart(BosonStartingTask* task, unsigned int part)
+	{
+		unsigned int count = mTasks.count();
+		mTasks.resize(count + 1);
+		mParts.resize(count + 1);
+		mResults.resize(count + 1);
+		mTimes.resize(count + 1);
+		mTasks[count] = task;
+		mParts[count] = part;
+		mResults[count] = false;
+		mTimes[count] = 0;
+	}
+	unsigned int count() const
+	{
+		return mTasks.count();
+	}
+	bool containsTask(const BosonStartingTask* task) const
+	{
+		return (mPreparedTasks.findRef(task) >= 0);
+	}
+
+	virtual void compute(unsigned int index)
+	{
+		Q_UINT64 start = BoTraceProfiling::now();
+		mResults[index] = mTasks[index]->preparePart(mParts[index]);
+		mTimes[index] = BoTraceProfiling::now() - start;
+	}
+
+public:
+	QPtrList<BosonStartingTask> mPreparedTasks; // including tasks without parts
+	QValueVector<BosonStartingTask*> mTasks;
+	QValueVector<unsigned int> mParts;
+	QValueVector<bool> mResults;
+	QValueVector<Q_UINT64> mTimes; // ns
+};
+
 class BosonStartingPrivate
 {
 public:
 	BosonStartingPrivate()
 	{
+		mWorkerPool = 0;
 	}
 	QPtrList<BosonStartingTaskCreator> mTaskCreators;
 
@@ -83,6 +143,8 @@ public:
 	QMap<unsigned int, QByteArray> mStartingCompletedMessage;
 
 	QString mLoadFromLogFile;
+
+	BoAdvanceWorkerPool* mWorkerPool; // exists while tasks are executed only
 };
 
 
@@ -147,10 +209,98 @@ void BosonStarting::slotStartNewGameWithTimer()
  QTimer::singleShot(0, this, SLOT(slotStart()));
 }
 
+bool BosonStarting::resolveDependencies(const QPtrList<BosonStartingTask>& tasks, QValueVector<int>* lastDependency)
+{
+ QMap<QString, int> providers;
+ lastDependency->resize(tasks.count());
+ int index = 0;
+ for (QPtrListIterator<BosonStartingTask> it(tasks); it.current(); ++it, index++) {
+	BosonStartingTask* task = it.current();
+	int last = -1;
+	if (task->requiredResources().isEmpty() && task->dependsOnPreviousTasks()) {
+		// a task that does not tell what it depends on, depends on
+		// all previous tasks.
+		last = index - 1;
+	}
+	for (QStringList::const_iterator r = task->requiredResources().begin(); r != task->requiredResources().end(); ++r) {
+		if (!providers.contains(*r)) {
+			boError(270) << k_funcinfo << "task " << task->text() << " requires " << *r << ", which is not provided by a previous task" << endl;
+			return false;
+		}
+		last = QMAX(last, providers[*r]);
+	}
+	(*lastDependency)[index] = last;
+
+	for (QStringList::const_iterator p = task->providedResources().begin(); p != task->providedResources().end(); ++p) {
+		if (providers.contains(*p)) {
+			boWarning(270) << k_funcinfo << "resource " << *p << " is provided by more than one task" << endl;
+		}
+		providers.insert(*p, index);
+	}
+ }
+ return true;
+}
+
+BosonStartingPrepareJob* BosonStarting::beginPrepareTasks(const QPtrList<BosonStartingTask>& tasks)
+{
+ BO_CHECK_NULL_RET0(d->mWorkerPool);
+ BosonStartingPrepareJob* job = new BosonStartingPrepareJob();
+ for (QPtrListIterator<BosonStartingTask> it(tasks); it.current(); ++it) {
+	unsigned int parts = it.current()->beginPrepare();
+	it.current()->setPrepareTime(0);
+	job->mPreparedTasks.append(it.current());
+	for (unsigned int i = 0; i < parts; i++) {
+		job->addPart(it.current(), i);
+	}
+ }
+ if (job->count() == 0) {
+	return job;
+ }
+ boDebug(270) << k_funcinfo << "preparing " << tasks.count() << " tasks in " << job->count() << " parts using " << d->mWorkerPool->workerCount() << " threads" << endl;
+
+ d->mWorkerPool->start(job, job->count());
+ return job;
+}
+
+bool BosonStarting::completePrepareTasks(BosonStartingPrepareJob* job)
+{
+ if (!job) {
+	return true;
+ }
+ BO_CHECK_NULL_RET0(d->mWorkerPool);
+ if (job->count() > 0) {
+	boProfiling->push("PrepareStartingTasks");
+	d->mWorkerPool->wait();
+	boProfiling->pop();
+ }
+
+ bool ret = true;
+ QMap<BosonStartingTask*, Q_UINT64> times;
+ for (unsigned int i = 0; i < job->count(); i++) {
+	times[job->mTasks[i]] += job->mTimes[i];
+	if (!job->mResults[i]) {
+		boError(270) << k_funcinfo << "could not prepare part " << job->mParts[i] << " of task " << job->mTasks[i]->text() << endl;
+		ret = false;
+	}
+ }
+ for (QMap<BosonStartingTask*, Q_UINT64>::iterator it = times.begin(); it != times.end(); ++it) {
+	it.key()->setPrepareTime((unsigned int)(it.data() / 1000000));
+ }
+ delete job;
+ return ret;
+}
+
 bool BosonStarting::executeTasks(const QPtrList<BosonStartingTask>& tasks)
 {
+ QValueVector<int> lastDependency;
+ if (!resolveDependencies(tasks, &lastDependency)) {
+	return false;
+ }
+
  unsigned long int duration = 0;
- for (QPtrListIterator<BosonStartingTask> it(tasks); it.current(); ++it) {
+ QValueVector<BosonStartingTask*> taskVector(tasks.count());
+ unsigned int index = 0;
+ for (QPtrListIterator<BosonStartingTask> it(tasks); it.current(); ++it, index++) {
 	disconnect(it.current(), SIGNAL(signalStartSubTask(const QString&)), this, 0);
 	connect(it.current(), SIGNAL(signalStartSubTask(const QString&)),
 			this, SIGNAL(signalLoadingStartSubTask(const QString&)));
@@ -159,30 +309,101 @@ bool BosonStarting::executeTasks(const QPtrList<BosonStartingTask>& tasks)
 			this, SIGNAL(signalLoadingTaskCompleted(unsigned int)));
 
 	duration += it.current()->taskDuration();
+	taskVector[index] = it.current();
  }
  emit signalLoadingMaxDuration(duration);
 
+ unsigned int workers = boConfig->uintValue("StartingWorkerThreads");
+ if (workers == 0) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	workers = (cpus > 0) ? (unsigned int)cpus : 1;
+ }
+ workers = QMIN(workers, MAX_STARTING_WORKER_COUNT);
+ BoAdvanceWorkerPool pool;
+ pool.setWorkerCount(workers);
+ pool.setChunkSize(1);
+ d->mWorkerPool = &pool;
+
+ // the tasks that have been given to the workers (or are prepared already)
+ QValueVector<bool> prepared(tasks.count(), false);
+ BosonStartingPrepareJob* runningJob = 0;
+ bool ret = true;
  duration = 0;
  emit signalLoadingTaskCompleted(duration);
- for (QPtrListIterator<BosonStartingTask> it(tasks); it.current(); ++it) {
-	boDebug(270) << k_funcinfo << "starting task: " << it.current()->text() << endl;
-	emit signalLoadingStartTask(it.current()->text());
+ for (unsigned int i = 0; i < taskVector.count(); i++) {
+	BosonStartingTask* task = taskVector[i];
+	if (!prepared[i]) {
+		// the task depends on the previous task, it can be prepared
+		// only now. the workers can work on one job at a time only.
+		bool completed = completePrepareTasks(runningJob);
+		runningJob = 0;
+		if (completed) {
+			QPtrList<BosonStartingTask> prepare;
+			prepare.append(task);
+			prepared[i] = true;
+			completed = completePrepareTasks(beginPrepareTasks(prepare));
+		}
+		if (!completed) {
+			boError(270) << k_funcinfo << "could not prepare tasks" << endl;
+			ret = false;
+			break;
+		}
+	} else if (runningJob && runningJob->containsTask(task)) {
+		bool completed = completePrepareTasks(runningJob);
+		runningJob = 0;
+		if (!completed) {
+			boError(270) << k_funcinfo << "could not prepare tasks" << endl;
+			ret = false;
+			break;
+		}
+	}
+
+	if (!runningJob) {
+		// all tasks before i have been completed, so the workers can
+		// prepare all tasks that depend on these tasks only, while the
+		// main thread starts task i.
+		QPtrList<BosonStartingTask> prepare;
+		for (unsigned int j = i + 1; j < taskVector.count(); j++) {
+			if (!prepared[j] && lastDependency[j] < (int)i) {
+				prepare.append(taskVector[j]);
+				prepared[j] = true;
+			}
+		}
+		if (!prepare.isEmpty()) {
+			runningJob = beginPrepareTasks(prepare);
+		}
+		if (runningJob && runningJob->count() == 0) {
+			// nothing for the workers to do
+			completePrepareTasks(runningJob);
+			runningJob = 0;
+		}
+	}
+
+	boDebug(270) << k_funcinfo << "starting task: " << task->text() << endl;
+	emit signalLoadingStartTask(task->text());
 	emit signalLoadingStartSubTask("");
 
-	boProfiling->push(QString("StartingTask: %1").arg(it.current()->text()));
-	bool completed = it.current()->start(duration);
+	boProfiling->push(QString("StartingTask: %1").arg(task->text()));
+	bool completed = task->start(duration);
 	boProfiling->pop();
 	if (!completed) {
-		boError(270) << k_funcinfo << "could not complete task " << it.current()->text() << endl;
-
-		return false;
+		boError(270) << k_funcinfo << "could not complete task " << task->text() << endl;
+		ret = false;
+		break;
 	}
-	boDebug(270) << k_funcinfo << "completed task: " << it.current()->text() << endl;
+	boDebug(270) << k_funcinfo << "completed task: " << task->text() << " (prepared in " << task->prepareTime() << " ms, started in " << task->startTime() << " ms)" << endl;
 
-	duration += it.current()->taskDuration();
+	duration += task->taskDuration();
 	emit signalLoadingTaskCompleted(duration);
+	emit signalLoadingTaskCompleted(task->text(), task->prepareTime(), task->startTime());
  }
- return true;
+
+ // the workers must not use the tasks anymore once we return
+ if (!completePrepareTasks(runningJob)) {
+	ret = false;
+ }
+ d->mWorkerPool = 0;
+ return ret;
 }
 
 void BosonStarting::slotStart()
@@ -422,6 +643,9 @@ BosonStartingTask::BosonStartingTask(const QString& text)
 {
  mText = text;
  mTimePassed = 0;
+ mDependsOnPreviousTasks = true;
+ mPrepareTime = 0;
+ mStartTime = 0;
 }
 
 BosonStartingTask::~BosonStartingTask()
@@ -431,7 +655,24 @@ BosonStartingTask::~BosonStartingTask()
 bool BosonStartingTask::start(unsigned int timePassed)
 {
  mTimePassed = timePassed;
- return startTask();
+ Q_UINT64 start = BoTraceProfiling::now();
+ bool ret = startTask();
+ mStartTime = (unsigned int)((BoTraceProfiling::now() - start) / 1000000);
+ return ret;
+}
+
+void BosonStartingTask::addProvidedResource(const QString& resource)
+{
+ if (!mProvidedResources.contains(resource)) {
+	mProvidedResources.append(resource);
+ }
+}
+
+void BosonStartingTask::addRequiredResource(const QString& resource)
+{
+ if (!mRequiredResources.contains(resource)) {
+	mRequiredResources.append(resource);
+ }
 }
 
 void BosonStartingTask::startSubTask(const QString& text)
@@ -21,6 +21,7 @@
 #define BOSONSTARTING_H
 
 #include <qobject.h>
+#include <qstringlist.h>
 
 class BosonPlayField;
 class Player;
@@ -29,7 +30,9 @@ class BosonCanvas;
 class QDomElement;
 template<class T> class QPtrList;
 template<class T1, class T2> class QMap;
+template<class T> class QValueVector;
 class BosonStartingTask;
+class BosonStartingPrepareJob;
 
 class BosonStartingTaskCreator;
 class BosonStartingPrivate;
@@ -80,6 +83,18 @@ public:
 	 **/
 	void checkEvents();
 
+	/**
+	 * Find the tasks that provide the resources that the tasks in @p tasks
+	 * require (see @ref BosonStartingTask::addRequiredResource).
+	 * @param lastDependency Receives the index of the last task that a
+	 * task depends on, for every task in @p tasks (-1 if it does not
+	 * depend on any task). A task can be prepared once all tasks up to
+	 * this index have been completed.
+	 * @return FALSE if a required resource is not provided by an earlier
+	 * task.
+	 **/
+	static bool resolveDependencies(const QPtrList<BosonStartingTask>& tasks, QValueVector<int>* lastDependency);
+
 public slots:
 	/**
 	 * Start the game starting (see @ref slotStart) using a timer.
@@ -129,6 +144,19 @@ signals:
 	 **/
 	void signalLoadingTaskCompleted(unsigned int duration);
 
+	/**
+	 * @overload
+	 *
+	 * Emitted after @ref signalLoadingTaskCompleted with the time that the
+	 * task @p text actually took.
+	 * @param prepareTime The time (in ms) that the worker threads spent in
+	 * @ref BosonStartingTask::preparePart of this task, see @ref
+	 * BosonStartingTask::prepareTime.
+	 * @param startTime The time (in ms) that @ref
+	 * BosonStartingTask::startTask took in the main thread.
+	 **/
+	void signalLoadingTaskCompleted(const QString& text, unsigned int prepareTime, unsigned int startTime);
+
 	/**
 	 * Emitted when a starting task begins. @p text describes this task
 	 * (i18n'ed)
@@ -159,8 +187,31 @@ protected:
 	void sendStartingCompleted(bool success);
 	bool checkStartingCompletedMessages() const;
 
+	/**
+	 * Start all tasks in @p tasks in the main thread, in order. While a
+	 * task is being started, the worker threads prepare the tasks whose
+	 * dependencies have been completed already (see @ref
+	 * resolveDependencies and @ref BosonStartingTask::preparePart).
+	 **/
 	bool executeTasks(const QPtrList<BosonStartingTask>& tasks);
 
+	/**
+	 * Call @ref BosonStartingTask::beginPrepare for all tasks in @p tasks
+	 * in the main thread and start @ref BosonStartingTask::preparePart for
+	 * all parts of these tasks on the worker threads. This returns
+	 * immediately, see @ref completePrepareTasks.
+	 * @return The running job. It must be completed using @ref
+	 * completePrepareTasks.
+	 **/
+	BosonStartingPrepareJob* beginPrepareTasks(const QPtrList<BosonStartingTask>& tasks);
+
+	/**
+	 * Wait until all parts of @p job have been prepared and delete @p
+	 * job. Does nothing if @p job is NULL.
+	 * @return FALSE if a part could not be prepared.
+	 **/
+	bool completePrepareTasks(BosonStartingPrepareJob* job);
+
 signals:
 	void signalDestPlayField(BosonPlayField*);
 	void signalCanvas(BosonCanvas* canvas);
@@ -198,6 +249,26 @@ public:
 	virtual QString creatorName() const = 0;
 };
 
+/**
+ * A task of the game starting procedure, see @ref BosonStarting.
+ *
+ * Tasks are started in the order in which they were created, in the main
+ * thread. A task may additionally do CPU-side work that does not depend on
+ * other tasks (such as decoding images) in worker threads before it is
+ * started, see @ref beginPrepare and @ref preparePart.
+ *
+ * Such a task must declare the tasks that it depends on. This is done by
+ * the names of resources: a task provides a resource (e.g. "PlayField", see
+ * @ref addProvidedResource) and other tasks require it (see @ref
+ * addRequiredResource). This way a task does not need to know the task (or
+ * the @ref BosonStartingTaskCreator) that provides the data it requires.
+ *
+ * The preparation of a task is started once all tasks it depends on have
+ * been completed, i.e. possibly before tasks that were created before it,
+ * and runs while the main thread starts these tasks. A task that does not
+ * declare any required resources depends on all tasks that were created
+ * before it, unless @ref setDependsOnPreviousTasks is used.
+ **/
 class BosonStartingTask : public QObject
 {
 	Q_OBJECT
@@ -220,6 +291,100 @@ public:
 	 **/
 	bool start(unsigned int duration);
 
+	/**
+	 * Declare that this task provides @p resource once it has been
+	 * completed.
+	 **/
+	void addProvidedResource(const QString& resource);
+
+	/**
+	 * Declare that this task requires @p resource, i.e. that it depends on
+	 * the task that provides @p resource.
+	 **/
+	void addRequiredResource(const QString& resource);
+
+	/**
+	 * A task that does not require any resources (see @ref
+	 * addRequiredResource) depends on all tasks that were created before
+	 * it by default. Call this with FALSE if the preparation of this task
+	 * does not depend on any other task, so that it can be prepared right
+	 * from the start.
+	 **/
+	void setDependsOnPreviousTasks(bool depends)
+	{
+		mDependsOnPreviousTasks = depends;
+	}
+	bool dependsOnPreviousTasks() const
+	{
+		return mDependsOnPreviousTasks;
+	}
+
+	const QStringList& providedResources() const
+	{
+		return mProvidedResources;
+	}
+	const QStringList& requiredResources() const
+	{
+		return mRequiredResources;
+	}
+
+	/**
+	 * Called by @ref BosonStarting in the main thread before the task is
+	 * prepared. The tasks that this task depends on have been completed at
+	 * this point, other tasks may not have been started yet.
+	 *
+	 * Note that @ref preparePart is called while the main thread starts
+	 * other tasks, so the data that is used by @ref preparePart must not
+	 * be touched by other tasks.
+	 *
+	 * Collect the work that can be done in worker threads here (e.g. the
+	 * names of files that need to be decoded).
+	 * @return The number of parts of the preparation, i.e. the number of
+	 * calls to @ref preparePart. The default implementation returns 0, i.e.
+	 * the task is not prepared at all.
+	 **/
+	virtual unsigned int beginPrepare()
+	{
+		return 0;
+	}
+
+	/**
+	 * Do the work for @p part of the preparation (see @ref beginPrepare).
+	 *
+	 * WARNING: this is called from a worker thread, possibly at the same
+	 * time as other parts of this and other tasks. Only thread safe code
+	 * can be used here. In particular you must not use OpenGL, the game
+	 * objects, @ref boDebug and @ref boError, @ref i18n and KConfig.
+	 * @return FALSE if an error occured. The game starting is aborted
+	 * then.
+	 **/
+	virtual bool preparePart(unsigned int part)
+	{
+		Q_UNUSED(part);
+		return true;
+	}
+
+	/**
+	 * @return The time (in ms) that the worker threads spent in @ref
+	 * preparePart, summed up over all parts.
+	 **/
+	unsigned int prepareTime() const
+	{
+		return mPrepareTime;
+	}
+	void setPrepareTime(unsigned int ms)
+	{
+		mPrepareTime = ms;
+	}
+
+	/**
+	 * @return The time (in ms) that @ref start took
+	 **/
+	unsigned int startTime() const
+	{
+		return mStartTime;
+	}
+
 	/**
 	 * @return The estimated amount of time this task will take. You can
 	 * return any non-negative number that you like, there is no special
@@ -251,6 +416,11 @@ protected:
 private:
 	QString mText;
 	unsigned int mTimePassed;
+	QStringList mProvidedResources;
+	QStringList mRequiredResources;
+	bool mDependsOnPreviousTasks;
+	unsigned int mPrepareTime;
+	unsigned int mStartTime;
 };
 
 
@@ -72,6 +72,11 @@ QString BosonWeaponProperties::name() const
   return "Weapon";
 }
 
+int BosonWeaponProperties::weaponPropertyKey(const QString& name, const QString& type) const
+{
+  return BoUpgradeablePropertyKey::key(QString("Weapon_%1:%2").arg(id() - 1).arg(name), type);
+}
+
 bool BosonWeaponProperties::insertULongWeaponBaseValue(unsigned long int v, const QString& name, const QString& type)
 {
   return insertULongBaseValue(v, QString("Weapon_%1:%2").arg(id() - 1).arg(name), type);
@@ -89,17 +94,32 @@ bool BosonWeaponProperties::insertBoFixedWeaponBaseValue(bofixed v, const QStrin
 
 unsigned long int BosonWeaponProperties::ulongWeaponBaseValue(const QString& name, const QString& type, unsigned long int defaultValue) const
 {
-  return ulongBaseValue(QString("Weapon_%1:%2").arg(id() - 1).arg(name), type, defaultValue);
+  unsigned long int v = defaultValue;
+  if(!getBaseValue(&v, weaponPropertyKey(name, type)))
+  {
+    return defaultValue;
+  }
+  return v;
 }
 
 long int BosonWeaponProperties::longWeaponBaseValue(const QString& name, const QString& type, long int defaultValue) const
 {
-  return longBaseValue(QString("Weapon_%1:%2").arg(id() - 1).arg(name), type, defaultValue);
+  long int v = defaultValue;
+  if(!getBaseValue(&v, weaponPropertyKey(name, type)))
+  {
+    return defaultValue;
+  }
+  return v;
 }
 
 bofixed BosonWeaponProperties::bofixedWeaponBaseValue(const QString& name, const QString& type, bofixed defaultValue) const
 {
-  return bofixedBaseValue(QString("Weapon_%1:%2").arg(id() - 1).arg(name), type, defaultValue);
+  bofixed v = defaultValue;
+  if(!getBaseValue(&v, weaponPropertyKey(name, type)))
+  {
+    return defaultValue;
+  }
+  return v;
 }
 
 bool BosonWeaponProperties::loadPlugin(KSimpleConfig* cfg)
@@ -485,15 +505,16 @@ void BosonWeaponProperties::loadAction(UnitAction type, KSimpleConfig* cfg, cons
 /*****  BosonWeapon  *****/
 BosonWeapon::BosonWeapon(int weaponNumber, BosonWeaponProperties* prop, Unit* _unit)
     : UnitPlugin(_unit),
-    // AB: note that ids start with _1_ here, but with _0_ in the config files.
-    // so we must subtract one for the strings.
-    mRange(          prop, QString("Weapon_%1:Range").arg(prop->id()-1), "MaxValue"),
-    mDamage(         prop, QString("Weapon_%1:Damage").arg(prop->id()-1), "MaxValue"),
-    mDamageRange(    prop, QString("Weapon_%1:DamageRange").arg(prop->id()-1), "MaxValue"),
-    mFullDamageRange(prop, QString("Weapon_%1:FullDamageRange").arg(prop->id()-1), "MaxValue"),
-    mReloadingTime(  prop, QString("Weapon_%1:Reload").arg(prop->id()-1), "MaxValue"),
-    mSpeed(          prop, QString("Weapon_%1:Speed").arg(prop->id()-1), "MaxValue"),
-    mRequiredAmmunition(prop, QString("Weapon_%1:RequiredAmmunition").arg(prop->id()-1), "MaxValue")
+    // the properties use the same names as the properties of prop, so we
+    // can re-use the keys instead of building the "Weapon_ID:name" strings
+    // for every weapon of every unit.
+    mRange(          prop, prop->mRange.key()),
+    mDamage(         prop, prop->mDamage.key()),
+    mDamageRange(    prop, prop->mDamageRange.key()),
+    mFullDamageRange(prop, prop->mFullDamageRange.key()),
+    mReloadingTime(  prop, prop->mReloadingTime.key()),
+    mSpeed(          prop, prop->mSpeed.key()),
+    mRequiredAmmunition(prop, prop->mRequiredAmmunition.key())
 {
   mProp = prop;
   mTurret = 0;
@@ -228,7 +228,14 @@ class BosonWeaponProperties : public PluginProperties
     long int longWeaponBaseValue(const QString& name, const QString& type = "MaxValue", long int defaultValue = 0) const;
     bofixed bofixedWeaponBaseValue(const QString& name, const QString& type = "MaxValue", bofixed defaultValue = 0) const;
 
+    /**
+     * @return The @ref BoUpgradeablePropertyKey of the weapon property @p
+     * name, i.e. of "Weapon_ID:name".
+     **/
+    int weaponPropertyKey(const QString& name, const QString& type = "MaxValue") const;
+
     friend class BosonWeaponPropertiesEditor;
+    friend class BosonWeapon; // uses the keys of our upgradeable properties
 
   private:
 
@@ -0,0 +1,68 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef BOSYNCHASH_H
+#define BOSYNCHASH_H
+
+#include "../bomath.h"
+
+#include <qglobal.h>
+
+/**
+ * Helper functions for the 64 bit state hashes that are used to check whether
+ * the clients of a network game are in sync, see @ref
+ * BosonCanvas::itemsSyncHash and @ref BosonNetworkSyncChecker.
+ *
+ * A hash of a single object (such as an item) is built by calling @ref add
+ * for all values and @ref finish on the result. The hashes of several objects
+ * are simply added up (modulo 2^64), so that the hash of a set of objects does
+ * not depend on the order of the objects and a changed object can be replaced
+ * in the sum in O(1) (subtract the old hash, add the new one).
+ *
+ * Note that only values that are the same on all clients may be used, i.e.
+ * never add a pointer or a float.
+ **/
+class BoSyncHash
+{
+public:
+	static inline Q_UINT64 add(Q_UINT64 h, Q_UINT64 v)
+	{
+		return h ^ (v + Q_UINT64_C(0x9e3779b97f4a7c15) + (h << 6) + (h >> 2));
+	}
+	static inline Q_UINT64 add(Q_UINT64 h, bofixed v)
+	{
+		return add(h, (Q_UINT64)(Q_UINT32)v.rawInt());
+	}
+
+	/**
+	 * Mix the bits of @p h, so that small changes of a value change the
+	 * whole hash. This is the finalizer of the SplitMix64 generator.
+	 **/
+	static inline Q_UINT64 finish(Q_UINT64 h)
+	{
+		h ^= h >> 30;
+		h *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+		h ^= h >> 27;
+		h *= Q_UINT64_C(0x94d049bb133111eb);
+		h ^= h >> 31;
+		return h;
+	}
+};
+
+#endif
+
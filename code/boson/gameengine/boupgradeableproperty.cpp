@@ -25,64 +25,199 @@
 #include "speciestheme.h"
 
 #include <qdom.h>
+#include <qmap.h>
+#include <qvaluelist.h>
+#include <qvaluevector.h>
 
-class BaseValueEntryBase
+class BoUpgradeablePropertyKeyRegistry
 {
 public:
-	BaseValueEntryBase()
-	{
-	}
-	virtual ~BaseValueEntryBase()
-	{
-	}
-	virtual unsigned long int toULong() const = 0;
-	virtual long int toLong() const = 0;
-	virtual bofixed toBoFixed() const = 0;
-
-	virtual void setValue(unsigned long int v) = 0;
-	virtual void setValue(long int v) = 0;
-	virtual void setValue(bofixed v) = 0;
+	QMap<QString, int> mNameKeys;
+	QValueVector<QString> mNames;
 };
 
-template<class T> class BaseValueEntry : public BaseValueEntryBase
+static BoUpgradeablePropertyKeyRegistry* propertyKeyRegistry()
+{
+ // created on first use, as properties may be created by static objects.
+ //     the object is never deleted.
+ static BoUpgradeablePropertyKeyRegistry* registry = 0;
+ if (!registry) {
+	registry = new BoUpgradeablePropertyKeyRegistry;
+ }
+ return registry;
+}
+
+int BoUpgradeablePropertyKey::valueType(const QString& type)
+{
+ if (type == "MaxValue") {
+	return MaxValue;
+ } else if (type == "MinValue") {
+	return MinValue;
+ }
+ return -1;
+}
+
+int BoUpgradeablePropertyKey::key(const QString& name, const QString& type)
+{
+ int t = valueType(type);
+ if (t < 0) {
+	boError() << k_funcinfo << "invalid type " << type << endl;
+	return -1;
+ }
+ BoUpgradeablePropertyKeyRegistry* r = propertyKeyRegistry();
+ QMap<QString, int>::const_iterator it = r->mNameKeys.find(name);
+ int nameKey;
+ if (it != r->mNameKeys.end()) {
+	nameKey = *it;
+ } else {
+	nameKey = r->mNames.count();
+	r->mNames.append(name);
+	r->mNameKeys.insert(name, nameKey);
+ }
+ return (nameKey << 1) | t;
+}
+
+QString BoUpgradeablePropertyKey::name(int key)
+{
+ BoUpgradeablePropertyKeyRegistry* r = propertyKeyRegistry();
+ if (key < 0 || nameKey(key) >= (int)r->mNames.count()) {
+	return QString::null;
+ }
+ return r->mNames[nameKey(key)];
+}
+
+QString BoUpgradeablePropertyKey::type(int key)
+{
+ if (key < 0) {
+	return QString::null;
+ }
+ if (valueType(key) == MinValue) {
+	return QString::fromLatin1("MinValue");
+ }
+ return QString::fromLatin1("MaxValue");
+}
+
+int BoUpgradeablePropertyKey::keyCount()
+{
+ return propertyKeyRegistry()->mNames.count() * 2;
+}
+
+
+/**
+ * A value of one of the data types of upgradeable properties. The data type
+ * that the value was inserted with is stored as well, so the value is converted
+ * exactly like it would be converted by a cast from the original type.
+ **/
+class BaseValue
 {
 public:
-	BaseValueEntry() : BaseValueEntryBase()
+	enum DataType {
+		DataNone = 0,
+		DataULong,
+		DataLong,
+		DataBoFixed
+	};
+	BaseValue()
 	{
+		mDataType = DataNone;
+		mULong = 0;
 	}
-	BaseValueEntry(const BaseValueEntry& v) : BaseValueEntryBase()
+
+	bool isValid() const { return mDataType != DataNone; }
+	int dataType() const { return mDataType; }
+
+	void set(unsigned long int v) { mDataType = DataULong; mULong = v; }
+	void set(long int v) { mDataType = DataLong; mLong = v; }
+	void set(bofixed v) { mDataType = DataBoFixed; mBoFixed = v.rawInt(); }
+
+	// keep the data type, if a value was already set
+	template<class T> void setValue(T v)
 	{
-		*this = v;
+		switch (mDataType) {
+			case DataULong:
+				set((unsigned long int)v);
+				break;
+			case DataLong:
+				set((long int)v);
+				break;
+			case DataBoFixed:
+				set((bofixed)v);
+				break;
+			default:
+				set(v);
+				break;
+		}
 	}
-	BaseValueEntry(const T& v) : BaseValueEntryBase()
+
+	bofixed boFixed() const
 	{
-		mValue = v;
+		bofixed f;
+		f.setFromRawInt(mBoFixed);
+		return f;
 	}
-	const BaseValueEntry& operator=(const BaseValueEntry& e)
+
+	void get(unsigned long int* v) const
 	{
-		mValue = e.mValue;
-		return *this;
+		switch (mDataType) {
+			case DataLong:
+				*v = (unsigned long int)mLong;
+				break;
+			case DataBoFixed:
+				*v = (unsigned long int)boFixed();
+				break;
+			default:
+				*v = mULong;
+				break;
+		}
 	}
-	const BaseValueEntry& operator=(const T& v)
+	void get(long int* v) const
 	{
-		mValue = v;
-		return *this;
+		switch (mDataType) {
+			case DataULong:
+				*v = (long int)mULong;
+				break;
+			case DataBoFixed:
+				*v = (long int)boFixed();
+				break;
+			default:
+				*v = mLong;
+				break;
+		}
 	}
-	operator T() const
+	void get(bofixed* v) const
 	{
-		return mValue;
+		switch (mDataType) {
+			case DataULong:
+				*v = (bofixed)mULong;
+				break;
+			case DataLong:
+				*v = (bofixed)mLong;
+				break;
+			default:
+				*v = boFixed();
+				break;
+		}
 	}
 
-	virtual unsigned long int toULong() const { return (unsigned long int)mValue; }
-	virtual long int toLong() const { return (long int)mValue; }
-	virtual bofixed toBoFixed() const { return (bofixed)mValue; }
+private:
+	Q_INT8 mDataType;
+	union {
+		unsigned long int mULong;
+		long int mLong;
+		Q_INT32 mBoFixed; // bofixed::rawInt()
+	};
+};
 
-	virtual void setValue(unsigned long int v) { mValue = (T)v; }
-	virtual void setValue(long int v)  { mValue = (T)v; }
-	virtual void setValue(bofixed v)  { mValue = (T)v; }
+/**
+ * The base value of a property and the most recently calculated upgraded value.
+ **/
+class BaseValueEntry
+{
+public:
+	BaseValue mBaseValue;
 
-private:
-	T mValue;
+	BaseValue mUpgradedValue;
+	QValueList<const UpgradeProperties*> mUpgradedWith;
 };
 
 class BoBaseValueCollectionPrivate
@@ -91,7 +226,31 @@ public:
 	BoBaseValueCollectionPrivate()
 	{
 	}
-	QMap< QString, QMap<QString, BaseValueEntryBase*> > mProperties;
+
+	BaseValueEntry* entry(int key)
+	{
+		if (key < 0) {
+			return 0;
+		}
+		if ((unsigned int)key >= mEntries.count()) {
+			// the vector is indexed by the key, so it grows to
+			// the largest key that is used by this collection.
+			mEntries.resize(key + 1);
+		}
+		return &mEntries[key];
+	}
+	const BaseValueEntry* constEntry(int key) const
+	{
+		if (key < 0 || (unsigned int)key >= mEntries.count()) {
+			return 0;
+		}
+		if (!mEntries[key].mBaseValue.isValid()) {
+			return 0;
+		}
+		return &mEntries[key];
+	}
+
+	QValueVector<BaseValueEntry> mEntries;
 };
 
 BoBaseValueCollection::BoBaseValueCollection()
@@ -101,107 +260,137 @@ BoBaseValueCollection::BoBaseValueCollection()
 
 BoBaseValueCollection::~BoBaseValueCollection()
 {
- QMap< QString, QMap<QString, BaseValueEntryBase*> >::iterator it;
- for (it = d->mProperties.begin(); it != d->mProperties.end(); ++it) {
-	QMap<QString, BaseValueEntryBase*>::iterator it2;
-	for (it2 = (*it).begin(); it2 != (*it).end(); ++it2) {
-		delete *it2;
-	}
-	(*it).clear();
- }
  delete d;
 }
 
-bool BoBaseValueCollection::insertULongBaseValue(unsigned long int v, const QString& name, const QString& type, bool replace)
+template<class T> bool BoBaseValueCollection::insertBaseValueInternal(T v, const QString& name, const QString& type, bool replace)
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
+ int key = BoUpgradeablePropertyKey::key(name, type);
+ BaseValueEntry* e = d->entry(key);
+ if (!e) {
+	// invalid type. error has already been displayed.
 	return false;
  }
- if (!(d->mProperties[type]).contains(name)) {
-	BaseValueEntryBase* value = new BaseValueEntry<unsigned long int>(v);
-	(d->mProperties[type]).insert(name, value);
- }
- if (replace) {
-	(d->mProperties[type])[name]->setValue(v);
+ if (!e->mBaseValue.isValid()) {
+	e->mBaseValue.set(v);
+ } else if (replace) {
+	e->mBaseValue.setValue(v);
+ } else {
+	return true;
  }
+ e->mUpgradedWith.clear();
+ e->mUpgradedValue = BaseValue();
  return true;
 }
 
+bool BoBaseValueCollection::insertULongBaseValue(unsigned long int v, const QString& name, const QString& type, bool replace)
+{
+ return insertBaseValueInternal(v, name, type, replace);
+}
+
 bool BoBaseValueCollection::insertLongBaseValue(long int v, const QString& name, const QString& type, bool replace)
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
-	return false;
- }
- if (!(d->mProperties[type]).contains(name)) {
-	BaseValueEntryBase* value = new BaseValueEntry<long int>(v);
-	(d->mProperties[type]).insert(name, value);
- }
- if (replace) {
-	(d->mProperties[type])[name]->setValue(v);
- }
- return true;
+ return insertBaseValueInternal(v, name, type, replace);
 }
 
 bool BoBaseValueCollection::insertBoFixedBaseValue(bofixed v, const QString& name, const QString& type, bool replace)
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
+ return insertBaseValueInternal(v, name, type, replace);
+}
+
+template<class T> bool BoBaseValueCollection::getBaseValueInternal(T* ret, int key) const
+{
+ const BaseValueEntry* e = d->constEntry(key);
+ if (!e) {
+	if (key < 0) {
+		boError() << k_funcinfo << "invalid key " << key << endl;
+	} else {
+		boError() << k_funcinfo << "no such property " << BoUpgradeablePropertyKey::name(key) << endl;
+	}
 	return false;
  }
- if (!(d->mProperties[type]).contains(name)) {
-	BaseValueEntryBase* value = new BaseValueEntry<bofixed>(v);
-	(d->mProperties[type]).insert(name, value);
- }
- if (replace) {
-	(d->mProperties[type])[name]->setValue(v);
- }
+ e->mBaseValue.get(ret);
  return true;
 }
 
+bool BoBaseValueCollection::getBaseValue(unsigned long int* ret, int key) const
+{
+ return getBaseValueInternal(ret, key);
+}
+
+bool BoBaseValueCollection::getBaseValue(long int* ret, int key) const
+{
+ return getBaseValueInternal(ret, key);
+}
+
+bool BoBaseValueCollection::getBaseValue(bofixed* ret, int key) const
+{
+ return getBaseValueInternal(ret, key);
+}
+
 bool BoBaseValueCollection::getBaseValue(unsigned long int* ret, const QString& name, const QString& type) const
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
-	return false;
- }
- if (!(d->mProperties[type]).contains(name)) {
-	boError() << k_funcinfo << "no such property " << name << endl;
-	return false;
- }
- *ret = (d->mProperties[type])[name]->toULong();
- return true;
+ return getBaseValue(ret, BoUpgradeablePropertyKey::key(name, type));
 }
 
 bool BoBaseValueCollection::getBaseValue(long int* ret, const QString& name, const QString& type) const
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
-	return false;
- }
- if (!(d->mProperties[type]).contains(name)) {
-	boError() << k_funcinfo << "no such property " << name << endl;
-	return false;
- }
- *ret = (d->mProperties[type])[name]->toLong();
- return true;
+ return getBaseValue(ret, BoUpgradeablePropertyKey::key(name, type));
 }
 
 bool BoBaseValueCollection::getBaseValue(bofixed* ret, const QString& name, const QString& type) const
 {
- if (type != "MaxValue" && type != "MinValue") {
-	boError() << k_funcinfo << "invalid type " << type << endl;
+ return getBaseValue(ret, BoUpgradeablePropertyKey::key(name, type));
+}
+
+template<class T> bool BoBaseValueCollection::getUpgradedValueInternal(T* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const
+{
+ BO_CHECK_NULL_RET0(upgrades);
+ if (!getBaseValueInternal(ret, key)) {
 	return false;
  }
- if (!(d->mProperties[type]).contains(name)) {
-	boError() << k_funcinfo << "no such property " << name << endl;
-	return false;
+ if (upgrades->isEmpty()) {
+	return true;
+ }
+
+ // the entry exists, getBaseValueInternal() succeeded
+ BaseValueEntry* e = &d->mEntries[key];
+ BaseValue dataType;
+ dataType.set(*ret);
+ if (e->mUpgradedValue.dataType() == dataType.dataType() && e->mUpgradedWith == *upgrades) {
+	e->mUpgradedValue.get(ret);
+	return true;
  }
- *ret = (d->mProperties[type])[name]->toBoFixed();
+
+ QValueList<const UpgradeProperties*>::const_iterator it;
+ for (it = upgrades->begin(); it != upgrades->end(); ++it) {
+	if (!(*it)->upgradeValue(key, ret)) {
+		boError() << k_funcinfo << "upgrade failed" << endl;
+		e->mUpgradedWith.clear();
+		e->mUpgradedValue = BaseValue();
+		return false;
+	}
+ }
+ e->mUpgradedValue.set(*ret);
+ e->mUpgradedWith = *upgrades;
  return true;
 }
 
+bool BoBaseValueCollection::getUpgradedValue(unsigned long int* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const
+{
+ return getUpgradedValueInternal(ret, key, upgrades);
+}
+
+bool BoBaseValueCollection::getUpgradedValue(long int* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const
+{
+ return getUpgradedValueInternal(ret, key, upgrades);
+}
+
+bool BoBaseValueCollection::getUpgradedValue(bofixed* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const
+{
+ return getUpgradedValueInternal(ret, key, upgrades);
+}
+
 unsigned long int BoBaseValueCollection::ulongBaseValue(const QString& name, const QString& type, unsigned long int defaultValue) const
 {
  unsigned long int v = defaultValue;
@@ -347,41 +536,3 @@ bool BoUpgradesCollection::loadFromXML(const SpeciesTheme* speciesTheme, const Q
  return true;
 }
 
-
-bool BoUpgradeablePropertyBase::upgradeValue(const QValueList<const UpgradeProperties*>* list, unsigned long int* v) const
-{
- QValueList<const UpgradeProperties*>::const_iterator it;
- for (it = list->begin(); it != list->end(); ++it) {
-	if (!(*it)->upgradeValue(name(), v, type())) {
-		boError() << k_funcinfo << "upgrade failed" << endl;
-		return false;
-	}
- }
- return true;
-}
-
-bool BoUpgradeablePropertyBase::upgradeValue(const QValueList<const UpgradeProperties*>* list, long int* v) const
-{
- QValueList<const UpgradeProperties*>::const_iterator it;
- for (it = list->begin(); it != list->end(); ++it) {
-	if (!(*it)->upgradeValue(name(), v, type())) {
-		boError() << k_funcinfo << "upgrade failed" << endl;
-		return false;
-	}
- }
- return true;
-}
-
-bool BoUpgradeablePropertyBase::upgradeValue(const QValueList<const UpgradeProperties*>* list, bofixed* v) const
-{
- QValueList<const UpgradeProperties*>::const_iterator it;
- for (it = list->begin(); it != list->end(); ++it) {
-	if (!(*it)->upgradeValue(name(), v, type())) {
-		boError() << k_funcinfo << "upgrade failed" << endl;
-		return false;
-	}
- }
- return true;
-}
-
-
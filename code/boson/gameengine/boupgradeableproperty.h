@@ -30,6 +30,75 @@ class UpgradeProperties;
 class SpeciesTheme;
 class QDomElement;
 
+/**
+ * @short Integer keys for the names and types of upgradeable properties
+ *
+ * Every @ref BoUpgradeableProperty is identified by a name (e.g. "Health" or
+ * "Weapon_0:Range") and a type ("MaxValue" or "MinValue"). Comparing these
+ * strings whenever a value is needed is expensive, so both are mapped to a
+ * single integer key once, when the property is created. The key is used to
+ * look up the base value in a @ref BoBaseValueCollection and the upgrade
+ * entries in an @ref UpgradeProperties object.
+ *
+ * Names are interned on first use, i.e. the key of a name is assigned when the
+ * data files are loaded and remains valid until the program exits. Keys are
+ * not stable across program runs, so they must never be saved.
+ **/
+class BoUpgradeablePropertyKey
+{
+public:
+	enum ValueType {
+		MaxValue = 0,
+		MinValue = 1
+	};
+
+	/**
+	 * @return The key of the property @p name of type @p type, or -1 if
+	 * @p type is not a valid type. The name is added to the list of known
+	 * names, if required.
+	 **/
+	static int key(const QString& name, const QString& type = "MaxValue");
+
+	/**
+	 * @return The @ref ValueType of the type string @p type, or -1 if
+	 * @p type is neither "MaxValue" nor "MinValue".
+	 **/
+	static int valueType(const QString& type);
+
+	/**
+	 * @return The name of the property identified by @p key
+	 **/
+	static QString name(int key);
+
+	/**
+	 * @return The type string ("MaxValue" or "MinValue") of @p key
+	 **/
+	static QString type(int key);
+
+	/**
+	 * @return The @ref ValueType of @p key
+	 **/
+	inline static int valueType(int key)
+	{
+		return (key & 1);
+	}
+
+	/**
+	 * @return The key of the name of @p key, i.e. a number that is equal
+	 * for the "MaxValue" and the "MinValue" key of a property.
+	 **/
+	inline static int nameKey(int key)
+	{
+		return (key >> 1);
+	}
+
+	/**
+	 * @return The number of keys that have been assigned so far. All keys
+	 * are smaller than this number.
+	 **/
+	static int keyCount();
+};
+
 class BoBaseValueCollectionPrivate;
 /**
  * This class provides a collection of "base" values of upgradeable properties.
@@ -95,6 +164,33 @@ public:
 	long int longBaseValue(const QString& name, const QString& type = "MaxValue", long int defaultValue = 0) const;
 	bofixed bofixedBaseValue(const QString& name, const QString& type = "MaxValue", bofixed defaultValue = 0) const;
 
+	/**
+	 * Same as above, but uses the @ref BoUpgradeablePropertyKey of the
+	 * property instead of its name and type.
+	 **/
+	bool getBaseValue(unsigned long int* ret, int key) const;
+	bool getBaseValue(long int* ret, int key) const;
+	bool getBaseValue(bofixed* ret, int key) const;
+
+	/**
+	 * Apply the @p upgrades to the base value of @p key.
+	 *
+	 * All objects of a unit type of a player share the same base values
+	 * and usually the same upgrades. Therefore the upgraded value is
+	 * remembered in this collection and is re-used as long as it is
+	 * requested with an equal list of upgrades (and the same data type).
+	 * So when an upgrade was added, the new value is calculated only once
+	 * instead of once per unit.
+	 * @return TRUE on success, otherwise FALSE. @p ret is undefined then.
+	 **/
+	bool getUpgradedValue(unsigned long int* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const;
+	bool getUpgradedValue(long int* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const;
+	bool getUpgradedValue(bofixed* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const;
+
+protected:
+	template<class T> bool insertBaseValueInternal(T v, const QString& name, const QString& type, bool replace);
+	template<class T> bool getBaseValueInternal(T* ret, int key) const;
+	template<class T> bool getUpgradedValueInternal(T* ret, int key, const QValueList<const UpgradeProperties*>* upgrades) const;
 
 private:
 	BoBaseValueCollectionPrivate* d;
@@ -144,11 +240,12 @@ private:
 /**
  * @short This is the base class for @ref BoUpgradeableProperty.
  *
- * @ref BoUpgradeableProperty uses @ref loadBaseValue to load the initial value
- * of the property and then @ref upgradeValue to apply the upgrades to this
- * value.
+ * @ref BoUpgradeableProperty uses @ref loadUpgradedValue to load the initial
+ * value of the property and to apply the upgrades to this value. See @ref
+ * BoBaseValueCollection::getUpgradedValue.
  *
- * Every property has a @ref name and a @ref type.
+ * Every property has a @ref name and a @ref type. Both are stored as a single
+ * integer @ref key only, see @ref BoUpgradeablePropertyKey.
  *
  * The @ref name is a unique internal string that identifies the property. It
  * usually makes sense to use the same name as in the index.technologies (or
@@ -173,17 +270,37 @@ public:
 	{
 		mCacheCounter = 0;
 		mBaseValueSource = baseValueSource;
-		mName = name;
-		mType = type;
+		mKey = BoUpgradeablePropertyKey::key(name, type);
 	}
 
-	const QString& name() const
+	/**
+	 * @param key The @ref BoUpgradeablePropertyKey of the property. Use
+	 * this constructor to avoid the string lookup, if the key is already
+	 * known (e.g. from another object of the same property).
+	 **/
+	BoUpgradeablePropertyBase(const BoBaseValueCollection* baseValueSource, int key)
+	{
+		mCacheCounter = 0;
+		mBaseValueSource = baseValueSource;
+		mKey = key;
+	}
+
+	QString name() const
 	{
-		return mName;
+		return BoUpgradeablePropertyKey::name(mKey);
 	}
-	const QString& type() const
+	QString type() const
 	{
-		return mType;
+		return BoUpgradeablePropertyKey::type(mKey);
+	}
+
+	/**
+	 * @return The @ref BoUpgradeablePropertyKey of @ref name and @ref
+	 * type. -1 if the type is invalid.
+	 **/
+	inline int key() const
+	{
+		return mKey;
 	}
 	const BoBaseValueCollection* baseValueCollection() const
 	{
@@ -196,12 +313,19 @@ protected:
 		if (!baseValueCollection()) {
 			return false;
 		}
-		return baseValueCollection()->getBaseValue(v, name(), type());
+		return baseValueCollection()->getBaseValue(v, key());
 	}
 
-	bool upgradeValue(const QValueList<const UpgradeProperties*>* list, unsigned long int* v) const;
-	bool upgradeValue(const QValueList<const UpgradeProperties*>* list, long int* v) const;
-	bool upgradeValue(const QValueList<const UpgradeProperties*>* list, bofixed* v) const;
+	/**
+	 * Load the base value and apply all upgrades in @p list to it.
+	 **/
+	template<class T>bool loadUpgradedValue(const QValueList<const UpgradeProperties*>* list, T* v) const
+	{
+		if (!baseValueCollection()) {
+			return false;
+		}
+		return baseValueCollection()->getUpgradedValue(v, key(), list);
+	}
 
 protected:
 	/*
@@ -212,8 +336,9 @@ protected:
 	mutable unsigned long int mCacheCounter;
 
 private:
-	QString mName;
-	QString mType;
+	// we store the key only, not the name and type strings. the
+	// strings are required for debugging only.
+	int mKey;
 	const BoBaseValueCollection* mBaseValueSource;
 };
 
@@ -268,6 +393,10 @@ public:
 		//    type. is there a different way to achieve this?
 		baseValueSource->insertBaseValue((T)0, name, type, false);
 	}
+	BoUpgradeableProperty(const BoBaseValueCollection* baseValueSource, int key)
+		: BoUpgradeablePropertyBase(baseValueSource, key)
+	{
+	}
 
 	inline T value(const BoUpgradesCollection* c) const
 	{
@@ -283,10 +412,7 @@ protected:
 	{
 		if (mCacheCounter != cacheCounter || cacheCounter == 0) {
 			T value;
-			if (!loadBaseValue(&value)) {
-				return value;
-			}
-			if (!upgradeValue(upgrades, &value)) {
+			if (!loadUpgradedValue(upgrades, &value)) {
 				return value;
 			}
 
@@ -334,6 +334,7 @@ bool BPFLoader::loadFromDiskToFiles(const QString& fileName, QMap<QString, QByte
  QByteArray waterXML = boFile.waterXMLData();
  QByteArray playersXML = boFile.playersData();
  QByteArray canvasXML = boFile.canvasData();
+ QByteArray canvasBinary = boFile.canvasBinaryData();
  QByteArray kgameXML = boFile.kgameData();
  QByteArray mapPreviewPNG = boFile.fileData("map.png", "mappreview");
  if (!boFile.hasMapDirectory()) {
@@ -392,7 +393,12 @@ bool BPFLoader::loadFromDiskToFiles(const QString& fileName, QMap<QString, QByte
  destFiles.insert("map/map.xml", mapXML);
  destFiles.insert("map/water.xml", waterXML);
  destFiles.insert("players.xml", playersXML);
- destFiles.insert("canvas.xml", canvasXML);
+ if (canvasBinary.size() != 0) {
+	// binary savegame (see BoBinarySaveGame). there is no canvas.xml then.
+	destFiles.insert("canvas.bin", canvasBinary);
+ } else {
+	destFiles.insert("canvas.xml", canvasXML);
+ }
  destFiles.insert("kgame.xml", kgameXML);
  if (externalXML.size() != 0) {
 	// AB: externalXML is optional only. only for loading games.
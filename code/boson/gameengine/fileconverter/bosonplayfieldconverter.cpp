@@ -23,6 +23,7 @@
 #include "../boversion.h"
 #include "bosonfileconverter.h"
 #include "bosavegameconverter.h"
+#include "../bobinarysavegame.h"
 #include "bodebug.h"
 
 #include <qdom.h>
@@ -57,7 +58,6 @@ bool BosonPlayFieldConverter::convertFilesToCurrentFormat(QMap<QString, QByteArr
  requireFiles.append("map/heightmap.png");
  requireFiles.append("map/map.xml");
  requireFiles.append("players.xml");
- requireFiles.append("canvas.xml");
  requireFiles.append("C/description.xml");
  // AB: all other files are optional for boson 0.9
 
@@ -67,6 +67,11 @@ bool BosonPlayFieldConverter::convertFilesToCurrentFormat(QMap<QString, QByteArr
 		return false;
 	}
  }
+ if (!destFiles.contains("canvas.xml") && !destFiles.contains("canvas.bin")) {
+	// canvas.bin is the binary version of canvas.xml. see BoBinarySaveGame.
+	boError() << k_funcinfo << "no file \"canvas.xml\" found." << endl;
+	return false;
+ }
 
  QDomDocument kgameDoc(QString::fromLatin1("Boson"));
  if (!kgameDoc.setContent(QString(destFiles["kgame.xml"]))) {
@@ -92,7 +97,20 @@ bool BosonPlayFieldConverter::convertFilesToCurrentFormat(QMap<QString, QByteArr
 	handled = false;
 	conversionSucceeded = true;
  } else {
-	conversionSucceeded = converters[version]->convertFiles(destFiles);
+	if (destFiles.contains("canvas.bin")) {
+		// the converters know the XML format only
+		QByteArray canvasXML = BoBinarySaveGame::convertCanvasBinaryToXML(destFiles["canvas.bin"]);
+		if (canvasXML.isNull()) {
+			boError() << k_funcinfo << "unable to convert canvas.bin to canvas.xml" << endl;
+			conversionSucceeded = false;
+		} else {
+			destFiles.remove("canvas.bin");
+			destFiles.insert("canvas.xml", canvasXML);
+		}
+	}
+	if (conversionSucceeded) {
+		conversionSucceeded = converters[version]->convertFiles(destFiles);
+	}
 	handled = true;
  }
  for (QMap<int, BoSaveGameConverter*>::iterator it = converters.begin(); it != converters.end(); ++it) {
@@ -28,6 +28,8 @@
 #include "unitplugins/ammunitionstorageplugin.h"
 #include "unitplugins/productionplugin.h"
 #include "bosonmessageids.h"
+#include "bosonmessage.h"
+#include "bosonnetworktraffic.h"
 #include "bosonmap.h"
 #include "bosonstatistics.h"
 #include "boson.h"
@@ -40,6 +42,7 @@
 #include "boevent.h"
 #include "boitemlist.h"
 #include "cell.h"
+#include "bosynchash.h"
 
 #include <kgame/kgame.h>
 #include <kgame/kgamemessage.h>
@@ -47,6 +50,7 @@
 #include <qbitarray.h>
 #include <qdom.h>
 #include <qtextstream.h>
+#include <qtimer.h>
 
 #include "player.moc"
 
@@ -59,10 +63,16 @@ public:
 		mUnitPropID = 0;
 		mMap = 0;
 		mFoggedRef = 0;
+		mUnfoggedBits = 0;
+		mUnfoggedBitsRowWords = 0;
+		clearFogChanges();
 
 		mStatistics = 0;
 
 		mPlayerIO = 0;
+
+		mInputBatchSender = 0;
+		mInputBatchTimer = 0;
 	}
 
 	QPtrList<Unit> mUnits;
@@ -70,8 +80,58 @@ public:
 	BosonMap* mMap; // just a pointer
 	int mUnitPropID; // used for KGamePropertyHandler
 
+	// Bits of a row of mUnfoggedBits that are set for cells x1..x2
+	static inline Q_UINT32 rowMask(int x1, int x2)
+	{
+		Q_UINT32 mask = 0xffffffff << (x1 & 31);
+		if ((x2 & 31) != 31) {
+			mask &= ~(0xffffffff << ((x2 & 31) + 1));
+		}
+		return mask;
+	}
+	void initUnfoggedBits(unsigned int width, unsigned int height)
+	{
+		delete[] mUnfoggedBits;
+		mUnfoggedBitsRowWords = (width + 31) / 32;
+		unsigned int words = mUnfoggedBitsRowWords * height;
+		mUnfoggedBits = new Q_UINT32[words];
+		for (unsigned int i = 0; i < words; i++) {
+			mUnfoggedBits[i] = 0;
+		}
+		for (unsigned int y = 0; y < height; y++) {
+			for (unsigned int x = 0; x < width; x++) {
+				if (mFoggedRef[y * width + x] != 0) {
+					mUnfoggedBits[y * mUnfoggedBitsRowWords + x / 32] |= ((Q_UINT32)1 << (x & 31));
+				}
+			}
+		}
+	}
+	void addFogChange(int x1, int y1, int x2, int y2)
+	{
+		mFogChangedX1 = QMIN(mFogChangedX1, x1);
+		mFogChangedY1 = QMIN(mFogChangedY1, y1);
+		mFogChangedX2 = QMAX(mFogChangedX2, x2);
+		mFogChangedY2 = QMAX(mFogChangedY2, y2);
+	}
+	void clearFogChanges()
+	{
+		mFogChangedX1 = 1000000;
+		mFogChangedY1 = 1000000;
+		mFogChangedX2 = -1;
+		mFogChangedY2 = -1;
+	}
+
 	QBitArray mExplored; // TODO: use KGameProperty
 	unsigned short int* mFoggedRef;
+	// One bit per cell, set if mFoggedRef is non-zero. Rows start at word
+	// boundaries, so that areas can be tested a word at once.
+	Q_UINT32* mUnfoggedBits;
+	unsigned int mUnfoggedBitsRowWords;
+	// Area whose fog changed since the last flushFogChanges() call
+	int mFogChangedX1;
+	int mFogChangedY1;
+	int mFogChangedX2;
+	int mFogChangedY2;
 	unsigned int mExploredCount; // helper variable, doesn't need to be saved
 	unsigned int mUnfoggedCount; // helper variable, doesn't need to be saved
 	KGameProperty<unsigned long int> mMinerals;
@@ -86,6 +146,11 @@ public:
 
 	PlayerIO* mPlayerIO;
 
+	// player inputs that have not yet been sent, see forwardInput()
+	BosonMessageBatch mInputBatch;
+	Q_UINT32 mInputBatchSender;
+	QTimer* mInputBatchTimer;
+
 	QValueList<unsigned long int> mResearchedUpgrades;
 
 	BoUpgradesCollection mUpgradesCollection;
@@ -103,6 +168,9 @@ Player::Player(bool isNeutralPlayer) : KPlayer()
  setAsyncInput(true);
  connect(this, SIGNAL(signalNetworkData(int, const QByteArray&, Q_UINT32, KPlayer*)),
 		this, SLOT(slotNetworkData(int, const QByteArray&, Q_UINT32, KPlayer*)));
+ d->mInputBatchTimer = new QTimer(this);
+ connect(d->mInputBatchTimer, SIGNAL(timeout()),
+		this, SLOT(slotSendInputBatch()));
 
  KGamePropertyBase* propName = dataHandler()->find(KGamePropertyBase::IdName);
  if (propName) {
@@ -193,8 +261,15 @@ void Player::quitGame(bool destruct)
  delete d->mStatistics;
  d->mStatistics = 0;
 
+ // orders of the previous game are discarded
+ d->mInputBatch.clear();
+ d->mInputBatchTimer->stop();
+
  delete[] d->mFoggedRef;
  d->mFoggedRef = 0;
+ delete[] d->mUnfoggedBits;
+ d->mUnfoggedBits = 0;
+ d->clearFogChanges();
 
  if (!destruct) {
 	d->mStatistics = new BosonStatistics;
@@ -206,6 +281,83 @@ void Player::quitGame(bool destruct)
  }
 }
 
+bool Player::forwardInput(QDataStream& msg, bool transmit, Q_UINT32 sender)
+{
+ if (!transmit) {
+	return KPlayer::forwardInput(msg, transmit, sender);
+ }
+ if (!isActive() || !game()) {
+	return false;
+ }
+
+ // we collect the player inputs of an advance call and send them in a
+ // single message in the compact format, see BosonMessageBatch.
+ QIODevice* device = msg.device();
+ const unsigned int start = device->at();
+ bool editor = false;
+ Q_UINT32 msgid;
+ msg >> msgid;
+ if (msgid == BosonMessageIds::MoveEditor) {
+	editor = true;
+	msg >> msgid;
+ }
+ BosonMessage* message = BosonMessage::createMessage(msgid, editor);
+ if (!message || !message->load(msg)) {
+	// not a message we know. send it as it is, but keep the order of the
+	// messages.
+	delete message;
+	slotSendInputBatch();
+	device->at(start);
+	return KPlayer::forwardInput(msg, transmit, sender);
+ }
+ if (!d->mInputBatch.isEmpty() && (sender != d->mInputBatchSender || editor != d->mInputBatch.isEditor())) {
+	slotSendInputBatch();
+ }
+ const unsigned int bytes = d->mInputBatch.append(*message);
+ delete message;
+ if (bytes == 0) {
+	boError() << k_funcinfo << "could not add message " << msgid << " to batch" << endl;
+	return false;
+ }
+ d->mInputBatchSender = sender;
+
+ Boson* boson = (Boson*)game();
+ boson->networkTraffic()->addPlayerInput(msgid, bytes, device->size() - start);
+
+ if (!d->mInputBatchTimer->isActive()) {
+	// send the batch once per advance call. if there are no advance calls
+	// (editor, paused game) we send it once we get back to the event loop.
+	int interval = 0;
+	if (boson->gameMode() && !boson->gamePaused() && boson->gameSpeed() > 0) {
+		interval = Boson::advanceMessageInterval() / boson->gameSpeed();
+	}
+	d->mInputBatchTimer->start(interval);
+ }
+ return true;
+}
+
+void Player::slotSendInputBatch()
+{
+ d->mInputBatchTimer->stop();
+ if (d->mInputBatch.isEmpty()) {
+	return;
+ }
+ QByteArray buffer;
+ QDataStream stream(buffer, IO_WriteOnly);
+ bool ret = d->mInputBatch.save(stream);
+ unsigned int count = d->mInputBatch.count();
+ d->mInputBatch.clear();
+ if (!ret) {
+	boError() << k_funcinfo << "unable to save batch of " << count << " messages" << endl;
+	return;
+ }
+ if (game()) {
+	((Boson*)game())->networkTraffic()->addPlayerInputBatch(buffer.size());
+ }
+ QDataStream msg(buffer, IO_ReadOnly);
+ KPlayer::forwardInput(msg, true, d->mInputBatchSender);
+}
+
 void Player::slotNetworkData(int msgid, const QByteArray& buffer, Q_UINT32 sender, KPlayer*)
 {
  // there are only very few messages handled here. Only those that have
@@ -306,22 +458,30 @@ void Player::slotUnitPropertyChanged(KGamePropertyBase* prop)
  }
 
  bool emitSignalUnitChanged = false;
+ bool updateSyncState = false;
  switch (prop->id()) {
 	case UnitBase::IdHealthFactor:
-	case UnitBase::IdArmorFactor:
 	case UnitBase::IdShieldsFactor:
+		updateSyncState = true;
+		// fall through
+	case UnitBase::IdArmorFactor:
 	case UnitBase::IdSightRangeFactor:
 		// update BosonUnitView if the unit is selected.
 		// not all of these IDs are displayed there. But perhaps they
 		// will one day.
 		emitSignalUnitChanged = true;
 		break;
+	case UnitBase::IdAdvanceWork:
+	case UnitBase::IdMovingStatus:
+		// part of UnitBase::syncState()
+		updateSyncState = true;
+		break;
 	default:
 		// all other Unit IDs are not displayed in BosonUnitView so
 		// there is no need to emit a signal for them.
 		break;
  }
- if (!emitSignalUnitChanged) {
+ if (!emitSignalUnitChanged && !updateSyncState) {
 	// nothing to do here
 	return;
  }
@@ -333,6 +493,9 @@ void Player::slotUnitPropertyChanged(KGamePropertyBase* prop)
 	boDebug() << "player=" << bosonId() << ",propId=" << prop->id() << endl;
 	return;
  }
+ if (updateSyncState) {
+	p->item()->updateSyncState();
+ }
  if (!RTTI::isUnit(p->item()->rtti())) {
 	return;
  }
@@ -474,39 +637,75 @@ void Player::initMap(BosonMap* map, bool unexplored, bool fogged)
 	d->mFoggedRef[i] = (fogged ? 0 : 1);
  }
  d->mUnfoggedCount = (fogged ? 0 : cellcount);
+ d->initUnfoggedBits(d->mMap->width(), d->mMap->height());
 }
 
-void Player::addFogRef(int x, int y)
+void Player::addFogRefs(int y, int x1, int x2)
 {
  if (!d->mMap || !d->mFoggedRef) {
 	return;
  }
 
- unsigned int index = x + d->mMap->width() * y;
- d->mFoggedRef[index]++;
- if (d->mFoggedRef[index] == 1) {
-	explore(x, y);
-	unfog(x, y);
+ unsigned short int* ref = d->mFoggedRef + d->mMap->width() * y;
+ Q_UINT32* bits = d->mUnfoggedBits + d->mUnfoggedBitsRowWords * y;
+ int changed1 = x2 + 1;
+ int changed2 = -1;
+ for (int x = x1; x <= x2; x++) {
+	ref[x]++;
+	if (ref[x] == 1) {
+		bits[x / 32] |= ((Q_UINT32)1 << (x & 31));
+		explore(x, y);
+		unfog(x, y);
+		changed1 = QMIN(changed1, x);
+		changed2 = x;
+	}
+ }
+ if (changed2 >= 0) {
+	d->addFogChange(changed1, y, changed2, y);
  }
 }
 
-void Player::removeFogRef(int x, int y)
+void Player::removeFogRefs(int y, int x1, int x2)
 {
  if (!d->mMap || !d->mFoggedRef) {
 	return;
  }
 
- unsigned int index = x + d->mMap->width() * y;
- if (d->mFoggedRef[index] == 0) {
-	boError() << k_funcinfo << "mFoggedRef is already 0 at (" << x << "; " << y << ")!" << endl;
-	return;
+ unsigned short int* ref = d->mFoggedRef + d->mMap->width() * y;
+ Q_UINT32* bits = d->mUnfoggedBits + d->mUnfoggedBitsRowWords * y;
+ int changed1 = x2 + 1;
+ int changed2 = -1;
+ for (int x = x1; x <= x2; x++) {
+	if (ref[x] == 0) {
+		boError() << k_funcinfo << "mFoggedRef is already 0 at (" << x << "; " << y << ")!" << endl;
+		continue;
+	}
+	ref[x]--;
+	if (ref[x] == 0) {
+		bits[x / 32] &= ~((Q_UINT32)1 << (x & 31));
+		fog(x, y);
+		changed1 = QMIN(changed1, x);
+		changed2 = x;
+	}
  }
- d->mFoggedRef[index]--;
- if (d->mFoggedRef[index] == 0) {
-	fog(x, y);
+ if (changed2 >= 0) {
+	d->addFogChange(changed1, y, changed2, y);
  }
 }
 
+void Player::flushFogChanges()
+{
+ if (d->mFogChangedX2 < 0) {
+	return;
+ }
+ int x1 = d->mFogChangedX1;
+ int y1 = d->mFogChangedY1;
+ int x2 = d->mFogChangedX2;
+ int y2 = d->mFogChangedY2;
+ d->clearFogChanges();
+ emit signalFogChanged(x1, y1, x2, y2);
+}
+
 void Player::fog(int x, int y)
 {
  d->mUnfoggedCount--;
@@ -526,8 +725,6 @@ void Player::fog(int x, int y)
 		unit->setVisibleStatus(bosonId(), (UnitBase::VisibleStatus)(unit->visibleStatus(bosonId()) & ~UnitBase::VS_Visible));
 	}
  }
-
- emit signalFog(x, y);
 }
 
 void Player::unfog(int x, int y)
@@ -553,8 +750,6 @@ void Player::unfog(int x, int y)
 		}
 	}
  }
-
- emit signalUnfog(x, y);
 }
 
 
@@ -566,7 +761,37 @@ bool Player::isFogged(int x, int y) const
 			<< d->mFogged.size() << ")" << endl;
 	return true;
  }*/
- return d->mFoggedRef[x + d->mMap->width() * y] == 0;
+ return !(d->mUnfoggedBits[d->mUnfoggedBitsRowWords * y + x / 32] & ((Q_UINT32)1 << (x & 31)));
+}
+
+bool Player::canSeeArea(int x1, int y1, int x2, int y2) const
+{
+ if (!d->mUnfoggedBits || x2 < x1 || y2 < y1) {
+	return false;
+ }
+ int word1 = x1 / 32;
+ int word2 = x2 / 32;
+ for (int y = y1; y <= y2; y++) {
+	const Q_UINT32* row = d->mUnfoggedBits + d->mUnfoggedBitsRowWords * y;
+	if (word1 == word2) {
+		if (row[word1] & PlayerPrivate::rowMask(x1, x2)) {
+			return true;
+		}
+		continue;
+	}
+	if (row[word1] & PlayerPrivate::rowMask(x1, 31)) {
+		return true;
+	}
+	for (int w = word1 + 1; w < word2; w++) {
+		if (row[w]) {
+			return true;
+		}
+	}
+	if (row[word2] & PlayerPrivate::rowMask(0, x2)) {
+		return true;
+	}
+ }
+ return false;
 }
 
 void Player::explore(int x, int y)
@@ -863,7 +1088,7 @@ void Player::facilityCompleted(Unit* fac)
  }
 
  BoVector3Fixed location(fac->centerX(), fac->centerY(), fac->z());
- BoEvent* constructedEvent = new BoEvent("FacilityWithTypeConstructed", QString::number(fac->type()));
+ BoEvent* constructedEvent = BoEvent::create("FacilityWithTypeConstructed", QString::number(fac->type()));
  constructedEvent->setPlayerId(bosonId());
  constructedEvent->setUnitId(fac->id());
  constructedEvent->setLocation(location);
@@ -1042,7 +1267,7 @@ void Player::technologyResearched(ProductionPlugin* plugin, unsigned long int ty
 
  addUpgrade(prop);
 
- BoEvent* event = new BoEvent("TechnologyWithTypeResearched", QString::number(type), QString::number(plugin->unit()->id()));
+ BoEvent* event = BoEvent::create("TechnologyWithTypeResearched", QString::number(type), QString::number(plugin->unit()->id()));
  event->setPlayerId(bosonId());
  event->setLocation(BoVector3Fixed(plugin->unit()->centerX(), plugin->unit()->centerY(), plugin->unit()->z()));
  ((Boson*)game())->queueEvent(event);
@@ -1253,6 +1478,7 @@ bool Player::loadFogOfWar(const QDomElement& root)
 		d->mUnfoggedCount++;
 	}
  }
+ d->initUnfoggedBits(d->mMap->width(), d->mMap->height());
  return true;
 }
 
@@ -1337,6 +1563,17 @@ unsigned int Player::exploredCells() const
  return d->mExploredCount;
 }
 
+Q_UINT64 Player::syncHash() const
+{
+ Q_UINT64 h = BoSyncHash::add(0, (Q_UINT64)bosonId());
+ h = BoSyncHash::add(h, (Q_UINT64)minerals());
+ h = BoSyncHash::add(h, (Q_UINT64)oil());
+ h = BoSyncHash::add(h, (Q_UINT64)ammunition("Generic"));
+ h = BoSyncHash::add(h, (Q_UINT64)unfoggedCells());
+ h = BoSyncHash::add(h, (Q_UINT64)exploredCells());
+ return BoSyncHash::finish(h);
+}
+
 void Player::clearUpgrades()
 {
  d->mUpgradesCollection.clearUpgrades();
@@ -279,8 +279,24 @@ public:
 	void explore(int x, int y);
 	void unexplore(int x, int y);
 
-	void addFogRef(int x, int y);
-	void removeFogRef(int x, int y);
+	void addFogRef(int x, int y) { addFogRefs(y, x, x); }
+	void removeFogRef(int x, int y) { removeFogRefs(y, x, x); }
+
+	/**
+	 * Adds a fog reference to the cells @p x1 to @p x2 (inclusive) in row
+	 * @p y. Cells that become visible are unfogged.
+	 *
+	 * The changed area is not announced until @ref flushFogChanges is
+	 * called.
+	 **/
+	void addFogRefs(int y, int x1, int x2);
+	void removeFogRefs(int y, int x1, int x2);
+
+	/**
+	 * Emits @ref signalFogChanged with the rect of all cells whose fog
+	 * changed since the last call.
+	 **/
+	void flushFogChanges();
 
 	/**
 	 * @return Whether the coordinates @p cellX, @p cellY are explored for
@@ -299,12 +315,26 @@ public:
 	 **/
 	bool isFogged(int x, int y) const;
 
+	/**
+	 * @return TRUE if at least one of the cells in the rect (@p x1, @p y1)
+	 * to (@p x2, @p y2) (inclusive) is not fogged.
+	 **/
+	bool canSeeArea(int x1, int y1, int x2, int y2) const;
+
 	/**
 	 * @return How many cells are currently fogged for this player
 	 **/
 	unsigned int unfoggedCells() const;
 	unsigned int exploredCells() const;
 
+	/**
+	 * @return A 64 bit hash (see @ref BoSyncHash) of the resources and the
+	 * fog of war counters of this player, for the network sync checks.
+	 * All values are counters that are kept up to date anyway, so this is
+	 * O(1).
+	 **/
+	Q_UINT64 syncHash() const;
+
 	unsigned long int minerals() const;
 	unsigned long int oil() const;
 	void setMinerals(unsigned long int m);
@@ -437,13 +467,23 @@ public:
 
 	virtual void networkTransmission(QDataStream& stream, int msgid, Q_UINT32 sender);
 
+	/**
+	 * Reimplemented from @ref KPlayer. Player inputs (see @ref
+	 * BosonMessageIds::MoveMove and following) are not sent immediately,
+	 * but collected in a @ref BosonMessageBatch that is sent once per
+	 * advance call (see @ref slotSendInputBatch).
+	 **/
+	virtual bool forwardInput(QDataStream& msg, bool transmit = true, Q_UINT32 sender = 0);
+
 signals:
 	void signalLoadUnit(unsigned long int unitType, unsigned long int id, Player* owner);
 
 	void signalUnitChanged(Unit* unit);
 
-	void signalFog(int x, int y);
-	void signalUnfog(int x, int y);
+	/**
+	 * Emitted by @ref flushFogChanges. The rect is inclusive.
+	 **/
+	void signalFogChanged(int x1, int y1, int x2, int y2);
 	void signalExplored(int x, int y);
 	void signalUnexplored(int x, int y);
 
@@ -457,6 +497,12 @@ public slots:
 	void slotUnitPropertyChanged(KGamePropertyBase* prop);
 	void slotNetworkData(int msgid, const QByteArray& msg, Q_UINT32 sender, KPlayer*);
 
+	/**
+	 * Send all player inputs that have been collected by @ref forwardInput
+	 * in a single message.
+	 **/
+	void slotSendInputBatch();
+
 protected:
 	bool saveFogOfWar(QDomElement& root) const;
 	bool saveAmmunition(QDomElement& root) const;
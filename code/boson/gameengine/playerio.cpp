@@ -29,6 +29,8 @@
 #include "bosonmap.h"
 #include "unitproperties.h"
 #include "boson.h"
+#include "boitemlist.h"
+#include "boitemlisthandler.h"
 
 #include <qptrvector.h>
 #include <qptrlist.h>
@@ -239,13 +241,15 @@ bool PlayerIO::canSee(BosonItem* item) const
  if (!item) {
 	return false;
  }
+ // The cells of an item always form a rect, the first cell is the top-left
+ // one, the last one the bottom-right
  QPtrVector<Cell>* cells = item->cells();
- for (unsigned int i = 0; i < cells->count(); i++) {
-	if (canSee((*cells)[i])) {
-		return true;
-	}
+ if (cells->count() == 0) {
+	return false;
  }
- return false;
+ const Cell* first = (*cells)[0];
+ const Cell* last = (*cells)[cells->count() - 1];
+ return player()->canSeeArea(first->x(), first->y(), last->x(), last->y());
 }
 
 bool PlayerIO::ownsUnit(const Unit* unit) const
@@ -376,12 +380,19 @@ Unit* PlayerIO::findUnit(unsigned long int id) const
 
 BoItemList* PlayerIO::unitsAtCells(const QPtrVector<const Cell>* cells) const
 {
- BoItemList* collisions = new BoItemList(); // will get deleted by BoItemListHandler
+ BoItemList* collisions = BoItemListHandler::itemListHandler()->allocateList();
+ unitsAtCells(cells, collisions);
+ return collisions;
+}
+
+void PlayerIO::unitsAtCells(const QPtrVector<const Cell>* cells, BoItemList* collisions) const
+{
+ BO_CHECK_NULL_RET(collisions);
  const BoItemList* cellItems;
  BoItemList::ConstIterator it;
  BosonItem* s;
  if (cells->count() == 0) {
-	return collisions;
+	return;
  }
  for (unsigned int i = 0; i < cells->count(); i++) {
 	const Cell* c = cells->at(i);
@@ -403,7 +414,6 @@ BoItemList* PlayerIO::unitsAtCells(const QPtrVector<const Cell>* cells) const
 		}
 	}
  }
- return collisions;
 }
 
 bool PlayerIO::canBuild(unsigned long int unitType) const
@@ -283,8 +283,20 @@ public:
 	Unit* findUnitAt(const BoVector3Fixed& canvasVector) const;
 	Unit* findUnit(unsigned long int unitId) const;
 
+	/**
+	 * @return The units on @p cells that are visible to this player. The
+	 * list is taken from the arena of the @ref BoItemListHandler, do not
+	 * delete it.
+	 **/
 	BoItemList* unitsAtCells(const QPtrVector<const Cell>* cells) const;
 
+	/**
+	 * @overload
+	 * Appends the units to @p result instead, e.g. to a list on the
+	 * stack.
+	 **/
+	void unitsAtCells(const QPtrVector<const Cell>* cells, BoItemList* result) const;
+
 	/**
 	 * @return Player::calculatePower
 	 **/
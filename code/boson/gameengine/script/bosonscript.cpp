@@ -35,6 +35,7 @@
 #include "../unitplugins/productionplugin.h"
 #include "../unitplugins/harvesterplugin.h"
 #include "../../bosonprofiling.h"
+#include "../../botraceprofiling.h"
 #include "../bosonpath.h"
 #include "../speciestheme.h"
 #include "../playerio.h"
@@ -43,6 +44,7 @@
 #include "../bosonplayfield.h"
 #include "../bosonmap.h"
 #include "bosonscriptinterface.h"
+#include "bosonscriptsnapshot.h"
 #include "bodebug.h"
 
 #warning FIXME: remove
@@ -70,6 +72,9 @@
 BosonScript* BosonScript::mCurrentScript = 0;
 BosonCanvas* BosonScript::mCanvas = 0;
 Boson* BosonScript::mGame = 0;
+BosonScriptUnitSnapshot* BosonScript::mUnitSnapshot = 0;
+bool BosonScript::mUnitSnapshotValid = false;
+unsigned int BosonScript::mUnitSnapshotGeneration = 0;
 
 BosonScript* BosonScript::newScriptParser(Language lang, int playerId)
 {
@@ -90,6 +95,17 @@ BosonScript::BosonScript(int playerId)
 {
   mInterface = new BosonScriptInterface(0);
   mPlayerId = playerId;
+  mAdvanceCallsToSkip = 0;
+  mAdvanceBudget = 0;
+  mAdvanceStartTime = 0;
+  if(playerId == -1)
+  {
+    mProfilingSection = BoTraceProfiling::section("Script of game");
+  }
+  else
+  {
+    mProfilingSection = BoTraceProfiling::section(QString("Script of player %1").arg(playerId));
+  }
 }
 
 BosonScript::~BosonScript()
@@ -121,11 +137,74 @@ void BosonScript::makeScriptCurrent(BosonScript* s)
   mCurrentScript = s;
 }
 
+const BosonScriptUnitSnapshot* BosonScript::unitSnapshot()
+{
+  if(!mUnitSnapshot)
+  {
+    mUnitSnapshot = new BosonScriptUnitSnapshot();
+  }
+  if(!mUnitSnapshotValid)
+  {
+    PROFILE_METHOD
+    mUnitSnapshot->update(canvas());
+    mUnitSnapshotValid = true;
+    mUnitSnapshotGeneration++;
+  }
+  return mUnitSnapshot;
+}
+
+void BosonScript::invalidateUnitSnapshot()
+{
+  mUnitSnapshotValid = false;
+}
+
+unsigned int BosonScript::unitSnapshotGeneration()
+{
+  return mUnitSnapshotGeneration;
+}
+
 int BosonScript::playerId() const
 {
   return mPlayerId;
 }
 
+void BosonScript::setAdvanceSchedule(unsigned int phase, long int budget)
+{
+  mAdvanceCallsToSkip = phase;
+  mAdvanceBudget = budget;
+}
+
+bool BosonScript::startAdvance()
+{
+  if(mAdvanceCallsToSkip > 0)
+  {
+    mAdvanceCallsToSkip--;
+    return false;
+  }
+  if(hasPendingCalls())
+  {
+    resumePendingCalls();
+    // the handlers are called again only once the previous call completed.
+    // otherwise a slow script would pile up more and more pending calls.
+    return false;
+  }
+  return true;
+}
+
+void BosonScript::startAdvanceBudget()
+{
+  mAdvanceStartTime = BoTraceProfiling::now();
+}
+
+bool BosonScript::advanceBudgetUsed() const
+{
+  if(mAdvanceBudget <= 0)
+  {
+    return false;
+  }
+  return (long int)((BoTraceProfiling::now() - mAdvanceStartTime) / 1000) >= mAdvanceBudget;
+}
+
 QString BosonScript::scriptsPath()
 {
   QString path = KGlobal::dirs()->findResourceDir("data", "boson/themes/scripts/ai.py");
@@ -1877,24 +1956,20 @@ void BosonScript::internalExplorePlayer(BosonMap* map, Player* p)
 
 void BosonScript::internalUnfogPlayer(BosonMap* map, Player* p)
 {
-  for(unsigned int x = 0; x < map->width(); x++)
+  for(unsigned int y = 0; y < map->height(); y++)
   {
-    for(unsigned int y = 0; y < map->height(); y++)
-    {
-      p->addFogRef(x, y);
-    }
+    p->addFogRefs(y, 0, map->width() - 1);
   }
+  p->flushFogChanges();
 }
 
 void BosonScript::internalFogPlayer(BosonMap* map, Player* p)
 {
-  for(unsigned int x = 0; x < map->width(); x++)
+  for(unsigned int y = 0; y < map->height(); y++)
   {
-    for(unsigned int y = 0; y < map->height(); y++)
-    {
-      p->removeFogRef(x, y);
-    }
+    p->removeFogRefs(y, 0, map->width() - 1);
   }
+  p->flushFogChanges();
 }
 
 /*
@@ -48,6 +48,7 @@ class QDataStream;
 template<class T> class QValueList;
 
 class BosonScriptInterface;
+class BosonScriptUnitSnapshot;
 
 /**
  * Base class for scripting interfaces in Boson
@@ -129,6 +130,55 @@ class BosonScript
 
     int playerId() const;
 
+    /**
+     * Spread the work of this script over several advance calls.
+     *
+     * @param phase The number of "Advance" events that are ignored before
+     * the script runs for the first time. Computer players use different
+     * phases, so that not all of them run in the same advance call.
+     * @param budget The time (in microseconds) a resumable call (see @ref
+     * hasPendingCalls) may use per advance call. 0 means unlimited.
+     **/
+    void setAdvanceSchedule(unsigned int phase, long int budget);
+    long int advanceBudget() const { return mAdvanceBudget; }
+
+    /**
+     * Called by the event listener when an "Advance" event is delivered to
+     * this script, before any handler is called.
+     *
+     * This continues pending calls (see @ref resumePendingCalls) first.
+     * @return TRUE if the handlers for the "Advance" event should be called,
+     * FALSE if the script skips this advance call, i.e. it has not yet
+     * reached its phase or it is still busy with a previous call.
+     **/
+    bool startAdvance();
+
+    /**
+     * @return Whether a handler that was called previously has not yet
+     * completed and will be continued in the next advance call. See @ref
+     * resumePendingCalls.
+     *
+     * The default implementation returns FALSE, i.e. script languages
+     * without support for resumable calls always complete a handler
+     * immediately.
+     **/
+    virtual bool hasPendingCalls() const { return false; }
+
+    /**
+     * Continue the pending calls until they complete or until the budget of
+     * this advance call (see @ref setAdvanceSchedule) is used.
+     *
+     * Pending calls are not saved, i.e. a game that is loaded starts the
+     * handlers from the beginning.
+     **/
+    virtual void resumePendingCalls() {}
+
+    /**
+     * @return The profiling section of this script, see @ref
+     * BoTraceProfiling::section.
+     **/
+    unsigned int profilingSection() const { return mProfilingSection; }
+
 
     /**
      * @return Path where script files are (ending with boson/themes/scripts/)
@@ -143,6 +193,31 @@ class BosonScript
 
     static BosonCanvas* canvas()  { return mCanvas; }
 
+    /**
+     * @return A snapshot of all units, see @ref BosonScriptUnitSnapshot. The
+     * snapshot is taken when this is called for the first time after @ref
+     * invalidateUnitSnapshot, i.e. all scripts that run in the same advance
+     * call share the same snapshot.
+     *
+     * Note that the snapshot does not copy the values of the units, so @ref
+     * BosonScriptUnitSnapshot::fill must be called immediately (i.e. before the
+     * script returns) when the @ref unitSnapshotGeneration has changed.
+     **/
+    static const BosonScriptUnitSnapshot* unitSnapshot();
+
+    /**
+     * Called once per advance call, before the scripts are run. See @ref
+     * unitSnapshot.
+     **/
+    static void invalidateUnitSnapshot();
+
+    /**
+     * @return A number that changes whenever a new snapshot is taken. Script
+     * languages can use this to find out whether the objects they created for
+     * the snapshot are still up to date.
+     **/
+    static unsigned int unitSnapshotGeneration();
+
 
     // Events
     /**
@@ -521,14 +596,36 @@ class BosonScript
     void internalUnfogPlayer(BosonMap* map, Player* p);
     void internalFogPlayer(BosonMap* map, Player* p);
 
+    /**
+     * Start counting the time of the budget (see @ref setAdvanceSchedule).
+     * Must be called whenever the pending calls are resumed, see @ref
+     * resumePendingCalls.
+     **/
+    void startAdvanceBudget();
+
+    /**
+     * @return TRUE if the budget (see @ref setAdvanceSchedule) is used up
+     * since the last call of @ref startAdvanceBudget.
+     **/
+    bool advanceBudgetUsed() const;
+
   private:
     static BosonScript* mCurrentScript;
     BosonScriptInterface* mInterface;
 
     int mPlayerId;
 
+    unsigned int mAdvanceCallsToSkip;
+    long int mAdvanceBudget;
+    Q_UINT64 mAdvanceStartTime;
+    unsigned int mProfilingSection;
+
     static BosonCanvas* mCanvas;
     static Boson* mGame;
+
+    static BosonScriptUnitSnapshot* mUnitSnapshot;
+    static bool mUnitSnapshotValid;
+    static unsigned int mUnitSnapshotGeneration;
 };
 
 #endif //BOSONSCRIPT_H
@@ -0,0 +1,114 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "bosonscriptsnapshot.h"
+
+#include "../../../bomemory/bodummymemory.h"
+#include "../bosoncanvas.h"
+#include "../boitemlist.h"
+#include "../rtti.h"
+#include "../unit.h"
+#include "../unitproperties.h"
+#include "../player.h"
+#include "../../defines.h"
+#include "bodebug.h"
+
+#include <qvaluevector.h>
+
+BosonScriptUnitSnapshot::BosonScriptUnitSnapshot()
+{
+  mUnits = new QValueVector<Unit*>();
+}
+
+BosonScriptUnitSnapshot::~BosonScriptUnitSnapshot()
+{
+  delete mUnits;
+}
+
+void BosonScriptUnitSnapshot::update(const BosonCanvas* canvas)
+{
+  // note: clear() would free the memory, we want to reuse it.
+  mUnits->resize(0);
+  if(!canvas)
+  {
+    BO_NULL_ERROR(canvas);
+    return;
+  }
+  const BoItemList* items = canvas->allItems();
+  for(BoItemList::ConstIterator it = items->begin(); it != items->end(); ++it)
+  {
+    if(!RTTI::isUnit((*it)->rtti()))
+    {
+      continue;
+    }
+    Unit* u = (Unit*)*it;
+    if(u->isDestroyed())
+    {
+      continue;
+    }
+    mUnits->push_back(u);
+  }
+}
+
+unsigned int BosonScriptUnitSnapshot::count() const
+{
+  return mUnits->count();
+}
+
+unsigned int BosonScriptUnitSnapshot::size() const
+{
+  return ColumnCount * count() * 4;
+}
+
+void BosonScriptUnitSnapshot::fill(char* data) const
+{
+  const unsigned int n = count();
+  Q_INT32* id = (Q_INT32*)(data + columnOffset(ColumnId));
+  Q_INT32* owner = (Q_INT32*)(data + columnOffset(ColumnOwner));
+  Q_INT32* type = (Q_INT32*)(data + columnOffset(ColumnType));
+  float* x = (float*)(data + columnOffset(ColumnX));
+  float* y = (float*)(data + columnOffset(ColumnY));
+  Q_INT32* health = (Q_INT32*)(data + columnOffset(ColumnHealth));
+  Q_INT32* work = (Q_INT32*)(data + columnOffset(ColumnWork));
+  Q_INT32* visible = (Q_INT32*)(data + columnOffset(ColumnVisible));
+  for(unsigned int i = 0; i < n; i++)
+  {
+    const Unit* u = mUnits->at(i);
+    id[i] = (Q_INT32)u->id();
+    owner[i] = (Q_INT32)u->owner()->bosonId();
+    type[i] = (Q_INT32)u->unitProperties()->typeId();
+    x[i] = u->centerX().toFloat();
+    y[i] = u->centerY().toFloat();
+    health[i] = (Q_INT32)u->health();
+    work[i] = (Q_INT32)u->advanceWork();
+    Q_INT32 mask = 0;
+    for(int p = 0; p < BOSON_MAX_PLAYERS; p++)
+    {
+      if(u->visibleStatus(128 + p) & (UnitBase::VS_Visible | UnitBase::VS_Earlier))
+      {
+        mask |= (1 << p);
+      }
+    }
+    visible[i] = mask;
+  }
+}
+
+/*
+ * vim: et sw=2
+ */
@@ -0,0 +1,109 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2006 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef BOSONSCRIPTSNAPSHOT_H
+#define BOSONSCRIPTSNAPSHOT_H
+
+class BosonCanvas;
+class Unit;
+
+template<class T> class QValueVector;
+
+/**
+ * A snapshot of all units on the canvas in a packed format, for scripts that
+ * look at many units at once (such as the AI). A script gets all units with a
+ * single call and without converting every value into an object of the script
+ * language.
+ *
+ * The snapshot consists of @ref ColumnCount columns. Every column is an array
+ * of @ref count values of 4 bytes each (native byte order), the columns follow
+ * each other (see @ref fill). Positions (@ref ColumnX and @ref ColumnY) are
+ * floats in cell coordinates, all other columns are signed 32 bit integers.
+ * The units are in the order of @ref BosonCanvas::allItems, destroyed units
+ * are not included.
+ *
+ * The snapshot contains the units of all players, including units that a
+ * player cannot see. @ref ColumnVisible tells which players see a unit (or
+ * have seen it earlier, see @ref UnitBase::visibleStatus): bit (id - 128) is
+ * set for the player with the id id. Scripts must check this column, so that
+ * they see the same units as @ref PlayerIO::allUnits.
+ *
+ * The snapshot is shared by all scripts and is updated (see @ref update) at
+ * most once per advance call, see @ref BosonScript::unitSnapshot.
+ **/
+class BosonScriptUnitSnapshot
+{
+  public:
+    enum Column
+    {
+      ColumnId = 0,
+      ColumnOwner = 1,
+      ColumnType = 2,
+      ColumnX = 3,
+      ColumnY = 4,
+      ColumnHealth = 5,
+      ColumnWork = 6,
+      ColumnVisible = 7,
+
+      ColumnCount = 8
+    };
+
+    BosonScriptUnitSnapshot();
+    ~BosonScriptUnitSnapshot();
+
+    /**
+     * Collect the units of @p canvas. This does not copy any values yet, see
+     * @ref fill.
+     **/
+    void update(const BosonCanvas* canvas);
+
+    /**
+     * @return The number of units in the snapshot.
+     **/
+    unsigned int count() const;
+
+    /**
+     * @return The number of bytes that @ref fill writes, i.e.
+     * @ref ColumnCount * @ref count * 4.
+     **/
+    unsigned int size() const;
+
+    /**
+     * @return The offset of the column @p c in the data written by @ref fill.
+     **/
+    unsigned int columnOffset(Column c) const
+    {
+      return c * count() * 4;
+    }
+
+    /**
+     * Write the values of all units to @p data, which must be able to hold
+     * @ref size bytes.
+     **/
+    void fill(char* data) const;
+
+  private:
+    QValueVector<Unit*>* mUnits;
+};
+
+#endif
+
+/*
+ * vim: et sw=2
+ */
@@ -33,6 +33,7 @@
 #include "bodebug.h"
 #include "../../bo3dtools.h"
 #include "../boevent.h"
+#include "bosonscriptsnapshot.h"
 
 // note: for this to work, getPythonLock() must be called first
 #define CHECK_PYTHON_ERROR if(PyErr_Occurred() != NULL) \
@@ -46,6 +47,8 @@
 PyThreadState* PythonScript::mThreadState = 0;
 int PythonScript::mScriptInstances = 0;
 bool PythonScript::mScriptingInited = false;
+PyObject* PythonScript::mUnitSnapshotObject = 0;
+unsigned int PythonScript::mUnitSnapshotObjectGeneration = 0;
 
 /*****  BoScript methods table (these are accessible from scripts)  *****/
 // Keep this up to date!
@@ -112,6 +115,7 @@ PyMethodDef PythonScript::mCallbacks[] = {
   { (char*)"playerUnitsOfTypeCount", py_playerUnitsOfTypeCount, METH_VARARGS, 0 },
   { (char*)"allUnitsVisibleFor", py_allUnitsVisibleFor, METH_VARARGS, 0 },
   { (char*)"allEnemyUnitsVisibleFor", py_allEnemyUnitsVisibleFor, METH_VARARGS, 0 },
+  { (char*)"unitSnapshot", py_unitSnapshot, METH_VARARGS, 0 },
   // Camera
   { (char*)"setCameraRotation", py_setCameraRotation, METH_VARARGS, 0 },
   { (char*)"setCameraXRotation", py_setCameraXRotation, METH_VARARGS, 0 },
@@ -204,6 +208,12 @@ PythonScript::~PythonScript()
   getPythonLock();
   CHECK_PYTHON_ERROR;
 
+  for(QValueList<PyObject*>::Iterator it = mPendingCalls.begin(); it != mPendingCalls.end(); ++it)
+  {
+    Py_DECREF(*it);
+  }
+  mPendingCalls.clear();
+
   Py_EndInterpreter(mInterpreter);
 
   freePythonLock();
@@ -230,6 +240,8 @@ void PythonScript::uninitScripting()
   PyThreadState* myState = PyThreadState_New(mainState);
   PyThreadState_Swap(myState);
   PyEval_AcquireLock();
+  Py_XDECREF(mUnitSnapshotObject);
+  mUnitSnapshotObject = 0;
   Py_Finalize();
   mScriptingInited = false;
 }
@@ -568,6 +580,14 @@ void PythonScript::callEventHandler(const BoEvent* e, const QString& function, c
     PyErr_Print();
     boError(700) << k_funcinfo << "Error while calling function " << funcname << endl;
   }
+  else if(PyGen_Check(pValue))
+  {
+    // the handler is a generator, i.e. it uses "yield" to give up control.
+    // we keep the reference and run it until it completes or the budget is
+    // used, see resumePendingCalls()
+    mPendingCalls.append(pValue);
+    resumePendingCallsLocked();
+  }
   else
   {
     Py_DECREF(pValue);
@@ -579,6 +599,53 @@ void PythonScript::callEventHandler(const BoEvent* e, const QString& function, c
   Py_DECREF(funcargs);
 }
 
+bool PythonScript::hasPendingCalls() const
+{
+  return !mPendingCalls.isEmpty();
+}
+
+void PythonScript::resumePendingCalls()
+{
+  if(mPendingCalls.isEmpty())
+  {
+    return;
+  }
+  getPythonLock();
+  CHECK_PYTHON_ERROR;
+  resumePendingCallsLocked();
+  freePythonLock();
+}
+
+void PythonScript::resumePendingCallsLocked()
+{
+  // note: this is called from the "Advance" event as well as from other event
+  // handlers that started a new call, so the budget starts here.
+  startAdvanceBudget();
+
+  // note: the calls are continued in the order they were made, a call is
+  // started only once all previous calls completed.
+  while(!mPendingCalls.isEmpty())
+  {
+    PyObject* call = mPendingCalls.first();
+    PyObject* value = PyIter_Next(call);
+    if(value)
+    {
+      Py_DECREF(value);
+    }
+    else
+    {
+      // the call completed (or failed)
+      CHECK_PYTHON_ERROR;
+      mPendingCalls.remove(mPendingCalls.begin());
+      Py_DECREF(call);
+    }
+    if(advanceBudgetUsed())
+    {
+      break;
+    }
+  }
+}
+
 bool PythonScript::init()
 {
   getPythonLock();
@@ -1660,6 +1727,28 @@ PyObject* PythonScript::py_allEnemyUnitsVisibleFor(PyObject*, PyObject* args)
   return QValueListToPyList(&units);
 }
 
+PyObject* PythonScript::py_unitSnapshot(PyObject*, PyObject*)
+{
+  BO_CHECK_NULL_RET0(currentScript());
+  // the snapshot object is created once per advance call and then shared
+  // by all interpreters (i.e. all AI players). this is fine, as it consists of
+  // builtin types only, which are the same in all interpreters.
+  BosonScript::unitSnapshot();
+  if(!mUnitSnapshotObject || mUnitSnapshotObjectGeneration != BosonScript::unitSnapshotGeneration())
+  {
+    Py_XDECREF(mUnitSnapshotObject);
+    mUnitSnapshotObject = createUnitSnapshotObject();
+    mUnitSnapshotObjectGeneration = BosonScript::unitSnapshotGeneration();
+    if(!mUnitSnapshotObject)
+    {
+      return 0;
+    }
+  }
+
+  Py_INCREF(mUnitSnapshotObject);
+  return mUnitSnapshotObject;
+}
+
 
 
 /*****  Camera functions  *****/
@@ -2306,6 +2395,39 @@ PyObject* PythonScript::py_mapHeight(PyObject* self, PyObject* args)
 
 /*****  Non-script functions  *****/
 
+PyObject* PythonScript::createUnitSnapshotObject()
+{
+  const BosonScriptUnitSnapshot* snapshot = BosonScript::unitSnapshot();
+
+  // the values are written directly into the memory of the string, the
+  // buffers only refer to parts of it.
+  PyObject* data = PyString_FromStringAndSize(0, snapshot->size());
+  if(!data)
+  {
+    return 0;
+  }
+  snapshot->fill(PyString_AS_STRING(data));
+
+  PyObject* tuple = PyTuple_New(1 + BosonScriptUnitSnapshot::ColumnCount);
+  PyTuple_SET_ITEM(tuple, 0, PyInt_FromLong(snapshot->count()));
+  for(int i = 0; i < BosonScriptUnitSnapshot::ColumnCount; i++)
+  {
+    BosonScriptUnitSnapshot::Column c = (BosonScriptUnitSnapshot::Column)i;
+    PyObject* column = PyBuffer_FromObject(data, snapshot->columnOffset(c), snapshot->count() * 4);
+    if(!column)
+    {
+      Py_DECREF(tuple);
+      Py_DECREF(data);
+      return 0;
+    }
+    PyTuple_SET_ITEM(tuple, 1 + i, column);
+  }
+
+  // the buffers keep a reference to the string
+  Py_DECREF(data);
+  return tuple;
+}
+
 PyObject* PythonScript::QValueListToPyList(QValueList<int>* list)
 {
   PyObject* pylist = PyList_New(list->count());
@@ -57,8 +57,17 @@ class PythonScript : public BosonScript
 
     virtual void execLine(const QString& line);
 
+    /**
+     * Calls the handler @p function for the event @p e. If the handler is a
+     * generator function (i.e. it uses "yield"), the call is continued by
+     * @ref resumePendingCalls until the generator is exhausted. This way a
+     * long running handler can spread its work over several advance calls.
+     **/
     virtual void callEventHandler(const BoEvent* e, const QString& function, const QString& args);
 
+    virtual bool hasPendingCalls() const;
+    virtual void resumePendingCalls();
+
 
     // Events
     static PyObject* py_addEventHandler(PyObject* self, PyObject* args);
@@ -132,6 +141,7 @@ class PythonScript : public BosonScript
     static PyObject* py_playerUnitsOfTypeCount(PyObject* self, PyObject* args);
     static PyObject* py_allUnitsVisibleFor(PyObject* self, PyObject* args);
     static PyObject* py_allEnemyUnitsVisibleFor(PyObject* self, PyObject* args);
+    static PyObject* py_unitSnapshot(PyObject* self, PyObject* args);
 
 
     // Camera
@@ -206,12 +216,26 @@ class PythonScript : public BosonScript
   protected:
     static PyObject* QValueListToPyList(QValueList<int>* list);
 
+    /**
+     * @return A tuple (count, ids, owners, types, x, y, health, work,
+     * visible) for
+     * @ref BosonScript::unitSnapshot. All values except count are read-only
+     * buffer objects that share the memory of a single string.
+     **/
+    static PyObject* createUnitSnapshotObject();
+
     static void initScripting();
     static void uninitScripting();
 
     void getPythonLock();
     void freePythonLock();
 
+    /**
+     * Like @ref resumePendingCalls, but the python lock must already be
+     * held.
+     **/
+    void resumePendingCallsLocked();
+
     PyObject* saveModule(PyObject* module) const;
     void loadModule(PyObject* module, PyObject* data);
 
@@ -220,11 +244,16 @@ class PythonScript : public BosonScript
     PyObject* mDict;
     PyThreadState* mInterpreter;
     QString mLoadedScripts;
+    QValueList<PyObject*> mPendingCalls; // generators returned by event handlers
 
     static PyMethodDef mCallbacks[];
     static bool mScriptingInited;
     static int mScriptInstances;
     static PyThreadState* mThreadState;
+
+    // shared by all interpreters, see py_unitSnapshot()
+    static PyObject* mUnitSnapshotObject;
+    static unsigned int mUnitSnapshotObjectGeneration;
 };
 
 #endif //PYTHONSCRIPT_H
@@ -219,7 +219,7 @@ bool SpeciesTheme::readUnitConfigs()
 {
  // AB: at least the object models are touched here :(
  // they depend on teamcolor, so we won't be able to change teamcolor anymore!
- if (d->mUnitProperties.count() != 0) {
+ if (unitConfigsRead()) {
 	boError(270) << "Cannot read unit configs again. Returning untouched..."
 			<< endl;
 	return true;
@@ -233,19 +233,7 @@ bool SpeciesTheme::readUnitConfigs()
 	boError() << k_funcinfo << "could not enter \"units\" subdirectory of " << themePath() << endl;
 	return false;
  }
- QStringList dirList = dir.entryList(QDir::Dirs);
- QStringList list;
- for (unsigned int i = 0; i < dirList.count(); i++) {
-	if (dirList[i] == QString::fromLatin1("..") ||
-			dirList[i] == QString::fromLatin1(".")) {
-		continue;
-	}
-	QString file = dir.path() + QString::fromLatin1("/") + dirList[i] +
-			QString::fromLatin1("/index.unit");
-	if (QFile::exists(file)) {
-		list.append(file);
-	}
- }
+ QStringList list = unitConfigFiles();
 
  if (list.isEmpty()) {
 	boWarning(270) << "No Units found in this theme" << endl;
@@ -270,6 +258,33 @@ bool SpeciesTheme::readUnitConfigs()
  return true;
 }
 
+QStringList SpeciesTheme::unitConfigFiles() const
+{
+ QStringList list;
+ QDir dir(themePath());
+ if (!dir.exists() || !dir.cd(QString::fromLatin1("units"))) {
+	return list;
+ }
+ QStringList dirList = dir.entryList(QDir::Dirs);
+ for (unsigned int i = 0; i < dirList.count(); i++) {
+	if (dirList[i] == QString::fromLatin1("..") ||
+			dirList[i] == QString::fromLatin1(".")) {
+		continue;
+	}
+	QString file = dir.path() + QString::fromLatin1("/") + dirList[i] +
+			QString::fromLatin1("/index.unit");
+	if (QFile::exists(file)) {
+		list.append(file);
+	}
+ }
+ return list;
+}
+
+bool SpeciesTheme::unitConfigsRead() const
+{
+ return (d->mUnitProperties.count() != 0);
+}
+
 const UnitProperties* SpeciesTheme::unitProperties(unsigned long int unitType) const
 {
  if (unitType == 0) {
@@ -121,6 +121,19 @@ public:
 	 **/
 	bool readUnitConfigs();
 
+	/**
+	 * @return The config files (index.unit) of all units in this theme,
+	 * i.e. the files that @ref readUnitConfigs reads. An empty list if
+	 * the units directory does not exist.
+	 **/
+	QStringList unitConfigFiles() const;
+
+	/**
+	 * @return TRUE if @ref readUnitConfigs has been called successfully
+	 * already.
+	 **/
+	bool unitConfigsRead() const;
+
 	/**
 	 * @return Concatenation of all @ref UnitProperties::md5 sums in this
 	 * theme, separated by "\n"s
@@ -41,6 +41,8 @@
 #include <klocale.h>
 #include <kinstance.h>
 
+#include <qdatetime.h>
+
 static const char *version = BOSON_VERSION_STRING;
 
 static KCmdLineOptions options[] =
@@ -51,6 +53,24 @@ static KCmdLineOptions options[] =
 static bool start();
 static bool createPlayers(unsigned int count, BosonPlayField*, BosonPlayerListManager*);
 static bool createAndAddUnit(const BoVector3Fixed& pos, BosonCanvas* canvas, BosonPlayerListManager* playerListManager);
+static bool benchmarkRangeQueries(BosonCollisions* collisions, const QPtrList<Unit>& units);
+
+/**
+ * Counts the units it visits
+ **/
+class CountingVisitor : public BoUnitVisitor
+{
+public:
+	CountingVisitor() { mCount = 0; }
+
+	virtual bool visit(Unit*)
+	{
+		mCount++;
+		return true;
+	}
+
+	unsigned int mCount;
+};
 
 int main(int argc, char **argv)
 {
@@ -176,6 +196,67 @@ bool start()
 
  boDebug() << "completed iterations: " << iteration << endl;
 
+ if (!benchmarkRangeQueries(collisions, units)) {
+	return false;
+ }
+
+ return true;
+}
+
+/**
+ * Compares BosonCollisions::visitUnitsInRange() (unit grid) to the old way
+ * of collecting the items of all cells in the range and checking their
+ * distance afterwards.
+ **/
+bool benchmarkRangeQueries(BosonCollisions* collisions, const QPtrList<Unit>& units)
+{
+ const unsigned int iterations = 20;
+ const bofixed radius = 8; // roughly a weapon range
+
+ QTime time;
+ unsigned long int cellsFound = 0;
+ time.start();
+ for (unsigned int iteration = 0; iteration < iterations; iteration++) {
+	for (QPtrListIterator<Unit> it(units); it.current(); ++it) {
+		const BoVector2Fixed pos = it.current()->center();
+		BoItemList* l = collisions->collisions(BoRect2Fixed(QMAX(pos.x() - radius, bofixed(0)), QMAX(pos.y() - radius, bofixed(0)),
+				pos.x() + radius, pos.y() + radius));
+		QValueList<Unit*> list;
+		for (BoItemList::Iterator it2 = l->begin(); it2 != l->end(); ++it2) {
+			if (!RTTI::isUnit((*it2)->rtti())) {
+				continue;
+			}
+			Unit* u = (Unit*)*it2;
+			if (u->isDestroyed()) {
+				continue;
+			}
+			if ((pos - u->center()).dotProduct() <= radius * radius) {
+				list.append(u);
+			}
+		}
+		cellsFound += list.count();
+	}
+ }
+ int cellsTime = time.elapsed();
+
+ unsigned long int gridFound = 0;
+ time.start();
+ for (unsigned int iteration = 0; iteration < iterations; iteration++) {
+	for (QPtrListIterator<Unit> it(units); it.current(); ++it) {
+		CountingVisitor visitor;
+		collisions->visitUnitsInRange(it.current()->center(), radius, &visitor);
+		gridFound += visitor.mCount;
+	}
+ }
+ int gridTime = time.elapsed();
+
+ boDebug() << "range queries: " << iterations * units.count() << " queries, radius " << radius << endl;
+ boDebug() << "  cells: " << cellsTime << " ms, found " << cellsFound << " units" << endl;
+ boDebug() << "  grid:  " << gridTime << " ms, found " << gridFound << " units" << endl;
+ if (cellsFound != gridFound) {
+	boError() << "unit grid found a different number of units than the cells!" << endl;
+	return false;
+ }
  return true;
 }
 
@@ -0,0 +1,190 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <config.h>
+#include "unittests/testframework.h" // FIXME: maybe move out of the unittests dir?
+#include "boversion.h"
+#include "bodebug.h"
+#include "boglobal.h"
+#include "bosondata.h"
+#include "bosoncanvas.h"
+#include "bosongroundtheme.h"
+#include "bobinarysavegame.h"
+
+#include <kaboutdata.h>
+#include <kcmdlineargs.h>
+#include <klocale.h>
+#include <kinstance.h>
+
+#include <qdatetime.h>
+
+static const char *version = BOSON_VERSION_STRING;
+
+static KCmdLineOptions options[] =
+{
+    { "units <count>", I18N_NOOP("Number of units on the canvas"), "3000" },
+    { 0, 0, 0 }
+};
+
+static bool start(unsigned int unitCount);
+static bool fillCanvas(CanvasContainer* container, unsigned int unitCount);
+static CanvasContainer* createEmptyCanvas();
+
+/**
+ * Compares saving and loading a canvas in XML format (canvas.xml) to the
+ * binary format (canvas.bin, see @ref BoBinarySaveGame).
+ **/
+int main(int argc, char **argv)
+{
+ BoDebug::disableAreas(); // dont load bodebug.areas
+ KAboutData about("bosontest",
+		I18N_NOOP("BosonTest"),
+		version);
+
+ QCString argv0(argv[0]);
+ KCmdLineArgs::init(argc, argv, &about);
+ KCmdLineArgs::addCmdLineOptions(options);
+#if BOSON_LINK_STATIC
+ KApplication::disableAutoDcopRegistration();
+#endif
+
+ BoGlobal::initStatic();
+ BoGlobal::boGlobal()->initGlobalObjects();
+
+ KInstance instance(&about);
+
+ KCmdLineArgs* args = KCmdLineArgs::parsedArgs();
+ bool ok = false;
+ unsigned int unitCount = QString(args->getOption("units")).toUInt(&ok);
+ if (!ok) {
+	boError() << "invalid unit count" << endl;
+	return 1;
+ }
+ args->clear();
+
+ if (!start(unitCount)) {
+	return 1;
+ }
+ return 0;
+}
+
+bool start(unsigned int unitCount)
+{
+ const unsigned int groundTypeCount = 3;
+ BosonGroundTheme* theme = TestFrameWork::createNewGroundTheme("dummy_theme_ID", groundTypeCount);
+ BosonData::bosonData()->insertGroundTheme(new BosonGenericDataObject("dummy_file", theme->identifier(), theme));
+
+ CanvasContainer* container = createEmptyCanvas();
+ if (!container) {
+	return false;
+ }
+ if (!fillCanvas(container, unitCount)) {
+	return false;
+ }
+ boDebug() << "canvas initialized. items: " << container->mCanvas->allItemsCount() << endl;
+
+ QTime time;
+ time.start();
+ QCString canvasXML = container->mCanvas->saveCanvas();
+ int xmlSaveTime = time.elapsed();
+
+ time.start();
+ QByteArray canvasBinary = container->mCanvas->saveCanvasBinary();
+ int binarySaveTime = time.elapsed();
+
+ if (canvasXML.isEmpty() || canvasBinary.isEmpty()) {
+	boError() << "saving failed" << endl;
+	return false;
+ }
+
+ CanvasContainer* xmlContainer = createEmptyCanvas();
+ if (!xmlContainer) {
+	return false;
+ }
+ time.start();
+ if (!xmlContainer->mCanvas->loadCanvas(canvasXML)) {
+	boError() << "loading canvas.xml failed" << endl;
+	return false;
+ }
+ int xmlLoadTime = time.elapsed();
+
+ CanvasContainer* binaryContainer = createEmptyCanvas();
+ if (!binaryContainer) {
+	return false;
+ }
+ time.start();
+ if (!binaryContainer->mCanvas->loadFromBinary(canvasBinary)) {
+	boError() << "loading canvas.bin failed" << endl;
+	return false;
+ }
+ int binaryLoadTime = time.elapsed();
+
+ if (xmlContainer->mCanvas->allItemsCount() != container->mCanvas->allItemsCount() ||
+		binaryContainer->mCanvas->allItemsCount() != container->mCanvas->allItemsCount()) {
+	boError() << "loaded canvas has a different number of items" << endl;
+	return false;
+ }
+
+ // savegames are compressed
+ unsigned int xmlCompressed = qCompress(canvasXML.data(), canvasXML.length()).size();
+ unsigned int binaryCompressed = qCompress(canvasBinary).size();
+
+ boDebug() << "canvas with " << container->mCanvas->allItemsCount() << " items:" << endl;
+ boDebug() << "  canvas.xml: save " << xmlSaveTime << " ms, load " << xmlLoadTime << " ms, "
+		<< canvasXML.length() << " bytes (" << xmlCompressed << " compressed)" << endl;
+ boDebug() << "  canvas.bin: save " << binarySaveTime << " ms, load " << binaryLoadTime << " ms, "
+		<< canvasBinary.size() << " bytes (" << binaryCompressed << " compressed)" << endl;
+
+ delete xmlContainer;
+ delete binaryContainer;
+ delete container;
+ return true;
+}
+
+CanvasContainer* createEmptyCanvas()
+{
+ CanvasContainer* container = new CanvasContainer();
+ if (!container->createCanvas("dummy_theme_ID")) {
+	boError() << k_funcinfo << "creating canvas failed" << endl;
+	delete container;
+	return 0;
+ }
+ return container;
+}
+
+bool fillCanvas(CanvasContainer* container, unsigned int unitCount)
+{
+ const bofixed width = container->mCanvas->mapWidth();
+ const bofixed height = container->mCanvas->mapHeight();
+ unsigned int count = 0;
+ for (bofixed y = 1.0; y + 2.0 < height && count < unitCount; y += 2.0) {
+	for (bofixed x = 1.0; x + 2.0 < width && count < unitCount; x += 2.0) {
+		if (!container->createNewUnitAtTopLeftPos(1, BoVector3Fixed(x, y, 0.0))) {
+			boError() << "failed adding unit" << endl;
+			return false;
+		}
+		count++;
+	}
+ }
+ if (count < unitCount) {
+	boWarning() << "map too small for " << unitCount << " units, created " << count << endl;
+ }
+ return true;
+}
+
@@ -29,6 +29,8 @@
 #include "bosongroundtheme.h"
 #include "bpfdescription.h"
 #include "boeventmanager.h"
+#include "boevent.h"
+#include "boeventmatching.h"
 #include "bosonplayerlistmanager.h"
 #include "boglobal.h"
 #include "bosondata.h"
@@ -39,10 +41,29 @@
 #include "boitemlist.h"
 #include "unit.h"
 #include "cell.h"
+#include "boadvanceworkerpool.h"
+#include "boitemlistarena.h"
+#include "boitemlisthandler.h"
+#include "bosoncollisions.h"
+#include "bo3dtools.h"
+#include "bosonmessage.h"
+#include "bobinarysavegame.h"
+#include "bomessage.h"
+#include "boreplay.h"
+#include "bpfloader.h"
+#include "boupgradeableproperty.h"
+#include "upgradeproperties.h"
+#include "bocanvasquadtreenode.h"
+#include "boitemfrustumculler.h"
+#include "bosonpath.h"
+#include "unitorder.h"
 
 #include <ktempfile.h>
+#include <ksimpleconfig.h>
 
 #include <qtextstream.h>
+#include <qdom.h>
+#include <qbuffer.h>
 
 CanvasTest::CanvasTest(QObject* parent)
 	: QObject(parent)
@@ -90,6 +111,19 @@ bool CanvasTest::test()
  DO_TEST(testCreateNewCanvas());
  DO_TEST(testSaveLoadCanvas());
  DO_TEST(testMoveUnits());
+ DO_TEST(testFogOfWar());
+ DO_TEST(testAdvanceWorkerPool());
+ DO_TEST(testItemListArena());
+ DO_TEST(testEventNames());
+ DO_TEST(testCompactMessages());
+ DO_TEST(testSyncHash());
+ DO_TEST(testBinaryCanvas());
+ DO_TEST(testReplay());
+ DO_TEST(testReplaySeek());
+ DO_TEST(testUpgradeableProperties());
+ DO_TEST(testCanvasQuadTree());
+ DO_TEST(testItemFrustumCuller());
+ DO_TEST(testFlowFieldPaths());
 
  return true;
 }
@@ -296,3 +330,987 @@ bool CanvasTest::testMoveUnits()
  return true;
 }
 
+bool CanvasTest::testFogOfWar()
+{
+ Player* player = mCanvasContainer->mPlayerListManager->gamePlayerList().getFirst();
+ MY_VERIFY(player != 0);
+
+ // this part of the map is not in sight of any unit. note that the cells
+ // cross word boundaries of the bit-packed fog rows
+ MY_VERIFY(!player->canSeeArea(30, 150, 70, 160));
+ unsigned int unfogged = player->unfoggedCells();
+
+ player->addFogRefs(155, 40, 66);
+ MY_VERIFY(player->unfoggedCells() == unfogged + 27);
+ MY_VERIFY(!player->isFogged(40, 155));
+ MY_VERIFY(!player->isFogged(66, 155));
+ MY_VERIFY(player->isFogged(39, 155));
+ MY_VERIFY(player->isFogged(67, 155));
+ MY_VERIFY(player->isFogged(50, 154));
+ MY_VERIFY(player->canSeeArea(30, 150, 70, 160));
+ MY_VERIFY(player->canSeeArea(66, 155, 66, 155));
+ MY_VERIFY(!player->canSeeArea(67, 150, 99, 160));
+ MY_VERIFY(!player->canSeeArea(0, 150, 39, 160));
+ MY_VERIFY(!player->canSeeArea(30, 156, 70, 160));
+
+ // a second reference keeps a cell visible
+ player->addFogRefs(155, 50, 50);
+ player->removeFogRefs(155, 40, 66);
+ MY_VERIFY(!player->isFogged(50, 155));
+ MY_VERIFY(player->isFogged(49, 155));
+ MY_VERIFY(player->isFogged(51, 155));
+ player->removeFogRefs(155, 50, 50);
+ MY_VERIFY(player->unfoggedCells() == unfogged);
+ MY_VERIFY(!player->canSeeArea(30, 150, 70, 160));
+ player->flushFogChanges();
+
+ return true;
+}
+
+bool CanvasTest::testSyncHash()
+{
+ BosonCanvas* canvas = mCanvasContainer->mCanvas;
+
+ Unit* unit1 = mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(30.0, 50.0, 0.0));
+ Unit* unit2 = mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(40.0, 50.0, 0.0));
+ MY_VERIFY(unit1 != 0);
+ MY_VERIFY(unit2 != 0);
+ const Q_UINT64 hash = canvas->itemsSyncHash();
+
+ // the hash follows every change and does not depend on the history
+ unit1->moveBy(1.0, 0.0, 0.0);
+ MY_VERIFY(canvas->itemsSyncHash() != hash);
+ unit1->moveBy(-1.0, 0.0, 0.0);
+ MY_VERIFY(canvas->itemsSyncHash() == hash);
+
+ unit2->setRotation(90);
+ MY_VERIFY(canvas->itemsSyncHash() != hash);
+ unit2->setRotation(0);
+ MY_VERIFY(canvas->itemsSyncHash() == hash);
+
+ // properties are tracked through the property handler
+ unsigned long int health = unit1->health();
+ unit1->setHealth(health / 2);
+ MY_VERIFY(canvas->itemsSyncHash() != hash);
+ unit1->setHealth(health);
+ MY_VERIFY(canvas->itemsSyncHash() == hash);
+
+ // two items in the same state still have different hashes
+ Unit* unit3 = mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(40.0, 50.0, 0.0));
+ MY_VERIFY(unit3 != 0);
+ const Q_UINT64 hash3 = canvas->itemsSyncHash();
+ MY_VERIFY(hash3 != hash);
+ unit2->moveBy(1.0, 0.0, 0.0);
+ const Q_UINT64 hash2Moved = canvas->itemsSyncHash();
+ unit2->moveBy(-1.0, 0.0, 0.0);
+ unit3->moveBy(1.0, 0.0, 0.0);
+ MY_VERIFY(canvas->itemsSyncHash() != hash2Moved);
+
+ return true;
+}
+
+static bool isEqualElement(const QDomElement& e1, const QDomElement& e2)
+{
+ MY_VERIFY(e1.tagName() == e2.tagName());
+ QDomNamedNodeMap attributes = e1.attributes();
+ MY_VERIFY(attributes.count() == e2.attributes().count());
+ for (unsigned int i = 0; i < attributes.count(); i++) {
+	QDomAttr a = attributes.item(i).toAttr();
+	MY_VERIFY(e2.hasAttribute(a.name()));
+	MY_VERIFY(e2.attribute(a.name()) == a.value());
+ }
+ QDomNode n1 = e1.firstChild();
+ QDomNode n2 = e2.firstChild();
+ for (; !n1.isNull() && !n2.isNull(); n1 = n1.nextSibling(), n2 = n2.nextSibling()) {
+	MY_VERIFY(n1.nodeType() == n2.nodeType());
+	if (n1.isElement()) {
+		if (!isEqualElement(n1.toElement(), n2.toElement())) {
+			return false;
+		}
+	} else if (n1.isCharacterData()) {
+		MY_VERIFY(n1.toCharacterData().data() == n2.toCharacterData().data());
+	}
+ }
+ MY_VERIFY(n1.isNull() && n2.isNull());
+ return true;
+}
+
+static bool isEqualXML(const QByteArray& xml1, const QByteArray& xml2)
+{
+ QDomDocument doc1;
+ QDomDocument doc2;
+ MY_VERIFY(doc1.setContent(QString(xml1)));
+ MY_VERIFY(doc2.setContent(QString(xml2)));
+ return isEqualElement(doc1.documentElement(), doc2.documentElement());
+}
+
+bool CanvasTest::testBinaryCanvas()
+{
+ MY_VERIFY(mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(12.0, 30.0, 0.0)) != 0);
+ MY_VERIFY(mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(16.0, 30.0, 0.0)) != 0);
+
+ // the properties are not stored as elements, but directly in the binary
+ // file. an armed unit has a WeaponDataHandler, too.
+ Unit* armed = mCanvasContainer->createNewUnitAtTopLeftPos(6, BoVector3Fixed(20.0, 30.0, 0.0));
+ MY_VERIFY(armed != 0);
+ armed->setHealth(armed->health() - 1);
+
+ QByteArray canvasBinary = mCanvasContainer->mCanvas->saveCanvasBinary();
+ MY_VERIFY(!canvasBinary.isEmpty());
+ MY_VERIFY(BoBinarySaveGame::isBinary(canvasBinary));
+ QCString canvasXML = mCanvasContainer->mCanvas->saveCanvas();
+ MY_VERIFY(!canvasXML.isEmpty());
+ MY_VERIFY(!BoBinarySaveGame::isBinary(canvasXML));
+
+ // the binary file contains exactly the data of the XML file
+ QByteArray convertedXML = BoBinarySaveGame::convertCanvasBinaryToXML(canvasBinary);
+ MY_VERIFY(!convertedXML.isEmpty());
+ MY_VERIFY(isEqualXML(canvasXML, convertedXML));
+
+ CanvasContainer* canvasContainer2 = new CanvasContainer();
+ if (!canvasContainer2->createCanvas("dummy_theme_ID")) {
+	return false;
+ }
+ if (!canvasContainer2->mCanvas->loadFromBinary(canvasBinary)) {
+	boError() << k_funcinfo << "loading failed" << endl;
+	return false;
+ }
+ if (!checkIfCanvasIsValid(canvasContainer2->mCanvas)) {
+	return false;
+ }
+ if (!checkIfCanvasAreEqual(mCanvasContainer->mCanvas, canvasContainer2->mCanvas)) {
+	return false;
+ }
+ MY_VERIFY(mCanvasContainer->mCanvas->itemsSyncHash() == canvasContainer2->mCanvas->itemsSyncHash());
+
+ // XML -> binary, as done for old savegames
+ QByteArray convertedBinary = BoBinarySaveGame::convertCanvasXMLToBinary(canvasXML);
+ MY_VERIFY(!convertedBinary.isEmpty());
+ CanvasContainer* canvasContainer3 = new CanvasContainer();
+ if (!canvasContainer3->createCanvas("dummy_theme_ID")) {
+	return false;
+ }
+ if (!canvasContainer3->mCanvas->loadFromBinary(convertedBinary)) {
+	return false;
+ }
+ if (!checkIfCanvasAreEqual(mCanvasContainer->mCanvas, canvasContainer3->mCanvas)) {
+	return false;
+ }
+
+ // a corrupted file must be rejected
+ QByteArray truncated;
+ truncated.duplicate(canvasBinary.data(), canvasBinary.size() / 2);
+ BoBinarySaveGameReader reader(truncated);
+ MY_VERIFY(!reader.open());
+
+ delete canvasContainer2;
+ delete canvasContainer3;
+
+ return true;
+}
+
+class CountUnitsVisitor : public BoUnitVisitor
+{
+public:
+	CountUnitsVisitor() : mCount(0) {}
+	virtual bool visit(Unit*) { mCount++; return true; }
+	unsigned int mCount;
+};
+
+/**
+ * Counts the units around every unit - this only reads the canvas, just like
+ * the jobs of the advance call.
+ **/
+class CountUnitsJob : public BoAdvanceJob
+{
+public:
+	CountUnitsJob(BosonCanvas* canvas, Unit** units, unsigned int* results)
+		: mCanvas(canvas), mUnits(units), mResults(results)
+	{
+	}
+	virtual void compute(unsigned int index)
+	{
+		CountUnitsVisitor visitor;
+		BoVector2Fixed pos(mUnits[index]->centerX(), mUnits[index]->centerY());
+		mCanvas->collisions()->visitUnitsInRange(pos, 10, &visitor);
+		mResults[index] = visitor.mCount;
+		if (mUnits[index]->findBestEnemyUnitInRange()) {
+			mResults[index] += 1000;
+		}
+	}
+
+private:
+	BosonCanvas* mCanvas;
+	Unit** mUnits;
+	unsigned int* mResults;
+};
+
+class AdvanceResult
+{
+public:
+	AdvanceResult()
+	{
+		mSyncHash = 0;
+		mItemsCount = 0;
+		mHealth = 0;
+		mAttackingUnits = 0;
+	}
+
+	Q_UINT64 mSyncHash;
+	unsigned int mItemsCount;
+	unsigned long int mHealth;
+	unsigned int mAttackingUnits;
+};
+
+/**
+ * Create a new canvas with armed units of two enemy players and advance it
+ * @p advanceCalls times, using @p workers threads for the advance calls.
+ **/
+static bool advanceArmedUnits(unsigned int workers, unsigned int advanceCalls, AdvanceResult* result)
+{
+ CanvasContainer container;
+ if (!container.createCanvas("dummy_theme_ID")) {
+	return false;
+ }
+ BosonCanvas* canvas = container.mCanvas;
+ canvas->loadCanvas(BosonCanvas::emptyCanvasFile(0));
+ QPtrList<Player> players = container.mPlayerListManager->gamePlayerList();
+ if (players.count() < 2) {
+	return false;
+ }
+ for (unsigned int i = 0; i < 40; i++) {
+	BoVector3Fixed pos1(10 + (i % 10) * 2, 60 + (i / 10) * 2, 0);
+	BoVector3Fixed pos2(10 + (i % 10) * 2, 70 + (i / 10) * 2, 0);
+	if (!container.createNewUnitAtTopLeftPos(6, pos1, players.at(0))) {
+		return false;
+	}
+	if (!container.createNewUnitAtTopLeftPos(6, pos2, players.at(1))) {
+		return false;
+	}
+ }
+
+ canvas->setAdvanceWorkerCount(workers);
+ if (canvas->advanceWorkerCount() != workers) {
+	return false;
+ }
+ for (unsigned int advanceCallsCount = 0; advanceCallsCount < advanceCalls; advanceCallsCount++) {
+	canvas->setAdvanceFlag(!canvas->advanceFlag());
+	canvas->slotAdvance(advanceCallsCount);
+ }
+
+ result->mSyncHash = canvas->itemsSyncHash();
+ result->mItemsCount = canvas->allItemsCount();
+ BoItemList* items = canvas->allItems();
+ for (BoItemList::Iterator it = items->begin(); it != items->end(); ++it) {
+	if (!RTTI::isUnit((*it)->rtti())) {
+		continue;
+	}
+	Unit* u = (Unit*)*it;
+	result->mHealth += u->health();
+	if (u->advanceWork() == UnitBase::WorkAttack) {
+		result->mAttackingUnits++;
+	}
+ }
+ return true;
+}
+
+bool CanvasTest::testAdvanceWorkerPool()
+{
+ BosonCanvas* canvas = mCanvasContainer->mCanvas;
+ const unsigned int count = 100;
+ Unit* units[count];
+ for (unsigned int i = 0; i < count; i++) {
+	BoVector3Fixed pos((i % 10) * 3, 60 + (i / 10) * 3, 0);
+	units[i] = mCanvasContainer->createNewUnitAtTopLeftPos(1, pos);
+	MY_VERIFY(units[i] != 0);
+ }
+
+ unsigned int results1[count];
+ unsigned int results8[count];
+ BoAdvanceWorkerPool pool;
+ MY_VERIFY(pool.workerCount() == 1);
+ CountUnitsJob job1(canvas, units, results1);
+ pool.run(&job1, count);
+
+ pool.setWorkerCount(8);
+ MY_VERIFY(pool.workerCount() == 8);
+ // run the job several times, so that the threads are scheduled
+ // differently
+ for (int run = 0; run < 10; run++) {
+	for (unsigned int i = 0; i < count; i++) {
+		results8[i] = 0xffffffff;
+	}
+	CountUnitsJob job8(canvas, units, results8);
+	pool.run(&job8, count);
+	for (unsigned int i = 0; i < count; i++) {
+		MY_VERIFY(results8[i] == results1[i]);
+	}
+ }
+
+ // one index per chunk (used for few, but long calls)
+ pool.setChunkSize(1);
+ MY_VERIFY(pool.chunkSize() == 1);
+ for (unsigned int i = 0; i < count; i++) {
+	results8[i] = 0xffffffff;
+ }
+ CountUnitsJob jobChunk(canvas, units, results8);
+ pool.run(&jobChunk, count);
+ for (unsigned int i = 0; i < count; i++) {
+	MY_VERIFY(results8[i] == results1[i]);
+ }
+ pool.setChunkSize(0);
+ MY_VERIFY(pool.chunkSize() == 1);
+
+ // the canvas must advance with several workers just like with a single
+ // one. the units of the two players are in range of each other, so the
+ // idle units find their targets in the worker threads.
+ AdvanceResult single;
+ AdvanceResult multi;
+ MY_VERIFY(advanceArmedUnits(1, 80, &single));
+ MY_VERIFY(advanceArmedUnits(8, 80, &multi));
+ MY_VERIFY(single.mAttackingUnits > 0);
+ MY_VERIFY(multi.mAttackingUnits == single.mAttackingUnits);
+ MY_VERIFY(multi.mHealth == single.mHealth);
+ MY_VERIFY(multi.mItemsCount == single.mItemsCount);
+ MY_VERIFY(multi.mSyncHash == single.mSyncHash);
+
+ return true;
+}
+
+bool CanvasTest::testItemListArena()
+{
+ BoItemListArena arena;
+ BoItemList* first = arena.allocate();
+ MY_VERIFY(first != 0);
+ first->append(0);
+ const unsigned int mark = arena.mark();
+ MY_VERIFY(mark == 1);
+ BoItemList* second = arena.allocate();
+ second->append(0);
+ for (int i = 0; i < 200; i++) {
+	MY_VERIFY(arena.allocate() != 0);
+ }
+ MY_VERIFY(arena.usedLists() == 202);
+ MY_VERIFY(arena.size() >= 202);
+
+ // the lists after the mark are reused, but are empty again
+ arena.rewind(mark);
+ MY_VERIFY(arena.usedLists() == 1);
+ MY_VERIFY(arena.allocate() == second);
+ MY_VERIFY(second->isEmpty());
+ MY_VERIFY(first->count() == 1);
+
+ // the stack-friendly queries return the same as the arena based ones
+ BosonCanvas* canvas = mCanvasContainer->mCanvas;
+ for (int i = 0; i < 5; i++) {
+	BoVector3Fixed pos(10 + i * 2, 90, 0);
+	MY_VERIFY(mCanvasContainer->createNewUnitAtTopLeftPos(1, pos) != 0);
+ }
+ BoRect2Fixed rect(5, 85, 25, 95);
+ BoItemList* list = canvas->collisions()->collisionsAtCells(rect, 0, false);
+ BoItemList stackList(0, false);
+ canvas->collisions()->collisionsAtCells(rect, 0, false, &stackList);
+ MY_VERIFY(list->count() >= 5);
+ MY_VERIFY(list->count() == stackList.count());
+
+ // an advance call gives back all lists it used
+ BoItemListArena* handlerArena = BoItemListHandler::itemListHandler()->arena();
+ const unsigned int handlerMark = handlerArena->mark();
+ canvas->setAdvanceFlag(!canvas->advanceFlag());
+ canvas->slotAdvance(0);
+ MY_VERIFY(handlerArena->mark() == handlerMark);
+
+ return true;
+}
+
+bool CanvasTest::testEventNames()
+{
+ BoEventManager manager(0);
+ MY_VERIFY(manager.eventNameCount() > 0);
+ MY_VERIFY(manager.eventNameId("NoSuchEvent") == -1);
+ MY_VERIFY(!manager.knowEventName("NoSuchEvent"));
+ for (unsigned int i = 0; i < manager.eventNameCount(); i++) {
+	QCString name = manager.eventName(i);
+	MY_VERIFY(!name.isEmpty());
+	MY_VERIFY(manager.eventNameId(name) == (int)i);
+ }
+ MY_VERIFY(manager.eventNameId("Advance") >= 0);
+ MY_VERIFY(manager.eventNameId("GameOver") != manager.eventNameId("Advance"));
+
+ // events that are given back to the pool are reused, but look like new
+ // events
+ BoEvent* e = BoEvent::create("UnitWithTypeDestroyed", "5");
+ e->setNameId(manager.eventNameId("UnitWithTypeDestroyed"));
+ e->setUnitId(10);
+ e->setDelayedDelivery(20);
+ BoEvent::release(e);
+ BoEvent* e2 = BoEvent::create("GameOver");
+ MY_VERIFY(e2 == e);
+ MY_VERIFY(e2->name() == "GameOver");
+ MY_VERIFY(e2->nameId() == -1);
+ MY_VERIFY(e2->unitId() == 0);
+ MY_VERIFY(e2->delayedDelivery() == 0);
+ MY_VERIFY(e2->data1().isNull());
+
+ // matching uses the name IDs, if they are available
+ BoEvent other("GameOver");
+ e2->setNameId(manager.eventNameId("GameOver"));
+ other.setNameId(manager.eventNameId("Advance"));
+ BoEventMatching m;
+ MY_VERIFY(!e2->matches(&m, &other));
+ other.setNameId(manager.eventNameId("GameOver"));
+ MY_VERIFY(e2->matches(&m, &other));
+ BoEvent::release(e2);
+
+ return true;
+}
+
+bool CanvasTest::testCompactMessages()
+{
+ QValueList<Q_ULONG> ids;
+ ids.append(10);
+ ids.append(11);
+ ids.append(12);
+ ids.append(5);
+ ids.append(1000000);
+ ids.append(1000001);
+ BosonMessageMoveMove move(true, BoVector2Fixed(bofixed(10.5f), bofixed(20.25f)), ids);
+ BosonMessageMoveStop stop(ids);
+
+ BosonMessageBatch batch;
+ MY_VERIFY(batch.append(move) > 0);
+ MY_VERIFY(batch.append(stop) > 0);
+ MY_VERIFY(batch.count() == 2);
+ MY_VERIFY(!batch.isEditor());
+
+ QByteArray buffer;
+ QDataStream write(buffer, IO_WriteOnly);
+ MY_VERIFY(batch.save(write));
+
+ QByteArray uncompressed;
+ QDataStream writeUncompressed(uncompressed, IO_WriteOnly);
+ MY_VERIFY(move.save(writeUncompressed));
+ MY_VERIFY(stop.save(writeUncompressed));
+ MY_VERIFY(buffer.size() < uncompressed.size());
+
+ QDataStream read(buffer, IO_ReadOnly);
+ Q_UINT32 msgid;
+ read >> msgid;
+ MY_VERIFY(msgid == BosonMessageIds::MoveBatch);
+ Q_UINT32 count;
+ MY_VERIFY(BosonMessageBatch::loadHeader(read, &count));
+ MY_VERIFY(count == 2);
+
+ MY_VERIFY(BosonMessage::loadVarUInt(read) == BosonMessageIds::MoveMove);
+ BosonMessageMoveMove move2;
+ MY_VERIFY(move2.loadCompact(read));
+ MY_VERIFY(move2.mIsAttack);
+ MY_VERIFY(move2.mPos.x() == move.mPos.x());
+ MY_VERIFY(move2.mPos.y() == move.mPos.y());
+ MY_VERIFY(move2.mItems == ids);
+
+ MY_VERIFY(BosonMessage::loadVarUInt(read) == BosonMessageIds::MoveStop);
+ BosonMessageMoveStop stop2;
+ MY_VERIFY(stop2.loadCompact(read));
+ MY_VERIFY(stop2.mItems == ids);
+ MY_VERIFY(read.atEnd());
+
+ // height changes must not lose precision
+ QValueVector<Q_UINT32> x;
+ QValueVector<Q_UINT32> y;
+ QValueVector<bofixed> heights;
+ x.append(5);
+ y.append(7);
+ heights.append(bofixed(1.2345f));
+ x.append(4);
+ y.append(8);
+ heights.append(bofixed(-3.5f));
+ BosonMessageEditorMoveChangeHeight height(x, y, heights);
+ QByteArray heightBuffer;
+ QDataStream writeHeight(heightBuffer, IO_WriteOnly);
+ MY_VERIFY(height.saveCompact(writeHeight));
+ QDataStream readHeight(heightBuffer, IO_ReadOnly);
+ BosonMessageEditorMoveChangeHeight height2;
+ MY_VERIFY(height2.loadCompact(readHeight));
+ MY_VERIFY(height2.mCellCornersX == x);
+ MY_VERIFY(height2.mCellCornersY == y);
+ MY_VERIFY(height2.mCellCornersHeight[0] == heights[0]);
+ MY_VERIFY(height2.mCellCornersHeight[1] == heights[1]);
+
+ return true;
+}
+
+static BoMessage* createLogMessage(unsigned int i)
+{
+ QByteArray data;
+ QDataStream stream(data, IO_WriteOnly);
+ stream << (Q_UINT32)i;
+ BoMessage* m = new BoMessage(data, 1000 + i, 1025, 1026, 1, i / 10);
+ m->deliveredOnAdvanceCallsCount = i / 10;
+ return m;
+}
+
+bool CanvasTest::testReplay()
+{
+ const unsigned int count = 250;
+ BoMessageLogger logger;
+ logger.setMaxMessagesInMemory(40);
+ for (unsigned int i = 0; i < count; i++) {
+	logger.append(createLogMessage(i));
+ }
+ MY_VERIFY(logger.messageCount() == count);
+
+ // all messages must be saved, including the spilled messages
+ QByteArray buffer;
+ QBuffer device(buffer);
+ device.open(IO_WriteOnly);
+ MY_VERIFY(logger.saveMessageLog(&device));
+ device.close();
+ QPtrList<BoMessage> messages;
+ messages.setAutoDelete(true);
+ device.open(IO_ReadOnly);
+ MY_VERIFY(BoMessageLogger::loadMessageLog(&device, &messages));
+ device.close();
+ MY_VERIFY(messages.count() == count);
+ for (unsigned int i = 0; i < count; i++) {
+	BoMessage* m = messages.at(i);
+	MY_VERIFY(m->msgid == (int)(1000 + i));
+	MY_VERIFY(m->deliveredOnAdvanceCallsCount == i / 10);
+	QDataStream stream(m->byteArray, IO_ReadOnly);
+	Q_UINT32 value;
+	stream >> value;
+	MY_VERIFY(value == i);
+ }
+ messages.clear();
+
+ // the most recent messages only (e.g. for the sync log)
+ QByteArray recentBuffer;
+ QBuffer recentDevice(recentBuffer);
+ recentDevice.open(IO_WriteOnly);
+ MY_VERIFY(logger.saveMessageLog(&recentDevice, 100));
+ recentDevice.close();
+ recentDevice.open(IO_ReadOnly);
+ MY_VERIFY(BoMessageLogger::loadMessageLog(&recentDevice, &messages));
+ recentDevice.close();
+ MY_VERIFY(messages.count() == 100);
+ MY_VERIFY(messages.getFirst()->msgid == (int)(1000 + count - 100));
+ messages.clear();
+
+ QPtrList<BoReplayKeyframe> keyframes;
+ keyframes.setAutoDelete(true);
+ for (unsigned int i = 1; i <= 3; i++) {
+	BoReplayKeyframe* keyframe = new BoReplayKeyframe();
+	keyframe->advanceCallsCount = i * 5;
+	keyframe->messageIndex = i * 50;
+	keyframe->randomSeed = i;
+	keyframe->playerIds.insert(1025, 128);
+	QMap<QString, QByteArray> files;
+	files.insert("kgame.xml", QCString("<Boson/>"));
+	keyframe->compressedFiles = qCompress(BPFLoader::streamFiles(files));
+	keyframes.append(keyframe);
+ }
+ QByteArray replayBuffer;
+ QBuffer replayDevice(replayBuffer);
+ replayDevice.open(IO_WriteOnly);
+ MY_VERIFY(BoReplay::saveReplay(&replayDevice, &logger, keyframes));
+ replayDevice.close();
+
+ QPtrList<BoReplayKeyframe> keyframes2;
+ keyframes2.setAutoDelete(true);
+ replayDevice.open(IO_ReadOnly);
+ MY_VERIFY(BoReplay::loadKeyframes(&replayDevice, &keyframes2));
+ MY_VERIFY(keyframes2.count() == 3);
+ MY_VERIFY(BoReplay::findKeyframe(keyframes2, 4) == 0);
+ BoReplayKeyframe* keyframe = BoReplay::findKeyframe(keyframes2, 12);
+ MY_VERIFY(keyframe != 0);
+ MY_VERIFY(keyframe->advanceCallsCount == 10);
+ MY_VERIFY(keyframe->randomSeed == 2);
+ MY_VERIFY(keyframe->playerIds[1025] == 128);
+ QMap<QString, QByteArray> files;
+ MY_VERIFY(keyframe->files(files));
+ MY_VERIFY(files.contains("kgame.xml"));
+
+ // the replay starts at the message after the keyframe
+ MY_VERIFY(BoMessageLogger::loadMessageLog(&replayDevice, &messages, keyframe->messageIndex));
+ replayDevice.close();
+ MY_VERIFY(messages.count() == count - 100);
+ MY_VERIFY(messages.getFirst()->msgid == 1100);
+
+ QMap<Q_UINT32, Q_UINT32> oldToNew;
+ oldToNew.insert(1025, 2049);
+ BoReplay::mapPlayerIds(&messages, oldToNew);
+ MY_VERIFY(messages.getFirst()->receiver == 2049);
+ MY_VERIFY(messages.getFirst()->sender == 1026);
+
+ return true;
+}
+
+/**
+ * Advance @p canvas from advance call @p first up to (but not including) @p
+ * last.
+ **/
+static void advanceCanvas(BosonCanvas* canvas, unsigned int first, unsigned int last)
+{
+ for (unsigned int advanceCallsCount = first; advanceCallsCount < last; advanceCallsCount++) {
+	canvas->setAdvanceFlag(!canvas->advanceFlag());
+	canvas->slotAdvance(advanceCallsCount);
+ }
+}
+
+bool CanvasTest::testReplaySeek()
+{
+ // a replay that is started at a keyframe must continue exactly like the
+ // game (or a replay from the beginning). the keyframe is taken while units
+ // wait for their paths and the pathfinder has cached paths.
+ const unsigned int keyframeAdvanceCall = 12;
+ const unsigned int lastAdvanceCall = 150;
+ const unsigned int nodeBudget = 200;
+
+ CanvasContainer game;
+ MY_VERIFY(game.createCanvas("dummy_theme_ID"));
+ game.mCanvas->loadCanvas(BosonCanvas::emptyCanvasFile(0));
+ game.mCanvas->pathFinder()->setNodeBudget(nodeBudget);
+ for (unsigned int i = 0; i < 40; i++) {
+	BoVector3Fixed pos(10 + (i % 8) * 2, 10 + (i / 8) * 2, 0);
+	Unit* u = game.createNewUnitAtTopLeftPos(1, pos);
+	MY_VERIFY(u != 0);
+	UnitMoveOrder* order;
+	if (i < 25) {
+		// a big group, which uses a flow field
+		order = new UnitMoveOrder(BoVector2Fixed(60, 80));
+		order->setGroupSize(25);
+	} else {
+		order = new UnitMoveOrder(BoVector2Fixed(70 - i, 20 + i));
+	}
+	MY_VERIFY(u->replaceToplevelOrders(order));
+ }
+ advanceCanvas(game.mCanvas, 0, keyframeAdvanceCall);
+
+ // this is what Boson does on all clients when a keyframe is taken
+ game.mCanvas->pathFinder()->flushPathRequests();
+ MY_VERIFY(game.mCanvas->pathFinder()->pendingPathRequests() == 0);
+ MY_VERIFY(game.mCanvas->pathFinder()->flowFieldCount() == 0);
+ QByteArray keyframe = game.mCanvas->saveCanvasBinary();
+ MY_VERIFY(!keyframe.isEmpty());
+ const Q_UINT64 keyframeHash = game.mCanvas->itemsSyncHash();
+
+ CanvasContainer replay;
+ MY_VERIFY(replay.createCanvas("dummy_theme_ID"));
+ MY_VERIFY(replay.mCanvas->loadFromBinary(keyframe));
+ replay.mCanvas->pathFinder()->setNodeBudget(nodeBudget);
+ replay.mCanvas->setAdvanceFlag(game.mCanvas->advanceFlag());
+ MY_VERIFY(replay.mCanvas->itemsSyncHash() == keyframeHash);
+
+ advanceCanvas(game.mCanvas, keyframeAdvanceCall, lastAdvanceCall);
+ advanceCanvas(replay.mCanvas, keyframeAdvanceCall, lastAdvanceCall);
+ MY_VERIFY(game.mCanvas->itemsSyncHash() != keyframeHash);
+ MY_VERIFY(replay.mCanvas->allItemsCount() == game.mCanvas->allItemsCount());
+ MY_VERIFY(replay.mCanvas->itemsSyncHash() == game.mCanvas->itemsSyncHash());
+
+ return true;
+}
+
+bool CanvasTest::testUpgradeableProperties()
+{
+ int healthKey = BoUpgradeablePropertyKey::key("Health");
+ MY_VERIFY(healthKey >= 0);
+ MY_VERIFY(BoUpgradeablePropertyKey::key("Health", "MaxValue") == healthKey);
+ MY_VERIFY(BoUpgradeablePropertyKey::key("Health", "MinValue") != healthKey);
+ MY_VERIFY(BoUpgradeablePropertyKey::key("Armor") != healthKey);
+ MY_VERIFY(BoUpgradeablePropertyKey::key("Health", "InvalidType") == -1);
+ MY_VERIFY(BoUpgradeablePropertyKey::name(healthKey) == "Health");
+ MY_VERIFY(BoUpgradeablePropertyKey::type(healthKey) == "MaxValue");
+ MY_VERIFY(BoUpgradeablePropertyKey::type(BoUpgradeablePropertyKey::key("Health", "MinValue")) == "MinValue");
+ MY_VERIFY(healthKey < BoUpgradeablePropertyKey::keyCount());
+
+ BoBaseValueCollection base;
+ MY_VERIFY(base.insertULongBaseValue(100, "Health"));
+ MY_VERIFY(base.insertULongBaseValue(10, "Armor"));
+ MY_VERIFY(base.insertLongBaseValue(-5, "Weapon_0:Damage"));
+ MY_VERIFY(!base.insertULongBaseValue(10, "Armor", "InvalidType"));
+ MY_VERIFY(base.ulongBaseValue("Health") == 100);
+ MY_VERIFY(base.ulongBaseValue("DoesNotExist", "MaxValue", 42) == 42);
+ bofixed fixedDamage = 0;
+ MY_VERIFY(base.getBaseValue(&fixedDamage, BoUpgradeablePropertyKey::key("Weapon_0:Damage")));
+ MY_VERIFY(fixedDamage == bofixed(-5));
+
+ // the data type of a base value is not changed when it is replaced
+ MY_VERIFY(base.insertBoFixedBaseValue(20.75f, "Armor"));
+ MY_VERIFY(base.bofixedBaseValue("Armor") == bofixed(20));
+
+ BoUpgradeableProperty<unsigned long int> health(&base, "Health");
+ BoUpgradeableProperty<unsigned long int> health2(&base, health.key());
+ BoUpgradeableProperty<unsigned long int> armor(&base, "Armor");
+ BoUpgradeableProperty<long int> damage(&base, "Weapon_0:Damage");
+ MY_VERIFY(health.name() == "Health");
+ MY_VERIFY(health.type() == "MaxValue");
+ MY_VERIFY(health2.key() == health.key());
+
+ BoUpgradesCollection upgrades;
+ MY_VERIFY(health.value(upgrades) == 100);
+ MY_VERIFY(armor.value(upgrades) == 20);
+
+ KTempFile file;
+ file.setAutoDelete(true);
+ QTextStream* stream = file.textStream();
+ MY_VERIFY(stream != 0);
+ *stream << "[Upgrade]\n";
+ *stream << "Id=1\n";
+ *stream << "Health=150\n";
+ *stream << "Armor=200%\n";
+ *stream << "Weapon_0:Damage=30\n";
+ MY_VERIFY(file.close());
+ KSimpleConfig config(file.name(), true);
+ UpgradeProperties upgrade("Technology", 0);
+ MY_VERIFY(upgrade.load(&config, "Upgrade"));
+ MY_VERIFY(upgrade.id() == 1);
+
+ unsigned long int v = 100;
+ MY_VERIFY(upgrade.upgradeValue("Health", &v));
+ MY_VERIFY(v == 150);
+ v = 10;
+ MY_VERIFY(upgrade.upgradeValue(BoUpgradeablePropertyKey::key("Armor"), &v));
+ MY_VERIFY(v == 20);
+ v = 10;
+ MY_VERIFY(upgrade.upgradeValue(BoUpgradeablePropertyKey::key("SightRange"), &v));
+ MY_VERIFY(v == 10);
+ MY_VERIFY(!upgrade.upgradeValue(BoUpgradeablePropertyKey::key("Health", "MinValue"), &v));
+
+ upgrades.addUpgrade(&upgrade);
+ MY_VERIFY(health.value(upgrades) == 150);
+ MY_VERIFY(armor.value(upgrades) == 40);
+ MY_VERIFY(damage.value(upgrades) == 30);
+
+ // a second object of the same property uses the value that has already
+ // been calculated by the base value collection
+ BoUpgradesCollection upgrades2;
+ upgrades2.addUpgrade(&upgrade);
+ MY_VERIFY(health2.value(upgrades2) == 150);
+
+ upgrades.removeUpgrade(&upgrade);
+ MY_VERIFY(health.value(upgrades) == 100);
+ MY_VERIFY(armor.value(upgrades) == 20);
+ MY_VERIFY(health2.value(upgrades2) == 150);
+
+ // replacing the base value must not re-use the previously upgraded value
+ MY_VERIFY(base.insertULongBaseValue(10, "Armor"));
+ upgrades.addUpgrade(&upgrade);
+ MY_VERIFY(armor.value(upgrades) == 20);
+
+ return true;
+}
+
+static const BoCanvasQuadTreeNode* findQuadTreeLeaf(const BoCanvasQuadTreeNode* node, int x, int y)
+{
+ while (node && (node->left() != node->right() || node->top() != node->bottom())) {
+	BoQuadTreeNode* children[4];
+	node->getChildren(children);
+	const BoCanvasQuadTreeNode* next = 0;
+	for (int i = 0; i < 4; i++) {
+		if (children[i] && children[i]->intersects(x, y, x, y)) {
+			next = (const BoCanvasQuadTreeNode*)children[i];
+			break;
+		}
+	}
+	node = next;
+ }
+ return node;
+}
+
+bool CanvasTest::testCanvasQuadTree()
+{
+ BosonCanvas* canvas = mCanvasContainer->mCanvas;
+ BosonMap* map = canvas->map();
+ MY_VERIFY(map != 0);
+
+ BoCanvasQuadTreeNode* root = BoCanvasQuadTreeNode::createTree(map->width(), map->height());
+ canvas->registerQuadTree(root);
+ map->registerQuadTree(root);
+ root->cellHeightChanged(map, 0, 0, map->width() - 1, map->height() - 1);
+ root->cellUnitsChanged(canvas, 0, 0, map->width() - 1, map->height() - 1);
+
+ // place the unit at the center of the map, so that it covers cells of all
+ // children of the root
+ const int centerX = map->width() / 2;
+ const int centerY = map->height() / 2;
+ Unit* unit = mCanvasContainer->createNewUnitAtTopLeftPos(1, BoVector3Fixed(centerX - 0.5, centerY - 0.5, 0.0));
+ MY_VERIFY(unit != 0);
+
+ // moving the unit up must update all nodes that contain one of its cells
+ unit->moveBy(0.0, 0.0, 5.0);
+ const float unitBottom = unit->z();
+ const float unitTop = unit->z() + unit->depth();
+ MY_VERIFY(unitBottom >= 5.0f);
+
+ BoQuadTreeNode* children[4];
+ root->getChildren(children);
+ for (int i = 0; i < 4; i++) {
+	MY_VERIFY(children[i] != 0);
+	const BoCanvasQuadTreeNode* child = (const BoCanvasQuadTreeNode*)children[i];
+	MY_VERIFY(child->unitMaxZ() >= unitTop);
+	MY_VERIFY(child->maxZ() >= unitTop);
+ }
+ MY_VERIFY(root->unitMaxZ() >= unitTop);
+
+ const BoCanvasQuadTreeNode* leaf = findQuadTreeLeaf(root, centerX, centerY);
+ MY_VERIFY(leaf != 0);
+ MY_VERIFY(leaf->unitMinZ() <= unitBottom);
+ MY_VERIFY(leaf->unitMaxZ() >= unitTop);
+
+ delete root;
+ return true;
+}
+
+/**
+ * @return A frustum of an orthographic view from above onto the cells @p x1
+ * to @p x2 and @p y1 to @p y2.
+ **/
+static BoFrustum createTopDownFrustum(float x1, float y1, float x2, float y2)
+{
+ // world coordinates use negative y values
+ const float left = x1;
+ const float right = x2;
+ const float bottom = -y2;
+ const float top = -y1;
+ const float zNear = -100.0f;
+ const float zFar = 100.0f;
+ BoMatrix projection;
+ projection.setElement(0, 0, 2.0f / (right - left));
+ projection.setElement(1, 1, 2.0f / (top - bottom));
+ projection.setElement(2, 2, -2.0f / (zFar - zNear));
+ projection.setElement(0, 3, -(right + left) / (right - left));
+ projection.setElement(1, 3, -(top + bottom) / (top - bottom));
+ projection.setElement(2, 3, -(zFar + zNear) / (zFar - zNear));
+ BoMatrix modelview;
+ BoFrustum frustum;
+ frustum.loadViewFrustum(modelview, projection);
+ return frustum;
+}
+
+static unsigned int culledItemCount(const QValueVector<BoCulledItem>& items, const BosonItem* item, BoCulledItem* culled)
+{
+ unsigned int count = 0;
+ for (unsigned int i = 0; i < items.count(); i++) {
+	if (items[i].item == item) {
+		*culled = items[i];
+		count++;
+	}
+ }
+ return count;
+}
+
+bool CanvasTest::testItemFrustumCuller()
+{
+ CanvasContainer container;
+ if (!container.createCanvas("dummy_theme_ID")) {
+	return false;
+ }
+ BosonCanvas* canvas = container.mCanvas;
+ canvas->loadCanvas(BosonCanvas::emptyCanvasFile(0));
+
+ BoItemFrustumCuller culler;
+ culler.setCanvas(canvas);
+
+ // the first unit covers several cells
+ Unit* near = container.createNewUnitAtTopLeftPos(1, BoVector3Fixed(16.5, 16.5, 0.0));
+ Unit* far = container.createNewUnitAtTopLeftPos(1, BoVector3Fixed(60.0, 150.0, 0.0));
+ MY_VERIFY(near != 0);
+ MY_VERIFY(far != 0);
+ MY_VERIFY(near->cells()->count() > 1);
+
+ QValueVector<BoCulledItem> items;
+ BoCulledItem culled;
+ culler.cullNodes(createTopDownFrustum(-8.0f, -8.0f, 40.0f, 40.0f));
+ MY_VERIFY(culler.acceptedNodes() > 0);
+ culler.collectItems(&items);
+ MY_VERIFY(culledItemCount(items, near, &culled) == 1);
+ MY_VERIFY(culled.node != 0);
+ MY_VERIFY(culled.nodeVisibility == BoItemFrustumCuller::CompletelyVisible);
+ MY_VERIFY(culledItemCount(items, far, &culled) == 0);
+
+ // the items of a rejected node are never collected, so the culler does not
+ // need to look at every item
+ MY_VERIFY(items.count() < canvas->allItemsCount());
+
+ BoVector3Float center((float)near->centerX(),
+		(float)-near->centerY(),
+		(float)(near->z() + near->depth() / 2));
+ MY_VERIFY(culledItemCount(items, near, &culled) == 1);
+ MY_VERIFY(BoItemFrustumCuller::itemVisibility(culled, center, 1.0f) == BoItemFrustumCuller::CompletelyVisible);
+ // a sphere that is larger than its node must be tested on its own
+ MY_VERIFY(BoItemFrustumCuller::itemVisibility(culled, center, 50.0f) == BoItemFrustumCuller::PartiallyVisible);
+
+ // a view onto the other unit only
+ culler.cullNodes(createTopDownFrustum(50.0f, 140.0f, 70.0f, 160.0f));
+ culler.collectItems(&items);
+ MY_VERIFY(culledItemCount(items, near, &culled) == 0);
+ MY_VERIFY(culledItemCount(items, far, &culled) == 1);
+
+ // nothing is visible
+ culler.cullNodes(createTopDownFrustum(-50.0f, -50.0f, -20.0f, -20.0f));
+ culler.collectItems(&items);
+ MY_VERIFY(items.count() == 0);
+
+ return true;
+}
+
+bool CanvasTest::testFlowFieldPaths()
+{
+ BosonPath* pathFinder = mCanvasContainer->mCanvas->pathFinder();
+ MY_VERIFY(pathFinder != 0);
+ const int unitType = 1; // UnitProperties ID
+
+ Unit* unit = mCanvasContainer->createNewUnitAtTopLeftPos(unitType, BoVector3Fixed(10.0, 80.0, 0.0));
+ MY_VERIFY(unit != 0);
+
+ // a unit is standing at the destination, so the paths can't end there
+ Unit* blocker = mCanvasContainer->createNewUnitAtTopLeftPos(unitType, BoVector3Fixed(40.0, 80.0, 0.0));
+ MY_VERIFY(blocker != 0);
+ const BoVector2Fixed dest(blocker->centerX(), blocker->centerY());
+
+ // the path of a single unit, using the normal search
+ BosonPathInfo single;
+ single.unit = unit;
+ single.start = BoVector2Fixed(unit->centerX(), unit->centerY());
+ single.dest = dest;
+ pathFinder->findPath(&single);
+ MY_VERIFY(single.result == BosonPath::GoalReached);
+ MY_VERIFY(single.llpath.count() > 0);
+
+ // the path of the same unit as a member of a big group, using a flow field
+ const unsigned int flowFields = pathFinder->flowFieldCount();
+ BosonPathInfo group;
+ group.unit = unit;
+ group.start = single.start;
+ group.dest = dest;
+ group.groupsize = 100;
+ pathFinder->findPath(&group);
+ MY_VERIFY(pathFinder->flowFieldCount() == flowFields + 1);
+ MY_VERIFY(group.result == single.result);
+ MY_VERIFY(group.llpath.count() > 0);
+
+ // both paths must end at the same distance from the occupied destination
+ const BoVector2Fixed singleEnd = single.llpath[single.llpath.count() - 1];
+ const BoVector2Fixed groupEnd = group.llpath[group.llpath.count() - 1];
+ const int singleDist = QMAX(QABS((int)singleEnd.x() - (int)dest.x()), QABS((int)singleEnd.y() - (int)dest.y()));
+ const int groupDist = QMAX(QABS((int)groupEnd.x() - (int)dest.x()), QABS((int)groupEnd.y() - (int)dest.y()));
+ MY_VERIFY(singleDist > 0);
+ MY_VERIFY(groupDist == singleDist);
+
+ // mobile units that start or stop inside of the field are ignored by the
+ // field, so it is kept
+ Unit* unit2 = mCanvasContainer->createNewUnitAtTopLeftPos(unitType, BoVector3Fixed(20.0, 90.0, 0.0));
+ MY_VERIFY(unit2 != 0);
+ MY_VERIFY(!unit2->isFacility());
+ MY_VERIFY(pathFinder->flowFieldCount() == flowFields + 1);
+
+ // a facility inside of the field makes the field outdated
+ const int facilityType = 2; // UnitProperties ID
+ Unit* facility = mCanvasContainer->createNewUnitAtTopLeftPos(facilityType, BoVector3Fixed(20.0, 70.0, 0.0));
+ MY_VERIFY(facility != 0);
+ MY_VERIFY(facility->isFacility());
+ MY_VERIFY(pathFinder->flowFieldCount() == flowFields);
+
+ return true;
+}
+
@@ -47,6 +47,19 @@ protected:
 	bool testCreateNewCanvas();
 	bool testSaveLoadCanvas();
 	bool testMoveUnits();
+	bool testFogOfWar();
+	bool testAdvanceWorkerPool();
+	bool testItemListArena();
+	bool testEventNames();
+	bool testCompactMessages();
+	bool testSyncHash();
+	bool testBinaryCanvas();
+	bool testReplay();
+	bool testReplaySeek();
+	bool testUpgradeableProperties();
+	bool testCanvasQuadTree();
+	bool testItemFrustumCuller();
+	bool testFlowFieldPaths();
 
 	bool checkIfCanvasIsValid(BosonCanvas* canvas);
 	bool checkIfCanvasAreEqual(BosonCanvas* canvas1, BosonCanvas* canvas2);
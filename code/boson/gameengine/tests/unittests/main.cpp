@@ -33,6 +33,7 @@
 #include "movetest.h"
 #include "constructiontest.h"
 #include "productiontest.h"
+#include "startingtest.h"
 
 #include <kaboutdata.h>
 #include <kcmdlineargs.h>
@@ -93,6 +94,7 @@ static bool startTests()
  ADD_TEST(MoveTest);
  ADD_TEST(ConstructionTest);
  ADD_TEST(ProductionTest);
+ ADD_TEST(StartingTest);
 
  return true;
 }
@@ -33,6 +33,7 @@
 #include "unit.h"
 #include "unitorder.h"
 #include "cell.h"
+#include "bosonpath.h"
 #include "bo3dtools.h"
 
 // FIXME: is "MoveTest" a good name? it suggests BosonItem::move() is being
@@ -82,6 +83,8 @@ bool MoveTest::test()
  cleanupTest();
 
  DO_TEST(testMove());
+ DO_TEST(testPathCache());
+ DO_TEST(testPathRequests());
 
  return true;
 }
@@ -145,3 +148,108 @@ boDebug() << debugStringVector(unitMoveWithObstaclePos) << endl;
  return true;
 }
 
+bool MoveTest::testPathCache()
+{
+ boDebug() << k_funcinfo << endl;
+ int unitType1 = 1; // UnitProperties ID
+
+ BosonPath* pathFinder = mCanvasContainer->mCanvas->pathFinder();
+ MY_VERIFY(pathFinder != 0);
+
+ Unit* unit = mCanvasContainer->createNewUnitAtTopLeftPos(unitType1, BoVector3Fixed(10.0, 10.0, 0.0));
+ MY_VERIFY(unit != 0);
+
+ // the destination must be far enough away for the high-level pathfinder to
+ // be used
+ BosonPathInfo info1;
+ info1.unit = unit;
+ info1.start = BoVector2Fixed(unit->centerX(), unit->centerY());
+ info1.dest = BoVector2Fixed(15.0, 150.0);
+ pathFinder->findPath(&info1);
+ MY_VERIFY(info1.result != BosonPath::NoPath);
+ MY_VERIFY(info1.hlpath.count() > 0);
+
+ unsigned int hits = pathFinder->highLevelCacheHits();
+
+ // the same query again must be answered by the cache and must result in the
+ // same route
+ BosonPathInfo info2;
+ info2.unit = unit;
+ info2.start = info1.start;
+ info2.dest = info1.dest;
+ pathFinder->findPath(&info2);
+ MY_VERIFY(pathFinder->highLevelCacheHits() == hits + 1);
+ MY_VERIFY(info2.hlpath.count() == info1.hlpath.count());
+ for (unsigned int i = 0; i < info1.hlpath.count(); i++) {
+	MY_VERIFY(info2.hlpath[i] == info1.hlpath[i]);
+ }
+ MY_VERIFY(info2.result == info1.result);
+
+ // a unit that stops on the route invalidates the cached route
+ Unit* blocker = mCanvasContainer->createNewUnitAtTopLeftPos(unitType1, BoVector3Fixed(info1.hlpath[0].x(), info1.hlpath[0].y(), 0.0));
+ MY_VERIFY(blocker != 0);
+ unsigned int misses = pathFinder->highLevelCacheMisses();
+ BosonPathInfo info3;
+ info3.unit = unit;
+ info3.start = info1.start;
+ info3.dest = info1.dest;
+ pathFinder->findPath(&info3);
+ MY_VERIFY(pathFinder->highLevelCacheMisses() == misses + 1);
+
+ return true;
+}
+
+bool MoveTest::testPathRequests()
+{
+ boDebug() << k_funcinfo << endl;
+ int unitType1 = 1; // UnitProperties ID
+
+ BosonPath* pathFinder = mCanvasContainer->mCanvas->pathFinder();
+ MY_VERIFY(pathFinder != 0);
+ unsigned int oldBudget = pathFinder->nodeBudget();
+
+ Unit* unit = mCanvasContainer->createNewUnitAtTopLeftPos(unitType1, BoVector3Fixed(10.0, 80.0, 0.0));
+ MY_VERIFY(unit != 0);
+
+ BosonPathInfo info1;
+ info1.unit = unit;
+ info1.start = BoVector2Fixed(unit->centerX(), unit->centerY());
+ info1.dest = BoVector2Fixed(30.0, 80.0);
+ BosonPathInfo info2 = info1;
+ info2.dest = BoVector2Fixed(30.0, 90.0);
+ BosonPathInfo* info3 = new BosonPathInfo(info1);
+
+ pathFinder->requestPath(&info1);
+ pathFinder->requestPath(&info2);
+ pathFinder->requestPath(info3);
+ MY_VERIFY(pathFinder->pendingPathRequests() == 3);
+ MY_VERIFY(info1.pathrequest == BosonPath::RequestPending);
+
+ // a deleted pathinfo must leave the queue
+ delete info3;
+ MY_VERIFY(pathFinder->pendingPathRequests() == 2);
+
+ // with a tiny budget only one request is answered per advance call, in the
+ // order they were made
+ pathFinder->setNodeBudget(1);
+ pathFinder->advance();
+ MY_VERIFY(info1.pathrequest == BosonPath::RequestDone);
+ MY_VERIFY(info1.result != BosonPath::None);
+ MY_VERIFY(info2.pathrequest == BosonPath::RequestPending);
+ pathFinder->advance();
+ MY_VERIFY(info2.pathrequest == BosonPath::RequestDone);
+ MY_VERIFY(pathFinder->pendingPathRequests() == 0);
+
+ // the result must be the same as of a direct search
+ BosonPathInfo info4;
+ info4.unit = unit;
+ info4.start = info1.start;
+ info4.dest = info1.dest;
+ pathFinder->findPath(&info4);
+ MY_VERIFY(info4.result == info1.result);
+ MY_VERIFY(info4.llpath.count() == info1.llpath.count());
+
+ pathFinder->setNodeBudget(oldBudget);
+ return true;
+}
+
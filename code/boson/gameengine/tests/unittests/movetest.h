@@ -45,6 +45,8 @@ protected:
 	void cleanupTest();
 
 	bool testMove();
+	bool testPathCache();
+	bool testPathRequests();
 
 private:
 	CanvasContainer* mCanvasContainer;
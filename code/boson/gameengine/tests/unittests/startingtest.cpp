@@ -0,0 +1,269 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "startingtest.h"
+#include "startingtest.moc"
+
+#include "testframework.h"
+
+#include "bodebug.h"
+#include "boglobal.h"
+#include "bosonstarting.h"
+
+#include <qptrlist.h>
+#include <qvaluevector.h>
+
+/**
+ * A task that does nothing but remember when it was prepared and started.
+ * The "events" counter is increased by @ref beginPrepare and @ref startTask,
+ * both are called by the main thread.
+ **/
+class TestStartingTask : public BosonStartingTask
+{
+public:
+	TestStartingTask(const QString& text, unsigned int parts, int* events)
+		: BosonStartingTask(text)
+	{
+		mPartCount = parts;
+		mEvents = events;
+		mBeginPrepareEvent = -1;
+		mStartEvent = -1;
+		mPreparedOnStart = false;
+		mFailPrepare = false;
+	}
+
+	virtual unsigned int taskDuration() const
+	{
+		return 10;
+	}
+
+	virtual unsigned int beginPrepare()
+	{
+		mBeginPrepareEvent = (*mEvents)++;
+		mPartsDone.resize(mPartCount);
+		for (unsigned int i = 0; i < mPartCount; i++) {
+			mPartsDone[i] = false;
+		}
+		return mPartCount;
+	}
+
+	virtual bool preparePart(unsigned int part)
+	{
+		// called by a worker thread. every part writes to its own
+		// entry only.
+		mPartsDone[part] = true;
+		return !mFailPrepare;
+	}
+
+	int mBeginPrepareEvent;
+	int mStartEvent;
+	bool mPreparedOnStart;
+	bool mFailPrepare;
+
+protected:
+	virtual bool startTask()
+	{
+		mStartEvent = (*mEvents)++;
+		mPreparedOnStart = (mBeginPrepareEvent >= 0);
+		for (unsigned int i = 0; i < mPartsDone.count(); i++) {
+			if (!mPartsDone[i]) {
+				mPreparedOnStart = false;
+			}
+		}
+		return true;
+	}
+
+private:
+	unsigned int mPartCount;
+	int* mEvents;
+	QValueVector<bool> mPartsDone;
+};
+
+/**
+ * Makes @ref BosonStarting::executeTasks available to the test.
+ **/
+class TestStarting : public BosonStarting
+{
+public:
+	TestStarting()
+		: BosonStarting(0)
+	{
+	}
+
+	bool execute(const QPtrList<BosonStartingTask>& tasks)
+	{
+		return executeTasks(tasks);
+	}
+};
+
+StartingTest::StartingTest(QObject* parent)
+	: QObject(parent)
+{
+}
+
+StartingTest::~StartingTest()
+{
+}
+
+bool StartingTest::initTest()
+{
+ return true;
+}
+
+void StartingTest::cleanupTest()
+{
+}
+
+bool StartingTest::test()
+{
+ BoGlobal::initStatic();
+
+ cleanupTest();
+
+ DO_TEST(testResolveDependencies());
+ DO_TEST(testExecuteTasks());
+ DO_TEST(testPrepareFailure());
+
+ return true;
+}
+
+bool StartingTest::testResolveDependencies()
+{
+ int events = 0;
+ QPtrList<BosonStartingTask> tasks;
+ tasks.setAutoDelete(true);
+ TestStartingTask* playField = new TestStartingTask("PlayField", 0, &events);
+ playField->addProvidedResource("PlayField");
+ tasks.append(playField);
+ TestStartingTask* canvas = new TestStartingTask("Canvas", 0, &events);
+ canvas->addProvidedResource("Canvas");
+ tasks.append(canvas);
+ TestStartingTask* implicit = new TestStartingTask("Implicit", 0, &events);
+ tasks.append(implicit);
+ TestStartingTask* tiles = new TestStartingTask("Tiles", 0, &events);
+ tiles->addRequiredResource("PlayField");
+ tasks.append(tiles);
+ TestStartingTask* both = new TestStartingTask("Both", 0, &events);
+ both->addRequiredResource("Canvas");
+ both->addRequiredResource("PlayField");
+ tasks.append(both);
+ TestStartingTask* independent = new TestStartingTask("Independent", 0, &events);
+ independent->setDependsOnPreviousTasks(false);
+ tasks.append(independent);
+
+ QValueVector<int> lastDependency;
+ MY_VERIFY(BosonStarting::resolveDependencies(tasks, &lastDependency) == true);
+ MY_VERIFY(lastDependency.count() == tasks.count());
+
+ // tasks without required resources depend on all previous tasks
+ MY_VERIFY(lastDependency[0] == -1);
+ MY_VERIFY(lastDependency[1] == 0);
+ MY_VERIFY(lastDependency[2] == 1);
+
+ // tasks with required resources depend on the providers only
+ MY_VERIFY(lastDependency[3] == 0);
+ MY_VERIFY(lastDependency[4] == 1);
+
+ MY_VERIFY(lastDependency[5] == -1);
+
+ // a resource that is not provided at all
+ TestStartingTask* missing = new TestStartingTask("Missing", 0, &events);
+ missing->addRequiredResource("Water");
+ tasks.append(missing);
+ MY_VERIFY(BosonStarting::resolveDependencies(tasks, &lastDependency) == false);
+ tasks.removeLast();
+
+ // a resource that is provided by a later task only
+ TestStartingTask* early = new TestStartingTask("Early", 0, &events);
+ early->addRequiredResource("Late");
+ tasks.append(early);
+ TestStartingTask* late = new TestStartingTask("Late", 0, &events);
+ late->addProvidedResource("Late");
+ tasks.append(late);
+ MY_VERIFY(BosonStarting::resolveDependencies(tasks, &lastDependency) == false);
+
+ return true;
+}
+
+bool StartingTest::testExecuteTasks()
+{
+ int events = 0;
+ QPtrList<BosonStartingTask> tasks;
+ tasks.setAutoDelete(true);
+ TestStartingTask* playField = new TestStartingTask("PlayField", 2, &events);
+ playField->addProvidedResource("PlayField");
+ tasks.append(playField);
+ TestStartingTask* implicit = new TestStartingTask("Implicit", 2, &events);
+ tasks.append(implicit);
+ TestStartingTask* tiles = new TestStartingTask("Tiles", 5, &events);
+ tiles->addRequiredResource("PlayField");
+ tasks.append(tiles);
+ TestStartingTask* independent = new TestStartingTask("Independent", 3, &events);
+ independent->setDependsOnPreviousTasks(false);
+ tasks.append(independent);
+
+ TestStarting starting;
+ MY_VERIFY(starting.execute(tasks) == true);
+
+ // all tasks are started in order, after they have been prepared
+ MY_VERIFY(playField->mStartEvent >= 0);
+ MY_VERIFY(implicit->mStartEvent > playField->mStartEvent);
+ MY_VERIFY(tiles->mStartEvent > implicit->mStartEvent);
+ MY_VERIFY(independent->mStartEvent > tiles->mStartEvent);
+ MY_VERIFY(playField->mPreparedOnStart == true);
+ MY_VERIFY(implicit->mPreparedOnStart == true);
+ MY_VERIFY(tiles->mPreparedOnStart == true);
+ MY_VERIFY(independent->mPreparedOnStart == true);
+
+ // the preparation of a task starts before the tasks that it does not
+ // depend on are started
+ MY_VERIFY(independent->mBeginPrepareEvent < playField->mStartEvent);
+ MY_VERIFY(tiles->mBeginPrepareEvent < implicit->mStartEvent);
+ MY_VERIFY(tiles->mBeginPrepareEvent > playField->mStartEvent);
+
+ // the implicit dependency: prepared once the previous task is completed
+ MY_VERIFY(implicit->mBeginPrepareEvent > playField->mStartEvent);
+
+ return true;
+}
+
+bool StartingTest::testPrepareFailure()
+{
+ int events = 0;
+ QPtrList<BosonStartingTask> tasks;
+ tasks.setAutoDelete(true);
+ TestStartingTask* playField = new TestStartingTask("PlayField", 1, &events);
+ playField->addProvidedResource("PlayField");
+ tasks.append(playField);
+ TestStartingTask* tiles = new TestStartingTask("Tiles", 4, &events);
+ tiles->addRequiredResource("PlayField");
+ tiles->mFailPrepare = true;
+ tasks.append(tiles);
+ TestStartingTask* last = new TestStartingTask("Last", 1, &events);
+ tasks.append(last);
+
+ TestStarting starting;
+ MY_VERIFY(starting.execute(tasks) == false);
+ MY_VERIFY(playField->mStartEvent >= 0);
+ MY_VERIFY(tiles->mStartEvent == -1);
+ MY_VERIFY(last->mStartEvent == -1);
+
+ return true;
+}
+
@@ -0,0 +1,44 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef STARTINGTEST_H
+#define STARTINGTEST_H
+
+#include <qobject.h>
+
+class StartingTest : public QObject
+{
+	Q_OBJECT
+public:
+	StartingTest(QObject* parent = 0);
+	~StartingTest();
+
+	bool test();
+
+protected:
+	bool initTest();
+	void cleanupTest();
+
+	bool testResolveDependencies();
+	bool testExecuteTasks();
+	bool testPrepareFailure();
+};
+
+#endif
+
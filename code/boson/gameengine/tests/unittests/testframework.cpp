@@ -116,7 +116,7 @@ BosonPlayField* TestFrameWork::createDummyPlayField(const QString& groundThemeId
 
 SpeciesTheme* TestFrameWork::createAndLoadDummySpeciesTheme(const QColor& teamColor, bool neutralSpecies)
 {
- const int unitCount = 5;
+ const int unitCount = 6;
 
  KTempDir speciesDir_("/tmp/");
  speciesDir_.setAutoDelete(true); // AB: deletes the dir recursively (implemented using ::system("/bin/rm -rf"))
@@ -195,6 +195,22 @@ SpeciesTheme* TestFrameWork::createAndLoadDummySpeciesTheme(const QColor& teamCo
 		stream << "[Boson Facility]\n";
 		stream << "ConstructionSteps=0\n";
 		stream << "PowerGenerated=2000\n";
+	} else if (id == 6) {
+		// id==6 is a mobile ground unit that can shoot at ground units
+		stream << "Weapons=1\n";
+		stream << "\n";
+		stream << "[Boson Mobile Unit]\n";
+		stream << "CanGoOnLand=true\n";
+		stream << "Speed=2\n";
+		stream << "Producer=1\n";
+		stream << "\n";
+		stream << "[Weapon_0]\n";
+		stream << "Name=Cannon\n";
+		stream << "Type=Bullet\n";
+		stream << "CanShootAtLandUnits=true\n";
+		stream << "Damage=10\n";
+		stream << "Range=6\n";
+		stream << "Reload=1\n";
 	}
 	file.close();
  }
@@ -259,8 +275,16 @@ Unit* CanvasContainer::createNewUnitAtTopLeftPos(unsigned int unitType, const Bo
  if (!mCanvas || !mPlayerListManager || mPlayerListManager->gamePlayerList().isEmpty()) {
 	return 0;
  }
+ return createNewUnitAtTopLeftPos(unitType, pos, mPlayerListManager->gamePlayerList().getFirst());
+}
+
+Unit* CanvasContainer::createNewUnitAtTopLeftPos(unsigned int unitType, const BoVector3Fixed& pos, Player* owner)
+{
+ if (!mCanvas || !owner) {
+	return 0;
+ }
  return static_cast<Unit*>(mCanvas->createNewItemAtTopLeftPos(RTTI::UnitStart + unitType,
-		mPlayerListManager->gamePlayerList().getFirst(),
+		owner,
 		ItemType(unitType),
 		pos));
 }
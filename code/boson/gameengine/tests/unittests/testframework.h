@@ -33,6 +33,7 @@ class BoEventManager;
 class BosonPlayerListManager;
 class BosonCanvas;
 class Unit;
+class Player;
 
 #define MY_VERIFY(x) \
 	if (!(x)) { \
@@ -143,6 +144,12 @@ public:
 	 **/
 	Unit* createNewUnitAtTopLeftPos(unsigned int unitType, const BoVector3Fixed& pos);
 
+	/**
+	 * @overload
+	 * The unit is owned by @p owner.
+	 **/
+	Unit* createNewUnitAtTopLeftPos(unsigned int unitType, const BoVector3Fixed& pos, Player* owner);
+
 public:
 	BoEventManager* mEventManager;
 	BosonPlayerListManager* mPlayerListManager;
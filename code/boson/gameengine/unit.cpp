@@ -32,6 +32,7 @@
 #include "bosonstatistics.h"
 #include "unitplugins/unitplugins.h"
 #include "boitemlist.h"
+#include "boitemlisthandler.h"
 #include "pluginproperties.h"
 #include "bosonweapon.h"
 #include "bopointeriterator.h"
@@ -40,6 +41,7 @@
 #include "bosonprofiling.h"
 #include "unitmover.h"
 #include "unitorder.h"
+#include "bosoncollisions.h"
 
 #include <kgame/kgamepropertylist.h>
 #include <kgame/kgame.h>
@@ -400,6 +402,9 @@ public:
 		mUnitInsideUnitMover = 0;
 
 		mOrderQueue = 0;
+
+		mPrecomputedIdleTarget = 0;
+		mHavePrecomputedIdleTarget = false;
 	}
 	KGamePropertyList<BoVector2Fixed> mPathPoints;
 	KGameProperty<Q_INT8> mIsInsideUnit;
@@ -427,6 +432,12 @@ public:
 	UnitOrderQueue* mOrderQueue;
 
 	bool mHaveUnitStorage;
+
+	// the result of the target search of the worker threads. this is valid
+	// during a single advance call only, so it does not need to be a
+	// KGameProperty.
+	Unit* mPrecomputedIdleTarget;
+	bool mHavePrecomputedIdleTarget;
 };
 
 Unit::Unit(const UnitProperties* prop, Player* owner, BosonCanvas* canvas)
@@ -929,6 +940,26 @@ void Unit::advanceIdle(unsigned int advanceCallsCount)
  }
 }
 
+bool Unit::searchesIdleTarget(unsigned int advanceCallsCount) const
+{
+ if (advanceCallsCount % 40 != (id() % 40)) {
+	return false;
+ }
+ return (unitProperties()->canShoot() && d->mWeapons[0]);
+}
+
+void Unit::setPrecomputedIdleTarget(Unit* target)
+{
+ d->mPrecomputedIdleTarget = target;
+ d->mHavePrecomputedIdleTarget = true;
+}
+
+void Unit::clearPrecomputedIdleTarget()
+{
+ d->mPrecomputedIdleTarget = 0;
+ d->mHavePrecomputedIdleTarget = false;
+}
+
 void Unit::advanceIdleBasic(unsigned int advanceCallsCount)
 {
  if (advanceCallsCount % 40 != (id() % 40)) {
@@ -938,7 +969,16 @@ void Unit::advanceIdleBasic(unsigned int advanceCallsCount)
 
  if (unitProperties()->canShoot() && d->mWeapons[0]) {
 	// Attack enemy units in range
-	Unit* target = bestEnemyUnitInRange();
+	Unit* target = 0;
+	if (d->mHavePrecomputedIdleTarget &&
+			(!d->mPrecomputedIdleTarget || !d->mPrecomputedIdleTarget->isDestroyed())) {
+		// the target has been searched by the canvas at the
+		// beginning of this advance call already
+		target = d->mPrecomputedIdleTarget;
+	} else {
+		target = bestEnemyUnitInRange();
+	}
+	clearPrecomputedIdleTarget();
 	if (target) {
 		addCurrentSuborder(new UnitAttackOrder(target, false));
 	}
@@ -1044,78 +1084,107 @@ Unit* Unit::attackEnemyUnitsInRange(Unit* target)
 Unit* Unit::bestEnemyUnitInRange()
 {
  PROFILE_METHOD
- // Return if unit can't shoot
- if (!unitProperties()->canShoot()) {
-	return 0;
- }
- // Return if no enemies in range
- BoItemList* list = enemyUnitsInRange(maxWeaponRange());
- if (!list->count() > 0) {
-	return 0;
- }
+ return findBestEnemyUnitInRange();
+}
 
- // Initialize some variables
- Unit* best = 0;
- BoItemList::Iterator it = list->begin();
- Unit* u = 0;
- bofixed dist = 0;
- // Candidates to best unit, see below
- Unit* c1 = 0;
- Unit* c2 = 0;
- Unit* c3 = 0;
-
- // Iterate through the list of enemies and pick the best ones
- for (; it != list->end(); ++it) {
-	u = ((Unit*)*it);
-	dist = QMAX(QABS((int)(u->centerX() - centerX())), QABS((int)(u->centerY() - centerY())));
-	// Quick check if we can shoot at u
-	if (u->isFlying()) {
-		if (!unitProperties()->canShootAtAirUnits()) {
-			continue;
+/**
+ * Picks the best enemy to attack from the units that it visits. This is
+ * the precedence of enemies:
+ *  1. enemies that can shoot at us
+ *  2. enemies that can shoot, but not at us
+ *  3. others
+ **/
+class BoBestEnemyVisitor : public BoUnitVisitor
+{
+public:
+	BoBestEnemyVisitor(const Unit* unit)
+		: mUnit(unit), mPlayerId(unit->owner()->bosonId())
+	{
+		mC1 = 0;
+		mC2 = 0;
+		mC3 = 0;
+	}
+
+	virtual bool visit(Unit* u)
+	{
+		// same filter as Unit::enemyUnitsInRange()
+		if (u == mUnit || u->isDestroyed()) {
+			return true;
 		}
-		if (dist > maxAirWeaponRange()) {
-			continue;
+		if (!(u->visibleStatus(mPlayerId) & (UnitBase::VS_Visible | UnitBase::VS_Earlier))) {
+			return true;
 		}
-	} else {
-		if (!unitProperties()->canShootAtLandUnits()) {
-			continue;
+		if (!mUnit->ownerIO()->isEnemy(u)) {
+			return true;
 		}
-		if (dist > maxLandWeaponRange()) {
-			continue;
+
+		const UnitProperties* prop = mUnit->unitProperties();
+		bofixed dist = QMAX(QABS((int)(u->centerX() - mUnit->centerX())), QABS((int)(u->centerY() - mUnit->centerY())));
+		// Quick check if we can shoot at u
+		if (u->isFlying()) {
+			if (!prop->canShootAtAirUnits()) {
+				return true;
+			}
+			if (dist > mUnit->maxAirWeaponRange()) {
+				return true;
+			}
+		} else {
+			if (!prop->canShootAtLandUnits()) {
+				return true;
+			}
+			if (dist > mUnit->maxLandWeaponRange()) {
+				return true;
+			}
 		}
-	}
 
-	// Check if it's the best unit so far.
-	// This is presedence of enemies:
-	//  1. enemies that can shoot at us
-	//  2. enemies that can shoot, but not at us
-	//  3. others
-	// Shoot at units that can shoot first, then at units that cannot shoot
-	if (u->unitProperties()->canShoot()) {
-		if ((isFlying() && u->unitProperties()->canShootAtAirUnits()) ||
-				(!isFlying() && u->unitProperties()->canShootAtLandUnits())) {
-			// u is type 1 - it can shoot at us
-			// TODO: check also for health here - first kill weaker units
-			c1 = u;
+		if (u->unitProperties()->canShoot()) {
+			if ((mUnit->isFlying() && u->unitProperties()->canShootAtAirUnits()) ||
+					(!mUnit->isFlying() && u->unitProperties()->canShootAtLandUnits())) {
+				// u is type 1 - it can shoot at us
+				// TODO: check also for health here - first kill weaker units
+				mC1 = u;
+			} else {
+				// u is type 2 - it can shoot but not at us
+				mC2 = u;
+			}
 		} else {
-			// u is type 2 - it can shoot but not at us
-			c2 = u;
+			// u is type 3 - it can't shoot
+			mC3 = u;
 		}
-	} else {
-		// u is type 3 - it can't shoot
-		c3 = u;
+		return true;
 	}
- }
 
- // Pick the best unit from the candidates
- if (c1) {
-	best = c1;
- } else if (c2) {
-	best = c2;
- } else if (c3) {
-	best = c3;
+	Unit* best() const
+	{
+		if (mC1) {
+			return mC1;
+		} else if (mC2) {
+			return mC2;
+		}
+		return mC3;
+	}
+
+private:
+	const Unit* mUnit;
+	int mPlayerId;
+	Unit* mC1;
+	Unit* mC2;
+	Unit* mC3;
+};
+
+Unit* Unit::findBestEnemyUnitInRange() const
+{
+ // Return if unit can't shoot
+ if (!unitProperties()->canShoot()) {
+	return 0;
  }
- return best;
+ // this visits the units in the same order as enemyUnitsInRange()
+ // returns them, so the result is the same as iterating that list.
+ BoBestEnemyVisitor visitor(this);
+ bofixed range = maxWeaponRange();
+ BoRect2Fixed rect(centerX() - range, centerY() - range, centerX() + range, centerY() + range);
+ collisions()->visitUnits(rect, &visitor);
+ return visitor.best();
 }
 
 void Unit::advanceAttack(unsigned int advanceCallsCount)
@@ -1598,44 +1667,47 @@ void Unit::shootAt(BosonWeapon* w, Unit* target)
  ownerIO()->statistics()->increaseShots();
 }
 
+/**
+ * Collects the units for @ref Unit::unitsInRange
+ **/
+class BoUnitsInRangeVisitor : public BoUnitVisitor
+{
+public:
+	BoUnitsInRangeVisitor(const Unit* unit, BoItemList* units)
+		: mUnit(unit), mPlayerId(unit->owner()->bosonId()), mUnits(units)
+	{
+	}
+
+	virtual bool visit(Unit* u)
+	{
+		if (u == mUnit || u->isDestroyed()) {
+			return true;
+		}
+		if (!(u->visibleStatus(mPlayerId) & (UnitBase::VS_Visible | UnitBase::VS_Earlier))) {
+			return true;
+		}
+		mUnits->append(u);
+		return true;
+	}
+
+private:
+	const Unit* mUnit;
+	int mPlayerId;
+	BoItemList* mUnits;
+};
+
 BoItemList* Unit::unitsInRange(unsigned long int range) const
 {
  PROFILE_METHOD
- // TODO: we use a *rect* for the range this is extremely bad.
- // ever heard about pythagoras ;-) ?
-
- // AB: note that we don't need to do error checking like left < 0, since
- // collisions() does this anyway.
- BoRect2Fixed rect(leftEdge() - range, topEdge() - range, rightEdge() + range, bottomEdge() + range);
+ // the unit grid of the collisions visits exactly the units with
+ // inRange(range, u) == true. the range is a square, not a circle.
 
  // TODO: we should do this using PlayerIO. It should return items that are
  // actually visible to us only!
- boProfiling->push("collisionsAtCells()");
- BoItemList* items = collisions()->collisionsAtCells(rect, (BosonItem*)this, false);
- boProfiling->pop();
- items->remove((BosonItem*)this);
-
- BoItemList* units = new BoItemList();
- BoItemList::Iterator it = items->begin();
- Unit* u;
- for (; it != items->end(); ++it) {
-	if (!RTTI::isUnit((*it)->rtti())) {
-		continue;
-	}
-	u = (Unit*)(*it);
-	if (u->isDestroyed()) {
-		continue;
-	}
-	if (!(u->visibleStatus(owner()->bosonId()) & (UnitBase::VS_Visible | UnitBase::VS_Earlier))) {
-		continue;
-	}
-	if (!inRange(range, u)) {
-		continue;
-	}
-	// TODO: remove the items from inRange which are not actually in range (hint:
-	// pythagoras)
-	units->append(*it);
- }
+ BoItemList* units = BoItemListHandler::itemListHandler()->allocateList();
+ BoUnitsInRangeVisitor visitor(this, units);
+ BoRect2Fixed rect(centerX() - range, centerY() - range, centerX() + range, centerY() + range);
+ collisions()->visitUnits(rect, &visitor);
  return units;
 }
 
@@ -1645,7 +1717,7 @@ BoItemList* Unit::enemyUnitsInRange(unsigned long int range) const
  boProfiling->push("unitsInRange()");
  BoItemList* units = unitsInRange(range);
  boProfiling->pop();
- BoItemList* enemy = new BoItemList();
+ BoItemList* enemy = BoItemListHandler::itemListHandler()->allocateList();
  Unit* u;
  BoItemList::Iterator it = units->begin();
  boProfiling->push("find enemies");
@@ -1664,14 +1736,15 @@ QValueList<Unit*> Unit::unitCollisions(bool exact)
  PROFILE_METHOD
  QValueList<Unit*> units;
  boDebug(310) << k_funcinfo << endl;
- BoItemList* collisionList = collisions()->collisionsAtCells(cells(), (BosonItem*)this, exact);
- if (collisionList->isEmpty()) {
+ BoItemList collisionList(0, false);
+ collisions()->collisionsAtCells(cells(), (BosonItem*)this, exact, &collisionList);
+ if (collisionList.isEmpty()) {
 	return units;
  }
 
  BoItemList::Iterator it;
  Unit* unit;
- for (it = collisionList->begin(); it != collisionList->end(); ++it) {
+ for (it = collisionList.begin(); it != collisionList.end(); ++it) {
 	if (!RTTI::isUnit((*it)->rtti())) {
 		continue;
 	}
@@ -2253,6 +2326,7 @@ bool Unit::currentOrderAdded()
 			boDebug(380) << k_funcinfo << "unit " << id() << ": Will move to (" << x << "; " << y << ")" << endl;
 			pathInfo()->moveAttacking = moveo->withAttacking();
 			pathInfo()->slowDownAtDest = true;
+			pathInfo()->groupsize = moveo->groupSize();
 		} else {
 			boDebug(380) << k_funcinfo << "unit " << id() << ": CANNOT move to (" << x << "; " << y << ")" << endl;
 			return false;
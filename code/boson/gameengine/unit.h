@@ -432,6 +432,28 @@ public:
 	 **/
 	Unit* bestEnemyUnitInRange();
 
+	/**
+	 * Same as @ref bestEnemyUnitInRange, but this method only reads the
+	 * game state and does neither profiling nor debug output, so that it
+	 * may be called from the worker threads of the advance call (see @ref
+	 * BoAdvanceWorkerPool).
+	 **/
+	Unit* findBestEnemyUnitInRange() const;
+
+	/**
+	 * @return TRUE if @ref advanceIdle will search for a target in the
+	 * advance call @p advanceCallsCount, otherwise FALSE.
+	 **/
+	bool searchesIdleTarget(unsigned int advanceCallsCount) const;
+
+	/**
+	 * Called by the canvas in the commit phase of an advance call, once the
+	 * target for @ref advanceIdle has been searched by a worker thread.
+	 * The target is valid for the current advance call only.
+	 **/
+	void setPrecomputedIdleTarget(Unit* target);
+	void clearPrecomputedIdleTarget();
+
 	/**
 	 * @return Square of distance between center points of this unit and u
 	 **/
@@ -30,6 +30,8 @@
 #include "bosoncanvas.h"
 #include "upgradeproperties.h"
 #include "bosonpropertyxml.h"
+#include "bobinarysavegame.h"
+#include "bosynchash.h"
 #include "bodebug.h"
 
 #include <kstaticdeleter.h>
@@ -231,6 +233,16 @@ void UnitBase::setHealth(unsigned long int h)
  }
 }
 
+Q_UINT64 UnitBase::syncState() const
+{
+ Q_UINT64 h = BosonItem::syncState();
+ h = BoSyncHash::add(h, healthFactor());
+ h = BoSyncHash::add(h, shieldsFactor());
+ h = BoSyncHash::add(h, (Q_UINT64)mAdvanceWork.value());
+ h = BoSyncHash::add(h, (Q_UINT64)mMovingStatus.value());
+ return h;
+}
+
 unsigned long int UnitBase::powerConsumedByUnit() const
 {
  return mPowerConsumed.value(upgradesCollection());
@@ -316,7 +328,7 @@ bool UnitBase::saveAsXML(QDomElement& root)
  if (mWeaponProperties) {
 	BosonCustomPropertyXML propertyXML;
 	QDomElement weaponHandler = doc.createElement(QString::fromLatin1("WeaponDataHandler"));
-	if (!propertyXML.saveAsXML(weaponHandler, weaponDataHandler())) {
+	if (saveDataHandlersAsXML() && !propertyXML.saveAsXML(weaponHandler, weaponDataHandler())) {
 		boError() << k_funcinfo << "Unable to save weapon datahandler of unit " << id() << endl;
 		return false;
 	}
@@ -360,6 +372,22 @@ bool UnitBase::loadFromXML(const QDomElement& root)
  return true;
 }
 
+void UnitBase::saveDataHandlers(BoBinarySaveGameWriter* writer, QDataStream& stream)
+{
+ BosonItem::saveDataHandlers(writer, stream);
+ if (mWeaponProperties) {
+	writer->writePropertyHandler(stream, QString::fromLatin1("WeaponDataHandler"), weaponDataHandler());
+ }
+}
+
+KGamePropertyHandler* UnitBase::dataHandlerByName(const QString& name)
+{
+ if (name == QString::fromLatin1("WeaponDataHandler")) {
+	return weaponDataHandler();
+ }
+ return BosonItem::dataHandlerByName(name);
+}
+
 SpeciesTheme* UnitBase::speciesTheme() const
 {
  if (!owner()) {
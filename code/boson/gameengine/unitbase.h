@@ -192,6 +192,14 @@ public:
 		return (health() == 0);
 	}
 
+	/**
+	 * Adds health, shields, work and moving status to the hash of @ref
+	 * BosonItem::syncState. These are properties, so the owner calls
+	 * @ref updateSyncState whenever they change (see @ref
+	 * Player::slotUnitPropertyChanged).
+	 **/
+	virtual Q_UINT64 syncState() const;
+
 	/**
 	 * @return owner()->playerIO()
 	 **/
@@ -234,6 +242,8 @@ public:
 
 	virtual bool saveAsXML(QDomElement& root);
 	virtual bool loadFromXML(const QDomElement& root);
+	virtual void saveDataHandlers(BoBinarySaveGameWriter* writer, QDataStream& stream);
+	virtual KGamePropertyHandler* dataHandlerByName(const QString& name);
 
 	/**
 	 * These are <em>not</em> the @ref KGameProperties! See @ref dataHandler
@@ -457,6 +457,69 @@ UnitMoverLand::~UnitMoverLand()
 {
 }
 
+bool UnitMoverLand::saveAsXML(QDomElement& root) const
+{
+ if (!UnitMover::saveAsXML(root)) {
+	return false;
+ }
+
+ // the position on the current path. without this a loaded unit would
+ // select its next cell differently than the unit that was saved.
+ root.setAttribute("LastCellX", mLastCellX);
+ root.setAttribute("LastCellY", mLastCellY);
+ root.setAttribute("NextCellX", mNextCellX);
+ root.setAttribute("NextCellY", mNextCellY);
+ int intersections = -1;
+ if (mNextWaypointIntersections) {
+	intersections = mNextWaypointIntersections - &mCellIntersectionTable[0][0];
+ }
+ root.setAttribute("NextWaypointIntersections", intersections);
+ root.setAttribute("NextWaypointIntersectionsXOffset", mNextWaypointIntersectionsXOffset);
+ root.setAttribute("NextWaypointIntersectionsYOffset", mNextWaypointIntersectionsYOffset);
+ return true;
+}
+
+bool UnitMoverLand::loadFromXML(const QDomElement& root)
+{
+ if (!UnitMover::loadFromXML(root)) {
+	return false;
+ }
+
+ // older savegames don't have this
+ if (!root.hasAttribute("NextWaypointIntersections")) {
+	return true;
+ }
+ bool ok = true;
+ bool ret = true;
+ mLastCellX = root.attribute("LastCellX").toInt(&ok);
+ ret = ret && ok;
+ mLastCellY = root.attribute("LastCellY").toInt(&ok);
+ ret = ret && ok;
+ mNextCellX = root.attribute("NextCellX").toInt(&ok);
+ ret = ret && ok;
+ mNextCellY = root.attribute("NextCellY").toInt(&ok);
+ ret = ret && ok;
+ int intersections = root.attribute("NextWaypointIntersections").toInt(&ok);
+ ret = ret && ok;
+ mNextWaypointIntersectionsXOffset = root.attribute("NextWaypointIntersectionsXOffset").toInt(&ok);
+ ret = ret && ok;
+ mNextWaypointIntersectionsYOffset = root.attribute("NextWaypointIntersectionsYOffset").toInt(&ok);
+ ret = ret && ok;
+ if (!ret) {
+	boError() << k_funcinfo << "Invalid value for a waypoint attribute" << endl;
+	return false;
+ }
+ if (intersections >= 11 * 11) {
+	boError() << k_funcinfo << "Invalid value for NextWaypointIntersections attribute: " << intersections << endl;
+	return false;
+ }
+ mNextWaypointIntersections = 0;
+ if (intersections >= 0) {
+	mNextWaypointIntersections = &mCellIntersectionTable[intersections / 11][intersections % 11];
+ }
+ return true;
+}
+
 int UnitMoverLand::pathPointCount() const
 {
  return unit()->pathPointCount();
@@ -522,9 +585,29 @@ void UnitMoverLand::advanceMoveInternal2(unsigned int advanceCallsCount)
 		return;
 	}
 	// If there aren't any enemies, find new path
-	if (!calculateNewPath()) {
-		// No path was found
-		stopMoving(false);
+	if (!usePathRequests()) {
+		if (!calculateNewPath()) {
+			// No path was found
+			stopMoving(false);
+			return;
+		}
+	} else if (pathInfo()->pathrequest == BosonPath::RequestPending) {
+		// The pathfinder didn't get to our request yet. Wait.
+		return;
+	} else if (pathInfo()->pathrequest == BosonPath::RequestDone &&
+			pathInfo()->start == BoVector2Fixed(unit()->centerX(), unit()->centerY())) {
+		if (!takeRequestedPath()) {
+			// No path was found
+			stopMoving(false);
+			return;
+		}
+	} else {
+		// Either no path was requested yet or we were moved since (e.g. by
+		//  attacking). The path will be searched by one of the next pathfinder
+		//  advance calls.
+		if (!requestNewPath()) {
+			stopMoving(false);
+		}
 		return;
 	}
  }
@@ -974,9 +1057,10 @@ void UnitMoverLand::avoidance()
 		unit()->topEdge() - unit()->speed() * 40 - 1,
 		unit()->rightEdge() + unit()->speed() * 40 + 1,
 		unit()->bottomEdge() + unit()->speed() * 40 + 1);
- BoItemList* items = canvas()->collisions()->collisionsAtCells(rect, unit(), false);
+ BoItemList items(0, false);
+ canvas()->collisions()->collisionsAtCells(rect, unit(), false, &items);
  // Go through the units
- for (BoItemList::ConstIterator it = items->begin(); it != items->end(); ++it) {
+ for (BoItemList::ConstIterator it = items.begin(); it != items.end(); ++it) {
 	if (!RTTI::isUnit((*it)->rtti())) {
 		// TODO: check for e.g. mines
 		continue;
@@ -1113,11 +1197,8 @@ bofixed UnitMoverLand::moveTowardsPoint(const BoVector2Fixed& p, bofixed x, bofi
  }
 }
 
-bool UnitMoverLand::calculateNewPath()
+bool UnitMoverLand::prepareNewPath()
 {
- BosonProfiler profiler("calculateNewPath");
- boDebug(401) << k_funcinfo << "unit " << id() << endl;
-
  // Update our start position
  pathInfo()->start.set(unit()->centerX(), unit()->centerY());
 
@@ -1140,6 +1221,17 @@ bool UnitMoverLand::calculateNewPath()
 		< 1.0f) {
 	return false;
  }
+ return true;
+}
+
+bool UnitMoverLand::calculateNewPath()
+{
+ BosonProfiler profiler("calculateNewPath");
+ boDebug(401) << k_funcinfo << "unit " << id() << endl;
+
+ if (!prepareNewPath()) {
+	return false;
+ }
 
  QValueVector<BoVector2Fixed> pathPoints;
  if (!calculateNewPathPathPoints(&pathPoints)) {
@@ -1163,6 +1255,44 @@ bool UnitMoverLand::calculateNewPath()
  return true;
 }
 
+bool UnitMoverLand::requestNewPath()
+{
+ boDebug(401) << k_funcinfo << "unit " << id() << endl;
+
+ pathInfo()->cancelPathRequest();
+ if (!prepareNewPath()) {
+	return false;
+ }
+
+ // The unit has no pathpoints until the request is answered
+ mLastCellX = -1;
+ mLastCellY = -1;
+ mNextWaypointIntersections = &mCellIntersectionTable[5][5];
+
+ canvas()->pathFinder()->preparePathInfo(pathInfo());
+ canvas()->pathFinder()->requestPath(pathInfo());
+ return true;
+}
+
+bool UnitMoverLand::takeRequestedPath()
+{
+ pathInfo()->pathrequest = BosonPath::NotRequested;
+ if (pathInfo()->result == BosonPath::NoPath || pathInfo()->llpath.count() == 0) {
+	return false;
+ }
+
+ unit()->clearPathPoints();
+ for (unsigned int i = 0; i < pathInfo()->llpath.count(); i++) {
+	unit()->addPathPoint(pathInfo()->llpath[i]);
+ }
+
+ // Reset last cell
+ mLastCellX = -1;
+ mLastCellY = -1;
+ mNextWaypointIntersections = &mCellIntersectionTable[5][5];
+ return true;
+}
+
 bool UnitMoverLand::calculateNewPathPathPoints(QValueVector<BoVector2Fixed>* pathPoints)
 {
  pathPoints->clear();
@@ -160,6 +160,9 @@ public:
 
 	virtual bool init();
 
+	virtual bool saveAsXML(QDomElement& root) const;
+	virtual bool loadFromXML(const QDomElement& root);
+
 
 protected:
 	virtual void advanceMoveInternal(unsigned int advanceCallsCount);
@@ -182,6 +185,13 @@ protected:
 	 **/
 	bool calculateNewPath();
 
+	/**
+	 * Updates start and destination of @ref pathInfo for a new search and
+	 * clears the current pathpoints.
+	 * @return FALSE if we are already at the destination.
+	 **/
+	bool prepareNewPath();
+
 	/**
 	 * Called by @ref calculateNewPath to actually calculate the pathpoints.
 	 *
@@ -190,6 +200,30 @@ protected:
 	 **/
 	virtual bool calculateNewPathPathPoints(QValueVector<BoVector2Fixed>* points);
 
+	/**
+	 * Like @ref calculateNewPath, but the path is not searched immediately.
+	 * Instead a request is queued in the pathfinder, which answers it in one
+	 * of the next advance calls. Use @ref takeRequestedPath once @ref
+	 * BosonPathInfo::pathrequest is @ref BosonPath::RequestDone.
+	 *
+	 * @return FALSE if no path needs to be searched (i.e. we are already at
+	 * the destination), otherwise TRUE.
+	 **/
+	bool requestNewPath();
+
+	/**
+	 * Uses the result of the request made by @ref requestNewPath.
+	 * @return See @ref calculateNewPath
+	 **/
+	bool takeRequestedPath();
+
+	/**
+	 * @return Whether the path for new move orders should be requested using
+	 * @ref requestNewPath. Classes that reimplement @ref
+	 * calculateNewPathPathPoints should return FALSE here.
+	 **/
+	virtual bool usePathRequests() const { return true; }
+
 	/**
 	 * Move towards p, going at most maxdist (in canvas coords).
 	 * How much unit should move, will be added to xspeed and yspeed.
@@ -261,6 +295,7 @@ protected:
 	virtual bool cellOccupied(int x, int y, bool ignoremoving = false) const;
 	virtual bool canGoToCurrentPathPoint(int xpos, int ypos);
 	virtual bool calculateNewPathPathPoints(QValueVector<BoVector2Fixed>* points);
+	virtual bool usePathRequests() const { return false; }
 	virtual void advanceMoveCheck();
 	virtual void pathPointDone();
 
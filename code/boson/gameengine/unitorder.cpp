@@ -113,10 +113,12 @@ UnitMoveOrder::UnitMoveOrder(const BoVector2Fixed& pos, int range, bool attackin
   mPos = pos;
   mRange = range;
   mWithAttacking = attacking;
+  mGroupSize = 1;
 }
 
 UnitMoveOrder::UnitMoveOrder() : UnitOrder()
 {
+  mGroupSize = 1;
 }
 
 UnitMoveOrder::~UnitMoveOrder()
@@ -132,6 +134,7 @@ bool UnitMoveOrder::saveAsXML(QDomElement& root)
   saveVector2AsXML(mPos, root, "Position");
   root.setAttribute("Range", mRange);
   root.setAttribute("WithAttacking", mWithAttacking ? 1 : 0);
+  root.setAttribute("GroupSize", mGroupSize);
   return true;
 }
 
@@ -156,6 +159,17 @@ bool UnitMoveOrder::loadFromXML(const QDomElement& root, BosonCanvas* canvas)
     boError() << k_funcinfo << "Invalid value for WithAttacking attribute" << endl;
     return false;
   }
+  // Older savegames don't have this
+  mGroupSize = 1;
+  if(root.hasAttribute("GroupSize"))
+  {
+    mGroupSize = root.attribute("GroupSize").toInt(&ok);
+    if(!ok)
+    {
+      boError() << k_funcinfo << "Invalid value for GroupSize attribute" << endl;
+      return false;
+    }
+  }
 
   return true;
 }
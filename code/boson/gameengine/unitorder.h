@@ -125,11 +125,18 @@ class UnitMoveOrder : public UnitOrder
     inline bool withAttacking() const  { return mWithAttacking; }
     inline void setWithAttacking(bool a)  { mWithAttacking = a; }
 
+    /**
+     * @return Number of units that got this order at the same time
+     **/
+    inline int groupSize() const  { return mGroupSize; }
+    inline void setGroupSize(int s)  { mGroupSize = s; }
+
 
   protected:
     BoVector2Fixed mPos;
     int mRange;
     bool mWithAttacking;
+    int mGroupSize;
 };
 
 
@@ -97,7 +97,7 @@ void ProductionPlugin::productionPlaced(Unit* produced)
 	player()->statistics()->addProducedMobileUnit(produced, this);
  }
 
- BoEvent* productionPlaced = new BoEvent("ProducedUnitWithTypePlaced", QString::number(produced->type()), QString::number(unit()->id()));
+ BoEvent* productionPlaced = BoEvent::create("ProducedUnitWithTypePlaced", QString::number(produced->type()), QString::number(unit()->id()));
  productionPlaced->setUnitId(produced->id());
  productionPlaced->setPlayerId(produced->owner()->bosonId());
  productionPlaced->setLocation(BoVector3Fixed(produced->centerX(), produced->centerY(), produced->z()));
@@ -171,7 +171,7 @@ void ProductionPlugin::addProduction(ProductionType type, unsigned long int id)
 	boError() << k_funcinfo << "Invalid productionType: " << (int)type << endl;
  }
  if (!eventName.isNull()) {
-	BoEvent* event = new BoEvent(eventName, QString::number(id), QString::number(unit()->id()));
+	BoEvent* event = BoEvent::create(eventName, QString::number(id), QString::number(unit()->id()));
 	event->setPlayerId(player()->bosonId());
 	event->setLocation(BoVector3Fixed(unit()->centerX(), unit()->centerY(), unit()->z()));
 	game()->queueEvent(event);
@@ -202,7 +202,7 @@ void ProductionPlugin::pauseProduction()
  }
 
  if (!eventName.isNull()) {
-	BoEvent* event = new BoEvent(eventName, QString::number(currentProductionId()), QString::number(unit()->id()));
+	BoEvent* event = BoEvent::create(eventName, QString::number(currentProductionId()), QString::number(unit()->id()));
 	event->setPlayerId(player()->bosonId());
 	event->setLocation(BoVector3Fixed(unit()->centerX(), unit()->centerY(), unit()->z()));
 	game()->queueEvent(event);
@@ -233,7 +233,7 @@ void ProductionPlugin::unpauseProduction()
 	boError() << k_funcinfo << "Invalid productionType: " << (int)currentProductionType() << endl;
  }
  if (!eventName.isNull()) {
-	BoEvent* event = new BoEvent(eventName, QString::number(currentProductionId()), QString::number(unit()->id()));
+	BoEvent* event = BoEvent::create(eventName, QString::number(currentProductionId()), QString::number(unit()->id()));
 	event->setPlayerId(player()->bosonId());
 	event->setLocation(BoVector3Fixed(unit()->centerX(), unit()->centerY(), unit()->z()));
 	game()->queueEvent(event);
@@ -264,7 +264,7 @@ void ProductionPlugin::abortProduction(ProductionType type, unsigned long int id
  }
 
  if (!eventName.isNull()) {
-	BoEvent* event = new BoEvent(eventName, QString::number(id), QString::number(unit()->id()));
+	BoEvent* event = BoEvent::create(eventName, QString::number(id), QString::number(unit()->id()));
 	event->setPlayerId(player()->bosonId());
 	event->setLocation(BoVector3Fixed(unit()->centerX(), unit()->centerY(), unit()->z()));
 	game()->queueEvent(event);
@@ -420,7 +420,7 @@ void ProductionPlugin::productionCompleted()
 	return;
  }
 
- BoEvent* unitProduced = new BoEvent("UnitWithTypeProduced", QString::number(id),
+ BoEvent* unitProduced = BoEvent::create("UnitWithTypeProduced", QString::number(id),
 		QString::number(unit()->id()));
  unitProduced->setPlayerId(player()->bosonId());
  game()->queueEvent(unitProduced);
@@ -30,12 +30,14 @@
 #include "bodebug.h"
 #include "bosonprofiling.h"
 #include "upgradeproperties.h"
+#include "bofilehashcache.h"
 
 #include <ksimpleconfig.h>
 #include <klocale.h>
 #include <kmdcodec.h>
 
 #include <qfile.h>
+#include <qstringlist.h>
 
 UnitProperties::UnitProperties(SpeciesTheme* theme)
 	: BoBaseValueCollection(),
@@ -72,13 +74,17 @@ UnitProperties::~UnitProperties()
 bool UnitProperties::loadUnitType(const QString& fileName)
 {
  bool isFacility;
- QFile file(fileName);
- if (!file.open(IO_ReadOnly)) {
-	boError() << k_funcinfo << "could not open " << fileName << endl;
-	return false;
+ // the sum may have been calculated by a worker thread already, see
+ // BosonStartingLoadPlayerGameData
+ if (!BoFileHashCache::hash(QStringList(fileName), &d->mMD5)) {
+	QFile file(fileName);
+	if (!file.open(IO_ReadOnly)) {
+		boError() << k_funcinfo << "could not open " << fileName << endl;
+		return false;
+	}
+	KMD5 md5(file.readAll());
+	d->mMD5 = md5.hexDigest();
  }
- KMD5 md5(file.readAll());
- d->mMD5 = md5.hexDigest();
  KSimpleConfig conf(fileName);
  conf.setGroup(QString::fromLatin1("Boson Unit"));
 
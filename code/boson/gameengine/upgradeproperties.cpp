@@ -28,6 +28,7 @@
 #include "bodebug.h"
 #include "bosonconfig.h"
 #include "bosonweapon.h"
+#include "boupgradeableproperty.h"
 #include "bosoncanvas.h"
 
 #include <ksimpleconfig.h>
@@ -36,6 +37,25 @@
 #include <qstring.h>
 #include <qvaluelist.h>
 
+/**
+ * A parsed entry of an upgrade, see @ref UpgradeProperties::prepareEntries
+ **/
+class UpgradeEntry
+{
+  public:
+    UpgradeEntry()
+    {
+      mValueType = 0;
+      mULongValue = 0;
+      mValid = false;
+    }
+
+    int mValueType; // UpgradeProperties::ValueType
+    unsigned long int mULongValue;
+    bofixed mBoFixedValue;
+    bool mValid;
+};
+
 class UpgradeApplyer
 {
   public:
@@ -46,11 +66,13 @@ class UpgradeApplyer
 
     // AB: valid types for T currently: unsigned long int, bofixed
     // note that only numerical values are valid!
-    template<class T> bool upgradeValue(const QString& data, T* value, const QString& type) const;
+    template<class T> bool upgradeValue(const UpgradeEntry& entry, T* value, int valueType) const;
+
+    void parseEntry(const QString& data, UpgradeEntry* entry) const;
 
   protected:
-    unsigned long int applyValue(const QString& data, unsigned long int oldvalue) const;
-    bofixed applyValue(const QString& data, bofixed oldvalue) const;
+    unsigned long int applyValue(const UpgradeEntry& entry, unsigned long int oldvalue) const;
+    bofixed applyValue(const UpgradeEntry& entry, bofixed oldvalue) const;
 
     bool parseEntryType(const QString& typeString, UpgradeProperties::UpgradeType* type, int* weaponid) const;
     void parseEntry(const QString& entry, UpgradeProperties::ValueType& type, QString& value) const;
@@ -86,6 +108,9 @@ public:
   QValueList<unsigned long int> mApplyToTypes;
 
   QMap<QString, QString> mEntryList;
+
+  // key is the BoUpgradeablePropertyKey::nameKey() of the property
+  QMap<int, UpgradeEntry> mEntries;
 };
 
 UpgradeProperties::UpgradeProperties(const QString& type, const SpeciesTheme* theme)
@@ -202,6 +227,7 @@ bool UpgradeProperties::load(KSimpleConfig* cfg, const QString& group)
   d->mEntryList.remove("RequireTechnologies");
 
   convertEntries();
+  prepareEntries();
 
   return true;
 }
@@ -270,33 +296,65 @@ bool UpgradeProperties::downgradeUnit(UnitBase* unit) const
 
 bool UpgradeProperties::upgradeValue(const QString& name, unsigned long int* v, const QString& type) const
 {
-  if(!d->mEntryList.contains(name))
+  return upgradeValue(BoUpgradeablePropertyKey::key(name, type), v);
+}
+
+bool UpgradeProperties::upgradeValue(const QString& name, long int* v, const QString& type) const
+{
+  return upgradeValue(BoUpgradeablePropertyKey::key(name, type), v);
+}
+
+bool UpgradeProperties::upgradeValue(const QString& name, bofixed* v, const QString& type) const
+{
+  return upgradeValue(BoUpgradeablePropertyKey::key(name, type), v);
+}
+
+bool UpgradeProperties::upgradeValue(int key, unsigned long int* v) const
+{
+  if(key < 0)
+  {
+    boError(600) << k_funcinfo << "invalid key " << key << endl;
+    return false;
+  }
+  QMap<int, UpgradeEntry>::const_iterator it = d->mEntries.find(BoUpgradeablePropertyKey::nameKey(key));
+  if(it == d->mEntries.end())
   {
     return true;
   }
   UpgradeApplyer a(this);
-  return a.upgradeValue(d->mEntryList[name], v, type);
+  return a.upgradeValue(*it, v, BoUpgradeablePropertyKey::valueType(key));
 }
 
-bool UpgradeProperties::upgradeValue(const QString& name, long int* v, const QString& type) const
+bool UpgradeProperties::upgradeValue(int key, long int* v) const
 {
-  if(!d->mEntryList.contains(name))
+  if(key < 0)
+  {
+    boError(600) << k_funcinfo << "invalid key " << key << endl;
+    return false;
+  }
+  QMap<int, UpgradeEntry>::const_iterator it = d->mEntries.find(BoUpgradeablePropertyKey::nameKey(key));
+  if(it == d->mEntries.end())
   {
-    boDebug() << k_funcinfo << "dont have " << name << endl;
     return true;
   }
   UpgradeApplyer a(this);
-  return a.upgradeValue(d->mEntryList[name], v, type);
+  return a.upgradeValue(*it, v, BoUpgradeablePropertyKey::valueType(key));
 }
 
-bool UpgradeProperties::upgradeValue(const QString& name, bofixed* v, const QString& type) const
+bool UpgradeProperties::upgradeValue(int key, bofixed* v) const
 {
-  if(!d->mEntryList.contains(name))
+  if(key < 0)
+  {
+    boError(600) << k_funcinfo << "invalid key " << key << endl;
+    return false;
+  }
+  QMap<int, UpgradeEntry>::const_iterator it = d->mEntries.find(BoUpgradeablePropertyKey::nameKey(key));
+  if(it == d->mEntries.end())
   {
     return true;
   }
   UpgradeApplyer a(this);
-  return a.upgradeValue(d->mEntryList[name], v, type);
+  return a.upgradeValue(*it, v, BoUpgradeablePropertyKey::valueType(key));
 }
 
 void UpgradeProperties::convertEntries()
@@ -337,22 +395,48 @@ void UpgradeProperties::convertEntries()
   }
 }
 
-unsigned long int UpgradeApplyer::applyValue(const QString& data, unsigned long int oldvalue) const
+void UpgradeProperties::prepareEntries()
 {
-  UpgradeProperties::ValueType type;
-  QString valuestr;
-  parseEntry(data, type, valuestr);
-  unsigned long int value = valuestr.toULong();
-  return applyValueInternal(type, oldvalue, value);
+  d->mEntries.clear();
+  UpgradeApplyer a(this);
+  QMap<QString, QString>::Iterator it;
+  for(it = d->mEntryList.begin(); it != d->mEntryList.end(); it++)
+  {
+    UpgradeEntry entry;
+    a.parseEntry(it.data(), &entry);
+    int key = BoUpgradeablePropertyKey::key(it.key());
+    d->mEntries.insert(BoUpgradeablePropertyKey::nameKey(key), entry);
+  }
+
+  // the string entries are not needed anymore, only the parsed values are
+  // used to upgrade properties.
+  d->mEntryList.clear();
 }
 
-bofixed UpgradeApplyer::applyValue(const QString& data, bofixed oldvalue) const
+void UpgradeApplyer::parseEntry(const QString& data, UpgradeEntry* entry) const
 {
+  if(data.isEmpty())
+  {
+    entry->mValid = false;
+    return;
+  }
   UpgradeProperties::ValueType type;
   QString valuestr;
   parseEntry(data, type, valuestr);
-  bofixed value = valuestr.toFloat();
-  return applyValueInternal(type, oldvalue, value);
+  entry->mValueType = (int)type;
+  entry->mULongValue = valuestr.toULong();
+  entry->mBoFixedValue = valuestr.toFloat();
+  entry->mValid = true;
+}
+
+unsigned long int UpgradeApplyer::applyValue(const UpgradeEntry& entry, unsigned long int oldvalue) const
+{
+  return applyValueInternal((UpgradeProperties::ValueType)entry.mValueType, oldvalue, entry.mULongValue);
+}
+
+bofixed UpgradeApplyer::applyValue(const UpgradeEntry& entry, bofixed oldvalue) const
+{
+  return applyValueInternal((UpgradeProperties::ValueType)entry.mValueType, oldvalue, entry.mBoFixedValue);
 }
 
 template<class T> T UpgradeApplyer::applyValueInternal(UpgradeProperties::ValueType type, T oldvalue, T value) const
@@ -503,26 +587,26 @@ void UpgradeApplyer::parseEntry(const QString& entry, UpgradeProperties::ValueTy
   }
 }
 
-template<class T> bool UpgradeApplyer::upgradeValue(const QString& data, T* value, const QString& type) const
+template<class T> bool UpgradeApplyer::upgradeValue(const UpgradeEntry& entry, T* value, int valueType) const
 {
-  if(data.isEmpty())
+  if(!entry.mValid)
   {
     boError(600) << k_funcinfo << "empty data string" << endl;
     return false;
   }
-  if(type == "MaxValue")
+  if(valueType == BoUpgradeablePropertyKey::MaxValue)
   {
-    *value = applyValue(data, *value);
+    *value = applyValue(entry, *value);
     return true;
   }
-  else if(type == "MinValue")
+  else if(valueType == BoUpgradeablePropertyKey::MinValue)
   {
     boError(600) << k_funcinfo << "MinValue not yet supported" << endl;
     return false;
   }
   else
   {
-    boError(600) << k_funcinfo << "invalid type " << type << endl;
+    boError(600) << k_funcinfo << "invalid type " << valueType << endl;
     return false;
   }
   return false;
@@ -87,6 +87,25 @@ class UpgradeProperties
      **/
     bool upgradeValue(const QString& name, bofixed* v, const QString& type = "MaxValue") const;
 
+    /**
+     * @overload
+     *
+     * Like above, but uses the @ref BoUpgradeablePropertyKey of the property.
+     * The entries of the upgrade are parsed once when the upgrade is loaded,
+     * so this does not require any string operations.
+     **/
+    bool upgradeValue(int key, unsigned long int* v) const;
+
+    /**
+     * @overload
+     **/
+    bool upgradeValue(int key, long int* v) const;
+
+    /**
+     * @overload
+     **/
+    bool upgradeValue(int key, bofixed* v) const;
+
     /**
      * Load upgrade properties
      **/
@@ -182,6 +201,13 @@ class UpgradeProperties
      **/
     void convertEntries();
 
+    /**
+     * Parses the entry list into values that can be applied to properties
+     * directly. The entries are stored by their @ref
+     * BoUpgradeablePropertyKey.
+     **/
+    void prepareEntries();
+
   private:
     QString mType;
     unsigned long int mId;
@@ -58,6 +58,15 @@ BosonScript* BoLocalPlayerEventListener::createScriptParser() const
  return BosonScript::newScriptParser(BosonScript::Python, playerId);
 }
 
+bool BoLocalPlayerEventListener::processesEvent(const QCString& name) const
+{
+ if (name == "UnitWithTypeProduced" || name == "LostMinimap" ||
+		name == "GainedMinimap") {
+	return true;
+ }
+ return false;
+}
+
 void BoLocalPlayerEventListener::processEvent(const BoEvent* event)
 {
  PROFILE_METHOD
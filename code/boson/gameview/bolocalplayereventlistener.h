@@ -64,6 +64,7 @@ signals:
 
 protected:
 	virtual BosonScript* createScriptParser() const;
+	virtual bool processesEvent(const QCString& name) const;
 
 private:
 	PlayerIO* mPlayerIO;
@@ -27,6 +27,7 @@
 #include "../gameengine/boson.h"
 #include "../gameengine/bosoncanvas.h"
 #include "../gameengine/bosonmap.h"
+#include "../gameengine/boitemfrustumculler.h"
 #include "../gameengine/cell.h"
 #include "../gameengine/boitemlist.h"
 #include "../gameengine/rtti.h"
@@ -544,6 +545,7 @@ public:
 
 		mMainSceneRenderTarget = 0;
 		mSceneRenderTargetCache = 0;
+		mItemCuller = 0;
 
 		mUnitIconLand = 0;
 		mUnitIconAir = 0;
@@ -553,6 +555,7 @@ public:
 	}
 	const BosonCanvas* mCanvas;
 	QValueVector<BoRenderItem> mRenderItemList;
+	QValueVector<BoCulledItem> mCulledItems;
 	SelectBoxData* mSelectBoxData;
 	BoVisibleEffects mVisibleEffects;
 	unsigned int mRenderedItems;
@@ -582,6 +585,8 @@ public:
 	BoSceneRenderTarget* mMainSceneRenderTarget;
 	BoSceneRenderTargetCache* mSceneRenderTargetCache;
 
+	BoItemFrustumCuller* mItemCuller;
+
 	QValueList<Unit*> mRadarContactsList;
 	QValueList<Unit*> mIconicUnits;
 	BoTexture* mUnitIconLand;
@@ -606,6 +611,7 @@ BosonCanvasRenderer::BosonCanvasRenderer()
  d->mVisibleEffects.mParticlesDirty = true;
  d->mVisualFeedbacks = new BoVisualFeedbackContainer();
  d->mSceneRenderTargetCache = new BoSceneRenderTargetCache();
+ d->mItemCuller = new BoItemFrustumCuller();
 }
 
 BosonCanvasRenderer::~BosonCanvasRenderer()
@@ -613,6 +619,7 @@ BosonCanvasRenderer::~BosonCanvasRenderer()
  delete d->mSelectBoxData;
  delete d->mVisualFeedbacks;
  delete d->mSceneRenderTargetCache;
+ delete d->mItemCuller;
  delete d->mUnitShader;
  delete d->mShadowTarget;
  delete d->mShadowTexture;
@@ -661,7 +668,7 @@ void BosonCanvasRenderer::slotWidgetResized()
  d->mSceneRenderTargetCache->deleteAllRenderTargets();
 }
 
-void BosonCanvasRenderer::setCanvas(const BosonCanvas* canvas)
+void BosonCanvasRenderer::setCanvas(BosonCanvas* canvas)
 {
  if (d->mCanvas) {
 	disconnect(d->mCanvas, 0, this, 0);
@@ -671,6 +678,7 @@ void BosonCanvasRenderer::setCanvas(const BosonCanvas* canvas)
 	connect(d->mCanvas, SIGNAL(signalRemovedItem(BosonItem*)),
 			this, SLOT(slotItemRemoved(BosonItem*)));
  }
+ d->mItemCuller->setCanvas(canvas);
 }
 
 void BosonCanvasRenderer::setGameGLMatrices(const BoGLMatrices* m)
@@ -728,6 +736,16 @@ unsigned int BosonCanvasRenderer::renderedItems() const
  return d->mRenderedItems;
 }
 
+unsigned int BosonCanvasRenderer::testedItemNodes() const
+{
+ return d->mItemCuller->testedNodes();
+}
+
+unsigned int BosonCanvasRenderer::acceptedItemNodes() const
+{
+ return d->mItemCuller->acceptedNodes();
+}
+
 unsigned int BosonCanvasRenderer::renderedCells() const
 {
  return d->mRenderedCells;
@@ -769,7 +787,7 @@ void BosonCanvasRenderer::reset()
  d->mSceneRenderTargetCache->deleteAllRenderTargets();
 }
 
-void BosonCanvasRenderer::paintGL(const QPtrList<BosonItemContainer>& allItems, const QPtrList<BosonEffect>& effects)
+void BosonCanvasRenderer::paintGL(const QPtrList<BosonEffect>& effects)
 {
  PROFILE_METHOD;
  BO_CHECK_NULL_RET(localPlayerIO());
@@ -799,7 +817,7 @@ void BosonCanvasRenderer::paintGL(const QPtrList<BosonItemContainer>& allItems,
 
 
  // Create list of visible items
- createRenderItemList(&d->mRenderItemList, &d->mRadarContactsList, allItems); // AB: this is very fast. < 1.5ms on experimental5 for me
+ createRenderItemList(&d->mRenderItemList, &d->mRadarContactsList); // AB: this is very fast. < 1.5ms on experimental5 for me
 
  // Create list of visible terrain chunks and calculate their min/max distance
  // Not necessary, it's done in BosonGameView::cameraChanged()
@@ -1478,12 +1496,24 @@ void BosonCanvasRenderer::stopRenderingToTexture()
  glPopAttrib();
 }
 
-void BosonCanvasRenderer::createRenderItemList(QValueVector<BoRenderItem>* renderItemList, QValueList<Unit*>* radarContactList, const QPtrList<BosonItemContainer>& allItems)
+void BosonCanvasRenderer::createRenderItemList(QValueVector<BoRenderItem>* renderItemList, QValueList<Unit*>* radarContactList)
 {
  BO_CHECK_NULL_RET(localPlayerIO());
 
+ // Accept or reject whole nodes of the quadtree first and collect the items
+ // of the visible nodes only. Items in partially visible nodes are tested on
+ // their own.
+ d->mItemCuller->cullNodes(viewFrustum());
+ d->mItemCuller->collectItems(&d->mCulledItems);
+
+ // shots are not in any cell, so they are never collected
+ const QPtrList<BosonItemContainer>& shots = boViewData->shotItemContainers();
+ for (QPtrListIterator<BosonItemContainer> it(shots); it.current(); ++it) {
+	d->mCulledItems.append(BoCulledItem(it.current()->item(), 0, BoItemFrustumCuller::PartiallyVisible));
+ }
+
  renderItemList->clear();
- renderItemList->reserve(allItems.count());
+ renderItemList->reserve(d->mCulledItems.count());
  radarContactList->clear();
 
  d->mMinItemDist = 1000000.0f;
@@ -1491,29 +1521,30 @@ void BosonCanvasRenderer::createRenderItemList(QValueVector<BoRenderItem>* rende
 
  BoVector3Float camerapos = camera()->cameraPos();
 
- for (QPtrListIterator<BosonItemContainer> it(allItems); it.current(); ++it) {
-	BosonItem* item = it.current()->item();
-	BosonItemRenderer* itemRenderer = it.current()->itemRenderer();
+ for (unsigned int i = 0; i < d->mCulledItems.count(); i++) {
+	const BoCulledItem& culled = d->mCulledItems[i];
+	BosonItem* item = culled.item;
+	BosonItemContainer* container = boViewData->itemContainer(item);
+	if (!container) {
+		continue;
+	}
+	BosonItemRenderer* itemRenderer = container->itemRenderer();
 
 	if (!item->isVisible() || !itemRenderer) {
 		continue;
 	}
 
-	// TODO: performance: we can improve this greatly:
-	// simply group the items to bigger sphere or boxes. every box is of
-	// size of (maybe) 10.0*10.0. We maintain a list of items for *every*
-	// box. we can simply test if the box is in the frustum and if so we
-	// test every item of that list. if not we can skip every item of that
-	// box.
-	// Especially in bigger games with big maps and several hundred units
-	// this would be a great speedup.
-	// UPDATE: probably not *that* big, as rendering itself is a bigger
-	// bottleneck.
-
-	// UPDATE: we could instead use the "sectors" that we are planning to
-	// use for collision detection and pathfinding also for the frustum
-	// tests (they wouldn't do floating point calculations)
-	float dist = itemRenderer->itemInFrustum(viewFrustum());
+	// this is the bounding sphere used by
+	// BosonItemRenderer::itemInFrustum()
+	const float radius = itemRenderer->boundingSphereRadius();
+	BoVector3Float center(item->centerX(), -item->centerY(), item->z() + item->depth() / 2);
+	float dist;
+	if (BoItemFrustumCuller::itemVisibility(culled, center, radius) == BoItemFrustumCuller::CompletelyVisible) {
+		// distance from the near plane, as returned by itemInFrustum()
+		dist = viewFrustum().near().distance(center) + radius;
+	} else {
+		dist = itemRenderer->itemInFrustum(viewFrustum());
+	}
 	if (dist == 0.0f) {
 		// the unit is not visible, currently. no need to draw anything.
 		continue;
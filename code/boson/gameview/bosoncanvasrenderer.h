@@ -86,7 +86,7 @@ public:
 	void setGameGLMatrices(const BoGLMatrices*);
 	void setCamera(BoGameCamera* camera);
 	void setLocalPlayerIO(PlayerIO* io);
-	void setCanvas(const BosonCanvas* canvas);
+	void setCanvas(BosonCanvas* canvas);
 
 	void setParticlesDirty(bool dirty);
 
@@ -100,12 +100,14 @@ public:
 	 * The method assumes that the projection has been set already. Same
 	 * about the camera settings.
 	 *
-	 * @param allItems A list of all BosonItemContainer objects existing in
-	 * the game.
+	 * The items are taken from the cells of the canvas (and @ref
+	 * BosonViewData::shotItemContainers), so that the items in parts of the
+	 * map that are not visible are never looked at.
+	 *
 	 * @param effects A list of all BosonEffect objects existing in the
 	 * game.
 	 **/
-	void paintGL(const QPtrList<BosonItemContainer>& allItems, const QPtrList<BosonEffect>& effects);
+	void paintGL(const QPtrList<BosonEffect>& effects);
 
 	/**
 	 * Uses the list of currently visible items to emulate OpenGL "picking"
@@ -121,6 +123,19 @@ public:
 	QValueList<BosonItem*> emulatePickItems(const QRect& pickRect) const;
 
 	unsigned int renderedItems() const;
+
+	/**
+	 * @return The number of quadtree nodes that were tested against the
+	 * view frustum for the items in the last frame.
+	 **/
+	unsigned int testedItemNodes() const;
+
+	/**
+	 * @return The number of quadtree nodes that were completely inside the
+	 * view frustum in the last frame, i.e. whose items were accepted
+	 * without testing them.
+	 **/
+	unsigned int acceptedItemNodes() const;
 	unsigned int renderedCells() const;
 	unsigned int renderedParticles() const;
 	int textureBindsCells() const;
@@ -151,7 +166,7 @@ protected:
 	void renderBulletTrailEffects(BoVisibleEffects& visible);
 	void renderFadeEffects(BoVisibleEffects& visible, bool enableShaderEffects);
 	void renderPathLines(const BosonCanvas* canvas, QValueList<QPoint>& path, bool isFlying, float _z);
-	void createRenderItemList(QValueVector<BoRenderItem>* renderItemList, QValueList<Unit*>* radarContactList, const QPtrList<BosonItemContainer>& allItems);
+	void createRenderItemList(QValueVector<BoRenderItem>* renderItemList, QValueList<Unit*>* radarContactList);
 	void createSelectionsList(BoItemList* selections, const QValueVector<BoRenderItem>* relevantItems);
 	void createVisibleEffectsList(BoVisibleEffects*, const QPtrList<BosonEffect>& allEffects, unsigned int mapWidth, unsigned int mapHeight);
 
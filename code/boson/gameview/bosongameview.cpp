@@ -1309,7 +1309,7 @@ void BosonGameView::initUfoGUI()
  d->mUfoCanvasWidget = new BosonUfoCanvasWidget();
  d->mUfoCanvasWidget->setGameGLMatrices(d->mGameGLMatrices);
  d->mUfoCanvasWidget->setCamera(&d->mCamera);
- d->mUfoCanvasWidget->setCanvas(canvas());
+ d->mUfoCanvasWidget->setCanvas(mCanvas);
  d->mLeftButtonState->setUfoCanvasWidget(d->mUfoCanvasWidget);
 
  d->mUfoPlacementPreviewWidget = new BosonUfoPlacementPreviewWidget();
@@ -1518,10 +1518,8 @@ void BosonGameView::setLocalPlayerIO(PlayerIO* io)
 				this, SLOT(slotExplored(int, int)));
 		io->connect(SIGNAL(signalUnexplored(int, int)),
 				this, SLOT(slotUnexplored(int, int)));
-		io->connect(SIGNAL(signalFog(int, int)),
-				this, SLOT(slotFog(int, int)));
-		io->connect(SIGNAL(signalUnfog(int, int)),
-				this, SLOT(slotUnfog(int, int)));
+		io->connect(SIGNAL(signalFogChanged(int, int, int, int)),
+				this, SLOT(slotFogChanged(int, int, int, int)));
 		if (boGame->gameMode()) {
 			d->mGLMiniMap->slotShowMiniMap(io->hasMiniMap());
 		} else {
@@ -1626,19 +1624,11 @@ void BosonGameView::slotUnexplored(int x, int y)
  boWaterRenderer->cellExploredChanged(x, y, x, y);
 }
 
-void BosonGameView::slotFog(int x, int y)
-{
-	BoGroundRenderer* r = BoGroundRendererManager::manager()->currentRenderer();
-	if (r) {
-		r->cellFogChanged(x, y, x, y);
-	}
-}
-
-void BosonGameView::slotUnfog(int x, int y)
+void BosonGameView::slotFogChanged(int x1, int y1, int x2, int y2)
 {
 	BoGroundRenderer* r = BoGroundRendererManager::manager()->currentRenderer();
 	if (r) {
-		r->cellFogChanged(x, y, x, y);
+		r->cellFogChanged(x1, y1, x2, y2);
 	}
 }
 
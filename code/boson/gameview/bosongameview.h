@@ -580,8 +580,7 @@ public slots:
 
 	void slotExplored(int x, int y);
 	void slotUnexplored(int x, int y);
-	void slotFog(int x, int y);
-	void slotUnfog(int x, int y);
+	void slotFogChanged(int x1, int y1, int x2, int y2);
 
 	void slotChangeTexMap(int x, int y);
 	void slotChangeHeight(int x, int y);
@@ -61,6 +61,10 @@ protected:
 	{
 		return 0;
 	}
+	virtual bool processesEvent(const QCString& name) const
+	{
+		return (name == "FacilityWithTypeConstructed");
+	}
 
 private:
 	const BosonCanvas* mCanvas;
@@ -197,7 +197,7 @@ void BosonLocalPlayerInput::stopUnits(const QPtrList<Unit>& units)
     return;
   }
 
-  QDataStream msg(b, IO_WriteOnly);
+  QDataStream msg(b, IO_ReadOnly);
   sendInput(msg);
 }
 
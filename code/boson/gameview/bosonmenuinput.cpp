@@ -1067,11 +1067,10 @@ void BosonMenuInput::slotUnfogAll(Player* pl)
  }
  for (unsigned int i = 0; i < list.count(); i++) {
 	Player* p = list.at(i);
-	for (unsigned int x = 0; x < map->width(); x++) {
-		for (unsigned int y = 0; y < map->height(); y++) {
-			p->addFogRef(x, y);
-		}
+	for (unsigned int y = 0; y < map->height(); y++) {
+		p->addFogRefs(y, 0, map->width() - 1);
 	}
+	p->flushFogChanges();
 	boGame->slotAddChatSystemMessage(i18n("Debug"), i18n("Unfogged player %1 - %2").arg(p->bosonId()).arg(p->name()));
  }
 }
@@ -1099,11 +1098,10 @@ void BosonMenuInput::slotFogAll(Player* pl)
  }
  for (unsigned int i = 0; i < list.count(); i++) {
 	Player* p = list.at(i);
-	for (unsigned int x = 0; x < map->width(); x++) {
-		for (unsigned int y = 0; y < map->height(); y++) {
-			p->removeFogRef(x, y);
-		}
+	for (unsigned int y = 0; y < map->height(); y++) {
+		p->removeFogRefs(y, 0, map->width() - 1);
 	}
+	p->flushFogChanges();
 	boGame->slotAddChatSystemMessage(i18n("Debug"), i18n("Fogged player %1 - %2").arg(p->bosonId()).arg(p->name()));
  }
 }
@@ -234,7 +234,7 @@ void BosonUfoCanvasWidget::setLocalPlayerIO(PlayerIO* io)
  d->mCanvasRenderer->setLocalPlayerIO(d->mLocalPlayerIO);
 }
 
-void BosonUfoCanvasWidget::setCanvas(const BosonCanvas* canvas)
+void BosonUfoCanvasWidget::setCanvas(BosonCanvas* canvas)
 {
  if (d->mCanvas) {
 	disconnect(d->mCanvas, 0, this, 0);
@@ -242,7 +242,7 @@ void BosonUfoCanvasWidget::setCanvas(const BosonCanvas* canvas)
  delete d->mGroundQuadTree;
  d->mGroundQuadTree = 0;
  d->mCanvas = canvas;
- d->mCanvasRenderer->setCanvas(d->mCanvas);
+ d->mCanvasRenderer->setCanvas(canvas);
  if (d->mCanvas) {
 	connect(d->mCanvas, SIGNAL(signalShotFired(BosonShot*, BosonWeapon*)),
 		this, SLOT(slotShotFired(BosonShot*, BosonWeapon*)));
@@ -1103,7 +1103,7 @@ void BosonUfoCanvasWidget::paintWidget()
 		d->mGameGLMatrices->viewport()[2],
 		d->mGameGLMatrices->viewport()[3]);
 
- d->mCanvasRenderer->paintGL(boViewData->allItemContainers(), d->mEffects);
+ d->mCanvasRenderer->paintGL(d->mEffects);
 
  glPopAttrib();
 
@@ -82,7 +82,7 @@ public:
 	void setGameGLMatrices(const BoGLMatrices*);
 	void setCamera(BoGameCamera* c);
 	void setLocalPlayerIO(PlayerIO* io);
-	void setCanvas(const BosonCanvas* canvas);
+	void setCanvas(BosonCanvas* canvas);
 
 	virtual void paintWidget();
 
@@ -732,6 +732,7 @@ void BosonUfoGameGUI::updateUfoLabelRenderCounts()
 #define HAVE_CANVAS_RENDERER 0
 #if HAVE_CANVAS_RENDERER
  text += i18n("Items rendered: %1\n").arg(d->mCanvasRenderer->renderedItems());
+ text += i18n("Item nodes tested: %1 (accepted: %2)\n").arg(d->mCanvasRenderer->testedItemNodes()).arg(d->mCanvasRenderer->acceptedItemNodes());
  text += i18n("Particles rendered: %1\n").arg(d->mCanvasRenderer->renderedParticles());
 #endif
 
@@ -54,6 +54,25 @@ bool BoCommandFrameEventListener::canSee(const BoEvent* event) const
  return playerIO()->canSee(event->location());
 }
 
+bool BoCommandFrameEventListener::processesEvent(const QCString& name) const
+{
+ if (name == "FacilityWithTypeConstructed" ||
+		name == "ProducedUnitWithTypePlaced" ||
+		name == "TechnologyWithTypeResearched" ||
+		name == "UnitWithTypeDestroyed" ||
+		name == "StartProductionOfUnitWithType" ||
+		name == "StartProductionOfTechnologyWithType" ||
+		name == "PauseProductionOfUnitWithType" ||
+		name == "PauseProductionOfTechnologyWithType" ||
+		name == "ContinueProductionOfUnitWithType" ||
+		name == "ContinueProductionOfTechnologyWithType" ||
+		name == "StopProductionOfUnitWithType" ||
+		name == "StopProductionOfTechnologyWithType") {
+	return true;
+ }
+ return false;
+}
+
 void BoCommandFrameEventListener::processEvent(const BoEvent* event)
 {
  if (event->playerId() == 0) {
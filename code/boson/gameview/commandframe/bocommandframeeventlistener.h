@@ -77,6 +77,7 @@ protected:
 	{
 		return 0;
 	}
+	virtual bool processesEvent(const QCString& name) const;
 
 private:
 	BoCommandFrameEventListenerPrivate* d;
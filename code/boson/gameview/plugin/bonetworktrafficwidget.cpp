@@ -39,12 +39,14 @@ public:
 		mMostTraffic = 0;
 		mRecentlySent = 0;
 		mRecentlyReceived = 0;
+		mPlayerInput = 0;
 	}
 	BoUfoLabel* mTotalSent;
 	BoUfoLabel* mTotalReceived;
 	BoUfoLabel* mMostTraffic;
 	BoUfoLabel* mRecentlySent;
 	BoUfoLabel* mRecentlyReceived;
+	BoUfoLabel* mPlayerInput;
 };
 
 
@@ -59,11 +61,13 @@ BoNetworkTrafficWidget::BoNetworkTrafficWidget()
  d->mMostTraffic = new BoUfoLabel();
  d->mRecentlySent = new BoUfoLabel();
  d->mRecentlyReceived = new BoUfoLabel();
+ d->mPlayerInput = new BoUfoLabel();
  addWidget(d->mTotalSent);
  addWidget(d->mTotalReceived);
  addWidget(d->mMostTraffic);
  addWidget(d->mRecentlySent);
  addWidget(d->mRecentlyReceived);
+ addWidget(d->mPlayerInput);
 
  setLayoutClass(BoUfoWidget::UVBoxLayout);
 }
@@ -140,4 +144,19 @@ void BoNetworkTrafficWidget::slotUpdate()
  }
  d->mRecentlySent->setText(i18n("Bytes sent in last %1 seconds: %2").arg(pastSeconds).arg(trafficSent));
  d->mRecentlyReceived->setText(i18n("Bytes received in last %1 seconds: %2").arg(pastSeconds).arg(trafficReceived));
+
+ unsigned int playerInputs = 0;
+ long long playerInputBytes = 0;
+ long long playerInputUncompressedBytes = 0;
+ for (QPtrListIterator<BosonNetworkTrafficPlayerInputStatistics> it(traffic->playerInputStatistics()); it.current(); ++it) {
+	playerInputs += it.current()->messages();
+	playerInputBytes += it.current()->bytes();
+	playerInputUncompressedBytes += it.current()->uncompressedBytes();
+ }
+ d->mPlayerInput->setText(i18n("Player input: %1 orders in %2 messages (%3 bytes). Orders: %4 bytes, uncompressed: %5 bytes")
+		.arg(playerInputs)
+		.arg(traffic->playerInputBatchesSent())
+		.arg(traffic->playerInputBatchBytesSent())
+		.arg(playerInputBytes)
+		.arg(playerInputUncompressedBytes));
 }
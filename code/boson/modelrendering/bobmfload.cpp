@@ -27,15 +27,23 @@
 #include "../../bobmfconverter/bmf.h"
 #include "bodebug.h"
 #include "bosonprofiling.h"
+#include "../gameengine/bofilehashcache.h"
 
 #include <qfile.h>
 #include <qdatastream.h>
 #include <qapplication.h>
+#include <qstringlist.h>
+#include <qtextstream.h>
+#include <qdir.h>
+#include <qmap.h>
 
 #include <kmdcodec.h>
 #include <kglobal.h>
 #include <kstandarddirs.h>
 #include <kprocess.h>
+#include <ktempfile.h>
+
+#include <sys/mman.h>
 
 
 #define MIN_SUPPORTED_VERSION BMF_MAKE_VERSION_CODE(0, 1, 1)
@@ -108,6 +116,22 @@ bool BoBMFLoad::loadModel()
         QString::number(BMF_VERSION_CODE, 16) << endl;
     return false;
   }
+  if(versioncode > BMF_VERSION_CODE)
+  {
+    boError(100) << k_funcinfo << "BMF version 0x" << QString::number(versioncode, 16) <<
+        " is newer than the current version 0x" << QString::number(BMF_VERSION_CODE, 16) << endl;
+    return false;
+  }
+
+  // Newer files start with the arrays, so that they can be mapped
+  bool mappedarrays = (versioncode >= BMF_VERSION_CODE_MAPPED_ARRAYS);
+  if(mappedarrays)
+  {
+    if(!loadMappedArrays(f, stream))
+    {
+      return false;
+    }
+  }
 
   Q_UINT32 magic;
   stream >> magic;
@@ -126,7 +150,7 @@ bool BoBMFLoad::loadModel()
     return false;
   }
   // Arrays
-  if(!loadArrays(stream))
+  if(!mappedarrays && !loadArrays(stream))
   {
     return false;
   }
@@ -281,6 +305,110 @@ bool BoBMFLoad::loadArrays(QDataStream& stream)
   return true;
 }
 
+bool BoBMFLoad::loadMappedArrays(QFile& file, QDataStream& stream)
+{
+  BosonProfiler profiler("BoBMFLoad::loadMappedArrays()");
+  Q_UINT32 magic;
+  stream >> magic;
+  if(magic != BMF_MAGIC_ARRAYS)
+  {
+    boError(100) << k_funcinfo << "Loading failed (no arrays section found)!" << endl;
+    return false;
+  }
+
+  Q_UINT32 points, indices, indextype;
+  Q_UINT32 pointoffset, indexoffset, modeloffset;
+  stream >> points;
+  stream >> indices;
+  stream >> indextype;
+  stream >> pointoffset;
+  stream >> indexoffset;
+  stream >> modeloffset;
+
+  unsigned int indexsize;
+  if(indextype == BMF_DATATYPE_UNSIGNED_SHORT)
+  {
+    indexsize = sizeof(Q_UINT16);
+  }
+  else if(indextype == BMF_DATATYPE_UNSIGNED_INT)
+  {
+    indexsize = sizeof(Q_UINT32);
+  }
+  else
+  {
+    boError(100) << k_funcinfo << "Loading failed (invalid index type " << indextype << ")!" << endl;
+    return false;
+  }
+  const unsigned int pointsize = 8 * sizeof(float);
+  if(points > (0x1 << 22) || indices > (0x1 << 24))
+  {
+    boError(100) << k_funcinfo << "Loading failed (too many points or indices)!" << endl;
+    return false;
+  }
+  if((pointoffset % BMF_ARRAY_ALIGNMENT) != 0 || (indexoffset % BMF_ARRAY_ALIGNMENT) != 0 ||
+      modeloffset > file.size() || indexoffset > modeloffset || pointoffset > indexoffset ||
+      pointoffset + points * pointsize > indexoffset ||
+      indexoffset + indices * indexsize > modeloffset)
+  {
+    boError(100) << k_funcinfo << "Loading failed (invalid array offsets)!" << endl;
+    return false;
+  }
+
+  // The arrays are little-endian, so they can be used directly on
+  //  little-endian systems only.
+  int wordsize;
+  bool bigendian;
+  qSysInfo(&wordsize, &bigendian);
+  void* mapping = MAP_FAILED;
+  if(!bigendian && modeloffset > 0)
+  {
+    mapping = mmap(0, modeloffset, PROT_READ, MAP_PRIVATE, file.handle(), 0);
+    if(mapping == MAP_FAILED)
+    {
+      boWarning(100) << k_funcinfo << "could not map " << file.name() << ", reading arrays instead" << endl;
+    }
+  }
+
+  if(mapping != MAP_FAILED)
+  {
+    char* base = (char*)mapping;
+    mModel->setMappedArrays(mapping, modeloffset,
+        (float*)(base + pointoffset), points,
+        (unsigned char*)(base + indexoffset), indices, indextype);
+  }
+  else
+  {
+    mModel->allocatePointArray(points);
+    mModel->allocateIndexArray(indices, indextype);
+    if(!file.at(pointoffset) ||
+        file.readBlock((char*)mModel->pointArray(), points * pointsize) != (int)(points * pointsize))
+    {
+      boError(100) << k_funcinfo << "Loading failed (could not read point array)!" << endl;
+      return false;
+    }
+    if(!file.at(indexoffset) ||
+        file.readBlock((char*)mModel->indexArray(), indices * indexsize) != (int)(indices * indexsize))
+    {
+      boError(100) << k_funcinfo << "Loading failed (could not read index array)!" << endl;
+      return false;
+    }
+    if(bigendian)
+    {
+      convertToBigEndian((char*)mModel->pointArray(), points * 8, sizeof(float));
+      convertToBigEndian((char*)mModel->indexArray(), indices, indexsize);
+    }
+  }
+
+  // The model chunk follows the arrays
+  if(!file.at(modeloffset))
+  {
+    boError(100) << k_funcinfo << "Loading failed (could not seek to model chunk)!" << endl;
+    return false;
+  }
+
+  return true;
+}
+
 bool BoBMFLoad::loadTextures(QDataStream& stream)
 {
   Q_UINT32 magic;
@@ -580,14 +708,14 @@ QString BoBMFLoad::cachedModelFilename(const QString& modelfile, const QString&
   if(!cachedmodel.isEmpty())
   {
     Q_UINT32 versioncode = getVersion(cachedmodel);
-    if(versioncode >= MIN_SUPPORTED_VERSION)
+    if(versioncode >= MIN_SUPPORTED_VERSION && versioncode <= BMF_VERSION_CODE)
     {
       // File exists and is up-to-date
       return cachedmodel;
     }
     else
     {
-      // Cached model is too old
+      // Cached model is too old (or was written by a newer version)
       // TODO: maybe delete the obsolete model?
       return QString::null;
     }
@@ -595,16 +723,32 @@ QString BoBMFLoad::cachedModelFilename(const QString& modelfile, const QString&
   return QString::null;
 }
 
-QString BoBMFLoad::convertModel(const QString& modelfile, const QString& configfile)
+QString BoBMFLoad::converterExecutable()
 {
-  QCString hash = calculateHash(modelfile, configfile);
+  // Find path to bobmfconverter binary
+  QString converter = KGlobal::dirs()->findResource("exe", "bobmfconverter");
+  if(converter.isEmpty())
+  {
+    converter = KGlobal::dirs()->findExe("bobmfconverter");
+    if(converter.isEmpty())
+    {
+      boError() << k_funcinfo << "Couldn't find bobmfconverter!" << endl;
+      return QString::null;
+    }
+  }
+  return converter;
+}
+
+QStringList BoBMFLoad::converterArguments(const QString& modelfile, const QString& configfile, const QCString& hash)
+{
+  QStringList args;
 
   // Get the path where the cached model can be saved
   QString cachedmodel = KGlobal::dirs()->saveLocation("data", "boson/modelcache/");
   if(cachedmodel.isEmpty())
   {
     boError() << k_funcinfo << "Failed to get save location for cached model" << endl;
-    return QString::null;
+    return args;
   }
   cachedmodel += QString("model-%1.bmf").arg(hash);
   // Get path for saved textures
@@ -612,33 +756,40 @@ QString BoBMFLoad::convertModel(const QString& modelfile, const QString& configf
   if(texturepath.isEmpty())
   {
     boError() << k_funcinfo << "Failed to get save location for textures" << endl;
+    return args;
+  }
+
+  // Add default cmdline args
+  args << "-texnametolower" <<  "-useboth" << "-resetmaterials";
+  args << "-texoptimize" << "-texpath" << texturepath << "-texname" << "unittex-"+hash+".jpg";
+  args << "-t" << KGlobal::dirs()->findResourceDir("data", "boson/themes/textures/concrt1.jpg") + "/boson/themes/textures/";
+  args << "-o" << cachedmodel;
+  if(!configfile.isEmpty())
+  {
+    args << "-c" << configfile;
+  }
+  args << modelfile;
+  args << "-comment" << QString("Automatically converted from file '%1'").arg(modelfile);
+  return args;
+}
+
+QString BoBMFLoad::convertModel(const QString& modelfile, const QString& configfile)
+{
+  QCString hash = calculateHash(modelfile, configfile);
+  QStringList args = converterArguments(modelfile, configfile, hash);
+  if(args.isEmpty())
+  {
     return QString::null;
   }
-  // Find path to bobmfconverter binary
-  QString converter = KGlobal::dirs()->findResource("exe", "bobmfconverter");
+  QString converter = converterExecutable();
   if(converter.isEmpty())
   {
-    converter = KGlobal::dirs()->findExe("bobmfconverter");
-    if(converter.isEmpty())
-    {
-      boError() << k_funcinfo << "Couldn't find bobmfconverter!" << endl;
-      return QString::null;
-    }
+    return QString::null;
   }
   // Create KProcess object
   KProcess proc;
   proc << converter;
-  // Add default cmdline args
-  proc << "-texnametolower" <<  "-useboth" << "-resetmaterials";
-  proc << "-texoptimize" << "-texpath" << texturepath << "-texname" << "unittex-"+hash+".jpg";
-  proc << "-t" << KGlobal::dirs()->findResourceDir("data", "boson/themes/textures/concrt1.jpg") + "/boson/themes/textures/";
-  proc << "-o" << cachedmodel;
-  if(!configfile.isEmpty())
-  {
-    proc << "-c" << configfile;
-  }
-  proc << modelfile;
-  proc << "-comment" << QString("Automatically converted from file '%1'").arg(modelfile);
+  proc << args;
 
   // FIXME: KProcess:Block ain't pretty here...
   if(!proc.start(KProcess::Block))
@@ -648,7 +799,7 @@ QString BoBMFLoad::convertModel(const QString& modelfile, const QString& configf
   }
 
   QString modelcacheFileName = QString("%1/model-%2.bmf").arg("boson/modelcache").arg(hash);
-  cachedmodel = KGlobal::dirs()->findResource("data", modelcacheFileName);
+  QString cachedmodel = KGlobal::dirs()->findResource("data", modelcacheFileName);
   if(cachedmodel.isEmpty())
   {
     QString args;
@@ -669,8 +820,134 @@ QString BoBMFLoad::convertModel(const QString& modelfile, const QString& configf
   return cachedmodel;
 }
 
+bool BoBMFLoad::convertModels(const QStringList& modelfiles, const QStringList& configfiles)
+{
+  if(modelfiles.count() != configfiles.count())
+  {
+    boError() << k_funcinfo << "need exactly one config file per model file" << endl;
+    return false;
+  }
+  BosonProfiler prof("BoBMFLoad::convertModels()");
+
+  // Collect the models that are not in the cache yet. Models with the same
+  //  hash (e.g. the same model used by two species) are converted once only.
+  QMap<QCString, QString> missing;
+  KTempFile batchFile;
+  batchFile.setAutoDelete(true);
+  QTextStream* stream = batchFile.textStream();
+  if(!stream)
+  {
+    boError() << k_funcinfo << "Couldn't create textstream object for KTempFile" << endl;
+    return false;
+  }
+  for(unsigned int i = 0; i < modelfiles.count(); i++)
+  {
+    if(!cachedModelFilename(modelfiles[i], configfiles[i]).isNull())
+    {
+      continue;
+    }
+    QCString hash = calculateHash(modelfiles[i], configfiles[i]);
+    if(hash.isEmpty() || missing.contains(hash))
+    {
+      continue;
+    }
+    QStringList args = converterArguments(modelfiles[i], configfiles[i], hash);
+    if(args.isEmpty())
+    {
+      return false;
+    }
+    missing.insert(hash, modelfiles[i]);
+
+    // One model per line, the arguments are separated by tabs
+    (*stream) << args.join("\t") << endl;
+  }
+  batchFile.close();
+  if(missing.isEmpty())
+  {
+    return true;
+  }
+
+  QString converter = converterExecutable();
+  if(converter.isEmpty())
+  {
+    return false;
+  }
+  boDebug(100) << k_funcinfo << "converting " << missing.count() << " models" << endl;
+  KProcess proc;
+  proc << converter << "-batch" << batchFile.name();
+  if(!proc.start(KProcess::Block))
+  {
+    boError() << k_funcinfo << "Error while trying to convert the models" << endl;
+    return false;
+  }
+
+  bool ret = true;
+  for(QMap<QCString, QString>::iterator it = missing.begin(); it != missing.end(); ++it)
+  {
+    QString modelcacheFileName = QString("%1/model-%2.bmf").arg("boson/modelcache").arg(it.key());
+    if(KGlobal::dirs()->findResource("data", modelcacheFileName).isEmpty())
+    {
+      boError() << k_funcinfo << "bobmfconverter did not write file." << endl
+        << "input file: " << it.data() << endl
+        << "expected output file: " << modelcacheFileName << endl;
+      ret = false;
+    }
+  }
+  return ret;
+}
+
+bool BoBMFLoad::prewarmModelCache()
+{
+  QStringList modelfiles;
+  QStringList configfiles;
+  findUnitModels(&modelfiles, &configfiles);
+  return convertModels(modelfiles, configfiles);
+}
+
+QStringList BoBMFLoad::unitModelFiles()
+{
+  QStringList list;
+  list.append("unit.3ds");
+  list.append("unit.ac");
+  list.append("unit.md2");
+  return list;
+}
+
+void BoBMFLoad::findUnitModels(QStringList* modelfiles, QStringList* configfiles)
+{
+  BO_CHECK_NULL_RET(modelfiles);
+  BO_CHECK_NULL_RET(configfiles);
+  QStringList modelFileNames = unitModelFiles();
+  QStringList unitFiles = KGlobal::dirs()->findAllResources("data", "boson/themes/species/*/units/*/index.unit");
+  for(QStringList::iterator it = unitFiles.begin(); it != unitFiles.end(); ++it)
+  {
+    QString unitPath = (*it).left((*it).length() - QString("index.unit").length());
+    for(QStringList::iterator fileIt = modelFileNames.begin(); fileIt != modelFileNames.end(); ++fileIt)
+    {
+      if(QFile::exists(unitPath + *fileIt))
+      {
+        modelfiles->append(unitPath + *fileIt);
+        configfiles->append(*it);
+        break;
+      }
+    }
+  }
+  boDebug(100) << k_funcinfo << "found " << modelfiles->count() << " unit models" << endl;
+}
+
 QCString BoBMFLoad::calculateHash(const QString& modelfilename, const QString& configfilename)
 {
+  // The sum may have been calculated by a worker thread already, see
+  //  BosonStartingLoadPlayerGUIData
+  QStringList files;
+  files.append(modelfilename);
+  files.append(configfilename);
+  QCString hash;
+  if(BoFileHashCache::hash(files, &hash))
+  {
+    return hash;
+  }
+
   QFile modelfile(modelfilename);
   if(!modelfile.open(IO_ReadOnly))
   {
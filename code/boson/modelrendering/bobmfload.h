@@ -27,6 +27,7 @@
 class KSimpleConfig;
 class QString;
 class QStringList;
+class QFile;
 class BoMesh;
 class BoFrame;
 class BosonModel;
@@ -61,6 +62,43 @@ class BoBMFLoad
      **/
     static QString convertModel(const QString& modelfile, const QString& configfile);
 
+    /**
+     * Converts all models in @p modelfiles (using the config file with the
+     * same index in @p configfiles) that are not in the model cache yet.
+     * This starts a single bobmfconverter process that converts the models
+     * in parallel, which is a lot faster than calling @ref convertModel for
+     * every model. The converter cannot be called in-process, as its own
+     * math classes clash with the ones of the game (see
+     * bobmfconverter/CMakeLists.txt).
+     * @return TRUE if all models are in the cache afterwards.
+     **/
+    static bool convertModels(const QStringList& modelfiles, const QStringList& configfiles);
+
+    /**
+     * Convert the models of all units of all species into the model cache,
+     * so that starting the first game does not have to wait for model
+     * conversions.
+     **/
+    static bool prewarmModelCache();
+
+    /**
+     * @return The possible file names of the model of a unit, in the order
+     * in which they are tried. See also @ref SpeciesData::unitModelFiles.
+     **/
+    static QStringList unitModelFiles();
+
+    /**
+     * Find the model files of all units of all species and the config
+     * files (index.unit) that belong to them.
+     **/
+    static void findUnitModels(QStringList* modelfiles, QStringList* configfiles);
+
+    /**
+     * @return The absolute path of the bobmfconverter binary, or a null
+     * string if it could not be found.
+     **/
+    static QString converterExecutable();
+
 
   protected:
     bool loadInfo(QDataStream& stream);
@@ -72,6 +110,14 @@ class BoBMFLoad
     bool loadFrames(QDataStream& stream, int lod);
     bool loadArrays(QDataStream& stream);
 
+    /**
+     * Load the arrays of a file that stores them at the beginning (see
+     * bmf.h). The arrays are mapped into memory and used by the model
+     * directly, if possible. The @p file is positioned at the model chunk
+     * afterwards.
+     **/
+    bool loadMappedArrays(QFile& file, QDataStream& stream);
+
 
     /**
     * @return The directory that contains the .3ds file. Usually the unit
@@ -80,6 +126,13 @@ class BoBMFLoad
     const QString& baseDirectory() const;
 
     static QCString calculateHash(const QString& modelfile, const QString& configfile);
+
+    /**
+     * @return The arguments for bobmfconverter (without the program name)
+     * that convert @p modelfile into the model cache file for @p hash, or
+     * an empty list if an error occured.
+     **/
+    static QStringList converterArguments(const QString& modelfile, const QString& configfile, const QCString& hash);
     static Q_UINT32 getVersion(const QString& modelfile);
 
     /**
@@ -43,6 +43,7 @@
 #include <qfile.h>
 
 #include <math.h>
+#include <sys/mman.h>
 
 
 
@@ -322,6 +323,22 @@ public:
 		mIndexArraySize = 0;
 		mIndexArrayType = 0;
 		mIndices = 0;
+		mMapping = 0;
+		mMappingSize = 0;
+	}
+
+	void unmapArrays()
+	{
+		if (!mMapping) {
+			return;
+		}
+		munmap(mMapping, mMappingSize);
+		mMapping = 0;
+		mMappingSize = 0;
+		mPoints = 0;
+		mPointArraySize = 0;
+		mIndices = 0;
+		mIndexArraySize = 0;
 	}
 
 	BoLOD* mLODs;
@@ -341,6 +358,10 @@ public:
 	unsigned int mIndexArrayType;
 	unsigned char* mIndices;
 
+	// The file mapping that contains mPoints and mIndices, if any
+	void* mMapping;
+	unsigned int mMappingSize;
+
 	float mBoundingSphereRadius;
 	BoVector3Float mMinCoord;
 	BoVector3Float mMaxCoord;
@@ -388,7 +409,12 @@ BosonModel::~BosonModel()
  d->mAnimations.clear();
  boDebug(100) << k_funcinfo << "delete " << d->mMaterialCount << " materials" << endl;
  delete[] d->mMaterials;
- delete[] d->mPoints;
+ if (d->mMapping) {
+	d->unmapArrays();
+ } else {
+	delete[] d->mPoints;
+	delete[] d->mIndices;
+ }
  delete d;
  boDebug(100) << k_funcinfo << "done" << endl;
 }
@@ -640,6 +666,10 @@ unsigned int BosonModel::pointArraySize() const
 
 void BosonModel::allocatePointArray(unsigned int size)
 {
+ if (d->mMapping) {
+	boWarning(100) << k_funcinfo << "Arrays already mapped!" << endl;
+	d->unmapArrays();
+ }
  if (d->mPoints) {
 	boWarning(100) << k_funcinfo << "Point array already allocated!" << endl;
 	delete[] d->mPoints;
@@ -670,6 +700,10 @@ unsigned int BosonModel::indexArrayType() const
 
 void BosonModel::allocateIndexArray(unsigned int size, unsigned int type)
 {
+ if (d->mMapping) {
+	boWarning(100) << k_funcinfo << "Arrays already mapped!" << endl;
+	d->unmapArrays();
+ }
  if (d->mIndices) {
 	boWarning(100) << k_funcinfo << "Index array already allocated!" << endl;
 	delete[] d->mIndices;
@@ -687,6 +721,24 @@ void BosonModel::allocateIndexArray(unsigned int size, unsigned int type)
  }
 }
 
+void BosonModel::setMappedArrays(void* mapping, unsigned int mappingSize, float* points, unsigned int pointCount, unsigned char* indices, unsigned int indexCount, unsigned int indexType)
+{
+ if (d->mMapping) {
+	boWarning(100) << k_funcinfo << "Arrays already mapped!" << endl;
+	d->unmapArrays();
+ } else {
+	delete[] d->mPoints;
+	delete[] d->mIndices;
+ }
+ d->mMapping = mapping;
+ d->mMappingSize = mappingSize;
+ d->mPoints = points;
+ d->mPointArraySize = pointCount;
+ d->mIndices = indices;
+ d->mIndexArraySize = indexCount;
+ d->mIndexArrayType = indexType;
+}
+
 void BosonModel::prepareRendering()
 {
  BoMeshRendererManager* manager = BoMeshRendererManager::manager();
@@ -335,6 +335,16 @@ public:
 	 **/
 	void allocateIndexArray(unsigned int size, unsigned int type);
 
+	/**
+	 * Use the arrays in a file that has been mapped into memory (see
+	 * mmap(2)) at @p mapping instead of allocating them. @p points and @p
+	 * indices must point into the mapping. The model takes ownership of
+	 * the mapping, it is unmapped when the model is deleted.
+	 *
+	 * Note that the arrays must not be modified.
+	 **/
+	void setMappedArrays(void* mapping, unsigned int mappingSize, float* points, unsigned int pointCount, unsigned char* indices, unsigned int indexCount, unsigned int indexType);
+
 	float boundingSphereRadius() const;
 	void setBoundingSphereRadius(float r);
 
@@ -0,0 +1,232 @@
+/*
+    This file is part of the Boson game
+    Copyright (C) 2008 The Boson Team (boson-devel@lists.sourceforge.net)
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "../bomemory/bodummymemory.h"
+#include <config.h>
+#include "../boversion.h"
+#include "bodebug.h"
+#include "../boapplication.h"
+#include "../botraceprofiling.h"
+#include "../modelrendering/bosonmodel.h"
+#include "../modelrendering/bobmfload.h"
+#include "../modelrendering/bomeshrenderermanager.h"
+#include "../../bobmfconverter/bmf.h"
+
+#include <kaboutdata.h>
+#include <kcmdlineargs.h>
+#include <klocale.h>
+#include <kprocess.h>
+#include <ktempdir.h>
+
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qstringlist.h>
+
+static const char *description =
+    I18N_NOOP("Compares the load times of the BMF file formats");
+
+static const char *version = BOSON_VERSION_STRING;
+
+static KCmdLineOptions options[] =
+{
+    { "iterations <count>", I18N_NOOP("Number of times every model is loaded"), "10" },
+    { 0, 0, 0 }
+};
+
+static bool convertModel(const QString& converter, const QString& modelfile, const QString& configfile, const QString& version, const QString& outfile);
+static bool loadModels(const QStringList& files, unsigned int iterations, Q_UINT64* time, Q_UINT32* checksum);
+static Q_UINT32 readArrays(const BosonModel* model);
+
+/**
+ * Converts all unit models into version 1 (arrays inside the model chunk) and
+ * version 2 (mapped arrays) of the BMF format and loads every file a few times
+ * using @ref BoBMFLoad.
+ **/
+int main(int argc, char **argv)
+{
+ KAboutData about("bobmfbenchmark",
+		I18N_NOOP("BoBMFBenchmark"),
+		version,
+		description,
+		KAboutData::License_GPL,
+		"(C) 2008 The Boson team",
+		0,
+		"http://boson.eu.org");
+
+ QCString argv0(argv[0]);
+ KCmdLineArgs::init(argc, argv, &about);
+ KCmdLineArgs::addCmdLineOptions(options);
+#if BOSON_LINK_STATIC
+ KApplication::disableAutoDcopRegistration();
+#endif
+
+ BoApplication app(argv0, false, false);
+
+ KCmdLineArgs* args = KCmdLineArgs::parsedArgs();
+ bool ok = false;
+ unsigned int iterations = QString(args->getOption("iterations")).toUInt(&ok);
+ if (!ok || iterations == 0) {
+	boError() << "invalid number of iterations" << endl;
+	return 1;
+ }
+ args->clear();
+
+ QString converter = BoBMFLoad::converterExecutable();
+ if (converter.isEmpty()) {
+	return 1;
+ }
+
+ QStringList modelfiles;
+ QStringList configfiles;
+ BoBMFLoad::findUnitModels(&modelfiles, &configfiles);
+ if (modelfiles.isEmpty()) {
+	boError() << "no unit models found" << endl;
+	return 1;
+ }
+
+ KTempDir tmpDir;
+ tmpDir.setAutoDelete(true);
+ if (tmpDir.status() != 0) {
+	boError() << "could not create temporary directory" << endl;
+	return 1;
+ }
+
+ QStringList files1;
+ QStringList files2;
+ for (unsigned int i = 0; i < modelfiles.count(); i++) {
+	QString file1 = tmpDir.name() + QString("model-%1-v1.bmf").arg(i);
+	QString file2 = tmpDir.name() + QString("model-%1-v2.bmf").arg(i);
+	if (!convertModel(converter, modelfiles[i], configfiles[i], "1", file1) ||
+			!convertModel(converter, modelfiles[i], configfiles[i], "2", file2)) {
+		boWarning() << "could not convert " << modelfiles[i] << ", skipping it" << endl;
+		continue;
+	}
+	files1.append(file1);
+	files2.append(file2);
+ }
+ boDebug() << "converted " << files1.count() << " of " << modelfiles.count() << " models" << endl;
+
+ BoMeshRendererManager::initStatic();
+
+ Q_UINT64 time1 = 0;
+ Q_UINT64 time2 = 0;
+ Q_UINT32 checksum1 = 0;
+ Q_UINT32 checksum2 = 0;
+ if (!loadModels(files1, iterations, &time1, &checksum1) || !loadModels(files2, iterations, &time2, &checksum2)) {
+	BoMeshRendererManager::deleteStatic();
+	return 1;
+ }
+ BoMeshRendererManager::deleteStatic();
+
+ unsigned int size1 = 0;
+ unsigned int size2 = 0;
+ for (unsigned int i = 0; i < files1.count(); i++) {
+	size1 += QFileInfo(files1[i]).size();
+	size2 += QFileInfo(files2[i]).size();
+ }
+
+ unsigned int loads = files1.count() * iterations;
+ boDebug() << files1.count() << " models, loaded " << iterations << " times:" << endl;
+ boDebug() << "  version 1: " << (unsigned int)(time1 / 1000) << " us total, "
+		<< (unsigned int)(time1 / loads / 1000) << " us per model, " << size1 << " bytes" << endl;
+ boDebug() << "  version 2: " << (unsigned int)(time2 / 1000) << " us total, "
+		<< (unsigned int)(time2 / loads / 1000) << " us per model, " << size2 << " bytes" << endl;
+ if (checksum1 != checksum2) {
+	boWarning() << "the versions contain different arrays (checksums "
+			<< checksum1 << " and " << checksum2 << ")" << endl;
+ }
+ return 0;
+}
+
+bool convertModel(const QString& converter, const QString& modelfile, const QString& configfile, const QString& version, const QString& outfile)
+{
+ // see BoBMFLoad::converterArguments(). we don't need textures here.
+ KProcess proc;
+ proc << converter;
+ proc << "-texnametolower" << "-useboth" << "-resetmaterials" << "-dontloadtex";
+ proc << "-bmfversion" << version;
+ proc << "-o" << outfile;
+ if (!configfile.isEmpty()) {
+	proc << "-c" << configfile;
+ }
+ proc << modelfile;
+ if (!proc.start(KProcess::Block)) {
+	boError() << k_funcinfo << "could not start " << converter << endl;
+	return false;
+ }
+ if (!proc.normalExit() || proc.exitStatus() != 0) {
+	return false;
+ }
+ return QFile::exists(outfile);
+}
+
+bool loadModels(const QStringList& files, unsigned int iterations, Q_UINT64* time, Q_UINT32* checksum)
+{
+ BO_CHECK_NULL_RET0(time);
+ BO_CHECK_NULL_RET0(checksum);
+ *time = 0;
+ *checksum = 0;
+ for (unsigned int i = 0; i < iterations; i++) {
+	for (QStringList::const_iterator it = files.begin(); it != files.end(); ++it) {
+		QFileInfo info(*it);
+		BosonModel* model = new BosonModel(info.dirPath(true) + "/", info.fileName());
+		Q_UINT64 start = BoTraceProfiling::now();
+		BoBMFLoad loader(*it, model);
+		bool ok = loader.loadModel();
+		if (ok) {
+			// version 2 maps the arrays only, the file is actually
+			// read once the arrays are used.
+			*checksum += readArrays(model);
+		}
+		*time += BoTraceProfiling::now() - start;
+		delete model;
+		if (!ok) {
+			boError() << k_funcinfo << "could not load " << *it << endl;
+			return false;
+		}
+	}
+ }
+ return true;
+}
+
+/**
+ * Read all values of the point and index arrays of @p model, like the
+ * renderer does once the model is used.
+ * @return A checksum of the arrays
+ **/
+Q_UINT32 readArrays(const BosonModel* model)
+{
+ Q_UINT32 checksum = 0;
+ const Q_UINT32* points = (const Q_UINT32*)model->pointArray();
+ for (unsigned int i = 0; i < model->pointArraySize() * 8; i++) {
+	checksum += points[i];
+ }
+ if (model->indexArrayType() == BMF_DATATYPE_UNSIGNED_SHORT) {
+	const Q_UINT16* indices = (const Q_UINT16*)model->indexArray();
+	for (unsigned int i = 0; i < model->indexArraySize(); i++) {
+		checksum += indices[i];
+	}
+ } else {
+	const Q_UINT32* indices = (const Q_UINT32*)model->indexArray();
+	for (unsigned int i = 0; i < model->indexArraySize(); i++) {
+		checksum += indices[i];
+	}
+ }
+ return checksum;
+}
@@ -30,6 +30,7 @@
 #include "boeventloop.h"
 #include "bosongameengine.h"
 #include "bosongldriverworkarounds.h"
+#include "modelrendering/bobmfload.h"
 #include <config.h>
 #include <bogl.h>
 
@@ -71,6 +72,7 @@ static KCmdLineOptions options[] =
     { "notexturecompression", I18N_NOOP("Disable texture compression for faster startup"), 0 },
     { "fast", I18N_NOOP("Fast Startup"), 0 },
     { "veryfast", I18N_NOOP("Very Fast Startup (debugging only!)"), 0 },
+    { "prewarm", I18N_NOOP("Convert the models of all units into the model cache and quit"), 0 },
     { 0, 0, 0 }
 };
 
@@ -137,6 +139,16 @@ int main(int argc, char **argv)
 	return 1;
  }
 
+ if (args->isSet("prewarm")) {
+	// no need to start the game - we just fill the model cache, so that
+	// the first game starts faster.
+	if (!BoBMFLoad::prewarmModelCache()) {
+		boError() << k_funcinfo << "could not convert all models" << endl;
+		return 1;
+	}
+	return 0;
+ }
+
  BoDebugDCOPIface* iface = 0;
 #if !BOSON_LINK_STATIC
  // AB: if we build a static binary, we do not allow DCOP connections, so no
@@ -39,13 +39,30 @@
 #include "../gameengine/speciestheme.h"
 #include "../gameengine/bosoncomputerio.h"
 #include "../gameengine/bpfloader.h"
+#include "../gameengine/bosonnetworksynchronizer.h"
+#include "../gameengine/bomessage.h"
+#include "../gameengine/boreplay.h"
+#include "../bosonprofiling.h"
+#include "../botraceprofiling.h"
 #include <config.h>
 
 #include <kaboutdata.h>
 #include <klocale.h>
 #include <kmessagebox.h>
+#include <kmdcodec.h>
+#include <krandomsequence.h>
+#include <kgame/kgameio.h>
 
 #include <qtimer.h>
+#include <qapplication.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qtextstream.h>
+#include <qmap.h>
+#include <qptrlist.h>
+#include <qdom.h>
+
+#include <limits.h>
 
 class StartGame
 {
@@ -97,6 +114,21 @@ public:
 	bool mClient;
 };
 
+// profiling items deeper than this are summed up in their parent
+#define BENCHMARK_PHASE_DEPTH 3
+
+class BenchmarkPhase
+{
+public:
+	BenchmarkPhase()
+	{
+		mTotalTime = 0;
+		mCalls = 0;
+	}
+	double mTotalTime; // in us
+	unsigned int mCalls;
+};
+
 class MainNoGUIPrivate
 {
 public:
@@ -106,14 +138,70 @@ public:
 		mStarting = 0;
 
 		mStartGame = 0;
+
+		mComputerPlayers = 0;
+		mBenchmarkAdvanceCalls = 0;
+		mBenchmarkAdvanceCallsMade = 0;
+
+		mReplay = false;
+		mReplaySeekAdvanceCalls = 0;
+		mReplayKeyframeAdvanceCalls = 0;
+		mReplaySeed = 0;
 	}
 	BosonGameEngine* mGameEngine;
 	BosonStarting* mStarting;
 	bool mStartingExecuted;
 
 	StartGame* mStartGame;
+
+	QString mPlayFieldFile;
+	unsigned int mComputerPlayers;
+
+	unsigned int mBenchmarkAdvanceCalls;
+	unsigned int mBenchmarkAdvanceCallsMade;
+	QString mBenchmarkOutput;
+	QTime mBenchmarkTime;
+	QStringList mBenchmarkPhaseOrder;
+	QMap<QString, BenchmarkPhase> mBenchmarkPhases;
+
+	bool mReplay;
+	QString mReplayFile;
+	QString mReplayOutput;
+	QString mReplaySaveGame;
+	unsigned int mReplaySeekAdvanceCalls;
+	unsigned int mReplayKeyframeAdvanceCalls;
+	Q_INT32 mReplaySeed;
+	QMap<Q_UINT32, Q_UINT32> mReplayPlayerIds;
+	QPtrList<BoMessage> mReplayMessages;
+	QTime mReplayTime;
 };
 
+/**
+ * Add the times of @p item and its children (up to @ref BENCHMARK_PHASE_DEPTH)
+ * to @p phases. Phases are identified by the path of the item in the
+ * profiling tree, e.g. "slotAdvance() / Advance Items".
+ **/
+static void addBenchmarkPhases(const BosonProfilingItem* item, const QString& parentName, unsigned int depth, QStringList* order, QMap<QString, BenchmarkPhase>* phases)
+{
+ QString name = item->name();
+ if (!parentName.isEmpty()) {
+	name = parentName + " / " + name;
+ }
+ if (!phases->contains(name)) {
+	order->append(name);
+ }
+ BenchmarkPhase& phase = (*phases)[name];
+ phase.mTotalTime += (double)item->elapsedTime();
+ phase.mCalls++;
+
+ if (depth + 1 >= BENCHMARK_PHASE_DEPTH || !item->children()) {
+	return;
+ }
+ for (QPtrListIterator<BosonProfilingItem> it(*item->children()); it.current(); ++it) {
+	addBenchmarkPhases(it.current(), name, depth + 1, order, phases);
+ }
+}
+
 MainNoGUI::MainNoGUI()
 	: QObject(0)
 {
@@ -130,6 +218,8 @@ MainNoGUI::MainNoGUI()
 
 MainNoGUI::~MainNoGUI()
 {
+ d->mReplayMessages.setAutoDelete(true);
+ d->mReplayMessages.clear();
  delete d->mStarting;
  delete d->mGameEngine;
  delete d;
@@ -175,7 +265,29 @@ bool MainNoGUI::startGame(const MainNoGUIStartOptions& options)
  connect(boGame, SIGNAL(signalPlayerJoinedGame(KPlayer*)),
 		this, SLOT(slotPlayerJoinedGame(KPlayer*)));
 
+ if (options.benchmarkAdvanceCalls > 0) {
+	if (options.isClient || options.remotePlayers > 0) {
+		boError() << k_funcinfo << "benchmarks are possible in local games only" << endl;
+		return false;
+	}
+	d->mBenchmarkAdvanceCalls = options.benchmarkAdvanceCalls;
+	d->mBenchmarkAdvanceCallsMade = 0;
+	d->mBenchmarkOutput = options.benchmarkOutput;
+	d->mComputerPlayers = options.computerPlayers.count();
+	boGame->setFastAdvance(true);
+
+	// we need the most recent advance call only
+	boProfiling->setMaximalEntries("Advance", 1);
+
+	connect(boGame, SIGNAL(signalAdvance(unsigned int, bool)),
+			this, SLOT(slotBenchmarkAdvance(unsigned int, bool)));
+	connect(boGame, SIGNAL(signalGameOver()),
+			this, SLOT(slotBenchmarkGameOver()));
+ }
 
+ if (!options.replayFile.isEmpty()) {
+	return startReplay(options);
+ }
 
  const bool loadGame = options.load;
  if (options.load) {
@@ -314,6 +426,12 @@ QByteArray MainNoGUI::loadPlayFieldFromDisk(const MainNoGUIStartOptions& options
  if (identifier.isEmpty()) {
 	identifier = BosonPlayField::defaultPlayField();
  }
+ if (identifier.endsWith(".bpf") && QFile::exists(identifier)) {
+	// a file that is not (necessarily) installed, e.g. for benchmarks
+	boDebug() << k_funcinfo << "loading file " << identifier << endl;
+	d->mPlayFieldFile = identifier;
+	return BPFLoader::loadFromDiskToStream(identifier);
+ }
  BPFPreview* preview = boData->playFieldPreview(identifier);
  if (!preview) {
 	boError() << k_funcinfo << "no playfield " << identifier << endl;
@@ -325,6 +443,7 @@ QByteArray MainNoGUI::loadPlayFieldFromDisk(const MainNoGUIStartOptions& options
  }
 
  QString fileName = preview->fileName();
+ d->mPlayFieldFile = fileName;
 
  boDebug() << k_funcinfo << "loading " << identifier << endl;
  QByteArray data = BPFLoader::loadFromDiskToStream(fileName);
@@ -338,6 +457,35 @@ void MainNoGUI::slotGameStarted()
 	return;
  }
  boDebug() << k_funcinfo << endl;
+ if (d->mReplay) {
+	// this must be done before Boson has completed the IdGameIsStarted
+	// message: once in loadfromlog mode, the ADMIN does not send advance
+	// messages itself.
+	QMap<Q_UINT32, Q_UINT32> oldToNew;
+	for (QMap<Q_UINT32, Q_UINT32>::iterator it = d->mReplayPlayerIds.begin(); it != d->mReplayPlayerIds.end(); ++it) {
+		KPlayer* p = boGame->findPlayerByUserId(it.data());
+		if (!p) {
+			boWarning() << k_funcinfo << "player " << it.data() << " of the keyframe is not in the game" << endl;
+			continue;
+		}
+		oldToNew.insert(it.key(), p->kgameId());
+	}
+	BoReplay::mapPlayerIds(&d->mReplayMessages, oldToNew);
+
+	boGame->random()->setSeed(d->mReplaySeed);
+	d->mReplayTime.start();
+	boDebug() << k_funcinfo << "replaying " << d->mReplayMessages.count() << " messages" << endl;
+	if (!boGame->loadFromLog(&d->mReplayMessages)) {
+		boError() << k_funcinfo << "could not replay messages" << endl;
+		QTimer::singleShot(0, qApp, SLOT(quit()));
+	}
+	return;
+ }
+ if (d->mBenchmarkAdvanceCalls > 0) {
+	// the advance calls start once the game is unpaused below, so the
+	// time includes the first advance call.
+	d->mBenchmarkTime.start();
+ }
  if (boGame->isAdmin()) {
 	if (boGame->gameSpeed() == 0) {
 		boDebug() << k_funcinfo << "unpause game" << endl;
@@ -367,6 +515,287 @@ void MainNoGUI::slotCheckStart()
  }
 }
 
+void MainNoGUI::slotBenchmarkAdvance(unsigned int, bool)
+{
+ if (d->mBenchmarkAdvanceCallsMade >= d->mBenchmarkAdvanceCalls) {
+	return;
+ }
+ d->mBenchmarkAdvanceCallsMade++;
+
+ QPtrList<BosonProfilingItem> items = boProfiling->cloneItems("Advance");
+ if (items.last()) {
+	addBenchmarkPhases(items.last(), QString::null, 0, &d->mBenchmarkPhaseOrder, &d->mBenchmarkPhases);
+ }
+ while (!items.isEmpty()) {
+	BosonProfilingItem* item = items.take(0);
+	delete item;
+ }
+
+ if (d->mBenchmarkAdvanceCallsMade < d->mBenchmarkAdvanceCalls) {
+	return;
+ }
+ finishBenchmark();
+}
+
+void MainNoGUI::slotBenchmarkGameOver()
+{
+ if (d->mBenchmarkAdvanceCallsMade >= d->mBenchmarkAdvanceCalls) {
+	return;
+ }
+ // no more advance calls will be made. the result contains the number of
+ // calls that were actually made.
+ boWarning() << k_funcinfo << "game over after " << d->mBenchmarkAdvanceCallsMade << " of " << d->mBenchmarkAdvanceCalls << " advance calls" << endl;
+ d->mBenchmarkAdvanceCalls = d->mBenchmarkAdvanceCallsMade;
+ finishBenchmark();
+}
+
+void MainNoGUI::finishBenchmark()
+{
+ disconnect(boGame, SIGNAL(signalAdvance(unsigned int, bool)),
+		this, SLOT(slotBenchmarkAdvance(unsigned int, bool)));
+ disconnect(boGame, SIGNAL(signalGameOver()),
+		this, SLOT(slotBenchmarkGameOver()));
+ boGame->setFastAdvance(false);
+ if (!writeBenchmarkResult()) {
+	boError() << k_funcinfo << "unable to write benchmark result" << endl;
+ }
+ QTimer::singleShot(0, qApp, SLOT(quit()));
+}
+
+bool MainNoGUI::writeBenchmarkResult()
+{
+ int wallTime = d->mBenchmarkTime.elapsed();
+
+ // the log of the sync check contains everything that must be equal on
+ // all clients, so its md5 sum is a good checksum of the simulation.
+ QByteArray log = BosonNetworkSynchronizer::makeCanvasLog(boGame->canvasNonConst());
+ KMD5 md5(log);
+
+ QFile file;
+ if (d->mBenchmarkOutput.isEmpty()) {
+	if (!file.open(IO_WriteOnly, stdout)) {
+		return false;
+	}
+ } else {
+	file.setName(d->mBenchmarkOutput);
+	if (!file.open(IO_WriteOnly)) {
+		boError() << k_funcinfo << "could not open " << d->mBenchmarkOutput << endl;
+		return false;
+	}
+ }
+ QTextStream stream(&file);
+ stream << "{\n";
+ stream << "  \"playfield\": " << BoTraceProfiling::jsonString(d->mPlayFieldFile) << ",\n";
+ stream << "  \"computerPlayers\": " << d->mComputerPlayers << ",\n";
+ stream << "  \"advanceCalls\": " << d->mBenchmarkAdvanceCallsMade << ",\n";
+ stream << "  \"wallTimeMs\": " << wallTime << ",\n";
+ stream << "  \"checksum\": " << BoTraceProfiling::jsonString(QString(md5.hexDigest())) << ",\n";
+ stream << "  \"phases\": [\n";
+ for (QStringList::iterator it = d->mBenchmarkPhaseOrder.begin(); it != d->mBenchmarkPhaseOrder.end(); ++it) {
+	const BenchmarkPhase& phase = d->mBenchmarkPhases[*it];
+	double average = 0.0;
+	if (phase.mCalls > 0) {
+		average = phase.mTotalTime / phase.mCalls;
+	}
+	stream << "    { \"name\": " << BoTraceProfiling::jsonString(*it)
+			<< ", \"totalUs\": " << QString::number(phase.mTotalTime, 'f', 0)
+			<< ", \"calls\": " << phase.mCalls
+			<< ", \"averageUs\": " << QString::number(average, 'f', 1)
+			<< " }";
+	QStringList::iterator next = it;
+	++next;
+	if (next != d->mBenchmarkPhaseOrder.end()) {
+		stream << ",";
+	}
+	stream << "\n";
+ }
+ stream << "  ]\n";
+ stream << "}\n";
+ file.close();
+ return true;
+}
+
+bool MainNoGUI::startReplay(const MainNoGUIStartOptions& options)
+{
+ if (options.isClient || options.remotePlayers > 0) {
+	boError() << k_funcinfo << "replays are possible in local games only" << endl;
+	return false;
+ }
+ QFile file(options.replayFile);
+ if (!file.open(IO_ReadOnly)) {
+	boError() << k_funcinfo << "could not open " << options.replayFile << endl;
+	return false;
+ }
+ QPtrList<BoReplayKeyframe> keyframes;
+ keyframes.setAutoDelete(true);
+ if (!BoReplay::loadKeyframes(&file, &keyframes)) {
+	boError() << k_funcinfo << "could not load keyframes from " << options.replayFile << endl;
+	return false;
+ }
+ BoReplayKeyframe* keyframe = BoReplay::findKeyframe(keyframes, options.replaySeekAdvanceCalls);
+ if (!keyframe) {
+	boError() << k_funcinfo << "replay has no keyframe before advance call " << options.replaySeekAdvanceCalls << endl;
+	return false;
+ }
+ boDebug() << k_funcinfo << "starting at keyframe of advance call " << keyframe->advanceCallsCount << endl;
+
+ // the messages before the keyframe are not needed
+ if (!BoMessageLogger::loadMessageLog(&file, &d->mReplayMessages, keyframe->messageIndex)) {
+	boError() << k_funcinfo << "could not load messages from " << options.replayFile << endl;
+	return false;
+ }
+ file.close();
+
+ QMap<QString, QByteArray> files;
+ if (!keyframe->files(files)) {
+	boError() << k_funcinfo << "invalid keyframe" << endl;
+	return false;
+ }
+ if (!files.contains("players.xml")) {
+	boError() << k_funcinfo << "did not find players.xml in keyframe" << endl;
+	return false;
+ }
+
+ d->mReplay = true;
+ d->mReplayFile = options.replayFile;
+ d->mReplayOutput = options.replayOutput;
+ d->mReplaySaveGame = options.replaySaveGame;
+ d->mReplaySeekAdvanceCalls = options.replaySeekAdvanceCalls;
+ d->mReplayKeyframeAdvanceCalls = keyframe->advanceCallsCount;
+ d->mReplaySeed = keyframe->randomSeed;
+ d->mReplayPlayerIds = keyframe->playerIds;
+
+ delete d->mStartGame;
+ d->mStartGame = new StartGame();
+
+ QByteArray buffer;
+ QDataStream stream(buffer, IO_WriteOnly);
+ stream << (Q_INT8)1; // game mode (not editor)
+ stream << qCompress(BPFLoader::streamFiles(files));
+ d->mStartGame->mPlayField = buffer;
+
+ if (!addReplayPlayers(QString(files["players.xml"]))) {
+	boError() << k_funcinfo << "adding players failed" << endl;
+	return false;
+ }
+
+ boGame->setFastAdvance(true);
+ connect(boGame, SIGNAL(signalAdvance(unsigned int, bool)),
+		this, SLOT(slotReplayAdvance(unsigned int, bool)));
+ connect(boGame, SIGNAL(signalLoadFromLogCompleted()),
+		this, SLOT(slotReplayCompleted()));
+ return true;
+}
+
+// see BosonLoadSaveGameHandler::addLoadGamePlayers(). the players of a
+// replay do not get any IO, all of their input is in the replayed messages.
+bool MainNoGUI::addReplayPlayers(const QString& playersXML)
+{
+ QDomDocument playersDoc;
+ if (!playersDoc.setContent(playersXML)) {
+	boError() << k_funcinfo << "error loading players.xml" << endl;
+	return false;
+ }
+ QDomNodeList list = playersDoc.documentElement().elementsByTagName("Player");
+ if (list.count() == 0) {
+	boError() << k_funcinfo << "no players in keyframe" << endl;
+	return false;
+ }
+ for (unsigned int i = 0; i < list.count(); i++) {
+	QDomElement p = list.item(i).toElement();
+	bool ok = false;
+	unsigned int id = p.attribute("PlayerId").toUInt(&ok);
+	if (!ok) {
+		boError() << k_funcinfo << "invalid PlayerId" << endl;
+		return false;
+	}
+	QDomElement speciesTheme = p.namedItem("SpeciesTheme").toElement();
+	QString species = speciesTheme.attribute(QString::fromLatin1("Identifier"));
+	QColor color;
+	color.setRgb(speciesTheme.attribute(QString::fromLatin1("TeamColor")).toUInt(&ok));
+	if (!ok || species.isEmpty()) {
+		boError() << k_funcinfo << "invalid SpeciesTheme for player " << id << endl;
+		return false;
+	}
+	Player* player = new Player(id == 256);
+	player->addGameIO(new KGameComputerIO());
+	player->setUserId(id);
+	player->loadTheme(SpeciesTheme::speciesDirectory(species), color);
+
+	boGame->bosonAddPlayer(player);
+	d->mStartGame->mRequiredPlayers++;
+ }
+ return true;
+}
+
+void MainNoGUI::slotReplayAdvance(unsigned int advanceCallsCount, bool)
+{
+ if (advanceCallsCount + 1 < d->mReplaySeekAdvanceCalls) {
+	return;
+ }
+ // the remaining advance calls of the current advance message are still
+ // made, then the replay completes. this way we stop between two advance
+ // messages, i.e. at a point that can be saved.
+ disconnect(boGame, SIGNAL(signalAdvance(unsigned int, bool)),
+		this, SLOT(slotReplayAdvance(unsigned int, bool)));
+ boGame->clearDelayedMessages();
+}
+
+void MainNoGUI::slotReplayCompleted()
+{
+ disconnect(boGame, SIGNAL(signalAdvance(unsigned int, bool)),
+		this, SLOT(slotReplayAdvance(unsigned int, bool)));
+ disconnect(boGame, SIGNAL(signalLoadFromLogCompleted()),
+		this, SLOT(slotReplayCompleted()));
+
+ // no more advance calls must be made, or the result would not match the
+ // replay anymore
+ boGame->setFastAdvance(false);
+
+ if (d->mReplaySeekAdvanceCalls != UINT_MAX && boGame->advanceCallsCount() < d->mReplaySeekAdvanceCalls) {
+	boWarning() << k_funcinfo << "replay ended at advance call " << boGame->advanceCallsCount() << ", before advance call " << d->mReplaySeekAdvanceCalls << endl;
+ }
+ if (!writeReplayResult()) {
+	boError() << k_funcinfo << "unable to write replay result" << endl;
+ }
+ if (!d->mReplaySaveGame.isEmpty()) {
+	if (!boGame->saveToFile(d->mReplaySaveGame)) {
+		boError() << k_funcinfo << "unable to save game to " << d->mReplaySaveGame << endl;
+	}
+ }
+ QTimer::singleShot(0, qApp, SLOT(quit()));
+}
+
+bool MainNoGUI::writeReplayResult()
+{
+ int wallTime = d->mReplayTime.elapsed();
+ QByteArray log = BosonNetworkSynchronizer::makeCanvasLog(boGame->canvasNonConst());
+ KMD5 md5(log);
+
+ QFile file;
+ if (d->mReplayOutput.isEmpty()) {
+	if (!file.open(IO_WriteOnly, stdout)) {
+		return false;
+	}
+ } else {
+	file.setName(d->mReplayOutput);
+	if (!file.open(IO_WriteOnly)) {
+		boError() << k_funcinfo << "could not open " << d->mReplayOutput << endl;
+		return false;
+	}
+ }
+ QTextStream stream(&file);
+ stream << "{\n";
+ stream << "  \"replay\": " << BoTraceProfiling::jsonString(d->mReplayFile) << ",\n";
+ stream << "  \"keyframeAdvanceCalls\": " << d->mReplayKeyframeAdvanceCalls << ",\n";
+ stream << "  \"advanceCalls\": " << boGame->advanceCallsCount() << ",\n";
+ stream << "  \"wallTimeMs\": " << wallTime << ",\n";
+ stream << "  \"checksum\": " << BoTraceProfiling::jsonString(QString(md5.hexDigest())) << "\n";
+ stream << "}\n";
+ file.close();
+ return true;
+}
+
 void MainNoGUI::slotAddIOs(Player* p, int* ioMask, bool* failure)
 {
  if ((*ioMask) & MainNoGUIAIPlayerOptions::ComputerIO) {
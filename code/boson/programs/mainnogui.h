@@ -59,6 +59,10 @@ public:
 		isClient = false;
 		host = "localhost";
 		port = BOSON_PORT;
+
+		benchmarkAdvanceCalls = 0;
+
+		replaySeekAdvanceCalls = 0;
 	}
 
 	void addAIPlayer();
@@ -72,6 +76,21 @@ public:
 	bool isClient; // either client or server
 	QString host; // only used if isClient == true
 	int port; // only used if isClient == true || remotePlayers > 0
+
+	// if > 0 the game runs in fast advance mode and quits after this many
+	// advance calls, writing the benchmark results to benchmarkOutput (or
+	// stdout, if empty).
+	unsigned int benchmarkAdvanceCalls;
+	QString benchmarkOutput;
+
+	// if non-empty the game is started from the keyframe of this replay
+	// file (see BoReplay) that is closest to replaySeekAdvanceCalls. the
+	// game then runs in fast advance mode until replaySeekAdvanceCalls
+	// advance calls have been made (or the replay ends) and quits.
+	QString replayFile;
+	unsigned int replaySeekAdvanceCalls;
+	QString replayOutput; // stdout if empty
+	QString replaySaveGame; // the game is saved to this file, if non-empty
 };
 
 class MainNoGUIPrivate;
@@ -113,11 +132,47 @@ protected:
 	QByteArray loadPlayFieldFromDisk(const MainNoGUIStartOptions& options);
 	bool addComputerPlayersToGame(const MainNoGUIStartOptions& options, unsigned int needPlayers = 0);
 
+	/**
+	 * Write the results of the benchmark (the times of the advance phases
+	 * and a checksum of the canvas) in JSON format.
+	 **/
+	bool writeBenchmarkResult();
+	void finishBenchmark();
+
+	/**
+	 * Start the game from the keyframe of the replay (see @ref
+	 * MainNoGUIStartOptions::replayFile) and prepare replaying the messages
+	 * after the keyframe.
+	 **/
+	bool startReplay(const MainNoGUIStartOptions& options);
+	bool addReplayPlayers(const QString& playersXML);
+
+	/**
+	 * Write the advance call the replay stopped at and a checksum of the
+	 * canvas in JSON format.
+	 **/
+	bool writeReplayResult();
+
 protected slots:
 	void slotGameStarted();
 	void slotPlayerJoinedGame(KPlayer*);
 	void slotCheckStart();
 
+	/**
+	 * Called after every advance call in benchmark mode. Collects the
+	 * profiling data of the call and quits once all advance calls have
+	 * been made.
+	 **/
+	void slotBenchmarkAdvance(unsigned int advanceCallsCount, bool advanceFlag);
+	void slotBenchmarkGameOver();
+
+	/**
+	 * Called after every advance call while replaying. Stops the replay once
+	 * the requested advance call has been reached.
+	 **/
+	void slotReplayAdvance(unsigned int advanceCallsCount, bool advanceFlag);
+	void slotReplayCompleted();
+
 	/**
 	 * Add IOs. This adds primarily the computer player IO.
 	 **/
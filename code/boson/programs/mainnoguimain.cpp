@@ -36,6 +36,8 @@
 
 #include <qtimer.h>
 
+#include <limits.h>
+
 static const char *description =
     I18N_NOOP("Boson without GUI");
 
@@ -52,12 +54,20 @@ static KCmdLineOptions options[] =
     { "aidelay <delay>", I18N_NOOP("Set AI delay (in seconds). The less it is, the faster AI will send it's units"), 0 },
     { "noai", I18N_NOOP("Disable AI"), 0 },
     { "connectto <host:port>" I18N_NOOP("Connect to a server"), 0 },
+    { "benchmark <advancecalls>", I18N_NOOP("Run <advancecalls> advance calls as fast as possible, print the times of the advance phases and a checksum of the game and quit. The playfield may be the filename of a .bpf file."), 0 },
+    { "benchmark-output <file>", I18N_NOOP("Write the benchmark results to <file> instead of stdout"), 0 },
+    { "replay <file>", I18N_NOOP("Start at a keyframe of the replay <file> (see --seek), replay the game as fast as possible, print a checksum of the game and quit"), 0 },
+    { "seek <advancecall>", I18N_NOOP("Replay until <advancecall>, starting at the closest keyframe before it. Default is the last keyframe."), 0 },
+    { "replay-output <file>", I18N_NOOP("Write the replay result to <file> instead of stdout"), 0 },
+    { "replay-save <file>", I18N_NOOP("Save the game to <file> when the replay stops"), 0 },
     { 0, 0, 0 }
 };
 
 static bool parseArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args);
 static bool parseAddComputerArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args);
 static bool parsePlayFieldArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args);
+static bool parseBenchmarkArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args);
+static bool parseReplayArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args);
 
 static void postBosonConfigInit();
 
@@ -251,6 +261,13 @@ static bool parseArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args)
 		return false;
 	}
  }
+
+ if (!parseBenchmarkArgs(options, args)) {
+	return false;
+ }
+ if (!parseReplayArgs(options, args)) {
+	return false;
+ }
  return true;
 }
 
@@ -310,3 +327,57 @@ bool parsePlayFieldArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args)
  }
  return true;
 }
+
+bool parseBenchmarkArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args)
+{
+ if (!args->isSet("benchmark")) {
+	return true;
+ }
+ bool ok;
+ int calls = args->getOption("benchmark").toInt(&ok);
+ if (!ok || calls <= 0) {
+	boError() << k_funcinfo << "\"benchmark\" argument is not a valid number" << endl;
+	return false;
+ }
+ if (options->remotePlayers > 0) {
+	boError() << k_funcinfo << "\"benchmark\" cannot be used with network players" << endl;
+	return false;
+ }
+ options->benchmarkAdvanceCalls = calls;
+ if (args->isSet("benchmark-output")) {
+	options->benchmarkOutput = args->getOption("benchmark-output");
+ }
+ return true;
+}
+
+bool parseReplayArgs(MainNoGUIStartOptions* options, KCmdLineArgs* args)
+{
+ if (!args->isSet("replay")) {
+	return true;
+ }
+ if (options->benchmarkAdvanceCalls > 0) {
+	boError() << k_funcinfo << "\"replay\" cannot be used with \"benchmark\"" << endl;
+	return false;
+ }
+ if (options->remotePlayers > 0) {
+	boError() << k_funcinfo << "\"replay\" cannot be used with network players" << endl;
+	return false;
+ }
+ options->replayFile = args->getOption("replay");
+ options->replaySeekAdvanceCalls = UINT_MAX;
+ if (args->isSet("seek")) {
+	bool ok;
+	options->replaySeekAdvanceCalls = args->getOption("seek").toUInt(&ok);
+	if (!ok) {
+		boError() << k_funcinfo << "\"seek\" argument is not a valid number" << endl;
+		return false;
+	}
+ }
+ if (args->isSet("replay-output")) {
+	options->replayOutput = args->getOption("replay-output");
+ }
+ if (args->isSet("replay-save")) {
+	options->replaySaveGame = args->getOption("replay-save");
+ }
+ return true;
+}
@@ -24,12 +24,14 @@
 #include "gameengine/unitbase.h"
 #include "gameengine/bosonweapon.h"
 #include "modelrendering/bosonmodel.h"
+#include "modelrendering/bobmfload.h"
 #include "bodebug.h"
 #include "boaction.h"
 #include "bosonconfig.h"
 #include "bosonprofiling.h"
 #include "sound/bosonaudiointerface.h"
 #include "boufo/boufoimage.h"
+#include "boimagecache.h"
 
 #include <qintdict.h>
 #include <qdict.h>
@@ -273,17 +275,8 @@ bool SpeciesData::loadUnitModel(const UnitProperties* prop, const QColor& )
  BosonModel* m = d->mUnitModels[prop->typeId()];
 
  if (!m) {
-	QStringList fileNames = unitModelFiles();
-	bool found = false;
-	QString file;
-	for (QStringList::Iterator it = fileNames.begin(); it != fileNames.end(); ++it) {
-		if (KStandardDirs::exists(prop->unitPath() + *it)) {
-			file = *it;
-			found = true;
-			break;
-		}
-	}
-	if (!found) {
+	QString file = unitModelFile(prop);
+	if (file.isNull()) {
 		boError(270) << k_funcinfo << "Cannot find model file file for " << prop->typeId() << endl;
 		return false;
 	}
@@ -300,6 +293,34 @@ bool SpeciesData::loadUnitModel(const UnitProperties* prop, const QColor& )
  return true;
 }
 
+bool SpeciesData::convertUnitModels(const QValueList<const UnitProperties*>& props)
+{
+ if (boConfig->boolValue("ForceDisableModelLoading")) {
+	return true;
+ }
+ QStringList modelFiles;
+ QStringList configFiles;
+ for (QValueList<const UnitProperties*>::const_iterator it = props.begin(); it != props.end(); ++it) {
+	const UnitProperties* prop = *it;
+	if (!prop || d->mUnitModels[prop->typeId()]) {
+		continue;
+	}
+	QString file = unitModelFile(prop);
+	if (file.isNull()) {
+		// loadUnitModel() will report the error
+		continue;
+	}
+	// see BosonModelFactory::createUnitModel()
+	modelFiles.append(prop->unitPath() + file);
+	configFiles.append(prop->unitPath() + QString::fromLatin1("index.unit"));
+ }
+ if (modelFiles.isEmpty()) {
+	return true;
+ }
+ BosonProfiler prof("ConvertUnitModels");
+ return BoBMFLoad::convertModels(modelFiles, configFiles);
+}
+
 BosonModel* SpeciesData::unitModel(unsigned long int unitType) const
 {
  return d->mUnitModels[unitType];
@@ -307,11 +328,22 @@ BosonModel* SpeciesData::unitModel(unsigned long int unitType) const
 
 QStringList SpeciesData::unitModelFiles()
 {
- QStringList list;
- list.append("unit.3ds");
- list.append("unit.ac");
- list.append("unit.md2");
- return list;
+ return BoBMFLoad::unitModelFiles();
+}
+
+QString SpeciesData::unitModelFile(const UnitProperties* prop)
+{
+ if (!prop) {
+	BO_NULL_ERROR(prop);
+	return QString::null;
+ }
+ QStringList fileNames = unitModelFiles();
+ for (QStringList::Iterator it = fileNames.begin(); it != fileNames.end(); ++it) {
+	if (KStandardDirs::exists(prop->unitPath() + *it)) {
+		return *it;
+	}
+ }
+ return QString::null;
 }
 
 BosonSoundInterface* SpeciesData::sound() const
@@ -395,12 +427,33 @@ bool SpeciesData::loadUnitOverview(const UnitProperties* prop, const QColor& tea
 }
 
 
+QStringList SpeciesData::unitOverviewFiles(const UnitProperties* prop, const QColor& teamColor) const
+{
+ QStringList files;
+ if (!prop) {
+	BO_NULL_ERROR(prop);
+	return files;
+ }
+ TeamColorData* data = teamColorData(teamColor);
+ unsigned long int type = prop->typeId();
+ if (!data || !data->mBigOverview[type]) {
+	files.append(prop->unitPath() + "overview-big.png");
+ }
+ if (!data || !data->mSmallOverview[type]) {
+	files.append(prop->unitPath() + "overview-small.png");
+ }
+ return files;
+}
+
 bool SpeciesData::loadUnitImage(const QColor& teamColor, const QString &fileName, QImage &_image)
 {
  BosonProfiler prof("LoadUnitImage");
- boProfiling->push("QImage loading");
- QImage image(fileName);
- boProfiling->pop(); // "QImage loading"
+ QImage image;
+ if (!BoImageCache::takeImage(fileName, false, &image)) {
+	boProfiling->push("QImage loading");
+	image = QImage(fileName);
+	boProfiling->pop(); // "QImage loading"
+ }
 // image.setAlphaBuffer(false);
  int x, y, w, h;
  QRgb *p = 0;
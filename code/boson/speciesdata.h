@@ -37,6 +37,7 @@ class QPixmap;
 class QStringList;
 class QColor;
 template<class T> class QDict;
+template<class T> class QValueList;
 
 /**
  * Here we store all un-modifyable data, such as images or unit models for a
@@ -99,6 +100,14 @@ public:
 	 **/
 	bool loadUnitModel(const UnitProperties* prop, const QColor& teamColor);
 
+	/**
+	 * Convert the models of all units in @p props that have not been
+	 * loaded yet into the model cache, in a single batch (see @ref
+	 * BoBMFLoad::convertModels). Call this before @ref loadUnitModel, so
+	 * that the models don't have to be converted one by one.
+	 **/
+	bool convertUnitModels(const QValueList<const UnitProperties*>& props);
+
 	/**
 	 * Load the overview pixmaps for the unit @p prop in the color @p
 	 * teamColor
@@ -106,6 +115,14 @@ public:
 	 **/
 	bool loadUnitOverview(const UnitProperties* prop, const QColor& teamColor);
 
+	/**
+	 * @return The absolute filenames of the images that @ref
+	 * loadUnitOverview will load for @p prop in the color @p teamColor.
+	 * Images that have been loaded already are not included. See also @ref
+	 * BoImageCache.
+	 **/
+	QStringList unitOverviewFiles(const UnitProperties* prop, const QColor& teamColor) const;
+
 	/**
 	 * Load the objects specified in $speciesdir/objects/objects.boson.
 	 *
@@ -153,6 +170,12 @@ public:
 	 **/
 	static QStringList unitModelFiles();
 
+	/**
+	 * @return The first file of @ref unitModelFiles that exists in the
+	 * directory of @p prop, or QString::null if there is none.
+	 **/
+	static QString unitModelFile(const UnitProperties* prop);
+
 	/**
 	 * @return The @ref BosonSound object for this species.
 	 **/
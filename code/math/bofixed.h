@@ -27,6 +27,7 @@
 #include <math.h>
 
 #include <qglobal.h> // Q_INT32, ...
+typedef quint64 Q_UINT64;
 typedef qint64 Q_INT64;
 typedef qint32 Q_INT32;
 typedef quint32 Q_UINT32;
@@ -182,4 +182,46 @@ bool BoFrustum::boxInFrustum(const BoVector3Float& min, const BoVector3Float& ma
  return true;
 }
 
+int BoFrustum::boxCompleteInFrustum(const BoVector3Float& min, const BoVector3Float& max) const
+{
+ int c = 0;
+ for (int p = 0; p < 6; p++) {
+	int inside = 0;
+	if (mPlanes[p].distance(min.x(), min.y(), min.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(max.x(), min.y(), min.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(min.x(), max.y(), min.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(max.x(), max.y(), min.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(min.x(), min.y(), max.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(max.x(), min.y(), max.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(min.x(), max.y(), max.z()) > 0.0f) {
+		inside++;
+	}
+	if (mPlanes[p].distance(max.x(), max.y(), max.z()) > 0.0f) {
+		inside++;
+	}
+	if (inside == 0) {
+		return 0;
+	}
+	if (inside == 8) {
+		c++;
+	}
+ }
+ if (c == 6) {
+	return 2;
+ }
+ return 1;
+}
+
 
@@ -93,6 +93,17 @@ public:
 		return boxInFrustum(rect.topLeftBack(), rect.bottomRightFront());
 	}
 
+	/**
+	 * This is similar to @ref boxInFrustum, but will test whether the box
+	 * is completely in the frustum.
+	 *
+	 * @return 0 if the box is not in the frustum at all, 1 if it is
+	 * partially in the frustum and 2 if the complete box is in the frustum.
+	 * Note that 1 may be returned for boxes that are close to an edge of
+	 * the frustum, but not inside it.
+	 **/
+	int boxCompleteInFrustum(const BoVector3Float& min, const BoVector3Float& max) const;
+
 	/**
 	 * This is similar to @ref sphereInFrustum, but will test whether the sphere
 	 * is completely in the frustum.
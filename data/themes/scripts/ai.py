@@ -1,6 +1,7 @@
 from sys import exit
 from utils import *
 from random import randint
+from struct import Struct
 
 aidelay = 0
 cycle = 0
@@ -19,6 +20,54 @@ except ImportError:
   boprint("error", "Couldn't import ai_produce, ai_attack. Won't work.")
 
 
+class SnapshotColumn:
+  """A column of a UnitSnapshot. The values are read from the buffer of the
+  snapshot when they are accessed, nothing is copied.
+  """
+  def __init__(self, values, typecode):
+    self.values = values
+    self.unpack = Struct(typecode).unpack_from
+
+  def __len__(self):
+    return len(self.values) / 4
+
+  def __getitem__(self, i):
+    return self.unpack(self.values, i * 4)[0]
+
+
+class UnitSnapshot:
+  """All units of the game, as returned by BoScript.unitSnapshot().
+
+  The snapshot is taken once per advance call and shared by all players. It
+  contains units that the player cannot see, use visibleTo() to filter them.
+  """
+  def __init__(self, data):
+    self.data = data
+    self.count = data[0]
+    self.ids = SnapshotColumn(data[1], "i")
+    self.owners = SnapshotColumn(data[2], "i")
+    self.types = SnapshotColumn(data[3], "i")
+    self.x = SnapshotColumn(data[4], "f")
+    self.y = SnapshotColumn(data[5], "f")
+    self.health = SnapshotColumn(data[6], "i")
+    self.work = SnapshotColumn(data[7], "i")
+    self.visible = SnapshotColumn(data[8], "i")
+
+  def visibleTo(self, i, playerid):
+    """Whether unit i is or has been seen by the player playerid."""
+    return (self.visible[i] >> (playerid - 128)) & 1
+
+snapshot = None
+
+def unitSnapshot():
+  """Returns a UnitSnapshot of the current advance call."""
+  global snapshot
+  data = BoScript.unitSnapshot()
+  if snapshot is None or snapshot.data is not data:
+    snapshot = UnitSnapshot(data)
+  return snapshot
+
+
 def unitDestroyed(unitid, ownerid, pos):
   boprint("debug","unit with id %s destroyed" % unitid)
 
@@ -47,6 +96,10 @@ def resetAIDelay():
   aidelay = int(BoScript.aiDelay() * 20)
 
 
+# note: advance() is a generator, every "yield" gives control back to the game.
+# the remaining steps are continued in the next advance call(s) if the time
+# budget of this advance call is used up. the steps are generators as well and
+# yield after every unit they handled.
 def advance():
   global cycle
   global player
@@ -64,16 +117,20 @@ def advance():
   cycle = cycle + 1
   if (cycle % 2) == 0:
     boprint("debug", "produced method called, cycle: %s" % cycle)
-    ai_produce.produce()
+    for step in ai_produce.produce():
+      yield step
   if (cycle % 5) == 0:
     # AB: this is only a fallback - the unit should be placed by the event
-    ai_produce.place()
+    for step in ai_produce.place():
+      yield step
   if (cycle % 2) == 0:
     boprint("debug", "mine method called, cycle: %s" % cycle)
-    mine()
+    for step in mine():
+      yield step
 #  if (cycle % 20) == 0:
      #spawnSomeUnits()
-  ai_attack.advance()
+  for step in ai_attack.advance():
+    yield step
 
 
 def spawnSomeUnits():
@@ -82,10 +139,15 @@ def spawnSomeUnits():
   for x in range(4):
     BoScript.spawnUnit(10035, 5, 5 + x * 2)
 
+# generator, yields after every unit.
 def mine():
   global player
   units = BoScript.allPlayerUnits(player)
   for u in units:
+    # the unit may have been destroyed while we were waiting for the next
+    # advance call
+    if not BoScript.isUnitAlive(u):
+      continue
     if BoScript.canUnitMineOil(u) and (BoScript.unitAdvanceWork(u)==0 or BoScript.unitAdvanceWork(u)==11):
       pos=BoScript.unitPosition(u)
       oil=BoScript.nearestOilLocations(int(pos[0]),int(pos[1]),1,150)
@@ -100,6 +162,7 @@ def mine():
       if len(minerals) > 0:
         BoScript.mineUnit(u, minerals[0][0], minerals[0][1])
         boprint("debug", "Mine  minerals done")
+    yield None
 
 
 def unitProduced(ownerid, pos, type, factorid):
@@ -25,7 +25,9 @@ class AIExplorer:
   def __init__(self, player):
     self.mPlayer = player
     self.mExplorer = 0
+    self.mExploreLocation = (-1, -1)
 
+  # generator, see findExploreLocation()
   def explore(self):
     boprint("debug", "exploring")
     if self.mExplorer and not self.mExplorer.isAlive():
@@ -38,10 +40,16 @@ class AIExplorer:
     pos = self.mExplorer.position()
     boprint("debug", "explore, explore unit: %s current position: %s" % (self.mExplorer.id(), pos))
 
-    exploreAt = self.findExploreLocation(self.mExplorer)
+    for step in self.findExploreLocation(self.mExplorer):
+      yield step
+    exploreAt = self.mExploreLocation
     if exploreAt[0] == -1:
       boprint("debug", "not exploring")
       return
+    if not self.mExplorer.isAlive():
+      # destroyed while we were searching
+      self.mExplorer = 0
+      return
 
     boprint("debug", "exploring with unit %s at: %s" % (self.mExplorer.id(), exploreAt))
     self.mExplorer.move(exploreAt[0], exploreAt[1])
@@ -70,7 +78,10 @@ class AIExplorer:
     return 0
 
 
+  # generator, yields after every column of cells that was searched. the
+  # result is stored in mExploreLocation, (-1, -1) if nothing was found.
   def findExploreLocation(self, unit):
+    self.mExploreLocation = (-1, -1)
     pos = unit.position()
     boprint("debug", "%d, %s, %d" %(unit.id(), unit.position(), unit.sightRange()))
 
@@ -83,7 +94,7 @@ class AIExplorer:
 
     if unit.sightRange() < 2:
       boprint("debug", "sightrange of unit %d too small (%d)" % (unit.id(), unit.sightRange()))
-      return (-1, -1)
+      return
 
     sightRange2 = unit.sightRange() * 2
     range = 0
@@ -113,16 +124,17 @@ class AIExplorer:
             searchCells = searchCells + [(x, y)]
           y = y + sightRange2
         x = x + sightRange2
+        yield None
 
     if len(searchCells) == 0:
       boprint("debug", "nothing to explore found within a range of %s around unit %s" % (maxRange, unit.id()))
-      return (-1, -1)
+      return
 
     shuffle(searchCells)
     # TODO: check if unit can actually go there (or rather at least nearby)
     cell = searchCells[0]
     boprint("debug", "found location to explore for unit %d: %s" % (unit.id(), cell))
-    return cell
+    self.mExploreLocation = cell
 
 
 
@@ -140,6 +152,7 @@ def init():
   boprint("debug", "%s called" % module)
   explorerObject = AIExplorer(ai.player)
 
+# generator, yields inside of the explore and attack loops.
 def advance():
   global explorerObject
   boprint("debug", "%s: advance()" % module)
@@ -148,15 +161,18 @@ def advance():
     return
 
   if ai.cycle % 2 == 0:
-    advanceExplore()
+    for step in advanceExplore():
+      yield step
   if ai.cycle % 1 == 0: # always true
-    advanceAttack()
+    for step in advanceAttack():
+      yield step
 
 
 def advanceExplore():
   global explorerObject
   boprint("debug", "%s: advanceExplore()" % module)
-  explorerObject.explore()
+  for step in explorerObject.explore():
+    yield step
 
 def advanceAttack():
   global aiunit, aitarget
@@ -180,9 +196,16 @@ def advanceAttack():
       boprint("info", "No attacker found, returning")
       return
     u = units[aiunit]
+    if not BoScript.isUnitAlive(u):
+      continue
     if BoScript.isUnitMobile(u):
       if BoScript.canUnitShoot(u) and not explorerObject.isIdExploring(u):
         attacker = u
+    if attacker == -1:
+      yield None
+  if not BoScript.isUnitAlive(aitarget):
+    # destroyed while we were searching for an attacker
+    return
   targetpos = BoScript.unitPosition(aitarget)
   boprint("debug", "ordering unit %s to attack targetpos %s containing target %s" % (attacker, targetpos, aitarget))
   BoScript.moveUnitWithAttacking(attacker, targetpos[0], targetpos[1])
@@ -191,13 +214,23 @@ def advanceAttack():
 def findTarget():
   boprint("debug", "%s: findTarget()" % module)
   target = -1
-  units = BoScript.allEnemyUnitsVisibleFor(ai.player)
-  for u in units:
+  # the snapshot contains all units, we need to check for visibility and
+  # enemies ourselves. the enemy check is done once per owner only.
+  snapshot = ai.unitSnapshot()
+  enemies = {}
+  for i in xrange(snapshot.count):
+    if not snapshot.visibleTo(i, ai.player):
+      continue
+    owner = snapshot.owners[i]
+    if not enemies.has_key(owner):
+      enemies[owner] = BoScript.areEnemies(ai.player, owner)
+    if not enemies[owner]:
+      continue
     # FIXME: command center id is hardcoded
-    if BoScript.unitType(u) == 5:
-      return u
+    if snapshot.types[i] == 5:
+      return snapshot.ids[i]
     if target == -1:
-      target = u
+      target = snapshot.ids[i]
   # if cmdcenter wasn't found, return any other unit
   return target
 
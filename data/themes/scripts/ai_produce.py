@@ -52,9 +52,14 @@ def unitPlaced(unitid, ownerid, pos, type):
   boprint("debug","unit with id %s and type  %s placed " % (unitid,type))
 
 
+# generator, yields after every unit that was looked at.
 def produce():
   units = BoScript.allPlayerUnits(ai.player)
   for u in units:
+    # the unit may have been destroyed while we were waiting for the next
+    # advance call
+    if not BoScript.isUnitAlive(u):
+      continue
     # AB: unitAdvanceWork(u) == 0 means that the unit is idle
     if BoScript.canUnitProduce(u) and BoScript.unitAdvanceWork(u) == 0:
       boprint("debug", "start production algorithm for unit %d" % u)
@@ -71,14 +76,19 @@ def produce():
         produceFacilities(u)
       if canProduceMobiles:
         produceMobiles(u)
+    yield None
 
+# generator, yields after every unit that was looked at.
 def place():
   units = BoScript.allPlayerUnits(ai.player)
   for u in units:
+    if not BoScript.isUnitAlive(u):
+      continue
     # AB; unitAdvanceWork(u) == 9 means "WorkPlugin", which is e.g. produce
     if BoScript.canUnitProduce(u) and BoScript.unitAdvanceWork(u) == 9 and BoScript.hasUnitCompletedProduction(u):
       boprint("debug", "start placement algorithm for unit %d" % u)
       placeUnit(u, BoScript.completedProductionType(u))
+    yield None
 
 def produceFacilities(factory):
   boprint("debug", "produceFacilities()")